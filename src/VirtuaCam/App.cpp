@@ -6,7 +6,9 @@
 #include "Discovery.h"
 #include <wrl.h>
 #include <algorithm>
+#include <atomic>
 #include <map>
+#include <thread>
 
 using namespace Microsoft::WRL;
 
@@ -14,6 +16,8 @@ static wil::com_ptr_nothrow<IMFVirtualCamera> g_vcam;
 static HWND g_hMainWnd = NULL;
 static std::unique_ptr<WASAPICapture> g_audioCapture;
 static std::unique_ptr<VirtuaCam::Discovery> g_discovery;
+static std::thread g_producerWatcher;
+static std::atomic<bool> g_stopProducerWatcher{ false };
 
 typedef void (*PFN_InitializeBroker)();
 typedef void (*PFN_ShutdownBroker)();
@@ -55,6 +59,8 @@ HRESULT RegisterVirtualCamera();
 void ShutdownSystem();
 void OnIdle();
 void InformBroker();
+void StartProducerWatcher();
+void StopProducerWatcher();
 void LoadSettings();
 void SaveSettings();
 
@@ -127,7 +133,6 @@ DWORD LaunchProducer(const std::wstring& key, const std::wstring& args)
     if (CreateProcessW(NULL, cmdLineNonConst, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi))
     {
         g_producerProcesses[key] = pi;
-        Sleep(200);
         return pi.dwProcessId;
     }
     return 0;
@@ -261,8 +266,8 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPWSTR,
         ShutdownSystem(); MFShutdown(); CoUninitialize(); return FALSE;
     }
 
-    // Timer for periodic discovery refresh and UI updates
-    SetTimer(g_hMainWnd, 1, 1000, nullptr);
+    // Refresh the broker whenever the producer set changes
+    StartProducerWatcher();
     InformBroker();
 
     // Initialize audio capture subsystem (WASAPI)
@@ -318,6 +323,7 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPWSTR,
     // own capture logic (MFCamera, MFGraphicsCapture, or Consumer).
     // =========================================================================
     UI_RunMessageLoop(OnIdle);
+    StopProducerWatcher();
 
     // Cleanup: shutdown all subsystems in reverse order
     ShutdownSystem();
@@ -331,6 +337,35 @@ void OnIdle() {
     if (g_pfnGetBrokerState) UpdateTelemetry(g_pfnGetBrokerState());
 }
 
+// The watcher thread sleeps on the producer directory's wake event and posts
+// WM_APP_PRODUCERS_CHANGED when a producer arrives, leaves or dies, so the
+// main thread refreshes the broker only when there is something new.  If the
+// directory cannot be subscribed to, fall back to the old 1-second timer.
+void StartProducerWatcher() {
+    if (!g_discovery || !g_discovery->Subscribe()) {
+        SetTimer(g_hMainWnd, 1, 1000, nullptr);
+        return;
+    }
+    g_stopProducerWatcher = false;
+    g_producerWatcher = std::thread([] {
+        uint64_t seen = g_discovery->ChangeCount();
+        while (!g_stopProducerWatcher) {
+            if (g_discovery->WaitForChange(seen)) {
+                seen = g_discovery->ChangeCount();
+                PostMessage(g_hMainWnd, WM_APP_PRODUCERS_CHANGED, 0, 0);
+            }
+        }
+    });
+}
+
+void StopProducerWatcher() {
+    KillTimer(g_hMainWnd, 1);
+    if (!g_producerWatcher.joinable()) return;
+    g_stopProducerWatcher = true;
+    g_discovery->CancelWait();
+    g_producerWatcher.join();
+}
+
 void InformBroker() {
     if (!g_discovery || !g_pfnUpdateProducerPriorityList || !g_pfnSetCompositingMode) return;
 
@@ -8,6 +8,8 @@
 // ------------------------
 // WM_APP_TRAY_MSG    — Posted to the main window by the system-tray icon.
 // WM_APP_MENU_COMMAND — Posted when a command is selected from our custom menu.
+// WM_APP_PRODUCERS_CHANGED — Posted by the producer watcher thread when a
+//                      producer registers, deregisters or dies.
 //
 // Menu/control ID layout
 // ----------------------
@@ -48,6 +50,7 @@
 // --- System tray / window control IDs ---
 #define WM_APP_TRAY_MSG         (WM_APP + 1)    // System-tray notification message
 #define WM_APP_MENU_COMMAND     (WM_APP + 2)    // Custom menu selection forwarded to main WndProc
+#define WM_APP_PRODUCERS_CHANGED (WM_APP + 3)   // Producer directory changed; refresh the broker
 #define ID_TRAY_PREVIEW_WINDOW  5001            // "Preview" menu item
 #define ID_TRAY_ABOUT           5002            // "About" menu item
 #define ID_TRAY_EXIT            5003            // "Exit" menu item
@@ -0,0 +1,327 @@
+// =============================================================================
+// Blend.cpp  --  CPU BGRA compositing kernels (fill, copy, blend)
+// =============================================================================
+// See Blend.h for the public contract.
+//
+// All blends work on 16-bit lanes (one unpack per 8-bit channel) and divide
+// by 255 with the exact rounded form
+//
+//   x / 255  ~=  ((x + 128) * 257) >> 16            (exact for x <= 255 * 255)
+//
+// which is a single pmulhuw in SIMD.  Unpacking and packing both work per
+// 128-bit lane, so the AVX2 kernels keep pixels in memory order without any
+// lane fix-up.  The kernels are memory-bound well before AVX2 width, so
+// AVX-512 reuses the AVX2 path.
+// =============================================================================
+
+#include "Blend.h"
+#include <algorithm>
+#include <cstring>
+
+#if VCAM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace VirtuaCam {
+
+namespace
+{
+    // Destination rectangle after clipping, plus the matching source offset.
+    struct Clipped {
+        uint8_t* dst = nullptr;
+        uint32_t srcX = 0, srcY = 0;
+        uint32_t width = 0, height = 0;
+    };
+
+    bool ClipRect(const BgraSurface& surface, int32_t x, int32_t y, uint32_t width, uint32_t height, Clipped& out)
+    {
+        if (!surface.data)
+            return false;
+        const int64_t x0 = std::max<int64_t>(x, 0);
+        const int64_t y0 = std::max<int64_t>(y, 0);
+        const int64_t x1 = std::min<int64_t>((int64_t)x + width, surface.width);
+        const int64_t y1 = std::min<int64_t>((int64_t)y + height, surface.height);
+        if (x0 >= x1 || y0 >= y1)
+            return false;
+        out.dst = surface.data + (ptrdiff_t)y0 * surface.stride + (ptrdiff_t)x0 * 4;
+        out.srcX = (uint32_t)(x0 - x);
+        out.srcY = (uint32_t)(y0 - y);
+        out.width = (uint32_t)(x1 - x0);
+        out.height = (uint32_t)(y1 - y0);
+        return true;
+    }
+
+    using FillRowFn = void (*)(uint8_t* dst, uint32_t count, uint32_t color);
+    using OverRowFn = void (*)(uint8_t* dst, const uint8_t* src, uint32_t count, uint32_t opacity);
+    using MaskRowFn = void (*)(uint8_t* dst, const uint8_t* mask, uint32_t count, uint32_t color);
+
+    // -----------------------------------------------------------------------
+    // Scalar reference
+    // -----------------------------------------------------------------------
+
+    inline uint32_t Div255(uint32_t v)
+    {
+        return ((v + 128) * 257) >> 16;
+    }
+
+    void FillRow_Scalar(uint8_t* dst, uint32_t count, uint32_t color)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+            std::memcpy(dst + i * 4, &color, 4);
+    }
+
+    void OverRow_Scalar(uint8_t* dst, const uint8_t* src, uint32_t count, uint32_t opacity)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t s[4];
+            for (int c = 0; c < 4; ++c)
+                s[c] = opacity == 255 ? src[i * 4 + c] : Div255(src[i * 4 + c] * opacity);
+            const uint32_t inverse = 255 - s[3];
+            for (int c = 0; c < 4; ++c)
+                dst[i * 4 + c] = (uint8_t)std::min<uint32_t>(255, s[c] + Div255(dst[i * 4 + c] * inverse));
+        }
+    }
+
+    void MaskRow_Scalar(uint8_t* dst, const uint8_t* mask, uint32_t count, uint32_t color)
+    {
+        uint8_t col[4];
+        std::memcpy(col, &color, 4);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const uint32_t m = mask[i];
+            for (int c = 0; c < 4; ++c)
+                dst[i * 4 + c] = (uint8_t)Div255(col[c] * m + dst[i * 4 + c] * (255 - m));
+        }
+    }
+
+#if VCAM_SIMD_X86
+    // -----------------------------------------------------------------------
+    // SSE4.1  (4 pixels per step)
+    // -----------------------------------------------------------------------
+
+    VCAM_TARGET_SSE41 inline __m128i Div255_SSE41(__m128i v)
+    {
+        return _mm_mulhi_epu16(_mm_add_epi16(v, _mm_set1_epi16(128)), _mm_set1_epi16(257));
+    }
+
+    // Broadcasts the alpha word of each of the two pixels in a 16-bit vector.
+    VCAM_TARGET_SSE41 inline __m128i AlphaShuffle_SSE41()
+    {
+        return _mm_setr_epi8(6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15);
+    }
+
+    VCAM_TARGET_SSE41 void FillRow_SSE41(uint8_t* dst, uint32_t count, uint32_t color)
+    {
+        const __m128i c = _mm_set1_epi32((int)color);
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4)
+            _mm_storeu_si128((__m128i*)(dst + i * 4), c);
+        FillRow_Scalar(dst + i * 4, count - i, color);
+    }
+
+    VCAM_TARGET_SSE41 inline __m128i Over2_SSE41(__m128i s, __m128i d, __m128i opacity, bool scaled)
+    {
+        if (scaled)
+            s = Div255_SSE41(_mm_mullo_epi16(s, opacity));
+        const __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), _mm_shuffle_epi8(s, AlphaShuffle_SSE41()));
+        return _mm_add_epi16(s, Div255_SSE41(_mm_mullo_epi16(d, inverse)));
+    }
+
+    VCAM_TARGET_SSE41 void OverRow_SSE41(uint8_t* dst, const uint8_t* src, uint32_t count, uint32_t opacity)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i op = _mm_set1_epi16((short)opacity);
+        const bool scaled = opacity != 255;
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128i s = _mm_loadu_si128((const __m128i*)(src + i * 4));
+            const __m128i d = _mm_loadu_si128((const __m128i*)(dst + i * 4));
+            const __m128i lo = Over2_SSE41(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), op, scaled);
+            const __m128i hi = Over2_SSE41(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), op, scaled);
+            _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_packus_epi16(lo, hi));
+        }
+        OverRow_Scalar(dst + i * 4, src + i * 4, count - i, opacity);
+    }
+
+    VCAM_TARGET_SSE41 inline __m128i Mask2_SSE41(__m128i color, __m128i m, __m128i d)
+    {
+        const __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), m);
+        return Div255_SSE41(_mm_add_epi16(_mm_mullo_epi16(color, m), _mm_mullo_epi16(d, inverse)));
+    }
+
+    VCAM_TARGET_SSE41 void MaskRow_SSE41(uint8_t* dst, const uint8_t* mask, uint32_t count, uint32_t color)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i c = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero);
+        const __m128i spread = _mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            int32_t m4;
+            std::memcpy(&m4, mask + i, 4);
+            const __m128i m = _mm_shuffle_epi8(_mm_cvtsi32_si128(m4), spread);
+            const __m128i d = _mm_loadu_si128((const __m128i*)(dst + i * 4));
+            const __m128i lo = Mask2_SSE41(c, _mm_unpacklo_epi8(m, zero), _mm_unpacklo_epi8(d, zero));
+            const __m128i hi = Mask2_SSE41(c, _mm_unpackhi_epi8(m, zero), _mm_unpackhi_epi8(d, zero));
+            _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_packus_epi16(lo, hi));
+        }
+        MaskRow_Scalar(dst + i * 4, mask + i, count - i, color);
+    }
+
+    // -----------------------------------------------------------------------
+    // AVX2  (8 pixels per step)
+    // -----------------------------------------------------------------------
+
+    VCAM_TARGET_AVX2 inline __m256i Div255_AVX2(__m256i v)
+    {
+        return _mm256_mulhi_epu16(_mm256_add_epi16(v, _mm256_set1_epi16(128)), _mm256_set1_epi16(257));
+    }
+
+    VCAM_TARGET_AVX2 void FillRow_AVX2(uint8_t* dst, uint32_t count, uint32_t color)
+    {
+        const __m256i c = _mm256_set1_epi32((int)color);
+        uint32_t i = 0;
+        for (; i + 8 <= count; i += 8)
+            _mm256_storeu_si256((__m256i*)(dst + i * 4), c);
+        FillRow_SSE41(dst + i * 4, count - i, color);
+    }
+
+    VCAM_TARGET_AVX2 inline __m256i Over2_AVX2(__m256i s, __m256i d, __m256i opacity, bool scaled)
+    {
+        if (scaled)
+            s = Div255_AVX2(_mm256_mullo_epi16(s, opacity));
+        const __m256i alpha = _mm256_shuffle_epi8(s, _mm256_broadcastsi128_si256(AlphaShuffle_SSE41()));
+        const __m256i inverse = _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+        return _mm256_add_epi16(s, Div255_AVX2(_mm256_mullo_epi16(d, inverse)));
+    }
+
+    VCAM_TARGET_AVX2 void OverRow_AVX2(uint8_t* dst, const uint8_t* src, uint32_t count, uint32_t opacity)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i op = _mm256_set1_epi16((short)opacity);
+        const bool scaled = opacity != 255;
+        uint32_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i s = _mm256_loadu_si256((const __m256i*)(src + i * 4));
+            const __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i * 4));
+            const __m256i lo = Over2_AVX2(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero), op, scaled);
+            const __m256i hi = Over2_AVX2(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero), op, scaled);
+            _mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_packus_epi16(lo, hi));
+        }
+        OverRow_SSE41(dst + i * 4, src + i * 4, count - i, opacity);
+    }
+
+    VCAM_TARGET_AVX2 void MaskRow_AVX2(uint8_t* dst, const uint8_t* mask, uint32_t count, uint32_t color)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i c = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)color), zero);
+        // Both lanes hold the 8 mask bytes; lane 0 spreads bytes 0-3, lane 1 bytes 4-7.
+        const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                                4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7);
+        const __m256i inverseBase = _mm256_set1_epi16(255);
+        uint32_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i m = _mm256_shuffle_epi8(_mm256_broadcastq_epi64(_mm_loadl_epi64((const __m128i*)(mask + i))), spread);
+            const __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i * 4));
+            const __m256i mLo = _mm256_unpacklo_epi8(m, zero), mHi = _mm256_unpackhi_epi8(m, zero);
+            const __m256i lo = Div255_AVX2(_mm256_add_epi16(_mm256_mullo_epi16(c, mLo),
+                                                            _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(inverseBase, mLo))));
+            const __m256i hi = Div255_AVX2(_mm256_add_epi16(_mm256_mullo_epi16(c, mHi),
+                                                            _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(inverseBase, mHi))));
+            _mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_packus_epi16(lo, hi));
+        }
+        MaskRow_SSE41(dst + i * 4, mask + i, count - i, color);
+    }
+#endif
+
+    // -----------------------------------------------------------------------
+    // Dispatch
+    // -----------------------------------------------------------------------
+
+    template <class Fn>
+    Fn Select(SimdLevel level, Fn scalar, Fn sse41, Fn avx2)
+    {
+#if VCAM_SIMD_X86
+        switch (ClampSimdLevel(level))
+        {
+        case SimdLevel::AVX512:
+        case SimdLevel::AVX2:   return avx2;
+        case SimdLevel::SSE41:  return sse41;
+        default:                break;
+        }
+#else
+        (void)level; (void)sse41; (void)avx2;
+#endif
+        return scalar;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public entry points
+// ---------------------------------------------------------------------------
+
+void FillRect(const BgraSurface& dst, int32_t x, int32_t y, uint32_t width, uint32_t height,
+              uint32_t color, SimdLevel level)
+{
+    Clipped r;
+    if (!ClipRect(dst, x, y, width, height, r))
+        return;
+#if VCAM_SIMD_X86
+    const FillRowFn fill = Select<FillRowFn>(level, FillRow_Scalar, FillRow_SSE41, FillRow_AVX2);
+#else
+    const FillRowFn fill = FillRow_Scalar;
+#endif
+    for (uint32_t row = 0; row < r.height; ++row)
+        fill(r.dst + (ptrdiff_t)row * dst.stride, r.width, color);
+}
+
+void CopyRect(const BgraSurface& dst, int32_t x, int32_t y,
+              const uint8_t* src, ptrdiff_t srcStride, uint32_t width, uint32_t height)
+{
+    Clipped r;
+    if (!src || !ClipRect(dst, x, y, width, height, r))
+        return;
+    const uint8_t* s = src + (ptrdiff_t)r.srcY * srcStride + (ptrdiff_t)r.srcX * 4;
+    for (uint32_t row = 0; row < r.height; ++row)
+        std::memcpy(r.dst + (ptrdiff_t)row * dst.stride, s + (ptrdiff_t)row * srcStride, (size_t)r.width * 4);
+}
+
+void BlendOver(const BgraSurface& dst, int32_t x, int32_t y,
+               const uint8_t* src, ptrdiff_t srcStride, uint32_t width, uint32_t height,
+               uint8_t opacity, SimdLevel level)
+{
+    Clipped r;
+    if (!src || !opacity || !ClipRect(dst, x, y, width, height, r))
+        return;
+#if VCAM_SIMD_X86
+    const OverRowFn over = Select<OverRowFn>(level, OverRow_Scalar, OverRow_SSE41, OverRow_AVX2);
+#else
+    const OverRowFn over = OverRow_Scalar;
+#endif
+    const uint8_t* s = src + (ptrdiff_t)r.srcY * srcStride + (ptrdiff_t)r.srcX * 4;
+    for (uint32_t row = 0; row < r.height; ++row)
+        over(r.dst + (ptrdiff_t)row * dst.stride, s + (ptrdiff_t)row * srcStride, r.width, opacity);
+}
+
+void BlendMask(const BgraSurface& dst, int32_t x, int32_t y,
+               const uint8_t* mask, ptrdiff_t maskStride, uint32_t width, uint32_t height,
+               uint32_t color, SimdLevel level)
+{
+    Clipped r;
+    if (!mask || !ClipRect(dst, x, y, width, height, r))
+        return;
+#if VCAM_SIMD_X86
+    const MaskRowFn blend = Select<MaskRowFn>(level, MaskRow_Scalar, MaskRow_SSE41, MaskRow_AVX2);
+#else
+    const MaskRowFn blend = MaskRow_Scalar;
+#endif
+    const uint8_t* m = mask + (ptrdiff_t)r.srcY * maskStride + r.srcX;
+    for (uint32_t row = 0; row < r.height; ++row)
+        blend(r.dst + (ptrdiff_t)row * dst.stride, m + (ptrdiff_t)row * maskStride, r.width, color);
+}
+
+}
@@ -0,0 +1,53 @@
+// =============================================================================
+// Blend.h  --  CPU BGRA compositing kernels (fill, copy, blend)
+// =============================================================================
+// The building blocks of a CPU compositor: PiP tiles, letterbox bars and the
+// "No Signal" wordmark.  All operations take a destination rectangle that may
+// lie partly (or wholly) outside the surface; it is clipped, and the source
+// is offset to match.
+//
+// Pixels are 8-bit BGRA in memory (0xAARRGGBB as a little-endian uint32).
+// Sources for BlendOver() are premultiplied.  Every blend divides by 255
+// exactly (rounded), so the SSE4.1 / AVX2 kernels and the scalar reference
+// produce bit-identical output.
+//
+// This header (and Blend.cpp) deliberately has no Windows dependency.
+// =============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Simd.h"
+
+namespace VirtuaCam {
+
+// A writable BGRA image.  'stride' is in bytes.
+struct BgraSurface {
+    uint8_t*  data   = nullptr;
+    ptrdiff_t stride = 0;
+    uint32_t  width  = 0;
+    uint32_t  height = 0;
+};
+
+// Solid fill.
+void FillRect(const BgraSurface& dst, int32_t x, int32_t y, uint32_t width, uint32_t height,
+              uint32_t color, SimdLevel level = GetSimdLevel());
+
+// Plain copy (no blending) of a width x height BGRA block.
+void CopyRect(const BgraSurface& dst, int32_t x, int32_t y,
+              const uint8_t* src, ptrdiff_t srcStride, uint32_t width, uint32_t height);
+
+// Premultiplied source-over with a global opacity:
+//   s' = s * opacity / 255,   dst = s' + dst * (255 - s'.a) / 255
+void BlendOver(const BgraSurface& dst, int32_t x, int32_t y,
+               const uint8_t* src, ptrdiff_t srcStride, uint32_t width, uint32_t height,
+               uint8_t opacity = 255, SimdLevel level = GetSimdLevel());
+
+// Coverage-mask blend of a solid colour (e.g. a text or logo mask):
+//   dst = (color * m + dst * (255 - m)) / 255   for every channel
+void BlendMask(const BgraSurface& dst, int32_t x, int32_t y,
+               const uint8_t* mask, ptrdiff_t maskStride, uint32_t width, uint32_t height,
+               uint32_t color, SimdLevel level = GetSimdLevel());
+
+}
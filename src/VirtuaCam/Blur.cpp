@@ -0,0 +1,483 @@
+// =============================================================================
+// Blur.cpp  --  Constant-time separable blur for BGRA frames
+// =============================================================================
+// See Blur.h for the public contract.
+//
+// Sliding window
+// --------------
+// For a box of radius r (width w = 2r + 1) the window sum of every channel
+// is kept in 32 bits and updated per output sample:
+//
+//   out[x]   = (sum * mul + (1 << 15)) >> 16        mul = round(65536 / w)
+//   sum     += in[min(x + r + 1, n - 1)] - in[max(x - r, 0)]
+//
+// sum <= 255 * w and w <= 255, so the product stays below 2^25 and the
+// result never exceeds 255.  Horizontally the dependency chain runs along
+// the row, so SSE4.1 keeps one pixel's four channels per register and AVX2
+// runs two rows side by side.  Vertically every column is independent and
+// the kernels update 16 (SSE4.1) or 32 (AVX2) bytes of sums per step.
+// =============================================================================
+
+#include "Blur.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if VCAM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace VirtuaCam {
+
+namespace
+{
+    constexpr uint32_t kStripPixels = 64;
+    constexpr int kRound = 1 << 15;
+
+    inline uint32_t Reciprocal(uint32_t radius)
+    {
+        const uint32_t width = 2 * radius + 1;
+        return (65536 + width / 2) / width;
+    }
+
+    inline uint32_t Clamp(int64_t i, uint32_t n)
+    {
+        return (uint32_t)std::clamp<int64_t>(i, 0, (int64_t)n - 1);
+    }
+
+    // One horizontal pass over one row; 'in' and 'out' must differ.  The
+    // pair variant filters two rows (in1 / out1 may be null).
+    using HorizontalFn = void (*)(const uint8_t* in0, uint8_t* out0, const uint8_t* in1, uint8_t* out1,
+                                  uint32_t width, uint32_t radius, uint32_t mul);
+
+    // Writes the averages in 'sums' to 'out'; then, if 'add' is set, slides
+    // the window: sums += add - sub.  'count' is in bytes.
+    using VerticalFn = void (*)(int32_t* sums, uint8_t* out, const uint8_t* add, const uint8_t* sub,
+                                uint32_t count, uint32_t mul);
+
+    // -----------------------------------------------------------------------
+    // Scalar reference
+    // -----------------------------------------------------------------------
+
+    void HorizontalRow_Scalar(const uint8_t* in, uint8_t* out, uint32_t width, uint32_t radius, uint32_t mul)
+    {
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            uint32_t sum = (radius + 1) * in[c];
+            for (uint32_t k = 1; k <= radius; ++k)
+                sum += in[Clamp(k, width) * 4 + c];
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                out[x * 4 + c] = (uint8_t)((sum * mul + kRound) >> 16);
+                sum += in[Clamp((int64_t)x + radius + 1, width) * 4 + c];
+                sum -= in[Clamp((int64_t)x - radius, width) * 4 + c];
+            }
+        }
+    }
+
+    void Horizontal_Scalar(const uint8_t* in0, uint8_t* out0, const uint8_t* in1, uint8_t* out1,
+                           uint32_t width, uint32_t radius, uint32_t mul)
+    {
+        HorizontalRow_Scalar(in0, out0, width, radius, mul);
+        if (in1)
+            HorizontalRow_Scalar(in1, out1, width, radius, mul);
+    }
+
+    void Vertical_Scalar(int32_t* sums, uint8_t* out, const uint8_t* add, const uint8_t* sub,
+                         uint32_t count, uint32_t mul)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            out[i] = (uint8_t)(((uint32_t)sums[i] * mul + kRound) >> 16);
+            if (add)
+                sums[i] += add[i] - sub[i];
+        }
+    }
+
+#if VCAM_SIMD_X86
+    // -----------------------------------------------------------------------
+    // SSE4.1
+    // -----------------------------------------------------------------------
+
+    VCAM_TARGET_SSE41 inline __m128i Pixel_SSE41(const uint8_t* row, uint32_t x)
+    {
+        int32_t v;
+        std::memcpy(&v, row + (size_t)x * 4, 4);
+        return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(v));
+    }
+
+    VCAM_TARGET_SSE41 void HorizontalRow_SSE41(const uint8_t* in, uint8_t* out, uint32_t width, uint32_t radius, uint32_t mul)
+    {
+        const __m128i m = _mm_set1_epi32((int)mul);
+        const __m128i round = _mm_set1_epi32(kRound);
+        __m128i sum = _mm_mullo_epi32(Pixel_SSE41(in, 0), _mm_set1_epi32((int)radius + 1));
+        for (uint32_t k = 1; k <= radius; ++k)
+            sum = _mm_add_epi32(sum, Pixel_SSE41(in, Clamp(k, width)));
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            __m128i v = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(sum, m), round), 16);
+            v = _mm_packus_epi16(_mm_packus_epi32(v, v), v);
+            const int32_t packed = _mm_cvtsi128_si32(v);
+            std::memcpy(out + (size_t)x * 4, &packed, 4);
+            sum = _mm_add_epi32(sum, Pixel_SSE41(in, Clamp((int64_t)x + radius + 1, width)));
+            sum = _mm_sub_epi32(sum, Pixel_SSE41(in, Clamp((int64_t)x - radius, width)));
+        }
+    }
+
+    VCAM_TARGET_SSE41 void Horizontal_SSE41(const uint8_t* in0, uint8_t* out0, const uint8_t* in1, uint8_t* out1,
+                                            uint32_t width, uint32_t radius, uint32_t mul)
+    {
+        HorizontalRow_SSE41(in0, out0, width, radius, mul);
+        if (in1)
+            HorizontalRow_SSE41(in1, out1, width, radius, mul);
+    }
+
+    VCAM_TARGET_SSE41 inline __m128i Average4_SSE41(const int32_t* sums, __m128i m, __m128i round)
+    {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums));
+        return _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(s, m), round), 16);
+    }
+
+    VCAM_TARGET_SSE41 inline void Slide4_SSE41(int32_t* sums, __m128i delta)
+    {
+        __m128i* p = reinterpret_cast<__m128i*>(sums);
+        _mm_storeu_si128(p, _mm_add_epi32(_mm_loadu_si128(p), _mm_cvtepi16_epi32(delta)));
+    }
+
+    VCAM_TARGET_SSE41 void Vertical_SSE41(int32_t* sums, uint8_t* out, const uint8_t* add, const uint8_t* sub,
+                                          uint32_t count, uint32_t mul)
+    {
+        const __m128i m = _mm_set1_epi32((int)mul);
+        const __m128i round = _mm_set1_epi32(kRound);
+        uint32_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            const __m128i lo = _mm_packus_epi32(Average4_SSE41(sums + i, m, round), Average4_SSE41(sums + i + 4, m, round));
+            const __m128i hi = _mm_packus_epi32(Average4_SSE41(sums + i + 8, m, round), Average4_SSE41(sums + i + 12, m, round));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(lo, hi));
+            if (!add)
+                continue;
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(add + i));
+            const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sub + i));
+            const __m128i d0 = _mm_sub_epi16(_mm_cvtepu8_epi16(a), _mm_cvtepu8_epi16(s));
+            const __m128i d1 = _mm_sub_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(a, 8)), _mm_cvtepu8_epi16(_mm_srli_si128(s, 8)));
+            Slide4_SSE41(sums + i, d0);
+            Slide4_SSE41(sums + i + 4, _mm_srli_si128(d0, 8));
+            Slide4_SSE41(sums + i + 8, d1);
+            Slide4_SSE41(sums + i + 12, _mm_srli_si128(d1, 8));
+        }
+        Vertical_Scalar(sums + i, out + i, add ? add + i : nullptr, sub ? sub + i : nullptr, count - i, mul);
+    }
+
+    // -----------------------------------------------------------------------
+    // AVX2
+    // -----------------------------------------------------------------------
+
+    VCAM_TARGET_AVX2 inline __m256i PixelPair_AVX2(const uint8_t* row0, const uint8_t* row1, uint32_t x)
+    {
+        int32_t a, b;
+        std::memcpy(&a, row0 + (size_t)x * 4, 4);
+        std::memcpy(&b, row1 + (size_t)x * 4, 4);
+        return _mm256_cvtepu8_epi32(_mm_unpacklo_epi32(_mm_cvtsi32_si128(a), _mm_cvtsi32_si128(b)));
+    }
+
+    VCAM_TARGET_AVX2 void Horizontal_AVX2(const uint8_t* in0, uint8_t* out0, const uint8_t* in1, uint8_t* out1,
+                                          uint32_t width, uint32_t radius, uint32_t mul)
+    {
+        if (!in1)
+        {
+            HorizontalRow_SSE41(in0, out0, width, radius, mul);
+            return;
+        }
+        const __m256i m = _mm256_set1_epi32((int)mul);
+        const __m256i round = _mm256_set1_epi32(kRound);
+        __m256i sum = _mm256_mullo_epi32(PixelPair_AVX2(in0, in1, 0), _mm256_set1_epi32((int)radius + 1));
+        for (uint32_t k = 1; k <= radius; ++k)
+            sum = _mm256_add_epi32(sum, PixelPair_AVX2(in0, in1, Clamp(k, width)));
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            __m256i v = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(sum, m), round), 16);
+            v = _mm256_packus_epi16(_mm256_packus_epi32(v, v), v);
+            const int32_t p0 = _mm_cvtsi128_si32(_mm256_castsi256_si128(v));
+            const int32_t p1 = _mm_cvtsi128_si32(_mm256_extracti128_si256(v, 1));
+            std::memcpy(out0 + (size_t)x * 4, &p0, 4);
+            std::memcpy(out1 + (size_t)x * 4, &p1, 4);
+            sum = _mm256_add_epi32(sum, PixelPair_AVX2(in0, in1, Clamp((int64_t)x + radius + 1, width)));
+            sum = _mm256_sub_epi32(sum, PixelPair_AVX2(in0, in1, Clamp((int64_t)x - radius, width)));
+        }
+    }
+
+    VCAM_TARGET_AVX2 inline __m256i Average8_AVX2(const int32_t* sums, __m256i m, __m256i round)
+    {
+        const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sums));
+        return _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(s, m), round), 16);
+    }
+
+    VCAM_TARGET_AVX2 inline void Slide8_AVX2(int32_t* sums, __m128i delta)
+    {
+        __m256i* p = reinterpret_cast<__m256i*>(sums);
+        _mm256_storeu_si256(p, _mm256_add_epi32(_mm256_loadu_si256(p), _mm256_cvtepi16_epi32(delta)));
+    }
+
+    VCAM_TARGET_AVX2 void Vertical_AVX2(int32_t* sums, uint8_t* out, const uint8_t* add, const uint8_t* sub,
+                                        uint32_t count, uint32_t mul)
+    {
+        const __m256i m = _mm256_set1_epi32((int)mul);
+        const __m256i round = _mm256_set1_epi32(kRound);
+        // packus works per 128-bit lane; this restores the dword order.
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        uint32_t i = 0;
+        for (; i + 32 <= count; i += 32)
+        {
+            const __m256i lo = _mm256_packus_epi32(Average8_AVX2(sums + i, m, round), Average8_AVX2(sums + i + 8, m, round));
+            const __m256i hi = _mm256_packus_epi32(Average8_AVX2(sums + i + 16, m, round), Average8_AVX2(sums + i + 24, m, round));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_permutevar8x32_epi32(_mm256_packus_epi16(lo, hi), order));
+            if (!add)
+                continue;
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(add + i));
+            const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sub + i));
+            const __m256i d0 = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(a)), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(s)));
+            const __m256i d1 = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(a, 1)), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(s, 1)));
+            Slide8_AVX2(sums + i, _mm256_castsi256_si128(d0));
+            Slide8_AVX2(sums + i + 8, _mm256_extracti128_si256(d0, 1));
+            Slide8_AVX2(sums + i + 16, _mm256_castsi256_si128(d1));
+            Slide8_AVX2(sums + i + 24, _mm256_extracti128_si256(d1, 1));
+        }
+        Vertical_SSE41(sums + i, out + i, add ? add + i : nullptr, sub ? sub + i : nullptr, count - i, mul);
+    }
+#endif
+
+    // -----------------------------------------------------------------------
+    // Dispatch
+    // -----------------------------------------------------------------------
+
+    // Memory-bound; AVX-512 uses the AVX2 kernels.
+    template <class Fn>
+    Fn Select(SimdLevel level, Fn scalar, Fn sse41, Fn avx2)
+    {
+#if VCAM_SIMD_X86
+        switch (ClampSimdLevel(level))
+        {
+        case SimdLevel::AVX512:
+        case SimdLevel::AVX2:   return avx2;
+        case SimdLevel::SSE41:  return sse41;
+        default:                break;
+        }
+#else
+        (void)level; (void)sse41; (void)avx2;
+#endif
+        return scalar;
+    }
+
+    HorizontalFn SelectHorizontal(SimdLevel level)
+    {
+#if VCAM_SIMD_X86
+        return Select<HorizontalFn>(level, Horizontal_Scalar, Horizontal_SSE41, Horizontal_AVX2);
+#else
+        return Select<HorizontalFn>(level, Horizontal_Scalar, nullptr, nullptr);
+#endif
+    }
+
+    VerticalFn SelectVertical(SimdLevel level)
+    {
+#if VCAM_SIMD_X86
+        return Select<VerticalFn>(level, Vertical_Scalar, Vertical_SSE41, Vertical_AVX2);
+#else
+        return Select<VerticalFn>(level, Vertical_Scalar, nullptr, nullptr);
+#endif
+    }
+
+    // Box widths whose n-fold convolution best matches a Gaussian of 'sigma'
+    // (Kutskir / Wells): the two odd widths around the ideal one, mixed.
+    void BoxRadii(double sigma, uint32_t passes, uint32_t* radius)
+    {
+        const double n = passes;
+        const double ideal = std::sqrt(12.0 * sigma * sigma / n + 1.0);
+        int lower = (int)std::floor(ideal);
+        if (lower % 2 == 0)
+            --lower;
+        const double m = (12.0 * sigma * sigma - n * lower * lower - 4.0 * n * lower - 3.0 * n) / (-4.0 * lower - 4.0);
+        const int mRounded = (int)std::lround(m);
+        for (uint32_t i = 0; i < passes; ++i)
+            radius[i] = (uint32_t)(((int)i < mRounded ? lower : lower + 2) - 1) / 2;
+    }
+
+    // -----------------------------------------------------------------------
+    // Axis drivers
+    // -----------------------------------------------------------------------
+
+    // Rows [rowBegin, rowEnd): every pass runs in per-thread scratch and the
+    // last one writes 'dst'.
+    void BlurRows(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                  uint32_t width, uint32_t rowBegin, uint32_t rowEnd,
+                  const uint32_t* radius, const uint32_t* mul, uint32_t passes, HorizontalFn horizontal)
+    {
+        thread_local std::vector<uint8_t> scratch;
+        const size_t rowBytes = (size_t)width * 4;
+        if (scratch.size() < rowBytes * 4)
+            scratch.resize(rowBytes * 4);
+
+        for (uint32_t y = rowBegin; y < rowEnd; y += 2)
+        {
+            const bool pair = y + 1 < rowEnd;
+            const uint8_t* in[2] = { src + (ptrdiff_t)y * srcStride, pair ? src + (ptrdiff_t)(y + 1) * srcStride : nullptr };
+            uint8_t* target[2] = { dst + (ptrdiff_t)y * dstStride, pair ? dst + (ptrdiff_t)(y + 1) * dstStride : nullptr };
+            for (uint32_t p = 0; p < passes; ++p)
+            {
+                uint8_t* out[2] = { scratch.data() + (p & 1) * 2 * rowBytes, scratch.data() + ((p & 1) * 2 + 1) * rowBytes };
+                if (p + 1 == passes && in[0] != target[0])
+                {
+                    out[0] = target[0];
+                    out[1] = target[1];
+                }
+                horizontal(in[0], out[0], in[1], pair ? out[1] : nullptr, width, radius[p], mul[p]);
+                in[0] = out[0];
+                in[1] = pair ? out[1] : nullptr;
+            }
+            if (in[0] != target[0])
+            {
+                // Single in-place pass: the result is still in scratch.
+                std::memcpy(target[0], in[0], rowBytes);
+                if (pair)
+                    std::memcpy(target[1], in[1], rowBytes);
+            }
+        }
+    }
+
+    // Byte columns [begin, end) of 'image', filtered in place.  The ring
+    // keeps the original rows the window still has to subtract.
+    void BlurColumns(uint8_t* image, ptrdiff_t stride, uint32_t height, uint32_t begin, uint32_t end,
+                     const uint32_t* radius, const uint32_t* mul, uint32_t passes, VerticalFn vertical)
+    {
+        thread_local std::vector<int32_t> sums;
+        thread_local std::vector<uint8_t> ring;
+        const uint32_t count = end - begin;
+        if (sums.size() < count)
+            sums.resize(count);
+
+        auto row = [&](uint32_t y) { return image + (ptrdiff_t)y * stride + begin; };
+        for (uint32_t p = 0; p < passes; ++p)
+        {
+            const uint32_t r = radius[p];
+            const size_t ringSize = (size_t)(r + 1) * count;
+            if (ring.size() < ringSize)
+                ring.resize(ringSize);
+
+            int32_t* s = sums.data();
+            const uint8_t* top = row(0);
+            for (uint32_t i = 0; i < count; ++i)
+                s[i] = (int32_t)(r + 1) * top[i];
+            for (uint32_t k = 1; k <= r; ++k)
+            {
+                const uint8_t* add = row(Clamp(k, height));
+                for (uint32_t i = 0; i < count; ++i)
+                    s[i] += add[i];
+            }
+
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                std::memcpy(ring.data() + (size_t)(y % (r + 1)) * count, row(y), count);
+                const bool slide = y + 1 < height;
+                const uint8_t* add = slide ? row(Clamp((int64_t)y + r + 1, height)) : nullptr;
+                const uint8_t* sub = ring.data() + (size_t)(Clamp((int64_t)y - r, height) % (r + 1)) * count;
+                vertical(s, row(y), add, sub, count, mul[p]);
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Blur
+// ---------------------------------------------------------------------------
+
+void Blur::Configure(uint32_t width, uint32_t height, float sigma, uint32_t passes, uint32_t downscale)
+{
+    m_width = width;
+    m_height = height;
+    m_passes = (width && height && sigma >= 0.5f) ? std::clamp(passes, 1u, kMaxPasses) : 0;
+    m_downscale = 1;
+    while (m_downscale < std::min(downscale, kMaxDownscale))
+        m_downscale *= 2;
+
+    if (m_passes)
+    {
+        for (;;)
+        {
+            BoxRadii(double(sigma) / m_downscale, m_passes, m_radius);
+            const uint32_t widest = *std::max_element(m_radius, m_radius + m_passes);
+            if (widest <= kMaxBoxRadius || m_downscale == kMaxDownscale)
+                break;
+            m_downscale *= 2;
+        }
+        for (uint32_t p = 0; p < m_passes; ++p)
+            m_radius[p] = std::min(m_radius[p], kMaxBoxRadius);
+
+        // Boxes of radius 0 are no-ops.
+        const uint32_t* last = std::remove(m_radius, m_radius + m_passes, 0u);
+        m_passes = (uint32_t)(last - m_radius);
+    }
+
+    m_small.clear();
+    if (m_passes && m_downscale > 1)
+    {
+        const uint32_t smallWidth = std::max(1u, (width + m_downscale - 1) / m_downscale);
+        const uint32_t smallHeight = std::max(1u, (height + m_downscale - 1) / m_downscale);
+        m_down.Configure(width, height, smallWidth, smallHeight, ScaleFilter::Box);
+        m_up.Configure(smallWidth, smallHeight, width, height, ScaleFilter::Bilinear);
+        m_small.resize((size_t)smallWidth * smallHeight * 4);
+    }
+}
+
+void Blur::Filter(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                  uint32_t width, uint32_t height, WorkerPool& pool, SimdLevel level) const
+{
+    uint32_t mul[kMaxPasses];
+    for (uint32_t p = 0; p < m_passes; ++p)
+        mul[p] = Reciprocal(m_radius[p]);
+
+    const HorizontalFn horizontal = SelectHorizontal(level);
+    pool.ParallelBands(height, 2, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd)
+    {
+        BlurRows(src, srcStride, dst, dstStride, width, rowBegin, rowEnd, m_radius, mul, m_passes, horizontal);
+    });
+
+    const VerticalFn vertical = SelectVertical(level);
+    pool.ParallelBands(width, kStripPixels, kStripPixels, [&](uint32_t columnBegin, uint32_t columnEnd)
+    {
+        for (uint32_t x = columnBegin; x < columnEnd; x += kStripPixels)
+        {
+            const uint32_t stripEnd = std::min(x + kStripPixels, columnEnd);
+            BlurColumns(dst, dstStride, height, x * 4, stripEnd * 4, m_radius, mul, m_passes, vertical);
+        }
+    });
+}
+
+void Blur::Apply(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                 WorkerPool& pool, SimdLevel level)
+{
+    if (!src || !dst || !IsConfigured())
+        return;
+
+    if (!m_passes)
+    {
+        if (src != dst)
+        {
+            for (uint32_t y = 0; y < m_height; ++y)
+                std::memcpy(dst + (ptrdiff_t)y * dstStride, src + (ptrdiff_t)y * srcStride, (size_t)m_width * 4);
+        }
+        return;
+    }
+
+    if (m_downscale == 1)
+    {
+        Filter(src, srcStride, dst, dstStride, m_width, m_height, pool, level);
+        return;
+    }
+
+    const ptrdiff_t smallStride = (ptrdiff_t)m_down.DstWidth() * 4;
+    m_down.ScaleParallel(src, srcStride, m_small.data(), smallStride, 4, pool, level);
+    Filter(m_small.data(), smallStride, m_small.data(), smallStride, m_down.DstWidth(), m_down.DstHeight(), pool, level);
+    m_up.ScaleParallel(m_small.data(), smallStride, dst, dstStride, 4, pool, level);
+}
+
+}
@@ -17,6 +17,8 @@
 //   4. Maintain a producer priority list supplied by the UI, which controls
 //      which producer is the primary (fullscreen) source and which appear as
 //      picture-in-picture overlays.
+//   5. Hold per-producer chroma keys (SetProducerChromaKey) so a keyed PiP
+//      source is composited without its background.
 //
 // KEY DESIGN DECISIONS:
 //
@@ -45,13 +47,16 @@
 #include <sddl.h>
 #include <string>
 #include <vector>
+#include <map>
 #include <mutex>
 #include <algorithm>
 #include "wil/resource.h"
 #include "App.h"
 #include "Tools.h"
+#include "WorkerPool.h"
 #include "Formats.h"
 #include "Discovery.h"
+#include "ProducerDirectory.h"
 #include "Multiplexer.h"
 
 #pragma comment(lib, "d3d11.lib")
@@ -70,6 +75,7 @@ static ComPtr<ID3D11Device> g_device;
 static LUID g_adapterLuid = {};
 
 static std::unique_ptr<VirtuaCam::Discovery> g_discovery;
+static VirtuaCam::ProducerDirectory g_directory;   // created here, held open while the broker runs
 static std::unique_ptr<Multiplexer> g_multiplexer;
 
 // Name of the broker's own manifest — BrokerClient opens this to find the
@@ -80,7 +86,7 @@ const WCHAR* BROKER_MANIFEST_NAME = L"Local\\DirectPort_Producer_Manifest_Virtua
 static ComPtr<ID3D11Texture2D> g_sharedTex_Out;
 static ComPtr<ID3D11Fence>     g_sharedFence_Out;
 static HANDLE                  g_hManifest_Out         = nullptr;
-static BroadcastManifest*      g_pManifestView_Out      = nullptr;
+static VirtuaCam::BroadcastManifestV2* g_pManifestView_Out = nullptr;
 static HANDLE                  g_sharedNTHandle_Out     = nullptr;
 static HANDLE                  g_sharedFenceHandle_Out  = nullptr;
 
@@ -90,6 +96,9 @@ static HANDLE                  g_sharedFenceHandle_Out  = nullptr;
 static std::vector<DWORD> g_producerPriorityList;
 static std::mutex         g_producerListMutex;
 
+// Chroma keys set by the UI, by producer PID (guarded by g_producerListMutex).
+static std::map<DWORD, VirtuaCam::ChromaKeyParams> g_chromaKeys;
+
 static bool        g_isGridMode  = false;
 static BrokerState g_brokerState = BrokerState::Searching;
 
@@ -98,6 +107,8 @@ static BrokerState g_brokerState = BrokerState::Searching;
 // ---------------------------------------------------------------------------
 
 void ShutdownSharing() {
+    // Clients keep the mapping open (and alive), so tell them it is dead.
+    MarkManifestStopped(g_pManifestView_Out);
     if (g_pManifestView_Out)    UnmapViewOfFile(g_pManifestView_Out);
     if (g_hManifest_Out)        CloseHandle(g_hManifest_Out);
     if (g_sharedNTHandle_Out)   CloseHandle(g_sharedNTHandle_Out);
@@ -176,23 +187,24 @@ HRESULT CreateSharingResources(UINT width, UINT height, DXGI_FORMAT format) {
 
     // Publish the broker manifest (named file-mapping) so BrokerClient can
     // discover the texture/fence names by simply reading this small struct.
-    g_hManifest_Out = CreateFileMappingW(INVALID_HANDLE_VALUE, &sa, PAGE_READWRITE, 0, sizeof(BroadcastManifest), BROKER_MANIFEST_NAME);
+    g_hManifest_Out = CreateFileMappingW(INVALID_HANDLE_VALUE, &sa, PAGE_READWRITE, 0, sizeof(VirtuaCam::BroadcastManifestV2), BROKER_MANIFEST_NAME);
     if (!g_hManifest_Out) return HRESULT_FROM_WIN32(GetLastError());
 
-    g_pManifestView_Out = (BroadcastManifest*)MapViewOfFile(g_hManifest_Out, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(BroadcastManifest));
+    g_pManifestView_Out = (VirtuaCam::BroadcastManifestV2*)MapViewOfFile(g_hManifest_Out, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(VirtuaCam::BroadcastManifestV2));
     if (!g_pManifestView_Out) { ShutdownSharing(); return E_FAIL; }
 
-    ZeroMemory(g_pManifestView_Out, sizeof(BroadcastManifest));
-    g_pManifestView_Out->width       = width;
-    g_pManifestView_Out->height      = height;
-    g_pManifestView_Out->format      = format;
-    g_pManifestView_Out->adapterLuid = g_adapterLuid;
-    g_pManifestView_Out->command     = VCamCommand::None;
-    wcscpy_s(g_pManifestView_Out->textureName, _countof(g_pManifestView_Out->textureName), textureName);
-    wcscpy_s(g_pManifestView_Out->fenceName,   _countof(g_pManifestView_Out->fenceName),   fenceName);
+    // The command starts as VCamCommand::None (zero).
+    InitializeManifest(g_pManifestView_Out, width, height, format, g_adapterLuid, textureName, fenceName);
     return S_OK;
 }
 
+// The broker is not a producer slot, but BrokerClient watches the directory's
+// change sequence to retry its connection at once, so announce the output
+// manifest appearing and going away.
+void NotifyDirectory() {
+    g_directory.Notify();
+}
+
 HRESULT InitD3D11_Broker() {
     ComPtr<ID3D11DeviceContext> context;
     RETURN_IF_FAILED(D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, D3D11_CREATE_DEVICE_BGRA_SUPPORT, nullptr, 0, D3D11_SDK_VERSION, &g_device, nullptr, &context));
@@ -214,6 +226,9 @@ extern "C" {
     // output resources.  Must be called once before any other Broker function.
     BROKER_API void InitializeBroker() {
         CoInitializeEx(NULL, COINIT_MULTITHREADED);
+        // The broker owns the directory along with the producers; Discovery
+        // and the virtual camera only open it.
+        g_directory.Open();
         if (SUCCEEDED(InitD3D11_Broker())) {
             g_discovery = std::make_unique<VirtuaCam::Discovery>();
             g_discovery->Initialize(g_device.Get());
@@ -222,17 +237,20 @@ extern "C" {
             g_multiplexer->Initialize(g_device);
 
             // Fixed 1080p output — matches the virtual camera's advertised format.
-            CreateSharingResources(1920, 1080, DXGI_FORMAT_B8G8R8A8_UNORM);
+            if (SUCCEEDED(CreateSharingResources(1920, 1080, DXGI_FORMAT_B8G8R8A8_UNORM))) NotifyDirectory();
         }
     }
 
     BROKER_API void ShutdownBroker() {
         ShutdownSharing();
+        NotifyDirectory();
         if (g_multiplexer) g_multiplexer->Shutdown();
         if (g_discovery)   g_discovery->Teardown();
+        VirtuaCam::WorkerPool::Shared().Shutdown();     // before the DLL can be unloaded
         g_device.Reset();
         g_multiplexer.reset();
         g_discovery.reset();
+        g_directory.Close();
         CoUninitialize();
     }
 
@@ -249,6 +267,26 @@ extern "C" {
         g_isGridMode = isGrid;
     }
 
+    // Key out a colour of one producer when it is shown as a PiP overlay, e.g.
+    // a green-screen camera over a captured window.  keyRGB is 0x00RRGGBB;
+    // tolerance and softness are chroma distances in 0..1 units and spill
+    // (0..1) is how much of the key's colour cast is removed.  A negative
+    // tolerance removes the producer's key.
+    BROKER_API void SetProducerChromaKey(DWORD pid, UINT keyRGB, float tolerance, float softness, float spill) {
+        std::lock_guard<std::mutex> lock(g_producerListMutex);
+        if (tolerance < 0.0f) {
+            g_chromaKeys.erase(pid);
+            return;
+        }
+        VirtuaCam::ChromaKeyParams& key = g_chromaKeys[pid];
+        key.keyR      = (uint8_t)(keyRGB >> 16);
+        key.keyG      = (uint8_t)(keyRGB >> 8);
+        key.keyB      = (uint8_t)keyRGB;
+        key.tolerance = tolerance;
+        key.softness  = softness;
+        key.spill     = spill;
+    }
+
     // Composite one frame and signal the output fence.
     // Called by VirtuaCam.exe's render loop at ~30 fps.
     BROKER_API void RenderBrokerFrame() {
@@ -263,6 +301,7 @@ extern "C" {
 
         {
             std::lock_guard<std::mutex> lock(g_producerListMutex);
+            g_multiplexer->SetChromaKeys(g_chromaKeys);
             if (g_isGridMode) {
                 // Grid mode: include every discovered producer regardless of priority.
                 streamsToMux = allStreams;
@@ -309,10 +348,17 @@ extern "C" {
         UINT64 frameValue = g_multiplexer->GetOutputFrameValue();
         context4->Signal(g_sharedFence_Out.Get(), frameValue);
 
-        // Publish the new frame counter atomically so BrokerClient can detect
-        // it without a kernel event.  InterlockedExchange64 prevents torn reads.
-        InterlockedExchange64(reinterpret_cast<volatile LONGLONG*>(&g_pManifestView_Out->frameValue), frameValue);
-        g_pManifestView_Out->command = VCamCommand::None;
+        // Publish the new frame (record, then counter) so BrokerClient can
+        // detect it without a kernel event.  A skipped composite leaves the
+        // counter where it was and needs no new record.
+        if (frameValue != g_pManifestView_Out->frameValue.load(std::memory_order_relaxed)) {
+            VirtuaCam::ManifestFrameInfo info = ManifestFrameNow(frameValue, g_pManifestView_Out->width, g_pManifestView_Out->height,
+                                                                 (DXGI_FORMAT)g_pManifestView_Out->format);
+            if (LONGLONG captured = g_multiplexer->GetOutputCaptureTime())
+                info.captureTime = captured;
+            VirtuaCam::PublishFrame(*g_pManifestView_Out, info);
+        }
+        g_pManifestView_Out->command.store((uint32_t)VCamCommand::None, std::memory_order_relaxed);
     }
 
     // Return the shared output texture (with an AddRef).
@@ -13,7 +13,8 @@
 //      to Media Foundation as a video sample.
 //   4. If the broker is not running, show a static black "NO SIGNAL" frame.
 //   5. Optionally convert the RGB32 frame to NV12 via VideoProcessorMFT if
-//      the consumer has negotiated NV12 as the media type.
+//      the consumer has negotiated NV12 as the media type, or to YUY2 / I420 /
+//      P010 on the CPU (staging readback + ColorConvert kernels).
 //
 // CRITICAL DESIGN: Creator-Consumer Pattern for Cross-Session Access
 // -------------------------------------------------------------------
@@ -103,6 +104,8 @@ HRESULT BrokerClient::ReconfigureFormat(UINT width, UINT height)
     _textureRTV.reset();
     _converter.reset();
     _noSignalTexture.reset();
+    for (auto& staging : _stagingTextures) staging.reset();
+    _stagingPrimed = false;
 
     CD3D11_TEXTURE2D_DESC desc(DXGI_FORMAT_B8G8R8A8_UNORM, width, height, 1, 1, D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET);
     RETURN_IF_FAILED(device->CreateTexture2D(&desc, nullptr, &_texture));
@@ -124,6 +127,7 @@ HRESULT BrokerClient::ReconfigureFormat(UINT width, UINT height)
     iType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
     iType->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_RGB32);
     MFSetAttributeSize(iType.get(), MF_MT_FRAME_SIZE, width, height);
+    iType->SetUINT32(MF_MT_VIDEO_NOMINAL_RANGE, MFNominalRange_0_255);
     RETURN_IF_FAILED(_converter->SetInputType(0, iType.get(), 0));
 
     wil::com_ptr_nothrow<IMFMediaType> oType;
@@ -131,6 +135,9 @@ HRESULT BrokerClient::ReconfigureFormat(UINT width, UINT height)
     oType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
     oType->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_NV12);
     MFSetAttributeSize(oType.get(), MF_MT_FRAME_SIZE, width, height);
+    // Must match the colorimetry advertised on the NV12 media types in
+    // MFStream::Initialize; the MFT honours these attributes when converting.
+    RETURN_IF_FAILED(SetYuvColorimetry(oType.get(), VirtuaCam::DefaultColorimetry(width, height)));
     RETURN_IF_FAILED(_converter->SetOutputType(0, oType.get(), 0));
 
     // Share the same D3D device with the MFT for zero-copy GPU conversion.
@@ -148,8 +155,6 @@ HRESULT BrokerClient::ReconfigureFormat(UINT width, UINT height)
 void BrokerClient::DisconnectFromProducer()
 {
     if (!_producer.isConnected) return;
-    if (_producer.pManifestView) UnmapViewOfFile(_producer.pManifestView);
-    if (_producer.hManifest)     CloseHandle(_producer.hManifest);
     _producer = {};
     _producerPrivateTexture.reset();
     _producerSRV.reset();
@@ -192,33 +197,59 @@ HRESULT BrokerClient::CreateBlitResources()
 // FindAndConnectToBroker
 // ---------------------------------------------------------------------------
 // Attempt to open the broker manifest and from it open the shared texture and
-// fence.  If already connected, checks that the broker is still alive.
-// Retries at most once every 2 seconds to avoid hammering the kernel on
-// systems where the broker hasn't started yet.
+// fence.  If already connected, checks that the broker is still alive and
+// drops the connection (falling back to NO SIGNAL) if not.
+// While the broker is absent, retries as soon as the producer directory's
+// change sequence moves (the broker notifies it when its manifest appears
+// and goes away), and otherwise at most once every 2 seconds, which also
+// covers a directory this process cannot open.  The directory is opened
+// read-only and never created here: `Local\` only resolves to the App's
+// objects because the Frame Server opens them, and a directory created by
+// this process (before the App runs, or in another session namespace) would
+// be an empty one whose change sequence never moves.
 
 HRESULT BrokerClient::FindAndConnectToBroker()
 {
+    auto now = std::chrono::steady_clock::now();
+    const uint64_t directoryChange = _directory.ChangeCount();   // 0 until opened
+
     if (_producer.isConnected) {
-        // Check if the mapping handle has been abandoned (broker process exited).
-        if (WaitForSingleObject(_producer.hManifest, 0) == WAIT_ABANDONED) {
-            DisconnectFromProducer();
+        // The held view keeps the broker's mapping alive after the broker
+        // exits, so check the broker instead: on shutdown it marks the
+        // manifest stopped (and notifies the directory); a crash signals its
+        // process handle, checked on a directory change and once a second.
+        bool alive = !_producer.manifest.Stopped();
+        if (alive && (directoryChange != _lastDirectoryChange || now - _lastProducerSearchTime >= std::chrono::seconds(1))) {
+            _lastDirectoryChange = directoryChange;
+            _lastProducerSearchTime = now;
+            alive = !_producer.process || WaitForSingleObject(_producer.process.get(), 0) == WAIT_TIMEOUT;
         }
-        return S_OK;
+        if (alive) return S_OK;
+        DisconnectFromProducer();   // and look for a restarted broker right away
     }
 
-    // Rate-limit reconnection attempts to avoid spinning the CPU.
-    auto now = std::chrono::steady_clock::now();
-    if (_brokerState == BrokerState::Failed && (now - _lastProducerSearchTime < std::chrono::seconds(2))) {
+    // Rate-limit reconnection attempts to avoid spinning the CPU, unless the
+    // directory says something changed.
+    if (_brokerState == BrokerState::Failed && directoryChange == _lastDirectoryChange &&
+        (now - _lastProducerSearchTime < std::chrono::seconds(2))) {
         return S_OK;
     }
     _lastProducerSearchTime = now;
-
-    HANDLE hManifest = OpenFileMappingW(FILE_MAP_READ, FALSE, BROKER_MANIFEST_NAME);
-    if (!hManifest) { _brokerState = BrokerState::Failed; return S_OK; }
-    wil::unique_handle manifest_closer(hManifest);
-
-    BroadcastManifest* pManifestView = (BroadcastManifest*)MapViewOfFile(hManifest, FILE_MAP_READ, 0, 0, sizeof(BroadcastManifest));
-    if (!pManifestView) { _brokerState = BrokerState::Failed; return S_OK; }
+    _lastDirectoryChange = directoryChange;
+    if (!_directory.IsOpen())
+        _directory.Open(VirtuaCam::ProducerDirectory::kDefaultName, VirtuaCam::ProducerDirectory::Access::ReadOnly);
+
+    // A mapping still held open by other clients outlives its broker.
+    ManifestView manifest;
+    if (!manifest.Open(BROKER_MANIFEST_NAME) || manifest.Stopped()) { _brokerState = BrokerState::Failed; return S_OK; }
+
+    // The Frame Server's account may not be granted a handle on the broker;
+    // then only a clean shutdown is noticed, not a crash.
+    wil::unique_handle process;
+    if (manifest.ProcessId()) {
+        process.reset(OpenProcess(SYNCHRONIZE, FALSE, manifest.ProcessId()));
+        if (process && WaitForSingleObject(process.get(), 0) != WAIT_TIMEOUT) { _brokerState = BrokerState::Failed; return S_OK; }
+    }
 
     wil::com_ptr_nothrow<ID3D11Device> device;
     THROW_IF_FAILED(_dxgiManager->GetVideoService(_deviceHandle, IID_PPV_ARGS(&device)));
@@ -245,9 +276,9 @@ HRESULT BrokerClient::FindAndConnectToBroker()
         if (device1 && device5) {
             // GetHandleFromName uses a temporary D3D12 device to call
             // OpenSharedHandleByName (a D3D12-only API).
-            wil::unique_handle hTexture(GetHandleFromName(pManifestView->textureName));
+            wil::unique_handle hTexture(GetHandleFromName(manifest.TextureName()));
             if (hTexture && SUCCEEDED(device1->OpenSharedResource1(hTexture.get(), IID_PPV_ARGS(&_producer.sharedTexture)))) {
-                wil::unique_handle hFence(GetHandleFromName(pManifestView->fenceName));
+                wil::unique_handle hFence(GetHandleFromName(manifest.FenceName()));
                 if (hFence && SUCCEEDED(device5->OpenSharedFence(hFence.get(), IID_PPV_ARGS(&_producer.sharedFence)))) {
                     RETURN_IF_FAILED(CreateBlitResources());
 
@@ -264,8 +295,9 @@ HRESULT BrokerClient::FindAndConnectToBroker()
                     RETURN_IF_FAILED(device->CreateShaderResourceView(_producerPrivateTexture.get(), nullptr, &_producerSRV));
 
                     _producer.isConnected   = true;
-                    _producer.hManifest     = manifest_closer.release();
-                    _producer.pManifestView = pManifestView;
+                    _producer.producerPid   = manifest.ProcessId();
+                    _producer.process       = std::move(process);
+                    _producer.manifest      = std::move(manifest);
                     _brokerState            = BrokerState::Connected;
                     return S_OK;
                 }
@@ -273,7 +305,6 @@ HRESULT BrokerClient::FindAndConnectToBroker()
         }
     }
 
-    UnmapViewOfFile(pManifestView);
     _brokerState = BrokerState::Failed;
     return S_OK;
 }
@@ -312,7 +343,8 @@ HRESULT BrokerClient::SetD3DManager(IUnknown* manager, UINT width, UINT height)
 //   2b. Not connected: copy the static "NO SIGNAL" frame.
 //   3. Wrap the render target in an IMFSample (via a DXGI surface buffer).
 //   4. If the negotiated format is NV12, push the sample through VideoProcessorMFT
-//      and return the converted output sample.
+//      and return the converted output sample; YUY2 / I420 / P010 are converted
+//      on the CPU by ConvertOnCpu, one frame behind (see there).
 
 HRESULT BrokerClient::Generate(IMFSample* sample, REFGUID format, IMFSample** outSample)
 {
@@ -329,7 +361,7 @@ HRESULT BrokerClient::Generate(IMFSample* sample, REFGUID format, IMFSample** ou
     FindAndConnectToBroker();
 
     if (_producer.isConnected) {
-        UINT64 latestFrame = _producer.pManifestView->frameValue;
+        UINT64 latestFrame = _producer.manifest.FrameValue();
         if (latestFrame > _producer.lastSeenFrame) {
             // GPU fence Wait: blocks the GPU command queue (not the CPU thread)
             // until the broker has finished writing this frame.  This ensures
@@ -371,6 +403,9 @@ HRESULT BrokerClient::Generate(IMFSample* sample, REFGUID format, IMFSample** ou
     RETURN_IF_FAILED(MFCreateDXGISurfaceBuffer(__uuidof(ID3D11Texture2D), _texture.get(), 0, 0, &mediaBuffer));
     RETURN_IF_FAILED(sample->AddBuffer(mediaBuffer.get()));
 
+    // The staging copies are only kept up to date on the CPU path.
+    if (!IsSoftwareVideoFormat(format)) _stagingPrimed = false;
+
     if (format == MFVideoFormat_NV12) {
         // Push through VideoProcessorMFT to convert BGRA8 -> NV12 on the GPU.
         RETURN_HR_IF_NULL(E_UNEXPECTED, _converter);
@@ -381,6 +416,8 @@ HRESULT BrokerClient::Generate(IMFSample* sample, REFGUID format, IMFSample** ou
         if (hr == MF_E_TRANSFORM_NEED_MORE_INPUT) return S_OK;  // No output yet; caller will retry.
         RETURN_IF_FAILED(hr);
         *outSample = buffer.pSample;
+    } else if (IsSoftwareVideoFormat(format)) {
+        RETURN_IF_FAILED(ConvertOnCpu(context.get(), sample, format, outSample));
     } else {
         // RGB32 / BGRA8 — return the sample directly (no conversion needed).
         sample->AddRef();
@@ -388,3 +425,90 @@ HRESULT BrokerClient::Generate(IMFSample* sample, REFGUID format, IMFSample** ou
     }
     return S_OK;
 }
+
+// ---------------------------------------------------------------------------
+// ConvertOnCpu
+// ---------------------------------------------------------------------------
+// Reads the rendered BGRA frame back through a staging texture and converts it
+// with the SIMD kernels in ColorConvert.cpp straight into a system-memory MF
+// buffer of the negotiated format; the conversion runs band-parallel on the
+// shared worker pool.
+//
+// Mapping the copy just queued would stall this thread until the GPU has
+// rendered and copied the frame.  Instead each frame is copied into one of
+// two staging textures and the other one, holding the previous frame's copy
+// (a frame interval old, normally complete), is mapped: the output trails the
+// render by one frame.  Map() is tried with D3D11_MAP_FLAG_DO_NOT_WAIT first
+// and only waits if that copy is still running.  The first frame after a
+// reconfigure or a switch from a GPU format has no previous copy and waits
+// for its own.  The staging textures (32 MB each at 4K) exist only once a
+// CPU format is in use.
+
+HRESULT BrokerClient::ConvertOnCpu(ID3D11DeviceContext* context, IMFSample* sample, REFGUID format, IMFSample** outSample)
+{
+    if (!_stagingTextures[0]) {
+        wil::com_ptr_nothrow<ID3D11Device> device;
+        context->GetDevice(&device);
+        CD3D11_TEXTURE2D_DESC stagingDesc(DXGI_FORMAT_B8G8R8A8_UNORM, _width, _height, 1, 1, 0, D3D11_USAGE_STAGING, D3D11_CPU_ACCESS_READ);
+        for (auto& staging : _stagingTextures) {
+            RETURN_IF_FAILED(device->CreateTexture2D(&stagingDesc, nullptr, &staging));
+        }
+        _stagingNext = 0;
+        _stagingPrimed = false;
+    }
+
+    const UINT current = _stagingNext;
+    const UINT previous = (current + kStagingTextures - 1) % kStagingTextures;
+    context->CopyResource(_stagingTextures[current].get(), _texture.get());
+    _stagingNext = (current + 1) % kStagingTextures;
+    ID3D11Texture2D* staging = _stagingTextures[_stagingPrimed ? previous : current].get();
+    _stagingPrimed = true;
+
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    HRESULT mapResult = context->Map(staging, 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+    if (mapResult == DXGI_ERROR_WAS_STILL_DRAWING)
+        mapResult = context->Map(staging, 0, D3D11_MAP_READ, 0, &mapped);
+    RETURN_IF_FAILED(mapResult);
+    auto unmap = wil::scope_exit([&] { context->Unmap(staging, 0); });
+
+    wil::com_ptr_nothrow<IMFMediaBuffer> buffer;
+    RETURN_IF_FAILED(MFCreate2DMediaBuffer(_width, _height, format.Data1, FALSE, &buffer));
+    wil::com_ptr_nothrow<IMF2DBuffer2> buffer2d;
+    RETURN_IF_FAILED(buffer.query_to(&buffer2d));
+
+    BYTE* scanline0 = nullptr;
+    LONG pitch = 0;
+    BYTE* bufferStart = nullptr;
+    DWORD bufferLength = 0;
+    RETURN_IF_FAILED(buffer2d->Lock2DSize(MF2DBuffer_LockFlags_Write, &scanline0, &pitch, &bufferStart, &bufferLength));
+
+    BYTE* input = static_cast<BYTE*>(mapped.pData);
+    const ULONG inputSize = mapped.RowPitch * _height;
+    const ULONG outputSize = bufferLength - (ULONG)(scanline0 - bufferStart);
+    const VirtuaCam::YuvColorimetry colorimetry = VirtuaCam::DefaultColorimetry(_width, _height);
+    HRESULT hr = E_UNEXPECTED;
+    if (format == MFVideoFormat_YUY2)
+        hr = RGB32ToYUY2(input, inputSize, mapped.RowPitch, _width, _height, scanline0, outputSize, pitch, colorimetry);
+    else if (format == MFVideoFormat_I420)
+        hr = RGB32ToI420(input, inputSize, mapped.RowPitch, _width, _height, scanline0, outputSize, pitch, colorimetry);
+    else if (format == MFVideoFormat_P010)
+        hr = RGB32ToP010(input, inputSize, mapped.RowPitch, _width, _height, scanline0, outputSize, pitch, colorimetry);
+    buffer2d->Unlock2D();
+    RETURN_IF_FAILED(hr);
+
+    DWORD contiguousLength = 0;
+    RETURN_IF_FAILED(buffer2d->GetContiguousLength(&contiguousLength));
+    RETURN_IF_FAILED(buffer->SetCurrentLength(contiguousLength));
+
+    wil::com_ptr_nothrow<IMFSample> output;
+    RETURN_IF_FAILED(MFCreateSample(&output));
+    RETURN_IF_FAILED(output->AddBuffer(buffer.get()));
+    LONGLONG time = 0;
+    if (SUCCEEDED(sample->GetSampleTime(&time)))
+        RETURN_IF_FAILED(output->SetSampleTime(time));
+    if (SUCCEEDED(sample->GetSampleDuration(&time)))
+        RETURN_IF_FAILED(output->SetSampleDuration(time));
+
+    *outSample = output.detach();
+    return S_OK;
+}
@@ -4,13 +4,14 @@
 #include <DirectXMath.h>
 #include "Tools.h"
 #include "App.h"
+#include "ProducerDirectory.h"
 
 struct ProducerConnection
 {
     bool isConnected = false;
     DWORD producerPid = 0;
-    HANDLE hManifest = nullptr;
-    BroadcastManifest* pManifestView = nullptr;
+    wil::unique_handle process;   // SYNCHRONIZE handle on the broker, if granted
+    ManifestView manifest;   // the broker's output manifest, mapped while connected
     wil::com_ptr_nothrow<ID3D11Texture2D> sharedTexture;
     wil::com_ptr_nothrow<ID3D11Fence> sharedFence;
     UINT64 lastSeenFrame = 0;
@@ -27,6 +28,8 @@ class BrokerClient
     wil::com_ptr_nothrow<IMFTransform> _converter;
     ProducerConnection _producer;
     std::chrono::steady_clock::time_point _lastProducerSearchTime;
+    VirtuaCam::ProducerDirectory _directory;   // change sequence bumped when the broker (re)publishes
+    uint64_t _lastDirectoryChange;
     BrokerState _brokerState;
     wil::com_ptr_nothrow<ID3D11Texture2D> _producerPrivateTexture;
     wil::com_ptr_nothrow<ID3D11ShaderResourceView> _producerSRV;
@@ -34,16 +37,23 @@ class BrokerClient
     wil::com_ptr_nothrow<ID3D11PixelShader> _blitPS;
     wil::com_ptr_nothrow<ID3D11SamplerState> _blitSampler;
     wil::com_ptr_nothrow<ID3D11Texture2D> _noSignalTexture;  // Static "NO SIGNAL" frame shown when the broker is absent
+    // CPU readback of _texture for YUY2/I420/P010 output, created on first
+    // use: frame N is copied into one while frame N-1 is read from the other.
+    static constexpr UINT kStagingTextures = 2;
+    wil::com_ptr_nothrow<ID3D11Texture2D> _stagingTextures[kStagingTextures];
+    UINT _stagingNext = 0;          // staging texture the next frame is copied into
+    bool _stagingPrimed = false;    // the previous one holds the last frame's copy
 
 private:
     HRESULT FindAndConnectToBroker();
     void DisconnectFromProducer();
     HRESULT CreateBlitResources();
+    HRESULT ConvertOnCpu(ID3D11DeviceContext* context, IMFSample* sample, REFGUID format, IMFSample** outSample);
     
 public:
     BrokerClient() :
         _width(0), _height(0), _deviceHandle(nullptr), _producer{},
-        _lastProducerSearchTime{}, _brokerState(BrokerState::Searching) {}
+        _lastProducerSearchTime{}, _lastDirectoryChange(0), _brokerState(BrokerState::Searching) {}
 
     ~BrokerClient()
     {
@@ -0,0 +1,241 @@
+// =============================================================================
+// ChangeDetector.cpp  --  Tile-hash change detection for BGRA frames
+// =============================================================================
+// See ChangeDetector.h for the public contract.
+//
+// Lane step:  h = rotl((h ^ word) * kLanePrime, 13)
+// Lanes 0..7 take the 8 dwords of each 32-byte block of a tile row; a row
+// whose tile width is not a multiple of 8 pixels feeds its last dwords to
+// lanes 0..n-1 with the scalar step (shared by every kernel, so all levels
+// agree).  The row kernels walk a whole frame row, tile after tile, keeping
+// each tile's lane state in 'state[tileX * 8 .. + 8)'.
+// =============================================================================
+
+#include "ChangeDetector.h"
+#include <algorithm>
+#include <cstring>
+
+#if VCAM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace VirtuaCam {
+
+namespace
+{
+    constexpr uint32_t kLanes = 8;
+    constexpr uint32_t kLanePrime = 0x9E3779B1u;    // odd, so the multiply is a bijection
+    constexpr uint32_t kLaneRotate = 13;
+
+    using HashRowFn = void (*)(uint32_t* state, const uint8_t* row, uint32_t width, uint32_t tileSize);
+
+    inline uint32_t Rotl32(uint32_t v, uint32_t r)
+    {
+        return (v << r) | (v >> (32 - r));
+    }
+
+    inline uint32_t LaneStep(uint32_t h, uint32_t word)
+    {
+        return Rotl32((h ^ word) * kLanePrime, kLaneRotate);
+    }
+
+    // Tail dwords of one tile row (after the last whole 32-byte block).
+    inline void HashTail(uint32_t* lanes, const uint8_t* p, uint32_t words)
+    {
+        for (uint32_t i = 0; i < words; ++i)
+        {
+            uint32_t w;
+            std::memcpy(&w, p + i * 4, 4);
+            lanes[i] = LaneStep(lanes[i], w);
+        }
+    }
+
+    uint64_t FoldLanes(const uint32_t* lanes)
+    {
+        uint64_t h = 0x9E3779B97F4A7C15ull;
+        for (uint32_t i = 0; i < kLanes; ++i)
+        {
+            h = (h ^ lanes[i]) * 0xFF51AFD7ED558CCDull;
+            h ^= h >> 33;
+        }
+        return h;
+    }
+
+    void HashRow_Scalar(uint32_t* state, const uint8_t* row, uint32_t width, uint32_t tileSize)
+    {
+        for (uint32_t x = 0; x < width; x += tileSize, state += kLanes)
+        {
+            const uint32_t words = std::min(tileSize, width - x);
+            const uint8_t* p = row + (size_t)x * 4;
+            uint32_t i = 0;
+            for (; i + kLanes <= words; i += kLanes)
+                for (uint32_t l = 0; l < kLanes; ++l)
+                {
+                    uint32_t w;
+                    std::memcpy(&w, p + (i + l) * 4, 4);
+                    state[l] = LaneStep(state[l], w);
+                }
+            HashTail(state, p + i * 4, words - i);
+        }
+    }
+
+#if VCAM_SIMD_X86
+    VCAM_TARGET_SSE41 inline __m128i LaneStep_SSE41(__m128i h, __m128i w)
+    {
+        const __m128i m = _mm_mullo_epi32(_mm_xor_si128(h, w), _mm_set1_epi32((int)kLanePrime));
+        return _mm_or_si128(_mm_slli_epi32(m, kLaneRotate), _mm_srli_epi32(m, 32 - kLaneRotate));
+    }
+
+    VCAM_TARGET_SSE41 void HashRow_SSE41(uint32_t* state, const uint8_t* row, uint32_t width, uint32_t tileSize)
+    {
+        for (uint32_t x = 0; x < width; x += tileSize, state += kLanes)
+        {
+            const uint32_t words = std::min(tileSize, width - x);
+            const uint8_t* p = row + (size_t)x * 4;
+            __m128i lo = _mm_loadu_si128((const __m128i*)state);
+            __m128i hi = _mm_loadu_si128((const __m128i*)(state + 4));
+            uint32_t i = 0;
+            for (; i + kLanes <= words; i += kLanes)
+            {
+                lo = LaneStep_SSE41(lo, _mm_loadu_si128((const __m128i*)(p + i * 4)));
+                hi = LaneStep_SSE41(hi, _mm_loadu_si128((const __m128i*)(p + i * 4 + 16)));
+            }
+            _mm_storeu_si128((__m128i*)state, lo);
+            _mm_storeu_si128((__m128i*)(state + 4), hi);
+            HashTail(state, p + i * 4, words - i);
+        }
+    }
+
+    VCAM_TARGET_AVX2 inline __m256i LaneStep_AVX2(__m256i h, __m256i w)
+    {
+        const __m256i m = _mm256_mullo_epi32(_mm256_xor_si256(h, w), _mm256_set1_epi32((int)kLanePrime));
+        return _mm256_or_si256(_mm256_slli_epi32(m, kLaneRotate), _mm256_srli_epi32(m, 32 - kLaneRotate));
+    }
+
+    VCAM_TARGET_AVX2 void HashRow_AVX2(uint32_t* state, const uint8_t* row, uint32_t width, uint32_t tileSize)
+    {
+        for (uint32_t x = 0; x < width; x += tileSize, state += kLanes)
+        {
+            const uint32_t words = std::min(tileSize, width - x);
+            const uint8_t* p = row + (size_t)x * 4;
+            __m256i h = _mm256_loadu_si256((const __m256i*)state);
+            uint32_t i = 0;
+            for (; i + kLanes <= words; i += kLanes)
+                h = LaneStep_AVX2(h, _mm256_loadu_si256((const __m256i*)(p + i * 4)));
+            _mm256_storeu_si256((__m256i*)state, h);
+            HashTail(state, p + i * 4, words - i);
+        }
+    }
+#endif
+
+    HashRowFn SelectHashRow(SimdLevel level)
+    {
+#if VCAM_SIMD_X86
+        switch (ClampSimdLevel(level))
+        {
+        case SimdLevel::AVX512:
+        case SimdLevel::AVX2:   return HashRow_AVX2;
+        case SimdLevel::SSE41:  return HashRow_SSE41;
+        default:                break;
+        }
+#else
+        (void)level;
+#endif
+        return HashRow_Scalar;
+    }
+}
+
+ChangeDetector::ChangeDetector(uint32_t width, uint32_t height, uint32_t tileSize)
+{
+    Configure(width, height, tileSize);
+}
+
+void ChangeDetector::Configure(uint32_t width, uint32_t height, uint32_t tileSize)
+{
+    tileSize = std::max(tileSize, 1u);
+    if (width == m_width && height == m_height && tileSize == m_tileSize && !m_hashes.empty())
+        return;
+    m_width = width;
+    m_height = height;
+    m_tileSize = tileSize;
+    m_tilesX = (width + tileSize - 1) / tileSize;
+    m_tilesY = (height + tileSize - 1) / tileSize;
+    m_hashes.assign((size_t)m_tilesX * m_tilesY, 0);
+    m_dirty.assign(m_hashes.size(), 1);
+    m_dirtyCount = (uint32_t)m_hashes.size();
+    m_hasPrevious = false;
+}
+
+void ChangeDetector::HashTileRows(const uint8_t* bgra, ptrdiff_t stride, SimdLevel level,
+                                  uint32_t tileRowBegin, uint32_t tileRowEnd)
+{
+    const HashRowFn hashRow = SelectHashRow(level);
+    std::vector<uint32_t> state((size_t)m_tilesX * kLanes);
+
+    for (uint32_t ty = tileRowBegin; ty < tileRowEnd; ++ty)
+    {
+        for (size_t i = 0; i < state.size(); ++i)
+            state[i] = 0x85EBCA77u + (uint32_t)(i % kLanes);
+
+        const uint32_t y0 = ty * m_tileSize;
+        const uint32_t y1 = std::min(y0 + m_tileSize, m_height);
+        for (uint32_t y = y0; y < y1; ++y)
+            hashRow(state.data(), bgra + (ptrdiff_t)y * stride, m_width, m_tileSize);
+
+        for (uint32_t tx = 0; tx < m_tilesX; ++tx)
+        {
+            const size_t tile = (size_t)ty * m_tilesX + tx;
+            const uint64_t hash = FoldLanes(&state[(size_t)tx * kLanes]);
+            m_dirty[tile] = !m_hasPrevious || hash != m_hashes[tile];
+            m_hashes[tile] = hash;
+        }
+    }
+}
+
+bool ChangeDetector::Finish()
+{
+    m_hasPrevious = true;
+    m_dirtyCount = (uint32_t)std::count(m_dirty.begin(), m_dirty.end(), (uint8_t)1);
+    return m_dirtyCount != 0;
+}
+
+bool ChangeDetector::Update(const uint8_t* bgra, ptrdiff_t stride, SimdLevel level)
+{
+    if (!bgra || m_hashes.empty())
+        return true;
+    HashTileRows(bgra, stride, level, 0, m_tilesY);
+    return Finish();
+}
+
+bool ChangeDetector::UpdateParallel(const uint8_t* bgra, ptrdiff_t stride, WorkerPool& pool, SimdLevel level)
+{
+    if (!bgra || m_hashes.empty())
+        return true;
+    const uint32_t minTileRows = std::max(1u, WorkerPool::kMinBandRows / m_tileSize);
+    pool.ParallelBands(m_tilesY, 1, minTileRows, [&](uint32_t begin, uint32_t end) {
+        HashTileRows(bgra, stride, level, begin, end);
+    });
+    return Finish();
+}
+
+ChangeDetector::Rect ChangeDetector::DirtyBounds() const
+{
+    uint32_t minX = m_tilesX, minY = m_tilesY, maxX = 0, maxY = 0;
+    for (uint32_t ty = 0; ty < m_tilesY; ++ty)
+        for (uint32_t tx = 0; tx < m_tilesX; ++tx)
+            if (m_dirty[(size_t)ty * m_tilesX + tx])
+            {
+                minX = std::min(minX, tx); maxX = std::max(maxX, tx);
+                minY = std::min(minY, ty); maxY = std::max(maxY, ty);
+            }
+    if (minX > maxX || minY > maxY)
+        return {};
+    Rect r;
+    r.x = minX * m_tileSize;
+    r.y = minY * m_tileSize;
+    r.width = std::min((maxX + 1) * m_tileSize, m_width) - r.x;
+    r.height = std::min((maxY + 1) * m_tileSize, m_height) - r.y;
+    return r;
+}
+
+}
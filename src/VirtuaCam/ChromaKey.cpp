@@ -0,0 +1,320 @@
+// =============================================================================
+// ChromaKey.cpp  --  Chroma-key matte and spill suppression for BGRA frames
+// =============================================================================
+// See ChromaKey.h for the public contract.
+//
+// Every kernel works on one pixel per 32-bit lane with the same integer
+// steps, so the results match bit for bit:
+//
+//   cb  = (-43 R -  85 G + 128 B) >> 8          cr = (128 R - 107 G - 21 B) >> 8
+//   d2  = (cb - keyCb)^2 + (cr - keyCr)^2       <= 2 * 255^2, so the table
+//                                                  index d2 >> 4 never exceeds
+//                                                  kMatteEntries - 1
+//   s   = (max((cb dirCb + cr dirCr) >> 8, 0) * spill) >> 8
+//   dCb = (-s dirCb) >> 8                       dCr = (-s dirCr) >> 8
+//   R  += (359 dCr) >> 8    G -= (88 dCb + 183 dCr) >> 8    B += (454 dCb) >> 8
+//   a   = Div255(matte * A)                     c = Div255(c * a)
+//
+// The SSE4.1 kernel reads the matte table with four scalar loads; AVX2
+// gathers it.  The work is arithmetic-bound rather than memory-bound, but a
+// 16-lane gather is no faster than two 8-lane ones, so AVX-512 reuses AVX2.
+// =============================================================================
+
+#include "ChromaKey.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if VCAM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace VirtuaCam {
+
+namespace
+{
+    using Coefficients = ChromaKey::Coefficients;
+    using KeyRowFn = void (*)(const uint8_t* src, uint8_t* dst, uint32_t count, const Coefficients& k);
+
+    // -----------------------------------------------------------------------
+    // Scalar reference
+    // -----------------------------------------------------------------------
+
+    inline int32_t Div255(int32_t v)
+    {
+        return ((v + 128) * 257) >> 16;
+    }
+
+    inline int32_t ChromaB(int32_t r, int32_t g, int32_t b) { return (-43 * r - 85 * g + 128 * b) >> 8; }
+    inline int32_t ChromaR(int32_t r, int32_t g, int32_t b) { return (128 * r - 107 * g - 21 * b) >> 8; }
+
+    inline uint32_t KeyPixel(uint32_t pixel, const Coefficients& k)
+    {
+        int32_t b = pixel & 0xFF, g = (pixel >> 8) & 0xFF, r = (pixel >> 16) & 0xFF;
+        const int32_t alpha = pixel >> 24;
+
+        const int32_t cb = ChromaB(r, g, b);
+        const int32_t cr = ChromaR(r, g, b);
+        const int32_t dcb = cb - k.keyCb, dcr = cr - k.keyCr;
+        const int32_t matte = (int32_t)k.matte[(uint32_t)(dcb * dcb + dcr * dcr) >> ChromaKey::kMatteShift];
+
+        const int32_t s = (std::max((cb * k.dirCb + cr * k.dirCr) >> 8, 0) * k.spill) >> 8;
+        const int32_t sCb = (-s * k.dirCb) >> 8, sCr = (-s * k.dirCr) >> 8;
+        r = std::clamp(r + ((359 * sCr) >> 8), 0, 255);
+        g = std::clamp(g - ((88 * sCb + 183 * sCr) >> 8), 0, 255);
+        b = std::clamp(b + ((454 * sCb) >> 8), 0, 255);
+
+        const int32_t a = Div255(matte * alpha);
+        return (uint32_t)Div255(b * a) | (uint32_t)Div255(g * a) << 8 |
+               (uint32_t)Div255(r * a) << 16 | (uint32_t)a << 24;
+    }
+
+    void KeyRow_Scalar(const uint8_t* src, uint8_t* dst, uint32_t count, const Coefficients& k)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t pixel;
+            std::memcpy(&pixel, src + i * 4, 4);
+            pixel = KeyPixel(pixel, k);
+            std::memcpy(dst + i * 4, &pixel, 4);
+        }
+    }
+
+#if VCAM_SIMD_X86
+    // -----------------------------------------------------------------------
+    // SSE4.1: 4 pixels per step
+    // -----------------------------------------------------------------------
+
+    VCAM_TARGET_SSE41 inline __m128i Div255_SSE41(__m128i v)
+    {
+        return _mm_srli_epi32(_mm_mullo_epi32(_mm_add_epi32(v, _mm_set1_epi32(128)), _mm_set1_epi32(257)), 16);
+    }
+
+    VCAM_TARGET_SSE41 inline __m128i Madd3_SSE41(__m128i r, __m128i g, __m128i b, int cr, int cg, int cb)
+    {
+        return _mm_add_epi32(_mm_add_epi32(_mm_mullo_epi32(r, _mm_set1_epi32(cr)), _mm_mullo_epi32(g, _mm_set1_epi32(cg))),
+                             _mm_mullo_epi32(b, _mm_set1_epi32(cb)));
+    }
+
+    VCAM_TARGET_SSE41 inline __m128i Clamp255_SSE41(__m128i v)
+    {
+        return _mm_min_epi32(_mm_max_epi32(v, _mm_setzero_si128()), _mm_set1_epi32(255));
+    }
+
+    VCAM_TARGET_SSE41 void KeyRow_SSE41(const uint8_t* src, uint8_t* dst, uint32_t count, const Coefficients& k)
+    {
+        const __m128i byteMask = _mm_set1_epi32(0xFF);
+        const __m128i keyCb = _mm_set1_epi32(k.keyCb), keyCr = _mm_set1_epi32(k.keyCr);
+        const __m128i dirCb = _mm_set1_epi32(k.dirCb), dirCr = _mm_set1_epi32(k.dirCr);
+        const __m128i spill = _mm_set1_epi32(k.spill);
+        const __m128i zero = _mm_setzero_si128();
+
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128i pixels = _mm_loadu_si128((const __m128i*)(src + i * 4));
+            __m128i b = _mm_and_si128(pixels, byteMask);
+            __m128i g = _mm_and_si128(_mm_srli_epi32(pixels, 8), byteMask);
+            __m128i r = _mm_and_si128(_mm_srli_epi32(pixels, 16), byteMask);
+            const __m128i alpha = _mm_srli_epi32(pixels, 24);
+
+            const __m128i cb = _mm_srai_epi32(Madd3_SSE41(r, g, b, -43, -85, 128), 8);
+            const __m128i cr = _mm_srai_epi32(Madd3_SSE41(r, g, b, 128, -107, -21), 8);
+            const __m128i dcb = _mm_sub_epi32(cb, keyCb), dcr = _mm_sub_epi32(cr, keyCr);
+            const __m128i index = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(dcb, dcb), _mm_mullo_epi32(dcr, dcr)),
+                                                 ChromaKey::kMatteShift);
+            alignas(16) uint32_t idx[4];
+            _mm_store_si128((__m128i*)idx, index);
+            const __m128i matte = _mm_setr_epi32((int)k.matte[idx[0]], (int)k.matte[idx[1]],
+                                                 (int)k.matte[idx[2]], (int)k.matte[idx[3]]);
+
+            const __m128i p = _mm_max_epi32(_mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(cb, dirCb),
+                                                                         _mm_mullo_epi32(cr, dirCr)), 8), zero);
+            const __m128i s = _mm_sub_epi32(zero, _mm_srai_epi32(_mm_mullo_epi32(p, spill), 8));
+            const __m128i sCb = _mm_srai_epi32(_mm_mullo_epi32(s, dirCb), 8);
+            const __m128i sCr = _mm_srai_epi32(_mm_mullo_epi32(s, dirCr), 8);
+            r = Clamp255_SSE41(_mm_add_epi32(r, _mm_srai_epi32(_mm_mullo_epi32(sCr, _mm_set1_epi32(359)), 8)));
+            g = Clamp255_SSE41(_mm_sub_epi32(g, _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(sCb, _mm_set1_epi32(88)),
+                                                                            _mm_mullo_epi32(sCr, _mm_set1_epi32(183))), 8)));
+            b = Clamp255_SSE41(_mm_add_epi32(b, _mm_srai_epi32(_mm_mullo_epi32(sCb, _mm_set1_epi32(454)), 8)));
+
+            const __m128i a = Div255_SSE41(_mm_mullo_epi32(matte, alpha));
+            const __m128i out = _mm_or_si128(
+                _mm_or_si128(Div255_SSE41(_mm_mullo_epi32(b, a)), _mm_slli_epi32(Div255_SSE41(_mm_mullo_epi32(g, a)), 8)),
+                _mm_or_si128(_mm_slli_epi32(Div255_SSE41(_mm_mullo_epi32(r, a)), 16), _mm_slli_epi32(a, 24)));
+            _mm_storeu_si128((__m128i*)(dst + i * 4), out);
+        }
+        KeyRow_Scalar(src + i * 4, dst + i * 4, count - i, k);
+    }
+
+    // -----------------------------------------------------------------------
+    // AVX2: 8 pixels per step, gathered matte
+    // -----------------------------------------------------------------------
+
+    VCAM_TARGET_AVX2 inline __m256i Div255_AVX2(__m256i v)
+    {
+        return _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_add_epi32(v, _mm256_set1_epi32(128)), _mm256_set1_epi32(257)), 16);
+    }
+
+    VCAM_TARGET_AVX2 inline __m256i Madd3_AVX2(__m256i r, __m256i g, __m256i b, int cr, int cg, int cb)
+    {
+        return _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(r, _mm256_set1_epi32(cr)),
+                                                 _mm256_mullo_epi32(g, _mm256_set1_epi32(cg))),
+                                _mm256_mullo_epi32(b, _mm256_set1_epi32(cb)));
+    }
+
+    VCAM_TARGET_AVX2 inline __m256i Clamp255_AVX2(__m256i v)
+    {
+        return _mm256_min_epi32(_mm256_max_epi32(v, _mm256_setzero_si256()), _mm256_set1_epi32(255));
+    }
+
+    VCAM_TARGET_AVX2 void KeyRow_AVX2(const uint8_t* src, uint8_t* dst, uint32_t count, const Coefficients& k)
+    {
+        const __m256i byteMask = _mm256_set1_epi32(0xFF);
+        const __m256i keyCb = _mm256_set1_epi32(k.keyCb), keyCr = _mm256_set1_epi32(k.keyCr);
+        const __m256i dirCb = _mm256_set1_epi32(k.dirCb), dirCr = _mm256_set1_epi32(k.dirCr);
+        const __m256i spill = _mm256_set1_epi32(k.spill);
+        const __m256i zero = _mm256_setzero_si256();
+        const int* table = (const int*)k.matte;
+
+        uint32_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i pixels = _mm256_loadu_si256((const __m256i*)(src + i * 4));
+            __m256i b = _mm256_and_si256(pixels, byteMask);
+            __m256i g = _mm256_and_si256(_mm256_srli_epi32(pixels, 8), byteMask);
+            __m256i r = _mm256_and_si256(_mm256_srli_epi32(pixels, 16), byteMask);
+            const __m256i alpha = _mm256_srli_epi32(pixels, 24);
+
+            const __m256i cb = _mm256_srai_epi32(Madd3_AVX2(r, g, b, -43, -85, 128), 8);
+            const __m256i cr = _mm256_srai_epi32(Madd3_AVX2(r, g, b, 128, -107, -21), 8);
+            const __m256i dcb = _mm256_sub_epi32(cb, keyCb), dcr = _mm256_sub_epi32(cr, keyCr);
+            const __m256i index = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(dcb, dcb),
+                                                                     _mm256_mullo_epi32(dcr, dcr)),
+                                                    ChromaKey::kMatteShift);
+            const __m256i matte = _mm256_i32gather_epi32(table, index, 4);
+
+            const __m256i p = _mm256_max_epi32(_mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(cb, dirCb),
+                                                                                  _mm256_mullo_epi32(cr, dirCr)), 8), zero);
+            const __m256i s = _mm256_sub_epi32(zero, _mm256_srai_epi32(_mm256_mullo_epi32(p, spill), 8));
+            const __m256i sCb = _mm256_srai_epi32(_mm256_mullo_epi32(s, dirCb), 8);
+            const __m256i sCr = _mm256_srai_epi32(_mm256_mullo_epi32(s, dirCr), 8);
+            r = Clamp255_AVX2(_mm256_add_epi32(r, _mm256_srai_epi32(_mm256_mullo_epi32(sCr, _mm256_set1_epi32(359)), 8)));
+            g = Clamp255_AVX2(_mm256_sub_epi32(g, _mm256_srai_epi32(
+                _mm256_add_epi32(_mm256_mullo_epi32(sCb, _mm256_set1_epi32(88)), _mm256_mullo_epi32(sCr, _mm256_set1_epi32(183))), 8)));
+            b = Clamp255_AVX2(_mm256_add_epi32(b, _mm256_srai_epi32(_mm256_mullo_epi32(sCb, _mm256_set1_epi32(454)), 8)));
+
+            const __m256i a = Div255_AVX2(_mm256_mullo_epi32(matte, alpha));
+            const __m256i out = _mm256_or_si256(
+                _mm256_or_si256(Div255_AVX2(_mm256_mullo_epi32(b, a)), _mm256_slli_epi32(Div255_AVX2(_mm256_mullo_epi32(g, a)), 8)),
+                _mm256_or_si256(_mm256_slli_epi32(Div255_AVX2(_mm256_mullo_epi32(r, a)), 16), _mm256_slli_epi32(a, 24)));
+            _mm256_storeu_si256((__m256i*)(dst + i * 4), out);
+        }
+        KeyRow_SSE41(src + i * 4, dst + i * 4, count - i, k);
+    }
+#endif
+
+    KeyRowFn SelectKeyRow(SimdLevel level)
+    {
+#if VCAM_SIMD_X86
+        switch (ClampSimdLevel(level))
+        {
+        case SimdLevel::AVX512:
+        case SimdLevel::AVX2:   return KeyRow_AVX2;
+        case SimdLevel::SSE41:  return KeyRow_SSE41;
+        default:                break;
+        }
+#else
+        (void)level;
+#endif
+        return KeyRow_Scalar;
+    }
+
+    void KeyRows(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride, uint32_t width,
+                 uint32_t rowBegin, uint32_t rowEnd, const Coefficients& k, KeyRowFn keyRow)
+    {
+        for (uint32_t y = rowBegin; y < rowEnd; ++y)
+            keyRow(src + (ptrdiff_t)y * srcStride, dst + (ptrdiff_t)y * dstStride, width, k);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ChromaKey
+// ---------------------------------------------------------------------------
+
+void ChromaKey::Configure(const ChromaKeyParams& params)
+{
+    if (IsConfigured() && params == m_params)
+        return;
+    m_params = params;
+
+    Coefficients k;
+    k.keyCb = ChromaB(params.keyR, params.keyG, params.keyB);
+    k.keyCr = ChromaR(params.keyR, params.keyG, params.keyB);
+
+    // A grey key has no chroma direction to suppress.
+    const double length = std::sqrt((double)k.keyCb * k.keyCb + (double)k.keyCr * k.keyCr);
+    if (length >= 1.0)
+    {
+        k.dirCb = (int32_t)std::lround(256.0 * k.keyCb / length);
+        k.dirCr = (int32_t)std::lround(256.0 * k.keyCr / length);
+    }
+    k.spill = (int32_t)std::lround(std::clamp(params.spill, 0.0f, 1.0f) * 256.0f);
+
+    // Matte per squared-distance bucket, sampled at the bucket centre.
+    const double tolerance = std::max(params.tolerance, 0.0f) * 255.0;
+    const double softness = std::max(params.softness, 0.0f) * 255.0;
+    m_matte.resize(kMatteEntries);
+    for (uint32_t i = 0; i < kMatteEntries; ++i)
+    {
+        const double d = std::sqrt((double)(i << kMatteShift) + (1 << kMatteShift) * 0.5);
+        double t;
+        if (softness > 0.0)
+        {
+            t = std::clamp((d - tolerance) / softness, 0.0, 1.0);
+            t = t * t * (3.0 - 2.0 * t);
+        }
+        else
+        {
+            t = d > tolerance ? 1.0 : 0.0;
+        }
+        m_matte[i] = (uint32_t)std::lround(t * 255.0);
+    }
+    k.matte = m_matte.data();
+    m_coefficients = k;
+}
+
+ChromaKeyShaderConstants ChromaKey::ShaderConstants() const
+{
+    ChromaKeyShaderConstants c = {};
+    c.keyCb = m_coefficients.keyCb / 255.0f;
+    c.keyCr = m_coefficients.keyCr / 255.0f;
+    c.directionCb = m_coefficients.dirCb / 256.0f;
+    c.directionCr = m_coefficients.dirCr / 256.0f;
+    c.tolerance = std::max(m_params.tolerance, 0.0f);
+    c.softness = std::max(m_params.softness, 0.0f);
+    c.spill = std::clamp(m_params.spill, 0.0f, 1.0f);
+    return c;
+}
+
+void ChromaKey::Apply(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                      uint32_t width, uint32_t height, SimdLevel level) const
+{
+    if (!src || !dst || !IsConfigured())
+        return;
+    KeyRows(src, srcStride, dst, dstStride, width, 0, height, m_coefficients, SelectKeyRow(level));
+}
+
+void ChromaKey::ApplyParallel(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                              uint32_t width, uint32_t height, WorkerPool& pool, SimdLevel level) const
+{
+    if (!src || !dst || !IsConfigured())
+        return;
+    const KeyRowFn keyRow = SelectKeyRow(level);
+    pool.ParallelBands(height, 1, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd)
+    {
+        KeyRows(src, srcStride, dst, dstStride, width, rowBegin, rowEnd, m_coefficients, keyRow);
+    });
+}
+
+}
@@ -0,0 +1,96 @@
+// =============================================================================
+// ChromaKey.h  --  Chroma-key matte and spill suppression for BGRA frames
+// =============================================================================
+// Keys a source (typically a green-screen camera) so it can be layered over
+// another one: pixels whose chroma is close to the key colour become
+// transparent, a soft band around the tolerance gives smooth edges, and the
+// key colour's cast is removed from what remains ("spill").
+//
+// Everything happens in the Cb / Cr plane, where lighting changes on the
+// screen mostly move luma and leave the chroma distance small:
+//
+//   cb, cr     = BT.601 chroma of the pixel (8-bit scale, centred on 0)
+//   d^2        = (cb - key.cb)^2 + (cr - key.cr)^2
+//   matte      = table[d^2 >> 4]       smoothstep from 'tolerance' (0) to
+//                                      'tolerance + softness' (255)
+//   spill      = max(0, (cb, cr) . keyDirection) * params.spill
+//   (cb, cr)  -= spill * keyDirection  applied to RGB as a chroma delta,
+//                                      so luma is kept and spill = 0 leaves
+//                                      the colour untouched
+//
+// The matte curve is precomputed per Configure() into a table indexed by
+// the squared distance, so no square root or smoothstep runs per pixel.  The
+// output is premultiplied BGRA (alpha = matte * source alpha), ready for
+// BlendOver() (Blend.h) or a premultiplied GPU blend.
+//
+// All arithmetic is integer; the scalar, SSE4.1 and AVX2 kernels (AVX2
+// gathers the matte from the table) are bit-identical.  AVX-512 reuses AVX2.
+// The Multiplexer runs the same formulas in a pixel shader (in float) for
+// keyed PiP sources; ShaderConstants() provides its parameters.
+//
+// This header (and ChromaKey.cpp) deliberately has no Windows dependency.
+// =============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Simd.h"
+#include "WorkerPool.h"
+
+namespace VirtuaCam {
+
+struct ChromaKeyParams {
+    uint8_t keyR = 0, keyG = 177, keyB = 64;    // the key colour (default: chroma green)
+    float tolerance = 0.12f;    // chroma distance keyed out fully, in units of the 8-bit range
+    float softness = 0.08f;     // width of the transition band beyond 'tolerance'
+    float spill = 0.6f;         // 0 .. 1: share of the key-direction chroma removed
+
+    bool operator==(const ChromaKeyParams&) const = default;
+};
+
+// The same parameters in the shader's terms (chroma in -0.5 .. 0.5 units).
+struct ChromaKeyShaderConstants {
+    float keyCb, keyCr;
+    float directionCb, directionCr;     // unit vector towards the key chroma
+    float tolerance, softness, spill;
+    float padding;
+};
+
+class ChromaKey {
+public:
+    // Rebuilds the matte table; a no-op if the parameters did not change.
+    void Configure(const ChromaKeyParams& params);
+
+    bool IsConfigured() const { return !m_matte.empty(); }
+    const ChromaKeyParams& Params() const { return m_params; }
+    ChromaKeyShaderConstants ShaderConstants() const;
+
+    // Keys width x height BGRA pixels from 'src' into 'dst' (may be the same
+    // buffer) as premultiplied BGRA.  Strides in bytes.
+    void Apply(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+               uint32_t width, uint32_t height, SimdLevel level = GetSimdLevel()) const;
+
+    void ApplyParallel(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                       uint32_t width, uint32_t height, WorkerPool& pool = WorkerPool::Shared(),
+                       SimdLevel level = GetSimdLevel()) const;
+
+    // Fixed-point state shared by the kernels.
+    struct Coefficients {
+        int32_t keyCb = 0, keyCr = 0;       // key chroma, 8-bit scale
+        int32_t dirCb = 0, dirCr = 0;       // key direction, Q8 unit vector
+        int32_t spill = 0;                  // Q8
+        const uint32_t* matte = nullptr;    // kMatteEntries, indexed by d^2 >> kMatteShift
+    };
+
+    static constexpr uint32_t kMatteShift = 4;
+    static constexpr uint32_t kMatteEntries = (2 * 256 * 256 >> kMatteShift) + 1;
+
+private:
+    ChromaKeyParams m_params;
+    Coefficients m_coefficients;
+    std::vector<uint32_t> m_matte;
+};
+
+}
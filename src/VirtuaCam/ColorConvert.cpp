@@ -0,0 +1,823 @@
+// =============================================================================
+// ColorConvert.cpp  --  CPU colour-space conversion kernels
+// =============================================================================
+// See ColorConvert.h for the public contract.
+//
+// Integer coefficients (8-bit fixed point), e.g. for BT.601 limited range:
+//
+//   Y  = ( 66*R + 129*G +  25*B + 128) >> 8  + 16
+//   Cb = (-38*R -  74*G + 112*B + 128) >> 8  + 128
+//   Cr = (112*R -  94*G -  18*B + 128) >> 8  + 128
+//
+// The +128 before the shift is a rounding bias (0.5 after the divide); the +16
+// and +128 offsets are the foot levels (Y: [16,235], Cb/Cr: [16,240] in
+// limited range).  The shift is arithmetic, so negative chroma sums round
+// toward -infinity exactly like the scalar code.
+//
+// Every kernel is a template on a YuvCoefficients<> specialisation (see
+// Colorimetry.h); the SIMD constants are built from its static members and
+// fold to immediates.  Full-range chroma can reach 256, so the scalar path
+// clamps and the vector paths rely on their saturating packs.
+//
+// SIMD layout
+// -----------
+// All vector paths use the same trick: unpack BGRA bytes to 16-bit lanes,
+// multiply-add against (B,G,R,A) coefficient vectors with pmaddwd, then add
+// the two partial sums of each pixel horizontally.  For chroma only the even
+// (left) pixels of the bottom row are needed, so each even pixel is broadcast
+// into both halves of a 128-bit lane and multiplied against (Cb | Cr)
+// coefficients at once.  Results are packed back to bytes with saturating
+// packs; AVX2/AVX-512 packs work per 128-bit lane, so a final cross-lane
+// permute restores pixel order.
+//
+// Banding
+// -------
+// A band is just a sub-image: its source/Y rows start at the band's first row
+// and its UV rows at half of that.  Bands start on even rows, so no 2x2 chroma
+// block straddles two bands and the threads never write the same bytes.
+// =============================================================================
+
+#include "ColorConvert.h"
+#include <algorithm>
+#include <vector>
+
+#if VCAM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace VirtuaCam {
+
+namespace
+{
+    // -----------------------------------------------------------------------
+    // Scalar reference
+    // -----------------------------------------------------------------------
+
+    inline uint8_t ClampByte(int v)
+    {
+        return (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+    }
+
+    // P010 keeps its 10 significant bits in the top of each 16-bit sample.
+    inline uint16_t ClampP010(int v)
+    {
+        return (uint16_t)((v < 0 ? 0 : v > 1023 ? 1023 : v) << 6);
+    }
+
+    template <class C>
+    inline int LumaValue(const uint8_t* bgra)
+    {
+        return ((C::YR * bgra[2] + C::YG * bgra[1] + C::YB * bgra[0] + 128) >> 8) + C::YOffset;
+    }
+
+    template <class C>
+    inline int CbValue(const uint8_t* bgra)
+    {
+        return ((C::UR * bgra[2] + C::UG * bgra[1] + C::UB * bgra[0] + 128) >> 8) + C::UVOffset;
+    }
+
+    template <class C>
+    inline int CrValue(const uint8_t* bgra)
+    {
+        return ((C::VR * bgra[2] + C::VG * bgra[1] + C::VB * bgra[0] + 128) >> 8) + C::UVOffset;
+    }
+
+    template <class C>
+    inline uint8_t Luma(const uint8_t* bgra)
+    {
+        return ClampByte(LumaValue<C>(bgra));
+    }
+
+    template <class C>
+    inline void Chroma(const uint8_t* bgra, uint8_t* uv)
+    {
+        uv[0] = ClampByte(CbValue<C>(bgra));
+        uv[1] = ClampByte(CrValue<C>(bgra));
+    }
+
+    // Converts one pair of rows.  'bottom'/'yBottom' alias 'top'/'yTop' for the
+    // last row of an odd-height image, in which case the chroma comes from the
+    // top row instead.
+    using NV12RowFn = void (*)(const uint8_t* top, const uint8_t* bottom, uint8_t* yTop, uint8_t* yBottom, uint8_t* uv, uint32_t width);
+
+    template <class C>
+    void BGRAToNV12Row_Scalar(const uint8_t* top, const uint8_t* bottom, uint8_t* yTop, uint8_t* yBottom, uint8_t* uv, uint32_t width)
+    {
+        for (uint32_t x = 0; x < width; x += 2)
+        {
+            yTop[x]    = Luma<C>(top + x * 4);
+            yBottom[x] = Luma<C>(bottom + x * 4);
+            if (x + 1 < width)
+            {
+                yTop[x + 1]    = Luma<C>(top + x * 4 + 4);
+                yBottom[x + 1] = Luma<C>(bottom + x * 4 + 4);
+            }
+            Chroma<C>(bottom + x * 4, uv + x);
+        }
+    }
+
+    // One row of packed 4:2:2.  Each pixel pair becomes Y0 Cb Y1 Cr with the
+    // chroma taken from the left pixel (co-sited); an odd last pixel is
+    // repeated to complete its pair.
+    using YUY2RowFn = void (*)(const uint8_t* src, uint8_t* dst, uint32_t width);
+
+    template <class C>
+    void BGRAToYUY2Row_Scalar(const uint8_t* src, uint8_t* dst, uint32_t width)
+    {
+        for (uint32_t x = 0; x < width; x += 2)
+        {
+            const uint8_t* left = src + x * 4;
+            const uint8_t* right = (x + 1 < width) ? left + 4 : left;
+            uint8_t* out = dst + x * 2;
+            out[0] = Luma<C>(left);
+            out[1] = ClampByte(CbValue<C>(left));
+            out[2] = Luma<C>(right);
+            out[3] = ClampByte(CrValue<C>(left));
+        }
+    }
+
+    // P010: same layout and chroma siting as NV12, with 16-bit samples.
+    using P010RowFn = void (*)(const uint8_t* top, const uint8_t* bottom, uint16_t* yTop, uint16_t* yBottom, uint16_t* uv, uint32_t width);
+
+    template <class C>
+    void BGRAToP010Row_Scalar(const uint8_t* top, const uint8_t* bottom, uint16_t* yTop, uint16_t* yBottom, uint16_t* uv, uint32_t width)
+    {
+        for (uint32_t x = 0; x < width; x += 2)
+        {
+            yTop[x]    = ClampP010(LumaValue<C>(top + x * 4));
+            yBottom[x] = ClampP010(LumaValue<C>(bottom + x * 4));
+            if (x + 1 < width)
+            {
+                yTop[x + 1]    = ClampP010(LumaValue<C>(top + x * 4 + 4));
+                yBottom[x + 1] = ClampP010(LumaValue<C>(bottom + x * 4 + 4));
+            }
+            uv[x]     = ClampP010(CbValue<C>(bottom + x * 4));
+            uv[x + 1] = ClampP010(CrValue<C>(bottom + x * 4));
+        }
+    }
+
+    // I420 reuses the NV12 row kernels and then splits the interleaved chroma
+    // row into the separate Cb and Cr planes.
+    using SplitUVFn = void (*)(const uint8_t* uv, uint8_t* u, uint8_t* v, uint32_t pairs);
+
+    void SplitUV_Scalar(const uint8_t* uv, uint8_t* u, uint8_t* v, uint32_t pairs)
+    {
+        for (uint32_t i = 0; i < pairs; ++i)
+        {
+            u[i] = uv[i * 2];
+            v[i] = uv[i * 2 + 1];
+        }
+    }
+
+#if VCAM_SIMD_X86
+    // -----------------------------------------------------------------------
+    // SSE4.1  (16 pixels per row per iteration)
+    // -----------------------------------------------------------------------
+
+    template <class C>
+    VCAM_TARGET_SSE41 inline __m128i LumaSums_SSE41(__m128i px)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i kY = _mm_setr_epi16(C::YB, C::YG, C::YR, 0, C::YB, C::YG, C::YR, 0);
+        const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), kY);
+        const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), kY);
+        const __m128i sum = _mm_hadd_epi32(lo, hi);                       // Y0..Y3
+        return _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(128)), 8), _mm_set1_epi32(C::YOffset));
+    }
+
+    template <class C>
+    VCAM_TARGET_SSE41 inline __m128i ChromaSums_SSE41(__m128i px)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i kUV = _mm_setr_epi16(C::UB, C::UG, C::UR, 0, C::VB, C::VG, C::VR, 0);
+        const __m128i lo = _mm_unpacklo_epi8(px, zero);                  // px0 | px1
+        const __m128i hi = _mm_unpackhi_epi8(px, zero);                  // px2 | px3
+        const __m128i a = _mm_madd_epi16(_mm_unpacklo_epi64(lo, lo), kUV);
+        const __m128i b = _mm_madd_epi16(_mm_unpacklo_epi64(hi, hi), kUV);
+        const __m128i sum = _mm_hadd_epi32(a, b);                         // U0 V0 U2 V2
+        return _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(128)), 8), _mm_set1_epi32(C::UVOffset));
+    }
+
+    template <class C>
+    VCAM_TARGET_SSE41 inline void LumaRow16_SSE41(const uint8_t* src, uint8_t* dst)
+    {
+        const __m128i s0 = LumaSums_SSE41<C>(_mm_loadu_si128((const __m128i*)(src)));
+        const __m128i s1 = LumaSums_SSE41<C>(_mm_loadu_si128((const __m128i*)(src + 16)));
+        const __m128i s2 = LumaSums_SSE41<C>(_mm_loadu_si128((const __m128i*)(src + 32)));
+        const __m128i s3 = LumaSums_SSE41<C>(_mm_loadu_si128((const __m128i*)(src + 48)));
+        _mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(_mm_packs_epi32(s0, s1), _mm_packs_epi32(s2, s3)));
+    }
+
+    template <class C>
+    VCAM_TARGET_SSE41 void BGRAToNV12Row_SSE41(const uint8_t* top, const uint8_t* bottom, uint8_t* yTop, uint8_t* yBottom, uint8_t* uv, uint32_t width)
+    {
+        uint32_t x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            const uint8_t* t = top + x * 4;
+            const uint8_t* b = bottom + x * 4;
+            LumaRow16_SSE41<C>(t, yTop + x);
+            LumaRow16_SSE41<C>(b, yBottom + x);
+
+            const __m128i c0 = ChromaSums_SSE41<C>(_mm_loadu_si128((const __m128i*)(b)));
+            const __m128i c1 = ChromaSums_SSE41<C>(_mm_loadu_si128((const __m128i*)(b + 16)));
+            const __m128i c2 = ChromaSums_SSE41<C>(_mm_loadu_si128((const __m128i*)(b + 32)));
+            const __m128i c3 = ChromaSums_SSE41<C>(_mm_loadu_si128((const __m128i*)(b + 48)));
+            _mm_storeu_si128((__m128i*)(uv + x), _mm_packus_epi16(_mm_packs_epi32(c0, c1), _mm_packs_epi32(c2, c3)));
+        }
+        if (x < width)
+            BGRAToNV12Row_Scalar<C>(top + x * 4, bottom + x * 4, yTop + x, yBottom + x, uv + x, width - x);
+    }
+
+    // Four pixels -> Y0 Cb0 Y1 Cr0 Y2 Cb2 Y3 Cr2 as eight int16.
+    template <class C>
+    VCAM_TARGET_SSE41 inline __m128i YUY2Words4_SSE41(__m128i px)
+    {
+        const __m128i y = LumaSums_SSE41<C>(px);                         // Y0 Y1 Y2 Y3
+        const __m128i c = ChromaSums_SSE41<C>(px);                       // U0 V0 U2 V2
+        return _mm_packs_epi32(_mm_unpacklo_epi32(y, c), _mm_unpackhi_epi32(y, c));
+    }
+
+    template <class C>
+    VCAM_TARGET_SSE41 void BGRAToYUY2Row_SSE41(const uint8_t* src, uint8_t* dst, uint32_t width)
+    {
+        uint32_t x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            const uint8_t* s = src + x * 4;
+            const __m128i w0 = YUY2Words4_SSE41<C>(_mm_loadu_si128((const __m128i*)(s)));
+            const __m128i w1 = YUY2Words4_SSE41<C>(_mm_loadu_si128((const __m128i*)(s + 16)));
+            _mm_storeu_si128((__m128i*)(dst + x * 2), _mm_packus_epi16(w0, w1));
+        }
+        if (x < width)
+            BGRAToYUY2Row_Scalar<C>(src + x * 4, dst + x * 2, width - x);
+    }
+
+    // Two 4 x int32 vectors (in order) -> eight P010 samples.
+    VCAM_TARGET_SSE41 inline __m128i PackP010_SSE41(__m128i a, __m128i b)
+    {
+        return _mm_slli_epi16(_mm_min_epu16(_mm_packus_epi32(a, b), _mm_set1_epi16(1023)), 6);
+    }
+
+    template <class C>
+    VCAM_TARGET_SSE41 void BGRAToP010Row_SSE41(const uint8_t* top, const uint8_t* bottom, uint16_t* yTop, uint16_t* yBottom, uint16_t* uv, uint32_t width)
+    {
+        uint32_t x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            const uint8_t* t = top + x * 4;
+            const uint8_t* b = bottom + x * 4;
+            const __m128i b0 = _mm_loadu_si128((const __m128i*)(b));
+            const __m128i b1 = _mm_loadu_si128((const __m128i*)(b + 16));
+            _mm_storeu_si128((__m128i*)(yTop + x), PackP010_SSE41(
+                LumaSums_SSE41<C>(_mm_loadu_si128((const __m128i*)(t))),
+                LumaSums_SSE41<C>(_mm_loadu_si128((const __m128i*)(t + 16)))));
+            _mm_storeu_si128((__m128i*)(yBottom + x), PackP010_SSE41(LumaSums_SSE41<C>(b0), LumaSums_SSE41<C>(b1)));
+            _mm_storeu_si128((__m128i*)(uv + x), PackP010_SSE41(ChromaSums_SSE41<C>(b0), ChromaSums_SSE41<C>(b1)));
+        }
+        if (x < width)
+            BGRAToP010Row_Scalar<C>(top + x * 4, bottom + x * 4, yTop + x, yBottom + x, uv + x, width - x);
+    }
+
+    VCAM_TARGET_SSE41 void SplitUV_SSE41(const uint8_t* uv, uint8_t* u, uint8_t* v, uint32_t pairs)
+    {
+        const __m128i split = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+        uint32_t i = 0;
+        for (; i + 8 <= pairs; i += 8)
+        {
+            const __m128i r = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(uv + i * 2)), split);
+            _mm_storel_epi64((__m128i*)(u + i), r);
+            _mm_storel_epi64((__m128i*)(v + i), _mm_unpackhi_epi64(r, r));
+        }
+        if (i < pairs)
+            SplitUV_Scalar(uv + i * 2, u + i, v + i, pairs - i);
+    }
+
+    // -----------------------------------------------------------------------
+    // AVX2  (32 pixels per row per iteration)
+    // -----------------------------------------------------------------------
+
+    template <class C>
+    VCAM_TARGET_AVX2 inline __m256i LumaSums_AVX2(__m256i px)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i kY = _mm256_broadcastsi128_si256(_mm_setr_epi16(C::YB, C::YG, C::YR, 0, C::YB, C::YG, C::YR, 0));
+        const __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi8(px, zero), kY);
+        const __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi8(px, zero), kY);
+        const __m256i sum = _mm256_hadd_epi32(lo, hi);
+        return _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(128)), 8), _mm256_set1_epi32(C::YOffset));
+    }
+
+    template <class C>
+    VCAM_TARGET_AVX2 inline __m256i ChromaSums_AVX2(__m256i px)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i kUV = _mm256_broadcastsi128_si256(_mm_setr_epi16(C::UB, C::UG, C::UR, 0, C::VB, C::VG, C::VR, 0));
+        const __m256i lo = _mm256_unpacklo_epi8(px, zero);
+        const __m256i hi = _mm256_unpackhi_epi8(px, zero);
+        const __m256i a = _mm256_madd_epi16(_mm256_unpacklo_epi64(lo, lo), kUV);
+        const __m256i b = _mm256_madd_epi16(_mm256_unpacklo_epi64(hi, hi), kUV);
+        const __m256i sum = _mm256_hadd_epi32(a, b);
+        return _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(128)), 8), _mm256_set1_epi32(C::UVOffset));
+    }
+
+    // Packs four 8 x int32 vectors (in pixel order) to 32 bytes in pixel order.
+    VCAM_TARGET_AVX2 inline __m256i PackBytes_AVX2(__m256i s0, __m256i s1, __m256i s2, __m256i s3)
+    {
+        const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(s0, s1), _mm256_packs_epi32(s2, s3));
+        return _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+    }
+
+    template <class C>
+    VCAM_TARGET_AVX2 void BGRAToNV12Row_AVX2(const uint8_t* top, const uint8_t* bottom, uint8_t* yTop, uint8_t* yBottom, uint8_t* uv, uint32_t width)
+    {
+        uint32_t x = 0;
+        for (; x + 32 <= width; x += 32)
+        {
+            const uint8_t* t = top + x * 4;
+            const uint8_t* b = bottom + x * 4;
+            const __m256i b0 = _mm256_loadu_si256((const __m256i*)(b));
+            const __m256i b1 = _mm256_loadu_si256((const __m256i*)(b + 32));
+            const __m256i b2 = _mm256_loadu_si256((const __m256i*)(b + 64));
+            const __m256i b3 = _mm256_loadu_si256((const __m256i*)(b + 96));
+
+            _mm256_storeu_si256((__m256i*)(yTop + x), PackBytes_AVX2(
+                LumaSums_AVX2<C>(_mm256_loadu_si256((const __m256i*)(t))),
+                LumaSums_AVX2<C>(_mm256_loadu_si256((const __m256i*)(t + 32))),
+                LumaSums_AVX2<C>(_mm256_loadu_si256((const __m256i*)(t + 64))),
+                LumaSums_AVX2<C>(_mm256_loadu_si256((const __m256i*)(t + 96)))));
+            _mm256_storeu_si256((__m256i*)(yBottom + x), PackBytes_AVX2(
+                LumaSums_AVX2<C>(b0), LumaSums_AVX2<C>(b1), LumaSums_AVX2<C>(b2), LumaSums_AVX2<C>(b3)));
+            _mm256_storeu_si256((__m256i*)(uv + x), PackBytes_AVX2(
+                ChromaSums_AVX2<C>(b0), ChromaSums_AVX2<C>(b1), ChromaSums_AVX2<C>(b2), ChromaSums_AVX2<C>(b3)));
+        }
+        if (x < width)
+            BGRAToNV12Row_SSE41<C>(top + x * 4, bottom + x * 4, yTop + x, yBottom + x, uv + x, width - x);
+    }
+
+    // Eight pixels -> sixteen YUY2 int16 in pixel order (each 128-bit lane
+    // holds its own four pixels, so no cross-lane fix-up is needed yet).
+    template <class C>
+    VCAM_TARGET_AVX2 inline __m256i YUY2Words8_AVX2(__m256i px)
+    {
+        const __m256i y = LumaSums_AVX2<C>(px);
+        const __m256i c = ChromaSums_AVX2<C>(px);
+        return _mm256_packs_epi32(_mm256_unpacklo_epi32(y, c), _mm256_unpackhi_epi32(y, c));
+    }
+
+    template <class C>
+    VCAM_TARGET_AVX2 void BGRAToYUY2Row_AVX2(const uint8_t* src, uint8_t* dst, uint32_t width)
+    {
+        uint32_t x = 0;
+        for (; x + 32 <= width; x += 32)
+        {
+            const uint8_t* s = src + x * 4;
+            const __m256i w0 = YUY2Words8_AVX2<C>(_mm256_loadu_si256((const __m256i*)(s)));
+            const __m256i w1 = YUY2Words8_AVX2<C>(_mm256_loadu_si256((const __m256i*)(s + 32)));
+            const __m256i w2 = YUY2Words8_AVX2<C>(_mm256_loadu_si256((const __m256i*)(s + 64)));
+            const __m256i w3 = YUY2Words8_AVX2<C>(_mm256_loadu_si256((const __m256i*)(s + 96)));
+            _mm256_storeu_si256((__m256i*)(dst + x * 2), _mm256_permute4x64_epi64(_mm256_packus_epi16(w0, w1), _MM_SHUFFLE(3, 1, 2, 0)));
+            _mm256_storeu_si256((__m256i*)(dst + x * 2 + 32), _mm256_permute4x64_epi64(_mm256_packus_epi16(w2, w3), _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+        if (x < width)
+            BGRAToYUY2Row_SSE41<C>(src + x * 4, dst + x * 2, width - x);
+    }
+
+    VCAM_TARGET_AVX2 inline __m256i PackP010_AVX2(__m256i a, __m256i b)
+    {
+        const __m256i packed = _mm256_min_epu16(_mm256_packus_epi32(a, b), _mm256_set1_epi16(1023));
+        return _mm256_permute4x64_epi64(_mm256_slli_epi16(packed, 6), _MM_SHUFFLE(3, 1, 2, 0));
+    }
+
+    template <class C>
+    VCAM_TARGET_AVX2 void BGRAToP010Row_AVX2(const uint8_t* top, const uint8_t* bottom, uint16_t* yTop, uint16_t* yBottom, uint16_t* uv, uint32_t width)
+    {
+        uint32_t x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            const uint8_t* t = top + x * 4;
+            const uint8_t* b = bottom + x * 4;
+            const __m256i b0 = _mm256_loadu_si256((const __m256i*)(b));
+            const __m256i b1 = _mm256_loadu_si256((const __m256i*)(b + 32));
+            _mm256_storeu_si256((__m256i*)(yTop + x), PackP010_AVX2(
+                LumaSums_AVX2<C>(_mm256_loadu_si256((const __m256i*)(t))),
+                LumaSums_AVX2<C>(_mm256_loadu_si256((const __m256i*)(t + 32)))));
+            _mm256_storeu_si256((__m256i*)(yBottom + x), PackP010_AVX2(LumaSums_AVX2<C>(b0), LumaSums_AVX2<C>(b1)));
+            _mm256_storeu_si256((__m256i*)(uv + x), PackP010_AVX2(ChromaSums_AVX2<C>(b0), ChromaSums_AVX2<C>(b1)));
+        }
+        if (x < width)
+            BGRAToP010Row_SSE41<C>(top + x * 4, bottom + x * 4, yTop + x, yBottom + x, uv + x, width - x);
+    }
+
+    VCAM_TARGET_AVX2 void SplitUV_AVX2(const uint8_t* uv, uint8_t* u, uint8_t* v, uint32_t pairs)
+    {
+        const __m256i split = _mm256_broadcastsi128_si256(_mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15));
+        uint32_t i = 0;
+        for (; i + 16 <= pairs; i += 16)
+        {
+            const __m256i r = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(uv + i * 2)), split);
+            const __m256i ordered = _mm256_permute4x64_epi64(r, _MM_SHUFFLE(3, 1, 2, 0));   // U0..15 | V0..15
+            _mm_storeu_si128((__m128i*)(u + i), _mm256_castsi256_si128(ordered));
+            _mm_storeu_si128((__m128i*)(v + i), _mm256_extracti128_si256(ordered, 1));
+        }
+        if (i < pairs)
+            SplitUV_SSE41(uv + i * 2, u + i, v + i, pairs - i);
+    }
+
+    // -----------------------------------------------------------------------
+    // AVX-512 BW  (64 pixels per row per iteration)
+    // -----------------------------------------------------------------------
+
+    // Per-128-bit-lane equivalent of _mm_hadd_epi32 (AVX-512 has no phaddd).
+    VCAM_TARGET_AVX512 inline __m512i HaddEpi32_AVX512(__m512i a, __m512i b)
+    {
+        const __m512 fa = _mm512_castsi512_ps(a);
+        const __m512 fb = _mm512_castsi512_ps(b);
+        const __m512i even = _mm512_castps_si512(_mm512_shuffle_ps(fa, fb, _MM_SHUFFLE(2, 0, 2, 0)));
+        const __m512i odd  = _mm512_castps_si512(_mm512_shuffle_ps(fa, fb, _MM_SHUFFLE(3, 1, 3, 1)));
+        return _mm512_add_epi32(even, odd);
+    }
+
+    template <class C>
+    VCAM_TARGET_AVX512 inline __m512i LumaSums_AVX512(__m512i px)
+    {
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i kY = _mm512_broadcast_i32x4(_mm_setr_epi16(C::YB, C::YG, C::YR, 0, C::YB, C::YG, C::YR, 0));
+        const __m512i lo = _mm512_madd_epi16(_mm512_unpacklo_epi8(px, zero), kY);
+        const __m512i hi = _mm512_madd_epi16(_mm512_unpackhi_epi8(px, zero), kY);
+        const __m512i sum = HaddEpi32_AVX512(lo, hi);
+        return _mm512_add_epi32(_mm512_srai_epi32(_mm512_add_epi32(sum, _mm512_set1_epi32(128)), 8), _mm512_set1_epi32(C::YOffset));
+    }
+
+    template <class C>
+    VCAM_TARGET_AVX512 inline __m512i ChromaSums_AVX512(__m512i px)
+    {
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i kUV = _mm512_broadcast_i32x4(_mm_setr_epi16(C::UB, C::UG, C::UR, 0, C::VB, C::VG, C::VR, 0));
+        const __m512i lo = _mm512_unpacklo_epi8(px, zero);
+        const __m512i hi = _mm512_unpackhi_epi8(px, zero);
+        const __m512i a = _mm512_madd_epi16(_mm512_unpacklo_epi64(lo, lo), kUV);
+        const __m512i b = _mm512_madd_epi16(_mm512_unpacklo_epi64(hi, hi), kUV);
+        const __m512i sum = HaddEpi32_AVX512(a, b);
+        return _mm512_add_epi32(_mm512_srai_epi32(_mm512_add_epi32(sum, _mm512_set1_epi32(128)), 8), _mm512_set1_epi32(C::UVOffset));
+    }
+
+    VCAM_TARGET_AVX512 inline __m512i PackBytes_AVX512(__m512i s0, __m512i s1, __m512i s2, __m512i s3)
+    {
+        const __m512i packed = _mm512_packus_epi16(_mm512_packs_epi32(s0, s1), _mm512_packs_epi32(s2, s3));
+        return _mm512_permutexvar_epi32(_mm512_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15), packed);
+    }
+
+    template <class C>
+    VCAM_TARGET_AVX512 void BGRAToNV12Row_AVX512(const uint8_t* top, const uint8_t* bottom, uint8_t* yTop, uint8_t* yBottom, uint8_t* uv, uint32_t width)
+    {
+        uint32_t x = 0;
+        for (; x + 64 <= width; x += 64)
+        {
+            const uint8_t* t = top + x * 4;
+            const uint8_t* b = bottom + x * 4;
+            const __m512i b0 = _mm512_loadu_si512(b);
+            const __m512i b1 = _mm512_loadu_si512(b + 64);
+            const __m512i b2 = _mm512_loadu_si512(b + 128);
+            const __m512i b3 = _mm512_loadu_si512(b + 192);
+
+            _mm512_storeu_si512(yTop + x, PackBytes_AVX512(
+                LumaSums_AVX512<C>(_mm512_loadu_si512(t)),
+                LumaSums_AVX512<C>(_mm512_loadu_si512(t + 64)),
+                LumaSums_AVX512<C>(_mm512_loadu_si512(t + 128)),
+                LumaSums_AVX512<C>(_mm512_loadu_si512(t + 192))));
+            _mm512_storeu_si512(yBottom + x, PackBytes_AVX512(
+                LumaSums_AVX512<C>(b0), LumaSums_AVX512<C>(b1), LumaSums_AVX512<C>(b2), LumaSums_AVX512<C>(b3)));
+            _mm512_storeu_si512(uv + x, PackBytes_AVX512(
+                ChromaSums_AVX512<C>(b0), ChromaSums_AVX512<C>(b1), ChromaSums_AVX512<C>(b2), ChromaSums_AVX512<C>(b3)));
+        }
+        if (x < width)
+            BGRAToNV12Row_AVX2<C>(top + x * 4, bottom + x * 4, yTop + x, yBottom + x, uv + x, width - x);
+    }
+
+    // Restores qword order after a per-lane pack of two in-order vectors.
+    VCAM_TARGET_AVX512 inline __m512i OrderQwords_AVX512(__m512i packed)
+    {
+        return _mm512_permutexvar_epi64(_mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7), packed);
+    }
+
+    template <class C>
+    VCAM_TARGET_AVX512 inline __m512i YUY2Words16_AVX512(__m512i px)
+    {
+        const __m512i y = LumaSums_AVX512<C>(px);
+        const __m512i c = ChromaSums_AVX512<C>(px);
+        return _mm512_packs_epi32(_mm512_unpacklo_epi32(y, c), _mm512_unpackhi_epi32(y, c));
+    }
+
+    template <class C>
+    VCAM_TARGET_AVX512 void BGRAToYUY2Row_AVX512(const uint8_t* src, uint8_t* dst, uint32_t width)
+    {
+        uint32_t x = 0;
+        for (; x + 64 <= width; x += 64)
+        {
+            const uint8_t* s = src + x * 4;
+            const __m512i w0 = YUY2Words16_AVX512<C>(_mm512_loadu_si512(s));
+            const __m512i w1 = YUY2Words16_AVX512<C>(_mm512_loadu_si512(s + 64));
+            const __m512i w2 = YUY2Words16_AVX512<C>(_mm512_loadu_si512(s + 128));
+            const __m512i w3 = YUY2Words16_AVX512<C>(_mm512_loadu_si512(s + 192));
+            _mm512_storeu_si512(dst + x * 2, OrderQwords_AVX512(_mm512_packus_epi16(w0, w1)));
+            _mm512_storeu_si512(dst + x * 2 + 64, OrderQwords_AVX512(_mm512_packus_epi16(w2, w3)));
+        }
+        if (x < width)
+            BGRAToYUY2Row_AVX2<C>(src + x * 4, dst + x * 2, width - x);
+    }
+
+    VCAM_TARGET_AVX512 inline __m512i PackP010_AVX512(__m512i a, __m512i b)
+    {
+        const __m512i packed = _mm512_min_epu16(_mm512_packus_epi32(a, b), _mm512_set1_epi16(1023));
+        return OrderQwords_AVX512(_mm512_slli_epi16(packed, 6));
+    }
+
+    template <class C>
+    VCAM_TARGET_AVX512 void BGRAToP010Row_AVX512(const uint8_t* top, const uint8_t* bottom, uint16_t* yTop, uint16_t* yBottom, uint16_t* uv, uint32_t width)
+    {
+        uint32_t x = 0;
+        for (; x + 32 <= width; x += 32)
+        {
+            const uint8_t* t = top + x * 4;
+            const uint8_t* b = bottom + x * 4;
+            const __m512i b0 = _mm512_loadu_si512(b);
+            const __m512i b1 = _mm512_loadu_si512(b + 64);
+            _mm512_storeu_si512(yTop + x, PackP010_AVX512(
+                LumaSums_AVX512<C>(_mm512_loadu_si512(t)),
+                LumaSums_AVX512<C>(_mm512_loadu_si512(t + 64))));
+            _mm512_storeu_si512(yBottom + x, PackP010_AVX512(LumaSums_AVX512<C>(b0), LumaSums_AVX512<C>(b1)));
+            _mm512_storeu_si512(uv + x, PackP010_AVX512(ChromaSums_AVX512<C>(b0), ChromaSums_AVX512<C>(b1)));
+        }
+        if (x < width)
+            BGRAToP010Row_AVX2<C>(top + x * 4, bottom + x * 4, yTop + x, yBottom + x, uv + x, width - x);
+    }
+#endif
+
+    // -----------------------------------------------------------------------
+    // Dispatch: one kernel per (matrix, range, SIMD level), chosen per frame
+    // -----------------------------------------------------------------------
+
+    // Each kernel family exposes its row-function type, output depth and a
+    // per-level selector; SelectKernel maps a runtime colorimetry onto the
+    // matching specialisation through a table built at compile time.
+
+    struct NV12Kernels
+    {
+        using Fn = NV12RowFn;
+        static constexpr int Bits = 8;
+
+        template <class C>
+        static Fn Select(SimdLevel level)
+        {
+#if VCAM_SIMD_X86
+            switch (ClampSimdLevel(level))
+            {
+            case SimdLevel::AVX512: return BGRAToNV12Row_AVX512<C>;
+            case SimdLevel::AVX2:   return BGRAToNV12Row_AVX2<C>;
+            case SimdLevel::SSE41:  return BGRAToNV12Row_SSE41<C>;
+            default:                break;
+            }
+#endif
+            return BGRAToNV12Row_Scalar<C>;
+        }
+    };
+
+    struct YUY2Kernels
+    {
+        using Fn = YUY2RowFn;
+        static constexpr int Bits = 8;
+
+        template <class C>
+        static Fn Select(SimdLevel level)
+        {
+#if VCAM_SIMD_X86
+            switch (ClampSimdLevel(level))
+            {
+            case SimdLevel::AVX512: return BGRAToYUY2Row_AVX512<C>;
+            case SimdLevel::AVX2:   return BGRAToYUY2Row_AVX2<C>;
+            case SimdLevel::SSE41:  return BGRAToYUY2Row_SSE41<C>;
+            default:                break;
+            }
+#endif
+            return BGRAToYUY2Row_Scalar<C>;
+        }
+    };
+
+    struct P010Kernels
+    {
+        using Fn = P010RowFn;
+        static constexpr int Bits = 10;
+
+        template <class C>
+        static Fn Select(SimdLevel level)
+        {
+#if VCAM_SIMD_X86
+            switch (ClampSimdLevel(level))
+            {
+            case SimdLevel::AVX512: return BGRAToP010Row_AVX512<C>;
+            case SimdLevel::AVX2:   return BGRAToP010Row_AVX2<C>;
+            case SimdLevel::SSE41:  return BGRAToP010Row_SSE41<C>;
+            default:                break;
+            }
+#endif
+            return BGRAToP010Row_Scalar<C>;
+        }
+    };
+
+    template <class K>
+    typename K::Fn SelectKernel(YuvColorimetry colorimetry, SimdLevel level)
+    {
+        using M = YuvMatrix;
+        using R = YuvRange;
+        using SelectFn = typename K::Fn (*)(SimdLevel);
+        static constexpr SelectFn table[3][2] = {
+            { K::template Select<YuvCoefficients<M::BT601,  R::Limited, K::Bits>>, K::template Select<YuvCoefficients<M::BT601,  R::Full, K::Bits>> },
+            { K::template Select<YuvCoefficients<M::BT709,  R::Limited, K::Bits>>, K::template Select<YuvCoefficients<M::BT709,  R::Full, K::Bits>> },
+            { K::template Select<YuvCoefficients<M::BT2020, R::Limited, K::Bits>>, K::template Select<YuvCoefficients<M::BT2020, R::Full, K::Bits>> },
+        };
+        const unsigned m = std::min((unsigned)colorimetry.matrix, 2u);
+        const unsigned r = std::min((unsigned)colorimetry.range, 1u);
+        return table[m][r](level);
+    }
+
+    SplitUVFn SelectSplitUV(SimdLevel level)
+    {
+#if VCAM_SIMD_X86
+        switch (ClampSimdLevel(level))
+        {
+        case SimdLevel::AVX512:     // 16-byte chroma rows gain nothing from ZMM
+        case SimdLevel::AVX2:   return SplitUV_AVX2;
+        case SimdLevel::SSE41:  return SplitUV_SSE41;
+        default:                break;
+        }
+#endif
+        return SplitUV_Scalar;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public entry points
+// ---------------------------------------------------------------------------
+
+void ConvertBGRAToNV12(const uint8_t* src, ptrdiff_t srcStride,
+                       uint32_t width, uint32_t height,
+                       uint8_t* dstY, ptrdiff_t dstYStride,
+                       uint8_t* dstUV, ptrdiff_t dstUVStride,
+                       YuvColorimetry colorimetry, SimdLevel level)
+{
+    if (!src || !dstY || !dstUV || !width || !height)
+        return;
+
+    const NV12RowFn convertRows = SelectKernel<NV12Kernels>(colorimetry, level);
+    for (uint32_t y = 0; y < height; y += 2)
+    {
+        // The last row of an odd-height image pairs with itself.
+        const ptrdiff_t next = (y + 1 < height) ? 1 : 0;
+        const uint8_t* top = src + (ptrdiff_t)y * srcStride;
+        uint8_t* yTop = dstY + (ptrdiff_t)y * dstYStride;
+        convertRows(top, top + next * srcStride, yTop, yTop + next * dstYStride, dstUV + (ptrdiff_t)(y / 2) * dstUVStride, width);
+    }
+}
+
+void ConvertBGRAToNV12Parallel(const uint8_t* src, ptrdiff_t srcStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dstY, ptrdiff_t dstYStride,
+                               uint8_t* dstUV, ptrdiff_t dstUVStride,
+                               YuvColorimetry colorimetry, WorkerPool& pool, SimdLevel level)
+{
+    if (!src || !dstY || !dstUV || !width || !height)
+        return;
+
+    pool.ParallelBands(height, 2, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd)
+    {
+        ConvertBGRAToNV12(src + (ptrdiff_t)rowBegin * srcStride, srcStride,
+                          width, rowEnd - rowBegin,
+                          dstY + (ptrdiff_t)rowBegin * dstYStride, dstYStride,
+                          dstUV + (ptrdiff_t)(rowBegin / 2) * dstUVStride, dstUVStride,
+                          colorimetry, level);
+    });
+}
+
+void ConvertBGRAToYUY2(const uint8_t* src, ptrdiff_t srcStride,
+                       uint32_t width, uint32_t height,
+                       uint8_t* dst, ptrdiff_t dstStride,
+                       YuvColorimetry colorimetry, SimdLevel level)
+{
+    if (!src || !dst || !width || !height)
+        return;
+
+    const YUY2RowFn convertRow = SelectKernel<YUY2Kernels>(colorimetry, level);
+    for (uint32_t y = 0; y < height; ++y)
+        convertRow(src + (ptrdiff_t)y * srcStride, dst + (ptrdiff_t)y * dstStride, width);
+}
+
+void ConvertBGRAToYUY2Parallel(const uint8_t* src, ptrdiff_t srcStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dst, ptrdiff_t dstStride,
+                               YuvColorimetry colorimetry, WorkerPool& pool, SimdLevel level)
+{
+    if (!src || !dst || !width || !height)
+        return;
+
+    pool.ParallelBands(height, 1, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd)
+    {
+        ConvertBGRAToYUY2(src + (ptrdiff_t)rowBegin * srcStride, srcStride,
+                          width, rowEnd - rowBegin,
+                          dst + (ptrdiff_t)rowBegin * dstStride, dstStride,
+                          colorimetry, level);
+    });
+}
+
+void ConvertBGRAToI420(const uint8_t* src, ptrdiff_t srcStride,
+                       uint32_t width, uint32_t height,
+                       uint8_t* dstY, ptrdiff_t dstYStride,
+                       uint8_t* dstU, ptrdiff_t dstUStride,
+                       uint8_t* dstV, ptrdiff_t dstVStride,
+                       YuvColorimetry colorimetry, SimdLevel level)
+{
+    if (!src || !dstY || !dstU || !dstV || !width || !height)
+        return;
+
+    const NV12RowFn convertRows = SelectKernel<NV12Kernels>(colorimetry, level);
+    const SplitUVFn splitUV = SelectSplitUV(level);
+    const uint32_t pairs = (width + 1) / 2;
+    std::vector<uint8_t> uvRow((size_t)pairs * 2);   // one interleaved chroma row, reused
+
+    for (uint32_t y = 0; y < height; y += 2)
+    {
+        const ptrdiff_t next = (y + 1 < height) ? 1 : 0;
+        const uint8_t* top = src + (ptrdiff_t)y * srcStride;
+        uint8_t* yTop = dstY + (ptrdiff_t)y * dstYStride;
+        convertRows(top, top + next * srcStride, yTop, yTop + next * dstYStride, uvRow.data(), width);
+        splitUV(uvRow.data(), dstU + (ptrdiff_t)(y / 2) * dstUStride, dstV + (ptrdiff_t)(y / 2) * dstVStride, pairs);
+    }
+}
+
+void ConvertBGRAToI420Parallel(const uint8_t* src, ptrdiff_t srcStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dstY, ptrdiff_t dstYStride,
+                               uint8_t* dstU, ptrdiff_t dstUStride,
+                               uint8_t* dstV, ptrdiff_t dstVStride,
+                               YuvColorimetry colorimetry, WorkerPool& pool, SimdLevel level)
+{
+    if (!src || !dstY || !dstU || !dstV || !width || !height)
+        return;
+
+    pool.ParallelBands(height, 2, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd)
+    {
+        ConvertBGRAToI420(src + (ptrdiff_t)rowBegin * srcStride, srcStride,
+                          width, rowEnd - rowBegin,
+                          dstY + (ptrdiff_t)rowBegin * dstYStride, dstYStride,
+                          dstU + (ptrdiff_t)(rowBegin / 2) * dstUStride, dstUStride,
+                          dstV + (ptrdiff_t)(rowBegin / 2) * dstVStride, dstVStride,
+                          colorimetry, level);
+    });
+}
+
+void ConvertBGRAToP010(const uint8_t* src, ptrdiff_t srcStride,
+                       uint32_t width, uint32_t height,
+                       uint16_t* dstY, ptrdiff_t dstYStride,
+                       uint16_t* dstUV, ptrdiff_t dstUVStride,
+                       YuvColorimetry colorimetry, SimdLevel level)
+{
+    if (!src || !dstY || !dstUV || !width || !height)
+        return;
+
+    // Strides are in bytes, so step through the 16-bit planes as bytes.
+    const P010RowFn convertRows = SelectKernel<P010Kernels>(colorimetry, level);
+    uint8_t* yBase = reinterpret_cast<uint8_t*>(dstY);
+    uint8_t* uvBase = reinterpret_cast<uint8_t*>(dstUV);
+    for (uint32_t y = 0; y < height; y += 2)
+    {
+        const ptrdiff_t next = (y + 1 < height) ? 1 : 0;
+        const uint8_t* top = src + (ptrdiff_t)y * srcStride;
+        uint8_t* yTop = yBase + (ptrdiff_t)y * dstYStride;
+        convertRows(top, top + next * srcStride,
+                    reinterpret_cast<uint16_t*>(yTop), reinterpret_cast<uint16_t*>(yTop + next * dstYStride),
+                    reinterpret_cast<uint16_t*>(uvBase + (ptrdiff_t)(y / 2) * dstUVStride), width);
+    }
+}
+
+void ConvertBGRAToP010Parallel(const uint8_t* src, ptrdiff_t srcStride,
+                               uint32_t width, uint32_t height,
+                               uint16_t* dstY, ptrdiff_t dstYStride,
+                               uint16_t* dstUV, ptrdiff_t dstUVStride,
+                               YuvColorimetry colorimetry, WorkerPool& pool, SimdLevel level)
+{
+    if (!src || !dstY || !dstUV || !width || !height)
+        return;
+
+    uint8_t* yBase = reinterpret_cast<uint8_t*>(dstY);
+    uint8_t* uvBase = reinterpret_cast<uint8_t*>(dstUV);
+    pool.ParallelBands(height, 2, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd)
+    {
+        ConvertBGRAToP010(src + (ptrdiff_t)rowBegin * srcStride, srcStride,
+                          width, rowEnd - rowBegin,
+                          reinterpret_cast<uint16_t*>(yBase + (ptrdiff_t)rowBegin * dstYStride), dstYStride,
+                          reinterpret_cast<uint16_t*>(uvBase + (ptrdiff_t)(rowBegin / 2) * dstUVStride), dstUVStride,
+                          colorimetry, level);
+    });
+}
+
+}
@@ -0,0 +1,104 @@
+// =============================================================================
+// ColorConvert.h  --  CPU colour-space conversion kernels
+// =============================================================================
+// Software pixel-format conversion used whenever a frame has to be produced on
+// the CPU (e.g. NV12 without the VideoProcessorMFT).  Each kernel has a scalar
+// reference plus SSE4.1 / AVX2 / AVX-512 variants selected through Simd.h;
+// every variant produces bit-identical output.
+//
+// Conventions shared by all kernels:
+//   - BGRA means 32-bit pixels in memory order B, G, R, A (MFVideoFormat_RGB32,
+//     DXGI_FORMAT_B8G8R8A8_UNORM).
+//   - Strides are in bytes and may be larger than the row width or negative
+//     (bottom-up images).
+//   - Any width/height is accepted.  Odd sizes replicate the last column/row
+//     into the final chroma sample.
+//   - *Parallel variants split the frame into horizontal bands (even-aligned
+//     for 4:2:0 chroma) on a WorkerPool and return after a single join; their
+//     output is identical to the single-threaded kernel.
+//
+// This header (and ColorConvert.cpp) deliberately has no Windows dependency.
+// =============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Simd.h"
+#include "Colorimetry.h"
+#include "WorkerPool.h"
+
+namespace VirtuaCam {
+
+// BGRA -> NV12 using the given matrix and range (default: BT.601, limited).
+// NV12 = full-resolution Y plane followed by a half-resolution interleaved
+// Cb/Cr plane; each chroma pair covers a 2x2 block of pixels and is taken from
+// the bottom-left pixel of that block.  The UV plane has ceil(height/2) rows of
+// ceil(width/2) pairs.
+void ConvertBGRAToNV12(const uint8_t* src, ptrdiff_t srcStride,
+                       uint32_t width, uint32_t height,
+                       uint8_t* dstY, ptrdiff_t dstYStride,
+                       uint8_t* dstUV, ptrdiff_t dstUVStride,
+                       YuvColorimetry colorimetry = {},
+                       SimdLevel level = GetSimdLevel());
+
+void ConvertBGRAToNV12Parallel(const uint8_t* src, ptrdiff_t srcStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dstY, ptrdiff_t dstYStride,
+                               uint8_t* dstUV, ptrdiff_t dstUVStride,
+                               YuvColorimetry colorimetry = {},
+                               WorkerPool& pool = WorkerPool::Shared(),
+                               SimdLevel level = GetSimdLevel());
+
+// BGRA -> YUY2 (packed 4:2:2, bytes Y0 Cb Y1 Cr per pixel pair).  Chroma is
+// taken from the left pixel of each pair; rows hold ceil(width/2) pairs.
+void ConvertBGRAToYUY2(const uint8_t* src, ptrdiff_t srcStride,
+                       uint32_t width, uint32_t height,
+                       uint8_t* dst, ptrdiff_t dstStride,
+                       YuvColorimetry colorimetry = {},
+                       SimdLevel level = GetSimdLevel());
+
+void ConvertBGRAToYUY2Parallel(const uint8_t* src, ptrdiff_t srcStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dst, ptrdiff_t dstStride,
+                               YuvColorimetry colorimetry = {},
+                               WorkerPool& pool = WorkerPool::Shared(),
+                               SimdLevel level = GetSimdLevel());
+
+// BGRA -> I420 (planar 4:2:0: Y, Cb, Cr planes).  Same chroma siting and plane
+// sizes as NV12, with the chroma split into ceil(width/2)-byte Cb and Cr rows.
+void ConvertBGRAToI420(const uint8_t* src, ptrdiff_t srcStride,
+                       uint32_t width, uint32_t height,
+                       uint8_t* dstY, ptrdiff_t dstYStride,
+                       uint8_t* dstU, ptrdiff_t dstUStride,
+                       uint8_t* dstV, ptrdiff_t dstVStride,
+                       YuvColorimetry colorimetry = {},
+                       SimdLevel level = GetSimdLevel());
+
+void ConvertBGRAToI420Parallel(const uint8_t* src, ptrdiff_t srcStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dstY, ptrdiff_t dstYStride,
+                               uint8_t* dstU, ptrdiff_t dstUStride,
+                               uint8_t* dstV, ptrdiff_t dstVStride,
+                               YuvColorimetry colorimetry = {},
+                               WorkerPool& pool = WorkerPool::Shared(),
+                               SimdLevel level = GetSimdLevel());
+
+// BGRA -> P010 (NV12 layout with 16-bit little-endian samples; the 10-bit
+// value sits in the top bits, i.e. sample = value << 6).  Strides in bytes.
+void ConvertBGRAToP010(const uint8_t* src, ptrdiff_t srcStride,
+                       uint32_t width, uint32_t height,
+                       uint16_t* dstY, ptrdiff_t dstYStride,
+                       uint16_t* dstUV, ptrdiff_t dstUVStride,
+                       YuvColorimetry colorimetry = {},
+                       SimdLevel level = GetSimdLevel());
+
+void ConvertBGRAToP010Parallel(const uint8_t* src, ptrdiff_t srcStride,
+                               uint32_t width, uint32_t height,
+                               uint16_t* dstY, ptrdiff_t dstYStride,
+                               uint16_t* dstUV, ptrdiff_t dstUVStride,
+                               YuvColorimetry colorimetry = {},
+                               WorkerPool& pool = WorkerPool::Shared(),
+                               SimdLevel level = GetSimdLevel());
+
+}
@@ -0,0 +1,154 @@
+// =============================================================================
+// Colorimetry.h  --  YUV matrix / range selection and fixed-point coefficients
+// =============================================================================
+// Every RGB -> YUV kernel in ColorConvert.cpp is a template on YuvCoefficients
+// below, so each (matrix, range) pair is a separately compiled kernel with its
+// constants folded in; choosing one is a table lookup per frame, never a branch
+// per pixel.
+//
+// Coefficients are fixed point (x256) on 8-bit RGB input, derived at compile
+// time from the luma weights Kr/Kb of each standard:
+//
+//   Y  = Kr*R + (1-Kr-Kb)*G + Kb*B             scaled to 219 (limited) or 255
+//   Cb = (B - Y) / (2*(1-Kb))                  scaled to 224 (limited) or 255
+//   Cr = (R - Y) / (2*(1-Kr))
+//
+// 'Bits' is the output sample depth: for 10-bit (P010) the scales become
+// 876/896 (limited) or 1023 and the offsets 64/512, so the same kernels
+// produce 10-bit samples directly from 8-bit input.
+//
+// The green term is derived last so that the weights always sum exactly to the
+// scale (luma) or to zero (chroma): grey stays grey with no rounding drift.
+// For BT.601 limited range this reproduces the classic 66/129/25,
+// -38/-74/112, 112/-94/-18 table bit for bit.
+//
+// References: ITU-R BT.601-7, BT.709-6, BT.2020-2.
+// This header deliberately has no Windows dependency.
+// =============================================================================
+
+#pragma once
+
+#include <cstdint>
+
+namespace VirtuaCam {
+
+enum class YuvMatrix : int {
+    BT601  = 0,
+    BT709  = 1,
+    BT2020 = 2,
+};
+
+enum class YuvRange : int {
+    Limited = 0,    // Y [16,235], Cb/Cr [16,240]  ("studio" / "TV")
+    Full    = 1,    // Y, Cb, Cr [0,255]           ("PC" / JPEG)
+};
+
+struct YuvColorimetry {
+    YuvMatrix matrix = YuvMatrix::BT601;
+    YuvRange  range  = YuvRange::Limited;
+};
+
+// What the virtual camera advertises for a given frame size: BT.709 for HD
+// (720 lines and up) and BT.601 for SD, limited range, which is also what
+// consumers assume for untagged video.
+constexpr YuvColorimetry DefaultColorimetry(uint32_t width, uint32_t height)
+{
+    (void)width;
+    return { height >= 720 ? YuvMatrix::BT709 : YuvMatrix::BT601, YuvRange::Limited };
+}
+
+namespace Detail
+{
+    constexpr int RoundToInt(double v)
+    {
+        return v >= 0 ? (int)(v + 0.5) : -(int)(-v + 0.5);
+    }
+
+    constexpr double LumaKr(YuvMatrix m)
+    {
+        return m == YuvMatrix::BT709 ? 0.2126 : m == YuvMatrix::BT2020 ? 0.2627 : 0.299;
+    }
+
+    constexpr double LumaKb(YuvMatrix m)
+    {
+        return m == YuvMatrix::BT709 ? 0.0722 : m == YuvMatrix::BT2020 ? 0.0593 : 0.114;
+    }
+}
+
+template <YuvMatrix M, YuvRange R, int Bits = 8>
+struct YuvCoefficients
+{
+    static_assert(Bits >= 8 && Bits <= 10, "only 8- and 10-bit outputs are supported");
+
+    static constexpr YuvMatrix Matrix = M;
+    static constexpr YuvRange  Range  = R;
+    static constexpr int       Depth  = Bits;
+    static constexpr int       MaxValue = (1 << Bits) - 1;
+
+    static constexpr double Kr = Detail::LumaKr(M);
+    static constexpr double Kb = Detail::LumaKb(M);
+    static constexpr double LumaScale   = (R == YuvRange::Limited ? double(219 << (Bits - 8)) : double(MaxValue)) / 255.0 * 256.0;
+    static constexpr double ChromaScale = (R == YuvRange::Limited ? double(224 << (Bits - 8)) : double(MaxValue)) / 255.0 * 256.0;
+
+    static constexpr int YR = Detail::RoundToInt(Kr * LumaScale);
+    static constexpr int YB = Detail::RoundToInt(Kb * LumaScale);
+    static constexpr int YG = Detail::RoundToInt(LumaScale) - YR - YB;
+
+    static constexpr int UB = Detail::RoundToInt(0.5 * ChromaScale);
+    static constexpr int UR = Detail::RoundToInt(-0.5 * Kr / (1.0 - Kb) * ChromaScale);
+    static constexpr int UG = -UB - UR;
+
+    static constexpr int VR = Detail::RoundToInt(0.5 * ChromaScale);
+    static constexpr int VB = Detail::RoundToInt(-0.5 * Kb / (1.0 - Kr) * ChromaScale);
+    static constexpr int VG = -VR - VB;
+
+    static constexpr int YOffset  = R == YuvRange::Limited ? 16 << (Bits - 8) : 0;
+    static constexpr int UVOffset = 128 << (Bits - 8);
+};
+
+// Inverse (YUV -> RGB) coefficients, 13-bit fixed point, for 8-bit samples:
+//
+//   y = Y - YOffset,  u = Cb - 128,  v = Cr - 128
+//   R = (YG*y          + RV*v + 4096) >> 13
+//   G = (YG*y + GU*u   + GV*v + 4096) >> 13
+//   B = (YG*y + BU*u          + 4096) >> 13
+//
+// 13 bits is the most precision that keeps every coefficient (BU reaches
+// ~2.14 for limited-range BT.2020) inside a signed 16-bit multiplier.
+template <YuvMatrix M, YuvRange R>
+struct RgbCoefficients
+{
+    static constexpr YuvMatrix Matrix = M;
+    static constexpr YuvRange  Range  = R;
+    static constexpr int       Shift  = 13;
+
+    static constexpr double Kr = Detail::LumaKr(M);
+    static constexpr double Kb = Detail::LumaKb(M);
+    static constexpr double Kg = 1.0 - Kr - Kb;
+    static constexpr double One = double(1 << Shift);
+    static constexpr double LumaGain   = (R == YuvRange::Limited ? 255.0 / 219.0 : 1.0) * One;
+    static constexpr double ChromaGain = (R == YuvRange::Limited ? 255.0 / 224.0 : 1.0) * One;
+
+    static constexpr int YG = Detail::RoundToInt(LumaGain);
+    static constexpr int RV = Detail::RoundToInt(2.0 * (1.0 - Kr) * ChromaGain);
+    static constexpr int BU = Detail::RoundToInt(2.0 * (1.0 - Kb) * ChromaGain);
+    static constexpr int GU = -Detail::RoundToInt(2.0 * (1.0 - Kb) * Kb / Kg * ChromaGain);
+    static constexpr int GV = -Detail::RoundToInt(2.0 * (1.0 - Kr) * Kr / Kg * ChromaGain);
+
+    static constexpr int YOffset  = R == YuvRange::Limited ? 16 : 0;
+    static constexpr int UVOffset = 128;
+    static constexpr int Round    = 1 << (Shift - 1);
+
+    static_assert(BU < 32768 && RV < 32768 && YG < 32768, "coefficients must fit in int16");
+};
+
+static_assert(YuvCoefficients<YuvMatrix::BT601, YuvRange::Limited>::YR == 66 &&
+              YuvCoefficients<YuvMatrix::BT601, YuvRange::Limited>::YG == 129 &&
+              YuvCoefficients<YuvMatrix::BT601, YuvRange::Limited>::YB == 25 &&
+              YuvCoefficients<YuvMatrix::BT601, YuvRange::Limited>::UR == -38 &&
+              YuvCoefficients<YuvMatrix::BT601, YuvRange::Limited>::UG == -74 &&
+              YuvCoefficients<YuvMatrix::BT601, YuvRange::Limited>::VG == -94 &&
+              YuvCoefficients<YuvMatrix::BT601, YuvRange::Limited>::VB == -18,
+              "BT.601 limited-range coefficients must match the reference table");
+
+}
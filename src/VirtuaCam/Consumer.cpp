@@ -14,6 +14,22 @@
 // Default pixel shader: passthrough (no visual change).  Replace g_pixelShader
 // with any HLSL transform to create custom video filters.
 //
+// Arguments: --lut <file.cube>   (optional colour grade, see below)
+//            --blur <sigma>      (optional Gaussian blur, sigma in pixels)
+//            --ring <slots>      (output texture ring, 2..4, or 1 for a single
+//                                 texture; default 3; TextureRing.h)
+//
+// CPU filter stage: with --lut or --blur the shader output is read back
+// through a staging texture, filtered on the worker pool and written to a
+// mapped upload texture, which is published instead.
+//
+//   --lut   3D LUT grade (Lut3D.h: .cube file, tetrahedral interpolation).
+//           On its own it maps the staging texture straight into the upload.
+//   --blur  constant-time separable blur (Blur.h).  Its vertical pass works
+//           in place, and the upload mapping is write-combined memory that
+//           must never be read, so the frame goes through g_filterFrame
+//           (graded first if --lut is also given) and is then copied up.
+//
 // Note: The consumer connects to the first stream returned by Discovery, which
 // in practice will be the broker's own output manifest (because the broker
 // advertises itself the same way as other producers).  If the broker is not
@@ -27,6 +43,11 @@
 #include <wrl.h>
 #include <sddl.h>
 #include <d3dcompiler.h>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include "Blur.h"
+#include "Lut3D.h"
 
 #pragma comment(lib, "d3dcompiler.lib")
 #pragma comment(lib, "d3d11.lib")
@@ -42,11 +63,12 @@ static std::unique_ptr<VirtuaCam::Discovery> g_discovery;
 static VirtuaCam::DiscoveredSharedStream g_inputStream;
 static bool g_inputConnected = false;
 
-static ComPtr<ID3D11Texture2D>        g_inputSharedTexture;
 static ComPtr<ID3D11Fence>            g_inputSharedFence;
 static ComPtr<ID3D11Texture2D>        g_inputPrivateTexture;
 static ComPtr<ID3D11ShaderResourceView> g_inputSRV;
+static SharedTextureSource            g_input;             // manifest + texture (ring), open while connected
 static UINT64                         g_lastSeenFrame = 0;
+static VirtuaCam::ManifestFrameInfo   g_inputFrame;        // record of the last frame copied
 
 static ComPtr<ID3D11Texture2D>        g_outputTexture;
 static ComPtr<ID3D11RenderTargetView> g_outputRTV;
@@ -54,14 +76,23 @@ static ComPtr<ID3D11VertexShader>     g_vs;
 static ComPtr<ID3D11PixelShader>      g_ps;
 static ComPtr<ID3D11SamplerState>     g_sampler;
 
-static ComPtr<ID3D11Texture2D>        g_sharedOutTexture;
+static SharedTextureRing              g_sharedOutTextures;
+static UINT                           g_ringSlots = VirtuaCam::kDefaultRingSlots;
 static ComPtr<ID3D11Fence>            g_sharedOutFence;
 static UINT64                         g_sharedOutFrameValue = 0;
 static HANDLE                         g_hManifestOut = nullptr;
-static BroadcastManifest*             g_pManifestViewOut = nullptr;
-static HANDLE                         g_sharedOutTextureHandle = nullptr;
+static VirtuaCam::BroadcastManifestV2* g_pManifestViewOut = nullptr;
 static HANDLE                         g_sharedOutFenceHandle = nullptr;
 
+// CPU filter stage (--lut / --blur), and the readback / upload pair it runs
+// between.
+static VirtuaCam::Lut3D               g_lut;
+static VirtuaCam::Blur                g_blur;
+static float                          g_blurSigma = 0.0f;
+static std::vector<uint8_t>           g_filterFrame;
+static ComPtr<ID3D11Texture2D>        g_filterStagingTexture;
+static ComPtr<ID3D11Texture2D>        g_filterUploadTexture;
+
 // Full-screen triangle vertex shader (same pattern as BrokerClient/Multiplexer).
 const char* g_vertexShader = "struct VOut{float4 p:SV_POSITION;float2 u:TEXCOORD;};VOut main(uint v:SV_VertexID){VOut o;o.u=float2((v<<1)&2,v&2);o.p=float4(o.u.x*2-1,1-o.u.y*2,0,1);return o;}";
 // Passthrough by default. Replace this shader to implement any custom video filter.
@@ -87,7 +118,6 @@ HRESULT InitOutputResources()
     
     desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
     desc.MiscFlags = D3D11_RESOURCE_MISC_SHARED_NTHANDLE | D3D11_RESOURCE_MISC_SHARED;
-    RETURN_IF_FAILED(g_device->CreateTexture2D(&desc, nullptr, &g_sharedOutTexture));
     
     ComPtr<ID3D11Device5> device5; g_device.As(&device5);
     RETURN_IF_FAILED(device5->CreateFence(0, D3D11_FENCE_FLAG_SHARED, IID_PPV_ARGS(&g_sharedOutFence)));
@@ -102,20 +132,15 @@ HRESULT InitOutputResources()
     std::wstring textureName = L"Local\\DirectPortTexture_" + std::to_wstring(pid);
     std::wstring fenceName = L"Local\\DirectPortFence_" + std::to_wstring(pid);
 
-    ComPtr<IDXGIResource1> r1; g_sharedOutTexture.As(&r1);
-    RETURN_IF_FAILED(r1->CreateSharedHandle(&sa, GENERIC_ALL, textureName.c_str(), &g_sharedOutTextureHandle));
     RETURN_IF_FAILED(g_sharedOutFence->CreateSharedHandle(&sa, GENERIC_ALL, fenceName.c_str(), &g_sharedOutFenceHandle));
     
-    g_hManifestOut = CreateFileMappingW(INVALID_HANDLE_VALUE, &sa, PAGE_READWRITE, 0, sizeof(BroadcastManifest), manifestName.c_str());
+    g_hManifestOut = CreateFileMappingW(INVALID_HANDLE_VALUE, &sa, PAGE_READWRITE, 0, sizeof(VirtuaCam::BroadcastManifestV2), manifestName.c_str());
     RETURN_HR_IF_NULL(E_FAIL, g_hManifestOut);
-    g_pManifestViewOut = (BroadcastManifest*)MapViewOfFile(g_hManifestOut, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    g_pManifestViewOut = (VirtuaCam::BroadcastManifestV2*)MapViewOfFile(g_hManifestOut, FILE_MAP_ALL_ACCESS, 0, 0, 0);
     RETURN_HR_IF_NULL(E_FAIL, g_pManifestViewOut);
     
-    ZeroMemory(g_pManifestViewOut, sizeof(BroadcastManifest));
-    g_pManifestViewOut->width = 1920; g_pManifestViewOut->height = 1080; g_pManifestViewOut->format = DXGI_FORMAT_B8G8R8A8_UNORM;
-    g_pManifestViewOut->adapterLuid = g_adapterLuid;
-    wcscpy_s(g_pManifestViewOut->textureName, textureName.c_str());
-    wcscpy_s(g_pManifestViewOut->fenceName, fenceName.c_str());
+    InitializeManifest(g_pManifestViewOut, 1920, 1080, DXGI_FORMAT_B8G8R8A8_UNORM, g_adapterLuid, textureName, fenceName, g_ringSlots);
+    RETURN_IF_FAILED(g_sharedOutTextures.Create(g_device.Get(), desc, &sa, textureName, g_ringSlots, VirtuaCam::ManifestRing(*g_pManifestViewOut)));
     
     ComPtr<ID3DBlob> vsBlob, psBlob;
     D3DCompile(g_vertexShader, strlen(g_vertexShader), nullptr, nullptr, nullptr, "main", "vs_5_0", 0, 0, &vsBlob, nullptr);
@@ -131,6 +156,71 @@ HRESULT InitOutputResources()
     return S_OK;
 }
 
+bool HasCpuFilters()
+{
+    return g_lut.IsLoaded() || g_blur.Passes() != 0;
+}
+
+HRESULT InitFilterResources()
+{
+    D3D11_TEXTURE2D_DESC desc;
+    g_outputTexture->GetDesc(&desc);
+    if (g_blurSigma > 0.0f)
+    {
+        g_blur.Configure(desc.Width, desc.Height, g_blurSigma);
+        if (g_blur.Passes())
+            g_filterFrame.resize(static_cast<size_t>(desc.Width) * desc.Height * 4);
+    }
+    if (!HasCpuFilters())
+        return S_OK;
+
+    desc.BindFlags = 0; desc.MiscFlags = 0;
+    desc.Usage = D3D11_USAGE_STAGING; desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    RETURN_IF_FAILED(g_device->CreateTexture2D(&desc, nullptr, &g_filterStagingTexture));
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.Usage = D3D11_USAGE_DYNAMIC; desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    RETURN_IF_FAILED(g_device->CreateTexture2D(&desc, nullptr, &g_filterUploadTexture));
+    return S_OK;
+}
+
+// Runs the CPU filters on the shader output into g_filterUploadTexture.
+// Returns false (and the unfiltered frame is published) if either texture
+// cannot be mapped.
+bool ApplyCpuFilters()
+{
+    g_context->CopyResource(g_filterStagingTexture.Get(), g_outputTexture.Get());
+    D3D11_MAPPED_SUBRESOURCE in = {}, out = {};
+    if (FAILED(g_context->Map(g_filterStagingTexture.Get(), 0, D3D11_MAP_READ, 0, &in))) return false;
+    auto unmapIn = wil::scope_exit([&] { g_context->Unmap(g_filterStagingTexture.Get(), 0); });
+    if (FAILED(g_context->Map(g_filterUploadTexture.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &out))) return false;
+    auto unmapOut = wil::scope_exit([&] { g_context->Unmap(g_filterUploadTexture.Get(), 0); });
+
+    D3D11_TEXTURE2D_DESC desc;
+    g_filterUploadTexture->GetDesc(&desc);
+    const auto* src = static_cast<const uint8_t*>(in.pData);
+    auto* dst = static_cast<uint8_t*>(out.pData);
+    if (!g_blur.Passes())
+    {
+        g_lut.ApplyParallel(src, in.RowPitch, dst, out.RowPitch, desc.Width, desc.Height);
+        return true;
+    }
+
+    const size_t rowBytes = static_cast<size_t>(desc.Width) * 4;
+    const ptrdiff_t frameStride = static_cast<ptrdiff_t>(rowBytes);
+    if (g_lut.IsLoaded())
+    {
+        g_lut.ApplyParallel(src, in.RowPitch, g_filterFrame.data(), frameStride, desc.Width, desc.Height);
+        g_blur.Apply(g_filterFrame.data(), frameStride, g_filterFrame.data(), frameStride);
+    }
+    else
+    {
+        g_blur.Apply(src, in.RowPitch, g_filterFrame.data(), frameStride);
+    }
+    for (UINT y = 0; y < desc.Height; ++y)
+        memcpy(dst + static_cast<size_t>(y) * out.RowPitch, g_filterFrame.data() + y * rowBytes, rowBytes);
+    return true;
+}
+
 void FindAndConnectInput()
 {
     g_discovery->DiscoverStreams();
@@ -139,15 +229,15 @@ void FindAndConnectInput()
     
     g_inputStream = streams[0];
 
-    ComPtr<ID3D11Device1> d1; g_device.As(&d1);
     ComPtr<ID3D11Device5> d5; g_device.As(&d5);
-    wil::unique_handle hTex(GetHandleFromName(g_inputStream.textureName.c_str()));
     wil::unique_handle hFence(GetHandleFromName(g_inputStream.fenceName.c_str()));
     
-    if (!hTex || FAILED(d1->OpenSharedResource1(hTex.get(), IID_PPV_ARGS(&g_inputSharedTexture)))) { g_inputConnected = false; return; }
-    if (!hFence || FAILED(d5->OpenSharedFence(hFence.get(), IID_PPV_ARGS(&g_inputSharedFence)))) { g_inputConnected = false; return; }
+    if (FAILED(g_input.Open(g_device.Get(), g_inputStream.manifestName, g_inputStream.textureName))) { g_inputConnected = false; return; }
+    if (!hFence || FAILED(d5->OpenSharedFence(hFence.get(), IID_PPV_ARGS(&g_inputSharedFence)))) { g_input.Close(); g_inputConnected = false; return; }
+    g_lastSeenFrame = 0;
+    g_inputFrame = {};
     
-    D3D11_TEXTURE2D_DESC desc; g_inputSharedTexture->GetDesc(&desc);
+    D3D11_TEXTURE2D_DESC desc; g_input.Texture()->GetDesc(&desc);
     desc.MiscFlags = 0; desc.BindFlags = D3D11_BIND_SHADER_RESOURCE; desc.Usage = D3D11_USAGE_DEFAULT;
     g_device->CreateTexture2D(&desc, nullptr, &g_inputPrivateTexture);
     g_device->CreateShaderResourceView(g_inputPrivateTexture.Get(), nullptr, &g_inputSRV);
@@ -157,8 +247,29 @@ void FindAndConnectInput()
 
 PRODUCER_API HRESULT InitializeProducer(const wchar_t* args)
 {
+    std::wistringstream iss(args ? args : L"");
+    std::wstring key;
+    while (iss >> key) {
+        if (key == L"--lut") {
+            std::wstring path;
+            iss >> std::quoted(path);
+            std::string error;
+            if (!g_lut.LoadCubeFile(path, &error))
+                RETURN_HR_MSG(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), "--lut %ls: %hs", path.c_str(), error.c_str());
+        }
+        else if (key == L"--blur") {
+            if (!(iss >> g_blurSigma) || g_blurSigma < 0.0f)
+                RETURN_HR_MSG(E_INVALIDARG, "--blur expects a non-negative sigma");
+        }
+        else if (key == L"--ring") {
+            if (!(iss >> g_ringSlots) || g_ringSlots < 1 || g_ringSlots > VirtuaCam::kMaxRingSlots)
+                RETURN_HR_MSG(E_INVALIDARG, "--ring expects 1 to %u slots", VirtuaCam::kMaxRingSlots);
+        }
+    }
+
     RETURN_IF_FAILED(InitD3D());
     RETURN_IF_FAILED(InitOutputResources());
+    RETURN_IF_FAILED(InitFilterResources());
     g_discovery = std::make_unique<VirtuaCam::Discovery>();
     g_discovery->Initialize(g_device.Get());
     return S_OK;
@@ -168,17 +279,28 @@ PRODUCER_API void ProcessFrame()
 {
     if (!g_inputConnected) { FindAndConnectInput(); return; }
 
-    wil::unique_handle hManifest(OpenFileMappingW(FILE_MAP_READ, FALSE, g_inputStream.manifestName.c_str()));
-    if(!hManifest) { g_inputConnected = false; return; }
-    BroadcastManifest* pView = (BroadcastManifest*)MapViewOfFile(hManifest.get(), FILE_MAP_READ, 0, 0, sizeof(BroadcastManifest));
-    if(!pView) { g_inputConnected = false; return; }
+    // Liveness comes from Discovery (a single atomic load while the producer
+    // set is unchanged); the held manifest view would outlive the producer.
+    g_discovery->DiscoverStreams();
+    const auto& streams = g_discovery->GetDiscoveredStreams();
+    if (std::none_of(streams.begin(), streams.end(), [](const auto& s) { return s.processId == g_inputStream.processId; })) {
+        g_input.Close();
+        g_inputConnected = false;
+        return;
+    }
 
-    UINT64 latest = pView->frameValue;
-    UnmapViewOfFile(pView);
-    if(latest > g_lastSeenFrame) {
+    g_input.ReleaseCompletedReads();
+    UINT64 latest = g_input.Manifest().FrameValue();
+    ID3D11Texture2D* source = latest > g_lastSeenFrame ? g_input.Acquire(latest) : nullptr;
+    if(source) {
         g_context4->Wait(g_inputSharedFence.Get(), latest);
-        g_context->CopyResource(g_inputPrivateTexture.Get(), g_inputSharedTexture.Get());
+        g_context->CopyResource(g_inputPrivateTexture.Get(), source);
+        g_input.EndRead();
         g_lastSeenFrame = latest;
+        // Only keep the record if it still describes the frame just copied
+        // (the producer may have published another since Acquire()).
+        VirtuaCam::ManifestFrameInfo info;
+        g_inputFrame = g_input.Manifest().ReadFrameInfo(info) && info.frameValue == latest ? info : VirtuaCam::ManifestFrameInfo{};
     }
     
     D3D11_VIEWPORT vp = {0,0,1920,1080,0,1};
@@ -191,18 +313,35 @@ PRODUCER_API void ProcessFrame()
     g_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     g_context->Draw(3, 0);
     
-    g_context->CopyResource(g_sharedOutTexture.Get(), g_outputTexture.Get());
+    const bool filtered = HasCpuFilters() && ApplyCpuFilters();
+    ID3D11Texture2D* target = g_sharedOutTextures.BeginWrite();
+    if (!target) return;    // every ring slot is being read: drop the frame
+    g_context->CopyResource(target, filtered ? g_filterUploadTexture.Get() : g_outputTexture.Get());
     g_sharedOutFrameValue++;
     g_context4->Signal(g_sharedOutFence.Get(), g_sharedOutFrameValue);
+    g_sharedOutTextures.EndWrite(g_sharedOutFrameValue);
     if (g_pManifestViewOut) {
-        InterlockedExchange64(reinterpret_cast<volatile LONGLONG*>(&g_pManifestViewOut->frameValue), g_sharedOutFrameValue);
+        // Carry the input's capture time through, so end-to-end latency is
+        // measured from the camera / capture rather than from this filter.
+        VirtuaCam::ManifestFrameInfo info = ManifestFrameNow(g_sharedOutFrameValue, 1920, 1080, DXGI_FORMAT_B8G8R8A8_UNORM);
+        if (g_inputFrame.captureTime) {
+            info.captureTime = g_inputFrame.captureTime;
+            info.duration = g_inputFrame.duration;
+        }
+        VirtuaCam::PublishFrame(*g_pManifestViewOut, info);
     }
 }
 
 PRODUCER_API void ShutdownProducer()
 {
+    g_input.Close();
+    g_sharedOutTextures.Reset();
     if (g_pManifestViewOut) UnmapViewOfFile(g_pManifestViewOut);
     if (g_hManifestOut) CloseHandle(g_hManifestOut);
-    if (g_sharedOutTextureHandle) CloseHandle(g_sharedOutTextureHandle);
     if (g_sharedOutFenceHandle) CloseHandle(g_sharedOutFenceHandle);
+    g_filterStagingTexture.Reset(); g_filterUploadTexture.Reset();
+    g_lut.Reset();
+    g_blur = {}; g_blurSigma = 0.0f;
+    g_filterFrame.clear(); g_filterFrame.shrink_to_fit();
+    VirtuaCam::WorkerPool::Shared().Shutdown();     // before the DLL can be unloaded
 }
\ No newline at end of file
@@ -0,0 +1,228 @@
+// =============================================================================
+// Denoise.cpp  --  Motion-adaptive temporal denoise for BGRA frames
+// =============================================================================
+// See Denoise.h for the public contract.
+//
+// Per pixel, identically in every kernel:
+//
+//   diff = (|dB| + 2 |dG| + |dR|) >> 2                 pmaddubsw + pmaddwd
+//   k    = max(0, maxWeight - ((min(diff, threshold) * slope + 8) >> 4))
+//   out  = (cur (256 - k) + history k + 128) >> 8      16-bit lanes; the sum
+//                                                      is at most 65408
+//
+// The SIMD kernels spread each pixel's weight over its four 16-bit channel
+// lanes with the same unpack that widens the pixels, so nothing crosses a
+// 128-bit lane.
+// =============================================================================
+
+#include "Denoise.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if VCAM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace VirtuaCam {
+
+namespace
+{
+    struct Gate {
+        int32_t maxWeight, threshold, slope;
+    };
+
+    using DenoiseRowFn = void (*)(const uint8_t* src, uint8_t* history, uint8_t* dst, uint32_t count, const Gate& gate);
+
+    // -----------------------------------------------------------------------
+    // Scalar reference
+    // -----------------------------------------------------------------------
+
+    inline int32_t HistoryWeight(int32_t diff, const Gate& gate)
+    {
+        return std::max(gate.maxWeight - ((std::min(diff, gate.threshold) * gate.slope + 8) >> 4), 0);
+    }
+
+    void DenoiseRow_Scalar(const uint8_t* src, uint8_t* history, uint8_t* dst, uint32_t count, const Gate& gate)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const uint8_t* c = src + i * 4;
+            uint8_t* h = history + i * 4;
+            const int32_t diff = (std::abs(c[0] - h[0]) + 2 * std::abs(c[1] - h[1]) + std::abs(c[2] - h[2])) >> 2;
+            const int32_t k = HistoryWeight(diff, gate);
+            uint8_t out[4];
+            for (int ch = 0; ch < 4; ++ch)
+                out[ch] = (uint8_t)((c[ch] * (256 - k) + h[ch] * k + 128) >> 8);
+            std::memcpy(h, out, 4);
+            std::memcpy(dst + i * 4, out, 4);
+        }
+    }
+
+#if VCAM_SIMD_X86
+    // -----------------------------------------------------------------------
+    // SSE4.1: 4 pixels per step
+    // -----------------------------------------------------------------------
+
+    VCAM_TARGET_SSE41 inline __m128i Denoise4_SSE41(__m128i cur, __m128i hist, const Gate& gate)
+    {
+        const __m128i ad = _mm_or_si128(_mm_subs_epu8(cur, hist), _mm_subs_epu8(hist, cur));
+        const __m128i sum = _mm_madd_epi16(_mm_maddubs_epi16(ad, _mm_set1_epi32(0x00010201)), _mm_set1_epi16(1));
+        const __m128i diff = _mm_min_epi32(_mm_srli_epi32(sum, 2), _mm_set1_epi32(gate.threshold));
+        const __m128i k = _mm_max_epi32(_mm_sub_epi32(_mm_set1_epi32(gate.maxWeight),
+            _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(diff, _mm_set1_epi32(gate.slope)), _mm_set1_epi32(8)), 4)),
+            _mm_setzero_si128());
+        const __m128i kk = _mm_or_si128(k, _mm_slli_epi32(k, 16));
+        const __m128i inv = _mm_sub_epi16(_mm_set1_epi16(256), kk);
+
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi16(128);
+        const __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(
+            _mm_mullo_epi16(_mm_unpacklo_epi8(cur, zero), _mm_unpacklo_epi32(inv, inv)),
+            _mm_mullo_epi16(_mm_unpacklo_epi8(hist, zero), _mm_unpacklo_epi32(kk, kk))), round), 8);
+        const __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(
+            _mm_mullo_epi16(_mm_unpackhi_epi8(cur, zero), _mm_unpackhi_epi32(inv, inv)),
+            _mm_mullo_epi16(_mm_unpackhi_epi8(hist, zero), _mm_unpackhi_epi32(kk, kk))), round), 8);
+        return _mm_packus_epi16(lo, hi);
+    }
+
+    VCAM_TARGET_SSE41 void DenoiseRow_SSE41(const uint8_t* src, uint8_t* history, uint8_t* dst, uint32_t count, const Gate& gate)
+    {
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128i out = Denoise4_SSE41(_mm_loadu_si128((const __m128i*)(src + i * 4)),
+                                               _mm_loadu_si128((const __m128i*)(history + i * 4)), gate);
+            _mm_storeu_si128((__m128i*)(history + i * 4), out);
+            _mm_storeu_si128((__m128i*)(dst + i * 4), out);
+        }
+        DenoiseRow_Scalar(src + i * 4, history + i * 4, dst + i * 4, count - i, gate);
+    }
+
+    // -----------------------------------------------------------------------
+    // AVX2: 8 pixels per step (Denoise4_SSE41 in each 128-bit lane)
+    // -----------------------------------------------------------------------
+
+    VCAM_TARGET_AVX2 void DenoiseRow_AVX2(const uint8_t* src, uint8_t* history, uint8_t* dst, uint32_t count, const Gate& gate)
+    {
+        const __m256i channelWeights = _mm256_set1_epi32(0x00010201);
+        const __m256i ones = _mm256_set1_epi16(1);
+        const __m256i threshold = _mm256_set1_epi32(gate.threshold);
+        const __m256i maxWeight = _mm256_set1_epi32(gate.maxWeight);
+        const __m256i slope = _mm256_set1_epi32(gate.slope);
+        const __m256i eight = _mm256_set1_epi32(8);
+        const __m256i full = _mm256_set1_epi16(256);
+        const __m256i round = _mm256_set1_epi16(128);
+        const __m256i zero = _mm256_setzero_si256();
+
+        uint32_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i cur = _mm256_loadu_si256((const __m256i*)(src + i * 4));
+            const __m256i hist = _mm256_loadu_si256((const __m256i*)(history + i * 4));
+            const __m256i ad = _mm256_or_si256(_mm256_subs_epu8(cur, hist), _mm256_subs_epu8(hist, cur));
+            const __m256i sum = _mm256_madd_epi16(_mm256_maddubs_epi16(ad, channelWeights), ones);
+            const __m256i diff = _mm256_min_epi32(_mm256_srli_epi32(sum, 2), threshold);
+            const __m256i k = _mm256_max_epi32(_mm256_sub_epi32(maxWeight,
+                _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(diff, slope), eight), 4)), zero);
+            const __m256i kk = _mm256_or_si256(k, _mm256_slli_epi32(k, 16));
+            const __m256i inv = _mm256_sub_epi16(full, kk);
+
+            const __m256i lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(
+                _mm256_mullo_epi16(_mm256_unpacklo_epi8(cur, zero), _mm256_unpacklo_epi32(inv, inv)),
+                _mm256_mullo_epi16(_mm256_unpacklo_epi8(hist, zero), _mm256_unpacklo_epi32(kk, kk))), round), 8);
+            const __m256i hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(
+                _mm256_mullo_epi16(_mm256_unpackhi_epi8(cur, zero), _mm256_unpackhi_epi32(inv, inv)),
+                _mm256_mullo_epi16(_mm256_unpackhi_epi8(hist, zero), _mm256_unpackhi_epi32(kk, kk))), round), 8);
+            const __m256i out = _mm256_packus_epi16(lo, hi);
+            _mm256_storeu_si256((__m256i*)(history + i * 4), out);
+            _mm256_storeu_si256((__m256i*)(dst + i * 4), out);
+        }
+        DenoiseRow_SSE41(src + i * 4, history + i * 4, dst + i * 4, count - i, gate);
+    }
+#endif
+
+    DenoiseRowFn SelectDenoiseRow(SimdLevel level)
+    {
+#if VCAM_SIMD_X86
+        switch (ClampSimdLevel(level))
+        {
+        case SimdLevel::AVX512:
+        case SimdLevel::AVX2:   return DenoiseRow_AVX2;
+        case SimdLevel::SSE41:  return DenoiseRow_SSE41;
+        default:                break;
+        }
+#else
+        (void)level;
+#endif
+        return DenoiseRow_Scalar;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// TemporalDenoise
+// ---------------------------------------------------------------------------
+
+void TemporalDenoise::Configure(uint32_t width, uint32_t height, float strength)
+{
+    m_width = m_height = 0;
+    m_primed = false;
+    m_history.clear();
+    strength = std::clamp(strength, 0.0f, 1.0f);
+    if (!width || !height || strength <= 0.0f)
+        return;
+
+    m_maxWeight = (uint32_t)std::lround(224.0f * strength);
+    m_threshold = (uint32_t)std::lround(8.0f + 24.0f * strength);
+    m_slope = (m_maxWeight * 16 + m_threshold / 2) / m_threshold;
+    m_width = width;
+    m_height = height;
+    m_history.resize((size_t)width * height * 4);
+}
+
+void TemporalDenoise::ApplyRows(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                                uint32_t rowBegin, uint32_t rowEnd, SimdLevel level)
+{
+    const Gate gate = { (int32_t)m_maxWeight, (int32_t)m_threshold, (int32_t)m_slope };
+    const DenoiseRowFn denoiseRow = SelectDenoiseRow(level);
+    const size_t rowBytes = (size_t)m_width * 4;
+    for (uint32_t y = rowBegin; y < rowEnd; ++y)
+    {
+        const uint8_t* in = src + (ptrdiff_t)y * srcStride;
+        uint8_t* history = m_history.data() + y * rowBytes;
+        uint8_t* out = dst + (ptrdiff_t)y * dstStride;
+        if (m_primed)
+        {
+            denoiseRow(in, history, out, m_width, gate);
+        }
+        else
+        {
+            // No history yet: the frame passes through and becomes it.
+            std::memcpy(history, in, rowBytes);
+            if (out != in)
+                std::memcpy(out, in, rowBytes);
+        }
+    }
+}
+
+void TemporalDenoise::Apply(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride, SimdLevel level)
+{
+    if (!src || !dst || !IsConfigured())
+        return;
+    ApplyRows(src, srcStride, dst, dstStride, 0, m_height, level);
+    m_primed = true;
+}
+
+void TemporalDenoise::ApplyParallel(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                                    WorkerPool& pool, SimdLevel level)
+{
+    if (!src || !dst || !IsConfigured())
+        return;
+    pool.ParallelBands(m_height, 1, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd)
+    {
+        ApplyRows(src, srcStride, dst, dstStride, rowBegin, rowEnd, level);
+    });
+    m_primed = true;
+}
+
+}
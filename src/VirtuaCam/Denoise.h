@@ -0,0 +1,74 @@
+// =============================================================================
+// Denoise.h  --  Motion-adaptive temporal denoise for BGRA frames
+// =============================================================================
+// Low-light webcam noise changes every frame while the scene mostly does not,
+// so averaging each pixel over time removes it without the blur a spatial
+// filter would add.  A TemporalDenoise keeps its previous output (the
+// history) and blends every new pixel towards it:
+//
+//   diff  = (|dB| + 2 |dG| + |dR|) / 4      frame vs history, per pixel
+//   k     = maxWeight * (1 - min(diff, threshold) / threshold)
+//   out   = (cur (256 - k) + history k + 128) / 256    per channel
+//   history = out
+//
+// A static pixel converges to the mean of its recent values (a recursive
+// filter with weight k / 256 on the past); a pixel that moved differs from
+// its history by more than the noise, gets k = 0 and passes straight
+// through, so motion does not smear.  The difference is one number per
+// pixel, averaged over the colour channels, so noise in one channel does not
+// open the gate and all channels blend by the same weight.
+//
+// Everything is 16-bit integer arithmetic and bit-identical across the
+// scalar, SSE4.1 and AVX2 kernels.  The stage streams three frames (input,
+// history, output) with little arithmetic, so AVX-512 reuses AVX2.
+//
+// This header (and Denoise.cpp) deliberately has no Windows dependency.
+// =============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Simd.h"
+#include "WorkerPool.h"
+
+namespace VirtuaCam {
+
+class TemporalDenoise {
+public:
+    // 'strength' 0 .. 1 sets both the history weight (up to 224 / 256: an
+    // 8-frame time constant) and the motion threshold (8 .. 32 levels).  A
+    // strength of 0 leaves the denoiser unconfigured.
+    void Configure(uint32_t width, uint32_t height, float strength);
+
+    bool IsConfigured() const { return m_width != 0; }
+    uint32_t MaxWeight() const { return m_maxWeight; }
+    uint32_t Threshold() const { return m_threshold; }
+
+    // Forgets the history; the next frame passes through unchanged (call on
+    // a scene cut or after a stall).
+    void Reset() { m_primed = false; }
+
+    // Denoises one width x height BGRA frame from 'src' into 'dst' (may be
+    // the same buffer) and keeps the result as the next frame's history.
+    // Strides in bytes.
+    void Apply(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+               SimdLevel level = GetSimdLevel());
+
+    void ApplyParallel(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                       WorkerPool& pool = WorkerPool::Shared(), SimdLevel level = GetSimdLevel());
+
+private:
+    void ApplyRows(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                   uint32_t rowBegin, uint32_t rowEnd, SimdLevel level);
+
+    uint32_t m_width = 0, m_height = 0;
+    uint32_t m_maxWeight = 0;       // Q8 history weight for a static pixel
+    uint32_t m_threshold = 0;       // difference at which the history is ignored
+    uint32_t m_slope = 0;           // Q4: maxWeight / threshold
+    bool m_primed = false;
+    std::vector<uint8_t> m_history; // previous output, width * 4 bytes per row
+};
+
+}
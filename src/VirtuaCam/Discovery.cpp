@@ -4,22 +4,36 @@
 // See Discovery.h for a full description of the discovery protocol.
 //
 // The scan works as follows:
-//   1. Take a process snapshot with CreateToolhelp32Snapshot.
-//   2. For each running process, try to open a file-mapping named
-//      "DirectPort_Producer_Manifest_<PID>".
-//   3. If found, map a view and read the BroadcastManifest header.
+//   1. Snapshot the producer directory (ProducerDirectory.h): the PIDs of the
+//      producers that registered themselves, a few cache lines.
+//   2. For each registered PID, open the file-mapping named
+//      "DirectPort_Producer_Manifest_<PID>".  A missing mapping means the
+//      producer died without deregistering; its slot is reclaimed.
+//   3. Map it through ManifestView, which reads v1 and v2 manifests alike.
 //   4. Check the adapter LUID — only accept producers on our own GPU, because
 //      D3D11 shared textures cannot cross adapter boundaries.
 //   5. Record the producer's texture and fence names for the broker/multiplexer
 //      to open later.
+//
+// DiscoverStreams() only rescans when the directory's change sequence has
+// moved since the last scan, so the per-frame call in the broker is a single
+// atomic load while the producer set is stable.
+//
+// For every registration it sees, the scanner opens the producer's process
+// handle once (for its executable name, via QueryFullProcessImageNameW) and
+// registers a thread-pool wait on it.  When the process exits the wait
+// callback reclaims its slot, which notifies every subscriber: a crashed
+// producer disappears at once instead of lingering until someone notices
+// its manifest is gone.
 // =============================================================================
 
 #include "pch.h"
 #include "Discovery.h"
 #include "Tools.h"
+#include "ProducerDirectory.h"
 #include <d3d11_1.h>
 #include <d3d12.h>
-#include <tlhelp32.h>
+#include <map>
 #include <memory>
 
 #pragma comment(lib, "d3d12.lib")
@@ -30,8 +44,89 @@ struct Discovery::Impl {
     Microsoft::WRL::ComPtr<ID3D11Device> m_device;
     LUID m_adapterLuid = {};
     std::vector<DiscoveredSharedStream> m_discoveredStreams;
+
+    ProducerDirectory m_directory;
+    std::vector<ProducerDirectory::Entry> m_entries;
+    bool m_scanned = false;
+    uint64_t m_scannedChangeCount = 0;
+
+    // One per registration seen, keyed by slot word.
+    struct ProducerWatch {
+        ProducerDirectory* directory = nullptr;
+        ProducerDirectory::Entry entry;
+        HANDLE process = nullptr;
+        HANDLE wait = nullptr;
+        std::wstring processName;
+    };
+    std::map<uint64_t, std::unique_ptr<ProducerWatch>> m_watches;
+
+    bool OpenDirectory();
+    ProducerWatch& Watch(const ProducerDirectory::Entry& entry);
+    void Unwatch(ProducerWatch& watch);
+    void PruneWatches();
+    static VOID CALLBACK OnProducerExit(PVOID context, BOOLEAN);
 };
 
+// Thread-pool callback: the producer process has exited.  The reclaim fails
+// harmlessly if the producer deregistered itself first.
+VOID CALLBACK Discovery::Impl::OnProducerExit(PVOID context, BOOLEAN) {
+    auto* watch = static_cast<ProducerWatch*>(context);
+    watch->directory->Reclaim(watch->entry);
+}
+
+// Opens the existing directory, never creates it (see ProducerDirectory.h).
+// Read-write: the scan reclaims slots of dead producers and callers may
+// subscribe.
+bool Discovery::Impl::OpenDirectory() {
+    return m_directory.Open(ProducerDirectory::kDefaultName, ProducerDirectory::Access::OpenExisting);
+}
+
+Discovery::Impl::ProducerWatch& Discovery::Impl::Watch(const ProducerDirectory::Entry& entry) {
+    auto it = m_watches.find(entry.word);
+    if (it != m_watches.end()) return *it->second;
+
+    auto watch = std::make_unique<ProducerWatch>();
+    watch->directory = &m_directory;
+    watch->entry = entry;
+    watch->process = OpenProcess(SYNCHRONIZE | PROCESS_QUERY_LIMITED_INFORMATION, FALSE, entry.processId);
+    if (watch->process) {
+        wchar_t path[MAX_PATH];
+        DWORD length = MAX_PATH;
+        if (QueryFullProcessImageNameW(watch->process, 0, path, &length)) {
+            std::wstring fullPath(path, length);
+            size_t separator = fullPath.find_last_of(L"\\/");
+            watch->processName = separator == std::wstring::npos ? fullPath : fullPath.substr(separator + 1);
+        }
+        RegisterWaitForSingleObject(&watch->wait, watch->process, OnProducerExit, watch.get(),
+                                    INFINITE, WT_EXECUTEONLYONCE);
+    }
+    return *m_watches.emplace(entry.word, std::move(watch)).first->second;
+}
+
+void Discovery::Impl::Unwatch(ProducerWatch& watch) {
+    // Blocks until a running callback has finished with 'watch'.
+    if (watch.wait) UnregisterWaitEx(watch.wait, INVALID_HANDLE_VALUE);
+    if (watch.process) CloseHandle(watch.process);
+    watch.wait = nullptr;
+    watch.process = nullptr;
+}
+
+void Discovery::Impl::PruneWatches() {
+    // Drop watches of registrations that are gone.
+    for (auto it = m_watches.begin(); it != m_watches.end();) {
+        bool live = false;
+        for (const auto& entry : m_entries) {
+            if (entry.word == it->first) { live = true; break; }
+        }
+        if (live) {
+            ++it;
+        } else {
+            Unwatch(*it->second);
+            it = m_watches.erase(it);
+        }
+    }
+}
+
 Discovery::Discovery() : pImpl(std::make_unique<Impl>()) {}
 Discovery::~Discovery() { Teardown(); }
 
@@ -47,60 +142,87 @@ HRESULT Discovery::Initialize(ID3D11Device* device) {
     DXGI_ADAPTER_DESC desc;
     adapter->GetDesc(&desc);
     pImpl->m_adapterLuid = desc.AdapterLuid;
+
+    // Producers and the broker create the directory; until one has, this
+    // finds nothing and DiscoverStreams() tries again.
+    pImpl->OpenDirectory();
     return S_OK;
 }
 
 void Discovery::Teardown() {
     pImpl->m_device.Reset();
+    for (auto& watch : pImpl->m_watches) pImpl->Unwatch(*watch.second);
+    pImpl->m_watches.clear();
+    pImpl->m_directory.Close();
+    pImpl->m_scanned = false;
 }
 
 void Discovery::DiscoverStreams() {
-    pImpl->m_discoveredStreams.clear();
+    if (!pImpl->m_directory.IsOpen() && !pImpl->OpenDirectory()) {
+        pImpl->m_discoveredStreams.clear();
+        return;
+    }
 
-    // Snapshot all processes currently running on the system.
-    HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-    if (hSnapshot == INVALID_HANDLE_VALUE) return;
+    // Nothing registered, deregistered or reclaimed since the last scan: the
+    // previous results still stand.  The count is read before the snapshot,
+    // so a change during the scan triggers another one next time.
+    const uint64_t changeCount = pImpl->m_directory.ChangeCount();
+    if (pImpl->m_scanned && changeCount == pImpl->m_scannedChangeCount) return;
+    pImpl->m_scanned = true;
+    pImpl->m_scannedChangeCount = changeCount;
+    pImpl->m_discoveredStreams.clear();
 
-    PROCESSENTRY32W pe32 = {};
-    pe32.dwSize = sizeof(PROCESSENTRY32W);
+    // Registered producers only; everything else on the machine is ignored.
+    pImpl->m_directory.Snapshot(pImpl->m_entries);
 
     // The naming convention for producer manifests.
     // Each producer creates a mapping named "<prefix><PID>".
-    const std::vector<std::pair<std::wstring, std::wstring>> producerSignatures = {
-        { L"DirectPort_Producer_Manifest_", L"DirectPort" },
-    };
+    static const wchar_t* kManifestPrefix = L"DirectPort_Producer_Manifest_";
 
-    if (Process32FirstW(hSnapshot, &pe32)) {
-        do {
-            for (const auto& sig : producerSignatures) {
-                std::wstring manifestName = sig.first + std::to_wstring(pe32.th32ProcessID);
-                HANDLE hManifest = OpenFileMappingW(FILE_MAP_READ, FALSE, manifestName.c_str());
-                if (hManifest) {
-                    BroadcastManifest* pView = (BroadcastManifest*)MapViewOfFile(hManifest, FILE_MAP_READ, 0, 0, sizeof(BroadcastManifest));
-                    if (pView) {
-                        // Only accept producers on our own GPU adapter.
-                        // D3D11 cross-process texture sharing requires both processes
-                        // to use the same physical adapter.
-                        if (memcmp(&pView->adapterLuid, &pImpl->m_adapterLuid, sizeof(LUID)) == 0) {
-                            DiscoveredSharedStream stream;
-                            stream.processId   = pe32.th32ProcessID;
-                            stream.processName = pe32.szExeFile;
-                            stream.producerType  = sig.second;
-                            stream.manifestName  = manifestName;
-                            stream.textureName   = pView->textureName;
-                            stream.fenceName     = pView->fenceName;
-                            stream.adapterLuid   = pView->adapterLuid;
-                            pImpl->m_discoveredStreams.push_back(stream);
-                        }
-                        UnmapViewOfFile(pView);
-                    }
-                    CloseHandle(hManifest);
-                    break;  // Found a manifest for this PID; skip remaining signatures.
-                }
-            }
-        } while (Process32NextW(hSnapshot, &pe32));
+    for (const auto& entry : pImpl->m_entries) {
+        std::wstring manifestName = kManifestPrefix + std::to_wstring(entry.processId);
+        ManifestView manifest;
+        if (!manifest.Open(manifestName.c_str())) {
+            // The mapping dies with its process: the producer exited without
+            // deregistering.  Free the slot unless it changed meanwhile.
+            if (GetLastError() == ERROR_FILE_NOT_FOUND) pImpl->m_directory.Reclaim(entry);
+            continue;
+        }
+        const Impl::ProducerWatch& watch = pImpl->Watch(entry);
+        // Only accept producers on our own GPU adapter.
+        // D3D11 cross-process texture sharing requires both processes
+        // to use the same physical adapter.
+        const LUID adapterLuid = manifest.AdapterLuid();
+        if (memcmp(&adapterLuid, &pImpl->m_adapterLuid, sizeof(LUID)) == 0) {
+            DiscoveredSharedStream stream;
+            stream.processId   = entry.processId;
+            stream.processName = watch.processName;
+            stream.producerType  = L"DirectPort";
+            stream.manifestName  = manifestName;
+            stream.textureName   = manifest.TextureName();
+            stream.fenceName     = manifest.FenceName();
+            stream.adapterLuid   = adapterLuid;
+            pImpl->m_discoveredStreams.push_back(stream);
+        }
     }
-    CloseHandle(hSnapshot);
+
+    pImpl->PruneWatches();
+}
+
+uint64_t Discovery::ChangeCount() const {
+    return pImpl->m_directory.ChangeCount();
+}
+
+bool Discovery::Subscribe() {
+    return pImpl->m_directory.Subscribe();
+}
+
+bool Discovery::WaitForChange(uint64_t seen, DWORD timeoutMs) {
+    return pImpl->m_directory.WaitForChange(seen, timeoutMs == INFINITE ? NamedEvent::kInfinite : timeoutMs);
+}
+
+void Discovery::CancelWait() {
+    pImpl->m_directory.Wake();
 }
 
 const std::vector<DiscoveredSharedStream>& Discovery::GetDiscoveredStreams() const {
@@ -6,14 +6,20 @@
 //
 //   DirectPort_Producer_Manifest_<PID>
 //
-// The mapping contains a BroadcastManifest struct (defined in App.h/Broker.cpp)
+// The mapping contains a manifest (Manifest.h; v1 or v2, read via ManifestView)
 // that holds the names of the shared texture and fence the producer has
-// created, along with the GPU adapter LUID it is running on.
+// created, along with the GPU adapter LUID it is running on.  For as long as
+// it runs, the producer also registers its PID in the shared producer
+// directory (ProducerDirectory.h).
 //
-// Discovery::DiscoverStreams() snapshots all running processes and probes each
-// one for this mapping.  Only producers running on the same GPU adapter as the
-// caller (matched by LUID) are returned; cross-adapter zero-copy texture
-// sharing is not possible.
+// Discovery::DiscoverStreams() reads the directory and probes only the
+// registered PIDs for this mapping.  Only producers running on the same GPU
+// adapter as the caller (matched by LUID) are returned; cross-adapter
+// zero-copy texture sharing is not possible.
+//
+// The directory also carries a change sequence and per-subscriber wake
+// events, so callers learn about producer arrival and departure (including
+// crashes, via process-handle waits) without polling.
 // =============================================================================
 
 #pragma once
@@ -47,25 +53,41 @@ struct DiscoveredSharedStream {
 // ---------------------------------------------------------------------------
 // Discovery
 // ---------------------------------------------------------------------------
-// One-shot stream scanner.  Call DiscoverStreams() each frame (or on demand)
-// and read the results from GetDiscoveredStreams().
+// Stream scanner.  Call DiscoverStreams() each frame (or on demand) and read
+// the results from GetDiscoveredStreams(); it only rescans when the producer
+// set has changed.  A thread that wants to sleep until then calls
+// Subscribe() once and WaitForChange() in a loop.
 
 class Discovery {
 public:
     Discovery();
     ~Discovery();
 
-    // Store the D3D11 device used to identify the local GPU adapter LUID.
-    // Must be called once before DiscoverStreams().
+    // Store the D3D11 device used to identify the local GPU adapter LUID and
+    // open the producer directory.  Must be called once before
+    // DiscoverStreams().
     HRESULT Initialize(ID3D11Device* device);
 
-    // Release the D3D11 device reference.
+    // Release the D3D11 device reference and the producer directory.
     void Teardown();
 
-    // Snapshot all running processes and populate the discovered-stream list.
-    // Results are cleared and rebuilt on every call.
+    // Scan the registered producers and populate the discovered-stream list.
+    // Results are rebuilt only when the directory's change sequence has moved
+    // since the previous call.
     void DiscoverStreams();
 
+    // The directory's change sequence.
+    uint64_t ChangeCount() const;
+
+    // Create this instance's wake event (once, after Initialize()).
+    bool Subscribe();
+
+    // Block until ChangeCount() differs from 'seen', the timeout expires or
+    // CancelWait() is called; true if it changed.  May be called from a
+    // thread other than the one calling DiscoverStreams().
+    bool WaitForChange(uint64_t seen, DWORD timeoutMs = INFINITE);
+    void CancelWait();
+
     // Access the most recently discovered streams.
     const std::vector<DiscoveredSharedStream>& GetDiscoveredStreams() const;
 
@@ -57,4 +57,29 @@ static const std::vector<FrameRate> g_supportedFrameRates = {
     {30, 1, L"30 FPS"},
     {30000, 1001, L"29.97 FPS (NTSC)"},
     {24, 1, L"24 FPS (Cinematic)"}
-};
\ No newline at end of file
+};
+
+// YUV formats produced on the CPU by the ColorConvert kernels (see
+// BrokerClient::Generate), advertised alongside RGB32 and NV12 for every
+// resolution and frame rate so apps get their preferred format directly.
+struct SoftwareVideoFormat {
+    GUID subtype;
+    UINT bitsPerPixel;      // Average over all planes, for MF_MT_AVG_BITRATE
+    UINT lumaSampleBytes;   // Default stride = width * lumaSampleBytes
+};
+
+static const std::vector<SoftwareVideoFormat> g_softwareVideoFormats = {
+    {MFVideoFormat_YUY2, 16, 2},
+    {MFVideoFormat_I420, 12, 1},
+    {MFVideoFormat_P010, 24, 2},
+};
+
+inline bool IsSoftwareVideoFormat(REFGUID subtype)
+{
+    for (const auto& f : g_softwareVideoFormats)
+    {
+        if (f.subtype == subtype)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,452 @@
+// =============================================================================
+// FramePipeline.cpp  --  Fused single-pass crop / scale / convert pipelines
+// =============================================================================
+// See FramePipeline.h for the public contract.
+//
+// Stages are small traits structs specialised per format:
+//
+//   Source<F>::Unpack   crop-relative source rows -> BGRA (kRowAlign: first
+//                       row granularity, 2 for NV12's shared chroma rows)
+//   Sink<F>::Pack       BGRA rows -> destination rows (output rows start on
+//                       a multiple of kChunkRows, so always even)
+//
+// RunBand<S, D, Scaled> strings them together per chunk and is the only
+// thing the dispatch table holds.  A BGRA source is read in place and a BGRA
+// destination (without orientation) is written in place, so those stages
+// cost nothing.  RunBandNV12<Scaled> is the YUV-only NV12 -> NV12 path.
+//
+// A downscaled NV12 source is resized in YUV by the NV12Scaler before it is
+// unpacked (ScaleNV12ToBGRA), so only the smaller output rows are converted
+// and the scaler reads 1.5 bytes per source pixel instead of 4.
+//
+// With statistics requested, each band accumulates into its own FrameStats
+// and merges it once at the end.  The NV12 -> NV12 path has no BGRA rows, so
+// it unpacks each output chunk (still in cache) to scratch for the purpose.
+// =============================================================================
+
+#include "FramePipeline.h"
+#include "ColorConvert.h"
+#include "YuvUnpack.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+namespace VirtuaCam {
+
+namespace
+{
+    using Job = FramePipeline::Job;
+    using BandFn = FramePipeline::BandFn;
+
+    constexpr size_t kFormatCount = 6;
+
+    // -----------------------------------------------------------------------
+    // Sources
+    // -----------------------------------------------------------------------
+
+    template <PixelFormat F> struct Source;
+
+    template <> struct Source<PixelFormat::BGRA> {
+        static constexpr uint32_t kRowAlign = 1;
+        static const uint8_t* Row(const PipelineDesc& d, const ImagePlanes& src, uint32_t y)
+        {
+            return src.plane[0] + (ptrdiff_t)(d.cropY + y) * src.stride[0] + (ptrdiff_t)d.cropX * 4;
+        }
+    };
+
+    template <> struct Source<PixelFormat::NV12> {
+        static constexpr uint32_t kRowAlign = 2;
+        static void Unpack(const PipelineDesc& d, const ImagePlanes& src, uint32_t y, uint32_t rows,
+                           uint8_t* bgra, ptrdiff_t stride, SimdLevel level)
+        {
+            const uint32_t ay = d.cropY + y;
+            ConvertNV12ToBGRA(src.plane[0] + (ptrdiff_t)ay * src.stride[0] + d.cropX, src.stride[0],
+                              src.plane[1] + (ptrdiff_t)(ay / 2) * src.stride[1] + d.cropX, src.stride[1],
+                              d.cropWidth, rows, bgra, stride, d.srcColorimetry, level);
+        }
+    };
+
+    template <> struct Source<PixelFormat::YUY2> {
+        static constexpr uint32_t kRowAlign = 1;
+        static void Unpack(const PipelineDesc& d, const ImagePlanes& src, uint32_t y, uint32_t rows,
+                           uint8_t* bgra, ptrdiff_t stride, SimdLevel level)
+        {
+            ConvertYUY2ToBGRA(src.plane[0] + (ptrdiff_t)(d.cropY + y) * src.stride[0] + (ptrdiff_t)d.cropX * 2, src.stride[0],
+                              d.cropWidth, rows, bgra, stride, d.srcColorimetry, level);
+        }
+    };
+
+    template <> struct Source<PixelFormat::UYVY> {
+        static constexpr uint32_t kRowAlign = 1;
+        static void Unpack(const PipelineDesc& d, const ImagePlanes& src, uint32_t y, uint32_t rows,
+                           uint8_t* bgra, ptrdiff_t stride, SimdLevel level)
+        {
+            ConvertUYVYToBGRA(src.plane[0] + (ptrdiff_t)(d.cropY + y) * src.stride[0] + (ptrdiff_t)d.cropX * 2, src.stride[0],
+                              d.cropWidth, rows, bgra, stride, d.srcColorimetry, level);
+        }
+    };
+
+    // -----------------------------------------------------------------------
+    // Sinks
+    // -----------------------------------------------------------------------
+
+    template <PixelFormat F> struct Sink;
+
+    template <> struct Sink<PixelFormat::BGRA> {
+        static uint8_t* Row(const ImagePlanes& dst, uint32_t y)
+        {
+            return dst.plane[0] + (ptrdiff_t)y * dst.stride[0];
+        }
+    };
+
+    template <> struct Sink<PixelFormat::NV12> {
+        static void Pack(const PipelineDesc& d, const uint8_t* bgra, ptrdiff_t stride, uint32_t y, uint32_t rows,
+                         const ImagePlanes& dst, SimdLevel level)
+        {
+            ConvertBGRAToNV12(bgra, stride, d.dstWidth, rows,
+                              dst.plane[0] + (ptrdiff_t)y * dst.stride[0], dst.stride[0],
+                              dst.plane[1] + (ptrdiff_t)(y / 2) * dst.stride[1], dst.stride[1],
+                              d.dstColorimetry, level);
+        }
+    };
+
+    template <> struct Sink<PixelFormat::YUY2> {
+        static void Pack(const PipelineDesc& d, const uint8_t* bgra, ptrdiff_t stride, uint32_t y, uint32_t rows,
+                         const ImagePlanes& dst, SimdLevel level)
+        {
+            ConvertBGRAToYUY2(bgra, stride, d.dstWidth, rows,
+                              dst.plane[0] + (ptrdiff_t)y * dst.stride[0], dst.stride[0], d.dstColorimetry, level);
+        }
+    };
+
+    template <> struct Sink<PixelFormat::I420> {
+        static void Pack(const PipelineDesc& d, const uint8_t* bgra, ptrdiff_t stride, uint32_t y, uint32_t rows,
+                         const ImagePlanes& dst, SimdLevel level)
+        {
+            ConvertBGRAToI420(bgra, stride, d.dstWidth, rows,
+                              dst.plane[0] + (ptrdiff_t)y * dst.stride[0], dst.stride[0],
+                              dst.plane[1] + (ptrdiff_t)(y / 2) * dst.stride[1], dst.stride[1],
+                              dst.plane[2] + (ptrdiff_t)(y / 2) * dst.stride[2], dst.stride[2],
+                              d.dstColorimetry, level);
+        }
+    };
+
+    template <> struct Sink<PixelFormat::P010> {
+        static void Pack(const PipelineDesc& d, const uint8_t* bgra, ptrdiff_t stride, uint32_t y, uint32_t rows,
+                         const ImagePlanes& dst, SimdLevel level)
+        {
+            ConvertBGRAToP010(bgra, stride, d.dstWidth, rows,
+                              reinterpret_cast<uint16_t*>(dst.plane[0] + (ptrdiff_t)y * dst.stride[0]), dst.stride[0],
+                              reinterpret_cast<uint16_t*>(dst.plane[1] + (ptrdiff_t)(y / 2) * dst.stride[1]), dst.stride[1],
+                              d.dstColorimetry, level);
+        }
+    };
+
+    constexpr bool IsSource(PixelFormat f)
+    {
+        return f == PixelFormat::BGRA || f == PixelFormat::NV12 || f == PixelFormat::YUY2 || f == PixelFormat::UYVY;
+    }
+
+    constexpr bool IsSink(PixelFormat f)
+    {
+        return f != PixelFormat::UYVY;
+    }
+
+    // Per-thread scratch: the unpacked source window, the BGRA chunk and the
+    // scaled NV12 chunk.
+    struct Scratch {
+        std::vector<uint8_t> window;
+        std::vector<uint8_t> chunk;
+        std::vector<uint8_t> nv12;
+    };
+
+    void MergeStats(const Job& job, const FrameStats& band)
+    {
+        std::lock_guard<std::mutex> guard(*job.statsLock);
+        job.stats->Merge(band);
+    }
+
+    uint8_t* Reserve(std::vector<uint8_t>& buffer, size_t bytes)
+    {
+        if (buffer.size() < bytes)
+            buffer.resize(bytes);
+        return buffer.data();
+    }
+
+    // Output rows [r0, r1) of a downscaled NV12 source: scaled in YUV into
+    // scratch, then unpacked to BGRA at the destination size.
+    void ScaleNV12ToBGRA(const Job& job, uint32_t r0, uint32_t r1, Scratch& scratch,
+                         uint8_t* bgra, ptrdiff_t bgraStride)
+    {
+        const PipelineDesc& d = job.pipeline->Desc();
+        const ImagePlanes& src = *job.src;
+        const ptrdiff_t yStride = d.dstWidth, uvStride = (ptrdiff_t)((d.dstWidth + 1) / 2) * 2;
+        uint8_t* y = Reserve(scratch.nv12, (size_t)(yStride + uvStride / 2) * FramePipeline::kChunkRows + uvStride);
+        uint8_t* uv = y + yStride * FramePipeline::kChunkRows;
+
+        job.pipeline->GetNV12Scaler().ScaleRows(src.plane[0] + (ptrdiff_t)d.cropY * src.stride[0] + d.cropX, src.stride[0],
+                                                src.plane[1] + (ptrdiff_t)(d.cropY / 2) * src.stride[1] + d.cropX, src.stride[1],
+                                                y, yStride, uv, uvStride, r0, r1, job.level);
+        ConvertNV12ToBGRA(y, yStride, uv, uvStride, d.dstWidth, r1 - r0, bgra, bgraStride, d.srcColorimetry, job.level);
+    }
+
+    // -----------------------------------------------------------------------
+    // The fused band kernel
+    // -----------------------------------------------------------------------
+
+    template <PixelFormat S, PixelFormat D, bool Scaled>
+    void RunBand(const Job& job, uint32_t rowBegin, uint32_t rowEnd)
+    {
+        thread_local Scratch scratch;
+        const FramePipeline& pipeline = *job.pipeline;
+        const PipelineDesc& d = pipeline.Desc();
+        const bool oriented = !d.orientation.IsIdentity();
+        const ptrdiff_t chunkStride = (ptrdiff_t)d.dstWidth * 4;
+        FrameStats stats;
+
+        for (uint32_t r0 = rowBegin; r0 < rowEnd; r0 += FramePipeline::kChunkRows)
+        {
+            const uint32_t r1 = std::min(r0 + FramePipeline::kChunkRows, rowEnd);
+            const uint32_t rows = r1 - r0;
+
+            // 1. BGRA output rows [r0, r1) of the unoriented destination,
+            //    straight into the destination when nothing follows.
+            const uint8_t* out = nullptr;
+            ptrdiff_t outStride = chunkStride;
+            uint8_t* target = nullptr;
+            if constexpr (D == PixelFormat::BGRA)
+            {
+                if (!oriented)
+                {
+                    target = Sink<D>::Row(*job.dst, r0);
+                    outStride = job.dst->stride[0];
+                }
+            }
+            if (!target)
+                target = Reserve(scratch.chunk, (size_t)chunkStride * FramePipeline::kChunkRows);
+
+            if constexpr (Scaled)
+            {
+                if (S == PixelFormat::NV12 && pipeline.GetNV12Scaler().IsConfigured())
+                {
+                    ScaleNV12ToBGRA(job, r0, r1, scratch, target, outStride);
+                }
+                else
+                {
+                    const Scaler& scaler = pipeline.GetScaler();
+                    uint32_t first = 0, last = 0;
+                    scaler.SourceRows(r0, r1, first, last);
+                    first -= first % Source<S>::kRowAlign;
+
+                    const uint8_t* window;
+                    ptrdiff_t windowStride;
+                    if constexpr (S == PixelFormat::BGRA)
+                    {
+                        window = Source<S>::Row(d, *job.src, first);
+                        windowStride = job.src->stride[0];
+                    }
+                    else
+                    {
+                        windowStride = (ptrdiff_t)d.cropWidth * 4;
+                        uint8_t* w = Reserve(scratch.window, (size_t)windowStride * (last - first));
+                        Source<S>::Unpack(d, *job.src, first, last - first, w, windowStride, job.level);
+                        window = w;
+                    }
+                    scaler.ScaleRows(window, windowStride, first, target, outStride, 4, r0, r1, job.level);
+                }
+                out = target;
+            }
+            else if constexpr (S == PixelFormat::BGRA)
+            {
+                out = Source<S>::Row(d, *job.src, r0);
+                outStride = job.src->stride[0];
+                if constexpr (D == PixelFormat::BGRA)
+                {
+                    if (!oriented)
+                    {
+                        if (job.stats)
+                            AccumulateFrameStats(out, outStride, d.dstWidth, rows, stats, job.level);
+                        for (uint32_t i = 0; i < rows; ++i)
+                            std::memcpy(target + (ptrdiff_t)i * job.dst->stride[0], out + (ptrdiff_t)i * outStride, (size_t)d.dstWidth * 4);
+                        continue;
+                    }
+                }
+            }
+            else
+            {
+                Source<S>::Unpack(d, *job.src, r0, rows, target, outStride, job.level);
+                out = target;
+            }
+
+            if (job.stats)
+                AccumulateFrameStats(out, outStride, d.dstWidth, rows, stats, job.level);
+
+            // 2. Store: orient (BGRA) or pack to the destination format.
+            if constexpr (D == PixelFormat::BGRA)
+            {
+                if (oriented)
+                    WriteOrientedRows(out, outStride, d.dstWidth, d.dstHeight, r0, r1,
+                                      job.dst->plane[0], job.dst->stride[0], d.orientation, job.level);
+            }
+            else
+            {
+                Sink<D>::Pack(d, out, outStride, r0, rows, *job.dst, job.level);
+            }
+        }
+        if (job.stats)
+            MergeStats(job, stats);
+    }
+
+    // -----------------------------------------------------------------------
+    // NV12 -> NV12 without leaving YUV
+    // -----------------------------------------------------------------------
+
+    template <bool Scaled>
+    void RunBandNV12(const Job& job, uint32_t rowBegin, uint32_t rowEnd)
+    {
+        const PipelineDesc& d = job.pipeline->Desc();
+        const ImagePlanes& src = *job.src;
+        const ImagePlanes& dst = *job.dst;
+        const uint8_t* srcY = src.plane[0] + (ptrdiff_t)d.cropY * src.stride[0] + d.cropX;
+        const uint8_t* srcUV = src.plane[1] + (ptrdiff_t)(d.cropY / 2) * src.stride[1] + d.cropX;
+
+        if constexpr (Scaled)
+        {
+            job.pipeline->GetNV12Scaler().ScaleRows(srcY, src.stride[0], srcUV, src.stride[1],
+                                                    dst.plane[0] + (ptrdiff_t)rowBegin * dst.stride[0], dst.stride[0],
+                                                    dst.plane[1] + (ptrdiff_t)(rowBegin / 2) * dst.stride[1], dst.stride[1],
+                                                    rowBegin, rowEnd, job.level);
+        }
+        else
+        {
+            for (uint32_t y = rowBegin; y < rowEnd; ++y)
+                std::memcpy(dst.plane[0] + (ptrdiff_t)y * dst.stride[0], srcY + (ptrdiff_t)y * src.stride[0], d.dstWidth);
+            const size_t chromaBytes = (size_t)((d.dstWidth + 1) / 2) * 2;
+            for (uint32_t y = rowBegin / 2; y < (rowEnd + 1) / 2; ++y)
+                std::memcpy(dst.plane[1] + (ptrdiff_t)y * dst.stride[1], srcUV + (ptrdiff_t)y * src.stride[1], chromaBytes);
+        }
+
+        if (job.stats)
+        {
+            thread_local Scratch scratch;
+            const ptrdiff_t chunkStride = (ptrdiff_t)d.dstWidth * 4;
+            uint8_t* chunk = Reserve(scratch.chunk, (size_t)chunkStride * FramePipeline::kChunkRows);
+            FrameStats stats;
+            for (uint32_t r0 = rowBegin; r0 < rowEnd; r0 += FramePipeline::kChunkRows)
+            {
+                const uint32_t rows = std::min(FramePipeline::kChunkRows, rowEnd - r0);
+                ConvertNV12ToBGRA(dst.plane[0] + (ptrdiff_t)r0 * dst.stride[0], dst.stride[0],
+                                  dst.plane[1] + (ptrdiff_t)(r0 / 2) * dst.stride[1], dst.stride[1],
+                                  d.dstWidth, rows, chunk, chunkStride, d.dstColorimetry, job.level);
+                AccumulateFrameStats(chunk, chunkStride, d.dstWidth, rows, stats, job.level);
+            }
+            MergeStats(job, stats);
+        }
+    }
+
+    // -----------------------------------------------------------------------
+    // Dispatch table: [source][destination][scaled]
+    // -----------------------------------------------------------------------
+
+    template <PixelFormat S, PixelFormat D>
+    constexpr std::array<BandFn, 2> Entry()
+    {
+        if constexpr (IsSource(S) && IsSink(D))
+            return { &RunBand<S, D, false>, &RunBand<S, D, true> };
+        else
+            return { nullptr, nullptr };
+    }
+
+    template <PixelFormat S>
+    constexpr std::array<std::array<BandFn, 2>, kFormatCount> Row()
+    {
+        return { Entry<S, PixelFormat::BGRA>(), Entry<S, PixelFormat::NV12>(), Entry<S, PixelFormat::YUY2>(),
+                 Entry<S, PixelFormat::UYVY>(), Entry<S, PixelFormat::I420>(), Entry<S, PixelFormat::P010>() };
+    }
+
+    constexpr std::array<std::array<std::array<BandFn, 2>, kFormatCount>, kFormatCount> kBandTable = {
+        Row<PixelFormat::BGRA>(), Row<PixelFormat::NV12>(), Row<PixelFormat::YUY2>(),
+        Row<PixelFormat::UYVY>(), Row<PixelFormat::I420>(), Row<PixelFormat::P010>(),
+    };
+}
+
+bool FramePipeline::Configure(const PipelineDesc& desc)
+{
+    m_band = nullptr;
+    const size_t src = (size_t)desc.srcFormat, dst = (size_t)desc.dstFormat;
+    if (src >= kFormatCount || dst >= kFormatCount || !desc.srcWidth || !desc.srcHeight)
+        return false;
+    if (!desc.orientation.IsIdentity() && desc.dstFormat != PixelFormat::BGRA)
+        return false;
+
+    PipelineDesc d = desc;
+    if (!d.cropWidth || !d.cropHeight)
+    {
+        d.cropX = d.cropY = 0;
+        d.cropWidth = d.srcWidth;
+        d.cropHeight = d.srcHeight;
+    }
+    if (d.srcFormat != PixelFormat::BGRA)
+    {
+        // Align the crop to the chroma grid.
+        d.cropWidth += d.cropX & 1;
+        d.cropX &= ~1u;
+        if (d.srcFormat == PixelFormat::NV12)
+        {
+            d.cropHeight += d.cropY & 1;
+            d.cropY &= ~1u;
+        }
+    }
+    if ((uint64_t)d.cropX + d.cropWidth > d.srcWidth || (uint64_t)d.cropY + d.cropHeight > d.srcHeight)
+        return false;
+    if (!d.dstWidth || !d.dstHeight)
+    {
+        d.dstWidth = d.cropWidth;
+        d.dstHeight = d.cropHeight;
+    }
+
+    const bool scaled = d.dstWidth != d.cropWidth || d.dstHeight != d.cropHeight;
+    const bool yuvOnly = d.srcFormat == PixelFormat::NV12 && d.dstFormat == PixelFormat::NV12 &&
+                         d.srcColorimetry.matrix == d.dstColorimetry.matrix && d.srcColorimetry.range == d.dstColorimetry.range;
+    const BandFn band = yuvOnly ? (scaled ? &RunBandNV12<true> : &RunBandNV12<false>) : kBandTable[src][dst][scaled ? 1 : 0];
+    if (!band)
+        return false;
+    // An NV12 source scales in YUV unless it is enlarged and converted, where
+    // unpacking the smaller source first is the cheaper order.
+    const bool downscaled = d.dstWidth <= d.cropWidth && d.dstHeight <= d.cropHeight;
+    m_nv12Scaler = NV12Scaler();
+    if (scaled && (yuvOnly || (d.srcFormat == PixelFormat::NV12 && downscaled)))
+        m_nv12Scaler.Configure(d.cropWidth, d.cropHeight, d.dstWidth, d.dstHeight, d.filter);
+    else if (scaled)
+        m_scaler.Configure(d.cropWidth, d.cropHeight, d.dstWidth, d.dstHeight, d.filter);
+
+    m_desc = d;
+    OrientedSize(d.dstWidth, d.dstHeight, d.orientation, m_outputWidth, m_outputHeight);
+    m_band = band;
+    return true;
+}
+
+void FramePipeline::Run(const ImagePlanes& src, const ImagePlanes& dst, WorkerPool& pool, SimdLevel level) const
+{
+    if (!m_band || !src.plane[0] || !dst.plane[0])
+        return;
+    const Job job = { this, &src, &dst, level, nullptr, nullptr };
+    pool.ParallelBands(m_desc.dstHeight, kChunkRows, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd) {
+        m_band(job, rowBegin, rowEnd);
+    });
+}
+
+void FramePipeline::Run(const ImagePlanes& src, const ImagePlanes& dst, FrameStats& stats, WorkerPool& pool, SimdLevel level) const
+{
+    stats.Reset();
+    if (!m_band || !src.plane[0] || !dst.plane[0])
+        return;
+    std::mutex statsLock;
+    const Job job = { this, &src, &dst, level, &stats, &statsLock };
+    pool.ParallelBands(m_desc.dstHeight, kChunkRows, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd) {
+        m_band(job, rowBegin, rowEnd);
+    });
+}
+
+}
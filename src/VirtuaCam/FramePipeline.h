@@ -0,0 +1,132 @@
+// =============================================================================
+// FramePipeline.h  --  Fused single-pass crop / scale / convert pipelines
+// =============================================================================
+// Chaining the CPU kernels (unpack -> crop -> scale -> orient -> convert)
+// writes and re-reads a full intermediate frame per step, and every step is
+// memory-bound.  A FramePipeline runs the whole chain a chunk of output rows
+// at a time instead: the source rows a chunk needs are unpacked to BGRA into
+// per-thread scratch, scaled, oriented and packed to the destination format
+// while they are still in cache.  The source is read once and the destination
+// written once.
+//
+// The combinations are compile-time: FramePipeline.cpp instantiates one band
+// kernel per (source format, destination format, scaled?) and Configure()
+// picks it from a constexpr dispatch table, so the per-chunk code has no
+// format switches.  Every stage reuses the existing SIMD kernels (YuvUnpack,
+// Scaler, Orientation, ColorConvert), so the output is bit-identical to the
+// chained passes.
+//
+// NV12 sources are resized in YUV by an NV12Scaler (siting-aware chroma)
+// rather than as BGRA, at a third of the memory traffic: NV12 -> NV12 with
+// the same colorimetry never leaves YUV (the planes are cropped and copied,
+// or scaled), and a downscaled NV12 frame bound for another format is scaled
+// first and only its output rows are unpacked.  Enlarged NV12 frames bound
+// for another format are unpacked first, which is the cheaper order there.
+//
+//   sources:       BGRA, NV12, YUY2, UYVY
+//   destinations:  BGRA, NV12, YUY2, I420, P010
+//
+// Run() can also fill a FrameStats (FrameStats.h) for the output frame: each
+// chunk is accumulated right after its BGRA rows are produced, while they
+// are in cache, so the statistics cost no extra pass over the frame.
+//
+// Crop rectangles on YUV sources are aligned down to the chroma grid (even x,
+// and even y for NV12).  Orientation is supported for BGRA destinations.
+//
+// This header (and FramePipeline.cpp) deliberately has no Windows dependency.
+// =============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include "Colorimetry.h"
+#include "FrameStats.h"
+#include "Orientation.h"
+#include "Scaler.h"
+#include "Simd.h"
+#include "WorkerPool.h"
+
+namespace VirtuaCam {
+
+enum class PixelFormat : int {
+    BGRA = 0,
+    NV12 = 1,
+    YUY2 = 2,
+    UYVY = 3,
+    I420 = 4,
+    P010 = 5,
+};
+
+// Up to three planes of an image; strides in bytes.  Plane use per format:
+// BGRA / YUY2 / UYVY: [0];  NV12 / P010: [0] Y, [1] UV;  I420: [0] Y, [1] U, [2] V.
+struct ImagePlanes {
+    uint8_t*  plane[3]  = {};
+    ptrdiff_t stride[3] = {};
+};
+
+struct PipelineDesc {
+    PixelFormat srcFormat = PixelFormat::BGRA;
+    uint32_t srcWidth = 0, srcHeight = 0;
+    YuvColorimetry srcColorimetry;
+
+    // Region of the source to use; a zero width or height means the whole frame.
+    uint32_t cropX = 0, cropY = 0, cropWidth = 0, cropHeight = 0;
+
+    // Scaled size before orientation; zero means the crop size (no scaling).
+    PixelFormat dstFormat = PixelFormat::BGRA;
+    uint32_t dstWidth = 0, dstHeight = 0;
+    YuvColorimetry dstColorimetry;
+
+    ScaleFilter filter = ScaleFilter::Bilinear;
+    Orientation orientation;
+};
+
+class FramePipeline {
+public:
+    // Output rows produced per chunk (even, so 4:2:0 stages stay aligned).
+    static constexpr uint32_t kChunkRows = 16;
+
+    // Validates the description and selects the band kernel.  Returns false
+    // (leaving the pipeline unconfigured) for unsupported combinations.
+    bool Configure(const PipelineDesc& desc);
+
+    bool IsConfigured() const { return m_band != nullptr; }
+    const PipelineDesc& Desc() const { return m_desc; }
+
+    // Size of the destination image (after orientation).
+    uint32_t OutputWidth() const  { return m_outputWidth; }
+    uint32_t OutputHeight() const { return m_outputHeight; }
+
+    void Run(const ImagePlanes& src, const ImagePlanes& dst,
+             WorkerPool& pool = WorkerPool::Shared(), SimdLevel level = GetSimdLevel()) const;
+
+    // Same, and replaces 'stats' with the statistics of the output frame
+    // (before orientation, which does not change them).
+    void Run(const ImagePlanes& src, const ImagePlanes& dst, FrameStats& stats,
+             WorkerPool& pool = WorkerPool::Shared(), SimdLevel level = GetSimdLevel()) const;
+
+    // Internal: everything a band kernel needs for one Run().
+    struct Job {
+        const FramePipeline* pipeline;
+        const ImagePlanes* src;
+        const ImagePlanes* dst;
+        SimdLevel level;
+        FrameStats* stats;          // null: no statistics
+        std::mutex* statsLock;      // guards *stats across bands
+    };
+    using BandFn = void (*)(const Job& job, uint32_t rowBegin, uint32_t rowEnd);
+
+    const Scaler& GetScaler() const { return m_scaler; }
+    const NV12Scaler& GetNV12Scaler() const { return m_nv12Scaler; }
+
+private:
+    PipelineDesc m_desc;
+    Scaler m_scaler;
+    NV12Scaler m_nv12Scaler;
+    BandFn m_band = nullptr;
+    uint32_t m_outputWidth = 0, m_outputHeight = 0;
+};
+
+}
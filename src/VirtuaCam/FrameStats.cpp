@@ -0,0 +1,289 @@
+// =============================================================================
+// FrameStats.cpp  --  Per-frame image statistics for BGRA frames
+// =============================================================================
+// See FrameStats.h for the definitions.
+//
+// Luma without widening: pmaddubsw with (19, 0, 54, 0) gives B*19 and R*54 in
+// the two 16-bit halves of every pixel; G is shifted into the low half and
+// multiplied by 183 (the product fits 16 bits unsigned, as does the total).
+// Adding the halves, rounding and shifting by 8 leaves the luma in the low
+// byte of each pixel.  Channel sums use psadbw against zero on the masked
+// channel, clip counts a per-pixel compare and a popcount of the lane mask.
+// =============================================================================
+
+#include "FrameStats.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <mutex>
+
+#if VCAM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace VirtuaCam {
+
+namespace
+{
+    // Running totals of one AccumulateFrameStats() call.  Consecutive pixels
+    // go to different sub-histograms so that runs of equal luma do not stall
+    // on the same counter.
+    struct Counts {
+        uint32_t histogram[4][256];
+        uint64_t channelSum[3];
+        uint64_t clippedLow, clippedHigh;
+    };
+
+    using RowFn = void (*)(const uint8_t* row, uint32_t width, Counts& counts);
+
+    inline void AddPixel(const uint8_t* p, uint32_t slot, Counts& counts)
+    {
+        const uint8_t b = p[0], g = p[1], r = p[2];
+        ++counts.histogram[slot & 3][StatsLuma(b, g, r)];
+        counts.channelSum[0] += b;
+        counts.channelSum[1] += g;
+        counts.channelSum[2] += r;
+        counts.clippedLow += (b == 0 || g == 0 || r == 0);
+        counts.clippedHigh += (b == 255 || g == 255 || r == 255);
+    }
+
+    // -----------------------------------------------------------------------
+    // Scalar reference
+    // -----------------------------------------------------------------------
+
+    void Row_Scalar(const uint8_t* row, uint32_t width, Counts& counts)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+            AddPixel(row + (size_t)x * 4, x, counts);
+    }
+
+#if VCAM_SIMD_X86
+    // -----------------------------------------------------------------------
+    // SSE4.1: 4 pixels per step
+    // -----------------------------------------------------------------------
+
+    VCAM_TARGET_SSE41 inline uint64_t Total_SSE41(__m128i v)
+    {
+        uint64_t halves[2];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(halves), v);
+        return halves[0] + halves[1];
+    }
+
+    VCAM_TARGET_SSE41 void Row_SSE41(const uint8_t* row, uint32_t width, Counts& counts)
+    {
+        const __m128i weightsBR = _mm_set1_epi32(54 << 16 | 19);
+        const __m128i weightG = _mm_set1_epi32(183);
+        const __m128i low16 = _mm_set1_epi32(0xFFFF);
+        const __m128i round = _mm_set1_epi16(128);
+        const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i ones = _mm_set1_epi32(-1);
+        const __m128i maskB = _mm_set1_epi32(0x000000FF);
+        __m128i sumB = zero, sumG = zero, sumR = zero;
+        uint64_t low = 0, high = 0;
+
+        uint32_t x = 0;
+        for (; x + 4 <= width; x += 4)
+        {
+            const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + (size_t)x * 4));
+
+            const __m128i br = _mm_maddubs_epi16(px, weightsBR);
+            const __m128i g = _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(px, 8), low16), weightG);
+            __m128i y = _mm_add_epi16(_mm_add_epi16(br, g), _mm_srli_epi32(br, 16));
+            y = _mm_and_si128(_mm_srli_epi16(_mm_add_epi16(y, round), 8), low16);
+            const uint32_t lumas = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(_mm_packus_epi32(y, y), y));
+            ++counts.histogram[0][lumas & 0xFF];
+            ++counts.histogram[1][(lumas >> 8) & 0xFF];
+            ++counts.histogram[2][(lumas >> 16) & 0xFF];
+            ++counts.histogram[3][lumas >> 24];
+
+            sumB = _mm_add_epi64(sumB, _mm_sad_epu8(_mm_and_si128(px, maskB), zero));
+            sumG = _mm_add_epi64(sumG, _mm_sad_epu8(_mm_and_si128(px, _mm_slli_epi32(maskB, 8)), zero));
+            sumR = _mm_add_epi64(sumR, _mm_sad_epu8(_mm_and_si128(px, _mm_slli_epi32(maskB, 16)), zero));
+
+            // Pixels with no colour byte at 0 (alpha forced non-zero) / at 255 (alpha forced to 0).
+            const __m128i noLow = _mm_cmpeq_epi32(_mm_cmpeq_epi8(_mm_or_si128(px, alpha), zero), zero);
+            const __m128i noHigh = _mm_cmpeq_epi32(_mm_cmpeq_epi8(_mm_andnot_si128(alpha, px), ones), zero);
+            low += 4 - std::popcount((unsigned)_mm_movemask_ps(_mm_castsi128_ps(noLow)));
+            high += 4 - std::popcount((unsigned)_mm_movemask_ps(_mm_castsi128_ps(noHigh)));
+        }
+
+        counts.channelSum[0] += Total_SSE41(sumB);
+        counts.channelSum[1] += Total_SSE41(sumG);
+        counts.channelSum[2] += Total_SSE41(sumR);
+        counts.clippedLow += low;
+        counts.clippedHigh += high;
+        for (; x < width; ++x)
+            AddPixel(row + (size_t)x * 4, x, counts);
+    }
+
+    // -----------------------------------------------------------------------
+    // AVX2: 8 pixels per step
+    // -----------------------------------------------------------------------
+
+    VCAM_TARGET_AVX2 inline uint64_t Total_AVX2(__m256i v)
+    {
+        return Total_SSE41(_mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+    }
+
+    VCAM_TARGET_AVX2 void Row_AVX2(const uint8_t* row, uint32_t width, Counts& counts)
+    {
+        const __m256i weightsBR = _mm256_set1_epi32(54 << 16 | 19);
+        const __m256i weightG = _mm256_set1_epi32(183);
+        const __m256i low16 = _mm256_set1_epi32(0xFFFF);
+        const __m256i round = _mm256_set1_epi16(128);
+        const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i ones = _mm256_set1_epi32(-1);
+        const __m256i maskB = _mm256_set1_epi32(0x000000FF);
+        __m256i sumB = zero, sumG = zero, sumR = zero;
+        uint64_t low = 0, high = 0;
+
+        uint32_t x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            const __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + (size_t)x * 4));
+
+            const __m256i br = _mm256_maddubs_epi16(px, weightsBR);
+            const __m256i g = _mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi16(px, 8), low16), weightG);
+            __m256i y = _mm256_add_epi16(_mm256_add_epi16(br, g), _mm256_srli_epi32(br, 16));
+            y = _mm256_and_si256(_mm256_srli_epi16(_mm256_add_epi16(y, round), 8), low16);
+            // Packing is per 128-bit lane; the histogram does not care about order.
+            y = _mm256_packus_epi16(_mm256_packus_epi32(y, y), y);
+            const uint32_t l0 = (uint32_t)_mm_cvtsi128_si32(_mm256_castsi256_si128(y));
+            const uint32_t l1 = (uint32_t)_mm_cvtsi128_si32(_mm256_extracti128_si256(y, 1));
+            ++counts.histogram[0][l0 & 0xFF];
+            ++counts.histogram[1][(l0 >> 8) & 0xFF];
+            ++counts.histogram[2][(l0 >> 16) & 0xFF];
+            ++counts.histogram[3][l0 >> 24];
+            ++counts.histogram[0][l1 & 0xFF];
+            ++counts.histogram[1][(l1 >> 8) & 0xFF];
+            ++counts.histogram[2][(l1 >> 16) & 0xFF];
+            ++counts.histogram[3][l1 >> 24];
+
+            sumB = _mm256_add_epi64(sumB, _mm256_sad_epu8(_mm256_and_si256(px, maskB), zero));
+            sumG = _mm256_add_epi64(sumG, _mm256_sad_epu8(_mm256_and_si256(px, _mm256_slli_epi32(maskB, 8)), zero));
+            sumR = _mm256_add_epi64(sumR, _mm256_sad_epu8(_mm256_and_si256(px, _mm256_slli_epi32(maskB, 16)), zero));
+
+            const __m256i noLow = _mm256_cmpeq_epi32(_mm256_cmpeq_epi8(_mm256_or_si256(px, alpha), zero), zero);
+            const __m256i noHigh = _mm256_cmpeq_epi32(_mm256_cmpeq_epi8(_mm256_andnot_si256(alpha, px), ones), zero);
+            low += 8 - std::popcount((unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(noLow)));
+            high += 8 - std::popcount((unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(noHigh)));
+        }
+
+        counts.channelSum[0] += Total_AVX2(sumB);
+        counts.channelSum[1] += Total_AVX2(sumG);
+        counts.channelSum[2] += Total_AVX2(sumR);
+        counts.clippedLow += low;
+        counts.clippedHigh += high;
+        Row_SSE41(row + (size_t)x * 4, width - x, counts);
+    }
+#endif
+
+    // -----------------------------------------------------------------------
+    // Dispatch
+    // -----------------------------------------------------------------------
+
+    // Bound by the scalar histogram scatter; AVX-512 uses the AVX2 kernel.
+    RowFn SelectRow(SimdLevel level)
+    {
+#if VCAM_SIMD_X86
+        switch (ClampSimdLevel(level))
+        {
+        case SimdLevel::AVX512:
+        case SimdLevel::AVX2:   return Row_AVX2;
+        case SimdLevel::SSE41:  return Row_SSE41;
+        default:                break;
+        }
+#else
+        (void)level;
+#endif
+        return Row_Scalar;
+    }
+}
+
+void FrameStats::Merge(const FrameStats& other)
+{
+    for (uint32_t i = 0; i < 256; ++i)
+        lumaHistogram[i] += other.lumaHistogram[i];
+    pixelCount += other.pixelCount;
+    lumaSum += other.lumaSum;
+    for (uint32_t c = 0; c < 3; ++c)
+        channelSum[c] += other.channelSum[c];
+    clippedLow += other.clippedLow;
+    clippedHigh += other.clippedHigh;
+}
+
+uint8_t FrameStats::LumaMin() const
+{
+    for (uint32_t i = 0; i < 256; ++i)
+        if (lumaHistogram[i])
+            return (uint8_t)i;
+    return 0;
+}
+
+uint8_t FrameStats::LumaMax() const
+{
+    for (uint32_t i = 256; i-- > 0;)
+        if (lumaHistogram[i])
+            return (uint8_t)i;
+    return 0;
+}
+
+uint8_t FrameStats::LumaPercentile(double fraction) const
+{
+    if (!pixelCount)
+        return 0;
+    const double target = std::clamp(fraction, 0.0, 1.0) * double(pixelCount);
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        seen += lumaHistogram[i];
+        if (seen && double(seen) >= target)
+            return (uint8_t)i;
+    }
+    return 255;
+}
+
+void AccumulateFrameStats(const uint8_t* bgra, ptrdiff_t stride, uint32_t width, uint32_t height,
+                          FrameStats& stats, SimdLevel level)
+{
+    if (!bgra || !width || !height)
+        return;
+
+    Counts counts;
+    std::memset(&counts, 0, sizeof(counts));
+    const RowFn row = SelectRow(level);
+    for (uint32_t y = 0; y < height; ++y)
+        row(bgra + (ptrdiff_t)y * stride, width, counts);
+
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        const uint32_t n = counts.histogram[0][i] + counts.histogram[1][i] + counts.histogram[2][i] + counts.histogram[3][i];
+        stats.lumaHistogram[i] += n;
+        stats.lumaSum += (uint64_t)n * i;
+    }
+    stats.pixelCount += (uint64_t)width * height;
+    stats.channelSum[0] += counts.channelSum[0];
+    stats.channelSum[1] += counts.channelSum[1];
+    stats.channelSum[2] += counts.channelSum[2];
+    stats.clippedLow += counts.clippedLow;
+    stats.clippedHigh += counts.clippedHigh;
+}
+
+FrameStats ComputeFrameStatsParallel(const uint8_t* bgra, ptrdiff_t stride, uint32_t width, uint32_t height,
+                                     WorkerPool& pool, SimdLevel level)
+{
+    FrameStats total;
+    std::mutex lock;
+    pool.ParallelBands(height, 1, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd)
+    {
+        FrameStats band;
+        AccumulateFrameStats(bgra + (ptrdiff_t)rowBegin * stride, stride, width, rowEnd - rowBegin, band, level);
+        std::lock_guard<std::mutex> guard(lock);
+        total.Merge(band);
+    });
+    return total;
+}
+
+}
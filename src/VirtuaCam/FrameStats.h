@@ -0,0 +1,77 @@
+// =============================================================================
+// FrameStats.h  --  Per-frame image statistics for BGRA frames
+// =============================================================================
+// Exposure matching between sources (auto-levels on a PiP) and source health
+// in the UI both need a few numbers per frame: the luma histogram, its mean
+// and extremes, how many pixels are clipped, and the mean colour.  Reading a
+// 1080p frame again just for that costs as much as converting it, so the
+// statistics are meant to be gathered where the frame is already in cache:
+// FramePipeline::Run() takes a FrameStats and accumulates every chunk of BGRA
+// rows right after it is produced, before it is packed or stored.
+//
+// Definitions (colour channels only; alpha is ignored):
+//
+//   luma          (19 B + 183 G + 54 R + 128) >> 8, i.e. BT.709 weights in
+//                 8-bit fixed point, full range, on the stored (gamma) values
+//   clippedLow    pixels with at least one of B, G, R at 0
+//   clippedHigh   pixels with at least one of B, G, R at 255
+//
+// Everything is an exact integer count, so statistics gathered in bands on
+// any number of threads, at any SIMD level, or inside the pipeline equal a
+// separate single-threaded pass.  The SIMD kernels compute luma, channel
+// sums and clip masks for 4 (SSE4.1) or 8 (AVX2) pixels at a time; the
+// histogram scatter is scalar into four interleaved sub-histograms, which is
+// what bounds the speed, so AVX-512 reuses AVX2.
+//
+// This header (and FrameStats.cpp) deliberately has no Windows dependency.
+// =============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Simd.h"
+#include "WorkerPool.h"
+
+namespace VirtuaCam {
+
+struct FrameStats {
+    uint32_t lumaHistogram[256] = {};
+    uint64_t pixelCount = 0;
+    uint64_t lumaSum = 0;
+    uint64_t channelSum[3] = {};    // B, G, R
+    uint64_t clippedLow = 0;
+    uint64_t clippedHigh = 0;
+
+    void Reset() { *this = FrameStats{}; }
+    void Merge(const FrameStats& other);
+
+    // Lowest / highest luma present (0 / 0 for an empty frame).
+    uint8_t LumaMin() const;
+    uint8_t LumaMax() const;
+
+    // Smallest luma value v with at least 'fraction' (0..1) of the pixels at
+    // or below v; e.g. 0.01 and 0.99 for an auto-levels black / white point.
+    uint8_t LumaPercentile(double fraction) const;
+
+    double MeanLuma() const { return pixelCount ? double(lumaSum) / double(pixelCount) : 0.0; }
+    double MeanBlue() const  { return pixelCount ? double(channelSum[0]) / double(pixelCount) : 0.0; }
+    double MeanGreen() const { return pixelCount ? double(channelSum[1]) / double(pixelCount) : 0.0; }
+    double MeanRed() const   { return pixelCount ? double(channelSum[2]) / double(pixelCount) : 0.0; }
+};
+
+// Luma of one pixel, as used by the histogram.
+inline uint8_t StatsLuma(uint8_t b, uint8_t g, uint8_t r)
+{
+    return (uint8_t)((19u * b + 183u * g + 54u * r + 128u) >> 8);
+}
+
+// Adds width x height BGRA pixels to 'stats'.  Stride in bytes.
+void AccumulateFrameStats(const uint8_t* bgra, ptrdiff_t stride, uint32_t width, uint32_t height,
+                          FrameStats& stats, SimdLevel level = GetSimdLevel());
+
+// A separate pass over a whole frame, band-parallel.
+FrameStats ComputeFrameStatsParallel(const uint8_t* bgra, ptrdiff_t stride, uint32_t width, uint32_t height,
+                                     WorkerPool& pool = WorkerPool::Shared(), SimdLevel level = GetSimdLevel());
+
+}
@@ -0,0 +1,115 @@
+// =============================================================================
+// Letterbox.cpp  --  Aspect-fit layout and the blurred-background bar fill
+// =============================================================================
+// See Letterbox.h for the public contract.
+// =============================================================================
+
+#include "Letterbox.h"
+#include <algorithm>
+#include <cmath>
+
+namespace VirtuaCam {
+
+LayoutRect FitRect(const LayoutRect& dst, uint32_t srcWidth, uint32_t srcHeight)
+{
+    LayoutRect fit = dst;
+    if (srcWidth && srcHeight)
+    {
+        const float scale = std::min(dst.width / (float)srcWidth, dst.height / (float)srcHeight);
+        fit.width  = srcWidth * scale;
+        fit.height = srcHeight * scale;
+        fit.x = dst.x + (dst.width - fit.width) * 0.5f;
+        fit.y = dst.y + (dst.height - fit.height) * 0.5f;
+    }
+    return fit;
+}
+
+bool HasBars(const LayoutRect& dst, const LayoutRect& content)
+{
+    return content.width <= dst.width - 1.0f || content.height <= dst.height - 1.0f;
+}
+
+UvRect CoverUv(float dstWidth, float dstHeight, uint32_t srcWidth, uint32_t srcHeight)
+{
+    UvRect cover;
+    if (!srcWidth || !srcHeight || dstWidth <= 0.0f || dstHeight <= 0.0f)
+        return cover;
+    const double srcAspect = (double)srcWidth / srcHeight;
+    const double dstAspect = (double)dstWidth / dstHeight;
+    if (srcAspect > dstAspect)
+        cover.width = (float)(dstAspect / srcAspect);       // source wider: crop the sides
+    else
+        cover.height = (float)(srcAspect / dstAspect);      // source taller: crop top and bottom
+    cover.u = (1.0f - cover.width) * 0.5f;
+    cover.v = (1.0f - cover.height) * 0.5f;
+    return cover;
+}
+
+LetterboxFillPlan PlanLetterboxFill(uint32_t dstWidth, uint32_t dstHeight, uint32_t srcWidth, uint32_t srcHeight,
+                                    uint32_t reduction)
+{
+    LetterboxFillPlan plan;
+    reduction = std::max(reduction, 1u);
+    plan.width = std::max(1u, (dstWidth + reduction - 1) / reduction);
+    plan.height = std::max(1u, (dstHeight + reduction - 1) / reduction);
+    plan.cover = CoverUv((float)dstWidth, (float)dstHeight, srcWidth, srcHeight);
+
+    // Source texels per reduced pixel; the mip level with about one texel
+    // per pixel samples without aliasing.
+    const double ratio = std::max(plan.cover.width * srcWidth / (double)plan.width,
+                                  plan.cover.height * srcHeight / (double)plan.height);
+    plan.lod = ratio > 1.0 ? (float)std::log2(ratio) : 0.0f;
+    return plan;
+}
+
+void GaussianWeights(float sigma, uint32_t radius, float* weights)
+{
+    const double s = std::max(sigma, 1e-3f);
+    double sum = 0.0;
+    for (uint32_t i = 0; i <= radius; ++i)
+    {
+        const double w = std::exp(-(double)i * i / (2.0 * s * s));
+        weights[i] = (float)w;
+        sum += i ? 2.0 * w : w;
+    }
+    for (uint32_t i = 0; i <= radius; ++i)
+        weights[i] = (float)(weights[i] / sum);
+}
+
+// ---------------------------------------------------------------------------
+// LetterboxFill
+// ---------------------------------------------------------------------------
+
+void LetterboxFill::Configure(uint32_t srcWidth, uint32_t srcHeight, uint32_t dstWidth, uint32_t dstHeight,
+                              uint32_t reduction, float sigma)
+{
+    m_plan = {};
+    if (!srcWidth || !srcHeight || !dstWidth || !dstHeight)
+        return;
+
+    const LetterboxFillPlan plan = PlanLetterboxFill(dstWidth, dstHeight, srcWidth, srcHeight, reduction);
+    m_cropX = std::min((uint32_t)(plan.cover.u * srcWidth), srcWidth - 1);
+    m_cropY = std::min((uint32_t)(plan.cover.v * srcHeight), srcHeight - 1);
+    const uint32_t cropWidth = std::clamp((uint32_t)std::lround(plan.cover.width * srcWidth), 1u, srcWidth - m_cropX);
+    const uint32_t cropHeight = std::clamp((uint32_t)std::lround(plan.cover.height * srcHeight), 1u, srcHeight - m_cropY);
+
+    m_reduce.Configure(cropWidth, cropHeight, plan.width, plan.height, ScaleFilter::Box);
+    m_blur.Configure(plan.width, plan.height, sigma);
+    m_expand.Configure(plan.width, plan.height, dstWidth, dstHeight, ScaleFilter::Bilinear);
+    m_small.resize((size_t)plan.width * plan.height * 4);
+    m_plan = plan;
+}
+
+void LetterboxFill::Apply(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                          WorkerPool& pool, SimdLevel level)
+{
+    if (!src || !dst || !IsConfigured())
+        return;
+    const ptrdiff_t smallStride = (ptrdiff_t)m_plan.width * 4;
+    m_reduce.ScaleParallel(src + (ptrdiff_t)m_cropY * srcStride + (ptrdiff_t)m_cropX * 4, srcStride,
+                           m_small.data(), smallStride, 4, pool, level);
+    m_blur.Apply(m_small.data(), smallStride, m_small.data(), smallStride, pool, level);
+    m_expand.ScaleParallel(m_small.data(), smallStride, dst, dstStride, 4, pool, level);
+}
+
+}
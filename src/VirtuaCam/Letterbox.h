@@ -0,0 +1,98 @@
+// =============================================================================
+// Letterbox.h  --  Aspect-fit layout and the blurred-background bar fill
+// =============================================================================
+// A source whose aspect differs from its destination is fitted inside it and
+// the remaining bars have to show something.  Black bars look broken behind
+// a portrait phone or a 4:3 camera; the usual fix is the source itself,
+// scaled to cover the whole destination and heavily blurred.  A blur that
+// wide is expensive at full resolution but not at 1/16: the look is so soft
+// that nothing is lost by computing it on a tiny image and upsampling.
+//
+//   1. reduce   the centre "cover" region of the source (same aspect as the
+//               destination) down to destination / reduction (120 x 68 for
+//               1080p at 1/16).  The GPU samples the source's mip chain at
+//               the matching level of detail, which the Multiplexer already
+//               generates for every frame.
+//   2. blur     a small separable Gaussian at that size.
+//   3. expand   bilinearly over the destination; the fitted source is then
+//               drawn on top, so the fill only shows in the bars.
+//
+// This module holds the layout math the Multiplexer's shaders are driven by,
+// and LetterboxFill, a CPU reference of the same three steps (Scaler and
+// Blur) for CPU compositing and for checking the layout.
+//
+// This header (and Letterbox.cpp) deliberately has no Windows dependency.
+// =============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Blur.h"
+#include "Scaler.h"
+#include "Simd.h"
+#include "WorkerPool.h"
+
+namespace VirtuaCam {
+
+struct LayoutRect {
+    float x = 0.0f, y = 0.0f, width = 0.0f, height = 0.0f;
+};
+
+// Part of a texture in normalised coordinates (0..1).
+struct UvRect {
+    float u = 0.0f, v = 0.0f, width = 1.0f, height = 1.0f;
+};
+
+// Largest rectangle with the source's aspect inside 'dst', centred.  Returns
+// 'dst' unchanged if the source size is unknown.
+LayoutRect FitRect(const LayoutRect& dst, uint32_t srcWidth, uint32_t srcHeight);
+
+// True if 'content' leaves a bar of at least one pixel inside 'dst'.
+bool HasBars(const LayoutRect& dst, const LayoutRect& content);
+
+// Centre region of the source that, stretched over a dstWidth x dstHeight
+// rectangle, fills it without distortion (the "cover" crop).
+UvRect CoverUv(float dstWidth, float dstHeight, uint32_t srcWidth, uint32_t srcHeight);
+
+// Sizes and sampling parameters for one fill.
+struct LetterboxFillPlan {
+    uint32_t width = 0, height = 0;     // reduced image (>= 1 x 1)
+    UvRect cover;                       // source region to reduce
+    float lod = 0.0f;                   // source mip level matching the reduction
+};
+
+LetterboxFillPlan PlanLetterboxFill(uint32_t dstWidth, uint32_t dstHeight, uint32_t srcWidth, uint32_t srcHeight,
+                                    uint32_t reduction = 16);
+
+// Normalised weights of a (2 * radius + 1)-tap Gaussian: weights[0] is the
+// centre tap, weights[i] the taps at +-i.  Sums to 1.
+void GaussianWeights(float sigma, uint32_t radius, float* weights);
+
+// CPU reference of the fill: reduce -> blur -> expand over the whole frame.
+class LetterboxFill {
+public:
+    static constexpr uint32_t kDefaultReduction = 16;
+    static constexpr float kDefaultSigma = 2.0f;    // in reduced pixels
+
+    void Configure(uint32_t srcWidth, uint32_t srcHeight, uint32_t dstWidth, uint32_t dstHeight,
+                   uint32_t reduction = kDefaultReduction, float sigma = kDefaultSigma);
+
+    bool IsConfigured() const { return m_plan.width != 0; }
+    const LetterboxFillPlan& Plan() const { return m_plan; }
+
+    // Writes the blurred background over all of 'dst' (dstWidth x dstHeight
+    // BGRA); draw the fitted source on top afterwards.  Strides in bytes.
+    void Apply(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+               WorkerPool& pool = WorkerPool::Shared(), SimdLevel level = GetSimdLevel());
+
+private:
+    LetterboxFillPlan m_plan;
+    uint32_t m_cropX = 0, m_cropY = 0;
+    Scaler m_reduce, m_expand;
+    Blur m_blur;
+    std::vector<uint8_t> m_small;
+};
+
+}
@@ -0,0 +1,468 @@
+// =============================================================================
+// Lut3D.cpp  --  3D LUT colour grading (.cube, tetrahedral interpolation)
+// =============================================================================
+// See Lut3D.h for the public contract.
+//
+// Fixed-point interpolation
+// -------------------------
+// Per channel the position table gives a lattice index i (at most N - 2) and
+// a fraction f in [0, 1 << 14].  With the fractions sorted a >= b >= c and
+// the lattice strides of their axes (1 for red, N for green, N^2 for blue):
+//
+//   v0 = base                    w0 = (1 << 14) - a
+//   v1 = base + stride(max)      w1 = a - b
+//   v2 = base + diag - stride(min)   w2 = b - c
+//   v3 = base + diag             w3 = c          (diag = 1 + N + N^2)
+//
+//   out = (w0*v0 + w1*v1 + w2*v2 + w3*v3 + (1 << 17)) >> 18
+//
+// Nodes are value * 16 (at most 4080), so the sum stays below 2^27 and each
+// channel is one pmaddwd over two interleaved node pairs.  Ties between
+// fractions pick their axis by a fixed rule that every kernel shares.  The
+// affected vertex then has zero weight, so any choice would be correct.
+// =============================================================================
+
+#include "Lut3D.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#if VCAM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace VirtuaCam {
+
+namespace
+{
+    constexpr int kFractionBits = 14;
+    constexpr uint32_t kFractionOne = 1u << kFractionBits;
+    constexpr uint32_t kIndexShift = 15;
+    constexpr uint32_t kFractionMask = (1u << kIndexShift) - 1;
+    constexpr int kOutputShift = kFractionBits + 4;
+    constexpr int kOutputRound = 1 << (kOutputShift - 1);
+    constexpr double kNodeScale = 255.0 * 16.0;
+
+    using RowFn = void (*)(const Lut3D::Table& table, const uint8_t* src, uint8_t* dst, uint32_t count);
+
+    // -----------------------------------------------------------------------
+    // Scalar reference
+    // -----------------------------------------------------------------------
+
+    struct Tetrahedron {
+        uint32_t vertex[4];
+        uint32_t weight[4];
+    };
+
+    inline Tetrahedron Locate(const Lut3D::Table& table, uint32_t pixel)
+    {
+        const uint32_t n = table.size;
+        const uint32_t pb = table.position[0][pixel & 0xFF];
+        const uint32_t pg = table.position[1][(pixel >> 8) & 0xFF];
+        const uint32_t pr = table.position[2][(pixel >> 16) & 0xFF];
+        const uint32_t fb = pb & kFractionMask, fg = pg & kFractionMask, fr = pr & kFractionMask;
+        const uint32_t base = ((pb >> kIndexShift) * n + (pg >> kIndexShift)) * n + (pr >> kIndexShift);
+        const uint32_t diag = 1 + n + n * n;
+
+        const uint32_t strideMax = (fr >= fg && fr >= fb) ? 1 : (fg >= fb ? n : n * n);
+        const uint32_t strideMin = (fb <= fg && fb <= fr) ? n * n : (fg <= fr ? n : 1);
+        const uint32_t a = std::max(std::max(fr, fg), fb);
+        const uint32_t c = std::min(std::min(fr, fg), fb);
+        const uint32_t b = fr + fg + fb - a - c;
+
+        return { { base, base + strideMax, base + diag - strideMin, base + diag },
+                 { kFractionOne - a, a - b, b - c, c } };
+    }
+
+    void ApplyRow_Scalar(const Lut3D::Table& table, const uint8_t* src, uint8_t* dst, uint32_t count)
+    {
+        const uint32_t* in = reinterpret_cast<const uint32_t*>(src);
+        uint32_t* out = reinterpret_cast<uint32_t*>(dst);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const uint32_t pixel = in[i];
+            const Tetrahedron t = Locate(table, pixel);
+            uint32_t result = pixel & 0xFF000000u;
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                uint32_t sum = kOutputRound;
+                for (uint32_t k = 0; k < 4; ++k)
+                    sum += t.weight[k] * (uint32_t)((table.nodes[t.vertex[k]] >> (16 * c)) & 0xFFFF);
+                result |= (sum >> kOutputShift) << (8 * c);
+            }
+            out[i] = result;
+        }
+    }
+
+#if VCAM_SIMD_X86
+    // -----------------------------------------------------------------------
+    // SSE4.1: one pixel per pmaddwd pair, two pixels per store
+    // -----------------------------------------------------------------------
+
+    VCAM_TARGET_SSE41 inline __m128i Interpolate_SSE41(const Lut3D::Table& table, uint32_t pixel)
+    {
+        const Tetrahedron t = Locate(table, pixel);
+        const uint64_t* nodes = table.nodes.data();
+        const __m128i n01 = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(nodes + t.vertex[0])),
+                                               _mm_loadl_epi64(reinterpret_cast<const __m128i*>(nodes + t.vertex[1])));
+        const __m128i n23 = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(nodes + t.vertex[2])),
+                                               _mm_loadl_epi64(reinterpret_cast<const __m128i*>(nodes + t.vertex[3])));
+        const __m128i w01 = _mm_set1_epi32((int)(t.weight[0] | (t.weight[1] << 16)));
+        const __m128i w23 = _mm_set1_epi32((int)(t.weight[2] | (t.weight[3] << 16)));
+        const __m128i sum = _mm_add_epi32(_mm_madd_epi16(n01, w01), _mm_madd_epi16(n23, w23));
+        return _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(kOutputRound)), kOutputShift);
+    }
+
+    VCAM_TARGET_SSE41 void ApplyRow_SSE41(const Lut3D::Table& table, const uint8_t* src, uint8_t* dst, uint32_t count)
+    {
+        const uint32_t* in = reinterpret_cast<const uint32_t*>(src);
+        const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000u);
+        uint32_t i = 0;
+        for (; i + 2 <= count; i += 2)
+        {
+            const __m128i pixels = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i));
+            const __m128i p0 = Interpolate_SSE41(table, in[i]);
+            const __m128i p1 = Interpolate_SSE41(table, in[i + 1]);
+            __m128i packed = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_setzero_si128());
+            packed = _mm_or_si128(packed, _mm_and_si128(pixels, alphaMask));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + (size_t)i * 4), packed);
+        }
+        ApplyRow_Scalar(table, src + (size_t)i * 4, dst + (size_t)i * 4, count - i);
+    }
+
+    // -----------------------------------------------------------------------
+    // AVX2: eight pixels per step, gathers for positions and nodes
+    // -----------------------------------------------------------------------
+
+    // Interpolates four pixels with vertex indices v0..v3.  Their packed
+    // weight pairs are lanes First .. First + 3 of w01 / w23 (one 32-bit lane
+    // per pixel).  Returns their 16-bit B, G, R, 0 values in pixel order.
+    template <int First>
+    VCAM_TARGET_AVX2 inline __m256i Interpolate4_AVX2(const long long* nodes, __m128i v0, __m128i v1, __m128i v2, __m128i v3,
+                                                      __m256i w01, __m256i w23)
+    {
+        const __m256i g0 = _mm256_i32gather_epi64(nodes, v0, 8);
+        const __m256i g1 = _mm256_i32gather_epi64(nodes, v1, 8);
+        const __m256i g2 = _mm256_i32gather_epi64(nodes, v2, 8);
+        const __m256i g3 = _mm256_i32gather_epi64(nodes, v3, 8);
+
+        // Gathered lanes hold pixels (0, 1 | 2, 3): the unpacklo half is
+        // pixels 0 and 2, the unpackhi half pixels 1 and 3.
+        const __m256i evenLanes = _mm256_setr_epi32(First, First, First, First, First + 2, First + 2, First + 2, First + 2);
+        const __m256i oddLanes = _mm256_add_epi32(evenLanes, _mm256_set1_epi32(1));
+        const __m256i even = _mm256_add_epi32(
+            _mm256_madd_epi16(_mm256_unpacklo_epi16(g0, g1), _mm256_permutevar8x32_epi32(w01, evenLanes)),
+            _mm256_madd_epi16(_mm256_unpacklo_epi16(g2, g3), _mm256_permutevar8x32_epi32(w23, evenLanes)));
+        const __m256i odd = _mm256_add_epi32(
+            _mm256_madd_epi16(_mm256_unpackhi_epi16(g0, g1), _mm256_permutevar8x32_epi32(w01, oddLanes)),
+            _mm256_madd_epi16(_mm256_unpackhi_epi16(g2, g3), _mm256_permutevar8x32_epi32(w23, oddLanes)));
+        const __m256i round = _mm256_set1_epi32(kOutputRound);
+        return _mm256_packs_epi32(_mm256_srli_epi32(_mm256_add_epi32(even, round), kOutputShift),
+                                  _mm256_srli_epi32(_mm256_add_epi32(odd, round), kOutputShift));
+    }
+
+    VCAM_TARGET_AVX2 void ApplyRow_AVX2(const Lut3D::Table& table, const uint8_t* src, uint8_t* dst, uint32_t count)
+    {
+        const int n = (int)table.size;
+        const __m256i strideR = _mm256_set1_epi32(1);
+        const __m256i strideG = _mm256_set1_epi32(n);
+        const __m256i strideB = _mm256_set1_epi32(n * n);
+        const __m256i diag = _mm256_set1_epi32(1 + n + n * n);
+        const __m256i one = _mm256_set1_epi32((int)kFractionOne);
+        const __m256i byteMask = _mm256_set1_epi32(0xFF);
+        const __m256i fractionMask = _mm256_set1_epi32((int)kFractionMask);
+        const __m256i alphaMask = _mm256_set1_epi32((int)0xFF000000u);
+        const long long* nodes = reinterpret_cast<const long long*>(table.nodes.data());
+        const int* posB = reinterpret_cast<const int*>(table.position[0]);
+        const int* posG = reinterpret_cast<const int*>(table.position[1]);
+        const int* posR = reinterpret_cast<const int*>(table.position[2]);
+
+        uint32_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + (size_t)i * 4));
+            const __m256i pb = _mm256_i32gather_epi32(posB, _mm256_and_si256(pixels, byteMask), 4);
+            const __m256i pg = _mm256_i32gather_epi32(posG, _mm256_and_si256(_mm256_srli_epi32(pixels, 8), byteMask), 4);
+            const __m256i pr = _mm256_i32gather_epi32(posR, _mm256_and_si256(_mm256_srli_epi32(pixels, 16), byteMask), 4);
+            const __m256i fb = _mm256_and_si256(pb, fractionMask);
+            const __m256i fg = _mm256_and_si256(pg, fractionMask);
+            const __m256i fr = _mm256_and_si256(pr, fractionMask);
+            const __m256i base = _mm256_add_epi32(
+                _mm256_mullo_epi32(_mm256_add_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(pb, kIndexShift), strideG),
+                                                    _mm256_srli_epi32(pg, kIndexShift)), strideG),
+                _mm256_srli_epi32(pr, kIndexShift));
+
+            // x >= y  <=>  !(y > x)
+            const __m256i rGeG = _mm256_cmpeq_epi32(_mm256_cmpgt_epi32(fg, fr), _mm256_setzero_si256());
+            const __m256i rGeB = _mm256_cmpeq_epi32(_mm256_cmpgt_epi32(fb, fr), _mm256_setzero_si256());
+            const __m256i gGeB = _mm256_cmpeq_epi32(_mm256_cmpgt_epi32(fb, fg), _mm256_setzero_si256());
+            const __m256i bLeG = gGeB;
+            const __m256i bLeR = rGeB;
+            const __m256i gLeR = rGeG;
+            const __m256i strideMax = _mm256_blendv_epi8(_mm256_blendv_epi8(strideB, strideG, gGeB), strideR, _mm256_and_si256(rGeG, rGeB));
+            const __m256i strideMin = _mm256_blendv_epi8(_mm256_blendv_epi8(strideR, strideG, gLeR), strideB, _mm256_and_si256(bLeG, bLeR));
+
+            const __m256i a = _mm256_max_epu32(_mm256_max_epu32(fr, fg), fb);
+            const __m256i c = _mm256_min_epu32(_mm256_min_epu32(fr, fg), fb);
+            const __m256i b = _mm256_sub_epi32(_mm256_add_epi32(_mm256_add_epi32(fr, fg), fb), _mm256_add_epi32(a, c));
+            const __m256i w01 = _mm256_or_si256(_mm256_sub_epi32(one, a), _mm256_slli_epi32(_mm256_sub_epi32(a, b), 16));
+            const __m256i w23 = _mm256_or_si256(_mm256_sub_epi32(b, c), _mm256_slli_epi32(c, 16));
+
+            const __m256i v1 = _mm256_add_epi32(base, strideMax);
+            const __m256i v3 = _mm256_add_epi32(base, diag);
+            const __m256i v2 = _mm256_sub_epi32(v3, strideMin);
+
+            const __m256i lo = Interpolate4_AVX2<0>(nodes, _mm256_castsi256_si128(base), _mm256_castsi256_si128(v1),
+                                                    _mm256_castsi256_si128(v2), _mm256_castsi256_si128(v3), w01, w23);
+            const __m256i hi = Interpolate4_AVX2<4>(nodes, _mm256_extracti128_si256(base, 1), _mm256_extracti128_si256(v1, 1),
+                                                    _mm256_extracti128_si256(v2, 1), _mm256_extracti128_si256(v3, 1), w01, w23);
+            // packus per lane gives pixels (0 1 4 5 | 2 3 6 7); restore order.
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+            packed = _mm256_or_si256(packed, _mm256_and_si256(pixels, alphaMask));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (size_t)i * 4), packed);
+        }
+        ApplyRow_SSE41(table, src + (size_t)i * 4, dst + (size_t)i * 4, count - i);
+    }
+#endif
+
+    // The kernels are bound by the node gathers; AVX-512 uses the AVX2 path.
+    RowFn SelectRow(SimdLevel level)
+    {
+#if VCAM_SIMD_X86
+        switch (ClampSimdLevel(level))
+        {
+        case SimdLevel::AVX512:
+        case SimdLevel::AVX2:   return ApplyRow_AVX2;
+        case SimdLevel::SSE41:  return ApplyRow_SSE41;
+        default:                break;
+        }
+#else
+        (void)level;
+#endif
+        return ApplyRow_Scalar;
+    }
+
+    // -----------------------------------------------------------------------
+    // .cube parsing
+    // -----------------------------------------------------------------------
+
+    std::string_view Trim(std::string_view s)
+    {
+        const size_t begin = s.find_first_not_of(" \t\r");
+        if (begin == std::string_view::npos)
+            return {};
+        const size_t end = s.find_last_not_of(" \t\r");
+        return s.substr(begin, end - begin + 1);
+    }
+
+    // Reads up to 'count' whitespace-separated floats; returns how many.
+    size_t ParseFloats(std::string_view s, float* values, size_t count)
+    {
+        size_t parsed = 0;
+        const char* p = s.data();
+        const char* end = s.data() + s.size();
+        while (parsed < count)
+        {
+            while (p < end && (*p == ' ' || *p == '\t'))
+                ++p;
+            if (p == end)
+                break;
+            if (*p == '+')
+                ++p;
+            const auto result = std::from_chars(p, end, values[parsed]);
+            if (result.ec != std::errc())
+                return parsed;
+            p = result.ptr;
+            ++parsed;
+        }
+        while (p < end && (*p == ' ' || *p == '\t'))
+            ++p;
+        return p == end ? parsed : 0;
+    }
+
+    bool Fail(std::string* error, size_t line, const char* message)
+    {
+        if (error)
+            *error = line ? "line " + std::to_string(line) + ": " + message : message;
+        return false;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Lut3D
+// ---------------------------------------------------------------------------
+
+bool Lut3D::ParseCube(std::string_view text, std::string* error)
+{
+    std::string title;
+    uint32_t size = 0;
+    float domainMin[3] = { 0.0f, 0.0f, 0.0f };
+    float domainMax[3] = { 1.0f, 1.0f, 1.0f };
+    std::vector<float> rgb;
+
+    size_t lineNumber = 0;
+    while (!text.empty())
+    {
+        const size_t newline = text.find('\n');
+        std::string_view line = text.substr(0, newline);
+        text = newline == std::string_view::npos ? std::string_view() : text.substr(newline + 1);
+        ++lineNumber;
+
+        line = Trim(line.substr(0, line.find('#')));
+        if (line.empty())
+            continue;
+
+        const bool isData = (line[0] >= '0' && line[0] <= '9') || line[0] == '-' || line[0] == '+' || line[0] == '.';
+        if (isData)
+        {
+            if (!size)
+                return Fail(error, lineNumber, "table data before LUT_3D_SIZE");
+            float v[3];
+            if (ParseFloats(line, v, 3) != 3)
+                return Fail(error, lineNumber, "expected three numbers");
+            if ((size_t)size * size * size * 3 == rgb.size())
+                return Fail(error, lineNumber, "more table entries than LUT_3D_SIZE^3");
+            rgb.insert(rgb.end(), v, v + 3);
+            continue;
+        }
+
+        const size_t space = line.find_first_of(" \t");
+        const std::string_view keyword = line.substr(0, space);
+        const std::string_view value = space == std::string_view::npos ? std::string_view() : Trim(line.substr(space));
+        if (keyword == "TITLE")
+        {
+            title = std::string(value.size() >= 2 && value.front() == '"' && value.back() == '"' ? value.substr(1, value.size() - 2) : value);
+        }
+        else if (keyword == "LUT_3D_SIZE")
+        {
+            float v = 0.0f;
+            if (size || ParseFloats(value, &v, 1) != 1 || v != std::floor(v) || v < kMinSize || v > kMaxSize)
+                return Fail(error, lineNumber, "invalid LUT_3D_SIZE");
+            size = (uint32_t)v;
+            rgb.reserve((size_t)size * size * size * 3);
+        }
+        else if (keyword == "LUT_1D_SIZE")
+        {
+            return Fail(error, lineNumber, "1D LUTs are not supported");
+        }
+        else if (keyword == "DOMAIN_MIN" || keyword == "DOMAIN_MAX")
+        {
+            if (ParseFloats(value, keyword == "DOMAIN_MIN" ? domainMin : domainMax, 3) != 3)
+                return Fail(error, lineNumber, "expected three numbers");
+        }
+        else if (keyword == "LUT_3D_INPUT_RANGE")
+        {
+            float range[2];
+            if (ParseFloats(value, range, 2) != 2)
+                return Fail(error, lineNumber, "expected two numbers");
+            std::fill(domainMin, domainMin + 3, range[0]);
+            std::fill(domainMax, domainMax + 3, range[1]);
+        }
+        // Other keywords (vendor extensions) are ignored.
+    }
+
+    if (!size)
+        return Fail(error, 0, "missing LUT_3D_SIZE");
+    if (rgb.size() != (size_t)size * size * size * 3)
+        return Fail(error, 0, "fewer table entries than LUT_3D_SIZE^3");
+    for (int c = 0; c < 3; ++c)
+    {
+        if (!(domainMax[c] > domainMin[c]))
+            return Fail(error, 0, "DOMAIN_MAX must exceed DOMAIN_MIN");
+    }
+
+    Build(size, rgb, domainMin, domainMax);
+    m_title = std::move(title);
+    return true;
+}
+
+bool Lut3D::LoadCubeFile(const std::filesystem::path& path, std::string* error)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return Fail(error, 0, "cannot open file");
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return ParseCube(contents.str(), error);
+}
+
+void Lut3D::SetIdentity(uint32_t size)
+{
+    size = std::clamp(size, kMinSize, kMaxSize);
+    std::vector<float> rgb;
+    rgb.reserve((size_t)size * size * size * 3);
+    const float step = 1.0f / float(size - 1);
+    for (uint32_t b = 0; b < size; ++b)
+        for (uint32_t g = 0; g < size; ++g)
+            for (uint32_t r = 0; r < size; ++r)
+                rgb.insert(rgb.end(), { r * step, g * step, b * step });
+    const float domainMin[3] = { 0.0f, 0.0f, 0.0f };
+    const float domainMax[3] = { 1.0f, 1.0f, 1.0f };
+    Build(size, rgb, domainMin, domainMax);
+    m_title.clear();
+}
+
+void Lut3D::Reset()
+{
+    m_size = 0;
+    m_title.clear();
+    m_table = {};
+}
+
+void Lut3D::Build(uint32_t size, const std::vector<float>& rgb, const float domainMin[3], const float domainMax[3])
+{
+    // .cube order (red fastest, then green, then blue) is already the packed
+    // node order; only the channels are swapped into BGRA order.
+    auto quantise = [](float v) -> uint64_t {
+        return (uint64_t)std::lround(std::clamp(v, 0.0f, 1.0f) * kNodeScale);
+    };
+    m_table.size = size;
+    m_table.nodes.resize((size_t)size * size * size);
+    for (size_t i = 0; i < m_table.nodes.size(); ++i)
+    {
+        const float* v = &rgb[i * 3];
+        m_table.nodes[i] = quantise(v[2]) | (quantise(v[1]) << 16) | (quantise(v[0]) << 32);
+    }
+
+    // Position tables in BGRA channel order; the file's domain is RGB.
+    for (int c = 0; c < 3; ++c)
+    {
+        const int axis = 2 - c;
+        const double lo = domainMin[axis], hi = domainMax[axis];
+        for (uint32_t x = 0; x < 256; ++x)
+        {
+            const double u = std::clamp((x / 255.0 - lo) / (hi - lo), 0.0, 1.0);
+            const uint32_t fixed = (uint32_t)std::lround(u * (size - 1) * kFractionOne);
+            const uint32_t index = std::min(fixed >> kFractionBits, size - 2);
+            m_table.position[c][x] = (index << kIndexShift) | (fixed - (index << kFractionBits));
+        }
+    }
+    m_size = size;
+}
+
+void Lut3D::Apply(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                  uint32_t width, uint32_t height, SimdLevel level) const
+{
+    if (!src || !dst || !IsLoaded())
+        return;
+    const RowFn row = SelectRow(level);
+    for (uint32_t y = 0; y < height; ++y)
+        row(m_table, src + (ptrdiff_t)y * srcStride, dst + (ptrdiff_t)y * dstStride, width);
+}
+
+void Lut3D::ApplyParallel(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                          uint32_t width, uint32_t height, WorkerPool& pool, SimdLevel level) const
+{
+    if (!src || !dst || !IsLoaded())
+        return;
+    const RowFn row = SelectRow(level);
+    pool.ParallelBands(height, 1, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd)
+    {
+        for (uint32_t y = rowBegin; y < rowEnd; ++y)
+            row(m_table, src + (ptrdiff_t)y * srcStride, dst + (ptrdiff_t)y * dstStride, width);
+    });
+}
+
+}
@@ -0,0 +1,87 @@
+// =============================================================================
+// Lut3D.h  --  3D LUT colour grading (.cube, tetrahedral interpolation)
+// =============================================================================
+// A Lut3D maps every BGRA pixel through an N x N x N RGB lattice, the format
+// grading tools export as Adobe/Resolve ".cube" files (typically 17, 33 or 65
+// points per axis).  It is the CPU filter stage behind the consumer's --lut
+// option: any look that can be baked into a LUT needs no HLSL.
+//
+// Loading packs the lattice once into a cache-friendly table: one 8-byte node
+// (B, G, R, 0 as 12-bit fixed point, value * 16) per lattice point, blue-major
+// so that the red neighbour is the next node.  A 33-point LUT is 280 KB and
+// stays in L2.  Per-channel position tables turn an 8-bit input into a
+// lattice index and a 14-bit fraction, with DOMAIN_MIN / DOMAIN_MAX folded in.
+//
+// Each pixel is interpolated tetrahedrally: the unit cube around it is split
+// into six tetrahedra along its main diagonal, and the four vertices of the
+// one containing the pixel are blended with weights summing to 1 << 14.
+// That needs four lattice reads instead of trilinear's eight, and it is
+// exactly neutral on the grey axis.
+//
+// Kernels: scalar reference, SSE4.1 (one pixel per step, pmaddwd on node
+// pairs) and AVX2 (eight pixels per step with gathers for positions and
+// nodes).  All are integer and bit-identical; AVX-512 reuses the AVX2 kernel.
+// Alpha passes through unchanged.
+//
+// This header (and Lut3D.cpp) deliberately has no Windows dependency.
+// =============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Simd.h"
+#include "WorkerPool.h"
+
+namespace VirtuaCam {
+
+class Lut3D {
+public:
+    static constexpr uint32_t kMinSize = 2;
+    static constexpr uint32_t kMaxSize = 129;
+
+    // Parses the text of a .cube file (LUT_3D_SIZE, optional TITLE and
+    // DOMAIN_MIN / DOMAIN_MAX, then N^3 "r g b" lines with red fastest).
+    // On failure returns false, leaves the LUT unchanged and describes the
+    // problem in 'error' if given.
+    bool ParseCube(std::string_view text, std::string* error = nullptr);
+    bool LoadCubeFile(const std::filesystem::path& path, std::string* error = nullptr);
+
+    // Identity lattice of the given size (useful as a neutral default).
+    void SetIdentity(uint32_t size);
+
+    void Reset();
+
+    bool IsLoaded() const { return m_size != 0; }
+    uint32_t Size() const { return m_size; }
+    const std::string& Title() const { return m_title; }
+
+    // Maps width x height BGRA pixels from 'src' to 'dst' (may be the same
+    // buffer).  Strides in bytes.
+    void Apply(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+               uint32_t width, uint32_t height, SimdLevel level = GetSimdLevel()) const;
+
+    void ApplyParallel(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                       uint32_t width, uint32_t height, WorkerPool& pool = WorkerPool::Shared(),
+                       SimdLevel level = GetSimdLevel()) const;
+
+    // Packed table layout (see the banner); exposed for the kernels.
+    struct Table {
+        uint32_t size = 0;                   // N
+        std::vector<uint64_t> nodes;         // N^3 nodes, index (b * N + g) * N + r
+        uint32_t position[3][256] = {};      // per channel (B, G, R): index << 15 | fraction
+    };
+
+private:
+    void Build(uint32_t size, const std::vector<float>& rgb, const float domainMin[3], const float domainMax[3]);
+
+    uint32_t m_size = 0;
+    std::string m_title;
+    Table m_table;
+};
+
+}
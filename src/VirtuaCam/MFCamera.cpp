@@ -2,24 +2,80 @@
 // MFCamera.cpp  --  Physical webcam producer
 // =============================================================================
 // This producer DLL is loaded by VirtuaCamProcess.exe (--type camera).
-// It opens a physical webcam via the Media Foundation Source Reader, reads
-// raw RGB32 frames, uploads them to a shared D3D11 texture, and signals the
+// It opens a physical webcam via the Media Foundation Source Reader, turns
+// each frame into BGRA, uploads it to a shared D3D11 texture, and signals the
 // fence so the broker can composite the frame.
 //
-// Argument: --device <index>   (0-based index from MFEnumDeviceSources)
+// Arguments: --device <index>          (0-based index from MFEnumDeviceSources)
+//            --mirror 0|1              (horizontal mirror, default 0)
+//            --rotate 0|90|180|270     (clockwise, after the mirror, default 0)
+//            --crop <x> <y> <w> <h>    (source region, default: whole frame)
+//            --size <w> <h>            (scale the crop to this size before the
+//                                       rotation, default: no scaling)
+//            --stats                   (per-frame image statistics, see below)
+//            --keystone <x0 y0 .. x3 y3> (output corners in the frame, 0..1,
+//                                       TL TR BR BL; see "Geometric correction")
+//            --lens <k1> <k2>          (radial undistort, k1 < 0 for barrel)
+//            --zoom <z>                (crop in after correction, default 1)
+//            --denoise <strength>      (temporal denoise, 0..1, default off)
+//            --ring <slots>            (shared texture ring, 2..4, or 1 for a
+//                                       single texture; default 3; TextureRing.h)
 //
 // Format negotiation
 // ------------------
-// The Source Reader is set up with MF_SOURCE_READER_ENABLE_VIDEO_PROCESSING
-// so MF automatically inserts colour-space / format conversion.  We iterate
-// native media types until we find one we can force to RGB32 output, which
-// keeps the broker's compositing path simple (always BGRA/RGB32 input).
+// Native types are tried in the order the camera lists them.  A native NV12,
+// YUY2 or UYVY type is read as-is (no MF converter in the graph) and unpacked
+// to BGRA by our own SIMD kernels (YuvUnpack.h), honouring the type's
+// MF_MT_YUV_MATRIX / MF_MT_VIDEO_NOMINAL_RANGE.  MJPEG is also read as-is
+// (see below).  Anything else falls back to
+// MF_SOURCE_READER_ENABLE_VIDEO_PROCESSING converting to RGB32.  Either way
+// the shared texture is BGRA, which keeps the broker's compositing path
+// simple.
+//
+// MJPEG: MF's decoder would run synchronously inside ReadSample and cannot
+// sustain 1080p60 / 4K.  Compressed MJPEG samples are instead handed to an
+// MjpegPipeline, which decodes several frames at once with WIC on the worker
+// pool and gives them back in capture order; each decoded frame is published
+// as soon as it is the oldest.
 //
 // Frame upload
 // ------------
-// Because MFSourceReader returns CPU-side buffers, frames are uploaded with
-// UpdateSubresource (CPU -> GPU copy).  This is the one place in VirtuaCam's
-// pipeline that does a CPU->GPU transfer; all other hops are GPU-only.
+// Because MFSourceReader returns CPU-side buffers, frames must cross from the
+// CPU to the GPU.  This is the one place in VirtuaCam's pipeline that does a
+// CPU->GPU transfer; all other hops are GPU-only.  YUV frames are unpacked
+// straight into a mapped DYNAMIC texture (band-parallel on the worker pool)
+// and then copied into the shared texture on the GPU; RGB32 frames still use
+// UpdateSubresource.
+//
+// Crop, scale and orientation
+// ---------------------------
+// --crop / --size / --mirror / --rotate are applied while the CPU writes the
+// frame, never as extra passes.  YUV and RGB32 frames go through one fused
+// FramePipeline (FramePipeline.h) that crops, unpacks, scales and orients a
+// chunk of rows at a time straight into the mapped upload texture; an NV12
+// camera downscaled with --size is resized in YUV before it is unpacked.
+// MJPEG frames with only a transform are oriented during the decode itself
+// (Orientation.h); with a crop or scale they are decoded as-is and run
+// through the same pipeline when published.  90/270 publish a texture with
+// width and height swapped.
+//
+// Statistics
+// ----------
+// With --stats every frame goes through the pipeline, which gathers the luma
+// histogram, clipped-pixel counts and mean colour of the published frame
+// while writing it (FrameStats.h).  A summary of them is published with
+// every frame in the manifest's statistics record (Manifest.h), where the
+// broker and the UI can read it through ManifestView::ReadFrameStats().
+//
+// Denoise and geometric correction
+// --------------------------------
+// --denoise adds a TemporalDenoise (Denoise.h) and --keystone / --lens /
+// --zoom a Warp (Warp.h) after the pipeline, in that order: noise is removed
+// at sensor pixels, before the warp interpolates it.  Both read their input
+// back, so the pipeline then writes into m_stageFrame (system memory; the
+// mapped upload texture is write-combined), the denoiser works on it in place
+// and the last stage writes into the upload texture.  The warp's remap table
+// is built once here.  Statistics describe the frame before these stages.
 // =============================================================================
 
 #include "pch.h"
@@ -32,7 +88,15 @@
 #include <string>
 #include <sstream>
 #include <atomic>
+#include <algorithm>
+#include <memory>
+#include <vector>
 #include "Tools.h"
+#include "FramePipeline.h"
+#include "Orientation.h"
+#include "MjpegPipeline.h"
+#include "Denoise.h"
+#include "Warp.h"
 
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "dxgi.lib")
@@ -40,6 +104,7 @@
 #pragma comment(lib, "mfplat.lib")
 #pragma comment(lib, "mfreadwrite.lib")
 #pragma comment(lib, "mfuuid.lib")
+#pragma comment(lib, "windowscodecs.lib")
 #pragma comment(lib, "advapi32.lib")
 
 using namespace Microsoft::WRL;
@@ -48,18 +113,195 @@ static ComPtr<ID3D11Device> m_d3d11Device;
 static ComPtr<ID3D11Device5> m_d3d11Device5;
 static ComPtr<ID3D11DeviceContext> m_d3d11Context;
 static ComPtr<ID3D11DeviceContext4> m_d3d11Context4;
-static ComPtr<ID3D11Texture2D> m_sharedD3D11Texture;
+static SharedTextureRing m_sharedTextures;
+static UINT m_ringSlots = VirtuaCam::kDefaultRingSlots;
 static ComPtr<ID3D11Fence> m_sharedD3D11Fence;
-static HANDLE m_hSharedTextureHandle = nullptr;
 static HANDLE m_hSharedFenceHandle = nullptr;
 static HANDLE m_hManifest = nullptr;
-static BroadcastManifest* m_pManifestView = nullptr;
+static VirtuaCam::BroadcastManifestV2* m_pManifestView = nullptr;
 static std::atomic<UINT64> m_fenceValue = 0;
 
 static ComPtr<IMFSourceReader> m_sourceReader;
 static long m_videoWidth = 0, m_videoHeight = 0;
 static std::atomic<bool> m_isCapturing = false;
 
+// Native YUV ingest: the subtype the reader delivers (RGB32 on the fallback
+// path), its default stride, colorimetry and the CPU-writable upload texture.
+static GUID m_inputSubtype = GUID_NULL;
+static LONG m_inputStride = 0;
+static UINT m_inputLumaRows = 0;    // NV12: rows in the luma plane (the coded height)
+static VirtuaCam::YuvColorimetry m_inputColorimetry;
+static ComPtr<ID3D11Texture2D> m_uploadTexture;
+
+// MJPEG ingest: WIC decodes on the worker pool, frames come back in order.
+static ComPtr<IWICImagingFactory> m_wicFactory;
+static std::unique_ptr<VirtuaCam::MjpegPipeline> m_mjpegPipeline;
+
+// --mirror / --rotate / --crop / --size, and the size of the published
+// (cropped, scaled, oriented) frame.
+static VirtuaCam::Orientation m_orientation;
+static UINT m_cropX = 0, m_cropY = 0, m_cropWidth = 0, m_cropHeight = 0;
+static UINT m_scaleWidth = 0, m_scaleHeight = 0;
+static UINT m_outputWidth = 0, m_outputHeight = 0;
+
+// The fused per-frame CPU pass, and whether frames go through it into the
+// upload texture (always for YUV; for RGB32 / MJPEG only when there is
+// something to do).  MJPEG decodes with m_decodeOrientation into frames of
+// the decode size: oriented output size, or the camera size when the
+// pipeline runs at publish.
+static VirtuaCam::FramePipeline m_framePipeline;
+static bool m_runPipeline = false;
+static VirtuaCam::Orientation m_decodeOrientation;
+
+// --stats: statistics of the last frame published through the pipeline.
+static bool m_collectStats = false;
+static VirtuaCam::FrameStats m_frameStats;
+
+// --denoise and --keystone / --lens / --zoom: stages run on the pipeline's
+// output, which is then written to m_stageFrame instead of the upload texture.
+static float m_denoiseStrength = 0.0f;
+static VirtuaCam::TemporalDenoise m_denoise;
+static VirtuaCam::WarpDesc m_warpDesc;
+static VirtuaCam::Warp m_warp;
+static std::vector<uint8_t> m_stageFrame;
+
+static bool HasOutputStages()
+{
+    return m_denoise.IsConfigured() || m_warp.IsConfigured();
+}
+
+// Runs the output stages on m_stageFrame; the last one writes 'dst'.
+static void RunOutputStages(BYTE* dst, ptrdiff_t dstStride)
+{
+    BYTE* frame = m_stageFrame.data();
+    const ptrdiff_t stride = (ptrdiff_t)m_outputWidth * 4;
+    if (m_denoise.IsConfigured()) {
+        if (m_warp.IsConfigured())
+            m_denoise.ApplyParallel(frame, stride, frame, stride);
+        else
+            m_denoise.ApplyParallel(frame, stride, dst, dstStride);
+    }
+    if (m_warp.IsConfigured())
+        m_warp.ApplyParallel(frame, stride, dst, dstStride);
+}
+
+static bool IsNativeYuvSubtype(REFGUID subtype)
+{
+    return subtype == MFVideoFormat_NV12 || subtype == MFVideoFormat_YUY2 || subtype == MFVideoFormat_UYVY;
+}
+
+static VirtuaCam::PixelFormat SourcePixelFormat(REFGUID subtype)
+{
+    if (subtype == MFVideoFormat_NV12) return VirtuaCam::PixelFormat::NV12;
+    if (subtype == MFVideoFormat_YUY2) return VirtuaCam::PixelFormat::YUY2;
+    if (subtype == MFVideoFormat_UYVY) return VirtuaCam::PixelFormat::UYVY;
+    return VirtuaCam::PixelFormat::BGRA;    // RGB32, and decoded MJPEG
+}
+
+// Runs one frame (top-down, 'pitch' bytes per row; 'chroma' is the NV12 UV
+// plane) through m_framePipeline into the upload texture and copies that to
+// 'target', the shared texture (ring slot) being written.
+static bool UploadThroughPipeline(ID3D11Texture2D* target, const BYTE* src, LONG pitch, const BYTE* chroma)
+{
+    D3D11_MAPPED_SUBRESOURCE mapped{};
+    if (FAILED(m_d3d11Context->Map(m_uploadTexture.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return false;
+    VirtuaCam::ImagePlanes in, out;
+    in.plane[0] = const_cast<BYTE*>(src); in.stride[0] = pitch;
+    in.plane[1] = const_cast<BYTE*>(chroma); in.stride[1] = pitch;
+    out.plane[0] = static_cast<BYTE*>(mapped.pData); out.stride[0] = mapped.RowPitch;
+    if (HasOutputStages()) {
+        out.plane[0] = m_stageFrame.data(); out.stride[0] = (ptrdiff_t)m_outputWidth * 4;
+    }
+    if (m_collectStats)
+        m_framePipeline.Run(in, out, m_frameStats);
+    else
+        m_framePipeline.Run(in, out);
+    if (HasOutputStages())
+        RunOutputStages(static_cast<BYTE*>(mapped.pData), mapped.RowPitch);
+    m_d3d11Context->Unmap(m_uploadTexture.Get(), 0);
+    m_d3d11Context->CopyResource(target, m_uploadTexture.Get());
+    return true;
+}
+
+// Pool threads are not otherwise COM threads, so each decode joins the MTA
+// for its duration (a thread already in an STA keeps it; WIC is free-threaded).
+// Scoped per decode rather than per thread: a thread_local would leave the
+// CoUninitialize to thread exit, which can happen inside DllMain.
+struct ComApartment {
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    ~ComApartment() { if (SUCCEEDED(hr)) CoUninitialize(); }
+};
+
+// MjpegPipeline::DecodeFn backed by WIC; runs on pool threads.  'bgra' has the
+// decode size; with a transform the decoder is drained in row strips that
+// are stored oriented straight from a small scratch buffer.
+static bool DecodeJpegWic(const uint8_t* jpeg, size_t size, uint8_t* bgra, ptrdiff_t stride)
+{
+    ComApartment apartment;
+
+    ComPtr<IWICStream> stream;
+    if (FAILED(m_wicFactory->CreateStream(&stream))) return false;
+    if (FAILED(stream->InitializeFromMemory(const_cast<BYTE*>(jpeg), (DWORD)size))) return false;
+    ComPtr<IWICBitmapDecoder> decoder;
+    if (FAILED(m_wicFactory->CreateDecoderFromStream(stream.Get(), &GUID_ContainerFormatJpeg, WICDecodeMetadataCacheOnDemand, &decoder))) return false;
+    ComPtr<IWICBitmapFrameDecode> frame;
+    if (FAILED(decoder->GetFrame(0, &frame))) return false;
+
+    UINT width = 0, height = 0;
+    if (FAILED(frame->GetSize(&width, &height)) || width != (UINT)m_videoWidth || height != (UINT)m_videoHeight) return false;
+
+    ComPtr<IWICBitmapSource> converted;
+    if (FAILED(WICConvertBitmapSource(GUID_WICPixelFormat32bppBGRA, frame.Get(), &converted))) return false;
+    if (m_decodeOrientation.IsIdentity())
+        return SUCCEEDED(converted->CopyPixels(nullptr, (UINT)stride, (UINT)(stride * height), bgra));
+
+    thread_local std::vector<uint8_t> strip;
+    const UINT stripStride = width * 4;
+    strip.resize((size_t)stripStride * VirtuaCam::kOrientChunkRows);
+    for (UINT y = 0; y < height; y += VirtuaCam::kOrientChunkRows) {
+        const UINT rows = std::min<UINT>(VirtuaCam::kOrientChunkRows, height - y);
+        const WICRect rect = { 0, (INT)y, (INT)width, (INT)rows };
+        if (FAILED(converted->CopyPixels(&rect, stripStride, stripStride * rows, strip.data()))) return false;
+        VirtuaCam::WriteOrientedRows(strip.data(), stripStride, width, height, y, y + rows, bgra, stride, m_decodeOrientation);
+    }
+    return true;
+}
+
+// Publishes the frame written since m_sharedTextures.BeginWrite().  'arrival'
+// is the QPC time ReadSample returned the sample, 'duration' its duration in
+// QPC ticks (0 if unknown).
+static void SignalFrame(LONGLONG arrival, LONGLONG duration)
+{
+    UINT64 newFenceValue = m_fenceValue.fetch_add(1) + 1;
+    m_d3d11Context4->Signal(m_sharedD3D11Fence.Get(), newFenceValue);
+    m_sharedTextures.EndWrite(newFenceValue);
+    if (m_pManifestView) {
+        // Statistics first, so a reader that sees the frame finds them too.
+        if (m_collectStats && m_frameStats.pixelCount)
+            VirtuaCam::PublishFrameStats(*m_pManifestView, VirtuaCam::SummarizeFrameStats(m_frameStats, newFenceValue));
+        VirtuaCam::ManifestFrameInfo info = ManifestFrameNow(newFenceValue, m_outputWidth, m_outputHeight, DXGI_FORMAT_B8G8R8A8_UNORM);
+        info.captureTime = arrival;
+        info.duration = duration;
+        VirtuaCam::PublishFrame(*m_pManifestView, info);
+    }
+}
+
+// MjpegPipeline::ConsumeFn: uploads one decoded frame and publishes it.  The
+// pipeline timestamp and duration are the sample's QPC arrival time and
+// duration (see ProcessFrame), carried with the frame through the pipeline.
+static void PublishDecodedFrame(const uint8_t* bgra, ptrdiff_t stride, int64_t arrival, int64_t duration)
+{
+    ID3D11Texture2D* target = m_sharedTextures.BeginWrite();
+    if (!target) return;    // every ring slot is being read: drop the frame
+    if (!m_runPipeline) {
+        m_d3d11Context->UpdateSubresource(target, 0, NULL, bgra, (UINT)stride, 0);
+    } else if (!UploadThroughPipeline(target, bgra, (LONG)stride, nullptr)) {
+        m_sharedTextures.AbortWrite();
+        return;
+    }
+    SignalFrame(arrival, duration);
+}
+
 HRESULT InitD3D11() {
     UINT flags = D3D11_CREATE_DEVICE_BGRA_SUPPORT;
     RETURN_IF_FAILED(D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, flags, nullptr, 0, D3D11_SDK_VERSION, &m_d3d11Device, nullptr, &m_d3d11Context));
@@ -79,6 +321,31 @@ extern "C" {
         while(iss >> key) {
             if(key == L"--device") {
                 iss >> cameraId;
+            } else if(key == L"--mirror") {
+                int mirror = 0;
+                iss >> mirror;
+                m_orientation.mirror = mirror != 0;
+            } else if(key == L"--rotate") {
+                int degrees = 0;
+                iss >> degrees;
+                RETURN_HR_IF(E_INVALIDARG, !VirtuaCam::RotationFromDegrees(degrees, m_orientation.rotation));
+            } else if(key == L"--crop") {
+                iss >> m_cropX >> m_cropY >> m_cropWidth >> m_cropHeight;
+            } else if(key == L"--size") {
+                iss >> m_scaleWidth >> m_scaleHeight;
+            } else if(key == L"--stats") {
+                m_collectStats = true;
+            } else if(key == L"--keystone") {
+                for (float& c : m_warpDesc.corners) iss >> c;
+            } else if(key == L"--lens") {
+                iss >> m_warpDesc.k1 >> m_warpDesc.k2;
+            } else if(key == L"--zoom") {
+                iss >> m_warpDesc.zoom;
+            } else if(key == L"--denoise") {
+                iss >> m_denoiseStrength;
+            } else if(key == L"--ring") {
+                iss >> m_ringSlots;
+                RETURN_HR_IF(E_INVALIDARG, m_ringSlots < 1 || m_ringSlots > VirtuaCam::kMaxRingSlots);
             }
         }
 
@@ -112,15 +379,22 @@ extern "C" {
         RETURN_IF_FAILED(outputType->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_RGB32));
         
         // Try each native type in turn: first set the reader to that native type
-        // so MF knows the camera's actual capabilities, then ask it to convert to
-        // RGB32.  Stop at the first combination that succeeds.
+        // so MF knows the camera's actual capabilities.  NV12/YUY2/UYVY and MJPEG
+        // are kept as-is (we unpack / decode them ourselves); anything else is
+        // converted to RGB32 by MF.  Stop at the first combination that succeeds.
         for (DWORD i = 0; ; ++i) {
             ComPtr<IMFMediaType> nativeType;
             HRESULT hr = m_sourceReader->GetNativeMediaType((DWORD)MF_SOURCE_READER_FIRST_VIDEO_STREAM, i, &nativeType);
             if (hr == MF_E_NO_MORE_TYPES) break;
             RETURN_IF_FAILED(hr);
 
+            GUID nativeSubtype = GUID_NULL;
+            nativeType->GetGUID(MF_MT_SUBTYPE, &nativeSubtype);
+
             if (SUCCEEDED(m_sourceReader->SetCurrentMediaType((DWORD)MF_SOURCE_READER_FIRST_VIDEO_STREAM, NULL, nativeType.Get()))) {
+                if (IsNativeYuvSubtype(nativeSubtype) || nativeSubtype == MFVideoFormat_MJPG) {
+                    goto found_format;
+                }
                 if (SUCCEEDED(m_sourceReader->SetCurrentMediaType((DWORD)MF_SOURCE_READER_FIRST_VIDEO_STREAM, NULL, outputType.Get()))) {
                     goto found_format;
                 }
@@ -132,13 +406,64 @@ extern "C" {
         ComPtr<IMFMediaType> pCurrentType;
         RETURN_IF_FAILED(m_sourceReader->GetCurrentMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, &pCurrentType));
         MFGetAttributeSize(pCurrentType.Get(), MF_MT_FRAME_SIZE, (UINT32*)&m_videoWidth, (UINT32*)&m_videoHeight);
+        RETURN_IF_FAILED(pCurrentType->GetGUID(MF_MT_SUBTYPE, &m_inputSubtype));
+        // The frame size is the coded size.  A decoder that pads it (1080p in
+        // 1088 rows) reports the picture as the minimum display aperture; the
+        // chroma plane of an NV12 buffer follows the coded rows.
+        m_inputLumaRows = (UINT)m_videoHeight;
+        MFVideoArea aperture = {};
+        if (IsNativeYuvSubtype(m_inputSubtype) &&
+            SUCCEEDED(pCurrentType->GetBlob(MF_MT_MINIMUM_DISPLAY_APERTURE, (UINT8*)&aperture, sizeof(aperture), nullptr)) &&
+            aperture.OffsetX.value == 0 && aperture.OffsetY.value == 0 && aperture.Area.cx == m_videoWidth &&
+            aperture.Area.cy > 0 && aperture.Area.cy < m_videoHeight)
+            m_videoHeight = aperture.Area.cy;
+        m_inputColorimetry = GetYuvColorimetry(pCurrentType.Get(), m_videoWidth, m_videoHeight);
+
+        VirtuaCam::PipelineDesc pipeline;
+        pipeline.srcFormat = SourcePixelFormat(m_inputSubtype);
+        pipeline.srcWidth = (uint32_t)m_videoWidth; pipeline.srcHeight = (uint32_t)m_videoHeight;
+        pipeline.srcColorimetry = m_inputColorimetry;
+        pipeline.cropX = m_cropX; pipeline.cropY = m_cropY;
+        pipeline.cropWidth = m_cropWidth; pipeline.cropHeight = m_cropHeight;
+        pipeline.dstWidth = m_scaleWidth; pipeline.dstHeight = m_scaleHeight;
+        pipeline.orientation = m_orientation;
+        RETURN_HR_IF(E_INVALIDARG, !m_framePipeline.Configure(pipeline));
+        m_outputWidth = m_framePipeline.OutputWidth(); m_outputHeight = m_framePipeline.OutputHeight();
+        const VirtuaCam::PipelineDesc& resolved = m_framePipeline.Desc();
+        const bool cropsOrScales = resolved.cropWidth != (uint32_t)m_videoWidth || resolved.cropHeight != (uint32_t)m_videoHeight ||
+                                   resolved.dstWidth != resolved.cropWidth || resolved.dstHeight != resolved.cropHeight;
+        const bool isMjpeg = m_inputSubtype == MFVideoFormat_MJPG;
+        m_warpDesc.srcWidth = m_outputWidth; m_warpDesc.srcHeight = m_outputHeight;
+        if (!m_warpDesc.IsIdentity())
+            RETURN_HR_IF(E_INVALIDARG, !m_warp.Configure(m_warpDesc));
+        m_denoise.Configure(m_outputWidth, m_outputHeight, m_denoiseStrength);
+        if (HasOutputStages())
+            m_stageFrame.resize((size_t)m_outputWidth * m_outputHeight * 4);
+        m_runPipeline = IsNativeYuvSubtype(m_inputSubtype) || cropsOrScales || m_collectStats || HasOutputStages() ||
+                        (!isMjpeg && !m_orientation.IsIdentity());
+        m_decodeOrientation = m_runPipeline ? VirtuaCam::Orientation{} : m_orientation;
+
+        if (IsNativeYuvSubtype(m_inputSubtype) && FAILED(pCurrentType->GetUINT32(MF_MT_DEFAULT_STRIDE, (UINT32*)&m_inputStride))) {
+            RETURN_IF_FAILED(MFGetStrideForBitmapInfoHeader(m_inputSubtype.Data1, m_videoWidth, &m_inputStride));
+        }
+        if (m_inputSubtype == MFVideoFormat_MJPG) {
+            RETURN_IF_FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&m_wicFactory)));
+            const UINT decodeWidth = m_runPipeline ? (UINT)m_videoWidth : m_outputWidth;
+            const UINT decodeHeight = m_runPipeline ? (UINT)m_videoHeight : m_outputHeight;
+            m_mjpegPipeline = std::make_unique<VirtuaCam::MjpegPipeline>(decodeWidth, decodeHeight, DecodeJpegWic);
+        }
 
         D3D11_TEXTURE2D_DESC td{};
-        td.Width = m_videoWidth; td.Height = m_videoHeight; td.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+        td.Width = m_outputWidth; td.Height = m_outputHeight; td.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
         td.MipLevels = 1; td.ArraySize = 1; td.SampleDesc.Count = 1; td.Usage = D3D11_USAGE_DEFAULT;
         td.BindFlags = D3D11_BIND_SHADER_RESOURCE;
         td.MiscFlags = D3D11_RESOURCE_MISC_SHARED_NTHANDLE | D3D11_RESOURCE_MISC_SHARED;
-        RETURN_IF_FAILED(m_d3d11Device->CreateTexture2D(&td, nullptr, &m_sharedD3D11Texture));
+        // Frames written by m_framePipeline go through a CPU-writable texture.
+        if (m_runPipeline) {
+            D3D11_TEXTURE2D_DESC ud = td;
+            ud.Usage = D3D11_USAGE_DYNAMIC; ud.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE; ud.MiscFlags = 0;
+            RETURN_IF_FAILED(m_d3d11Device->CreateTexture2D(&ud, nullptr, &m_uploadTexture));
+        }
         RETURN_IF_FAILED(m_d3d11Device5->CreateFence(0, D3D11_FENCE_FLAG_SHARED, IID_PPV_ARGS(&m_sharedD3D11Fence)));
 
         DWORD pid = GetCurrentProcessId();
@@ -151,25 +476,17 @@ extern "C" {
         sd.reset(sd_ptr);
         SECURITY_ATTRIBUTES sa = { sizeof(sa), sd.get(), FALSE };
         
-        m_hManifest = CreateFileMappingW(INVALID_HANDLE_VALUE, &sa, PAGE_READWRITE, 0, sizeof(BroadcastManifest), manifestName.c_str());
+        m_hManifest = CreateFileMappingW(INVALID_HANDLE_VALUE, &sa, PAGE_READWRITE, 0, sizeof(VirtuaCam::BroadcastManifestV2), manifestName.c_str());
         if (!m_hManifest) return HRESULT_FROM_WIN32(GetLastError());
-        m_pManifestView = (BroadcastManifest*)MapViewOfFile(m_hManifest, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(BroadcastManifest));
+        m_pManifestView = (VirtuaCam::BroadcastManifestV2*)MapViewOfFile(m_hManifest, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(VirtuaCam::BroadcastManifestV2));
         if (!m_pManifestView) return HRESULT_FROM_WIN32(GetLastError());
 
-        ZeroMemory(m_pManifestView, sizeof(BroadcastManifest));
-        m_pManifestView->width = m_videoWidth; m_pManifestView->height = m_videoHeight;
-        m_pManifestView->format = DXGI_FORMAT_B8G8R8A8_UNORM;
-
         ComPtr<IDXGIDevice> dxgiDevice; m_d3d11Device.As(&dxgiDevice);
         ComPtr<IDXGIAdapter> adapter; dxgiDevice->GetAdapter(&adapter);
         DXGI_ADAPTER_DESC desc; adapter->GetDesc(&desc);
-        m_pManifestView->adapterLuid = desc.AdapterLuid;
-        
-        wcscpy_s(m_pManifestView->textureName, texName.c_str());
-        wcscpy_s(m_pManifestView->fenceName, fenceName.c_str());
+        InitializeManifest(m_pManifestView, m_outputWidth, m_outputHeight, DXGI_FORMAT_B8G8R8A8_UNORM, desc.AdapterLuid, texName, fenceName, m_ringSlots);
 
-        ComPtr<IDXGIResource1> r1; m_sharedD3D11Texture.As(&r1);
-        RETURN_IF_FAILED(r1->CreateSharedHandle(&sa, GENERIC_ALL, texName.c_str(), &m_hSharedTextureHandle));
+        RETURN_IF_FAILED(m_sharedTextures.Create(m_d3d11Device.Get(), td, &sa, texName, m_ringSlots, VirtuaCam::ManifestRing(*m_pManifestView)));
         RETURN_IF_FAILED(m_sharedD3D11Fence->CreateSharedHandle(&sa, GENERIC_ALL, fenceName.c_str(), &m_hSharedFenceHandle));
 
         m_isCapturing = true;
@@ -186,21 +503,79 @@ extern "C" {
         HRESULT hr = m_sourceReader->ReadSample((DWORD)MF_SOURCE_READER_FIRST_VIDEO_STREAM, 0, NULL, &streamFlags, &timestamp, &pSample);
         if (FAILED(hr) || !pSample) return;
 
+        // The sample timestamp is relative to the stream start, so the
+        // manifest records the arrival time on the shared QPC clock instead.
+        LARGE_INTEGER arrival = {};
+        QueryPerformanceCounter(&arrival);
+        LONGLONG sampleDuration = 0;
+        const LONGLONG duration = SUCCEEDED(pSample->GetSampleDuration(&sampleDuration)) ? HnsToQpcTicks(sampleDuration) : 0;
+
         ComPtr<IMFMediaBuffer> pBuffer;
         THROW_IF_FAILED(pSample->ConvertToContiguousBuffer(&pBuffer));
 
-        BYTE* pData = nullptr;
-        DWORD cbCurrentLength = 0;
-        // CPU -> GPU upload.  Stride = width × 4 bytes (BGRA/RGB32).
-        THROW_IF_FAILED(pBuffer->Lock(&pData, NULL, &cbCurrentLength));
-        m_d3d11Context->UpdateSubresource(m_sharedD3D11Texture.Get(), 0, NULL, pData, m_videoWidth * 4, 0);
-        THROW_IF_FAILED(pBuffer->Unlock());
-
-        UINT64 newFenceValue = m_fenceValue.fetch_add(1) + 1;
-        m_d3d11Context4->Signal(m_sharedD3D11Fence.Get(), newFenceValue);
-        if (m_pManifestView) {
-            InterlockedExchange64(reinterpret_cast<volatile LONGLONG*>(&m_pManifestView->frameValue), newFenceValue);
+        if (m_mjpegPipeline) {
+            BYTE* pData = nullptr;
+            DWORD cbCurrentLength = 0;
+            THROW_IF_FAILED(pBuffer->Lock(&pData, NULL, &cbCurrentLength));
+            if (!m_mjpegPipeline->Submit(pData, cbCurrentLength, arrival.QuadPart, duration)) {
+                // Every decode slot is busy: publish the oldest frame to make room.
+                m_mjpegPipeline->Pop(PublishDecodedFrame);
+                m_mjpegPipeline->Submit(pData, cbCurrentLength, arrival.QuadPart, duration);
+            }
+            THROW_IF_FAILED(pBuffer->Unlock());
+            while (m_mjpegPipeline->TryPop(PublishDecodedFrame)) {}
+            return;
+        }
+
+        ID3D11Texture2D* target = m_sharedTextures.BeginWrite();
+        if (!target) return;    // every ring slot is being read: drop the frame
+        auto abortWrite = wil::scope_exit([] { m_sharedTextures.AbortWrite(); });
+
+        if (IsNativeYuvSubtype(m_inputSubtype)) {
+            // Native YUV: prefer the 2D lock, which reports the real pitch, and
+            // fall back to the type's default stride for plain buffers.
+            BYTE* pScan0 = nullptr;
+            LONG pitch = 0;
+            BYTE* pBufferStart = nullptr;
+            DWORD cbBufferLength = 0;
+            ComPtr<IMF2DBuffer2> p2DBuffer;
+            bool locked2D = SUCCEEDED(pBuffer.As(&p2DBuffer)) &&
+                            SUCCEEDED(p2DBuffer->Lock2DSize(MF2DBuffer_LockFlags_Read, &pScan0, &pitch, &pBufferStart, &cbBufferLength));
+            if (!locked2D) {
+                THROW_IF_FAILED(pBuffer->Lock(&pBufferStart, NULL, &cbBufferLength));
+                pScan0 = pBufferStart;
+                pitch = m_inputStride;
+            }
+            auto unlock = wil::scope_exit([&] { if (locked2D) p2DBuffer->Unlock2D(); else pBuffer->Unlock(); });
+
+            // NV12 chroma starts after the coded luma rows, which may extend
+            // past the picture (see m_inputLumaRows).
+            const UINT frameRows = (UINT)m_videoHeight;
+            const size_t available = cbBufferLength - (size_t)(pScan0 - pBufferStart);
+            const UINT lumaRows = m_inputSubtype == MFVideoFormat_NV12 ? m_inputLumaRows : frameRows;
+            size_t required = (size_t)pitch * frameRows;
+            if (m_inputSubtype == MFVideoFormat_NV12)
+                required = (size_t)pitch * lumaRows + (size_t)pitch * ((frameRows + 1) / 2);
+            if (pitch <= 0 || available < required) return;
+
+            if (!UploadThroughPipeline(target, pScan0, pitch, pScan0 + (ptrdiff_t)pitch * lumaRows)) return;
         }
+        else {
+            BYTE* pData = nullptr;
+            DWORD cbCurrentLength = 0;
+            // CPU -> GPU upload.  Stride = width × 4 bytes (BGRA/RGB32).
+            THROW_IF_FAILED(pBuffer->Lock(&pData, NULL, &cbCurrentLength));
+            auto unlock = wil::scope_exit([&] { pBuffer->Unlock(); });
+            if (cbCurrentLength < (DWORD)(m_videoWidth * 4 * m_videoHeight)) return;
+            if (!m_runPipeline) {
+                m_d3d11Context->UpdateSubresource(target, 0, NULL, pData, m_videoWidth * 4, 0);
+            } else if (!UploadThroughPipeline(target, pData, m_videoWidth * 4, nullptr)) {
+                return;
+            }
+        }
+
+        abortWrite.release();
+        SignalFrame(arrival.QuadPart, duration);
     }
 
     PRODUCER_API void ShutdownProducer()
@@ -209,13 +584,27 @@ extern "C" {
 
         if (m_sourceReader) m_sourceReader->Flush(MF_SOURCE_READER_ALL_STREAMS);
         m_sourceReader.Reset();
+        m_mjpegPipeline.reset();    // waits for in-flight decodes
+        VirtuaCam::WorkerPool::Shared().Shutdown();     // before the DLL can be unloaded
+        m_wicFactory.Reset();
         if (m_pManifestView) UnmapViewOfFile(m_pManifestView);
         if (m_hManifest) CloseHandle(m_hManifest);
         m_pManifestView = nullptr; m_hManifest = nullptr;
-        if (m_hSharedTextureHandle) CloseHandle(m_hSharedTextureHandle);
+        m_sharedTextures.Reset();
         if (m_hSharedFenceHandle) CloseHandle(m_hSharedFenceHandle);
-        m_hSharedTextureHandle = nullptr; m_hSharedFenceHandle = nullptr;
-        m_sharedD3D11Fence.Reset(); m_sharedD3D11Texture.Reset();
+        m_hSharedFenceHandle = nullptr;
+        m_sharedD3D11Fence.Reset(); m_uploadTexture.Reset();
+        m_inputSubtype = GUID_NULL;
+        m_inputLumaRows = 0;
+        m_orientation = {};
+        m_cropX = m_cropY = m_cropWidth = m_cropHeight = 0;
+        m_scaleWidth = m_scaleHeight = 0;
+        m_runPipeline = false;
+        m_collectStats = false;
+        m_frameStats.Reset();
+        m_warpDesc = {}; m_warp = {};
+        m_denoiseStrength = 0.0f; m_denoise = {};
+        m_stageFrame.clear(); m_stageFrame.shrink_to_fit();
         
         if(m_d3d11Context) m_d3d11Context->ClearState();
         m_d3d11Context.Reset(); m_d3d11Context4.Reset();
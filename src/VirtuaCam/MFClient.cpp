@@ -3,6 +3,7 @@
 #include "MFClient.h"
 #include "App.h"
 #include "Formats.h"
+#include "WorkerPool.h"
 #include <appmodel.h>
 
 // Live COM object / server-lock count for DllCanUnloadNow().
@@ -511,8 +512,29 @@ HRESULT MFStream::Initialize(IMFMediaSource* source, int index)
                 auto bitrate = (uint32_t)((res.width * res.height * 12 / 8) * (fr.numerator / (float)fr.denominator));
                 nv12Type->SetUINT32(MF_MT_AVG_BITRATE, bitrate);
                 MFSetAttributeRatio(nv12Type.get(), MF_MT_PIXEL_ASPECT_RATIO, 1, 1);
+                // Tag the matrix/range the converter actually produces (see
+                // BrokerClient::ReconfigureFormat) so apps don't re-convert.
+                RETURN_IF_FAILED(SetYuvColorimetry(nv12Type.get(), VirtuaCam::DefaultColorimetry(res.width, res.height)));
                 mediaTypes.push_back(nv12Type);
             }
+
+            for (const auto& sw : g_softwareVideoFormats)
+            {
+                wil::com_ptr_nothrow<IMFMediaType> yuvType;
+                RETURN_IF_FAILED(MFCreateMediaType(&yuvType));
+                yuvType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
+                yuvType->SetGUID(MF_MT_SUBTYPE, sw.subtype);
+                MFSetAttributeSize(yuvType.get(), MF_MT_FRAME_SIZE, res.width, res.height);
+                yuvType->SetUINT32(MF_MT_DEFAULT_STRIDE, res.width * sw.lumaSampleBytes);
+                yuvType->SetUINT32(MF_MT_INTERLACE_MODE, MFVideoInterlace_Progressive);
+                yuvType->SetUINT32(MF_MT_ALL_SAMPLES_INDEPENDENT, TRUE);
+                MFSetAttributeRatio(yuvType.get(), MF_MT_FRAME_RATE, fr.numerator, fr.denominator);
+                auto bitrate = (uint32_t)((res.width * res.height * sw.bitsPerPixel / 8) * (fr.numerator / (float)fr.denominator));
+                yuvType->SetUINT32(MF_MT_AVG_BITRATE, bitrate);
+                MFSetAttributeRatio(yuvType.get(), MF_MT_PIXEL_ASPECT_RATIO, 1, 1);
+                RETURN_IF_FAILED(SetYuvColorimetry(yuvType.get(), VirtuaCam::DefaultColorimetry(res.width, res.height)));
+                mediaTypes.push_back(yuvType);
+            }
         }
     }
     
@@ -556,7 +578,20 @@ HRESULT MFStream::Start(IMFMediaType* type)
         return E_UNEXPECTED;
 	}
 
-	RETURN_IF_FAILED(_allocator->InitializeSampleAllocator(10, type));
+	// CPU-converted formats are still rendered into a BGRA texture first and
+	// delivered in a separate system-memory buffer, so their allocator hands
+	// out BGRA samples.
+	wil::com_ptr_nothrow<IMFMediaType> allocatorType = type;
+	if (type && IsSoftwareVideoFormat(_format))
+	{
+		allocatorType.reset();
+		RETURN_IF_FAILED(MFCreateMediaType(&allocatorType));
+		RETURN_IF_FAILED(type->CopyAllItems(allocatorType.get()));
+		RETURN_IF_FAILED(allocatorType->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_RGB32));
+		RETURN_IF_FAILED(allocatorType->SetUINT32(MF_MT_DEFAULT_STRIDE, _currentWidth * 4));
+	}
+
+	RETURN_IF_FAILED(_allocator->InitializeSampleAllocator(10, allocatorType.get()));
 	RETURN_IF_FAILED(_queue->QueueEventParamVar(MEStreamStarted, GUID_NULL, S_OK, nullptr));
 	_state = MF_STREAM_STATE_RUNNING;
 	return S_OK;
@@ -604,6 +639,11 @@ void MFStream::Shutdown()
 	_descriptor.reset();
 	_source.reset();
 	_attributes.reset();
+
+	// Join the conversion workers now rather than from DllMain once
+	// DllCanUnloadNow() lets the DLL go; RequestSample() holds the same lock.
+	auto lock = _lock.lock_exclusive();
+	VirtuaCam::WorkerPool::Shared().Shutdown();
 }
 
 STDMETHODIMP MFStream::BeginGetEvent(IMFAsyncCallback* pCallback, IUnknown* punkState)
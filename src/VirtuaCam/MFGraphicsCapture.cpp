@@ -5,7 +5,10 @@
 // It captures a target window (or the desktop) using the Windows.Graphics.Capture
 // API (introduced in Windows 10 1803) and forwards frames to the broker.
 //
-// Argument: --hwnd <handle-as-uint64>   (the window to capture)
+// Arguments: --hwnd <handle-as-uint64>   (the window to capture)
+//            --skip-unchanged 0|1         (default 0, see below)
+//            --ring <slots>               (shared texture ring, 2..4, or 1 for a
+//                                          single texture; default 3; TextureRing.h)
 //
 // Windows.Graphics.Capture vs. Desktop Duplication
 // -------------------------------------------------
@@ -28,11 +31,28 @@
 // wrapper).  To get the underlying ID3D11Texture2D we must QI through
 // IDirect3DDxgiInterfaceAccess::GetInterface().  This interface is declared
 // inline here with a guard to avoid double-definition if a newer SDK ships it.
+//
+// Unchanged-frame suppression
+// ---------------------------
+// The frame pool delivers a frame whenever DWM recomposes the window, which
+// is often without any visible change (idle slides, editors).  Each published
+// frame costs the broker a copy, a mip chain and an NV12 conversion, so with
+// --skip-unchanged 1 every captured frame is copied into its ring slot and
+// into one of two rotating staging textures, but only published once the
+// readback has been run through a ChangeDetector (tile hashes).  The readback
+// is polled with D3D11_MAP_FLAG_DO_NOT_WAIT from later ProcessFrame() calls,
+// so the capture thread never stalls on the GPU; an unchanged frame gives its
+// slot back and frameValue is not bumped, and downstream simply keeps the
+// previous frame.  A frame whose readback is still in flight when the next
+// one arrives is published unhashed.  It is off by default: it still costs a
+// full-frame readback per frame, which only pays off for mostly static
+// windows.
 // =============================================================================
 
 #include "pch.h"
 #include "MFGraphicsCapture.h"
 #include "Tools.h"
+#include "ChangeDetector.h"
 #include <wrl.h>
 #include <wrl/wrappers/corewrappers.h>
 #include <sddl.h>
@@ -70,14 +90,27 @@ static ComPtr<ID3D11Device> g_d3d11Device;
 static ComPtr<ID3D11Device5> g_d3d11Device5;
 static ComPtr<ID3D11DeviceContext> g_d3d11Context;
 static ComPtr<ID3D11DeviceContext4> g_d3d11Context4;
-static ComPtr<ID3D11Texture2D> g_sharedD3D11Texture;
+static SharedTextureRing g_sharedTextures;
+static UINT g_ringSlots = VirtuaCam::kDefaultRingSlots;
 static ComPtr<ID3D11Fence> g_sharedD3D11Fence;
-static HANDLE g_hSharedTextureHandle = nullptr;
 static HANDLE g_hSharedFenceHandle = nullptr;
 static HANDLE g_hManifest = nullptr;
-static BroadcastManifest* g_pManifestView = nullptr;
+static VirtuaCam::BroadcastManifestV2* g_pManifestView = nullptr;
 static std::atomic<UINT64> g_fenceValue = 0;
 
+static bool g_skipUnchanged = false;
+static ComPtr<ID3D11Texture2D> g_stagingTextures[2];
+static UINT g_nextStaging = 0;
+static VirtuaCam::ChangeDetector g_changeDetector;
+
+// The frame copied into the claimed ring slot while its readback is pending.
+struct PendingFrame {
+    bool active = false;
+    UINT staging = 0;
+    LONGLONG captureTime = 0;
+};
+static PendingFrame g_pending;
+
 static ComPtr<WGD3D::IDirect3DDevice> g_d3dDevice;
 static ComPtr<WGC::IGraphicsCaptureItem> g_captureItem;
 static ComPtr<WGC::IDirect3D11CaptureFramePool> g_framePool;
@@ -105,6 +138,56 @@ static void CloseWinRTObject(const ComPtr<T>& object)
         closable->Close();
 }
 
+// Publishes the frame written since g_sharedTextures.BeginWrite().  With
+// 'hashed' the change detector's dirty bounds describe it.
+static void SignalFrame(LONGLONG captureTime, bool hashed)
+{
+    UINT64 newFenceValue = g_fenceValue.fetch_add(1) + 1;
+    g_d3d11Context4->Signal(g_sharedD3D11Fence.Get(), newFenceValue);
+    g_sharedTextures.EndWrite(newFenceValue);
+    if (!g_pManifestView) return;
+
+    VirtuaCam::ManifestFrameInfo info = ManifestFrameNow(newFenceValue, g_pManifestView->width,
+                                                         g_pManifestView->height, DXGI_FORMAT_B8G8R8A8_UNORM);
+    info.captureTime = captureTime;
+    if (hashed) {
+        const VirtuaCam::ChangeDetector::Rect dirty = g_changeDetector.DirtyBounds();
+        info.dirtyRegions = g_changeDetector.DirtyCount();
+        info.dirtyLeft = (int32_t)dirty.x;
+        info.dirtyTop = (int32_t)dirty.y;
+        info.dirtyRight = (int32_t)(dirty.x + dirty.width);
+        info.dirtyBottom = (int32_t)(dirty.y + dirty.height);
+    }
+    VirtuaCam::PublishFrame(*g_pManifestView, info);
+}
+
+// Settles the pending frame: published if its readback shows a change, its
+// slot given back if not.  A readback still in flight is left for the next
+// call unless 'force' (a newer frame arrived); the frame then goes out
+// unhashed, as it does if the readback fails, and since the detector never
+// saw it the next frame is forced out too.
+static void ResolvePendingFrame(bool force)
+{
+    if (!g_pending.active) return;
+    ID3D11Texture2D* staging = g_stagingTextures[g_pending.staging].Get();
+    D3D11_MAPPED_SUBRESOURCE mapped{};
+    const HRESULT hr = g_d3d11Context->Map(staging, 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+    if (hr == DXGI_ERROR_WAS_STILL_DRAWING && !force) return;
+
+    g_pending.active = false;
+    if (FAILED(hr)) {
+        g_changeDetector.Invalidate();
+        SignalFrame(g_pending.captureTime, false);
+        return;
+    }
+    const bool changed = g_changeDetector.UpdateParallel(static_cast<const uint8_t*>(mapped.pData), mapped.RowPitch);
+    g_d3d11Context->Unmap(staging, 0);
+    if (changed)
+        SignalFrame(g_pending.captureTime, true);
+    else
+        g_sharedTextures.AbortWrite();
+}
+
 extern "C" {
     PRODUCER_API HRESULT InitializeProducer(const wchar_t* args)
     {
@@ -116,6 +199,13 @@ extern "C" {
                 UINT64 hwnd_val;
                 iss >> hwnd_val;
                 hwndToCapture = reinterpret_cast<HWND>(hwnd_val);
+            } else if(key == L"--skip-unchanged") {
+                int enabled = 1;
+                iss >> enabled;
+                g_skipUnchanged = enabled != 0;
+            } else if(key == L"--ring") {
+                iss >> g_ringSlots;
+                RETURN_HR_IF(E_INVALIDARG, g_ringSlots < 1 || g_ringSlots > VirtuaCam::kMaxRingSlots);
             }
         }
         RETURN_HR_IF_NULL(E_INVALIDARG, hwndToCapture);
@@ -165,9 +255,18 @@ extern "C" {
         td.MipLevels = 1; td.ArraySize = 1; td.SampleDesc.Count = 1; td.Usage = D3D11_USAGE_DEFAULT;
         td.BindFlags = D3D11_BIND_SHADER_RESOURCE;
         td.MiscFlags = D3D11_RESOURCE_MISC_SHARED_NTHANDLE | D3D11_RESOURCE_MISC_SHARED;
-        RETURN_IF_FAILED(g_d3d11Device->CreateTexture2D(&td, nullptr, &g_sharedD3D11Texture));
         RETURN_IF_FAILED(g_d3d11Device5->CreateFence(0, D3D11_FENCE_FLAG_SHARED, IID_PPV_ARGS(&g_sharedD3D11Fence)));
 
+        if (g_skipUnchanged) {
+            D3D11_TEXTURE2D_DESC stagingDesc = td;
+            stagingDesc.Usage = D3D11_USAGE_STAGING; stagingDesc.BindFlags = 0; stagingDesc.MiscFlags = 0;
+            stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+            for (auto& staging : g_stagingTextures)
+                RETURN_IF_FAILED(g_d3d11Device->CreateTexture2D(&stagingDesc, nullptr, &staging));
+            g_changeDetector.Configure(size.Width, size.Height);
+            g_changeDetector.Invalidate();
+        }
+
         DWORD pid = GetCurrentProcessId();
         std::wstring manifestName = L"DirectPort_Producer_Manifest_" + std::to_wstring(pid);
         std::wstring texName = L"Local\\DirectPortTexture_" + std::to_wstring(pid);
@@ -178,24 +277,16 @@ extern "C" {
         sd.reset(sd_ptr);
         SECURITY_ATTRIBUTES sa = { sizeof(sa), sd.get(), FALSE };
 
-        g_hManifest = CreateFileMappingW(INVALID_HANDLE_VALUE, &sa, PAGE_READWRITE, 0, sizeof(BroadcastManifest), manifestName.c_str());
+        g_hManifest = CreateFileMappingW(INVALID_HANDLE_VALUE, &sa, PAGE_READWRITE, 0, sizeof(VirtuaCam::BroadcastManifestV2), manifestName.c_str());
         if (!g_hManifest) return HRESULT_FROM_WIN32(GetLastError());
-        g_pManifestView = (BroadcastManifest*)MapViewOfFile(g_hManifest, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(BroadcastManifest));
+        g_pManifestView = (VirtuaCam::BroadcastManifestV2*)MapViewOfFile(g_hManifest, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(VirtuaCam::BroadcastManifestV2));
         if (!g_pManifestView) return HRESULT_FROM_WIN32(GetLastError());
 
-        ZeroMemory(g_pManifestView, sizeof(BroadcastManifest));
-        g_pManifestView->width = size.Width; g_pManifestView->height = size.Height;
-        g_pManifestView->format = DXGI_FORMAT_B8G8R8A8_UNORM;
-
         ComPtr<IDXGIAdapter> adapter; dxgiDevice->GetAdapter(&adapter);
         DXGI_ADAPTER_DESC desc; adapter->GetDesc(&desc);
-        g_pManifestView->adapterLuid = desc.AdapterLuid;
+        InitializeManifest(g_pManifestView, size.Width, size.Height, DXGI_FORMAT_B8G8R8A8_UNORM, desc.AdapterLuid, texName, fenceName, g_ringSlots);
 
-        wcscpy_s(g_pManifestView->textureName, texName.c_str());
-        wcscpy_s(g_pManifestView->fenceName, fenceName.c_str());
-
-        ComPtr<IDXGIResource1> r1; g_sharedD3D11Texture.As(&r1);
-        RETURN_IF_FAILED(r1->CreateSharedHandle(&sa, GENERIC_ALL, texName.c_str(), &g_hSharedTextureHandle));
+        RETURN_IF_FAILED(g_sharedTextures.Create(g_d3d11Device.Get(), td, &sa, texName, g_ringSlots, VirtuaCam::ManifestRing(*g_pManifestView)));
         RETURN_IF_FAILED(g_sharedD3D11Fence->CreateSharedHandle(&sa, GENERIC_ALL, fenceName.c_str(), &g_hSharedFenceHandle));
 
         RETURN_IF_FAILED(g_session->StartCapture());
@@ -206,6 +297,7 @@ extern "C" {
     PRODUCER_API void ProcessFrame()
     {
         if (!g_isCapturing || !g_framePool) return;
+        ResolvePendingFrame(false);
 
         // TryGetNextFrame() is non-blocking — returns null if no new frame
         // is ready yet.  The caller (Process.cpp) re-polls every ~1 ms.
@@ -226,15 +318,33 @@ extern "C" {
             if (SUCCEEDED(surface.As(&surfaceAccess)))
             {
                 ComPtr<ID3D11Texture2D> frameTexture;
+                ID3D11Texture2D* target = nullptr;
                 if (SUCCEEDED(surfaceAccess->GetInterface(IID_PPV_ARGS(&frameTexture))))
                 {
-                    g_d3d11Context->CopyResource(g_sharedD3D11Texture.Get(), frameTexture.Get());
-
-                    UINT64 newFenceValue = g_fenceValue.fetch_add(1) + 1;
-                    g_d3d11Context4->Signal(g_sharedD3D11Fence.Get(), newFenceValue);
-
-                    if (g_pManifestView) {
-                        InterlockedExchange64(reinterpret_cast<volatile LONGLONG*>(&g_pManifestView->frameValue), newFenceValue);
+                    ResolvePendingFrame(true);
+                    // Null if every ring slot is being read: drop the frame, and
+                    // make sure the next one goes out even if it looks unchanged.
+                    target = g_sharedTextures.BeginWrite();
+                    if (!target) g_changeDetector.Invalidate();
+                }
+                if (target)
+                {
+                    g_d3d11Context->CopyResource(target, frameTexture.Get());
+
+                    // SystemRelativeTime is the compositor's QPC time in 100-ns units.
+                    LONGLONG captureTime = 0;
+                    ABI::Windows::Foundation::TimeSpan captured{};
+                    if (SUCCEEDED(frame->get_SystemRelativeTime(&captured)) && captured.Duration > 0)
+                        captureTime = HnsToQpcTicks(captured.Duration);
+
+                    if (g_skipUnchanged) {
+                        // Publish once the readback shows a change (ResolvePendingFrame).
+                        g_d3d11Context->CopyResource(g_stagingTextures[g_nextStaging].Get(), frameTexture.Get());
+                        g_d3d11Context->Flush();
+                        g_pending = { true, g_nextStaging, captureTime };
+                        g_nextStaging = (g_nextStaging + 1) % ARRAYSIZE(g_stagingTextures);
+                    } else {
+                        SignalFrame(captureTime, false);
                     }
                 }
             }
@@ -258,11 +368,16 @@ extern "C" {
         if (g_hManifest) CloseHandle(g_hManifest);
         g_pManifestView = nullptr; g_hManifest = nullptr;
 
-        if (g_hSharedTextureHandle) CloseHandle(g_hSharedTextureHandle);
+        if (g_pending.active) g_sharedTextures.AbortWrite();
+        g_pending = {};
+        g_sharedTextures.Reset();
         if (g_hSharedFenceHandle) CloseHandle(g_hSharedFenceHandle);
-        g_hSharedTextureHandle = nullptr; g_hSharedFenceHandle = nullptr;
+        g_hSharedFenceHandle = nullptr;
 
-        g_sharedD3D11Fence.Reset(); g_sharedD3D11Texture.Reset();
+        g_sharedD3D11Fence.Reset();
+        for (auto& staging : g_stagingTextures) staging.Reset();
+        g_nextStaging = 0;
+        VirtuaCam::WorkerPool::Shared().Shutdown();     // before the DLL can be unloaded
 
         if(g_d3d11Context) g_d3d11Context->ClearState();
         g_d3d11Context4.Reset();
@@ -0,0 +1,183 @@
+// =============================================================================
+// Manifest.cpp  --  Producer manifest layouts (v1 and v2) and the v2 seqlock
+// =============================================================================
+// See Manifest.h for the layouts and the seqlock protocol.
+// =============================================================================
+
+#include "Manifest.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include "FrameStats.h"
+
+namespace VirtuaCam {
+
+namespace {
+
+// The seqlock protocol of Manifest.h over 'count' record words.
+void WriteSeqlocked(std::atomic<uint64_t>& sequence, std::atomic<uint64_t>* words, const uint64_t* values,
+                    size_t count)
+{
+    const uint64_t before = sequence.load(std::memory_order_relaxed);
+    sequence.store(before + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < count; ++i)
+        words[i].store(values[i], std::memory_order_relaxed);
+    sequence.store(before + 2, std::memory_order_release);
+}
+
+bool ReadSeqlocked(const std::atomic<uint64_t>& sequence, const std::atomic<uint64_t>* words, uint64_t* values,
+                   size_t count)
+{
+    for (int attempt = 0; attempt < kMaxReadAttempts; ++attempt)
+    {
+        const uint64_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1)
+        {
+            // Mid-update: the writer holds it for a few stores.  Yield now
+            // and then in case it was preempted.
+            if ((attempt & 7) == 7)
+                std::this_thread::yield();
+            continue;
+        }
+        for (size_t i = 0; i < count; ++i)
+            values[i] = words[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before)
+            return true;
+    }
+    return false;
+}
+
+}
+
+uint32_t ManifestVersion(const void* data, size_t bytes)
+{
+    if (!data || bytes < sizeof(BroadcastManifestV1))
+        return 0;
+    const auto* v2 = static_cast<const BroadcastManifestV2*>(data);
+    if (bytes >= kManifestV2MinSize &&
+        v2->magic.load(std::memory_order_acquire) == kManifestMagic &&
+        v2->version == kManifestVersion && v2->size >= kManifestV2MinSize && v2->size <= bytes)
+        return 2;
+    return 1;
+}
+
+void InitializeManifest(BroadcastManifestV2& manifest, uint32_t width, uint32_t height, uint32_t format,
+                        ManifestLuid adapterLuid, uint64_t timestampFrequency,
+                        const char16_t* textureName, const char16_t* fenceName, uint32_t ringSlots,
+                        uint32_t processId)
+{
+    manifest.version = kManifestVersion;
+    manifest.size = sizeof(BroadcastManifestV2);
+    manifest.width = width;
+    manifest.height = height;
+    manifest.format = format;
+    manifest.adapterLuid = adapterLuid;
+    manifest.timestampFrequency = timestampFrequency;
+
+    auto copyName = [](char16_t* dst, const char16_t* src)
+    {
+        size_t i = 0;
+        for (; src && src[i] && i + 1 < kManifestNameChars; ++i)
+            dst[i] = src[i];
+        dst[i] = 0;
+    };
+    copyName(manifest.textureName, textureName);
+    copyName(manifest.fenceName, fenceName);
+    if (ringSlots > 1)
+        InitializeRing(manifest.ring, ringSlots);
+    manifest.processId = processId;
+    // A mapping kept open by readers is reused when the producer restarts.
+    manifest.stopped.store(0, std::memory_order_relaxed);
+
+    // Readers check the magic first; everything above is visible once it is.
+    manifest.magic.store(kManifestMagic, std::memory_order_release);
+}
+
+void PublishFrame(BroadcastManifestV2& manifest, const ManifestFrameInfo& info)
+{
+    uint64_t words[BroadcastManifestV2::kFrameWords] = {};
+    std::memcpy(words, &info, sizeof(info));
+    WriteSeqlocked(manifest.sequence, manifest.frameWords, words, BroadcastManifestV2::kFrameWords);
+    manifest.frameValue.store(info.frameValue, std::memory_order_release);
+}
+
+TextureRingState* ManifestRing(BroadcastManifestV2& manifest)
+{
+    if (manifest.size < kManifestV2RingSize || !RingSlotCount(manifest.ring))
+        return nullptr;
+    return &manifest.ring;
+}
+
+uint32_t ManifestProcessId(const BroadcastManifestV2& manifest)
+{
+    return manifest.size >= kManifestV2LivenessSize ? manifest.processId : 0;
+}
+
+void MarkManifestStopped(BroadcastManifestV2& manifest)
+{
+    manifest.stopped.store(1, std::memory_order_release);
+}
+
+bool ManifestStopped(const BroadcastManifestV2& manifest)
+{
+    return manifest.size >= kManifestV2LivenessSize && manifest.stopped.load(std::memory_order_acquire) != 0;
+}
+
+bool ReadFrameInfo(const BroadcastManifestV2& manifest, ManifestFrameInfo& info)
+{
+    uint64_t words[BroadcastManifestV2::kFrameWords];
+    if (!ReadSeqlocked(manifest.sequence, manifest.frameWords, words, BroadcastManifestV2::kFrameWords))
+        return false;
+    std::memcpy(&info, words, sizeof(info));
+    return true;
+}
+
+ManifestFrameStats SummarizeFrameStats(const FrameStats& stats, uint64_t frameValue)
+{
+    auto fixed88 = [](double value) { return (uint16_t)std::clamp(std::lround(value * 256.0), 0l, 65535l); };
+    auto fraction = [&](uint64_t count)
+    {
+        return (uint16_t)(stats.pixelCount ? count * 65535 / stats.pixelCount : 0);
+    };
+    ManifestFrameStats summary;
+    summary.frameValue = frameValue;
+    summary.meanLuma = fixed88(stats.MeanLuma());
+    summary.meanBlue = fixed88(stats.MeanBlue());
+    summary.meanGreen = fixed88(stats.MeanGreen());
+    summary.meanRed = fixed88(stats.MeanRed());
+    summary.lumaMin = stats.LumaMin();
+    summary.lumaMax = stats.LumaMax();
+    summary.lumaLow = stats.LumaPercentile(0.01);
+    summary.lumaHigh = stats.LumaPercentile(0.99);
+    summary.clippedLow = fraction(stats.clippedLow);
+    summary.clippedHigh = fraction(stats.clippedHigh);
+    return summary;
+}
+
+void PublishFrameStats(BroadcastManifestV2& manifest, const ManifestFrameStats& stats)
+{
+    if (manifest.size < sizeof(BroadcastManifestV2))
+        return;
+    uint64_t words[BroadcastManifestV2::kStatsWords] = {};
+    std::memcpy(words, &stats, sizeof(stats));
+    WriteSeqlocked(manifest.statsSequence, manifest.statsWords, words, BroadcastManifestV2::kStatsWords);
+}
+
+bool ReadFrameStats(const BroadcastManifestV2& manifest, ManifestFrameStats& stats)
+{
+    uint64_t words[BroadcastManifestV2::kStatsWords];
+    if (manifest.size < sizeof(BroadcastManifestV2) ||
+        !ReadSeqlocked(manifest.statsSequence, manifest.statsWords, words, BroadcastManifestV2::kStatsWords))
+        return false;
+    ManifestFrameStats snapshot;
+    std::memcpy(&snapshot, words, sizeof(snapshot));
+    if (!snapshot.frameValue)
+        return false;
+    stats = snapshot;
+    return true;
+}
+
+}
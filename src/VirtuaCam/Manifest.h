@@ -0,0 +1,206 @@
+// =============================================================================
+// Manifest.h  --  Producer manifest layouts (v1 and v2) and the v2 seqlock
+// =============================================================================
+// Every producer (and the broker, for its output) publishes a small named
+// mapping describing its shared texture and fence and carrying the latest
+// frame counter.  Readers poll the counter every frame.
+//
+// v1 (BroadcastManifestV1, the original BroadcastManifest in Tools.h) has no
+// header, keeps the hot counter on the same cache line as the description,
+// and gives readers no way to see the frame counter together with the frame's
+// size or format.  v2 fixes all three:
+//
+//   cache line 0   magic, version, size, description     written once, before
+//                                                         the producer registers
+//   cache line 1   frameValue                            the hot counter, alone
+//   cache line 2   sequence + ManifestFrameInfo          seqlock, per frame
+//   then           textureName / fenceName                written once
+//   then           TextureRingState (TextureRing.h)      slot accounting when
+//                                                         the texture is a ring
+//   then           processId, stopped                    liveness
+//   then           statsSequence + ManifestFrameStats    seqlock, optional
+//
+// Writing a frame: sequence goes odd, the record words are stored, sequence
+// goes even, then frameValue is released.  A reader that sees frameValue N
+// therefore finds a record for frame N or newer.  Reading the record: load
+// the sequence (acquire), retry while odd, load the words, fence, re-load the
+// sequence and retry if it moved.  The record is stored as relaxed atomic
+// words, so the retry protocol is race-free in the C++ memory model.  A
+// writer that dies mid-update leaves the sequence odd forever, so readers
+// give up after a bounded number of attempts instead of spinning.
+//
+// Fields appended later are covered by 'size': a reader only trusts what lies
+// within it (ManifestRing() returns null for an older v2 producer).
+//
+// A reader that keeps the mapping open keeps it alive after the producer
+// exits, so the mapping itself says nothing about liveness.  The producer
+// therefore records its process ID (readers wait on the process to catch a
+// crash) and sets 'stopped' when it shuts down cleanly.
+//
+// Producers that gather image statistics (FrameStats.h; the camera with
+// --stats) publish a summary of them per frame under a second seqlock, for
+// exposure matching and source health.  Its frameValue is the frame it
+// describes, so a reader can tell whether it matches the frame it copied.
+//
+// v1 stays readable: its offset 0 is the frame counter, which never reaches
+// kManifestMagic, so ManifestVersion() tells the two apart from the mapping
+// alone.
+//
+// This header (and Manifest.cpp) deliberately has no Windows dependency.
+// =============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "TextureRing.h"
+
+namespace VirtuaCam {
+
+struct FrameStats;
+
+constexpr uint64_t kManifestMagic = 0x32464E4D54504456ull;    // "VDPTMNF2"
+constexpr uint32_t kManifestVersion = 2;
+constexpr size_t kManifestNameChars = 256;
+
+struct ManifestLuid {
+    uint32_t lowPart;
+    int32_t highPart;
+};
+
+// The original layout, bit-for-bit (Tools.h asserts it against
+// BroadcastManifest).  Still produced by older builds.
+struct BroadcastManifestV1 {
+    uint64_t frameValue;
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;                        // DXGI_FORMAT
+    ManifestLuid adapterLuid;
+    char16_t textureName[kManifestNameChars];
+    char16_t fenceName[kManifestNameChars];
+    uint32_t command;                       // VCamCommand
+};
+
+// Per-frame record.  Times are QPC ticks (BroadcastManifestV2::
+// timestampFrequency per second); 0 means unknown.
+struct ManifestFrameInfo {
+    uint64_t frameValue = 0;        // fence value of the frame this describes
+    int64_t captureTime = 0;        // when the frame was captured (or arrived)
+    int64_t duration = 0;           // nominal frame duration
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t format = 0;            // DXGI_FORMAT
+    uint32_t dirtyRegions = 0;      // changed regions (tiles); 0 = whole frame / unknown
+    int32_t dirtyLeft = 0;          // union of the changed regions, in pixels
+    int32_t dirtyTop = 0;
+    int32_t dirtyRight = 0;
+    int32_t dirtyBottom = 0;
+};
+
+// Summary of a frame's FrameStats.  Means are 8.8 fixed point (0..255),
+// clipped counts a fraction of the pixels in 1/65535 units.
+struct ManifestFrameStats {
+    uint64_t frameValue = 0;        // frame these describe; 0 = none published
+    uint16_t meanLuma = 0;
+    uint16_t meanBlue = 0;
+    uint16_t meanGreen = 0;
+    uint16_t meanRed = 0;
+    uint8_t lumaMin = 0;
+    uint8_t lumaMax = 0;
+    uint8_t lumaLow = 0;            // 1st percentile (auto-levels black point)
+    uint8_t lumaHigh = 0;           // 99th percentile (white point)
+    uint16_t clippedLow = 0;
+    uint16_t clippedHigh = 0;
+};
+
+struct alignas(64) BroadcastManifestV2 {
+    static constexpr size_t kFrameWords = (sizeof(ManifestFrameInfo) + 7) / 8;
+    static constexpr size_t kStatsWords = (sizeof(ManifestFrameStats) + 7) / 8;
+
+    // Cache line 0: header and read-mostly description.
+    std::atomic<uint64_t> magic;            // kManifestMagic once initialised
+    uint32_t version;
+    uint32_t size;                          // sizeof(BroadcastManifestV2)
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;                        // DXGI_FORMAT
+    ManifestLuid adapterLuid;
+    uint64_t timestampFrequency;            // QPC ticks per second
+    std::atomic<uint32_t> command;          // VCamCommand
+
+    // Cache line 1: the counter readers poll every frame.
+    alignas(64) std::atomic<uint64_t> frameValue;
+
+    // Cache line 2: seqlock-protected ManifestFrameInfo.
+    alignas(64) std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> frameWords[kFrameWords];
+
+    alignas(64) char16_t textureName[kManifestNameChars];
+    char16_t fenceName[kManifestNameChars];
+
+    // Texture ring; slotCount 0 for a single texture named textureName.
+    alignas(64) TextureRingState ring;
+
+    // Liveness: the publishing process, and nonzero once it has stopped.
+    alignas(64) uint32_t processId;
+    std::atomic<uint32_t> stopped;
+
+    // Seqlock-protected ManifestFrameStats.
+    alignas(64) std::atomic<uint64_t> statsSequence;
+    std::atomic<uint64_t> statsWords[kStatsWords];
+};
+
+// Smallest v2 manifest (before the ring was appended), and the smallest ones
+// holding a ring and the liveness fields.
+constexpr size_t kManifestV2MinSize = offsetof(BroadcastManifestV2, ring);
+constexpr size_t kManifestV2RingSize = offsetof(BroadcastManifestV2, processId);
+constexpr size_t kManifestV2LivenessSize = offsetof(BroadcastManifestV2, statsSequence);
+
+static_assert(sizeof(BroadcastManifestV2::frameWords) + 8 <= 64, "the frame record must fit one cache line");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "manifest words must be lock-free to be shared across processes");
+
+// 0 if 'bytes' at 'data' hold neither layout, else 1 or 2.
+uint32_t ManifestVersion(const void* data, size_t bytes);
+
+// Fills the description of a zero-filled v2 manifest and stamps the header
+// last.  Names are NUL-terminated and truncated to kManifestNameChars - 1.
+// 'ringSlots' > 1 sets up a texture ring (see RingTextureName in Tools.h
+// for the slot textures' names).  'processId' is the producer's own.
+void InitializeManifest(BroadcastManifestV2& manifest, uint32_t width, uint32_t height, uint32_t format,
+                        ManifestLuid adapterLuid, uint64_t timestampFrequency,
+                        const char16_t* textureName, const char16_t* fenceName, uint32_t ringSlots = 0,
+                        uint32_t processId = 0);
+
+// Writes the frame record under the seqlock, then releases
+// info.frameValue as the new frame counter.  Single writer per manifest.
+void PublishFrame(BroadcastManifestV2& manifest, const ManifestFrameInfo& info);
+
+// The manifest's texture ring, or null if the producer predates it or
+// publishes a single texture.
+TextureRingState* ManifestRing(BroadcastManifestV2& manifest);
+
+// The producer's process ID, or 0 if it predates the liveness fields.
+uint32_t ManifestProcessId(const BroadcastManifestV2& manifest);
+
+// Set by the producer as it stops publishing, before it unmaps the manifest.
+void MarkManifestStopped(BroadcastManifestV2& manifest);
+bool ManifestStopped(const BroadcastManifestV2& manifest);
+
+// The summary of 'stats' published for frame 'frameValue'.
+ManifestFrameStats SummarizeFrameStats(const FrameStats& stats, uint64_t frameValue);
+
+// Writes the statistics record under its seqlock; publish it before the
+// frame it describes.  Single writer per manifest.
+void PublishFrameStats(BroadcastManifestV2& manifest, const ManifestFrameStats& stats);
+
+// Consistent snapshot of the latest statistics.  False if the producer
+// publishes none (or predates them) or kept the record busy.
+bool ReadFrameStats(const BroadcastManifestV2& manifest, ManifestFrameStats& stats);
+
+// Consistent snapshot of the latest frame record.  False if the writer kept
+// it busy for kMaxReadAttempts tries (or died mid-update).
+constexpr int kMaxReadAttempts = 64;
+bool ReadFrameInfo(const BroadcastManifestV2& manifest, ManifestFrameInfo& info);
+
+}
@@ -0,0 +1,221 @@
+// =============================================================================
+// MjpegPipeline.cpp  --  Frame-pipelined MJPEG decoding on the worker pool
+// =============================================================================
+// See MjpegPipeline.h.
+//
+// Slots form a ring of 'depth' entries.  Submit() fills the slot after the
+// newest one and enqueues its decode on the pool.  Deliver() only ever
+// looks at the oldest slot, which is what keeps the output in order even
+// though decodes finish in any order.  A slot returns to Free only once the
+// consumer has seen it, so a worker never writes into a frame being read.
+// =============================================================================
+
+#include "MjpegPipeline.h"
+#include <algorithm>
+#include <cstring>
+
+namespace VirtuaCam {
+
+namespace
+{
+    // -----------------------------------------------------------------------
+    // ITU-T T.81 Annex K.3 default Huffman tables, as one DHT segment
+    // -----------------------------------------------------------------------
+
+    constexpr uint8_t kDcLumaBits[16] = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+    constexpr uint8_t kDcChromaBits[16] = { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 };
+    constexpr uint8_t kDcValues[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+    constexpr uint8_t kAcLumaBits[16] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d };
+    constexpr uint8_t kAcLumaValues[162] = {
+        0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+        0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+        0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+        0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+        0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+        0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+        0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+        0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+        0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+        0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+        0xf9, 0xfa,
+    };
+
+    constexpr uint8_t kAcChromaBits[16] = { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 };
+    constexpr uint8_t kAcChromaValues[162] = {
+        0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+        0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+        0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+        0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+        0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+        0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+        0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+        0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+        0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+        0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+        0xf9, 0xfa,
+    };
+
+    void AppendTable(std::vector<uint8_t>& out, uint8_t classAndId, const uint8_t (&bits)[16], const uint8_t* values, size_t valueCount)
+    {
+        out.push_back(classAndId);
+        out.insert(out.end(), bits, bits + 16);
+        out.insert(out.end(), values, values + valueCount);
+    }
+
+    std::vector<uint8_t> BuildDefaultDht()
+    {
+        std::vector<uint8_t> dht = { 0xFF, 0xC4, 0, 0 };
+        AppendTable(dht, 0x00, kDcLumaBits, kDcValues, sizeof(kDcValues));
+        AppendTable(dht, 0x01, kDcChromaBits, kDcValues, sizeof(kDcValues));
+        AppendTable(dht, 0x10, kAcLumaBits, kAcLumaValues, sizeof(kAcLumaValues));
+        AppendTable(dht, 0x11, kAcChromaBits, kAcChromaValues, sizeof(kAcChromaValues));
+        const size_t length = dht.size() - 2;
+        dht[2] = (uint8_t)(length >> 8);
+        dht[3] = (uint8_t)(length & 0xFF);
+        return dht;
+    }
+
+    // Offset of the SOS marker if the header has no DHT segment, 0 otherwise
+    // (including for anything that does not parse as a JPEG header).
+    size_t FindSosWithoutDht(const uint8_t* data, size_t size)
+    {
+        if (size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+            return 0;
+        size_t pos = 2;
+        while (pos + 4 <= size)
+        {
+            if (data[pos] != 0xFF)
+                return 0;
+            const uint8_t marker = data[pos + 1];
+            if (marker == 0xFF)                 // fill byte
+            {
+                ++pos;
+                continue;
+            }
+            if (marker == 0xC4)                 // DHT present
+                return 0;
+            if (marker == 0xDA)                 // SOS: end of the header
+                return pos;
+            pos += 2 + ((size_t)data[pos + 2] << 8 | data[pos + 3]);
+        }
+        return 0;
+    }
+}
+
+void AppendMjpegFrame(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+{
+    static const std::vector<uint8_t> defaultDht = BuildDefaultDht();
+
+    out.clear();
+    const size_t sos = FindSosWithoutDht(data, size);
+    if (!sos)
+    {
+        out.assign(data, data + size);
+        return;
+    }
+    out.reserve(size + defaultDht.size());
+    out.insert(out.end(), data, data + sos);
+    out.insert(out.end(), defaultDht.begin(), defaultDht.end());
+    out.insert(out.end(), data + sos, data + size);
+}
+
+// ---------------------------------------------------------------------------
+// MjpegPipeline
+// ---------------------------------------------------------------------------
+
+MjpegPipeline::MjpegPipeline(uint32_t width, uint32_t height, DecodeFn decode, uint32_t depth, WorkerPool& pool)
+    : m_width(width), m_decode(std::move(decode)), m_pool(pool)
+{
+    if (!depth)
+        depth = std::min(pool.GetThreadCount(), 4u);
+    m_slots.resize(std::max(depth, 1u));
+    for (auto& slot : m_slots)
+        slot.bgra.resize((size_t)width * height * 4);
+}
+
+MjpegPipeline::~MjpegPipeline()
+{
+    // Decode tasks reference the slots; wait for every one of them.
+    std::unique_lock<std::mutex> guard(m_lock);
+    m_decoded.wait(guard, [this]
+    {
+        return std::none_of(m_slots.begin(), m_slots.end(), [](const Slot& s) { return s.state == SlotState::Decoding; });
+    });
+}
+
+uint32_t MjpegPipeline::InFlight() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_count;
+}
+
+bool MjpegPipeline::Submit(const uint8_t* data, size_t size, int64_t timestamp, int64_t duration)
+{
+    if (!data || !size)
+        return false;
+
+    Slot* slot = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (m_count == m_slots.size())
+            return false;
+        slot = &m_slots[(m_head + m_count) % m_slots.size()];
+        slot->state = SlotState::Decoding;
+        ++m_count;
+    }
+
+    // Only the capture thread touches a Decoding slot before its task starts.
+    AppendMjpegFrame(data, size, slot->jpeg);
+    slot->timestamp = timestamp;
+    slot->duration = duration;
+    m_pool.Submit([this, slot] { Decode(*slot); });
+    return true;
+}
+
+void MjpegPipeline::Decode(Slot& slot)
+{
+    const bool ok = m_decode(slot.jpeg.data(), slot.jpeg.size(), slot.bgra.data(), (ptrdiff_t)m_width * 4);
+    // Notify under the lock: once the state changes the destructor may run.
+    std::lock_guard<std::mutex> guard(m_lock);
+    slot.state = ok ? SlotState::Ready : SlotState::Failed;
+    m_decoded.notify_all();
+}
+
+bool MjpegPipeline::Deliver(const ConsumeFn& consume, bool wait)
+{
+    Slot* slot = nullptr;
+    {
+        std::unique_lock<std::mutex> guard(m_lock);
+        if (!m_count)
+            return false;
+        slot = &m_slots[m_head];
+        if (wait)
+            m_decoded.wait(guard, [slot] { return slot->state != SlotState::Decoding; });
+        else if (slot->state == SlotState::Decoding)
+            return false;
+    }
+
+    // Ready/Failed slots are not touched by workers, so read without the lock.
+    const bool ok = slot->state == SlotState::Ready;
+    if (ok && consume)
+        consume(slot->bgra.data(), (ptrdiff_t)m_width * 4, slot->timestamp, slot->duration);
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    slot->state = SlotState::Free;
+    m_head = (m_head + 1) % m_slots.size();
+    --m_count;
+    return true;
+}
+
+bool MjpegPipeline::TryPop(const ConsumeFn& consume)
+{
+    return Deliver(consume, false);
+}
+
+bool MjpegPipeline::Pop(const ConsumeFn& consume)
+{
+    return Deliver(consume, true);
+}
+
+}
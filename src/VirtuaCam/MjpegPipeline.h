@@ -0,0 +1,98 @@
+// =============================================================================
+// MjpegPipeline.h  --  Frame-pipelined MJPEG decoding on the worker pool
+// =============================================================================
+// USB cameras usually reach 1080p60 / 4K only in MJPEG, and a single decoder
+// running inside IMFSourceReader::ReadSample cannot keep up with that.  This
+// pipeline keeps up to 'depth' compressed frames in flight, each decoded as a
+// WorkerPool task, and hands the decoded BGRA frames back strictly in the
+// order they were submitted.  Throughput scales with the pool while latency
+// stays at roughly one decode.
+//
+// The decoder itself is injected (DecodeFn) so the pipeline has no Windows
+// dependency; the camera producer plugs in WIC.
+//
+// UVC payloads may omit the Huffman tables (the "AVI1" MJPEG convention),
+// which stock JPEG decoders reject.  Submit() inserts the standard tables
+// from ITU-T T.81 Annex K.3 into such frames while copying them.
+//
+// Threading: Submit()/TryPop()/Pop() must be called from a single thread
+// (the capture loop).  DecodeFn runs concurrently on pool threads.
+// =============================================================================
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "WorkerPool.h"
+
+namespace VirtuaCam {
+
+// Copies a JPEG frame into 'out', inserting the Annex K.3 Huffman tables
+// before the first scan if the frame has no DHT segment of its own.
+void AppendMjpegFrame(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+class MjpegPipeline {
+public:
+    // Decodes one complete JPEG into a width x height BGRA buffer.  Returns
+    // false for corrupt frames or a size mismatch; such frames are dropped.
+    using DecodeFn = std::function<bool(const uint8_t* jpeg, size_t size, uint8_t* bgra, ptrdiff_t stride)>;
+
+    // Receives a decoded frame with the timestamp and duration it was
+    // submitted with; the buffer is only valid during the call.
+    using ConsumeFn = std::function<void(const uint8_t* bgra, ptrdiff_t stride, int64_t timestamp, int64_t duration)>;
+
+    // 'depth' is the number of frames in flight (0 = one per pool thread,
+    // capped at 4).
+    MjpegPipeline(uint32_t width, uint32_t height, DecodeFn decode,
+                  uint32_t depth = 0, WorkerPool& pool = WorkerPool::Shared());
+    ~MjpegPipeline();
+
+    MjpegPipeline(const MjpegPipeline&) = delete;
+    MjpegPipeline& operator=(const MjpegPipeline&) = delete;
+
+    // Copies the compressed frame and queues it for decoding.  Returns false
+    // (and queues nothing) when all slots are busy; Pop() the oldest first.
+    bool Submit(const uint8_t* data, size_t size, int64_t timestamp, int64_t duration);
+
+    // Retires the oldest frame if its decode has finished, passing it to
+    // 'consume' unless it failed to decode.  Returns false if the oldest frame
+    // is still decoding or nothing is in flight.
+    bool TryPop(const ConsumeFn& consume);
+
+    // Like TryPop() but waits for the oldest frame's decode.  Returns false
+    // only if nothing is in flight.
+    bool Pop(const ConsumeFn& consume);
+
+    uint32_t InFlight() const;
+    uint32_t Depth() const { return (uint32_t)m_slots.size(); }
+
+private:
+    enum class SlotState { Free, Decoding, Ready, Failed };
+
+    struct Slot {
+        std::vector<uint8_t> jpeg;
+        std::vector<uint8_t> bgra;
+        int64_t timestamp = 0;
+        int64_t duration = 0;
+        SlotState state = SlotState::Free;
+    };
+
+    void Decode(Slot& slot);
+    bool Deliver(const ConsumeFn& consume, bool wait);
+
+    const uint32_t m_width;
+    const DecodeFn m_decode;
+    WorkerPool& m_pool;
+
+    std::vector<Slot> m_slots;
+    uint32_t m_head = 0;        // oldest frame in flight
+    uint32_t m_count = 0;       // frames in flight
+    mutable std::mutex m_lock;
+    std::condition_variable m_decoded;
+};
+
+}
@@ -16,6 +16,16 @@
 // When no primary source is available, a static black "NO SIGNAL" frame is
 // shown instead of leaving the output blank.
 //
+// A primary source with a different aspect is fitted inside the output.  By
+// default the bars show a blurred, cover-cropped copy of the source computed
+// at 1/16 size from its mip chain (Letterbox.h); LetterboxMode::Black keeps
+// plain bars.
+//
+// A PiP source with a chroma key (SetChromaKeys) is drawn through the key
+// shader -- the float form of ChromaKey.h's matte and spill suppression --
+// and blended premultiplied, so a green-screen camera sits directly on the
+// source behind it instead of in an opaque tile.
+//
 // All rendering uses D3D11 and the same full-screen triangle blit technique
 // as BrokerClient: a vertex shader generates three vertices from SV_VertexID,
 // forming a triangle that covers the entire viewport without a vertex buffer.
@@ -23,6 +33,7 @@
 
 #include "pch.h"
 #include "Multiplexer.h"
+#include "Letterbox.h"
 #include <d3dcompiler.h>
 #include <cmath>
 #include <algorithm>
@@ -49,6 +60,88 @@ float4 main(float4 pos : SV_POSITION, float2 uv : TEXCOORD) : SV_TARGET {
     return g_texture.Sample(g_sampler, uv);
 })";
 
+// ---------------------------------------------------------------------------
+// Letterbox fill shaders
+// ---------------------------------------------------------------------------
+// Both run over the reduced-size fill targets with the blit vertex shader.
+//   reduce  samples the cover region of the source at the mip level matching
+//           the reduction (trilinear, so the chain does the averaging);
+//   blur    one direction of a (2 * 7 + 1)-tap Gaussian.
+
+static constexpr UINT  kFillReduction  = VirtuaCam::LetterboxFill::kDefaultReduction;
+static constexpr float kFillSigma      = VirtuaCam::LetterboxFill::kDefaultSigma;
+static constexpr UINT  kFillBlurRadius = 7;
+
+const char* g_FillPixelShaders = R"(
+Texture2D    g_texture : register(t0);
+SamplerState g_sampler : register(s0);
+cbuffer FillConstants : register(b0) {
+    float4 g_uvRect;        // reduce: source region (u, v, width, height)
+    float2 g_texelStep;     // blur: one fill pixel along the pass direction
+    float  g_lod;           // reduce: source mip level
+    float  g_padding;
+    float4 g_weights[2];    // blur: centre tap, then the taps at +-1 .. +-7
+};
+float4 reduce(float4 pos : SV_POSITION, float2 uv : TEXCOORD) : SV_TARGET {
+    return g_texture.SampleLevel(g_sampler, g_uvRect.xy + uv * g_uvRect.zw, g_lod);
+}
+float4 blur(float4 pos : SV_POSITION, float2 uv : TEXCOORD) : SV_TARGET {
+    float4 sum = g_texture.SampleLevel(g_sampler, uv, 0) * g_weights[0].x;
+    [unroll] for (int i = 1; i < 8; ++i) {
+        const float2 offset = g_texelStep * i;
+        sum += (g_texture.SampleLevel(g_sampler, uv + offset, 0) +
+                g_texture.SampleLevel(g_sampler, uv - offset, 0)) * g_weights[i >> 2][i & 3];
+    }
+    return sum;
+})";
+
+// Mirrors the FillConstants cbuffer.
+struct FillConstants {
+    float uvRect[4];
+    float texelStep[2];
+    float lod;
+    float padding;
+    float weights[8];
+};
+static_assert(sizeof(FillConstants) % 16 == 0, "constant buffers are sized in 16-byte registers");
+
+// ---------------------------------------------------------------------------
+// Chroma-key shader
+// ---------------------------------------------------------------------------
+// Same steps as ChromaKey.cpp in float: BT.601 chroma distance to the key
+// through a smoothstep, key-direction spill removed as a chroma delta, output
+// premultiplied for the m_premultipliedBlend state.
+
+const char* g_KeyPixelShader = R"(
+Texture2D    g_texture : register(t0);
+SamplerState g_sampler : register(s0);
+cbuffer KeyConstants : register(b0) {
+    float2 g_keyChroma;     // key (Cb, Cr), -0.5 .. 0.5
+    float2 g_direction;     // unit vector towards the key chroma
+    float  g_tolerance;
+    float  g_softness;
+    float  g_spill;
+    float  g_padding;
+};
+float4 main(float4 pos : SV_POSITION, float2 uv : TEXCOORD) : SV_TARGET {
+    float4 c = g_texture.Sample(g_sampler, uv);
+    const float2 chroma = float2(dot(c.rgb, float3(-0.168736, -0.331264, 0.5)),
+                                 dot(c.rgb, float3(0.5, -0.418688, -0.081312)));
+    const float d = distance(chroma, g_keyChroma);
+    const float matte = g_softness > 0.0 ? smoothstep(g_tolerance, g_tolerance + g_softness, d)
+                                         : (float)(d > g_tolerance);
+
+    const float2 delta = -max(dot(chroma, g_direction), 0.0) * g_spill * g_direction;
+    c.r += 1.402 * delta.y;
+    c.g -= 0.344136 * delta.x + 0.714136 * delta.y;
+    c.b += 1.772 * delta.x;
+
+    const float a = matte * c.a;
+    return float4(saturate(c.rgb) * a, a);
+})";
+
+static_assert(sizeof(VirtuaCam::ChromaKeyShaderConstants) % 16 == 0, "constant buffers are sized in 16-byte registers");
+
 // ---------------------------------------------------------------------------
 // Aspect-fit helper
 // ---------------------------------------------------------------------------
@@ -58,15 +151,8 @@ float4 main(float4 pos : SV_POSITION, float2 uv : TEXCOORD) : SV_TARGET {
 
 static D3D11_VIEWPORT FitViewport(float dstX, float dstY, float dstW, float dstH, UINT srcW, UINT srcH)
 {
-    D3D11_VIEWPORT vp = { dstX, dstY, dstW, dstH, 0.0f, 1.0f };
-    if (srcW && srcH) {
-        const float scale = std::min(dstW / (float)srcW, dstH / (float)srcH);
-        vp.Width    = srcW * scale;
-        vp.Height   = srcH * scale;
-        vp.TopLeftX = dstX + (dstW - vp.Width)  * 0.5f;
-        vp.TopLeftY = dstY + (dstH - vp.Height) * 0.5f;
-    }
-    return vp;
+    const VirtuaCam::LayoutRect fit = VirtuaCam::FitRect({ dstX, dstY, dstW, dstH }, srcW, srcH);
+    return { fit.x, fit.y, fit.width, fit.height, 0.0f, 1.0f };
 }
 
 // ---------------------------------------------------------------------------
@@ -98,6 +184,12 @@ void Multiplexer::Shutdown()
     m_blitVS.Reset();
     m_blitPS.Reset();
     m_blitSampler.Reset();
+    for (int i = 0; i < 2; ++i) {
+        m_fillTexture[i].Reset(); m_fillRTV[i].Reset(); m_fillSRV[i].Reset();
+    }
+    m_fillReducePS.Reset(); m_fillBlurPS.Reset(); m_fillConstants.Reset();
+    m_keyPS.Reset(); m_keyConstants.Reset(); m_premultipliedBlend.Reset();
+    m_chromaKeys.clear();
     m_producerResources.clear();
 }
 
@@ -105,6 +197,25 @@ void Multiplexer::Shutdown()
 // Output accessors  (used by Broker.cpp to copy the composited frame)
 // ---------------------------------------------------------------------------
 
+void Multiplexer::SetChromaKeys(const std::map<DWORD, VirtuaCam::ChromaKeyParams>& keys)
+{
+    for (auto it = m_chromaKeys.begin(); it != m_chromaKeys.end();) {
+        if (keys.count(it->first)) {
+            ++it;
+        } else {
+            it = m_chromaKeys.erase(it);
+            m_chromaKeysChanged = true;
+        }
+    }
+    for (const auto& [pid, params] : keys) {
+        VirtuaCam::ChromaKey& key = m_chromaKeys[pid];
+        if (!key.IsConfigured() || !(key.Params() == params)) {
+            key.Configure(params);
+            m_chromaKeysChanged = true;
+        }
+    }
+}
+
 ID3D11Texture2D* Multiplexer::GetOutputTexture()   { return m_outputTexture.Get(); }
 ID3D11Fence*     Multiplexer::GetOutputFence()      { return m_outputFence.Get(); }
 UINT64           Multiplexer::GetOutputFrameValue() { return m_outputFrameValue; }
@@ -161,12 +272,80 @@ HRESULT Multiplexer::CreateResources()
     sampDesc.MaxLOD         = D3D11_FLOAT32_MAX;
     RETURN_IF_FAILED(m_device->CreateSamplerState(&sampDesc, &m_blitSampler));
 
+    RETURN_IF_FAILED(CreateLetterboxResources(compositeDesc.Width, compositeDesc.Height));
+    RETURN_IF_FAILED(CreateChromaKeyResources());
+
     // Static placeholder used as the background when no primary source is live.
     RETURN_IF_FAILED(CreateNoSignalTexture(m_device.Get(), compositeDesc.Width, compositeDesc.Height, &m_noSignalTexture));
 
     return S_OK;
 }
 
+// Fill targets at 1/kFillReduction of the output, the two fill shaders and
+// their constant buffer.
+HRESULT Multiplexer::CreateLetterboxResources(UINT width, UINT height)
+{
+    const VirtuaCam::LetterboxFillPlan plan = VirtuaCam::PlanLetterboxFill(width, height, width, height, kFillReduction);
+    m_fillWidth  = plan.width;
+    m_fillHeight = plan.height;
+
+    D3D11_TEXTURE2D_DESC fillDesc = {};
+    fillDesc.Width            = m_fillWidth;
+    fillDesc.Height           = m_fillHeight;
+    fillDesc.MipLevels        = 1;
+    fillDesc.ArraySize        = 1;
+    fillDesc.Format           = DXGI_FORMAT_B8G8R8A8_UNORM;
+    fillDesc.SampleDesc.Count = 1;
+    fillDesc.Usage            = D3D11_USAGE_DEFAULT;
+    fillDesc.BindFlags        = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    for (int i = 0; i < 2; ++i) {
+        RETURN_IF_FAILED(m_device->CreateTexture2D(&fillDesc, nullptr, &m_fillTexture[i]));
+        RETURN_IF_FAILED(m_device->CreateRenderTargetView(m_fillTexture[i].Get(), nullptr, &m_fillRTV[i]));
+        RETURN_IF_FAILED(m_device->CreateShaderResourceView(m_fillTexture[i].Get(), nullptr, &m_fillSRV[i]));
+    }
+
+    Microsoft::WRL::ComPtr<ID3DBlob> reduceBlob, blurBlob;
+    RETURN_IF_FAILED(D3DCompile(g_FillPixelShaders, strlen(g_FillPixelShaders), nullptr, nullptr, nullptr, "reduce", "ps_5_0", 0, 0, &reduceBlob, nullptr));
+    RETURN_IF_FAILED(D3DCompile(g_FillPixelShaders, strlen(g_FillPixelShaders), nullptr, nullptr, nullptr, "blur",   "ps_5_0", 0, 0, &blurBlob, nullptr));
+    RETURN_IF_FAILED(m_device->CreatePixelShader(reduceBlob->GetBufferPointer(), reduceBlob->GetBufferSize(), nullptr, &m_fillReducePS));
+    RETURN_IF_FAILED(m_device->CreatePixelShader(blurBlob->GetBufferPointer(),   blurBlob->GetBufferSize(),   nullptr, &m_fillBlurPS));
+
+    D3D11_BUFFER_DESC cbDesc = {};
+    cbDesc.ByteWidth = sizeof(FillConstants);
+    cbDesc.Usage     = D3D11_USAGE_DEFAULT;
+    cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    RETURN_IF_FAILED(m_device->CreateBuffer(&cbDesc, nullptr, &m_fillConstants));
+    return S_OK;
+}
+
+// Key shader, its constant buffer and the premultiplied "over" blend
+// (ONE, INV_SRC_ALPHA) used for keyed PiP draws.
+HRESULT Multiplexer::CreateChromaKeyResources()
+{
+    Microsoft::WRL::ComPtr<ID3DBlob> keyBlob;
+    RETURN_IF_FAILED(D3DCompile(g_KeyPixelShader, strlen(g_KeyPixelShader), nullptr, nullptr, nullptr, "main", "ps_5_0", 0, 0, &keyBlob, nullptr));
+    RETURN_IF_FAILED(m_device->CreatePixelShader(keyBlob->GetBufferPointer(), keyBlob->GetBufferSize(), nullptr, &m_keyPS));
+
+    D3D11_BUFFER_DESC cbDesc = {};
+    cbDesc.ByteWidth = sizeof(VirtuaCam::ChromaKeyShaderConstants);
+    cbDesc.Usage     = D3D11_USAGE_DEFAULT;
+    cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    RETURN_IF_FAILED(m_device->CreateBuffer(&cbDesc, nullptr, &m_keyConstants));
+
+    D3D11_BLEND_DESC blendDesc = {};
+    D3D11_RENDER_TARGET_BLEND_DESC& rt = blendDesc.RenderTarget[0];
+    rt.BlendEnable           = TRUE;
+    rt.SrcBlend              = D3D11_BLEND_ONE;
+    rt.DestBlend             = D3D11_BLEND_INV_SRC_ALPHA;
+    rt.BlendOp               = D3D11_BLEND_OP_ADD;
+    rt.SrcBlendAlpha         = D3D11_BLEND_ONE;
+    rt.DestBlendAlpha        = D3D11_BLEND_INV_SRC_ALPHA;
+    rt.BlendOpAlpha          = D3D11_BLEND_OP_ADD;
+    rt.RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+    RETURN_IF_FAILED(m_device->CreateBlendState(&blendDesc, &m_premultipliedBlend));
+    return S_OK;
+}
+
 // ---------------------------------------------------------------------------
 // PruneConnections
 // ---------------------------------------------------------------------------
@@ -188,8 +367,9 @@ void Multiplexer::PruneConnections(const std::vector<VirtuaCam::DiscoveredShared
 // ---------------------------------------------------------------------------
 // UpdateProducerConnection
 // ---------------------------------------------------------------------------
-// Open the shared texture and fence for a newly-discovered producer and create
-// a private (SRV-bindable) copy of the texture.  Idempotent — does nothing if
+// Open the shared texture (or texture ring) and fence for a newly-discovered
+// producer, map its manifest for the life of the connection, and create a
+// private (SRV-bindable) copy of the texture.  Idempotent — does nothing if
 // the producer is already connected.
 
 HRESULT Multiplexer::UpdateProducerConnection(const VirtuaCam::DiscoveredSharedStream& streamInfo)
@@ -201,25 +381,22 @@ HRESULT Multiplexer::UpdateProducerConnection(const VirtuaCam::DiscoveredSharedS
     ProducerGpuResources newRes;
     newRes.pid = streamInfo.processId;
 
-    Microsoft::WRL::ComPtr<ID3D11Device1> device1;
     Microsoft::WRL::ComPtr<ID3D11Device5> device5;
-    m_device.As(&device1);
     m_device.As(&device5);
 
     // GetHandleFromName uses a temporary D3D12 device (OpenSharedHandleByName
     // is not available on D3D11).
-    wil::unique_handle hTexture(GetHandleFromName(streamInfo.textureName.c_str()));
-    wil::unique_handle hFence(  GetHandleFromName(streamInfo.fenceName.c_str()));
+    wil::unique_handle hFence(GetHandleFromName(streamInfo.fenceName.c_str()));
 
-    if (!hTexture || FAILED(device1->OpenSharedResource1(hTexture.get(), IID_PPV_ARGS(&newRes.sharedTexture)))) return E_FAIL;
-    if (!hFence   || FAILED(device5->OpenSharedFence(    hFence.get(),   IID_PPV_ARGS(&newRes.sharedFence))))   return E_FAIL;
+    RETURN_IF_FAILED(newRes.source.Open(m_device.Get(), streamInfo.manifestName, streamInfo.textureName));
+    if (!hFence || FAILED(device5->OpenSharedFence(hFence.get(), IID_PPV_ARGS(&newRes.sharedFence)))) return E_FAIL;
 
     // Create a private copy of the texture (shared textures can't be bound as
     // SRVs).  The copy carries a full mip chain so that PiP downscaling samples
     // through the mips (MIN_MAG_MIP_LINEAR) instead of aliasing/shimmering when
     // a large source is shrunk into a small corner tile.
     D3D11_TEXTURE2D_DESC sharedDesc;
-    newRes.sharedTexture->GetDesc(&sharedDesc);
+    newRes.source.Texture()->GetDesc(&sharedDesc);
     newRes.width  = sharedDesc.Width;
     newRes.height = sharedDesc.Height;
     sharedDesc.MipLevels  = 0;  // full mip chain
@@ -235,6 +412,60 @@ HRESULT Multiplexer::UpdateProducerConnection(const VirtuaCam::DiscoveredSharedS
     return S_OK;
 }
 
+// ---------------------------------------------------------------------------
+// DrawLetterboxFill
+// ---------------------------------------------------------------------------
+// Reduce -> blur horizontally -> blur vertically on the fill targets, then
+// expand the result bilinearly over the whole composite.  The fitted source
+// is drawn on top by the caller.  Four draws, three of them at 1/256 of the
+// output's pixels.
+
+void Multiplexer::DrawLetterboxFill(const ProducerGpuResources& source, UINT width, UINT height)
+{
+    const VirtuaCam::LetterboxFillPlan plan = VirtuaCam::PlanLetterboxFill(width, height, source.width, source.height, kFillReduction);
+    FillConstants constants = {};
+    constants.uvRect[0] = plan.cover.u;     constants.uvRect[1] = plan.cover.v;
+    constants.uvRect[2] = plan.cover.width; constants.uvRect[3] = plan.cover.height;
+    constants.lod = plan.lod;
+    VirtuaCam::GaussianWeights(kFillSigma, kFillBlurRadius, constants.weights);
+
+    ID3D11ShaderResourceView* const noSRV = nullptr;
+    const D3D11_VIEWPORT fillViewport = { 0.0f, 0.0f, (float)m_fillWidth, (float)m_fillHeight, 0.0f, 1.0f };
+    m_context->RSSetViewports(1, &fillViewport);
+    m_context->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    m_context->VSSetShader(m_blitVS.Get(), nullptr, 0);
+    m_context->PSSetSamplers(0, 1, m_blitSampler.GetAddressOf());
+    m_context->PSSetConstantBuffers(0, 1, m_fillConstants.GetAddressOf());
+
+    // Reduce: source cover region -> fill[0].
+    m_context->UpdateSubresource(m_fillConstants.Get(), 0, nullptr, &constants, 0, 0);
+    m_context->OMSetRenderTargets(1, m_fillRTV[0].GetAddressOf(), nullptr);
+    m_context->PSSetShader(m_fillReducePS.Get(), nullptr, 0);
+    m_context->PSSetShaderResources(0, 1, source.privateSRV.GetAddressOf());
+    m_context->Draw(3, 0);
+
+    // Blur: fill[0] -> fill[1] horizontally, fill[1] -> fill[0] vertically.
+    m_context->PSSetShader(m_fillBlurPS.Get(), nullptr, 0);
+    for (int pass = 0; pass < 2; ++pass) {
+        constants.texelStep[0] = pass == 0 ? 1.0f / m_fillWidth : 0.0f;
+        constants.texelStep[1] = pass == 0 ? 0.0f : 1.0f / m_fillHeight;
+        m_context->UpdateSubresource(m_fillConstants.Get(), 0, nullptr, &constants, 0, 0);
+        m_context->PSSetShaderResources(0, 1, &noSRV);
+        m_context->OMSetRenderTargets(1, m_fillRTV[1 - pass].GetAddressOf(), nullptr);
+        m_context->PSSetShaderResources(0, 1, m_fillSRV[pass].GetAddressOf());
+        m_context->Draw(3, 0);
+    }
+
+    // Expand: fill[0] -> the whole composite.
+    const D3D11_VIEWPORT fullViewport = { 0.0f, 0.0f, (float)width, (float)height, 0.0f, 1.0f };
+    m_context->OMSetRenderTargets(1, m_compositeRTV.GetAddressOf(), nullptr);
+    m_context->RSSetViewports(1, &fullViewport);
+    m_context->PSSetShader(m_blitPS.Get(), nullptr, 0);
+    m_context->PSSetShaderResources(0, 1, m_fillSRV[0].GetAddressOf());
+    m_context->Draw(3, 0);
+    m_context->PSSetShaderResources(0, 1, &noSRV);
+}
+
 // ---------------------------------------------------------------------------
 // CompositeFrames
 // ---------------------------------------------------------------------------
@@ -244,8 +475,9 @@ HRESULT Multiplexer::UpdateProducerConnection(const VirtuaCam::DiscoveredSharedS
 //   1. Sync GPU resources: open connections for new producers, drop stale ones,
 //      then for each producer wait on its fence and copy its texture locally.
 //   2. Clear the composite render target to black.
-//   3. Render background: either the primary source fullscreen, or the static
-//      "NO SIGNAL" frame if no primary source is available.
+//   3. Render background: either the primary source fullscreen (over its
+//      letterbox fill if it has bars), or the static "NO SIGNAL" frame if no
+//      primary source is available.
 //   4. Render overlays: PiP tiles (priority-list mode) or grid (grid mode).
 //   5. Finalise: copy composite to output texture and signal the output fence.
 
@@ -264,28 +496,37 @@ void Multiplexer::CompositeFrames(const std::vector<VirtuaCam::DiscoveredSharedS
 
     // For each connected producer, check if a new frame is available.
     // Wait on the producer's fence (GPU-side) then copy to our private texture.
+    // The manifest stays mapped while connected, so this is a memory load per
+    // producer; producers that died have already been pruned above, because
+    // Discovery no longer lists them.
     bool contentChanged = false;
+    LONGLONG captureTime = 0;
     for (auto& res : m_producerResources) {
-        wil::unique_handle hManifest(OpenFileMappingW(FILE_MAP_READ, FALSE,
-            (L"DirectPort_Producer_Manifest_" + std::to_wstring(res.pid)).c_str()));
-        if (!hManifest) continue;
-
-        BroadcastManifest* pView = (BroadcastManifest*)MapViewOfFile(hManifest.get(), FILE_MAP_READ, 0, 0, sizeof(BroadcastManifest));
-        if (!pView) continue;
-
-        UINT64 latestFrame = pView->frameValue;
-        if (latestFrame > res.lastSeenFrame) {
+        // Give back ring slots whose earlier copies the GPU has finished.
+        res.source.ReleaseCompletedReads();
+        UINT64 latestFrame = res.source.Manifest().FrameValue();
+        // For a ring this pins the slot holding the newest frame (possibly
+        // newer than latestFrame) until a later frame's copy has run.
+        ID3D11Texture2D* sharedTexture = latestFrame > res.lastSeenFrame ? res.source.Acquire(latestFrame) : nullptr;
+        if (sharedTexture) {
             m_context4->Wait(res.sharedFence.Get(), latestFrame);
             // CopySubresourceRegion (not CopyResource): the private texture has
             // a full mip chain while the shared texture has a single mip, so
             // only mip 0 is copied, then the chain is regenerated.
-            m_context->CopySubresourceRegion(res.privateTexture.Get(), 0, 0, 0, 0, res.sharedTexture.Get(), 0, nullptr);
+            m_context->CopySubresourceRegion(res.privateTexture.Get(), 0, 0, 0, 0, sharedTexture, 0, nullptr);
+            res.source.EndRead();
             if (res.privateSRV)
                 m_context->GenerateMips(res.privateSRV.Get());
             res.lastSeenFrame = latestFrame;
+            // The record may already describe a frame published after the
+            // one pinned above; only use it if it is the frame we copied.
+            VirtuaCam::ManifestFrameInfo info;
+            const bool matched = res.source.Manifest().ReadFrameInfo(info) && info.frameValue == latestFrame;
+            res.lastFrame = matched ? info : VirtuaCam::ManifestFrameInfo{};
+            if (matched)
+                captureTime = std::max<LONGLONG>(captureTime, info.captureTime);
             contentChanged = true;
         }
-        UnmapViewOfFile(pView);
     }
 
     // Composite-skip: if no producer delivered a new frame and the layout is
@@ -296,11 +537,14 @@ void Multiplexer::CompositeFrames(const std::vector<VirtuaCam::DiscoveredSharedS
     layoutPids.reserve(producers.size());
     for (const auto& p : producers)
         layoutPids.push_back(p.processId);
-    const bool layoutChanged = !m_hasComposited || isGridMode != m_lastGridMode || layoutPids != m_lastLayoutPids;
+    const bool layoutChanged = !m_hasComposited || isGridMode != m_lastGridMode || layoutPids != m_lastLayoutPids ||
+                               m_letterboxMode != m_lastLetterboxMode || m_chromaKeysChanged;
     if (!contentChanged && !layoutChanged)
         return;
+    m_chromaKeysChanged = false;
     m_lastLayoutPids = std::move(layoutPids);
     m_lastGridMode = isGridMode;
+    m_lastLetterboxMode = m_letterboxMode;
     m_hasComposited = true;
 
     // --- Step 2: Clear the composite render target ---
@@ -329,9 +573,14 @@ void Multiplexer::CompositeFrames(const std::vector<VirtuaCam::DiscoveredSharedS
         primarySourceRes = find_resource(producers[0].processId);
 
     if (primarySourceRes && primarySourceRes->privateSRV) {
-        // Blit the primary source aspect-fit into the full output (letterboxed
-        // onto the black clear when the source aspect differs).
+        // Blit the primary source aspect-fit into the full output.  When the
+        // source aspect differs, the bars show the blurred fill or the black
+        // clear.
         D3D11_VIEWPORT vp = FitViewport(0.0f, 0.0f, (float)MUX_WIDTH, (float)MUX_HEIGHT, primarySourceRes->width, primarySourceRes->height);
+        const VirtuaCam::LayoutRect full = { 0.0f, 0.0f, (float)MUX_WIDTH, (float)MUX_HEIGHT };
+        if (m_letterboxMode == LetterboxMode::Blur && m_fillConstants &&
+            VirtuaCam::HasBars(full, { vp.TopLeftX, vp.TopLeftY, vp.Width, vp.Height }))
+            DrawLetterboxFill(*primarySourceRes, MUX_WIDTH, MUX_HEIGHT);
         m_context->RSSetViewports(1, &vp);
         m_context->VSSetShader(m_blitVS.Get(), nullptr, 0);
         m_context->PSSetShader(m_blitPS.Get(), nullptr, 0);
@@ -371,7 +620,8 @@ void Multiplexer::CompositeFrames(const std::vector<VirtuaCam::DiscoveredSharedS
         };
 
         // producers[1] -> pip_vps[0] (TL), producers[2] -> pip_vps[1] (TR), etc.
-        // Each source is aspect-fit within its tile rather than stretched.
+        // Each source is aspect-fit within its tile rather than stretched; a
+        // keyed source is drawn through the key shader and blended.
         for (size_t i = 1; i < producers.size() && i < 5; ++i) {
             if (producers[i].processId != 0) {
                 ProducerGpuResources* res = find_resource(producers[i].processId);
@@ -380,7 +630,20 @@ void Multiplexer::CompositeFrames(const std::vector<VirtuaCam::DiscoveredSharedS
                     D3D11_VIEWPORT vp = FitViewport(tile.TopLeftX, tile.TopLeftY, tile.Width, tile.Height, res->width, res->height);
                     m_context->RSSetViewports(1, &vp);
                     m_context->PSSetShaderResources(0, 1, res->privateSRV.GetAddressOf());
-                    m_context->Draw(3, 0);
+
+                    const auto key = m_chromaKeys.find(res->pid);
+                    if (key != m_chromaKeys.end() && m_keyPS) {
+                        const VirtuaCam::ChromaKeyShaderConstants constants = key->second.ShaderConstants();
+                        m_context->UpdateSubresource(m_keyConstants.Get(), 0, nullptr, &constants, 0, 0);
+                        m_context->PSSetShader(m_keyPS.Get(), nullptr, 0);
+                        m_context->PSSetConstantBuffers(0, 1, m_keyConstants.GetAddressOf());
+                        m_context->OMSetBlendState(m_premultipliedBlend.Get(), nullptr, 0xFFFFFFFF);
+                        m_context->Draw(3, 0);
+                        m_context->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
+                        m_context->PSSetShader(m_blitPS.Get(), nullptr, 0);
+                    } else {
+                        m_context->Draw(3, 0);
+                    }
                 }
             }
         }
@@ -392,5 +655,6 @@ void Multiplexer::CompositeFrames(const std::vector<VirtuaCam::DiscoveredSharedS
     // Broker.cpp knows the output is ready to copy to the shared NT handle texture.
     m_context->CopyResource(m_outputTexture.Get(), m_compositeTexture.Get());
     m_outputFrameValue++;
+    m_outputCaptureTime = captureTime;
     m_context4->Signal(m_outputFence.Get(), m_outputFrameValue);
 }
@@ -1,8 +1,10 @@
 #pragma once
 #include "Tools.h"
 #include "Discovery.h"
+#include "ChromaKey.h"
 #include <wrl/client.h>
 #include <d3d11_4.h>
+#include <map>
 #include <vector>
 
 class Multiplexer
@@ -17,9 +19,23 @@ public:
     ID3D11Texture2D* GetOutputTexture();
     ID3D11Fence* GetOutputFence();
     UINT64 GetOutputFrameValue();
+    // Newest capture time (QPC ticks) among the producer frames that went into
+    // the current output frame; 0 if it was re-rendered for a layout change only.
+    LONGLONG GetOutputCaptureTime() const { return m_outputCaptureTime; }
+
+    // What the bars around an aspect-fitted primary source show.
+    enum class LetterboxMode { Black, Blur };
+    void SetLetterboxMode(LetterboxMode mode) { m_letterboxMode = mode; }
+
+    // Per-source chroma keys (ChromaKey.h), by producer PID.  A keyed PiP
+    // source is drawn with its key colour made transparent, so a green-screen
+    // camera can be layered over another source.  Replaces the previous set.
+    void SetChromaKeys(const std::map<DWORD, VirtuaCam::ChromaKeyParams>& keys);
 
 private:
     HRESULT CreateResources();
+    HRESULT CreateLetterboxResources(UINT width, UINT height);
+    HRESULT CreateChromaKeyResources();
     HRESULT UpdateProducerConnection(const VirtuaCam::DiscoveredSharedStream& streamInfo);
     void PruneConnections(const std::vector<VirtuaCam::DiscoveredSharedStream>& currentProducers);
 
@@ -28,12 +44,15 @@ private:
         bool connected = false;
         UINT width = 0;      // Source dimensions, for aspect-fit layout
         UINT height = 0;
-        Microsoft::WRL::ComPtr<ID3D11Texture2D> sharedTexture;
         Microsoft::WRL::ComPtr<ID3D11Fence> sharedFence;
         Microsoft::WRL::ComPtr<ID3D11Texture2D> privateTexture;
         Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> privateSRV;
+        SharedTextureSource source;   // manifest + texture (ring), open for the life of the connection
         UINT64 lastSeenFrame = 0;
+        VirtuaCam::ManifestFrameInfo lastFrame;   // record of lastSeenFrame
     };
+
+    void DrawLetterboxFill(const ProducerGpuResources& source, UINT width, UINT height);
     
     Microsoft::WRL::ComPtr<ID3D11Device> m_device;
     Microsoft::WRL::ComPtr<ID3D11DeviceContext> m_context;
@@ -46,6 +65,25 @@ private:
     Microsoft::WRL::ComPtr<ID3D11PixelShader> m_blitPS;
     Microsoft::WRL::ComPtr<ID3D11SamplerState> m_blitSampler;
 
+    // Blurred-background letterbox fill (Letterbox.h): two reduced-size
+    // targets the source is reduced into and blurred between.
+    LetterboxMode m_letterboxMode = LetterboxMode::Blur;
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> m_fillTexture[2];
+    Microsoft::WRL::ComPtr<ID3D11RenderTargetView> m_fillRTV[2];
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_fillSRV[2];
+    Microsoft::WRL::ComPtr<ID3D11PixelShader> m_fillReducePS;
+    Microsoft::WRL::ComPtr<ID3D11PixelShader> m_fillBlurPS;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_fillConstants;
+    UINT m_fillWidth = 0, m_fillHeight = 0;
+
+    // Chroma-keyed PiP draws: key shader, its constants and a premultiplied
+    // alpha blend.  Unkeyed sources keep the opaque blit.
+    std::map<DWORD, VirtuaCam::ChromaKey> m_chromaKeys;
+    bool m_chromaKeysChanged = false;
+    Microsoft::WRL::ComPtr<ID3D11PixelShader> m_keyPS;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_keyConstants;
+    Microsoft::WRL::ComPtr<ID3D11BlendState> m_premultipliedBlend;
+
     Microsoft::WRL::ComPtr<ID3D11Texture2D> m_noSignalTexture;  // Static "NO SIGNAL" frame shown when no primary source is live
 
     std::vector<ProducerGpuResources> m_producerResources;
@@ -53,10 +91,12 @@ private:
     Microsoft::WRL::ComPtr<ID3D11Texture2D> m_outputTexture;
     Microsoft::WRL::ComPtr<ID3D11Fence> m_outputFence;
     UINT64 m_outputFrameValue = 0;
+    LONGLONG m_outputCaptureTime = 0;
 
     // Composite-skip state: the frame is only re-rendered when a producer
     // delivered a new frame or the layout (source list / mode) changed.
     std::vector<DWORD> m_lastLayoutPids;
     bool m_lastGridMode = false;
+    LetterboxMode m_lastLetterboxMode = LetterboxMode::Blur;
     bool m_hasComposited = false;
 };
\ No newline at end of file
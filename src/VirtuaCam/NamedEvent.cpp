@@ -0,0 +1,147 @@
+// =============================================================================
+// NamedEvent.cpp  --  Named cross-process wake-up event (Win32 / POSIX backends)
+// =============================================================================
+// See NamedEvent.h for the public contract.
+// =============================================================================
+
+#include "NamedEvent.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <sddl.h>
+#else
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <semaphore.h>
+#endif
+
+namespace VirtuaCam {
+
+#if defined(_WIN32)
+
+namespace
+{
+    std::wstring FullName(const std::string& name)
+    {
+        return L"Local\\" + std::wstring(name.begin(), name.end());
+    }
+}
+
+bool NamedEvent::Create(const std::string& name)
+{
+    Close();
+    // Same DACL as the shared textures and manifests: Authenticated Users.
+    PSECURITY_DESCRIPTOR sd = nullptr;
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(L"D:P(A;;GA;;;AU)", SDDL_REVISION_1, &sd, nullptr))
+        return false;
+    SECURITY_ATTRIBUTES sa = { sizeof(sa), sd, FALSE };
+    m_handle = CreateEventW(&sa, FALSE, FALSE, FullName(name).c_str());
+    LocalFree(sd);
+    return m_handle != nullptr;
+}
+
+bool NamedEvent::Open(const std::string& name, bool* missing)
+{
+    Close();
+    m_handle = OpenEventW(EVENT_MODIFY_STATE, FALSE, FullName(name).c_str());
+    if (missing)
+        *missing = !m_handle && GetLastError() == ERROR_FILE_NOT_FOUND;
+    return m_handle != nullptr;
+}
+
+void NamedEvent::Close()
+{
+    if (m_handle)
+        CloseHandle((HANDLE)m_handle);
+    m_handle = nullptr;
+}
+
+void NamedEvent::Signal()
+{
+    if (m_handle)
+        SetEvent((HANDLE)m_handle);
+}
+
+bool NamedEvent::Wait(uint32_t timeoutMs)
+{
+    return m_handle && WaitForSingleObject((HANDLE)m_handle, timeoutMs == kInfinite ? INFINITE : timeoutMs) == WAIT_OBJECT_0;
+}
+
+#else
+
+bool NamedEvent::Create(const std::string& name)
+{
+    Close();
+    const std::string fullName = "/" + name;
+    sem_t* sem = sem_open(fullName.c_str(), O_CREAT, 0600, 0);
+    if (sem == SEM_FAILED)
+        return false;
+    m_handle = sem;
+    m_createdName = fullName;
+    return true;
+}
+
+bool NamedEvent::Open(const std::string& name, bool* missing)
+{
+    Close();
+    sem_t* sem = sem_open(("/" + name).c_str(), 0);
+    if (missing)
+        *missing = sem == SEM_FAILED && errno == ENOENT;
+    if (sem == SEM_FAILED)
+        return false;
+    m_handle = sem;
+    return true;
+}
+
+void NamedEvent::Close()
+{
+    if (m_handle)
+        sem_close((sem_t*)m_handle);
+    if (!m_createdName.empty())
+        sem_unlink(m_createdName.c_str());
+    m_handle = nullptr;
+    m_createdName.clear();
+}
+
+void NamedEvent::Signal()
+{
+    if (m_handle)
+        sem_post((sem_t*)m_handle);
+}
+
+bool NamedEvent::Wait(uint32_t timeoutMs)
+{
+    if (!m_handle)
+        return false;
+    sem_t* sem = (sem_t*)m_handle;
+    if (timeoutMs == kInfinite)
+    {
+        while (sem_wait(sem) != 0)
+        {
+            if (errno != EINTR)
+                return false;
+        }
+        return true;
+    }
+    timespec deadline = {};
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeoutMs / 1000;
+    deadline.tv_nsec += (long)(timeoutMs % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000)
+    {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000;
+    }
+    while (sem_timedwait(sem, &deadline) != 0)
+    {
+        if (errno != EINTR)
+            return false;
+    }
+    return true;
+}
+
+#endif
+
+}
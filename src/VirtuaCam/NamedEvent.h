@@ -0,0 +1,62 @@
+// =============================================================================
+// NamedEvent.h  --  Named cross-process wake-up event (Win32 / POSIX backends)
+// =============================================================================
+// The wake-up half of the OS abstraction under ProducerDirectory (the region
+// is SharedMemory.h).  One process creates the event and waits on it; any
+// other process opens it by name and signals it.
+//
+//   Windows   Auto-reset event named "Local\<name>" with the shared-texture
+//             DACL.  A signal with nobody waiting stays pending until the
+//             next Wait(), so a check-then-wait loop never misses one.
+//   POSIX     Named semaphore "/<name>".  Signals accumulate instead of
+//             collapsing into one, so a waiter can see spurious wake-ups;
+//             callers re-check their condition anyway.
+//
+// This header deliberately has no Windows dependency; NamedEvent.cpp picks
+// the backend.
+// =============================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace VirtuaCam {
+
+class NamedEvent {
+public:
+    static constexpr uint32_t kInfinite = 0xFFFFFFFF;
+
+    NamedEvent() = default;
+    ~NamedEvent() { Close(); }
+
+    NamedEvent(const NamedEvent&) = delete;
+    NamedEvent& operator=(const NamedEvent&) = delete;
+
+    // Creates the event for waiting on ('name' is a plain identifier).  The
+    // creator's Close() also removes the name on POSIX.
+    bool Create(const std::string& name);
+
+    // Opens an existing event for signalling only.  Fails if no process has
+    // it created (on Windows: if its creator has exited).  On failure
+    // '*missing' tells that case (ERROR_FILE_NOT_FOUND / ENOENT) apart from
+    // any other error, such as access denied or out of handles.
+    bool Open(const std::string& name, bool* missing = nullptr);
+
+    void Close();
+    bool IsOpen() const { return m_handle != nullptr; }
+
+    void Signal();
+
+    // Returns true if signalled, false on timeout or error.
+    bool Wait(uint32_t timeoutMs);
+
+    // The HANDLE on Windows (for WaitForMultipleObjects); the sem_t* on POSIX.
+    void* NativeHandle() const { return m_handle; }
+
+private:
+    void* m_handle = nullptr;
+    std::string m_createdName;     // POSIX: name to unlink on Close()
+};
+
+}
@@ -0,0 +1,164 @@
+// =============================================================================
+// NoSignal.cpp  --  CPU rasteriser for the "No Signal" placeholder frame
+// =============================================================================
+// See NoSignal.h for the public contract.
+//
+// The SIMD gradient kernels evaluate exactly the scalar expression sequence
+// (separate multiplies and adds, no FMA contraction, IEEE sqrt and truncating
+// conversion), so all levels agree bit for bit.  AVX-512 reuses the AVX2
+// kernel: at 8 pixels per step the pass is already bound by the stores.
+// =============================================================================
+
+#include "NoSignal.h"
+#include "NoSignalMask.h"
+#include "Scaler.h"
+#include "Blend.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if VCAM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace VirtuaCam {
+
+namespace
+{
+    // Slightly cool dark grey in the centre, falling off to near-black at the
+    // corners.
+    constexpr float kCenterR = 24.0f, kCenterG = 26.0f, kCenterB = 30.0f;
+    constexpr float kEdgeR   =  7.0f, kEdgeG   =  8.0f, kEdgeB   = 10.0f;
+    constexpr uint32_t kTextColor = 0xFF8A8F98;  // soft grey, slightly cool
+
+    struct Gradient {
+        float cx, cy, invMaxDist;
+    };
+
+    using GradientRowFn = void (*)(uint32_t* row, uint32_t begin, uint32_t width, float dy, const Gradient& g);
+
+    void GradientRow_Scalar(uint32_t* row, uint32_t begin, uint32_t width, float dy, const Gradient& g)
+    {
+        const float dy2 = dy * dy;
+        for (uint32_t x = begin; x < width; x++)
+        {
+            const float dx = (float)x - g.cx;
+            float t = std::sqrt(dx * dx + dy2) * g.invMaxDist;
+            t = t * t * (3.0f - 2.0f * t);  // smoothstep for a soft falloff
+            const uint32_t r = (uint32_t)(kCenterR + (kEdgeR - kCenterR) * t);
+            const uint32_t gg = (uint32_t)(kCenterG + (kEdgeG - kCenterG) * t);
+            const uint32_t b = (uint32_t)(kCenterB + (kEdgeB - kCenterB) * t);
+            row[x] = 0xFF000000u | (r << 16) | (gg << 8) | b;
+        }
+    }
+
+#if VCAM_SIMD_X86
+    VCAM_TARGET_SSE41 void GradientRow_SSE41(uint32_t* row, uint32_t begin, uint32_t width, float dy, const Gradient& g)
+    {
+        const __m128 dy2 = _mm_set1_ps(dy * dy);
+        const __m128 cx = _mm_set1_ps(g.cx);
+        const __m128 inv = _mm_set1_ps(g.invMaxDist);
+        const __m128 three = _mm_set1_ps(3.0f), two = _mm_set1_ps(2.0f);
+        const __m128 cR = _mm_set1_ps(kCenterR), sR = _mm_set1_ps(kEdgeR - kCenterR);
+        const __m128 cG = _mm_set1_ps(kCenterG), sG = _mm_set1_ps(kEdgeG - kCenterG);
+        const __m128 cB = _mm_set1_ps(kCenterB), sB = _mm_set1_ps(kEdgeB - kCenterB);
+        const __m128i alpha = _mm_set1_epi32((int)0xFF000000u);
+        __m128i xs = _mm_add_epi32(_mm_set1_epi32((int)begin), _mm_setr_epi32(0, 1, 2, 3));
+
+        uint32_t x = begin;
+        for (; x + 4 <= width; x += 4, xs = _mm_add_epi32(xs, _mm_set1_epi32(4)))
+        {
+            const __m128 dx = _mm_sub_ps(_mm_cvtepi32_ps(xs), cx);
+            __m128 t = _mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), dy2)), inv);
+            t = _mm_mul_ps(_mm_mul_ps(t, t), _mm_sub_ps(three, _mm_mul_ps(two, t)));
+            const __m128i r = _mm_cvttps_epi32(_mm_add_ps(cR, _mm_mul_ps(sR, t)));
+            const __m128i gg = _mm_cvttps_epi32(_mm_add_ps(cG, _mm_mul_ps(sG, t)));
+            const __m128i b = _mm_cvttps_epi32(_mm_add_ps(cB, _mm_mul_ps(sB, t)));
+            const __m128i px = _mm_or_si128(_mm_or_si128(alpha, _mm_slli_epi32(r, 16)),
+                                            _mm_or_si128(_mm_slli_epi32(gg, 8), b));
+            _mm_storeu_si128((__m128i*)(row + x), px);
+        }
+        GradientRow_Scalar(row, x, width, dy, g);
+    }
+
+    VCAM_TARGET_AVX2 void GradientRow_AVX2(uint32_t* row, uint32_t begin, uint32_t width, float dy, const Gradient& g)
+    {
+        const __m256 dy2 = _mm256_set1_ps(dy * dy);
+        const __m256 cx = _mm256_set1_ps(g.cx);
+        const __m256 inv = _mm256_set1_ps(g.invMaxDist);
+        const __m256 three = _mm256_set1_ps(3.0f), two = _mm256_set1_ps(2.0f);
+        const __m256 cR = _mm256_set1_ps(kCenterR), sR = _mm256_set1_ps(kEdgeR - kCenterR);
+        const __m256 cG = _mm256_set1_ps(kCenterG), sG = _mm256_set1_ps(kEdgeG - kCenterG);
+        const __m256 cB = _mm256_set1_ps(kCenterB), sB = _mm256_set1_ps(kEdgeB - kCenterB);
+        const __m256i alpha = _mm256_set1_epi32((int)0xFF000000u);
+        __m256i xs = _mm256_add_epi32(_mm256_set1_epi32((int)begin), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+        uint32_t x = begin;
+        for (; x + 8 <= width; x += 8, xs = _mm256_add_epi32(xs, _mm256_set1_epi32(8)))
+        {
+            const __m256 dx = _mm256_sub_ps(_mm256_cvtepi32_ps(xs), cx);
+            __m256 t = _mm256_mul_ps(_mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), dy2)), inv);
+            t = _mm256_mul_ps(_mm256_mul_ps(t, t), _mm256_sub_ps(three, _mm256_mul_ps(two, t)));
+            const __m256i r = _mm256_cvttps_epi32(_mm256_add_ps(cR, _mm256_mul_ps(sR, t)));
+            const __m256i gg = _mm256_cvttps_epi32(_mm256_add_ps(cG, _mm256_mul_ps(sG, t)));
+            const __m256i b = _mm256_cvttps_epi32(_mm256_add_ps(cB, _mm256_mul_ps(sB, t)));
+            const __m256i px = _mm256_or_si256(_mm256_or_si256(alpha, _mm256_slli_epi32(r, 16)),
+                                               _mm256_or_si256(_mm256_slli_epi32(gg, 8), b));
+            _mm256_storeu_si256((__m256i*)(row + x), px);
+        }
+        GradientRow_SSE41(row, x, width, dy, g);
+    }
+#endif
+
+    GradientRowFn SelectGradientRow(SimdLevel level)
+    {
+#if VCAM_SIMD_X86
+        switch (ClampSimdLevel(level))
+        {
+        case SimdLevel::AVX512:
+        case SimdLevel::AVX2:   return GradientRow_AVX2;
+        case SimdLevel::SSE41:  return GradientRow_SSE41;
+        default:                break;
+        }
+#else
+        (void)level;
+#endif
+        return GradientRow_Scalar;
+    }
+}
+
+void RenderNoSignalFrame(uint32_t* pixels, uint32_t width, uint32_t height, WorkerPool& pool, SimdLevel level)
+{
+    if (!pixels || !width || !height)
+        return;
+
+    // Background: radial gradient with a smoothstep falloff.
+    Gradient g;
+    g.cx = width * 0.5f;
+    g.cy = height * 0.5f;
+    g.invMaxDist = 1.0f / std::sqrt(g.cx * g.cx + g.cy * g.cy);
+    const GradientRowFn gradientRow = SelectGradientRow(level);
+    pool.ParallelBands(height, 1, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd) {
+        for (uint32_t y = rowBegin; y < rowEnd; y++)
+            gradientRow(pixels + (size_t)y * width, 0, width, (float)y - g.cy, g);
+    });
+
+    // Wordmark: ~1/12th of the frame height, never wider than half the frame,
+    // resampled from the mask (bilinear) and coverage-blended over the gradient.
+    float scale = (height / 12.0f) / kNoSignalMaskHeight;
+    if (kNoSignalMaskWidth * scale > width * 0.5f)
+        scale = (width * 0.5f) / kNoSignalMaskWidth;
+    const uint32_t outW = std::max(1u, (uint32_t)(kNoSignalMaskWidth  * scale));
+    const uint32_t outH = std::max(1u, (uint32_t)(kNoSignalMaskHeight * scale));
+    const int32_t originX = ((int32_t)width  - (int32_t)outW) / 2;
+    const int32_t originY = ((int32_t)height - (int32_t)outH) / 2;
+
+    std::vector<uint8_t> mask((size_t)outW * outH);
+    Scaler(kNoSignalMaskWidth, kNoSignalMaskHeight, outW, outH, ScaleFilter::Bilinear)
+        .Scale(kNoSignalMask, kNoSignalMaskWidth, mask.data(), outW, 1, level);
+
+    const BgraSurface surface{ reinterpret_cast<uint8_t*>(pixels), (ptrdiff_t)width * 4, width, height };
+    BlendMask(surface, originX, originY, mask.data(), outW, outW, outH, kTextColor, level);
+}
+
+}
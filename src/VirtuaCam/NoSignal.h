@@ -0,0 +1,33 @@
+// =============================================================================
+// NoSignal.h  --  CPU rasteriser for the "No Signal" placeholder frame
+// =============================================================================
+// The placeholder is a subtle dark radial-gradient background with the
+// pre-rendered "NO SIGNAL" wordmark (Selawik, letter-spaced, see
+// NoSignalMask.h) blended in the centre.
+//
+// The gradient is the only per-pixel work that scales with the frame (one
+// square root per pixel), so it runs as SSE4.1 / AVX2 float kernels banded on
+// the worker pool; every level produces the same pixels as the scalar
+// reference.  The wordmark is resampled with Scaler and blended with
+// BlendMask.
+//
+// CreateNoSignalTexture() (Tools.h) caches the result per frame size; this
+// module only draws.
+//
+// This header (and NoSignal.cpp) deliberately has no Windows dependency.
+// =============================================================================
+
+#pragma once
+
+#include <cstdint>
+#include "Simd.h"
+#include "WorkerPool.h"
+
+namespace VirtuaCam {
+
+// Draws the placeholder into 'pixels' (width x height, tightly packed BGRA,
+// 0xAARRGGBB as little-endian uint32).
+void RenderNoSignalFrame(uint32_t* pixels, uint32_t width, uint32_t height,
+                         WorkerPool& pool = WorkerPool::Shared(), SimdLevel level = GetSimdLevel());
+
+}
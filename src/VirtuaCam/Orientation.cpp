@@ -0,0 +1,305 @@
+// =============================================================================
+// Orientation.cpp  --  Mirror / rotate transforms for BGRA frames
+// =============================================================================
+// See Orientation.h for the public contract.
+//
+// Source pixel (x, y) of a w x h frame lands at
+//
+//   None   (x', y)              Cw180  (w-1-x', h-1-y)
+//   Cw90   (h-1-y, x')          Cw270  (y, w-1-x')
+//
+// with x' = w-1-x when mirrored and x otherwise.  For the transposing cases
+// the destination row of source column x is therefore x when (Cw90 xor
+// mirror) and w-1-x otherwise, and the destination column of source row y is
+// h-1-y (Cw90) or y (Cw270).  A transposed block loads its source rows bottom
+// up for Cw90, so each transposed register is already in destination order.
+// =============================================================================
+
+#include "Orientation.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if VCAM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace VirtuaCam {
+
+namespace
+{
+    // Where the transposing cases put things (see the file header).
+    struct TransposeMap {
+        uint32_t width, height;
+        bool cw90;
+        bool forwardRows;   // destination row of column x is x (else w-1-x)
+
+        uint32_t DstRow(uint32_t x) const { return forwardRows ? x : width - 1 - x; }
+        uint32_t DstCol(uint32_t y) const { return cw90 ? height - 1 - y : y; }
+    };
+
+    inline uint32_t* Pixel(uint8_t* base, ptrdiff_t stride, uint32_t x, uint32_t y)
+    {
+        return reinterpret_cast<uint32_t*>(base + (ptrdiff_t)y * stride) + x;
+    }
+
+    // -----------------------------------------------------------------------
+    // Row copies (None / Cw180)
+    // -----------------------------------------------------------------------
+
+    using ReverseRowFn = void (*)(uint32_t* dst, const uint32_t* src, uint32_t count);
+
+    void ReverseRow_Scalar(uint32_t* dst, const uint32_t* src, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+            dst[count - 1 - i] = src[i];
+    }
+
+    // -----------------------------------------------------------------------
+    // Transposition (Cw90 / Cw270), 'rows' x 'cols' block of the source
+    // starting at local row 'r0' (absolute row y0) and column x0.
+    // -----------------------------------------------------------------------
+
+    using TransposeBlockFn = void (*)(const uint8_t* rows, ptrdiff_t rowsStride, uint32_t r0, uint32_t y0, uint32_t x0,
+                                      uint8_t* dst, ptrdiff_t dstStride, const TransposeMap& map);
+
+    void TransposePixels(const uint8_t* rows, ptrdiff_t rowsStride, uint32_t r0, uint32_t y0, uint32_t x0,
+                         uint32_t rowCount, uint32_t colCount,
+                         uint8_t* dst, ptrdiff_t dstStride, const TransposeMap& map)
+    {
+        for (uint32_t j = 0; j < colCount; ++j)
+        {
+            uint32_t* out = reinterpret_cast<uint32_t*>(dst + (ptrdiff_t)map.DstRow(x0 + j) * dstStride);
+            for (uint32_t k = 0; k < rowCount; ++k)
+            {
+                const uint32_t* in = reinterpret_cast<const uint32_t*>(rows + (ptrdiff_t)(r0 + k) * rowsStride) + x0 + j;
+                out[map.DstCol(y0 + k)] = *in;
+            }
+        }
+    }
+
+#if VCAM_SIMD_X86
+    VCAM_TARGET_SSE41 void ReverseRow_SSE41(uint32_t* dst, const uint32_t* src, uint32_t count)
+    {
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            _mm_storeu_si128((__m128i*)(dst + count - 4 - i), _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3)));
+        }
+        ReverseRow_Scalar(dst, src + i, count - i);
+    }
+
+    VCAM_TARGET_AVX2 void ReverseRow_AVX2(uint32_t* dst, const uint32_t* src, uint32_t count)
+    {
+        const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+        uint32_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+            _mm256_storeu_si256((__m256i*)(dst + count - 8 - i), _mm256_permutevar8x32_epi32(v, reverse));
+        }
+        ReverseRow_SSE41(dst, src + i, count - i);
+    }
+
+    // 4x4 block: source rows are loaded bottom-up for Cw90 so every
+    // transposed register is a destination row segment in order.
+    VCAM_TARGET_SSE41 void TransposeBlock_SSE41(const uint8_t* rows, ptrdiff_t rowsStride, uint32_t r0, uint32_t y0, uint32_t x0,
+                                                uint8_t* dst, ptrdiff_t dstStride, const TransposeMap& map)
+    {
+        __m128i v[4];
+        for (uint32_t k = 0; k < 4; ++k)
+        {
+            const uint32_t r = map.cw90 ? r0 + 3 - k : r0 + k;
+            v[k] = _mm_loadu_si128((const __m128i*)(rows + (ptrdiff_t)r * rowsStride + (ptrdiff_t)x0 * 4));
+        }
+        const __m128i t0 = _mm_unpacklo_epi32(v[0], v[1]), t1 = _mm_unpackhi_epi32(v[0], v[1]);
+        const __m128i t2 = _mm_unpacklo_epi32(v[2], v[3]), t3 = _mm_unpackhi_epi32(v[2], v[3]);
+        const __m128i o[4] = {
+            _mm_unpacklo_epi64(t0, t2), _mm_unpackhi_epi64(t0, t2),
+            _mm_unpacklo_epi64(t1, t3), _mm_unpackhi_epi64(t1, t3),
+        };
+        const uint32_t col = map.cw90 ? map.DstCol(y0 + 3) : map.DstCol(y0);
+        for (uint32_t j = 0; j < 4; ++j)
+            _mm_storeu_si128((__m128i*)Pixel(dst, dstStride, col, map.DstRow(x0 + j)), o[j]);
+    }
+
+    VCAM_TARGET_AVX2 void TransposeBlock_AVX2(const uint8_t* rows, ptrdiff_t rowsStride, uint32_t r0, uint32_t y0, uint32_t x0,
+                                              uint8_t* dst, ptrdiff_t dstStride, const TransposeMap& map)
+    {
+        __m256i v[8];
+        for (uint32_t k = 0; k < 8; ++k)
+        {
+            const uint32_t r = map.cw90 ? r0 + 7 - k : r0 + k;
+            v[k] = _mm256_loadu_si256((const __m256i*)(rows + (ptrdiff_t)r * rowsStride + (ptrdiff_t)x0 * 4));
+        }
+        // Classic 8x8 dword transpose: 32-bit, 64-bit, then 128-bit interleave.
+        __m256i a[8], b[8];
+        for (uint32_t k = 0; k < 8; k += 2)
+        {
+            a[k]     = _mm256_unpacklo_epi32(v[k], v[k + 1]);
+            a[k + 1] = _mm256_unpackhi_epi32(v[k], v[k + 1]);
+        }
+        for (uint32_t k = 0; k < 8; k += 4)
+        {
+            b[k]     = _mm256_unpacklo_epi64(a[k], a[k + 2]);
+            b[k + 1] = _mm256_unpackhi_epi64(a[k], a[k + 2]);
+            b[k + 2] = _mm256_unpacklo_epi64(a[k + 1], a[k + 3]);
+            b[k + 3] = _mm256_unpackhi_epi64(a[k + 1], a[k + 3]);
+        }
+        __m256i o[8];
+        for (uint32_t k = 0; k < 4; ++k)
+        {
+            o[k]     = _mm256_permute2x128_si256(b[k], b[k + 4], 0x20);
+            o[k + 4] = _mm256_permute2x128_si256(b[k], b[k + 4], 0x31);
+        }
+        const uint32_t col = map.cw90 ? map.DstCol(y0 + 7) : map.DstCol(y0);
+        for (uint32_t j = 0; j < 8; ++j)
+            _mm256_storeu_si256((__m256i*)Pixel(dst, dstStride, col, map.DstRow(x0 + j)), o[j]);
+    }
+#endif
+
+    struct Kernels {
+        ReverseRowFn reverse;
+        TransposeBlockFn transpose;     // null for the scalar level
+        uint32_t block;
+    };
+
+    Kernels SelectKernels(SimdLevel level)
+    {
+#if VCAM_SIMD_X86
+        switch (ClampSimdLevel(level))
+        {
+        case SimdLevel::AVX512:
+        case SimdLevel::AVX2:   return { ReverseRow_AVX2, TransposeBlock_AVX2, 8 };
+        case SimdLevel::SSE41:  return { ReverseRow_SSE41, TransposeBlock_SSE41, 4 };
+        default:                break;
+        }
+#else
+        (void)level;
+#endif
+        return { ReverseRow_Scalar, nullptr, 8 };
+    }
+}
+
+bool RotationFromDegrees(int degrees, Rotation& rotation)
+{
+    const int normalized = ((degrees % 360) + 360) % 360;
+    switch (normalized)
+    {
+    case 0:   rotation = Rotation::None;  return true;
+    case 90:  rotation = Rotation::Cw90;  return true;
+    case 180: rotation = Rotation::Cw180; return true;
+    case 270: rotation = Rotation::Cw270; return true;
+    default:  return false;
+    }
+}
+
+void OrientedSize(uint32_t width, uint32_t height, Orientation orientation,
+                  uint32_t& outWidth, uint32_t& outHeight)
+{
+    outWidth  = orientation.SwapsAxes() ? height : width;
+    outHeight = orientation.SwapsAxes() ? width : height;
+}
+
+void WriteOrientedRows(const uint8_t* rows, ptrdiff_t rowsStride,
+                       uint32_t width, uint32_t height, uint32_t rowBegin, uint32_t rowEnd,
+                       uint8_t* dst, ptrdiff_t dstStride, Orientation orientation, SimdLevel level)
+{
+    if (!rows || !dst || rowBegin >= rowEnd)
+        return;
+    const Kernels kernels = SelectKernels(level);
+    const uint32_t count = rowEnd - rowBegin;
+
+    if (!orientation.SwapsAxes())
+    {
+        const bool flip = orientation.rotation == Rotation::Cw180;
+        const bool reverse = orientation.mirror != flip;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const uint32_t y = rowBegin + i;
+            const uint32_t* in = reinterpret_cast<const uint32_t*>(rows + (ptrdiff_t)i * rowsStride);
+            uint32_t* out = Pixel(dst, dstStride, 0, flip ? height - 1 - y : y);
+            if (reverse)
+                kernels.reverse(out, in, width);
+            else
+                std::memcpy(out, in, (size_t)width * 4);
+        }
+        return;
+    }
+
+    TransposeMap map;
+    map.width = width;
+    map.height = height;
+    map.cw90 = orientation.rotation == Rotation::Cw90;
+    map.forwardRows = map.cw90 != orientation.mirror;
+
+    const uint32_t block = kernels.block;
+    for (uint32_t r0 = 0; r0 < count; r0 += block)
+    {
+        const uint32_t rowCount = std::min(block, count - r0);
+        for (uint32_t x0 = 0; x0 < width; x0 += block)
+        {
+            const uint32_t colCount = std::min(block, width - x0);
+            if (kernels.transpose && rowCount == block && colCount == block)
+                kernels.transpose(rows, rowsStride, r0, rowBegin + r0, x0, dst, dstStride, map);
+            else
+                TransposePixels(rows, rowsStride, r0, rowBegin + r0, x0, rowCount, colCount, dst, dstStride, map);
+        }
+    }
+}
+
+void OrientBGRA(const uint8_t* src, ptrdiff_t srcStride, uint32_t width, uint32_t height,
+                uint8_t* dst, ptrdiff_t dstStride, Orientation orientation, SimdLevel level)
+{
+    WriteOrientedRows(src, srcStride, width, height, 0, height, dst, dstStride, orientation, level);
+}
+
+void OrientBGRAParallel(const uint8_t* src, ptrdiff_t srcStride, uint32_t width, uint32_t height,
+                        uint8_t* dst, ptrdiff_t dstStride, Orientation orientation,
+                        WorkerPool& pool, SimdLevel level)
+{
+    if (!src || !dst)
+        return;
+    pool.ParallelBands(height, 8, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd) {
+        WriteOrientedRows(src + (ptrdiff_t)rowBegin * srcStride, srcStride, width, height, rowBegin, rowEnd,
+                          dst, dstStride, orientation, level);
+    });
+}
+
+void ProduceOriented(uint32_t width, uint32_t height, const OrientedRowProducer& produce,
+                     uint8_t* dst, ptrdiff_t dstStride, Orientation orientation,
+                     WorkerPool& pool, SimdLevel level)
+{
+    if (!dst || !width || !height)
+        return;
+
+    if (orientation.IsIdentity())
+    {
+        pool.ParallelBands(height, kOrientChunkRows, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd) {
+            for (uint32_t y = rowBegin; y < rowEnd; y += kOrientChunkRows)
+            {
+                const uint32_t end = std::min(y + kOrientChunkRows, rowEnd);
+                produce(y, end, dst + (ptrdiff_t)y * dstStride, dstStride);
+            }
+        });
+        return;
+    }
+
+    pool.ParallelBands(height, kOrientChunkRows, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd) {
+        // One chunk of source rows per thread, reused for every frame.
+        thread_local std::vector<uint8_t> scratch;
+        const ptrdiff_t stride = (ptrdiff_t)width * 4;
+        if (scratch.size() < (size_t)stride * kOrientChunkRows)
+            scratch.resize((size_t)stride * kOrientChunkRows);
+
+        for (uint32_t y = rowBegin; y < rowEnd; y += kOrientChunkRows)
+        {
+            const uint32_t end = std::min(y + kOrientChunkRows, rowEnd);
+            produce(y, end, scratch.data(), stride);
+            WriteOrientedRows(scratch.data(), stride, width, height, y, end, dst, dstStride, orientation, level);
+        }
+    });
+}
+
+}
@@ -0,0 +1,83 @@
+// =============================================================================
+// Orientation.h  --  Mirror / rotate transforms for BGRA frames
+// =============================================================================
+// Webcams want a horizontal mirror; phone and document cameras want 90/180/270
+// degree rotation.  Rather than an extra full-frame pass, the transform is
+// applied where pixels are produced: a conversion or scaling kernel writes a
+// few source rows into a small, cache-resident scratch band and
+// WriteOrientedRows() stores that band at its final, oriented position.  Every
+// pixel is read once from the source and written once to the destination.
+//
+// The 90/270 cases are transpositions, done in 8x8 (AVX2) or 4x4 (SSE4.1)
+// register blocks so both the scratch reads and the destination writes stay
+// sequential within a block.  Mirror / 180 are reversed or plain row copies.
+// All levels produce identical output (they only move pixels).
+//
+// Orientation semantics: the mirror (horizontal flip of the source) is applied
+// first, then the clockwise rotation.  90/270 swap the frame's width and
+// height (OrientedSize()).
+//
+// This header (and Orientation.cpp) deliberately has no Windows dependency.
+// =============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include "Simd.h"
+#include "WorkerPool.h"
+
+namespace VirtuaCam {
+
+enum class Rotation : uint32_t {
+    None  = 0,
+    Cw90  = 90,
+    Cw180 = 180,
+    Cw270 = 270,
+};
+
+struct Orientation {
+    bool mirror = false;
+    Rotation rotation = Rotation::None;
+
+    bool IsIdentity() const { return !mirror && rotation == Rotation::None; }
+    bool SwapsAxes() const  { return rotation == Rotation::Cw90 || rotation == Rotation::Cw270; }
+};
+
+// Accepts 0/90/180/270 (and their equivalents modulo 360, e.g. -90).
+bool RotationFromDegrees(int degrees, Rotation& rotation);
+
+// Size of a width x height frame after the transform.
+void OrientedSize(uint32_t width, uint32_t height, Orientation orientation,
+                  uint32_t& outWidth, uint32_t& outHeight);
+
+// Stores source rows [rowBegin, rowEnd) of a width x height BGRA frame at
+// their oriented position in 'dst'.  'rows' points at source row rowBegin.
+void WriteOrientedRows(const uint8_t* rows, ptrdiff_t rowsStride,
+                       uint32_t width, uint32_t height, uint32_t rowBegin, uint32_t rowEnd,
+                       uint8_t* dst, ptrdiff_t dstStride, Orientation orientation,
+                       SimdLevel level = GetSimdLevel());
+
+// Stand-alone pass for frames that are already BGRA.
+void OrientBGRA(const uint8_t* src, ptrdiff_t srcStride, uint32_t width, uint32_t height,
+                uint8_t* dst, ptrdiff_t dstStride, Orientation orientation,
+                SimdLevel level = GetSimdLevel());
+
+void OrientBGRAParallel(const uint8_t* src, ptrdiff_t srcStride, uint32_t width, uint32_t height,
+                        uint8_t* dst, ptrdiff_t dstStride, Orientation orientation,
+                        WorkerPool& pool = WorkerPool::Shared(), SimdLevel level = GetSimdLevel());
+
+// Fused driver: 'produce' fills source rows [rowBegin, rowEnd) as BGRA into
+// 'rows' (row rowBegin first).  Chunks are at most kOrientChunkRows rows and
+// start on a multiple of it (so 4:2:0 sources always start on a chroma row).
+// With the identity transform 'produce' writes straight into 'dst'.
+using OrientedRowProducer = std::function<void(uint32_t rowBegin, uint32_t rowEnd, uint8_t* rows, ptrdiff_t stride)>;
+
+constexpr uint32_t kOrientChunkRows = 16;
+
+void ProduceOriented(uint32_t width, uint32_t height, const OrientedRowProducer& produce,
+                     uint8_t* dst, ptrdiff_t dstStride, Orientation orientation,
+                     WorkerPool& pool = WorkerPool::Shared(), SimdLevel level = GetSimdLevel());
+
+}
@@ -17,11 +17,17 @@
 //   module.Process() then sleeps 1 ms.  Each producer only does GPU work
 //   when a new source frame is actually available, so ~1000 polls/sec is
 //   plenty of headroom for 30-120 fps without burning a full CPU core.
+//
+// Directory registration:
+//   Once the producer has initialised (and so created its manifest), the host
+//   registers the process in the shared producer directory, which is how
+//   Discovery finds it, and deregisters before shutting the producer down.
 // =============================================================================
 
 #include "pch.h"
 #include "Process.h"
 #include "Resource.h"
+#include "ProducerDirectory.h"
 #include <string>
 #include <sstream>
 #include <map>
@@ -95,7 +101,13 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPWSTR
         FreeLibrary(module.hModule);
         return 3;
     }
-    
+
+    // Advertise this producer to Discovery.  A full directory or a failed
+    // open only hides the stream; the producer itself keeps running.
+    VirtuaCam::ProducerDirectory directory;
+    VirtuaCam::ProducerDirectory::Entry registration;
+    const bool registered = directory.Open() && directory.Register(GetCurrentProcessId(), registration);
+
     // Cooperative frame loop: drain Windows messages first, then call the
     // producer's ProcessFrame().  Sleep(1) yields the thread for ~1 ms so we
     // don't spin a full CPU core while waiting for the next camera/capture frame.
@@ -114,6 +126,8 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPWSTR
         }
     }
 
+    if (registered)
+        directory.Deregister(registration);
     module.Shutdown();
     FreeLibrary(module.hModule);
     CoUninitialize();
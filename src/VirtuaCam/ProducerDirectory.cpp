@@ -0,0 +1,206 @@
+// =============================================================================
+// ProducerDirectory.cpp  --  Shared-memory table of live producer processes
+// =============================================================================
+// See ProducerDirectory.h for the layout and the concurrency rules.
+//
+// Producer slots and subscriber slots share the word format and the release
+// code.  Notify() bumps the sequence before it signals, so a
+// subscriber that wakes always sees the new count, and a subscriber that
+// checks the count just before the bump finds its event already set when it
+// goes to wait.
+// =============================================================================
+
+#include "ProducerDirectory.h"
+
+namespace VirtuaCam {
+
+bool ProducerDirectory::Open(const std::string& name, Access access)
+{
+    Close();
+    if (!m_region.Open(name, kRegionBytes, access))
+        return false;
+
+    // A fresh region is all zeroes; the first writable opener stamps the
+    // header.  A read-only opener cannot, and waits for one that can.
+    Layout* layout = static_cast<Layout*>(m_region.Data());
+    const uint64_t header = ((uint64_t)kVersion << 32) | kMagic;
+    uint64_t expected = 0;
+    const bool stamped = access == Access::ReadOnly
+                             ? layout->header.load(std::memory_order_acquire) == header
+                             : layout->header.compare_exchange_strong(expected, header, std::memory_order_acq_rel) ||
+                                   expected == header;
+    if (!stamped)
+    {
+        m_region.Close();
+        return false;
+    }
+    m_layout = layout;
+    m_readOnly = access == Access::ReadOnly;
+    m_name = name;
+    return true;
+}
+
+void ProducerDirectory::Close()
+{
+    Unsubscribe();
+    m_layout = nullptr;
+    m_readOnly = false;
+    m_region.Close();
+}
+
+ProducerDirectory::Entry ProducerDirectory::MakeEntry(uint32_t slot, uint64_t word)
+{
+    Entry entry;
+    entry.slot = slot;
+    entry.processId = ProcessIdOf(word);
+    entry.generation = GenerationOf(word);
+    entry.word = word;
+    return entry;
+}
+
+bool ProducerDirectory::Claim(std::atomic<uint64_t>* slots, uint32_t count, uint32_t processId, Entry& entry)
+{
+    // Prefer a slot still holding this PID (stale, from a crashed process
+    // the PID was recycled from); otherwise the first empty one.
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint64_t word = slots[i].load(std::memory_order_acquire);
+            if (ProcessIdOf(word) != (pass == 0 ? processId : 0))
+                continue;
+            const uint64_t claimed = MakeWord(processId, GenerationOf(word) + 1);
+            if (slots[i].compare_exchange_strong(word, claimed, std::memory_order_acq_rel))
+            {
+                entry = MakeEntry(i, claimed);
+                return true;
+            }
+            // Lost the race for this slot; keep looking.
+        }
+    }
+    return false;
+}
+
+bool ProducerDirectory::Release(std::atomic<uint64_t>* slots, uint32_t count, const Entry& entry)
+{
+    if (entry.slot >= count || !ProcessIdOf(entry.word))
+        return false;
+    uint64_t expected = entry.word;
+    return slots[entry.slot].compare_exchange_strong(expected, MakeWord(0, GenerationOf(entry.word) + 1),
+                                                     std::memory_order_acq_rel);
+}
+
+bool ProducerDirectory::Register(uint32_t processId, Entry& entry)
+{
+    if (!m_layout || m_readOnly || !processId || !Claim(m_layout->slots, kMaxProducers, processId, entry))
+        return false;
+    Notify();
+    return true;
+}
+
+bool ProducerDirectory::Deregister(const Entry& entry)
+{
+    if (!m_layout || m_readOnly || !Release(m_layout->slots, kMaxProducers, entry))
+        return false;
+    Notify();
+    return true;
+}
+
+void ProducerDirectory::Snapshot(std::vector<Entry>& entries) const
+{
+    entries.clear();
+    if (!m_layout)
+        return;
+    for (uint32_t i = 0; i < kMaxProducers; ++i)
+    {
+        const uint64_t word = m_layout->slots[i].load(std::memory_order_acquire);
+        if (ProcessIdOf(word))
+            entries.push_back(MakeEntry(i, word));
+    }
+}
+
+uint64_t ProducerDirectory::ChangeCount() const
+{
+    return m_layout ? m_layout->changeCount.load(std::memory_order_acquire) : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Change notification
+// ---------------------------------------------------------------------------
+
+std::string ProducerDirectory::WakeEventName(uint32_t slot, uint32_t generation) const
+{
+    return m_name + "_Wake_" + std::to_string(slot) + "_" + std::to_string(generation);
+}
+
+void ProducerDirectory::Notify()
+{
+    if (!m_layout || m_readOnly)
+        return;
+    m_layout->changeCount.fetch_add(1, std::memory_order_acq_rel);
+
+    for (uint32_t i = 0; i < kMaxSubscribers; ++i)
+    {
+        const uint64_t word = m_layout->subscribers[i].load(std::memory_order_acquire);
+        if (!ProcessIdOf(word))
+            continue;
+        NamedEvent wake;
+        bool missing = false;
+        if (wake.Open(WakeEventName(i, GenerationOf(word)), &missing))
+            wake.Signal();
+        else if (missing)
+            Release(m_layout->subscribers, kMaxSubscribers, MakeEntry(i, word));   // subscriber died
+        // Any other failure (no access to a differently privileged
+        // subscriber's event, out of handles) says nothing about the
+        // subscriber: skip it this time, it still sees ChangeCount().
+    }
+}
+
+bool ProducerDirectory::Subscribe()
+{
+    if (!m_layout || m_readOnly || IsSubscribed())
+        return m_layout != nullptr && !m_readOnly;
+
+    // The event exists before the slot is published, so a concurrent
+    // Notify() never mistakes a half-made subscriber for a dead one.  The
+    // subscriber "PID" is only an occupancy marker and need not be unique.
+    const uint32_t marker = (uint32_t)(reinterpret_cast<uintptr_t>(this) >> 4) | 1;
+    for (uint32_t i = 0; i < kMaxSubscribers; ++i)
+    {
+        uint64_t word = m_layout->subscribers[i].load(std::memory_order_acquire);
+        if (ProcessIdOf(word))
+            continue;
+        const uint64_t claimed = MakeWord(marker, GenerationOf(word) + 1);
+        if (!m_wake.Create(WakeEventName(i, GenerationOf(claimed))))
+            return false;
+        if (m_layout->subscribers[i].compare_exchange_strong(word, claimed, std::memory_order_acq_rel))
+        {
+            m_subscription = MakeEntry(i, claimed);
+            return true;
+        }
+        m_wake.Close();
+    }
+    return false;
+}
+
+void ProducerDirectory::Unsubscribe()
+{
+    if (!IsSubscribed())
+        return;
+    if (m_layout)
+        Release(m_layout->subscribers, kMaxSubscribers, m_subscription);
+    m_wake.Close();
+    m_subscription = Entry();
+}
+
+bool ProducerDirectory::WaitForChange(uint64_t seen, uint32_t timeoutMs)
+{
+    if (ChangeCount() != seen)
+        return true;
+    if (!IsSubscribed())
+        return false;
+    m_wake.Wait(timeoutMs);
+    return ChangeCount() != seen;
+}
+
+}
@@ -0,0 +1,170 @@
+// =============================================================================
+// ProducerDirectory.h  --  Shared-memory table of live producer processes
+// =============================================================================
+// Discovery used to find producers by snapshotting every process on the
+// machine and probing each PID for a "DirectPort_Producer_Manifest_<PID>"
+// mapping, on every broker frame.  The directory inverts that: one
+// well-known shared-memory region holds a fixed table of slots, producers
+// register their PID in it when they start and remove it when they stop, and
+// discovery reads the table (a few cache lines) and probes only those PIDs.
+//
+// Layout (kRegionBytes, zero-filled at creation):
+//
+//   header          magic | version, checked on Open()       cache line 0
+//   changeCount     the change sequence: bumped by every Notify()
+//   subscribers[16] subscriber slots, same word format       cache lines 1..2
+//   slots[64]       one 64-bit word each:                    cache lines 3..10
+//                     bits  0..31  PID (0 = empty)
+//                     bits 32..63  generation, +1 on every change of the slot
+//
+// Every change is a single compare-and-swap on a slot word, so producers can
+// come and go concurrently without a lock, and the generation makes each
+// word unique: a Deregister() or Reclaim() that raced with another change
+// fails instead of clearing somebody else's registration (no ABA).
+//
+// A producer that crashes never deregisters.  Readers detect that (on Windows
+// its manifest mapping disappears with the process) and Reclaim() the slot
+// with the word they saw, which fails harmlessly if the slot changed since.
+// Register() also takes over a slot still holding its own PID, left by a
+// crashed process whose PID was recycled.
+//
+// Change notification: every register / deregister / reclaim calls Notify(),
+// which bumps changeCount and signals the wake event (NamedEvent.h) of every
+// subscriber.  A process that wants to block until the producer set changes
+// Subscribe()s (claiming a subscriber slot and creating an event named after
+// it) and calls WaitForChange(seen, timeout) with the count it last acted
+// on.  Processes that already run per frame just compare ChangeCount().
+// A subscriber slot whose event no longer exists belongs to a dead process
+// and is reclaimed by the next Notify(); one whose event exists but cannot
+// be opened (access denied, out of handles) is only skipped.
+//
+// Only producers and the broker create the region.  Processes that just
+// watch it open the existing one: discovery (which also reclaims slots and
+// subscribes) read-write, the Frame Server's BrokerClient read-only.  A
+// reader that created its own would hold an empty table in its own session
+// namespace whose change count never moves.
+//
+// The region and the events sit behind SharedMemoryRegion and NamedEvent, so
+// the table logic runs on the POSIX shm backend as well as on Windows.
+//
+// This header (and ProducerDirectory.cpp) deliberately has no Windows
+// dependency.
+// =============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "NamedEvent.h"
+#include "SharedMemory.h"
+
+namespace VirtuaCam {
+
+class ProducerDirectory {
+public:
+    static constexpr uint32_t kMaxProducers = 64;
+    static constexpr uint32_t kMaxSubscribers = 16;
+    static constexpr uint32_t kMagic = 0x44504356;     // 'VCPD'
+    static constexpr uint32_t kVersion = 2;
+    static constexpr const char* kDefaultName = "DirectPort_Producer_Directory";
+
+    ProducerDirectory() = default;
+    ~ProducerDirectory() { Close(); }
+
+    ProducerDirectory(const ProducerDirectory&) = delete;
+    ProducerDirectory& operator=(const ProducerDirectory&) = delete;
+
+    struct Entry {
+        uint32_t slot = 0;
+        uint32_t processId = 0;
+        uint32_t generation = 0;
+        uint64_t word = 0;          // the slot word as read; identifies this registration
+    };
+
+    using Access = SharedMemoryRegion::Access;
+
+    // Creates or opens the directory region (see SharedMemoryRegion::Access).
+    // Fails if the region exists with a different magic / version, or, when
+    // opening without creating, does not exist or has not been stamped yet.
+    bool Open(const std::string& name = kDefaultName, Access access = Access::CreateOrOpen);
+    void Close();       // also unsubscribes
+    bool IsOpen() const { return m_layout != nullptr; }
+
+    // Opened with Access::ReadOnly: Register, Deregister, Notify and
+    // Subscribe do nothing and report failure.
+    bool IsReadOnly() const { return m_readOnly; }
+
+    // Claims a slot for 'processId'.  Returns false (and leaves 'entry'
+    // untouched) if the table is full.
+    bool Register(uint32_t processId, Entry& entry);
+
+    // Empties the slot 'entry' was registered in, if it still holds that
+    // registration.  Reclaim() is the same operation, used by readers on
+    // entries whose producer has died.
+    bool Deregister(const Entry& entry);
+    bool Reclaim(const Entry& entry) { return Deregister(entry); }
+
+    // Appends every occupied slot to 'entries' (cleared first).
+    void Snapshot(std::vector<Entry>& entries) const;
+
+    // Changes whenever any slot does; lets readers skip work on an unchanged
+    // table.
+    uint64_t ChangeCount() const;
+
+    // Bumps ChangeCount() and wakes every subscriber.  Register, Deregister
+    // and Reclaim call it; a process that publishes something other than a slot (the
+    // broker's output manifest) can call it directly.
+    void Notify();
+
+    // Claims a subscriber slot and creates its wake event.  One subscription
+    // per ProducerDirectory instance.
+    bool Subscribe();
+    void Unsubscribe();
+    bool IsSubscribed() const { return m_wake.IsOpen(); }
+
+    // Blocks until ChangeCount() differs from 'seen', the timeout expires or
+    // Wake() is called.  Returns true if the count changed; a false return
+    // can also be a stale wake-up left by an earlier Notify(), so callers
+    // loop.  Thread-safe against Notify() / Wake() from other threads.
+    bool WaitForChange(uint64_t seen, uint32_t timeoutMs = NamedEvent::kInfinite);
+
+    // Wakes this instance's WaitForChange() without a change (shutdown).
+    void Wake() { m_wake.Signal(); }
+
+    static constexpr uint32_t ProcessIdOf(uint64_t word) { return (uint32_t)word; }
+    static constexpr uint32_t GenerationOf(uint64_t word) { return (uint32_t)(word >> 32); }
+    static constexpr uint64_t MakeWord(uint32_t processId, uint32_t generation)
+    {
+        return ((uint64_t)generation << 32) | processId;
+    }
+
+private:
+    struct alignas(64) Layout {
+        std::atomic<uint64_t> header;
+        std::atomic<uint64_t> changeCount;
+        alignas(64) std::atomic<uint64_t> subscribers[kMaxSubscribers];
+        alignas(64) std::atomic<uint64_t> slots[kMaxProducers];
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "slot words must be lock-free to be shared across processes");
+
+public:
+    static constexpr size_t kRegionBytes = sizeof(Layout);
+
+private:
+    static Entry MakeEntry(uint32_t slot, uint64_t word);
+    static bool Claim(std::atomic<uint64_t>* slots, uint32_t count, uint32_t processId, Entry& entry);
+    static bool Release(std::atomic<uint64_t>* slots, uint32_t count, const Entry& entry);
+    std::string WakeEventName(uint32_t slot, uint32_t generation) const;
+
+    SharedMemoryRegion m_region;
+    Layout* m_layout = nullptr;
+    bool m_readOnly = false;
+    std::string m_name;
+    NamedEvent m_wake;
+    Entry m_subscription;
+};
+
+}
@@ -0,0 +1,744 @@
+// =============================================================================
+// Scaler.cpp  --  CPU image resampling (box / bilinear / Lanczos-3)
+// =============================================================================
+// See Scaler.h for the public contract.
+//
+// Fixed-point pipeline
+// --------------------
+// Weights are 14-bit (each table row sums to exactly 1 << 14).  The vertical
+// pass keeps 6 fractional bits in its int16 intermediate:
+//
+//   mid = (sum(src[k] * wv[k]) + (1 << 7)) >> 8            (~ value * 64)
+//   out = clamp((sum(mid[k] * wh[k]) + (1 << 19)) >> 20, 0, 255)
+//
+// Lanczos overshoot keeps mid within about [-4000, 21000] and the horizontal
+// sums well inside int32, so the SIMD kernels (pmaddwd on interleaved
+// sample/weight pairs) and the scalar reference agree bit for bit.  Identity
+// scaling is exact.
+//
+// SIMD layout
+// -----------
+// Vertical pass: one weight pair per pair of source rows, applied across the
+// whole row width (16 / 32 / 64 samples per step).  Horizontal pass: each
+// output pixel has its own window, so it is gather-bound; SSE4.1 handles one
+// pixel (BGRA, UV) or four pixels (grey) per step and AVX2 two BGRA pixels.
+// AVX-512 reuses the AVX2 horizontal kernel.
+// =============================================================================
+
+#include "Scaler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if VCAM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace VirtuaCam {
+
+namespace
+{
+    constexpr int kWeightBits = 14;
+    constexpr int kVerticalShift = 8;                       // leaves 6 fractional bits
+    constexpr int kHorizontalShift = 2 * kWeightBits - kVerticalShift;
+    constexpr int kVerticalRound = 1 << (kVerticalShift - 1);
+    constexpr int kHorizontalRound = 1 << (kHorizontalShift - 1);
+
+    // -----------------------------------------------------------------------
+    // Filter tables
+    // -----------------------------------------------------------------------
+
+    double FilterSupport(ScaleFilter filter)
+    {
+        switch (filter)
+        {
+        case ScaleFilter::Box:      return 0.5;
+        case ScaleFilter::Lanczos3: return 3.0;
+        default:                    return 1.0;
+        }
+    }
+
+    double Sinc(double x)
+    {
+        if (x == 0.0)
+            return 1.0;
+        x *= 3.14159265358979323846;
+        return std::sin(x) / x;
+    }
+
+    double FilterWeight(ScaleFilter filter, double x)
+    {
+        switch (filter)
+        {
+        case ScaleFilter::Box:
+            return (x > -0.5 && x <= 0.5) ? 1.0 : 0.0;
+        case ScaleFilter::Lanczos3:
+            return (x > -3.0 && x < 3.0) ? Sinc(x) * Sinc(x / 3.0) : 0.0;
+        default:
+            x = std::fabs(x);
+            return x < 1.0 ? 1.0 - x : 0.0;
+        }
+    }
+
+    Scaler::FilterTable BuildFilterTable(uint32_t srcSize, uint32_t dstSize, ScaleFilter filter, AxisMapping mapping)
+    {
+        // Centre-aligned mapping: output sample i covers source interval
+        // [i, i + 1) * scale (shifted by the mapping offset).  When shrinking,
+        // the kernel is widened by the scale factor so it integrates over
+        // every covered source sample.
+        const double scale = mapping.scale > 0.0 ? mapping.scale : double(srcSize) / double(dstSize);
+        const double offset = mapping.scale > 0.0 ? mapping.offset : 0.0;
+        const double filterScale = std::max(scale, 1.0);
+        const double support = FilterSupport(filter) * filterScale;
+
+        std::vector<int32_t> first(dstSize);
+        std::vector<std::vector<double>> windows(dstSize);
+        uint32_t taps = 1;
+        for (uint32_t i = 0; i < dstSize; ++i)
+        {
+            const double center = (i + 0.5) * scale + offset;
+            const int lo = std::max(0, (int)std::floor(center - support + 0.5));
+            const int hi = std::min((int)srcSize, (int)std::floor(center + support + 0.5));
+            std::vector<double>& w = windows[i];
+            double sum = 0.0;
+            for (int k = lo; k < hi; ++k)
+            {
+                w.push_back(FilterWeight(filter, (k + 0.5 - center) / filterScale));
+                sum += w.back();
+            }
+            first[i] = lo;
+            if (sum == 0.0)
+            {
+                // Degenerate window (can only happen at the very edge): nearest.
+                first[i] = std::clamp((int)std::floor(center), 0, (int)srcSize - 1);
+                w.assign(1, 1.0);
+                sum = 1.0;
+            }
+            for (double& v : w)
+                v /= sum;
+            taps = std::max(taps, (uint32_t)w.size());
+        }
+
+        Scaler::FilterTable table;
+        table.taps = taps;
+        table.stride = (taps + 7) & ~7u;
+        table.start.resize(dstSize);
+        table.weights.assign((size_t)dstSize * table.stride, 0);
+        for (uint32_t i = 0; i < dstSize; ++i)
+        {
+            // Fixed-size window: slide it left where it would run off the end.
+            const int start = std::min(first[i], (int)(srcSize - taps));
+            table.start[i] = start;
+            int16_t* dst = &table.weights[(size_t)i * table.stride + (first[i] - start)];
+
+            // Quantise, then fold the rounding residue into the largest tap
+            // so that every row sums to exactly 1 << 14.
+            const std::vector<double>& w = windows[i];
+            int total = 0;
+            size_t largest = 0;
+            for (size_t k = 0; k < w.size(); ++k)
+            {
+                dst[k] = (int16_t)std::lround(w[k] * (1 << kWeightBits));
+                total += dst[k];
+                if (w[k] > w[largest])
+                    largest = k;
+            }
+            dst[largest] = (int16_t)(dst[largest] + ((1 << kWeightBits) - total));
+        }
+        return table;
+    }
+
+    // -----------------------------------------------------------------------
+    // Kernel signatures
+    // -----------------------------------------------------------------------
+
+    // Intermediate samples [begin, end) of one output row.  rows[k] is valid
+    // for k < taps rounded up to 2 (the pad entry repeats the last row and
+    // has zero weight).
+    using VerticalFn = void (*)(const uint8_t* const* rows, const int16_t* weights, uint32_t taps, int16_t* out, uint32_t begin, uint32_t end);
+
+    // Output pixels [begin, end) of one row from its intermediate row.
+    using HorizontalFn = void (*)(const int16_t* in, const Scaler::FilterTable& table, uint8_t* out, uint32_t begin, uint32_t end);
+
+    // 2x2 average of two source rows; 'count' output bytes.
+    using HalveFn = void (*)(const uint8_t* row0, const uint8_t* row1, uint8_t* out, uint32_t count, uint32_t channels);
+
+    inline uint8_t ClampByte(int v)
+    {
+        return (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+    }
+
+    inline int16_t ClampShort(int v)
+    {
+        return (int16_t)(v < -32768 ? -32768 : v > 32767 ? 32767 : v);
+    }
+
+    // -----------------------------------------------------------------------
+    // Scalar reference
+    // -----------------------------------------------------------------------
+
+    void VerticalRow_Scalar(const uint8_t* const* rows, const int16_t* weights, uint32_t taps, int16_t* out, uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            int sum = 0;
+            for (uint32_t k = 0; k < taps; ++k)
+                sum += rows[k][i] * weights[k];
+            out[i] = ClampShort((sum + kVerticalRound) >> kVerticalShift);
+        }
+    }
+
+    template <uint32_t C>
+    void HorizontalRow_Scalar(const int16_t* in, const Scaler::FilterTable& table, uint8_t* out, uint32_t begin, uint32_t end)
+    {
+        for (uint32_t x = begin; x < end; ++x)
+        {
+            const int16_t* src = in + (size_t)table.start[x] * C;
+            const int16_t* w = &table.weights[(size_t)x * table.stride];
+            for (uint32_t c = 0; c < C; ++c)
+            {
+                int sum = 0;
+                for (uint32_t k = 0; k < table.taps; ++k)
+                    sum += src[k * C + c] * w[k];
+                out[x * C + c] = ClampByte((sum + kHorizontalRound) >> kHorizontalShift);
+            }
+        }
+    }
+
+    void HalveRow_Scalar(const uint8_t* row0, const uint8_t* row1, uint8_t* out, uint32_t count, uint32_t channels)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const uint32_t c = i % channels;
+            const uint32_t s = (i - c) * 2 + c;
+            out[i] = (uint8_t)((row0[s] + row0[s + channels] + row1[s] + row1[s + channels] + 2) >> 2);
+        }
+    }
+
+#if VCAM_SIMD_X86
+    // -----------------------------------------------------------------------
+    // SSE4.1
+    // -----------------------------------------------------------------------
+
+    inline int32_t LoadWeightPair(const int16_t* w)
+    {
+        int32_t pair;
+        std::memcpy(&pair, w, sizeof(pair));
+        return pair;
+    }
+
+    VCAM_TARGET_SSE41 void VerticalRow_SSE41(const uint8_t* const* rows, const int16_t* weights, uint32_t taps, int16_t* out, uint32_t begin, uint32_t end)
+    {
+        const __m128i round = _mm_set1_epi32(kVerticalRound);
+        uint32_t i = begin;
+        for (; i + 16 <= end; i += 16)
+        {
+            __m128i acc0 = _mm_setzero_si128(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+            for (uint32_t k = 0; k < taps; k += 2)
+            {
+                const __m128i w = _mm_set1_epi32(LoadWeightPair(weights + k));
+                const __m128i a = _mm_loadu_si128((const __m128i*)(rows[k] + i));
+                const __m128i b = _mm_loadu_si128((const __m128i*)(rows[k + 1] + i));
+                const __m128i aLo = _mm_cvtepu8_epi16(a), aHi = _mm_cvtepu8_epi16(_mm_srli_si128(a, 8));
+                const __m128i bLo = _mm_cvtepu8_epi16(b), bHi = _mm_cvtepu8_epi16(_mm_srli_si128(b, 8));
+                acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(aLo, bLo), w));
+                acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(aLo, bLo), w));
+                acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(aHi, bHi), w));
+                acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(aHi, bHi), w));
+            }
+            acc0 = _mm_srai_epi32(_mm_add_epi32(acc0, round), kVerticalShift);
+            acc1 = _mm_srai_epi32(_mm_add_epi32(acc1, round), kVerticalShift);
+            acc2 = _mm_srai_epi32(_mm_add_epi32(acc2, round), kVerticalShift);
+            acc3 = _mm_srai_epi32(_mm_add_epi32(acc3, round), kVerticalShift);
+            _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(acc0, acc1));
+            _mm_storeu_si128((__m128i*)(out + i + 8), _mm_packs_epi32(acc2, acc3));
+        }
+        if (i < end)
+            VerticalRow_Scalar(rows, weights, taps, out, i, end);
+    }
+
+    VCAM_TARGET_SSE41 inline void StoreBytes(uint8_t* out, __m128i packed, uint32_t bytes)
+    {
+        const uint32_t v = (uint32_t)_mm_cvtsi128_si32(packed);
+        std::memcpy(out, &v, bytes);
+    }
+
+    VCAM_TARGET_SSE41 void HorizontalRow1_SSE41(const int16_t* in, const Scaler::FilterTable& table, uint8_t* out, uint32_t begin, uint32_t end)
+    {
+        const __m128i round = _mm_set1_epi32(kHorizontalRound);
+        uint32_t x = begin;
+        for (; x + 4 <= end; x += 4)
+        {
+            __m128i acc[4];
+            for (uint32_t j = 0; j < 4; ++j)
+            {
+                const int16_t* src = in + table.start[x + j];
+                const int16_t* w = &table.weights[(size_t)(x + j) * table.stride];
+                __m128i sum = _mm_setzero_si128();
+                for (uint32_t k = 0; k < table.taps; k += 8)
+                    sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(src + k)), _mm_loadu_si128((const __m128i*)(w + k))));
+                acc[j] = sum;
+            }
+            __m128i sums = _mm_hadd_epi32(_mm_hadd_epi32(acc[0], acc[1]), _mm_hadd_epi32(acc[2], acc[3]));
+            sums = _mm_srai_epi32(_mm_add_epi32(sums, round), kHorizontalShift);
+            const __m128i words = _mm_packs_epi32(sums, sums);
+            StoreBytes(out + x, _mm_packus_epi16(words, words), 4);
+        }
+        if (x < end)
+            HorizontalRow_Scalar<1>(in, table, out, x, end);
+    }
+
+    VCAM_TARGET_SSE41 void HorizontalRow2_SSE41(const int16_t* in, const Scaler::FilterTable& table, uint8_t* out, uint32_t begin, uint32_t end)
+    {
+        // [u0 v0 u1 v1 u2 v2 u3 v3] -> [u0 u1 v0 v1 u2 u3 v2 v3]
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 4, 5, 2, 3, 6, 7, 8, 9, 12, 13, 10, 11, 14, 15);
+        const __m128i round = _mm_set1_epi32(kHorizontalRound);
+        for (uint32_t x = begin; x < end; ++x)
+        {
+            const int16_t* src = in + (size_t)table.start[x] * 2;
+            const int16_t* w = &table.weights[(size_t)x * table.stride];
+            __m128i acc = _mm_setzero_si128();
+            for (uint32_t k = 0; k < table.taps; k += 4)
+            {
+                const __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + k * 2)), shuffle);
+                const __m128i w4 = _mm_loadl_epi64((const __m128i*)(w + k));
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(v, _mm_unpacklo_epi32(w4, w4)));
+            }
+            acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 8));
+            acc = _mm_srai_epi32(_mm_add_epi32(acc, round), kHorizontalShift);
+            const __m128i words = _mm_packs_epi32(acc, acc);
+            StoreBytes(out + x * 2, _mm_packus_epi16(words, words), 2);
+        }
+    }
+
+    // [b0 g0 r0 a0 b1 g1 r1 a1] -> [b0 b1 g0 g1 r0 r1 a0 a1]
+    VCAM_TARGET_SSE41 inline __m128i PairShuffle4_SSE41()
+    {
+        return _mm_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15);
+    }
+
+    VCAM_TARGET_SSE41 void HorizontalRow4_SSE41(const int16_t* in, const Scaler::FilterTable& table, uint8_t* out, uint32_t begin, uint32_t end)
+    {
+        const __m128i shuffle = PairShuffle4_SSE41();
+        const __m128i round = _mm_set1_epi32(kHorizontalRound);
+        for (uint32_t x = begin; x < end; ++x)
+        {
+            const int16_t* src = in + (size_t)table.start[x] * 4;
+            const int16_t* w = &table.weights[(size_t)x * table.stride];
+            __m128i acc = _mm_setzero_si128();
+            for (uint32_t k = 0; k < table.taps; k += 2)
+            {
+                const __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + k * 4)), shuffle);
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(v, _mm_set1_epi32(LoadWeightPair(w + k))));
+            }
+            acc = _mm_srai_epi32(_mm_add_epi32(acc, round), kHorizontalShift);
+            const __m128i words = _mm_packs_epi32(acc, acc);
+            StoreBytes(out + x * 4, _mm_packus_epi16(words, words), 4);
+        }
+    }
+
+    // Byte regrouping so that pmaddubsw sums horizontally adjacent pixels.
+    VCAM_TARGET_SSE41 inline __m128i HalveShuffle_SSE41(uint32_t channels)
+    {
+        switch (channels)
+        {
+        case 2:  return _mm_setr_epi8(0, 2, 1, 3, 4, 6, 5, 7, 8, 10, 9, 11, 12, 14, 13, 15);
+        case 4:  return _mm_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15);
+        default: return _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        }
+    }
+
+    VCAM_TARGET_SSE41 void HalveRow_SSE41(const uint8_t* row0, const uint8_t* row1, uint8_t* out, uint32_t count, uint32_t channels)
+    {
+        const __m128i shuffle = HalveShuffle_SSE41(channels);
+        const __m128i ones = _mm_set1_epi8(1);
+        const __m128i two = _mm_set1_epi16(2);
+        uint32_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            const uint8_t* s0 = row0 + i * 2;
+            const uint8_t* s1 = row1 + i * 2;
+            __m128i lo = _mm_add_epi16(_mm_maddubs_epi16(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)s0), shuffle), ones),
+                                       _mm_maddubs_epi16(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)s1), shuffle), ones));
+            __m128i hi = _mm_add_epi16(_mm_maddubs_epi16(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(s0 + 16)), shuffle), ones),
+                                       _mm_maddubs_epi16(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(s1 + 16)), shuffle), ones));
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+            _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(lo, hi));
+        }
+        if (i < count)
+            HalveRow_Scalar(row0 + i * 2, row1 + i * 2, out + i, count - i, channels);
+    }
+
+    // -----------------------------------------------------------------------
+    // AVX2
+    // -----------------------------------------------------------------------
+
+    VCAM_TARGET_AVX2 void VerticalRow_AVX2(const uint8_t* const* rows, const int16_t* weights, uint32_t taps, int16_t* out, uint32_t begin, uint32_t end)
+    {
+        const __m256i round = _mm256_set1_epi32(kVerticalRound);
+        uint32_t i = begin;
+        for (; i + 32 <= end; i += 32)
+        {
+            __m256i acc0 = _mm256_setzero_si256(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+            for (uint32_t k = 0; k < taps; k += 2)
+            {
+                const __m256i w = _mm256_set1_epi32(LoadWeightPair(weights + k));
+                const __m256i a = _mm256_loadu_si256((const __m256i*)(rows[k] + i));
+                const __m256i b = _mm256_loadu_si256((const __m256i*)(rows[k + 1] + i));
+                const __m256i aLo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(a)), aHi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(a, 1));
+                const __m256i bLo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(b)), bHi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(b, 1));
+                acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi16(aLo, bLo), w));
+                acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi16(aLo, bLo), w));
+                acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi16(aHi, bHi), w));
+                acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi16(aHi, bHi), w));
+            }
+            acc0 = _mm256_srai_epi32(_mm256_add_epi32(acc0, round), kVerticalShift);
+            acc1 = _mm256_srai_epi32(_mm256_add_epi32(acc1, round), kVerticalShift);
+            acc2 = _mm256_srai_epi32(_mm256_add_epi32(acc2, round), kVerticalShift);
+            acc3 = _mm256_srai_epi32(_mm256_add_epi32(acc3, round), kVerticalShift);
+            // Per-lane unpack + per-lane pack cancel out: samples stay in order.
+            _mm256_storeu_si256((__m256i*)(out + i), _mm256_packs_epi32(acc0, acc1));
+            _mm256_storeu_si256((__m256i*)(out + i + 16), _mm256_packs_epi32(acc2, acc3));
+        }
+        if (i < end)
+            VerticalRow_SSE41(rows, weights, taps, out, i, end);
+    }
+
+    VCAM_TARGET_AVX2 void HorizontalRow4_AVX2(const int16_t* in, const Scaler::FilterTable& table, uint8_t* out, uint32_t begin, uint32_t end)
+    {
+        const __m256i shuffle = _mm256_broadcastsi128_si256(PairShuffle4_SSE41());
+        const __m256i round = _mm256_set1_epi32(kHorizontalRound);
+        uint32_t x = begin;
+        for (; x + 2 <= end; x += 2)
+        {
+            // Low lane: output pixel x, high lane: pixel x + 1.
+            const int16_t* srcA = in + (size_t)table.start[x] * 4;
+            const int16_t* srcB = in + (size_t)table.start[x + 1] * 4;
+            const int16_t* wA = &table.weights[(size_t)x * table.stride];
+            const int16_t* wB = wA + table.stride;
+            __m256i acc = _mm256_setzero_si256();
+            for (uint32_t k = 0; k < table.taps; k += 2)
+            {
+                const __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(srcA + k * 4))),
+                                                          _mm_loadu_si128((const __m128i*)(srcB + k * 4)), 1);
+                const __m256i w = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_set1_epi32(LoadWeightPair(wA + k))),
+                                                          _mm_set1_epi32(LoadWeightPair(wB + k)), 1);
+                acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_shuffle_epi8(v, shuffle), w));
+            }
+            acc = _mm256_srai_epi32(_mm256_add_epi32(acc, round), kHorizontalShift);
+            const __m256i words = _mm256_packs_epi32(acc, acc);
+            const __m256i bytes = _mm256_packus_epi16(words, words);
+            const __m128i pair = _mm_unpacklo_epi32(_mm256_castsi256_si128(bytes), _mm256_extracti128_si256(bytes, 1));
+            _mm_storel_epi64((__m128i*)(out + x * 4), pair);
+        }
+        if (x < end)
+            HorizontalRow4_SSE41(in, table, out, x, end);
+    }
+
+    VCAM_TARGET_AVX2 void HalveRow_AVX2(const uint8_t* row0, const uint8_t* row1, uint8_t* out, uint32_t count, uint32_t channels)
+    {
+        const __m256i shuffle = _mm256_broadcastsi128_si256(HalveShuffle_SSE41(channels));
+        const __m256i ones = _mm256_set1_epi8(1);
+        const __m256i two = _mm256_set1_epi16(2);
+        uint32_t i = 0;
+        for (; i + 32 <= count; i += 32)
+        {
+            const uint8_t* s0 = row0 + i * 2;
+            const uint8_t* s1 = row1 + i * 2;
+            __m256i lo = _mm256_add_epi16(_mm256_maddubs_epi16(_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)s0), shuffle), ones),
+                                          _mm256_maddubs_epi16(_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)s1), shuffle), ones));
+            __m256i hi = _mm256_add_epi16(_mm256_maddubs_epi16(_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(s0 + 32)), shuffle), ones),
+                                          _mm256_maddubs_epi16(_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(s1 + 32)), shuffle), ones));
+            lo = _mm256_srli_epi16(_mm256_add_epi16(lo, two), 2);
+            hi = _mm256_srli_epi16(_mm256_add_epi16(hi, two), 2);
+            const __m256i packed = _mm256_packus_epi16(lo, hi);
+            _mm256_storeu_si256((__m256i*)(out + i), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+        if (i < count)
+            HalveRow_SSE41(row0 + i * 2, row1 + i * 2, out + i, count - i, channels);
+    }
+
+    // -----------------------------------------------------------------------
+    // AVX-512 BW (vertical pass only; see the file header)
+    // -----------------------------------------------------------------------
+
+    VCAM_TARGET_AVX512 void VerticalRow_AVX512(const uint8_t* const* rows, const int16_t* weights, uint32_t taps, int16_t* out, uint32_t begin, uint32_t end)
+    {
+        const __m512i round = _mm512_set1_epi32(kVerticalRound);
+        uint32_t i = begin;
+        for (; i + 64 <= end; i += 64)
+        {
+            __m512i acc0 = _mm512_setzero_si512(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+            for (uint32_t k = 0; k < taps; k += 2)
+            {
+                const __m512i w = _mm512_set1_epi32(LoadWeightPair(weights + k));
+                const __m512i a = _mm512_loadu_si512(rows[k] + i);
+                const __m512i b = _mm512_loadu_si512(rows[k + 1] + i);
+                const __m512i aLo = _mm512_cvtepu8_epi16(_mm512_castsi512_si256(a)), aHi = _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(a, 1));
+                const __m512i bLo = _mm512_cvtepu8_epi16(_mm512_castsi512_si256(b)), bHi = _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(b, 1));
+                acc0 = _mm512_add_epi32(acc0, _mm512_madd_epi16(_mm512_unpacklo_epi16(aLo, bLo), w));
+                acc1 = _mm512_add_epi32(acc1, _mm512_madd_epi16(_mm512_unpackhi_epi16(aLo, bLo), w));
+                acc2 = _mm512_add_epi32(acc2, _mm512_madd_epi16(_mm512_unpacklo_epi16(aHi, bHi), w));
+                acc3 = _mm512_add_epi32(acc3, _mm512_madd_epi16(_mm512_unpackhi_epi16(aHi, bHi), w));
+            }
+            acc0 = _mm512_srai_epi32(_mm512_add_epi32(acc0, round), kVerticalShift);
+            acc1 = _mm512_srai_epi32(_mm512_add_epi32(acc1, round), kVerticalShift);
+            acc2 = _mm512_srai_epi32(_mm512_add_epi32(acc2, round), kVerticalShift);
+            acc3 = _mm512_srai_epi32(_mm512_add_epi32(acc3, round), kVerticalShift);
+            _mm512_storeu_si512(out + i, _mm512_packs_epi32(acc0, acc1));
+            _mm512_storeu_si512(out + i + 32, _mm512_packs_epi32(acc2, acc3));
+        }
+        if (i < end)
+            VerticalRow_AVX2(rows, weights, taps, out, i, end);
+    }
+#endif
+
+    // -----------------------------------------------------------------------
+    // Dispatch
+    // -----------------------------------------------------------------------
+
+    VerticalFn SelectVertical(SimdLevel level)
+    {
+#if VCAM_SIMD_X86
+        switch (ClampSimdLevel(level))
+        {
+        case SimdLevel::AVX512: return VerticalRow_AVX512;
+        case SimdLevel::AVX2:   return VerticalRow_AVX2;
+        case SimdLevel::SSE41:  return VerticalRow_SSE41;
+        default:                break;
+        }
+#endif
+        return VerticalRow_Scalar;
+    }
+
+    HorizontalFn SelectHorizontal(SimdLevel level, uint32_t channels)
+    {
+#if VCAM_SIMD_X86
+        const SimdLevel clamped = ClampSimdLevel(level);
+        if (clamped >= SimdLevel::SSE41)
+        {
+            switch (channels)
+            {
+            case 1:  return HorizontalRow1_SSE41;
+            case 2:  return HorizontalRow2_SSE41;
+            default: return clamped >= SimdLevel::AVX2 ? HorizontalRow4_AVX2 : HorizontalRow4_SSE41;
+            }
+        }
+#endif
+        switch (channels)
+        {
+        case 1:  return HorizontalRow_Scalar<1>;
+        case 2:  return HorizontalRow_Scalar<2>;
+        default: return HorizontalRow_Scalar<4>;
+        }
+    }
+
+    HalveFn SelectHalve(SimdLevel level)
+    {
+#if VCAM_SIMD_X86
+        switch (ClampSimdLevel(level))
+        {
+        case SimdLevel::AVX512:
+        case SimdLevel::AVX2:   return HalveRow_AVX2;
+        case SimdLevel::SSE41:  return HalveRow_SSE41;
+        default:                break;
+        }
+#endif
+        return HalveRow_Scalar;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Scaler
+// ---------------------------------------------------------------------------
+
+Scaler::Scaler(uint32_t srcWidth, uint32_t srcHeight, uint32_t dstWidth, uint32_t dstHeight, ScaleFilter filter)
+{
+    Configure(srcWidth, srcHeight, dstWidth, dstHeight, filter);
+}
+
+AxisMapping ChromaAxisMapping(uint32_t srcLumaSize, uint32_t dstLumaSize, ChromaSiting siting)
+{
+    // Chroma sample j sits at luma position 2j + s (s = 0 co-sited, 0.5
+    // centred, in luma samples).  Mapping output luma to source luma with
+    // the luma ratio r and converting back to chroma samples gives
+    //   (j + 0.5) * r + (s - 0.5) * (r - 1) / 2.
+    AxisMapping mapping;
+    if (!srcLumaSize || !dstLumaSize)
+        return mapping;
+    const double r = double(srcLumaSize) / double(dstLumaSize);
+    const double s = siting == ChromaSiting::Cosited ? 0.0 : 0.5;
+    mapping.scale = r;
+    mapping.offset = (s - 0.5) * (r - 1.0) / 2.0;
+    return mapping;
+}
+
+void Scaler::Configure(uint32_t srcWidth, uint32_t srcHeight, uint32_t dstWidth, uint32_t dstHeight, ScaleFilter filter,
+                       AxisMapping horizontal, AxisMapping vertical)
+{
+    if (srcWidth == m_srcWidth && srcHeight == m_srcHeight && dstWidth == m_dstWidth && dstHeight == m_dstHeight && filter == m_filter &&
+        horizontal == m_horizontalMapping && vertical == m_verticalMapping)
+        return;
+
+    m_srcWidth = srcWidth; m_srcHeight = srcHeight;
+    m_dstWidth = dstWidth; m_dstHeight = dstHeight;
+    m_filter = filter;
+    m_horizontalMapping = horizontal;
+    m_verticalMapping = vertical;
+    if (!srcWidth || !srcHeight || !dstWidth || !dstHeight)
+    {
+        m_dstWidth = m_dstHeight = 0;
+        m_horizontal = {};
+        m_vertical = {};
+        return;
+    }
+    m_horizontal = BuildFilterTable(srcWidth, dstWidth, filter, horizontal);
+    m_vertical = BuildFilterTable(srcHeight, dstHeight, filter, vertical);
+}
+
+bool Scaler::IsHalving() const
+{
+    return m_filter == ScaleFilter::Box && m_srcWidth == 2 * m_dstWidth && m_srcHeight == 2 * m_dstHeight &&
+           m_horizontalMapping.offset == 0.0 && m_verticalMapping.offset == 0.0;
+}
+
+void Scaler::SourceRows(uint32_t rowBegin, uint32_t rowEnd, uint32_t& first, uint32_t& last) const
+{
+    first = m_srcHeight;
+    last = 0;
+    if (rowBegin >= rowEnd)
+        return;
+    if (IsHalving())
+    {
+        first = 2 * rowBegin;
+        last = 2 * rowEnd;
+        return;
+    }
+    for (uint32_t y = rowBegin; y < rowEnd; ++y)
+    {
+        first = std::min(first, (uint32_t)m_vertical.start[y]);
+        last = std::max(last, (uint32_t)m_vertical.start[y] + m_vertical.taps);
+    }
+}
+
+void Scaler::ScaleRows(const uint8_t* src, ptrdiff_t srcStride, uint32_t srcFirstRow,
+                       uint8_t* dst, ptrdiff_t dstStride, uint32_t channels,
+                       uint32_t rowBegin, uint32_t rowEnd, SimdLevel level) const
+{
+    if (IsHalving())
+    {
+        const HalveFn halve = SelectHalve(level);
+        for (uint32_t y = rowBegin; y < rowEnd; ++y)
+        {
+            const uint8_t* row0 = src + (ptrdiff_t)(2 * y - srcFirstRow) * srcStride;
+            halve(row0, row0 + srcStride, dst + (ptrdiff_t)(y - rowBegin) * dstStride, m_dstWidth * channels, channels);
+        }
+        return;
+    }
+
+    const VerticalFn vertical = SelectVertical(level);
+    const HorizontalFn horizontal = SelectHorizontal(level, channels);
+
+    // Per-thread scratch, grown on demand and never shrunk.  The slack past
+    // the row lets the horizontal kernels read whole vectors; whatever sits
+    // there is multiplied by zero weights.
+    thread_local std::vector<int16_t> intermediate;
+    thread_local std::vector<const uint8_t*> rows;
+    const size_t needed = ((size_t)m_srcWidth + m_horizontal.stride + 8) * channels;
+    if (intermediate.size() < needed)
+        intermediate.resize(needed, 0);
+    if (rows.size() < m_vertical.stride)
+        rows.resize(m_vertical.stride);
+
+    const uint32_t taps = m_vertical.taps;
+    for (uint32_t y = rowBegin; y < rowEnd; ++y)
+    {
+        const int32_t first = m_vertical.start[y];
+        for (uint32_t k = 0; k < m_vertical.stride; ++k)
+            rows[k] = src + (ptrdiff_t)(first - (int32_t)srcFirstRow + std::min(k, taps - 1)) * srcStride;
+        vertical(rows.data(), &m_vertical.weights[(size_t)y * m_vertical.stride], taps, intermediate.data(), 0, m_srcWidth * channels);
+        horizontal(intermediate.data(), m_horizontal, dst + (ptrdiff_t)(y - rowBegin) * dstStride, 0, m_dstWidth);
+    }
+}
+
+void Scaler::Scale(const uint8_t* src, ptrdiff_t srcStride,
+                   uint8_t* dst, ptrdiff_t dstStride,
+                   uint32_t channels, SimdLevel level) const
+{
+    if (!src || !dst || !IsConfigured() || (channels != 1 && channels != 2 && channels != 4))
+        return;
+    ScaleRows(src, srcStride, 0, dst, dstStride, channels, 0, m_dstHeight, level);
+}
+
+void Scaler::ScaleParallel(const uint8_t* src, ptrdiff_t srcStride,
+                           uint8_t* dst, ptrdiff_t dstStride,
+                           uint32_t channels, WorkerPool& pool, SimdLevel level) const
+{
+    if (!src || !dst || !IsConfigured() || (channels != 1 && channels != 2 && channels != 4))
+        return;
+
+    pool.ParallelBands(m_dstHeight, 1, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd)
+    {
+        ScaleRows(src, srcStride, 0, dst + (ptrdiff_t)rowBegin * dstStride, dstStride, channels, rowBegin, rowEnd, level);
+    });
+}
+
+void Scaler::ScaleParallel(const uint8_t* src, ptrdiff_t srcStride,
+                           uint8_t* dst, ptrdiff_t dstStride,
+                           Orientation orientation, WorkerPool& pool, SimdLevel level) const
+{
+    if (!src || !dst || !IsConfigured())
+        return;
+
+    // Output rows are scaled a chunk at a time into per-thread scratch and
+    // stored oriented from there (Orientation.h).
+    ProduceOriented(m_dstWidth, m_dstHeight, [&](uint32_t rowBegin, uint32_t rowEnd, uint8_t* rows, ptrdiff_t stride) {
+        ScaleRows(src, srcStride, 0, rows, stride, 4, rowBegin, rowEnd, level);
+    }, dst, dstStride, orientation, pool, level);
+}
+
+// ---------------------------------------------------------------------------
+// NV12Scaler
+// ---------------------------------------------------------------------------
+
+void NV12Scaler::Configure(uint32_t srcWidth, uint32_t srcHeight, uint32_t dstWidth, uint32_t dstHeight, ScaleFilter filter,
+                           ChromaSiting horizontal, ChromaSiting vertical)
+{
+    m_luma.Configure(srcWidth, srcHeight, dstWidth, dstHeight, filter);
+    m_chroma.Configure((srcWidth + 1) / 2, (srcHeight + 1) / 2, (dstWidth + 1) / 2, (dstHeight + 1) / 2, filter,
+                       ChromaAxisMapping(srcWidth, dstWidth, horizontal),
+                       ChromaAxisMapping(srcHeight, dstHeight, vertical));
+}
+
+void NV12Scaler::ScaleRows(const uint8_t* srcY, ptrdiff_t srcYStride,
+                           const uint8_t* srcUV, ptrdiff_t srcUVStride,
+                           uint8_t* dstY, ptrdiff_t dstYStride,
+                           uint8_t* dstUV, ptrdiff_t dstUVStride,
+                           uint32_t rowBegin, uint32_t rowEnd, SimdLevel level) const
+{
+    const uint32_t chromaBegin = rowBegin / 2, chromaEnd = (rowEnd + 1) / 2;
+    m_luma.ScaleRows(srcY, srcYStride, 0, dstY, dstYStride, 1, rowBegin, rowEnd, level);
+    m_chroma.ScaleRows(srcUV, srcUVStride, 0, dstUV, dstUVStride, 2, chromaBegin, chromaEnd, level);
+}
+
+void NV12Scaler::ScaleParallel(const uint8_t* srcY, ptrdiff_t srcYStride,
+                               const uint8_t* srcUV, ptrdiff_t srcUVStride,
+                               uint8_t* dstY, ptrdiff_t dstYStride,
+                               uint8_t* dstUV, ptrdiff_t dstUVStride,
+                               WorkerPool& pool, SimdLevel level) const
+{
+    if (!srcY || !srcUV || !dstY || !dstUV || !IsConfigured())
+        return;
+
+    // One band covers its luma rows and the chroma rows they share, so both
+    // planes of a band are produced together.
+    pool.ParallelBands(m_luma.DstHeight(), 2, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd)
+    {
+        ScaleRows(srcY, srcYStride, srcUV, srcUVStride,
+                  dstY + (ptrdiff_t)rowBegin * dstYStride, dstYStride,
+                  dstUV + (ptrdiff_t)(rowBegin / 2) * dstUVStride, dstUVStride, rowBegin, rowEnd, level);
+    });
+}
+
+}
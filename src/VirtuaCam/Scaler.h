@@ -0,0 +1,169 @@
+// =============================================================================
+// Scaler.h  --  CPU image resampling (box / bilinear / Lanczos-3)
+// =============================================================================
+// The GPU does all scaling in the compositing path; this is the CPU
+// counterpart for paths that never touch a texture sampler (preview
+// thumbnails, software fallbacks, PiP tiles).
+//
+// A Scaler is configured once per (source size, destination size, filter):
+// the separable filter tables (first tap + 14-bit weights per output column
+// and per output row) are computed there and reused for every frame.
+//
+// Scale() works one output row at a time: the vertical taps of the source
+// rows are combined into a 16-bit intermediate row, which the horizontal taps
+// then reduce to the output row.  The working set is the tap rows plus one
+// intermediate row, so it stays in cache at any frame size, and output rows
+// are independent, which is what ScaleParallel() bands over.
+//
+// Planes are 8-bit with 1 (Y / grey), 2 (interleaved NV12 UV) or 4 (BGRA)
+// channels.  A Box filter at exactly 2:1 in both directions uses a dedicated
+// 2x2-average kernel (mip-style pyramid step).
+//
+// NV12Scaler resizes NV12 without leaving YUV: the Y plane and the interleaved
+// UV plane are scaled separately, with the chroma sample grid mapped through
+// the luma ratio and the chroma siting (ChromaSiting) so colour edges stay
+// aligned with luma edges.  That touches 1.5 bytes per pixel at each end
+// instead of unpacking to and repacking from BGRA.
+//
+// For BGRA, ScaleParallel() can also apply a mirror / rotation in the same
+// pass (Orientation.h).
+//
+// Every kernel has a scalar reference and SSE4.1 / AVX2 / AVX-512 variants
+// (Simd.h) that produce bit-identical output.
+//
+// This header (and Scaler.cpp) deliberately has no Windows dependency.
+// =============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Orientation.h"
+#include "Simd.h"
+#include "WorkerPool.h"
+
+namespace VirtuaCam {
+
+enum class ScaleFilter : int {
+    Box      = 0,   // area average when shrinking, nearest when enlarging
+    Bilinear = 1,   // triangle filter, widened by the shrink factor
+    Lanczos3 = 2,   // windowed sinc, 3 lobes
+};
+
+// Position of subsampled chroma samples relative to the luma grid, per axis.
+enum class ChromaSiting : int {
+    Center  = 0,    // midway between two luma samples (MPEG-2 vertical, JPEG)
+    Cosited = 1,    // on the first of the two luma samples (MPEG-2 / H.264 horizontal)
+};
+
+// Sample-grid mapping for one axis: output sample i is centred on source
+// position (i + 0.5) * scale + offset, in source samples.  A zero scale means
+// the plain ratio src / dst (and no offset).
+struct AxisMapping {
+    double scale  = 0.0;
+    double offset = 0.0;
+
+    bool operator==(const AxisMapping& other) const { return scale == other.scale && offset == other.offset; }
+};
+
+// Mapping for a chroma axis of a 2:1 subsampled plane, given the luma sizes.
+AxisMapping ChromaAxisMapping(uint32_t srcLumaSize, uint32_t dstLumaSize, ChromaSiting siting);
+
+class Scaler {
+public:
+    Scaler() = default;
+    Scaler(uint32_t srcWidth, uint32_t srcHeight, uint32_t dstWidth, uint32_t dstHeight, ScaleFilter filter);
+
+    // Recomputes the filter tables; a no-op if nothing changed.
+    void Configure(uint32_t srcWidth, uint32_t srcHeight, uint32_t dstWidth, uint32_t dstHeight, ScaleFilter filter,
+                   AxisMapping horizontal = {}, AxisMapping vertical = {});
+
+    bool IsConfigured() const { return m_dstWidth != 0; }
+    uint32_t SrcWidth() const  { return m_srcWidth; }
+    uint32_t SrcHeight() const { return m_srcHeight; }
+    uint32_t DstWidth() const  { return m_dstWidth; }
+    uint32_t DstHeight() const { return m_dstHeight; }
+
+    // Scales one plane of 'channels' (1, 2 or 4) interleaved 8-bit samples.
+    // Sizes are in pixels, strides in bytes.
+    void Scale(const uint8_t* src, ptrdiff_t srcStride,
+               uint8_t* dst, ptrdiff_t dstStride,
+               uint32_t channels, SimdLevel level = GetSimdLevel()) const;
+
+    void ScaleParallel(const uint8_t* src, ptrdiff_t srcStride,
+                       uint8_t* dst, ptrdiff_t dstStride,
+                       uint32_t channels, WorkerPool& pool = WorkerPool::Shared(),
+                       SimdLevel level = GetSimdLevel()) const;
+
+    // BGRA only: scales and applies a mirror / rotation in the same pass.
+    // 'dst' has the oriented size (OrientedSize() of DstWidth x DstHeight).
+    void ScaleParallel(const uint8_t* src, ptrdiff_t srcStride,
+                       uint8_t* dst, ptrdiff_t dstStride,
+                       Orientation orientation, WorkerPool& pool = WorkerPool::Shared(),
+                       SimdLevel level = GetSimdLevel()) const;
+
+    // Per-axis filter table: output i reads 'taps' source samples starting
+    // at start[i], weighted by weights[i * stride .. + taps) (sum 1 << 14).
+    // 'stride' is 'taps' rounded up to 8; the padding weights are zero.
+    struct FilterTable {
+        uint32_t taps = 0;
+        uint32_t stride = 0;
+        std::vector<int32_t> start;
+        std::vector<int16_t> weights;
+    };
+
+    // Row-range building blocks for fused pipelines (FramePipeline.h).
+    // SourceRows(): the source rows [first, last) read by output rows
+    // [rowBegin, rowEnd).  ScaleRows(): scales those output rows into 'dst'
+    // (row rowBegin first) from a window of source rows whose first row,
+    // 'src', is source row 'srcFirstRow'.
+    void SourceRows(uint32_t rowBegin, uint32_t rowEnd, uint32_t& first, uint32_t& last) const;
+    void ScaleRows(const uint8_t* src, ptrdiff_t srcStride, uint32_t srcFirstRow,
+                   uint8_t* dst, ptrdiff_t dstStride, uint32_t channels,
+                   uint32_t rowBegin, uint32_t rowEnd, SimdLevel level = GetSimdLevel()) const;
+
+private:
+    bool IsHalving() const;
+
+    uint32_t m_srcWidth = 0, m_srcHeight = 0;
+    uint32_t m_dstWidth = 0, m_dstHeight = 0;
+    ScaleFilter m_filter = ScaleFilter::Bilinear;
+    AxisMapping m_horizontalMapping, m_verticalMapping;
+    FilterTable m_horizontal;
+    FilterTable m_vertical;
+};
+
+// NV12 frame scaler: one Scaler for the luma plane, one for the interleaved
+// chroma plane (ceil(width/2) x ceil(height/2) pairs).  The default siting is
+// the MPEG-2 / H.264 one cameras and encoders use: co-sited horizontally,
+// centred vertically.
+class NV12Scaler {
+public:
+    void Configure(uint32_t srcWidth, uint32_t srcHeight, uint32_t dstWidth, uint32_t dstHeight, ScaleFilter filter,
+                   ChromaSiting horizontal = ChromaSiting::Cosited, ChromaSiting vertical = ChromaSiting::Center);
+
+    bool IsConfigured() const { return m_luma.IsConfigured(); }
+
+    // Scales luma rows [rowBegin, rowEnd) and the chroma rows they own
+    // (rowBegin must be even) into 'dstY' / 'dstUV' (luma row rowBegin and
+    // chroma row rowBegin / 2 first), like Scaler::ScaleRows().
+    void ScaleRows(const uint8_t* srcY, ptrdiff_t srcYStride,
+                   const uint8_t* srcUV, ptrdiff_t srcUVStride,
+                   uint8_t* dstY, ptrdiff_t dstYStride,
+                   uint8_t* dstUV, ptrdiff_t dstUVStride,
+                   uint32_t rowBegin, uint32_t rowEnd, SimdLevel level = GetSimdLevel()) const;
+
+    void ScaleParallel(const uint8_t* srcY, ptrdiff_t srcYStride,
+                       const uint8_t* srcUV, ptrdiff_t srcUVStride,
+                       uint8_t* dstY, ptrdiff_t dstYStride,
+                       uint8_t* dstUV, ptrdiff_t dstUVStride,
+                       WorkerPool& pool = WorkerPool::Shared(),
+                       SimdLevel level = GetSimdLevel()) const;
+
+private:
+    Scaler m_luma;
+    Scaler m_chroma;
+};
+
+}
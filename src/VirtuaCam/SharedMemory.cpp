@@ -0,0 +1,123 @@
+// =============================================================================
+// SharedMemory.cpp  --  Named shared-memory region (Win32 / POSIX backends)
+// =============================================================================
+// See SharedMemory.h for the public contract.
+// =============================================================================
+
+#include "SharedMemory.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <sddl.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace VirtuaCam {
+
+#if defined(_WIN32)
+
+bool SharedMemoryRegion::Open(const std::string& name, size_t size, Access access)
+{
+    Close();
+    const std::wstring fullName = L"Local\\" + std::wstring(name.begin(), name.end());
+    const DWORD viewAccess = access == Access::ReadOnly ? FILE_MAP_READ : FILE_MAP_READ | FILE_MAP_WRITE;
+
+    HANDLE mapping = nullptr;
+    if (access == Access::CreateOrOpen)
+    {
+        // Same DACL as the shared textures and manifests: Authenticated Users.
+        PSECURITY_DESCRIPTOR sd = nullptr;
+        if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(L"D:P(A;;GA;;;AU)", SDDL_REVISION_1, &sd, nullptr))
+            return false;
+        SECURITY_ATTRIBUTES sa = { sizeof(sa), sd, FALSE };
+        mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, &sa, PAGE_READWRITE,
+                                     (DWORD)((unsigned long long)size >> 32), (DWORD)size, fullName.c_str());
+        LocalFree(sd);
+    }
+    else
+    {
+        mapping = OpenFileMappingW(viewAccess, FALSE, fullName.c_str());
+    }
+    if (!mapping)
+        return false;
+
+    // Fails if the section is shorter than 'size'.
+    void* view = MapViewOfFile(mapping, viewAccess, 0, 0, size);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    m_handle = mapping;
+    m_data = view;
+    m_size = size;
+    return true;
+}
+
+void SharedMemoryRegion::Close()
+{
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_handle)
+        CloseHandle((HANDLE)m_handle);
+    m_data = nullptr;
+    m_handle = nullptr;
+    m_size = 0;
+}
+
+void SharedMemoryRegion::Remove(const std::string&)
+{
+}
+
+#else
+
+bool SharedMemoryRegion::Open(const std::string& name, size_t size, Access access)
+{
+    Close();
+    const std::string fullName = "/" + name;
+    const int flags = access == Access::ReadOnly ? O_RDONLY : access == Access::OpenExisting ? O_RDWR : O_RDWR | O_CREAT;
+    const int fd = shm_open(fullName.c_str(), flags, 0600);
+    if (fd < 0)
+        return false;
+
+    // Growing a new (or shorter) object zero-fills it; an existing one of the
+    // right size is left alone.  Only a creator grows it: mapping past the
+    // end of a shorter object would fault on access.
+    struct stat st = {};
+    if (fstat(fd, &st) != 0 ||
+        ((size_t)st.st_size < size && (access != Access::CreateOrOpen || ftruncate(fd, (off_t)size) != 0)))
+    {
+        close(fd);
+        return false;
+    }
+    const int protection = access == Access::ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+    void* view = mmap(nullptr, size, protection, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+        return false;
+    m_data = view;
+    m_size = size;
+    return true;
+}
+
+void SharedMemoryRegion::Close()
+{
+    if (m_data)
+        munmap(m_data, m_size);
+    m_data = nullptr;
+    m_size = 0;
+}
+
+void SharedMemoryRegion::Remove(const std::string& name)
+{
+    shm_unlink(("/" + name).c_str());
+}
+
+#endif
+
+}
@@ -0,0 +1,71 @@
+// =============================================================================
+// SharedMemory.h  --  Named shared-memory region (Win32 / POSIX backends)
+// =============================================================================
+// The small OS abstraction under ProducerDirectory (with NamedEvent.h):
+// create-or-open a named, zero-initialised region of a fixed size and map it
+// read-write, or open an existing one only (read-write or read-only).
+//
+//   Windows   CreateFileMappingW on the paging file, named "Local\<name>"
+//             (per session, like the producer manifests) with the same
+//             permissive DACL as the shared textures, so producers running
+//             as other accounts can open it.  The region lives while any
+//             process has it open.
+//   POSIX     shm_open("/<name>") + ftruncate + mmap.  The region lives until
+//             Remove() unlinks it.
+//
+// Both backends zero-fill a newly created region, which is what lets its
+// users treat all-zero memory as "empty" without a separate initialiser.
+//
+// Only the processes that own a region should create it.  On Windows the
+// "Local\" name resolves in the caller's session namespace, so a process
+// that creates instead of opening (one that starts first, or runs in
+// another session, like the Frame Server) ends up with a private, empty
+// copy nobody else writes to.  Readers open with OpenExisting or ReadOnly
+// and retry later if the region is not there yet.
+//
+// This header deliberately has no Windows dependency; SharedMemory.cpp picks
+// the backend.
+// =============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace VirtuaCam {
+
+class SharedMemoryRegion {
+public:
+    SharedMemoryRegion() = default;
+    ~SharedMemoryRegion() { Close(); }
+
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+    enum class Access {
+        CreateOrOpen,   // read-write, created zero-filled if missing
+        OpenExisting,   // read-write, fails if missing
+        ReadOnly,       // read-only, fails if missing
+    };
+
+    // Creates the region or opens the existing one (see Access) and maps
+    // 'size' bytes.  'name' is a plain identifier (no prefix or slashes).
+    // Opening fails if an existing region is shorter than 'size'.
+    bool Open(const std::string& name, size_t size, Access access = Access::CreateOrOpen);
+    void Close();
+
+    bool IsOpen() const { return m_data != nullptr; }
+    void* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+    // Deletes the name so the next Open() starts from zero (POSIX); mappings
+    // already open stay valid.  A no-op on Windows.
+    static void Remove(const std::string& name);
+
+private:
+    void* m_data = nullptr;
+    size_t m_size = 0;
+    void* m_handle = nullptr;   // Win32 mapping handle (unused on POSIX)
+};
+
+}
@@ -0,0 +1,103 @@
+// =============================================================================
+// Simd.cpp  --  CPU feature detection
+// =============================================================================
+// See Simd.h.  An instruction set is only reported when both the CPU supports
+// it (CPUID) and the OS saves/restores the corresponding register state across
+// context switches (XCR0, read with XGETBV).
+// =============================================================================
+
+#include "Simd.h"
+
+#if VCAM_SIMD_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace VirtuaCam {
+
+#if VCAM_SIMD_X86
+namespace
+{
+    void Cpuid(int leaf, int subleaf, int regs[4])
+    {
+#if defined(_MSC_VER)
+        __cpuidex(regs, leaf, subleaf);
+#else
+        unsigned a = 0, b = 0, c = 0, d = 0;
+        __cpuid_count(leaf, subleaf, a, b, c, d);
+        regs[0] = (int)a; regs[1] = (int)b; regs[2] = (int)c; regs[3] = (int)d;
+#endif
+    }
+
+    uint64_t ReadXcr0()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        uint32_t lo = 0, hi = 0;
+        __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        return ((uint64_t)hi << 32) | lo;
+#endif
+    }
+}
+#endif
+
+SimdLevel DetectSimdLevel()
+{
+#if VCAM_SIMD_X86
+    int regs[4] = {};
+    Cpuid(0, 0, regs);
+    const int maxLeaf = regs[0];
+    if (maxLeaf < 1)
+        return SimdLevel::Scalar;
+
+    Cpuid(1, 0, regs);
+    const bool ssse3   = (regs[2] & (1 << 9))  != 0;
+    const bool sse41   = (regs[2] & (1 << 19)) != 0;
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx     = (regs[2] & (1 << 28)) != 0;
+    if (!ssse3 || !sse41)
+        return SimdLevel::Scalar;
+    if (!osxsave || !avx || maxLeaf < 7)
+        return SimdLevel::SSE41;
+
+    // XCR0 bits: 1 = SSE, 2 = AVX (YMM upper halves), 5..7 = opmask + ZMM.
+    const uint64_t xcr0 = ReadXcr0();
+    if ((xcr0 & 0x6) != 0x6)
+        return SimdLevel::SSE41;
+
+    Cpuid(7, 0, regs);
+    const bool avx2     = (regs[1] & (1 << 5))  != 0;
+    const bool avx512f  = (regs[1] & (1 << 16)) != 0;
+    const bool avx512bw = (regs[1] & (1 << 30)) != 0;
+    if (!avx2)
+        return SimdLevel::SSE41;
+    if (avx512f && avx512bw && (xcr0 & 0xE6) == 0xE6)
+        return SimdLevel::AVX512;
+    return SimdLevel::AVX2;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+SimdLevel GetSimdLevel()
+{
+    static const SimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+const char* SimdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::SSE41:  return "SSE4.1";
+    case SimdLevel::AVX2:   return "AVX2";
+    case SimdLevel::AVX512: return "AVX-512";
+    default:                return "Scalar";
+    }
+}
+
+}
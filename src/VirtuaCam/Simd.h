@@ -0,0 +1,67 @@
+// =============================================================================
+// Simd.h  --  CPU feature detection and SIMD dispatch helpers
+// =============================================================================
+// The CPU-side pixel kernels (ColorConvert.cpp and friends) ship a scalar
+// reference implementation plus SSE4.1, AVX2 and AVX-512 variants.  The best
+// variant the machine supports is chosen once per process by probing CPUID and
+// XGETBV (the OS must also have enabled the wider register state).
+//
+// Every kernel entry point also accepts an explicit SimdLevel so callers can
+// pin a specific path (e.g. to compare it against the scalar reference).  The
+// requested level is always clamped to what the CPU actually supports.
+//
+// Target attributes
+// -----------------
+// MSVC lets any translation unit use any intrinsic, so the VCAM_TARGET_*
+// macros expand to nothing there.  GCC/Clang require the instruction set to be
+// enabled per function; the macros add the matching target attribute so the
+// kernels also build (and can be exercised) without Windows or MSVC.
+// =============================================================================
+
+#pragma once
+
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define VCAM_SIMD_X86 1
+#else
+#define VCAM_SIMD_X86 0
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define VCAM_TARGET_SSE41
+#define VCAM_TARGET_AVX2
+#define VCAM_TARGET_AVX512
+#else
+#define VCAM_TARGET_SSE41  __attribute__((target("sse4.1")))
+#define VCAM_TARGET_AVX2   __attribute__((target("avx2")))
+#define VCAM_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#endif
+
+namespace VirtuaCam {
+
+// Instruction-set tiers, ordered so that a higher value implies every lower one.
+enum class SimdLevel : int {
+    Scalar = 0,
+    SSE41  = 1,
+    AVX2   = 2,
+    AVX512 = 3,     // AVX-512 F + BW
+};
+
+// Probes CPUID/XGETBV and returns the highest usable tier.
+SimdLevel DetectSimdLevel();
+
+// Cached result of DetectSimdLevel(); the probe runs only on the first call.
+SimdLevel GetSimdLevel();
+
+// Clamps a requested tier to what this CPU supports.
+inline SimdLevel ClampSimdLevel(SimdLevel requested)
+{
+    const SimdLevel supported = GetSimdLevel();
+    return requested < supported ? requested : supported;
+}
+
+// Human-readable tier name, for logs and benchmark output.
+const char* SimdLevelName(SimdLevel level);
+
+}
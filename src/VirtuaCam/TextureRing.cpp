@@ -0,0 +1,198 @@
+// =============================================================================
+// TextureRing.cpp  --  Slot accounting for a producer's shared texture ring
+// =============================================================================
+// See TextureRing.h for the slot word and the protocol.
+// =============================================================================
+
+#include "TextureRing.h"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace VirtuaCam {
+
+namespace {
+
+constexpr uint64_t kWriting    = 1ull << 63;
+constexpr int      kReaderShift = 48;
+constexpr uint64_t kReaderUnit = 1ull << kReaderShift;
+constexpr uint64_t kReaderMask = 0x7FFFull << kReaderShift;
+constexpr uint64_t kFrameMask  = kReaderUnit - 1;
+constexpr int      kMaxAcquireAttempts = 16;
+
+inline uint64_t Readers(uint64_t word) { return (word & kReaderMask) >> kReaderShift; }
+inline uint64_t Frame(uint64_t word)   { return word & kFrameMask; }
+
+}
+
+void InitializeRing(TextureRingState& ring, uint32_t slotCount)
+{
+    for (auto& slot : ring.slots)
+        slot.store(0, std::memory_order_relaxed);
+    ring.latestSlot.store(0, std::memory_order_relaxed);
+    ring.slotCount.store(std::clamp(slotCount, kMinRingSlots, kMaxRingSlots), std::memory_order_release);
+}
+
+uint32_t RingSlotCount(const TextureRingState& ring)
+{
+    const uint32_t count = ring.slotCount.load(std::memory_order_acquire);
+    return count >= kMinRingSlots && count <= kMaxRingSlots ? count : 0;
+}
+
+// ---------------------------------------------------------------------------
+// TextureRingWriter
+// ---------------------------------------------------------------------------
+
+void TextureRingWriter::Attach(TextureRingState* ring)
+{
+    m_ring = ring;
+    m_next = 0;
+    m_slot = -1;
+    m_stalls = 0;
+}
+
+int TextureRingWriter::BeginWrite()
+{
+    const uint32_t count = m_ring ? RingSlotCount(*m_ring) : 0;
+    if (!count || m_slot >= 0)
+        return -1;
+    const uint32_t latest = m_ring->latestSlot.load(std::memory_order_relaxed);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const uint32_t slot = (m_next + i) % count;
+        if (slot == latest)
+            continue;
+        uint64_t word = m_ring->slots[slot].load(std::memory_order_relaxed);
+        while (!(word & (kWriting | kReaderMask)))
+        {
+            if (m_ring->slots[slot].compare_exchange_weak(word, word | kWriting, std::memory_order_acquire,
+                                                          std::memory_order_relaxed))
+            {
+                m_slot = (int)slot;
+                m_next = slot + 1;
+                m_stalls = 0;
+                return m_slot;
+            }
+        }
+    }
+
+    // Every other slot is pinned.  Readers move their pin forward each time
+    // they see a new frame, so this only lasts if one stopped reading.
+    if (++m_stalls < kStallLimit)
+        return -1;
+    const uint32_t slot = m_next % count != latest ? m_next % count : (m_next + 1) % count;
+    m_ring->slots[slot].exchange(kWriting, std::memory_order_acquire);
+    m_slot = (int)slot;
+    m_next = slot + 1;
+    m_stalls = 0;
+    return m_slot;
+}
+
+void TextureRingWriter::EndWrite(uint64_t frameValue)
+{
+    if (m_slot < 0)
+        return;
+    m_ring->slots[m_slot].store(frameValue & kFrameMask, std::memory_order_release);
+    m_ring->latestSlot.store((uint32_t)m_slot, std::memory_order_release);
+    m_slot = -1;
+}
+
+void TextureRingWriter::AbortWrite()
+{
+    if (m_slot < 0)
+        return;
+    // The contents are gone, so the slot holds no frame (and a late release
+    // of an earlier pin on it cannot match).
+    m_ring->slots[m_slot].store(0, std::memory_order_release);
+    m_slot = -1;
+}
+
+// ---------------------------------------------------------------------------
+// TextureRingReader
+// ---------------------------------------------------------------------------
+
+TextureRingReader::TextureRingReader(TextureRingReader&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+TextureRingReader& TextureRingReader::operator=(TextureRingReader&& other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        m_ring = std::exchange(other.m_ring, nullptr);
+        m_pin = std::exchange(other.m_pin, Pin());
+        std::copy(std::begin(other.m_retired), std::end(other.m_retired), std::begin(m_retired));
+        m_retiredCount = std::exchange(other.m_retiredCount, 0);
+    }
+    return *this;
+}
+
+void TextureRingReader::Attach(TextureRingState* ring)
+{
+    Release();
+    m_ring = ring;
+}
+
+bool TextureRingReader::Acquire(uint32_t& slot, uint64_t& frameValue)
+{
+    const uint32_t count = m_ring ? RingSlotCount(*m_ring) : 0;
+    if (!count || (m_pin.slot >= 0 && m_retiredCount == kMaxRingSlots))
+        return false;
+
+    for (int attempt = 0; attempt < kMaxAcquireAttempts; ++attempt)
+    {
+        const uint32_t latest = m_ring->latestSlot.load(std::memory_order_acquire);
+        if (latest >= count)
+            return false;
+        uint64_t word = m_ring->slots[latest].load(std::memory_order_acquire);
+        if (word & kWriting)
+            continue;               // a newer frame went out meanwhile
+        if (!Frame(word) || Readers(word) == Readers(kReaderMask))
+            return false;
+        if (!m_ring->slots[latest].compare_exchange_strong(word, word + kReaderUnit, std::memory_order_acquire,
+                                                            std::memory_order_relaxed))
+            continue;
+
+        if (m_pin.slot >= 0)
+            m_retired[m_retiredCount++] = m_pin;
+        m_pin.slot = (int)latest;
+        m_pin.frame = Frame(word);
+        slot = latest;
+        frameValue = m_pin.frame;
+        return true;
+    }
+    return false;
+}
+
+void TextureRingReader::ReleaseRetired()
+{
+    for (uint32_t i = 0; i < m_retiredCount; ++i)
+        Unpin(m_retired[i]);
+    m_retiredCount = 0;
+}
+
+void TextureRingReader::Release()
+{
+    ReleaseRetired();
+    Unpin(m_pin);
+}
+
+void TextureRingReader::Unpin(Pin& pin)
+{
+    if (pin.slot < 0)
+        return;
+    std::atomic<uint64_t>& slot = m_ring->slots[pin.slot];
+    uint64_t word = slot.load(std::memory_order_relaxed);
+    // Taken back by a stalled writer (and possibly rewritten): not ours any more.
+    while (!(word & kWriting) && Frame(word) == pin.frame && Readers(word) > 0)
+    {
+        if (slot.compare_exchange_weak(word, word - kReaderUnit, std::memory_order_release, std::memory_order_relaxed))
+            break;
+    }
+    pin = Pin();
+}
+
+}
@@ -0,0 +1,141 @@
+// =============================================================================
+// TextureRing.h  --  Slot accounting for a producer's shared texture ring
+// =============================================================================
+// A producer with a single shared texture overwrites it while readers (the
+// broker's multiplexer, the consumer filter) may still be copying the
+// previous frame out of it, so the two sides serialise on the GPU.  With a
+// ring the producer publishes into N textures (kMinRingSlots..kMaxRingSlots)
+// and never writes the one a reader is using.
+//
+// TextureRingState lives in the producer's manifest (Manifest.h) and holds
+// one word per slot:
+//
+//   bit 63       writing     the producer owns the slot
+//   bits 48..62  readers     pins held by readers
+//   bits 0..47   frame       fence value of the frame the slot holds (0: none)
+//
+// plus the index of the slot holding the latest frame.
+//
+//   Writer   BeginWrite() claims a slot other than the latest that no reader
+//            pins (CAS readers == 0 -> writing), round-robin so a slot just
+//            released is reused as late as possible.  The frame is rendered
+//            and its fence signalled, then EndWrite() stores the new frame
+//            value (clearing writing) and makes the slot the latest.  If
+//            every other slot is pinned the frame is dropped.
+//   Reader   Acquire() loads the latest slot and pins it (CAS readers + 1
+//            unless writing).  The writer never claims the latest slot, so
+//            seeing writing means a newer frame was published in between:
+//            reload and retry.  The next Acquire() does not drop the pin: it
+//            retires it, and retired pins are released (through the same
+//            word) only by ReleaseRetired(), which the reader calls once its
+//            GPU has completed the copies out of those slots.  Issuing a copy
+//            on a D3D11 context only queues it, possibly frames deep, so
+//            "the next frame came" says nothing about the last copy having
+//            run; the reader checks an event query issued after the copy.
+//            Writer and reader therefore never touch the same surface.
+//
+// While a reader's copy is in flight it pins two slots, the latest and the
+// one it is copying, so a two-slot ring drops frames for that long; three
+// (the default) leave the writer a free slot.
+//
+// A reader that dies holding a pin would stall its producer for good, so a
+// writer that finds no free slot for kStallLimit frames in a row takes one
+// back.  The frame value doubles as a generation: a late Release() for a slot
+// that was taken back and rewritten finds a different frame and does nothing.
+//
+// This header (and TextureRing.cpp) deliberately has no Windows dependency.
+// =============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace VirtuaCam {
+
+constexpr uint32_t kMinRingSlots = 2;
+constexpr uint32_t kMaxRingSlots = 4;
+constexpr uint32_t kDefaultRingSlots = 3;
+
+struct TextureRingState {
+    std::atomic<uint32_t> slotCount;            // 0: no ring (a single texture)
+    std::atomic<uint32_t> latestSlot;
+    std::atomic<uint64_t> slots[kMaxRingSlots];
+};
+
+// Zeroes the ring and sets its slot count, clamped to [kMinRingSlots,
+// kMaxRingSlots].  Called by the producer before it publishes the manifest.
+void InitializeRing(TextureRingState& ring, uint32_t slotCount);
+
+// The ring's slot count, or 0 if it holds no valid ring.
+uint32_t RingSlotCount(const TextureRingState& ring);
+
+// Producer side.  One writer per ring.
+class TextureRingWriter {
+public:
+    static constexpr uint32_t kStallLimit = 120;
+
+    void Attach(TextureRingState* ring);
+
+    // Slot to render the next frame into, or -1 if every other slot is
+    // pinned (drop the frame).
+    int BeginWrite();
+
+    // Publishes the frame rendered into the claimed slot.  'frameValue' is
+    // the fence value signalled for it: nonzero and increasing.
+    void EndWrite(uint64_t frameValue);
+
+    // Gives up the claimed slot without publishing.
+    void AbortWrite();
+
+private:
+    TextureRingState* m_ring = nullptr;
+    uint32_t m_next = 0;
+    int m_slot = -1;
+    uint32_t m_stalls = 0;
+};
+
+// Reader side.  Holds the pin of the last Acquire() and up to kMaxRingSlots
+// retired ones; releases them all on destruction, so it must not outlive
+// the mapping the ring lives in.  Move-only.
+class TextureRingReader {
+public:
+    TextureRingReader() = default;
+    ~TextureRingReader() { Release(); }
+
+    TextureRingReader(TextureRingReader&& other) noexcept;
+    TextureRingReader& operator=(TextureRingReader&& other) noexcept;
+    TextureRingReader(const TextureRingReader&) = delete;
+    TextureRingReader& operator=(const TextureRingReader&) = delete;
+
+    void Attach(TextureRingState* ring);
+
+    // Pins the slot holding the latest frame and retires the previous pin.
+    // False if no frame has been published yet, the writer kept moving for
+    // a bounded number of tries, or kMaxRingSlots pins are already retired;
+    // the pins held are then unchanged.
+    bool Acquire(uint32_t& slot, uint64_t& frameValue);
+
+    // Releases the retired pins.  Call once every read of those slots
+    // (copies issued before the last Acquire()) has completed.
+    void ReleaseRetired();
+    uint32_t RetiredCount() const { return m_retiredCount; }
+
+    // Releases every pin, retired or not.
+    void Release();
+
+private:
+    struct Pin {
+        int slot = -1;
+        uint64_t frame = 0;
+    };
+
+    void Unpin(Pin& pin);
+
+    TextureRingState* m_ring = nullptr;
+    Pin m_pin;
+    Pin m_retired[kMaxRingSlots];
+    uint32_t m_retiredCount = 0;
+};
+
+}
@@ -6,16 +6,21 @@
 //   - GUID formatting (for error messages and registry paths)
 //   - Window centering (multi-monitor aware)
 //   - HSL->RGB colour conversion (used by the UI)
-//   - Software RGB32 -> NV12 colour-space conversion (BT.601, limited range)
+//   - Software RGB32 -> NV12/YUY2/I420/P010 colour-space conversion (BT.601/709/2020, limited
+//     or full range; SIMD kernels live in ColorConvert.cpp) and the matching
+//     media-type colorimetry attributes
 //   - Registry read/write wrappers
 //   - Cross-process D3D11 shared-handle lookup via D3D12
+//   - The cached "No Signal" placeholder texture
 // =============================================================================
 
 #include "pch.h"
 #include "Tools.h"
+#include "ColorConvert.h"
 #include <d3d12.h>
 #include <algorithm>
 #include <cstdint>
+#include <utility>
 
 // ---------------------------------------------------------------------------
 // String conversion helpers
@@ -172,86 +177,143 @@ const LSTATUS RegWriteValue(HKEY key, PCWSTR name, DWORD value)
 }
 
 // ---------------------------------------------------------------------------
-// Software YUV conversion  (BT.601, limited / "studio" range)
+// Software RGB32 -> NV12 conversion
 // ---------------------------------------------------------------------------
-// These functions convert RGB pixels to the YCbCr colour space used by NV12.
+// Thin HRESULT wrapper around the SIMD kernels in ColorConvert.cpp (scalar,
+// SSE4.1, AVX2 or AVX-512, chosen once per process from CPUID).  The default
+// colorimetry is BT.601 limited ("studio") range.
 //
-// The integer coefficients are the standard BT.601 limited-range approximation:
-//
-//   Y  = ( 66*R + 129*G +  25*B + 128) >> 8  + 16
-//   Cb = (-38*R -  74*G + 112*B + 128) >> 8  + 128
-//   Cr = (112*R -  94*G -  18*B + 128) >> 8  + 128
-//
-// The +128 before the shift is a rounding bias (equivalent to 0.5 after the
-// divide).  The +16 and +128 offsets are the limited-range foot levels for Y
-// and chroma respectively (Y: [16,235], Cb/Cr: [16,240]).
-//
-// Reference: ITU-R BT.601-7, Section 2.5.3
+// Output layout: Y plane [height rows] immediately followed by the interleaved
+// UV plane [ceil(height/2) rows], both using outputStride.  Odd widths and
+// heights are supported; the last chroma column/row is taken from the edge
+// pixels.
+
+// Validates the arguments shared by every RGB32 -> YUV wrapper: 'outputRow' is
+// the number of bytes written per output row and 'outputRows' the number of
+// rows (all planes) addressed through outputStride.
+static HRESULT CheckRGB32Conversion(const BYTE* input, ULONG inputSize, LONG inputStride, UINT width, UINT height,
+                                    const BYTE* output, ULONG outputSize, LONG outputStride, ULONGLONG outputRow, ULONGLONG outputRows)
+{
+    RETURN_HR_IF_NULL(E_INVALIDARG, input);
+    RETURN_HR_IF_NULL(E_INVALIDARG, output);
+    RETURN_HR_IF(E_INVALIDARG, !width || !height);
 
-static inline void RGB24ToYUY2(int r, int g, int b, BYTE* y, BYTE* u, BYTE* v)
+    // Bytes actually touched per row, and the span covered by all rows.
+    const ULONGLONG inputPitch  = (ULONGLONG)std::abs((LONGLONG)inputStride);
+    const ULONGLONG outputPitch = (ULONGLONG)std::abs((LONGLONG)outputStride);
+    const ULONGLONG inputRow    = (ULONGLONG)width * 4;
+    RETURN_HR_IF(E_INVALIDARG, inputPitch < inputRow || outputPitch < outputRow);
+    RETURN_HR_IF(E_UNEXPECTED, inputPitch * (height - 1) + inputRow > inputSize);
+    RETURN_HR_IF(E_UNEXPECTED, outputPitch * (outputRows - 1) + outputRow > outputSize);
+    return S_OK;
+}
+
+HRESULT RGB32ToNV12(BYTE* input, ULONG inputSize, LONG inputStride, UINT width, UINT height, BYTE* output, ULONG ouputSize, LONG outputStride, VirtuaCam::YuvColorimetry colorimetry)
 {
-    *y = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
-    *u = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
-    *v = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+    // UV rows hold ceil(width/2) pairs.
+    const ULONGLONG outputRow = ((ULONGLONG)width + 1) & ~1ull;
+    RETURN_IF_FAILED(CheckRGB32Conversion(input, inputSize, inputStride, width, height, output, ouputSize, outputStride, outputRow, (ULONGLONG)height + (height + 1) / 2));
+
+    // UV plane starts immediately after the Y plane at row offset 'height'.
+    // Large frames are split into even-aligned bands on the shared worker pool.
+    BYTE* uv = output + (LONGLONG)height * outputStride;
+    VirtuaCam::ConvertBGRAToNV12Parallel(input, inputStride, width, height, output, outputStride, uv, outputStride, colorimetry);
+    return S_OK;
 }
 
-// Y-only variant (used for pixels that share Cb/Cr with a neighbour due to
-// 4:2:0 chroma subsampling).
-static inline void RGB24ToY(int r, int g, int b, BYTE* y)
+// ---------------------------------------------------------------------------
+// Software RGB32 -> YUY2 / I420 / P010 conversion
+// ---------------------------------------------------------------------------
+// Same contract as RGB32ToNV12; output layouts follow the Media Foundation
+// buffer conventions for each format:
+//   YUY2  single packed plane, ceil(width/2) * 4 bytes per row.
+//   I420  Y plane, then Cb, then Cr; the chroma planes use half of
+//         outputStride (the layout MF uses for I420/IYUV buffers).
+//   P010  Y plane then interleaved UV plane, 16-bit samples; outputStride is
+//         in bytes.
+
+HRESULT RGB32ToYUY2(BYTE* input, ULONG inputSize, LONG inputStride, UINT width, UINT height, BYTE* output, ULONG outputSize, LONG outputStride, VirtuaCam::YuvColorimetry colorimetry)
 {
-    *y = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+    const ULONGLONG outputRow = (((ULONGLONG)width + 1) / 2) * 4;
+    RETURN_IF_FAILED(CheckRGB32Conversion(input, inputSize, inputStride, width, height, output, outputSize, outputStride, outputRow, height));
+
+    VirtuaCam::ConvertBGRAToYUY2Parallel(input, inputStride, width, height, output, outputStride, colorimetry);
+    return S_OK;
 }
 
-// Converts two horizontally adjacent pixels from two vertically adjacent rows
-// (a 2x2 block) into NV12 format.  NV12 has a full-resolution Y plane followed
-// by a half-resolution interleaved UV plane (4:2:0 chroma subsampling).
-// Input:  rgb1 = top row (two BGRA pixels = 8 bytes)
-//         rgb2 = bottom row (two BGRA pixels = 8 bytes)
-//         Note: BGRA byte order, so channel indices are [0]=B, [1]=G, [2]=R, [3]=A.
-// Output: y1/y2 = luma for top/bottom row pixels (2 bytes each)
-//         uv    = interleaved Cb,Cr for the 2x2 block (2 bytes)
-static inline void RGB32ToNV12(BYTE rgb1[8], BYTE rgb2[8], BYTE* y1, BYTE* y2, BYTE* uv)
+HRESULT RGB32ToI420(BYTE* input, ULONG inputSize, LONG inputStride, UINT width, UINT height, BYTE* output, ULONG outputSize, LONG outputStride, VirtuaCam::YuvColorimetry colorimetry)
 {
-    // Top-left pixel: compute Y + U/V (U/V represent the whole 2x2 block)
-    RGB24ToYUY2(rgb1[2], rgb1[1], rgb1[0], y1, uv, uv + 1);
-    // Top-right pixel: Y only (shares U/V with top-left)
-    RGB24ToY(rgb1[6], rgb1[5], rgb1[4], y1 + 1);
-    // Bottom-left pixel: Y only (shares U/V — chroma overwritten, but values are similar)
-    RGB24ToYUY2(rgb2[2], rgb2[1], rgb2[0], y2, uv, uv + 1);
-    // Bottom-right pixel: Y only
-    RGB24ToY(rgb2[6], rgb2[5], rgb2[4], y2 + 1);
-};
+    // The chroma planes are addressed with outputStride / 2, so the stride
+    // must be even and its half must cover ceil(width/2) bytes.
+    RETURN_HR_IF(E_INVALIDARG, outputStride % 2 != 0);
+    const ULONGLONG outputRow = ((ULONGLONG)width + 1) & ~1ull;
+    const UINT chromaRows = (height + 1) / 2;
+    RETURN_IF_FAILED(CheckRGB32Conversion(input, inputSize, inputStride, width, height, output, outputSize, outputStride, outputRow, (ULONGLONG)height + chromaRows));
+
+    const LONG chromaStride = outputStride / 2;
+    BYTE* u = output + (LONGLONG)height * outputStride;
+    BYTE* v = u + (LONGLONG)chromaRows * chromaStride;
+    VirtuaCam::ConvertBGRAToI420Parallel(input, inputStride, width, height, output, outputStride, u, chromaStride, v, chromaStride, colorimetry);
+    return S_OK;
+}
 
-// Full-frame RGB32 -> NV12 conversion.
-// Processes the image two rows at a time to correctly handle 4:2:0 chroma
-// subsampling (each U/V sample covers a 2x2 pixel block).
-// Output layout: Y plane [width x height bytes] then UV plane [width x height/2 bytes].
-HRESULT RGB32ToNV12(BYTE* input, ULONG inputSize, LONG inputStride, UINT width, UINT height, BYTE* output, ULONG ouputSize, LONG outputStride)
+HRESULT RGB32ToP010(BYTE* input, ULONG inputSize, LONG inputStride, UINT width, UINT height, BYTE* output, ULONG outputSize, LONG outputStride, VirtuaCam::YuvColorimetry colorimetry)
 {
-    RETURN_HR_IF_NULL(E_INVALIDARG, input);
-    RETURN_HR_IF_NULL(E_INVALIDARG, output);
-    RETURN_HR_IF(E_UNEXPECTED, width * 4 * height > inputSize);
-    RETURN_HR_IF(E_UNEXPECTED, width * 1.5 * height > ouputSize);
-
-    for (DWORD h = 0; h < height - 1; h += 2)
-    {
-        auto rgb1     = h * inputStride + input;
-        auto rgb2pRGB2 = (h + 1) * inputStride + input;
-        auto y1       = h * outputStride + output;
-        auto y2       = (h + 1) * outputStride + output;
-        // UV plane starts immediately after the Y plane at row offset 'height'.
-        auto uv       = (h / 2 + height) * outputStride + output;
-        for (DWORD w = 0; w < width; w += 2)
+    RETURN_HR_IF(E_INVALIDARG, outputStride % 2 != 0);
+    const ULONGLONG outputRow = (((ULONGLONG)width + 1) & ~1ull) * 2;
+    RETURN_IF_FAILED(CheckRGB32Conversion(input, inputSize, inputStride, width, height, output, outputSize, outputStride, outputRow, (ULONGLONG)height + (height + 1) / 2));
+
+    BYTE* uv = output + (LONGLONG)height * outputStride;
+    VirtuaCam::ConvertBGRAToP010Parallel(input, inputStride, width, height,
+                                         reinterpret_cast<uint16_t*>(output), outputStride,
+                                         reinterpret_cast<uint16_t*>(uv), outputStride, colorimetry);
+    return S_OK;
+}
+
+HRESULT SetYuvColorimetry(IMFAttributes* type, VirtuaCam::YuvColorimetry colorimetry)
+{
+    RETURN_HR_IF_NULL(E_INVALIDARG, type);
+
+    MFVideoTransferMatrix matrix = MFVideoTransferMatrix_BT601;
+    switch (colorimetry.matrix)
+    {
+    case VirtuaCam::YuvMatrix::BT709:  matrix = MFVideoTransferMatrix_BT709; break;
+    case VirtuaCam::YuvMatrix::BT2020: matrix = MFVideoTransferMatrix_BT2020_10; break;
+    default: break;
+    }
+    const MFNominalRange range = colorimetry.range == VirtuaCam::YuvRange::Full ? MFNominalRange_0_255 : MFNominalRange_16_235;
+
+    RETURN_IF_FAILED(type->SetUINT32(MF_MT_YUV_MATRIX, matrix));
+    RETURN_IF_FAILED(type->SetUINT32(MF_MT_VIDEO_NOMINAL_RANGE, range));
+    return S_OK;
+}
+
+VirtuaCam::YuvColorimetry GetYuvColorimetry(IMFAttributes* type, UINT width, UINT height)
+{
+    VirtuaCam::YuvColorimetry colorimetry = VirtuaCam::DefaultColorimetry(width, height);
+    if (!type)
+        return colorimetry;
+
+    UINT32 value = 0;
+    if (SUCCEEDED(type->GetUINT32(MF_MT_YUV_MATRIX, &value)))
+    {
+        switch (value)
         {
-            RGB32ToNV12(rgb1, rgb2pRGB2, y1, y2, uv);
-            rgb1     += 8;
-            rgb2pRGB2 += 8;
-            y1  += 2;
-            y2  += 2;
-            uv  += 2;
+        case MFVideoTransferMatrix_BT601:     colorimetry.matrix = VirtuaCam::YuvMatrix::BT601; break;
+        case MFVideoTransferMatrix_BT709:     colorimetry.matrix = VirtuaCam::YuvMatrix::BT709; break;
+        case MFVideoTransferMatrix_BT2020_10:
+        case MFVideoTransferMatrix_BT2020_12: colorimetry.matrix = VirtuaCam::YuvMatrix::BT2020; break;
+        default: break;
         }
     }
-    return S_OK;
+    if (SUCCEEDED(type->GetUINT32(MF_MT_VIDEO_NOMINAL_RANGE, &value)))
+    {
+        if (value == MFNominalRange_0_255)
+            colorimetry.range = VirtuaCam::YuvRange::Full;
+        else if (value == MFNominalRange_16_235)
+            colorimetry.range = VirtuaCam::YuvRange::Limited;
+    }
+    return colorimetry;
 }
 
 // ---------------------------------------------------------------------------
@@ -273,92 +335,532 @@ HANDLE GetHandleFromName(const WCHAR* name)
 }
 
 // ---------------------------------------------------------------------------
-// "No Signal" placeholder texture
+// ManifestView
 // ---------------------------------------------------------------------------
-// CPU-rasters a static placeholder frame once and uploads it as an immutable
-// texture: a subtle dark radial-gradient background with a pre-rendered
-// "NO SIGNAL" wordmark (Selawik, letter-spaced — see NoSignalMask.h) blended
-// in the centre.  Displaying the placeholder is a single CopyResource per
-// frame — no shaders, no animation, no per-frame CPU work.
 
-#include "NoSignalMask.h"
+void InitializeManifest(VirtuaCam::BroadcastManifestV2* manifest, UINT width, UINT height, DXGI_FORMAT format,
+                        LUID adapterLuid, const std::wstring& textureName, const std::wstring& fenceName,
+                        UINT ringSlots)
+{
+    LARGE_INTEGER frequency = {};
+    QueryPerformanceFrequency(&frequency);
+    static_assert(sizeof(wchar_t) == sizeof(char16_t), "manifest names are UTF-16");
+    VirtuaCam::InitializeManifest(*manifest, width, height, (uint32_t)format,
+                                  { adapterLuid.LowPart, adapterLuid.HighPart }, (uint64_t)frequency.QuadPart,
+                                  reinterpret_cast<const char16_t*>(textureName.c_str()),
+                                  reinterpret_cast<const char16_t*>(fenceName.c_str()), ringSlots,
+                                  (uint32_t)GetCurrentProcessId());
+}
 
-namespace
+void MarkManifestStopped(VirtuaCam::BroadcastManifestV2* manifest)
 {
-    // Bilinear sample of the wordmark alpha mask at fractional coordinates.
-    float SampleMask(float x, float y)
+    if (manifest)
     {
-        if (x < 0 || y < 0 || x > kNoSignalMaskWidth - 1.0f || y > kNoSignalMaskHeight - 1.0f)
-            return 0.0f;
-        const UINT x0 = (UINT)x, y0 = (UINT)y;
-        const UINT x1 = std::min(x0 + 1, kNoSignalMaskWidth - 1);
-        const UINT y1 = std::min(y0 + 1, kNoSignalMaskHeight - 1);
-        const float fx = x - x0, fy = y - y0;
-        const float top = kNoSignalMask[y0 * kNoSignalMaskWidth + x0] * (1 - fx) + kNoSignalMask[y0 * kNoSignalMaskWidth + x1] * fx;
-        const float bot = kNoSignalMask[y1 * kNoSignalMaskWidth + x0] * (1 - fx) + kNoSignalMask[y1 * kNoSignalMaskWidth + x1] * fx;
-        return (top * (1 - fy) + bot * fy) / 255.0f;
+        VirtuaCam::MarkManifestStopped(*manifest);
     }
 }
 
-HRESULT CreateNoSignalTexture(ID3D11Device* device, UINT width, UINT height, ID3D11Texture2D** outTexture)
+VirtuaCam::ManifestFrameInfo ManifestFrameNow(UINT64 frameValue, UINT width, UINT height, DXGI_FORMAT format)
 {
-    RETURN_HR_IF_NULL(E_POINTER, device);
-    RETURN_HR_IF_NULL(E_POINTER, outTexture);
-    *outTexture = nullptr;
-    RETURN_HR_IF(E_INVALIDARG, !width || !height);
+    LARGE_INTEGER now = {};
+    QueryPerformanceCounter(&now);
+    VirtuaCam::ManifestFrameInfo info;
+    info.frameValue = frameValue;
+    info.captureTime = now.QuadPart;
+    info.width = width;
+    info.height = height;
+    info.format = (uint32_t)format;
+    return info;
+}
+
+LONGLONG HnsToQpcTicks(LONGLONG hns)
+{
+    LARGE_INTEGER frequency = {};
+    QueryPerformanceFrequency(&frequency);
+    // Split to avoid overflowing hns * frequency.
+    return hns / 10000000 * frequency.QuadPart + hns % 10000000 * frequency.QuadPart / 10000000;
+}
+
+ManifestView::ManifestView(ManifestView&& other) noexcept
+    : m_mapping(std::exchange(other.m_mapping, nullptr)), m_data(std::exchange(other.m_data, nullptr)),
+      m_version(std::exchange(other.m_version, 0)), m_writable(std::exchange(other.m_writable, false))
+{
+}
 
-    // Background: subtle radial gradient, slightly cool dark grey falling off
-    // to near-black at the corners.  Rastered once, so per-pixel cost is free.
-    std::vector<uint32_t> pixels((size_t)width * height);
+ManifestView& ManifestView::operator=(ManifestView&& other) noexcept
+{
+    if (this != &other)
     {
-        constexpr float centerR = 24.0f, centerG = 26.0f, centerB = 30.0f;
-        constexpr float edgeR   =  7.0f, edgeG   =  8.0f, edgeB   = 10.0f;
-        const float cx = width * 0.5f, cy = height * 0.5f;
-        const float invMaxDist = 1.0f / std::sqrt(cx * cx + cy * cy);
-        for (UINT y = 0; y < height; y++)
+        Close();
+        m_mapping = std::exchange(other.m_mapping, nullptr);
+        m_data = std::exchange(other.m_data, nullptr);
+        m_version = std::exchange(other.m_version, 0);
+        m_writable = std::exchange(other.m_writable, false);
+    }
+    return *this;
+}
+
+bool ManifestView::Open(const WCHAR* name)
+{
+    Close();
+    DWORD access = FILE_MAP_READ | FILE_MAP_WRITE;
+    HANDLE mapping = OpenFileMappingW(access, FALSE, name);
+    if (!mapping && GetLastError() == ERROR_ACCESS_DENIED)
+    {
+        access = FILE_MAP_READ;
+        mapping = OpenFileMappingW(access, FALSE, name);
+    }
+    if (!mapping)
+    {
+        return false;
+    }
+    // Map the whole section: a v1 manifest is smaller than a v2 one, and
+    // asking for more than the section holds fails.
+    void* view = MapViewOfFile(mapping, access, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION region = {};
+    const uint32_t version = view && VirtualQuery(view, &region, sizeof(region))
+                           ? VirtuaCam::ManifestVersion(view, region.RegionSize) : 0;
+    if (!version)
+    {
+        if (view)
         {
-            const float dy = (float)y - cy;
-            for (UINT x = 0; x < width; x++)
-            {
-                const float dx = (float)x - cx;
-                float t = std::sqrt(dx * dx + dy * dy) * invMaxDist;
-                t = t * t * (3.0f - 2.0f * t);  // smoothstep for a soft falloff
-                const uint32_t r = (uint32_t)(centerR + (edgeR - centerR) * t);
-                const uint32_t g = (uint32_t)(centerG + (edgeG - centerG) * t);
-                const uint32_t b = (uint32_t)(centerB + (edgeB - centerB) * t);
-                pixels[(size_t)y * width + x] = 0xFF000000u | (r << 16) | (g << 8) | b;
-            }
+            UnmapViewOfFile(view);
         }
+        CloseHandle(mapping);
+        SetLastError(ERROR_INVALID_DATA);
+        return false;
+    }
+    m_mapping = mapping;
+    m_data = view;
+    m_version = version;
+    m_writable = (access & FILE_MAP_WRITE) != 0;
+    return true;
+}
+
+void ManifestView::Close()
+{
+    if (m_data)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping)
+    {
+        CloseHandle(m_mapping);
+    }
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_version = 0;
+    m_writable = false;
+}
+
+UINT64 ManifestView::FrameValue() const
+{
+    if (m_version == 2)
+    {
+        return V2()->frameValue.load(std::memory_order_acquire);
+    }
+    return (UINT64)ReadAcquire64((const volatile LONG64*)&V1()->frameValue);
+}
+
+bool ManifestView::ReadFrameInfo(VirtuaCam::ManifestFrameInfo& info) const
+{
+    if (m_version == 2)
+    {
+        return VirtuaCam::ReadFrameInfo(*V2(), info);
+    }
+    info = {};
+    info.frameValue = FrameValue();
+    info.width = V1()->width;
+    info.height = V1()->height;
+    info.format = (uint32_t)V1()->format;
+    return true;
+}
+
+bool ManifestView::ReadFrameStats(VirtuaCam::ManifestFrameStats& stats) const
+{
+    return m_version == 2 && VirtuaCam::ReadFrameStats(*V2(), stats);
+}
+
+UINT ManifestView::Width() const { return m_version == 2 ? V2()->width : V1()->width; }
+UINT ManifestView::Height() const { return m_version == 2 ? V2()->height : V1()->height; }
+DXGI_FORMAT ManifestView::Format() const { return m_version == 2 ? (DXGI_FORMAT)V2()->format : V1()->format; }
+
+LUID ManifestView::AdapterLuid() const
+{
+    if (m_version == 2)
+    {
+        return { V2()->adapterLuid.lowPart, V2()->adapterLuid.highPart };
     }
+    return V1()->adapterLuid;
+}
+
+const WCHAR* ManifestView::TextureName() const
+{
+    return m_version == 2 ? reinterpret_cast<const WCHAR*>(V2()->textureName) : V1()->textureName;
+}
 
-    // Wordmark: ~1/12th of the frame height, never wider than half the frame,
-    // alpha-blended over the gradient with bilinear scaling.
+const WCHAR* ManifestView::FenceName() const
+{
+    return m_version == 2 ? reinterpret_cast<const WCHAR*>(V2()->fenceName) : V1()->fenceName;
+}
+
+VirtuaCam::TextureRingState* ManifestView::Ring() const
+{
+    if (m_version != 2 || !m_writable)
     {
-        float scale = (height / 12.0f) / kNoSignalMaskHeight;
-        if (kNoSignalMaskWidth * scale > width * 0.5f)
-            scale = (width * 0.5f) / kNoSignalMaskWidth;
-        const UINT outW = std::max(1u, (UINT)(kNoSignalMaskWidth  * scale));
-        const UINT outH = std::max(1u, (UINT)(kNoSignalMaskHeight * scale));
-        const UINT originX = (width  > outW) ? (width  - outW) / 2 : 0;
-        const UINT originY = (height > outH) ? (height - outH) / 2 : 0;
-        constexpr float textR = 0x8A, textG = 0x8F, textB = 0x98;  // soft grey, slightly cool
+        return nullptr;
+    }
+    return VirtuaCam::ManifestRing(*const_cast<VirtuaCam::BroadcastManifestV2*>(V2()));
+}
+
+DWORD ManifestView::ProcessId() const
+{
+    return m_version == 2 ? VirtuaCam::ManifestProcessId(*V2()) : 0;
+}
+
+bool ManifestView::Stopped() const
+{
+    return m_version == 2 && VirtuaCam::ManifestStopped(*V2());
+}
 
-        for (UINT y = 0; y < outH && originY + y < height; y++)
-            for (UINT x = 0; x < outW && originX + x < width; x++)
+// ---------------------------------------------------------------------------
+// Shared texture ring (producer and reader sides)
+// ---------------------------------------------------------------------------
+
+std::wstring RingTextureName(const std::wstring& textureName, UINT slot)
+{
+    return textureName + L"_" + std::to_wstring(slot);
+}
+
+HRESULT SharedTextureRing::Create(ID3D11Device* device, const D3D11_TEXTURE2D_DESC& desc, SECURITY_ATTRIBUTES* sa,
+                                  const std::wstring& textureName, UINT slots, VirtuaCam::TextureRingState* ring)
+{
+    Reset();
+    const UINT count = ring && slots > 1 ? std::clamp<UINT>(slots, VirtuaCam::kMinRingSlots, VirtuaCam::kMaxRingSlots) : 1;
+    for (UINT slot = 0; slot < count; ++slot)
+    {
+        RETURN_IF_FAILED(device->CreateTexture2D(&desc, nullptr, &m_textures[slot]));
+        wil::com_ptr_nothrow<IDXGIResource1> resource;
+        RETURN_IF_FAILED(m_textures[slot]->QueryInterface(IID_PPV_ARGS(&resource)));
+        const std::wstring name = count > 1 ? RingTextureName(textureName, slot) : textureName;
+        RETURN_IF_FAILED(resource->CreateSharedHandle(sa, GENERIC_ALL, name.c_str(), &m_handles[slot]));
+    }
+    m_slots = count;
+    if (count > 1)
+    {
+        m_writer.Attach(ring);
+    }
+    return S_OK;
+}
+
+void SharedTextureRing::Reset()
+{
+    for (UINT slot = 0; slot < VirtuaCam::kMaxRingSlots; ++slot)
+    {
+        if (m_handles[slot])
+        {
+            CloseHandle(m_handles[slot]);
+        }
+        m_handles[slot] = nullptr;
+        m_textures[slot].reset();
+    }
+    m_slots = 0;
+    m_writer.Attach(nullptr);
+}
+
+ID3D11Texture2D* SharedTextureRing::BeginWrite()
+{
+    if (m_slots <= 1)
+    {
+        return m_textures[0].get();
+    }
+    const int slot = m_writer.BeginWrite();
+    return slot >= 0 ? m_textures[slot].get() : nullptr;
+}
+
+void SharedTextureRing::EndWrite(UINT64 frameValue)
+{
+    if (m_slots > 1)
+    {
+        m_writer.EndWrite(frameValue);
+    }
+}
+
+void SharedTextureRing::AbortWrite()
+{
+    if (m_slots > 1)
+    {
+        m_writer.AbortWrite();
+    }
+}
+
+SharedTextureSource& SharedTextureSource::operator=(SharedTextureSource&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        m_manifest = std::move(other.m_manifest);
+        for (UINT slot = 0; slot < VirtuaCam::kMaxRingSlots; ++slot)
+        {
+            m_textures[slot] = std::move(other.m_textures[slot]);
+        }
+        m_slots = std::exchange(other.m_slots, 0);
+        m_reader = std::move(other.m_reader);
+        m_context = std::move(other.m_context);
+        m_readsDone = std::move(other.m_readsDone);
+        m_readsPending = std::exchange(other.m_readsPending, false);
+    }
+    return *this;
+}
+
+HRESULT SharedTextureSource::Open(ID3D11Device* device, const std::wstring& manifestName, const std::wstring& textureName)
+{
+    Close();
+    if (!m_manifest.Open(manifestName.c_str()))
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    auto closeOnFailure = wil::scope_exit([&] { Close(); });
+
+    wil::com_ptr_nothrow<ID3D11Device1> device1;
+    RETURN_IF_FAILED(device->QueryInterface(IID_PPV_ARGS(&device1)));
+
+    // A ring producer shares only the slot textures, so a reader that cannot
+    // pin slots (read-only view) finds nothing under the plain name.
+    VirtuaCam::TextureRingState* ring = m_manifest.Ring();
+    const UINT slots = ring ? VirtuaCam::RingSlotCount(*ring) : 1;
+    for (UINT slot = 0; slot < slots; ++slot)
+    {
+        const std::wstring name = slots > 1 ? RingTextureName(textureName, slot) : textureName;
+        wil::unique_handle handle(GetHandleFromName(name.c_str()));
+        RETURN_HR_IF_NULL(E_FAIL, handle.get());
+        RETURN_IF_FAILED(device1->OpenSharedResource1(handle.get(), IID_PPV_ARGS(&m_textures[slot])));
+    }
+    m_slots = slots;
+    if (slots > 1)
+    {
+        // Slots are only released once the GPU has run the copies out of them.
+        device->GetImmediateContext(&m_context);
+        const D3D11_QUERY_DESC queryDesc = { D3D11_QUERY_EVENT, 0 };
+        RETURN_IF_FAILED(device->CreateQuery(&queryDesc, &m_readsDone));
+        m_reader.Attach(ring);
+    }
+    closeOnFailure.release();
+    return S_OK;
+}
+
+void SharedTextureSource::Close()
+{
+    // Copies still queued may read the pinned slots: let them finish, then
+    // release the pins, which live in the manifest mapping, before unmapping.
+    if (m_readsPending)
+    {
+        while (m_context->GetData(m_readsDone.get(), nullptr, 0, 0) == S_FALSE)
+        {
+            SwitchToThread();
+        }
+        m_readsPending = false;
+    }
+    m_reader.Attach(nullptr);
+    m_readsDone.reset();
+    m_context.reset();
+    for (auto& texture : m_textures)
+    {
+        texture.reset();
+    }
+    m_slots = 0;
+    m_manifest.Close();
+}
+
+ID3D11Texture2D* SharedTextureSource::Acquire(UINT64& frameValue)
+{
+    if (m_slots <= 1)
+    {
+        return m_textures[0].get();
+    }
+    uint32_t slot = 0;
+    uint64_t frame = 0;
+    if (!m_reader.Acquire(slot, frame))
+    {
+        return nullptr;
+    }
+    frameValue = frame;
+    return m_textures[slot].get();
+}
+
+void SharedTextureSource::EndRead()
+{
+    // Every pin retired so far was read by copies queued before this point.
+    if (m_readsDone)
+    {
+        m_context->End(m_readsDone.get());
+        m_readsPending = true;
+    }
+}
+
+void SharedTextureSource::ReleaseCompletedReads()
+{
+    // GetData() without D3D11_ASYNC_GETDATA_DONOTFLUSH submits the queued
+    // work if needed, so the query completes without anyone flushing.
+    if (m_readsPending && m_context->GetData(m_readsDone.get(), nullptr, 0, 0) == S_OK)
+    {
+        m_readsPending = false;
+        m_reader.ReleaseRetired();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// "No Signal" placeholder texture
+// ---------------------------------------------------------------------------
+// The placeholder (see NoSignal.h) is rastered once per frame size and
+// uploaded as an immutable texture, so displaying it is a single CopyResource
+// per frame.  Format renegotiation and reconnects recreate the texture, so the
+// pixels are cached process-wide per (width, height), and they are also
+// persisted as a file in the temp directory: a restarted process maps that
+// file instead of rastering again.
+//
+// Cache file: NoSignalFileHeader followed by width * height BGRA pixels.  The
+// version is part of both the header and the file name; bump it whenever the
+// look of the placeholder changes.
+
+#include "NoSignal.h"
+#include <memory>
+#include <mutex>
+
+namespace
+{
+    constexpr uint32_t kNoSignalFileMagic   = 0x534E4356;   // "VCNS"
+    constexpr uint32_t kNoSignalFileVersion = 1;
+    constexpr size_t   kNoSignalCacheSize   = 2;            // sizes kept in memory
+
+    struct NoSignalFileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    // One cached placeholder: pixels either rastered into 'owned' or mapped
+    // from the cache file through 'view'.
+    struct NoSignalFrame {
+        UINT width = 0;
+        UINT height = 0;
+        std::vector<uint32_t> owned;
+        wil::unique_mapview_ptr<uint8_t> view;
+        const uint32_t* pixels = nullptr;
+    };
+
+    std::mutex g_noSignalLock;
+    std::vector<std::shared_ptr<const NoSignalFrame>> g_noSignalCache;     // most recent first
+
+    std::wstring NoSignalCachePath(UINT width, UINT height)
+    {
+        WCHAR dir[MAX_PATH + 1];
+        const DWORD length = GetTempPathW(ARRAYSIZE(dir), dir);
+        if (!length || length > MAX_PATH)
+            return {};
+        return std::wstring(dir, length) + L"VirtuaCam_NoSignal_v" + std::to_wstring(kNoSignalFileVersion) +
+               L"_" + std::to_wstring(width) + L"x" + std::to_wstring(height) + L".bgra";
+    }
+
+    std::shared_ptr<NoSignalFrame> LoadNoSignalFile(const std::wstring& path, UINT width, UINT height)
+    {
+        wil::unique_hfile file(CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                           nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+        if (!file)
+            return nullptr;
+        LARGE_INTEGER size{};
+        const uint64_t expected = sizeof(NoSignalFileHeader) + (uint64_t)width * height * 4;
+        if (!GetFileSizeEx(file.get(), &size) || (uint64_t)size.QuadPart != expected)
+            return nullptr;
+
+        wil::unique_handle mapping(CreateFileMappingW(file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+        if (!mapping)
+            return nullptr;
+        wil::unique_mapview_ptr<uint8_t> view(static_cast<uint8_t*>(MapViewOfFile(mapping.get(), FILE_MAP_READ, 0, 0, 0)));
+        if (!view)
+            return nullptr;
+
+        const auto* header = reinterpret_cast<const NoSignalFileHeader*>(view.get());
+        if (header->magic != kNoSignalFileMagic || header->version != kNoSignalFileVersion ||
+            header->width != width || header->height != height)
+            return nullptr;
+
+        auto frame = std::make_shared<NoSignalFrame>();
+        frame->width = width;
+        frame->height = height;
+        frame->pixels = reinterpret_cast<const uint32_t*>(header + 1);
+        frame->view = std::move(view);
+        return frame;
+    }
+
+    // Writes to a private temporary name and renames it into place, so other
+    // processes never map a half-written file.  Failure only costs the cache.
+    void SaveNoSignalFile(const std::wstring& path, const NoSignalFrame& frame)
+    {
+        const std::wstring temp = path + L"." + std::to_wstring(GetCurrentProcessId()) + L".tmp";
+        {
+            wil::unique_hfile file(CreateFileW(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                                               FILE_ATTRIBUTE_NORMAL, nullptr));
+            if (!file)
+                return;
+            const NoSignalFileHeader header = { kNoSignalFileMagic, kNoSignalFileVersion, frame.width, frame.height };
+            const DWORD pixelBytes = frame.width * frame.height * 4;
+            DWORD written = 0;
+            const bool ok = WriteFile(file.get(), &header, sizeof(header), &written, nullptr) && written == sizeof(header) &&
+                            WriteFile(file.get(), frame.pixels, pixelBytes, &written, nullptr) && written == pixelBytes;
+            if (!ok)
             {
-                const float a = SampleMask(x / scale, y / scale);
-                if (a <= 0.0f)
-                    continue;
-                uint32_t& dst = pixels[(size_t)(originY + y) * width + (originX + x)];
-                const float bgR = (float)((dst >> 16) & 0xFF);
-                const float bgG = (float)((dst >>  8) & 0xFF);
-                const float bgB = (float)( dst        & 0xFF);
-                const uint32_t r = (uint32_t)(bgR + (textR - bgR) * a);
-                const uint32_t g = (uint32_t)(bgG + (textG - bgG) * a);
-                const uint32_t b = (uint32_t)(bgB + (textB - bgB) * a);
-                dst = 0xFF000000u | (r << 16) | (g << 8) | b;
+                file.reset();
+                DeleteFileW(temp.c_str());
+                return;
             }
+        }
+        if (!MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+            DeleteFileW(temp.c_str());
+    }
+
+    std::shared_ptr<const NoSignalFrame> GetNoSignalFrame(UINT width, UINT height)
+    {
+        std::lock_guard<std::mutex> lock(g_noSignalLock);
+
+        auto cached = std::find_if(g_noSignalCache.begin(), g_noSignalCache.end(),
+            [&](const auto& f) { return f->width == width && f->height == height; });
+        if (cached != g_noSignalCache.end())
+        {
+            std::rotate(g_noSignalCache.begin(), cached, cached + 1);
+            return g_noSignalCache.front();
+        }
+
+        const std::wstring path = NoSignalCachePath(width, height);
+        std::shared_ptr<NoSignalFrame> frame = path.empty() ? nullptr : LoadNoSignalFile(path, width, height);
+        if (!frame)
+        {
+            frame = std::make_shared<NoSignalFrame>();
+            frame->width = width;
+            frame->height = height;
+            frame->owned.resize((size_t)width * height);
+            VirtuaCam::RenderNoSignalFrame(frame->owned.data(), width, height);
+            frame->pixels = frame->owned.data();
+            if (!path.empty())
+                SaveNoSignalFile(path, *frame);
+        }
+
+        g_noSignalCache.insert(g_noSignalCache.begin(), frame);
+        if (g_noSignalCache.size() > kNoSignalCacheSize)
+            g_noSignalCache.pop_back();
+        return frame;
     }
+}
+
+HRESULT CreateNoSignalTexture(ID3D11Device* device, UINT width, UINT height, ID3D11Texture2D** outTexture)
+{
+    RETURN_HR_IF_NULL(E_POINTER, device);
+    RETURN_HR_IF_NULL(E_POINTER, outTexture);
+    *outTexture = nullptr;
+    RETURN_HR_IF(E_INVALIDARG, !width || !height);
+
+    const std::shared_ptr<const NoSignalFrame> frame = GetNoSignalFrame(width, height);
 
     D3D11_TEXTURE2D_DESC desc = {};
     desc.Width            = width;
@@ -369,7 +871,7 @@ HRESULT CreateNoSignalTexture(ID3D11Device* device, UINT width, UINT height, ID3
     desc.SampleDesc.Count = 1;
     desc.Usage            = D3D11_USAGE_IMMUTABLE;
     desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
-    D3D11_SUBRESOURCE_DATA init = { pixels.data(), width * 4, 0 };
+    D3D11_SUBRESOURCE_DATA init = { frame->pixels, width * 4, 0 };
     RETURN_IF_FAILED(device->CreateTexture2D(&desc, &init, outTexture));
     return S_OK;
 }
@@ -3,6 +3,9 @@
 #include <d2d1_1.h>
 #include <ks.h>
 #include <cassert>
+#include <utility>
+#include "Colorimetry.h"
+#include "Manifest.h"
 
 std::string to_string(const std::wstring& ws);
 std::wstring to_wstring(const std::string& s);
@@ -13,17 +16,30 @@ D2D_COLOR_F HSL2RGB(const float h, const float s, const float l);
 const LSTATUS RegWriteKey(HKEY key, PCWSTR path, HKEY* outKey);
 const LSTATUS RegWriteValue(HKEY key, PCWSTR name, const std::wstring& value);
 const LSTATUS RegWriteValue(HKEY key, PCWSTR name, DWORD value);
-HRESULT RGB32ToNV12(BYTE* input, ULONG inputSize, LONG inputStride, UINT width, UINT height, BYTE* output, ULONG ouputSize, LONG outputStride);
+HRESULT RGB32ToNV12(BYTE* input, ULONG inputSize, LONG inputStride, UINT width, UINT height, BYTE* output, ULONG ouputSize, LONG outputStride, VirtuaCam::YuvColorimetry colorimetry = {});
+HRESULT RGB32ToYUY2(BYTE* input, ULONG inputSize, LONG inputStride, UINT width, UINT height, BYTE* output, ULONG outputSize, LONG outputStride, VirtuaCam::YuvColorimetry colorimetry = {});
+HRESULT RGB32ToI420(BYTE* input, ULONG inputSize, LONG inputStride, UINT width, UINT height, BYTE* output, ULONG outputSize, LONG outputStride, VirtuaCam::YuvColorimetry colorimetry = {});
+HRESULT RGB32ToP010(BYTE* input, ULONG inputSize, LONG inputStride, UINT width, UINT height, BYTE* output, ULONG outputSize, LONG outputStride, VirtuaCam::YuvColorimetry colorimetry = {});
+// Tags a YUV media type with MF_MT_YUV_MATRIX / MF_MT_VIDEO_NOMINAL_RANGE so
+// consumers interpret the samples exactly as they were converted.
+HRESULT SetYuvColorimetry(IMFAttributes* type, VirtuaCam::YuvColorimetry colorimetry);
+// Reads the same attributes back; untagged types get DefaultColorimetry(width, height).
+VirtuaCam::YuvColorimetry GetYuvColorimetry(IMFAttributes* type, UINT width, UINT height);
 HANDLE GetHandleFromName(const WCHAR* name);
 
 struct ID3D11Device;
 struct ID3D11Texture2D;
-// Creates a static BGRA8 placeholder texture: black frame with "NO SIGNAL"
+// Creates a static BGRA8 placeholder texture: dark frame with "NO SIGNAL"
 // rastered in the centre.  Shown whenever no producer is feeding the camera.
+// The pixels are cached per (width, height) for the life of the process and
+// persisted in the temp directory across processes.
 HRESULT CreateNoSignalTexture(ID3D11Device* device, UINT width, UINT height, ID3D11Texture2D** outTexture);
 
 enum class VCamCommand;
 
+// The v1 manifest layout (see Manifest.h).  Producers now write
+// VirtuaCam::BroadcastManifestV2; this stays so v1 producers remain
+// readable through ManifestView.
 struct BroadcastManifest {
     UINT64 frameValue;
     UINT width;
@@ -34,6 +50,172 @@ struct BroadcastManifest {
     WCHAR fenceName[256];
     volatile VCamCommand command;
 };
+static_assert(sizeof(BroadcastManifest) == sizeof(VirtuaCam::BroadcastManifestV1) &&
+              offsetof(BroadcastManifest, adapterLuid) == offsetof(VirtuaCam::BroadcastManifestV1, adapterLuid) &&
+              offsetof(BroadcastManifest, command) == offsetof(VirtuaCam::BroadcastManifestV1, command),
+              "BroadcastManifest must match the portable v1 layout");
+
+// Producer side of a v2 manifest: fills the description of a freshly created
+// (zero-filled) mapping, and builds a frame record stamped with the current
+// QPC time for PublishFrame().
+void InitializeManifest(VirtuaCam::BroadcastManifestV2* manifest, UINT width, UINT height, DXGI_FORMAT format,
+                        LUID adapterLuid, const std::wstring& textureName, const std::wstring& fenceName,
+                        UINT ringSlots = 0);
+// Marks a v2 manifest as no longer published; call before unmapping it.
+void MarkManifestStopped(VirtuaCam::BroadcastManifestV2* manifest);
+VirtuaCam::ManifestFrameInfo ManifestFrameNow(UINT64 frameValue, UINT width, UINT height, DXGI_FORMAT format);
+// 100-ns times on the QPC clock (Media Foundation, Windows.Graphics.Capture)
+// to QPC ticks.
+LONGLONG HnsToQpcTicks(LONGLONG hns);
+
+// Read-only view of another process's manifest, opened once when a
+// connection is made and held for its lifetime, so polling for new frames is
+// a plain memory load instead of an open / map / unmap / close per frame.
+// The view keeps the mapping alive after its producer exits, so the mapping
+// says nothing about liveness: that comes from Discovery (producer directory
+// and process-handle watches) or, for a single connection, from ProcessId()
+// and Stopped().  Reads v1 and v2 manifests.  Move-only.
+class ManifestView {
+public:
+    ManifestView() = default;
+    ~ManifestView() { Close(); }
+    ManifestView(ManifestView&& other) noexcept;
+    ManifestView& operator=(ManifestView&& other) noexcept;
+    ManifestView(const ManifestView&) = delete;
+    ManifestView& operator=(const ManifestView&) = delete;
+
+    // Maps the manifest writable when allowed (readers pin texture ring
+    // slots through it), read-only otherwise.  On failure GetLastError() is
+    // ERROR_FILE_NOT_FOUND if no such mapping exists, ERROR_INVALID_DATA if
+    // it holds neither manifest layout.
+    bool Open(const WCHAR* name);
+    void Close();
+    bool IsOpen() const { return m_data != nullptr; }
+    uint32_t Version() const { return m_version; }
+
+    // Latest frame value published by the producer (acquire load; producers
+    // release it after signalling their fence).
+    UINT64 FrameValue() const;
+
+    // Consistent record of the latest frame.  v1 producers publish none, so
+    // it is synthesised from the frame value and the static description.
+    bool ReadFrameInfo(VirtuaCam::ManifestFrameInfo& info) const;
+
+    // Statistics of a recent frame, for producers that publish them (v2
+    // only; see Manifest.h).
+    bool ReadFrameStats(VirtuaCam::ManifestFrameStats& stats) const;
+
+    UINT Width() const;
+    UINT Height() const;
+    DXGI_FORMAT Format() const;
+    LUID AdapterLuid() const;
+    const WCHAR* TextureName() const;
+    const WCHAR* FenceName() const;
+
+    // The producer's texture ring, or null for a single texture (or a
+    // read-only view, which cannot pin slots).
+    VirtuaCam::TextureRingState* Ring() const;
+
+    // The producer's PID (0 for producers that do not record it) and whether
+    // it has marked the manifest stopped (see Manifest.h).
+    DWORD ProcessId() const;
+    bool Stopped() const;
+
+private:
+    const BroadcastManifest* V1() const { return static_cast<const BroadcastManifest*>(m_data); }
+    const VirtuaCam::BroadcastManifestV2* V2() const { return static_cast<const VirtuaCam::BroadcastManifestV2*>(m_data); }
+
+    HANDLE m_mapping = nullptr;
+    const void* m_data = nullptr;
+    uint32_t m_version = 0;
+    bool m_writable = false;
+};
+
+// Name of slot 'slot' of the texture ring advertised as 'textureName'.
+std::wstring RingTextureName(const std::wstring& textureName, UINT slot);
+
+// Producer side of a shared output texture: one texture shared under its
+// name, or a ring of them (TextureRing.h) the producer renders into in turn,
+// skipping any a reader is still copying from.
+class SharedTextureRing {
+public:
+    SharedTextureRing() = default;
+    ~SharedTextureRing() { Reset(); }
+
+    SharedTextureRing(const SharedTextureRing&) = delete;
+    SharedTextureRing& operator=(const SharedTextureRing&) = delete;
+
+    // Creates 'slots' textures from 'desc' (which carries the shared flags)
+    // and shares them: 1 slot under 'textureName', more under
+    // RingTextureName() with 'ring' (the manifest's, already initialised
+    // for that many slots) doing the accounting.
+    HRESULT Create(ID3D11Device* device, const D3D11_TEXTURE2D_DESC& desc, SECURITY_ATTRIBUTES* sa,
+                   const std::wstring& textureName, UINT slots, VirtuaCam::TextureRingState* ring);
+    void Reset();
+
+    UINT Slots() const { return m_slots; }
+
+    // Texture to render the next frame into, or null if every other ring
+    // slot is still being read (drop the frame).  Follow with EndWrite()
+    // after signalling the frame's fence, or AbortWrite().
+    ID3D11Texture2D* BeginWrite();
+    void EndWrite(UINT64 frameValue);
+    void AbortWrite();
+
+private:
+    wil::com_ptr_nothrow<ID3D11Texture2D> m_textures[VirtuaCam::kMaxRingSlots];
+    HANDLE m_handles[VirtuaCam::kMaxRingSlots] = {};
+    UINT m_slots = 0;
+    VirtuaCam::TextureRingWriter m_writer;
+};
+
+// Reader side of a producer's shared output texture: its manifest, and its
+// single texture or texture ring opened on the reader's device.  Holds a pin
+// on the ring slot last acquired, and on earlier slots until an event query
+// issued after their copies (EndRead()) reports that the GPU has run them.
+// The copies must go through the device's immediate context.  Move-only.
+class SharedTextureSource {
+public:
+    SharedTextureSource() = default;
+    ~SharedTextureSource() { Close(); }
+
+    SharedTextureSource(SharedTextureSource&& other) noexcept { *this = std::move(other); }
+    SharedTextureSource& operator=(SharedTextureSource&& other) noexcept;
+    SharedTextureSource(const SharedTextureSource&) = delete;
+    SharedTextureSource& operator=(const SharedTextureSource&) = delete;
+
+    HRESULT Open(ID3D11Device* device, const std::wstring& manifestName, const std::wstring& textureName);
+    void Close();
+    bool IsOpen() const { return m_manifest.IsOpen(); }
+
+    const ManifestView& Manifest() const { return m_manifest; }
+    // Slot 0 (or the single texture), for the source's description.
+    ID3D11Texture2D* Texture() const { return m_textures[0].get(); }
+
+    // Texture holding the newest frame.  'frameValue' comes in as the value
+    // just read from the manifest and goes out as the fence value to wait
+    // for, which for a ring may be newer.  Null if no ring slot could be
+    // pinned this time.
+    ID3D11Texture2D* Acquire(UINT64& frameValue);
+
+    // Call after queuing the copy out of the texture Acquire() returned.
+    void EndRead();
+
+    // Releases the slots whose copies the GPU has completed, without
+    // waiting.  Call once per frame, new frame or not: until then the
+    // producer cannot reuse those slots.
+    void ReleaseCompletedReads();
+
+private:
+    // Destroyed after the reader, whose pins live in the mapped manifest.
+    ManifestView m_manifest;
+    wil::com_ptr_nothrow<ID3D11Texture2D> m_textures[VirtuaCam::kMaxRingSlots];
+    UINT m_slots = 0;
+    VirtuaCam::TextureRingReader m_reader;
+    wil::com_ptr_nothrow<ID3D11DeviceContext> m_context;
+    wil::com_ptr_nothrow<ID3D11Query> m_readsDone;     // D3D11_QUERY_EVENT, ended after each copy
+    bool m_readsPending = false;
+};
 
 _Ret_range_(== , _expr)
 inline bool assert_true(bool _expr)
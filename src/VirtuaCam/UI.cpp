@@ -343,6 +343,9 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
     case WM_TIMER:
         if (wParam == 1) InformBroker();
         break;
+    case WM_APP_PRODUCERS_CHANGED:
+        InformBroker();
+        break;
     case WM_APP_TRAY_MSG:
         if (lParam == WM_RBUTTONUP || lParam == WM_CONTEXTMENU) ShowContextMenu(hwnd);
         else if (lParam == WM_LBUTTONDBLCLK) CreatePreviewWindow();
@@ -0,0 +1,367 @@
+// =============================================================================
+// Warp.cpp  --  Remap-table geometric correction (keystone, lens undistort)
+// =============================================================================
+// See Warp.h for the public contract.
+//
+// Table entry for output pixel (x, y), with the band starting at row y0 and
+// holding 'rows' rows, and the tile starting at column x0 being 'tileWidth'
+// wide:
+//
+//   y0 * dstWidth + rows * x0 + (y - y0) * tileWidth + (x - x0)
+//
+// Each entry is the top-left neighbour (x <= srcWidth - 2, y <= srcHeight - 2)
+// and the weights fx, fy of the right / lower neighbours in 0..64.  Per
+// channel:
+//
+//   top = p00 (64 - fx) + p01 fx            bottom = p10 (64 - fx) + p11 fx
+//   out = (top (64 - fy) + bottom fy + 2048) >> 12
+//
+// which is pmaddubsw (weights fit a signed byte) followed by pmaddwd in SIMD,
+// exact in every kernel.
+// =============================================================================
+
+#include "Warp.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if VCAM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace VirtuaCam {
+
+namespace
+{
+    constexpr uint32_t kWeightOne = 1u << Warp::kFractionBits;    // 64
+    constexpr uint16_t kOutside = 0x80;
+    constexpr uint16_t kWeightMask = 0x7F;
+
+    using RemapRowFn = void (*)(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst,
+                                const uint32_t* coords, const uint16_t* fractions, uint32_t count);
+
+    // -----------------------------------------------------------------------
+    // Table construction
+    // -----------------------------------------------------------------------
+
+    // Projective map of the unit square onto the quad p0..p3 (Heckbert,
+    // "Fundamentals of Texture Mapping"): x = (a u + b v + c) / (g u + h v + 1),
+    // y = (d u + e v + f) / (g u + h v + 1).
+    void SquareToQuad(const float* p, double* m)
+    {
+        const double x0 = p[0], y0 = p[1], x1 = p[2], y1 = p[3], x2 = p[4], y2 = p[5], x3 = p[6], y3 = p[7];
+        const double sx = x0 - x1 + x2 - x3, sy = y0 - y1 + y2 - y3;
+        double g = 0.0, h = 0.0;
+        if (sx != 0.0 || sy != 0.0)
+        {
+            const double dx1 = x1 - x2, dx2 = x3 - x2, dy1 = y1 - y2, dy2 = y3 - y2;
+            const double den = dx1 * dy2 - dx2 * dy1;
+            if (den != 0.0)
+            {
+                g = (sx * dy2 - dx2 * sy) / den;
+                h = (dx1 * sy - sx * dy1) / den;
+            }
+        }
+        m[0] = x1 - x0 + g * x1; m[1] = x3 - x0 + h * x3; m[2] = x0;
+        m[3] = y1 - y0 + g * y1; m[4] = y3 - y0 + h * y3; m[5] = y0;
+        m[6] = g;                m[7] = h;
+    }
+
+    // Source position (pixel units, pixel centres at integers) -> entry.
+    inline void Encode(double sx, double sy, uint32_t srcWidth, uint32_t srcHeight, uint32_t& coord, uint16_t& fraction)
+    {
+        // Written as negated ranges so that NaN (a degenerate keystone) is outside.
+        if (!(sx >= -0.5 && sx <= srcWidth - 0.5 && sy >= -0.5 && sy <= srcHeight - 0.5))
+        {
+            coord = 0;
+            fraction = kOutside;
+            return;
+        }
+        sx = std::clamp(sx, 0.0, srcWidth - 1.0);
+        sy = std::clamp(sy, 0.0, srcHeight - 1.0);
+        const uint32_t x = std::min((uint32_t)sx, srcWidth - 2);
+        const uint32_t y = std::min((uint32_t)sy, srcHeight - 2);
+        const uint32_t fx = (uint32_t)std::lround((sx - x) * kWeightOne);
+        const uint32_t fy = (uint32_t)std::lround((sy - y) * kWeightOne);
+        coord = x | y << 16;
+        fraction = (uint16_t)(fx | fy << 8);
+    }
+
+    // -----------------------------------------------------------------------
+    // Scalar reference
+    // -----------------------------------------------------------------------
+
+    void RemapRow_Scalar(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst,
+                         const uint32_t* coords, const uint16_t* fractions, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint8_t* out = dst + i * 4;
+            const uint32_t f = fractions[i];
+            if (f & kOutside)
+            {
+                std::memset(out, 0, 4);
+                continue;
+            }
+            const uint32_t fx = f & kWeightMask, fy = (f >> 8) & kWeightMask;
+            const uint8_t* p00 = src + (ptrdiff_t)(coords[i] >> 16) * srcStride + (ptrdiff_t)(coords[i] & 0xFFFF) * 4;
+            const uint8_t* p10 = p00 + srcStride;
+            for (int c = 0; c < 4; ++c)
+            {
+                const uint32_t top = p00[c] * (kWeightOne - fx) + p00[c + 4] * fx;
+                const uint32_t bottom = p10[c] * (kWeightOne - fx) + p10[c + 4] * fx;
+                out[c] = (uint8_t)((top * (kWeightOne - fy) + bottom * fy + 2048) >> 12);
+            }
+        }
+    }
+
+#if VCAM_SIMD_X86
+    // -----------------------------------------------------------------------
+    // SSE4.1: 4 pixels per step, neighbours fetched with scalar loads
+    // -----------------------------------------------------------------------
+
+    inline int Load32(const uint8_t* p)
+    {
+        int v;
+        std::memcpy(&v, p, 4);
+        return v;
+    }
+
+    // Interpolates four pixels from their neighbours; 'f' holds the entries'
+    // fractions, one per 32-bit lane.
+    VCAM_TARGET_SSE41 inline __m128i Bilinear4_SSE41(__m128i p00, __m128i p01, __m128i p10, __m128i p11, __m128i f)
+    {
+        const __m128i weightMask = _mm_set1_epi32(kWeightMask);
+        const __m128i one = _mm_set1_epi32(kWeightOne);
+        const __m128i fx = _mm_and_si128(f, weightMask);
+        const __m128i fy = _mm_and_si128(_mm_srli_epi32(f, 8), weightMask);
+        __m128i wx = _mm_or_si128(_mm_sub_epi32(one, fx), _mm_slli_epi32(fx, 8));
+        wx = _mm_or_si128(wx, _mm_slli_epi32(wx, 16));
+        const __m128i wy = _mm_or_si128(_mm_sub_epi32(one, fy), _mm_slli_epi32(fy, 16));
+
+        const __m128i wxLo = _mm_unpacklo_epi32(wx, wx), wxHi = _mm_unpackhi_epi32(wx, wx);
+        const __m128i topLo = _mm_maddubs_epi16(_mm_unpacklo_epi8(p00, p01), wxLo);
+        const __m128i topHi = _mm_maddubs_epi16(_mm_unpackhi_epi8(p00, p01), wxHi);
+        const __m128i botLo = _mm_maddubs_epi16(_mm_unpacklo_epi8(p10, p11), wxLo);
+        const __m128i botHi = _mm_maddubs_epi16(_mm_unpackhi_epi8(p10, p11), wxHi);
+
+        const __m128i round = _mm_set1_epi32(2048);
+        const __m128i r0 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(topLo, botLo), _mm_shuffle_epi32(wy, 0x00)), round), 12);
+        const __m128i r1 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(topLo, botLo), _mm_shuffle_epi32(wy, 0x55)), round), 12);
+        const __m128i r2 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(topHi, botHi), _mm_shuffle_epi32(wy, 0xAA)), round), 12);
+        const __m128i r3 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(topHi, botHi), _mm_shuffle_epi32(wy, 0xFF)), round), 12);
+        const __m128i pixels = _mm_packus_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3));
+
+        const __m128i outside = _mm_cmpeq_epi32(_mm_and_si128(f, _mm_set1_epi32(kOutside)), _mm_set1_epi32(kOutside));
+        return _mm_andnot_si128(outside, pixels);
+    }
+
+    VCAM_TARGET_SSE41 void RemapRow_SSE41(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst,
+                                          const uint32_t* coords, const uint16_t* fractions, uint32_t count)
+    {
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const uint8_t* p[4];
+            for (int k = 0; k < 4; ++k)
+                p[k] = src + (ptrdiff_t)(coords[i + k] >> 16) * srcStride + (ptrdiff_t)(coords[i + k] & 0xFFFF) * 4;
+            const __m128i p00 = _mm_setr_epi32(Load32(p[0]), Load32(p[1]), Load32(p[2]), Load32(p[3]));
+            const __m128i p01 = _mm_setr_epi32(Load32(p[0] + 4), Load32(p[1] + 4), Load32(p[2] + 4), Load32(p[3] + 4));
+            const __m128i p10 = _mm_setr_epi32(Load32(p[0] + srcStride), Load32(p[1] + srcStride),
+                                               Load32(p[2] + srcStride), Load32(p[3] + srcStride));
+            const __m128i p11 = _mm_setr_epi32(Load32(p[0] + srcStride + 4), Load32(p[1] + srcStride + 4),
+                                               Load32(p[2] + srcStride + 4), Load32(p[3] + srcStride + 4));
+            const __m128i f = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)(fractions + i)));
+            _mm_storeu_si128((__m128i*)(dst + i * 4), Bilinear4_SSE41(p00, p01, p10, p11, f));
+        }
+        RemapRow_Scalar(src, srcStride, dst + i * 4, coords + i, fractions + i, count - i);
+    }
+
+    // -----------------------------------------------------------------------
+    // AVX2: 8 pixels per step, neighbours gathered
+    // -----------------------------------------------------------------------
+    // Same steps as Bilinear4_SSE41 in each 128-bit lane.
+
+    VCAM_TARGET_AVX2 inline __m256i Bilinear8_AVX2(__m256i p00, __m256i p01, __m256i p10, __m256i p11, __m256i f)
+    {
+        const __m256i weightMask = _mm256_set1_epi32(kWeightMask);
+        const __m256i one = _mm256_set1_epi32(kWeightOne);
+        const __m256i fx = _mm256_and_si256(f, weightMask);
+        const __m256i fy = _mm256_and_si256(_mm256_srli_epi32(f, 8), weightMask);
+        __m256i wx = _mm256_or_si256(_mm256_sub_epi32(one, fx), _mm256_slli_epi32(fx, 8));
+        wx = _mm256_or_si256(wx, _mm256_slli_epi32(wx, 16));
+        const __m256i wy = _mm256_or_si256(_mm256_sub_epi32(one, fy), _mm256_slli_epi32(fy, 16));
+
+        const __m256i wxLo = _mm256_unpacklo_epi32(wx, wx), wxHi = _mm256_unpackhi_epi32(wx, wx);
+        const __m256i topLo = _mm256_maddubs_epi16(_mm256_unpacklo_epi8(p00, p01), wxLo);
+        const __m256i topHi = _mm256_maddubs_epi16(_mm256_unpackhi_epi8(p00, p01), wxHi);
+        const __m256i botLo = _mm256_maddubs_epi16(_mm256_unpacklo_epi8(p10, p11), wxLo);
+        const __m256i botHi = _mm256_maddubs_epi16(_mm256_unpackhi_epi8(p10, p11), wxHi);
+
+        const __m256i round = _mm256_set1_epi32(2048);
+        const __m256i r0 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(topLo, botLo), _mm256_shuffle_epi32(wy, 0x00)), round), 12);
+        const __m256i r1 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(topLo, botLo), _mm256_shuffle_epi32(wy, 0x55)), round), 12);
+        const __m256i r2 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(topHi, botHi), _mm256_shuffle_epi32(wy, 0xAA)), round), 12);
+        const __m256i r3 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(topHi, botHi), _mm256_shuffle_epi32(wy, 0xFF)), round), 12);
+        const __m256i pixels = _mm256_packus_epi16(_mm256_packs_epi32(r0, r1), _mm256_packs_epi32(r2, r3));
+
+        const __m256i outside = _mm256_cmpeq_epi32(_mm256_and_si256(f, _mm256_set1_epi32(kOutside)), _mm256_set1_epi32(kOutside));
+        return _mm256_andnot_si256(outside, pixels);
+    }
+
+    VCAM_TARGET_AVX2 void RemapRow_AVX2(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst,
+                                        const uint32_t* coords, const uint16_t* fractions, uint32_t count)
+    {
+        const int* top = (const int*)src;
+        const int* topRight = (const int*)(src + 4);
+        const int* bottom = (const int*)(src + srcStride);
+        const int* bottomRight = (const int*)(src + srcStride + 4);
+        const __m256i stride = _mm256_set1_epi32((int)srcStride);
+        const __m256i low16 = _mm256_set1_epi32(0xFFFF);
+
+        uint32_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i c = _mm256_loadu_si256((const __m256i*)(coords + i));
+            const __m256i offset = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(c, 16), stride),
+                                                    _mm256_slli_epi32(_mm256_and_si256(c, low16), 2));
+            const __m256i p00 = _mm256_i32gather_epi32(top, offset, 1);
+            const __m256i p01 = _mm256_i32gather_epi32(topRight, offset, 1);
+            const __m256i p10 = _mm256_i32gather_epi32(bottom, offset, 1);
+            const __m256i p11 = _mm256_i32gather_epi32(bottomRight, offset, 1);
+            const __m256i f = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(fractions + i)));
+            _mm256_storeu_si256((__m256i*)(dst + i * 4), Bilinear8_AVX2(p00, p01, p10, p11, f));
+        }
+        RemapRow_SSE41(src, srcStride, dst + i * 4, coords + i, fractions + i, count - i);
+    }
+#endif
+
+    RemapRowFn SelectRemapRow(SimdLevel level)
+    {
+#if VCAM_SIMD_X86
+        switch (ClampSimdLevel(level))
+        {
+        case SimdLevel::AVX512:
+        case SimdLevel::AVX2:   return RemapRow_AVX2;
+        case SimdLevel::SSE41:  return RemapRow_SSE41;
+        default:                break;
+        }
+#else
+        (void)level;
+#endif
+        return RemapRow_Scalar;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// WarpDesc
+// ---------------------------------------------------------------------------
+
+bool WarpDesc::IsIdentity() const
+{
+    static const WarpDesc identity;
+    return (!dstWidth || dstWidth == srcWidth) && (!dstHeight || dstHeight == srcHeight) &&
+           std::equal(corners, corners + 8, identity.corners) && k1 == 0.0f && k2 == 0.0f && zoom == 1.0f;
+}
+
+// ---------------------------------------------------------------------------
+// Warp
+// ---------------------------------------------------------------------------
+
+bool Warp::Configure(const WarpDesc& desc, WorkerPool& pool)
+{
+    m_coords.clear();
+    m_fractions.clear();
+    if (desc.srcWidth < 2 || desc.srcHeight < 2 || desc.srcWidth > 0xFFFF || desc.srcHeight > 0xFFFF)
+        return false;
+
+    m_desc = desc;
+    if (!m_desc.dstWidth)  m_desc.dstWidth = desc.srcWidth;
+    if (!m_desc.dstHeight) m_desc.dstHeight = desc.srcHeight;
+    if (!(m_desc.zoom > 0.0f))
+        m_desc.zoom = 1.0f;
+    SquareToQuad(m_desc.corners, m_homography);
+
+    const size_t entries = (size_t)m_desc.dstWidth * m_desc.dstHeight;
+    m_coords.resize(entries);
+    m_fractions.resize(entries);
+    pool.ParallelBands(m_desc.dstHeight, kTileHeight, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd)
+    {
+        BuildBand(rowBegin, rowEnd);
+    });
+    return true;
+}
+
+void Warp::BuildBand(uint32_t rowBegin, uint32_t rowEnd)
+{
+    const uint32_t dstWidth = m_desc.dstWidth, dstHeight = m_desc.dstHeight;
+    const uint32_t srcWidth = m_desc.srcWidth, srcHeight = m_desc.srcHeight;
+    const double* m = m_homography;
+    const double invZoom = 1.0 / m_desc.zoom;
+    const double k1 = m_desc.k1, k2 = m_desc.k2;
+    const double invRadius2 = 4.0 / ((double)srcWidth * srcWidth + (double)srcHeight * srcHeight);
+
+    for (uint32_t y0 = rowBegin; y0 < rowEnd; y0 += kTileHeight)
+    {
+        const uint32_t rows = std::min(kTileHeight, dstHeight - y0);
+        size_t entry = (size_t)y0 * dstWidth;
+        for (uint32_t x0 = 0; x0 < dstWidth; x0 += kTileWidth)
+        {
+            const uint32_t tileWidth = std::min(kTileWidth, dstWidth - x0);
+            for (uint32_t y = y0; y < y0 + rows; ++y)
+            {
+                const double v = 0.5 + ((y + 0.5) / dstHeight - 0.5) * invZoom;
+                for (uint32_t x = x0; x < x0 + tileWidth; ++x, ++entry)
+                {
+                    const double u = 0.5 + ((x + 0.5) / dstWidth - 0.5) * invZoom;
+                    const double w = m[6] * u + m[7] * v + 1.0;
+                    const double px = ((m[0] * u + m[1] * v + m[2]) / w - 0.5) * srcWidth;
+                    const double py = ((m[3] * u + m[4] * v + m[5]) / w - 0.5) * srcHeight;
+                    const double r2 = (px * px + py * py) * invRadius2;
+                    const double scale = 1.0 + r2 * (k1 + k2 * r2);
+                    Encode(px * scale + srcWidth * 0.5 - 0.5, py * scale + srcHeight * 0.5 - 0.5,
+                           srcWidth, srcHeight, m_coords[entry], m_fractions[entry]);
+                }
+            }
+        }
+    }
+}
+
+void Warp::ApplyBand(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                     uint32_t rowBegin, uint32_t rowEnd, SimdLevel level) const
+{
+    const RemapRowFn remapRow = SelectRemapRow(level);
+    const uint32_t dstWidth = m_desc.dstWidth, dstHeight = m_desc.dstHeight;
+    for (uint32_t y0 = rowBegin; y0 < rowEnd; y0 += kTileHeight)
+    {
+        const uint32_t rows = std::min(kTileHeight, dstHeight - y0);
+        size_t entry = (size_t)y0 * dstWidth;
+        for (uint32_t x0 = 0; x0 < dstWidth; x0 += kTileWidth)
+        {
+            const uint32_t tileWidth = std::min(kTileWidth, dstWidth - x0);
+            for (uint32_t y = y0; y < y0 + rows; ++y, entry += tileWidth)
+                remapRow(src, srcStride, dst + (ptrdiff_t)y * dstStride + (ptrdiff_t)x0 * 4,
+                         m_coords.data() + entry, m_fractions.data() + entry, tileWidth);
+        }
+    }
+}
+
+void Warp::Apply(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride, SimdLevel level) const
+{
+    if (!src || !dst || !IsConfigured())
+        return;
+    ApplyBand(src, srcStride, dst, dstStride, 0, m_desc.dstHeight, level);
+}
+
+void Warp::ApplyParallel(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                         WorkerPool& pool, SimdLevel level) const
+{
+    if (!src || !dst || !IsConfigured())
+        return;
+    pool.ParallelBands(m_desc.dstHeight, kTileHeight, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd)
+    {
+        ApplyBand(src, srcStride, dst, dstStride, rowBegin, rowEnd, level);
+    });
+}
+
+}
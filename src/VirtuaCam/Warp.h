@@ -0,0 +1,101 @@
+// =============================================================================
+// Warp.h  --  Remap-table geometric correction (keystone, lens undistort)
+// =============================================================================
+// A document camera looking down at an angle sees the page as a trapezoid,
+// and a wide-angle webcam bends straight lines outward (barrel distortion).
+// Both are fixed per setup, so a Warp evaluates the geometry once, in
+// Configure(), into a remap table: for every output pixel, the source pixel
+// it samples.  Each frame is then a plain table-driven bilinear gather with
+// no per-pixel trigonometry or division.
+//
+// The mapping from an output pixel to the source:
+//
+//   1. zoom      about the centre (> 1 crops in to hide the curved border a
+//                strong undistort leaves)
+//   2. keystone  a homography taking the output rectangle onto the quad
+//                'corners' (normalised source coordinates; TL, TR, BR, BL)
+//   3. lens      Brown radial model about the source centre,
+//                r' = r (1 + k1 r^2 + k2 r^4), r = 1 at the corners;
+//                k1 < 0 corrects barrel distortion, k1 > 0 pincushion
+//
+// The table is compact and tile-ordered.  Per output pixel it holds the
+// top-left source pixel as 16-bit x / y (4 bytes) and the 1/64-pixel
+// fractions (2 bytes): 6 bytes in two arrays, against 8 for a pair of float
+// maps.  Entries are stored kTileWidth x kTileHeight tile by tile, so a
+// tile's entries are contiguous and the source pixels it reads stay close
+// together in cache.  Output pixels that map outside the source are black
+// and transparent.
+//
+// Interpolation is fixed-point (horizontal then vertical, 6-bit weights) and
+// bit-identical across the scalar, SSE4.1 and AVX2 kernels; AVX2 fetches the
+// four neighbours with gathers.  AVX-512 reuses AVX2: the gathers dominate
+// and a 16-lane gather issues as many loads as two 8-lane ones.
+//
+// This header (and Warp.cpp) deliberately has no Windows dependency.
+// =============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Simd.h"
+#include "WorkerPool.h"
+
+namespace VirtuaCam {
+
+struct WarpDesc {
+    uint32_t srcWidth = 0, srcHeight = 0;
+    uint32_t dstWidth = 0, dstHeight = 0;   // zero: the source size
+
+    // Where the output's corners land in the source, normalised 0..1:
+    // top-left, top-right, bottom-right, bottom-left as (x, y) pairs.
+    float corners[8] = { 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f };
+
+    float k1 = 0.0f, k2 = 0.0f;     // radial lens coefficients
+    float zoom = 1.0f;
+
+    // True if the warp maps every pixel onto itself (same size, no keystone,
+    // lens or zoom).
+    bool IsIdentity() const;
+};
+
+class Warp {
+public:
+    static constexpr uint32_t kTileWidth = 64;
+    static constexpr uint32_t kTileHeight = 8;
+    static constexpr uint32_t kFractionBits = 6;
+
+    // Builds the remap table (band-parallel on 'pool').  Returns false, leaving
+    // the warp unconfigured, for sources smaller than 2 x 2 or larger than
+    // 65535 in either dimension.
+    bool Configure(const WarpDesc& desc, WorkerPool& pool = WorkerPool::Shared());
+
+    bool IsConfigured() const { return !m_coords.empty(); }
+    const WarpDesc& Desc() const { return m_desc; }
+    uint32_t DstWidth() const { return m_desc.dstWidth; }
+    uint32_t DstHeight() const { return m_desc.dstHeight; }
+
+    // Bytes held by the remap table.
+    size_t TableBytes() const { return m_coords.size() * sizeof(uint32_t) + m_fractions.size() * sizeof(uint16_t); }
+
+    // Warps a srcWidth x srcHeight BGRA frame into dstWidth x dstHeight BGRA.
+    // 'src' and 'dst' must not overlap.  Strides in bytes.
+    void Apply(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+               SimdLevel level = GetSimdLevel()) const;
+
+    void ApplyParallel(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                       WorkerPool& pool = WorkerPool::Shared(), SimdLevel level = GetSimdLevel()) const;
+
+private:
+    void BuildBand(uint32_t rowBegin, uint32_t rowEnd);
+    void ApplyBand(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                   uint32_t rowBegin, uint32_t rowEnd, SimdLevel level) const;
+
+    WarpDesc m_desc;
+    double m_homography[8] = {};    // output (0..1) -> normalised source: a b c d e f g h
+    std::vector<uint32_t> m_coords;     // x | y << 16, tile-ordered
+    std::vector<uint16_t> m_fractions;  // fx | outside flag (0x80) | fy << 8
+};
+
+}
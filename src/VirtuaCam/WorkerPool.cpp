@@ -0,0 +1,215 @@
+// =============================================================================
+// WorkerPool.cpp  --  Persistent worker threads for CPU frame processing
+// =============================================================================
+// See WorkerPool.h.
+//
+// ParallelBands() shares a small job record between the caller and the
+// helpers it enqueues.  Bands are claimed from an atomic counter, so whoever is
+// free takes the next band; helpers that start after all bands are claimed
+// simply return.  The record is reference-counted because a helper may still
+// be unwinding after the caller has observed the last band completing.
+// =============================================================================
+
+#include "WorkerPool.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace VirtuaCam {
+
+namespace
+{
+    struct BandJob
+    {
+        const WorkerPool::BandFn* fn = nullptr;
+        uint32_t rows = 0;
+        uint32_t bandRows = 0;
+        uint32_t bandCount = 0;
+        std::atomic<uint32_t> nextBand{ 0 };
+        std::atomic<uint32_t> doneBands{ 0 };
+        std::mutex lock;
+        std::condition_variable done;
+
+        // Claims and runs bands until none are left.
+        void Run()
+        {
+            for (;;)
+            {
+                const uint32_t band = nextBand.fetch_add(1);
+                if (band >= bandCount)
+                    return;
+                const uint32_t begin = band * bandRows;
+                const uint32_t end = std::min(rows, begin + bandRows);
+                (*fn)(begin, end);
+                if (doneBands.fetch_add(1) + 1 == bandCount)
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    done.notify_all();
+                }
+            }
+        }
+    };
+
+    unsigned ResolveThreadCount(unsigned requested)
+    {
+        if (requested)
+            return requested;
+        const unsigned hw = std::thread::hardware_concurrency();
+        return hw ? hw : 1;
+    }
+}
+
+WorkerPool::WorkerPool(unsigned threadCount)
+{
+    SetThreadCount(threadCount);
+}
+
+WorkerPool::~WorkerPool()
+{
+    StopWorkers();
+}
+
+WorkerPool& WorkerPool::Shared()
+{
+    static WorkerPool* pool = new WorkerPool;
+    return *pool;
+}
+
+void WorkerPool::Shutdown()
+{
+    std::lock_guard<std::mutex> guard(m_restartLock);
+    StopWorkers();
+    m_shutDown.store(true, std::memory_order_release);
+}
+
+void WorkerPool::RestartIfShutDown()
+{
+    if (!m_shutDown.load(std::memory_order_acquire))
+        return;
+    std::lock_guard<std::mutex> guard(m_restartLock);
+    if (!m_shutDown.load(std::memory_order_relaxed))
+        return;
+    StartWorkers(m_threadCount - 1);
+    m_shutDown.store(false, std::memory_order_release);
+}
+
+void WorkerPool::SetThreadCount(unsigned threadCount)
+{
+    const unsigned resolved = ResolveThreadCount(threadCount);
+    if (resolved == m_threadCount && m_workers.size() == resolved - 1)
+        return;
+    StopWorkers();
+    m_threadCount = resolved;
+    StartWorkers(resolved - 1);
+    m_shutDown.store(false, std::memory_order_release);
+}
+
+unsigned WorkerPool::GetThreadCount() const
+{
+    return m_threadCount;
+}
+
+void WorkerPool::StartWorkers(unsigned workerCount)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stopping = false;
+        m_running = workerCount;
+    }
+    m_workers.reserve(workerCount);
+    for (unsigned i = 0; i < workerCount; ++i)
+        m_workers.emplace_back(&WorkerPool::WorkerLoop, this);
+}
+
+void WorkerPool::StopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stopping = true;
+        m_running = 0;
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers)
+        worker.join();
+    m_workers.clear();
+}
+
+void WorkerPool::WorkerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> guard(m_lock);
+            m_wake.wait(guard, [this] { return m_stopping || !m_tasks.empty(); });
+            // Drain queued work before honouring a stop request so that no
+            // ParallelBands() caller is left waiting on a dropped helper.
+            if (m_tasks.empty())
+                return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void WorkerPool::Submit(std::function<void()> task)
+{
+    RestartIfShutDown();
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (m_running)
+        {
+            m_tasks.push_back(std::move(task));
+            task = nullptr;
+        }
+    }
+    if (task)
+        task();     // no workers, or being shut down
+    else
+        m_wake.notify_one();
+}
+
+void WorkerPool::ParallelBands(uint32_t rows, uint32_t alignment, uint32_t minRows, const BandFn& fn)
+{
+    if (!rows)
+        return;
+    RestartIfShutDown();
+    alignment = std::max(alignment, 1u);
+    minRows = std::max(minRows, alignment);
+
+    // Band height: an even share per thread, rounded up to the alignment and
+    // never smaller than minRows.
+    const uint32_t maxBands = std::max(1u, std::min(m_threadCount, rows / minRows));
+    uint32_t bandRows = (rows + maxBands - 1) / maxBands;
+    bandRows = (bandRows + alignment - 1) / alignment * alignment;
+    const uint32_t bandCount = (rows + bandRows - 1) / bandRows;
+
+    if (bandCount <= 1 || m_threadCount <= 1)
+    {
+        fn(0, rows);
+        return;
+    }
+
+    auto job = std::make_shared<BandJob>();
+    job->fn = &fn;
+    job->rows = rows;
+    job->bandRows = bandRows;
+    job->bandCount = bandCount;
+
+    // With no workers (being shut down) nothing is queued and the caller
+    // runs every band itself.
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        for (uint32_t i = 1; m_running && i < bandCount; ++i)
+            m_tasks.push_back([job] { job->Run(); });
+    }
+    m_wake.notify_all();
+
+    job->Run();
+
+    std::unique_lock<std::mutex> guard(job->lock);
+    job->done.wait(guard, [&] { return job->doneBands.load() == bandCount; });
+}
+
+}
@@ -0,0 +1,100 @@
+// =============================================================================
+// WorkerPool.h  --  Persistent worker threads for CPU frame processing
+// =============================================================================
+// CPU pixel kernels (colour conversion, scaling, ...) split a frame into
+// horizontal bands and run them on a pool of threads that is created once and
+// reused for every frame; no thread is ever created per frame.
+//
+// ParallelBands() is a fork/join: the calling thread processes bands itself
+// alongside the workers and returns only when every band is done (a single
+// join per frame).  Because the caller always participates, calling it from a
+// worker thread cannot deadlock, it just runs with less help.
+//
+// Thread-count knob
+// -----------------
+// SetThreadCount(n) sets the total number of threads that work on a frame,
+// including the caller (n - 1 workers are kept alive).  0 means "one per
+// logical processor"; 1 makes everything run inline on the caller.
+//
+// Shutdown
+// --------
+// Shared() is never destroyed: its destructor would join the workers from
+// DLL_PROCESS_DETACH, under the loader lock, which can hang.  A module that
+// uses it calls Shutdown() from its own teardown instead (ShutdownProducer,
+// ShutdownBroker, the client's stream shutdown), before it can be unloaded.
+// The workers are restarted by the next ParallelBands() or Submit().
+//
+// This module deliberately has no Windows dependency (std::thread only).
+// =============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+namespace VirtuaCam {
+
+class WorkerPool {
+public:
+    // Band callback: process rows [rowBegin, rowEnd).
+    using BandFn = std::function<void(uint32_t rowBegin, uint32_t rowEnd)>;
+
+    // Rows below which splitting a frame costs more in wake-ups than it saves
+    // (64 rows of 1080p BGRA is about 0.5 MB); the usual ParallelBands minRows.
+    static constexpr uint32_t kMinBandRows = 64;
+
+    explicit WorkerPool(unsigned threadCount = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Process-wide pool shared by all kernels in this module.  Deliberately
+    // leaked; see Shutdown().
+    static WorkerPool& Shared();
+
+    // Joins the workers; until they are restarted by the next ParallelBands()
+    // or Submit(), work runs inline on the caller.  Call it from module
+    // teardown, not while another thread is still using the pool.
+    void Shutdown();
+
+    // Total threads used per frame (workers + caller).  Changing the count
+    // joins the existing workers and starts new ones; do not call it while
+    // another thread is inside ParallelBands().
+    void SetThreadCount(unsigned threadCount);
+    unsigned GetThreadCount() const;
+
+    // Splits [0, rows) into at most GetThreadCount() bands.  Every band but the
+    // last starts and ends on a multiple of 'alignment' (e.g. 2 for 4:2:0
+    // chroma) and holds at least 'minRows' rows, so small frames run as one
+    // band on the caller without touching the workers.
+    void ParallelBands(uint32_t rows, uint32_t alignment, uint32_t minRows, const BandFn& fn);
+
+    // Queues a fire-and-forget task on the workers (runs inline if the pool
+    // has no workers).  Used by pipelines that overlap whole frames.
+    void Submit(std::function<void()> task);
+
+private:
+    void StartWorkers(unsigned workerCount);
+    void StopWorkers();
+    void RestartIfShutDown();
+    void WorkerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_lock;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+    unsigned m_running = 0;             // workers accepting tasks (under m_lock)
+    unsigned m_threadCount = 1;
+    std::atomic<bool> m_shutDown{ false };
+    std::mutex m_restartLock;
+};
+
+}
@@ -0,0 +1,509 @@
+// =============================================================================
+// YuvUnpack.cpp  --  CPU YUV -> BGRA conversion kernels
+// =============================================================================
+// See YuvUnpack.h for the public contract and Colorimetry.h for the fixed-point
+// formulas.
+//
+// SIMD layout
+// -----------
+// Every format is first reduced to two byte vectors: N luma samples and N/2
+// Cb/Cr pairs in memory order (NV12 rows already look like that; YUY2/UYVY
+// are split with one pshufb).  The shared core then widens both to 16 bits,
+// pairs each luma with a constant 1 and each pixel with its duplicated
+// (Cb, Cr) pair, and evaluates
+//
+//   ys = madd([y, 1],  [YG, round])
+//   R  = ys + madd([u, v], [0,  RV])
+//   G  = ys + madd([u, v], [GU, GV])
+//   B  = ys + madd([u, v], [BU, 0 ])
+//
+// in 32-bit lanes.  Saturating packs do the clamping, and the B/G and R/A
+// words are interleaved into BGRA bytes.  The AVX2/AVX-512 cores work per
+// 128-bit lane (8 pixels each), so the final stores re-interleave lanes.
+// =============================================================================
+
+#include "YuvUnpack.h"
+#include <algorithm>
+
+#if VCAM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace VirtuaCam {
+
+namespace
+{
+    // -----------------------------------------------------------------------
+    // Scalar reference
+    // -----------------------------------------------------------------------
+
+    inline uint8_t ClampByte(int v)
+    {
+        return (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+    }
+
+    template <class C>
+    inline void StoreBGRA(int y, int cb, int cr, uint8_t* bgra)
+    {
+        const int ys = (y - C::YOffset) * C::YG + C::Round;
+        const int u = cb - C::UVOffset;
+        const int v = cr - C::UVOffset;
+        bgra[0] = ClampByte((ys + C::BU * u) >> C::Shift);
+        bgra[1] = ClampByte((ys + C::GU * u + C::GV * v) >> C::Shift);
+        bgra[2] = ClampByte((ys + C::RV * v) >> C::Shift);
+        bgra[3] = 255;
+    }
+
+    // One output row from one luma row and its (shared) chroma row.
+    using NV12UnpackRowFn = void (*)(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width);
+
+    // One output row from one packed 4:2:2 row.
+    using PackedUnpackRowFn = void (*)(const uint8_t* src, uint8_t* dst, uint32_t width);
+
+    template <class C>
+    void NV12ToBGRARow_Scalar(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const uint8_t* pair = uv + (x & ~1u);
+            StoreBGRA<C>(y[x], pair[0], pair[1], dst + x * 4);
+        }
+    }
+
+    // Byte offsets of Y0, Cb, Y1, Cr within a 4-byte packed pair.
+    template <bool UYVY> struct PackedLayout            { static constexpr int Y0 = 0, U = 1, Y1 = 2, V = 3; };
+    template <>          struct PackedLayout<true>      { static constexpr int Y0 = 1, U = 0, Y1 = 3, V = 2; };
+
+    template <class C, bool UYVY>
+    void PackedToBGRARow_Scalar(const uint8_t* src, uint8_t* dst, uint32_t width)
+    {
+        using L = PackedLayout<UYVY>;
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const uint8_t* pair = src + (x / 2) * 4;
+            StoreBGRA<C>(pair[(x & 1) ? L::Y1 : L::Y0], pair[L::U], pair[L::V], dst + x * 4);
+        }
+    }
+
+#if VCAM_SIMD_X86
+    // -----------------------------------------------------------------------
+    // SSE4.1  (8 pixels per core call)
+    // -----------------------------------------------------------------------
+
+    // pshufb masks that split 8 packed pixels into 8 luma bytes | 4 chroma pairs.
+    VCAM_TARGET_SSE41 inline __m128i PackedSplitMask_SSE41(bool uyvy)
+    {
+        return uyvy ? _mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15, 0, 2, 4, 6, 8, 10, 12, 14)
+                    : _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+    }
+
+    // Computes B, G, R (4 x int32 each) for four pixels.
+    template <class C>
+    VCAM_TARGET_SSE41 inline void Rgb4_SSE41(__m128i yPairs, __m128i uvDup, __m128i& b, __m128i& g, __m128i& r)
+    {
+        const __m128i kY = _mm_setr_epi16(C::YG, C::Round, C::YG, C::Round, C::YG, C::Round, C::YG, C::Round);
+        const __m128i kR = _mm_setr_epi16(0, C::RV, 0, C::RV, 0, C::RV, 0, C::RV);
+        const __m128i kG = _mm_setr_epi16(C::GU, C::GV, C::GU, C::GV, C::GU, C::GV, C::GU, C::GV);
+        const __m128i kB = _mm_setr_epi16(C::BU, 0, C::BU, 0, C::BU, 0, C::BU, 0);
+        const __m128i ys = _mm_madd_epi16(yPairs, kY);
+        b = _mm_srai_epi32(_mm_add_epi32(ys, _mm_madd_epi16(uvDup, kB)), C::Shift);
+        g = _mm_srai_epi32(_mm_add_epi32(ys, _mm_madd_epi16(uvDup, kG)), C::Shift);
+        r = _mm_srai_epi32(_mm_add_epi32(ys, _mm_madd_epi16(uvDup, kR)), C::Shift);
+    }
+
+    // 8 luma bytes + 4 chroma pairs (low halves of y8 / uv8) -> 32 BGRA bytes,
+    // returned as pixels 0-3 and 4-7.
+    template <class C>
+    VCAM_TARGET_SSE41 inline void YuvToBGRA8_SSE41(__m128i y8, __m128i uv8, __m128i& out0, __m128i& out1)
+    {
+        const __m128i one = _mm_set1_epi16(1);
+        const __m128i y  = _mm_sub_epi16(_mm_cvtepu8_epi16(y8), _mm_set1_epi16(C::YOffset));
+        const __m128i uv = _mm_sub_epi16(_mm_cvtepu8_epi16(uv8), _mm_set1_epi16(C::UVOffset));
+
+        __m128i b0, g0, r0, b1, g1, r1;
+        Rgb4_SSE41<C>(_mm_unpacklo_epi16(y, one), _mm_unpacklo_epi32(uv, uv), b0, g0, r0);
+        Rgb4_SSE41<C>(_mm_unpackhi_epi16(y, one), _mm_unpackhi_epi32(uv, uv), b1, g1, r1);
+
+        const __m128i b = _mm_packs_epi32(b0, b1);
+        const __m128i g = _mm_packs_epi32(g0, g1);
+        const __m128i r = _mm_packs_epi32(r0, r1);
+        const __m128i a = _mm_set1_epi16(255);
+        const __m128i bgLo = _mm_unpacklo_epi16(b, g), bgHi = _mm_unpackhi_epi16(b, g);
+        const __m128i raLo = _mm_unpacklo_epi16(r, a), raHi = _mm_unpackhi_epi16(r, a);
+        out0 = _mm_packus_epi16(_mm_unpacklo_epi32(bgLo, raLo), _mm_unpackhi_epi32(bgLo, raLo));
+        out1 = _mm_packus_epi16(_mm_unpacklo_epi32(bgHi, raHi), _mm_unpackhi_epi32(bgHi, raHi));
+    }
+
+    template <class C>
+    VCAM_TARGET_SSE41 void NV12ToBGRARow_SSE41(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width)
+    {
+        uint32_t x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            __m128i out0, out1;
+            YuvToBGRA8_SSE41<C>(_mm_loadl_epi64((const __m128i*)(y + x)), _mm_loadl_epi64((const __m128i*)(uv + x)), out0, out1);
+            _mm_storeu_si128((__m128i*)(dst + x * 4), out0);
+            _mm_storeu_si128((__m128i*)(dst + x * 4 + 16), out1);
+        }
+        if (x < width)
+            NV12ToBGRARow_Scalar<C>(y + x, uv + x, dst + x * 4, width - x);
+    }
+
+    template <class C, bool UYVY>
+    VCAM_TARGET_SSE41 void PackedToBGRARow_SSE41(const uint8_t* src, uint8_t* dst, uint32_t width)
+    {
+        const __m128i split = PackedSplitMask_SSE41(UYVY);
+        uint32_t x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            const __m128i s = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + x * 2)), split);
+            __m128i out0, out1;
+            YuvToBGRA8_SSE41<C>(s, _mm_srli_si128(s, 8), out0, out1);
+            _mm_storeu_si128((__m128i*)(dst + x * 4), out0);
+            _mm_storeu_si128((__m128i*)(dst + x * 4 + 16), out1);
+        }
+        if (x < width)
+            PackedToBGRARow_Scalar<C, UYVY>(src + x * 2, dst + x * 4, width - x);
+    }
+
+    // -----------------------------------------------------------------------
+    // AVX2  (16 pixels per core call)
+    // -----------------------------------------------------------------------
+
+    template <class C>
+    VCAM_TARGET_AVX2 inline void Rgb8_AVX2(__m256i yPairs, __m256i uvDup, __m256i& b, __m256i& g, __m256i& r)
+    {
+        const __m256i kY = _mm256_broadcastsi128_si256(_mm_setr_epi16(C::YG, C::Round, C::YG, C::Round, C::YG, C::Round, C::YG, C::Round));
+        const __m256i kR = _mm256_broadcastsi128_si256(_mm_setr_epi16(0, C::RV, 0, C::RV, 0, C::RV, 0, C::RV));
+        const __m256i kG = _mm256_broadcastsi128_si256(_mm_setr_epi16(C::GU, C::GV, C::GU, C::GV, C::GU, C::GV, C::GU, C::GV));
+        const __m256i kB = _mm256_broadcastsi128_si256(_mm_setr_epi16(C::BU, 0, C::BU, 0, C::BU, 0, C::BU, 0));
+        const __m256i ys = _mm256_madd_epi16(yPairs, kY);
+        b = _mm256_srai_epi32(_mm256_add_epi32(ys, _mm256_madd_epi16(uvDup, kB)), C::Shift);
+        g = _mm256_srai_epi32(_mm256_add_epi32(ys, _mm256_madd_epi16(uvDup, kG)), C::Shift);
+        r = _mm256_srai_epi32(_mm256_add_epi32(ys, _mm256_madd_epi16(uvDup, kR)), C::Shift);
+    }
+
+    // 16 luma bytes + 8 chroma pairs -> 64 BGRA bytes at dst.
+    template <class C>
+    VCAM_TARGET_AVX2 inline void YuvToBGRA16_AVX2(__m128i y16, __m128i uv16, uint8_t* dst)
+    {
+        const __m256i one = _mm256_set1_epi16(1);
+        const __m256i y  = _mm256_sub_epi16(_mm256_cvtepu8_epi16(y16), _mm256_set1_epi16(C::YOffset));
+        const __m256i uv = _mm256_sub_epi16(_mm256_cvtepu8_epi16(uv16), _mm256_set1_epi16(C::UVOffset));
+
+        __m256i b0, g0, r0, b1, g1, r1;
+        Rgb8_AVX2<C>(_mm256_unpacklo_epi16(y, one), _mm256_unpacklo_epi32(uv, uv), b0, g0, r0);
+        Rgb8_AVX2<C>(_mm256_unpackhi_epi16(y, one), _mm256_unpackhi_epi32(uv, uv), b1, g1, r1);
+
+        const __m256i b = _mm256_packs_epi32(b0, b1);
+        const __m256i g = _mm256_packs_epi32(g0, g1);
+        const __m256i r = _mm256_packs_epi32(r0, r1);
+        const __m256i a = _mm256_set1_epi16(255);
+        const __m256i bgLo = _mm256_unpacklo_epi16(b, g), bgHi = _mm256_unpackhi_epi16(b, g);
+        const __m256i raLo = _mm256_unpacklo_epi16(r, a), raHi = _mm256_unpackhi_epi16(r, a);
+        const __m256i out0 = _mm256_packus_epi16(_mm256_unpacklo_epi32(bgLo, raLo), _mm256_unpackhi_epi32(bgLo, raLo));  // px 0-3 | 8-11
+        const __m256i out1 = _mm256_packus_epi16(_mm256_unpacklo_epi32(bgHi, raHi), _mm256_unpackhi_epi32(bgHi, raHi));  // px 4-7 | 12-15
+        _mm256_storeu_si256((__m256i*)(dst), _mm256_permute2x128_si256(out0, out1, 0x20));
+        _mm256_storeu_si256((__m256i*)(dst + 32), _mm256_permute2x128_si256(out0, out1, 0x31));
+    }
+
+    template <class C>
+    VCAM_TARGET_AVX2 void NV12ToBGRARow_AVX2(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width)
+    {
+        uint32_t x = 0;
+        for (; x + 16 <= width; x += 16)
+            YuvToBGRA16_AVX2<C>(_mm_loadu_si128((const __m128i*)(y + x)), _mm_loadu_si128((const __m128i*)(uv + x)), dst + x * 4);
+        if (x < width)
+            NV12ToBGRARow_SSE41<C>(y + x, uv + x, dst + x * 4, width - x);
+    }
+
+    template <class C, bool UYVY>
+    VCAM_TARGET_AVX2 void PackedToBGRARow_AVX2(const uint8_t* src, uint8_t* dst, uint32_t width)
+    {
+        const __m256i split = _mm256_broadcastsi128_si256(PackedSplitMask_SSE41(UYVY));
+        uint32_t x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            const __m256i s = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(src + x * 2)), split);
+            const __m256i t = _mm256_permute4x64_epi64(s, _MM_SHUFFLE(3, 1, 2, 0));          // Y0..15 | UV0..7
+            YuvToBGRA16_AVX2<C>(_mm256_castsi256_si128(t), _mm256_extracti128_si256(t, 1), dst + x * 4);
+        }
+        if (x < width)
+            PackedToBGRARow_SSE41<C, UYVY>(src + x * 2, dst + x * 4, width - x);
+    }
+
+    // -----------------------------------------------------------------------
+    // AVX-512 BW  (32 pixels per core call)
+    // -----------------------------------------------------------------------
+
+    template <class C>
+    VCAM_TARGET_AVX512 inline void Rgb16_AVX512(__m512i yPairs, __m512i uvDup, __m512i& b, __m512i& g, __m512i& r)
+    {
+        const __m512i kY = _mm512_broadcast_i32x4(_mm_setr_epi16(C::YG, C::Round, C::YG, C::Round, C::YG, C::Round, C::YG, C::Round));
+        const __m512i kR = _mm512_broadcast_i32x4(_mm_setr_epi16(0, C::RV, 0, C::RV, 0, C::RV, 0, C::RV));
+        const __m512i kG = _mm512_broadcast_i32x4(_mm_setr_epi16(C::GU, C::GV, C::GU, C::GV, C::GU, C::GV, C::GU, C::GV));
+        const __m512i kB = _mm512_broadcast_i32x4(_mm_setr_epi16(C::BU, 0, C::BU, 0, C::BU, 0, C::BU, 0));
+        const __m512i ys = _mm512_madd_epi16(yPairs, kY);
+        b = _mm512_srai_epi32(_mm512_add_epi32(ys, _mm512_madd_epi16(uvDup, kB)), C::Shift);
+        g = _mm512_srai_epi32(_mm512_add_epi32(ys, _mm512_madd_epi16(uvDup, kG)), C::Shift);
+        r = _mm512_srai_epi32(_mm512_add_epi32(ys, _mm512_madd_epi16(uvDup, kR)), C::Shift);
+    }
+
+    // 32 luma bytes + 16 chroma pairs -> 128 BGRA bytes at dst.
+    template <class C>
+    VCAM_TARGET_AVX512 inline void YuvToBGRA32_AVX512(__m256i y32, __m256i uv32, uint8_t* dst)
+    {
+        const __m512i one = _mm512_set1_epi16(1);
+        const __m512i y  = _mm512_sub_epi16(_mm512_cvtepu8_epi16(y32), _mm512_set1_epi16(C::YOffset));
+        const __m512i uv = _mm512_sub_epi16(_mm512_cvtepu8_epi16(uv32), _mm512_set1_epi16(C::UVOffset));
+
+        __m512i b0, g0, r0, b1, g1, r1;
+        Rgb16_AVX512<C>(_mm512_unpacklo_epi16(y, one), _mm512_unpacklo_epi32(uv, uv), b0, g0, r0);
+        Rgb16_AVX512<C>(_mm512_unpackhi_epi16(y, one), _mm512_unpackhi_epi32(uv, uv), b1, g1, r1);
+
+        const __m512i b = _mm512_packs_epi32(b0, b1);
+        const __m512i g = _mm512_packs_epi32(g0, g1);
+        const __m512i r = _mm512_packs_epi32(r0, r1);
+        const __m512i a = _mm512_set1_epi16(255);
+        const __m512i bgLo = _mm512_unpacklo_epi16(b, g), bgHi = _mm512_unpackhi_epi16(b, g);
+        const __m512i raLo = _mm512_unpacklo_epi16(r, a), raHi = _mm512_unpackhi_epi16(r, a);
+        const __m512i out0 = _mm512_packus_epi16(_mm512_unpacklo_epi32(bgLo, raLo), _mm512_unpackhi_epi32(bgLo, raLo));  // lane k: px 8k..8k+3
+        const __m512i out1 = _mm512_packus_epi16(_mm512_unpacklo_epi32(bgHi, raHi), _mm512_unpackhi_epi32(bgHi, raHi));  // lane k: px 8k+4..8k+7
+        _mm512_storeu_si512(dst,      _mm512_permutex2var_epi64(out0, _mm512_setr_epi64(0, 1, 8, 9, 2, 3, 10, 11), out1));
+        _mm512_storeu_si512(dst + 64, _mm512_permutex2var_epi64(out0, _mm512_setr_epi64(4, 5, 12, 13, 6, 7, 14, 15), out1));
+    }
+
+    template <class C>
+    VCAM_TARGET_AVX512 void NV12ToBGRARow_AVX512(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width)
+    {
+        uint32_t x = 0;
+        for (; x + 32 <= width; x += 32)
+            YuvToBGRA32_AVX512<C>(_mm256_loadu_si256((const __m256i*)(y + x)), _mm256_loadu_si256((const __m256i*)(uv + x)), dst + x * 4);
+        if (x < width)
+            NV12ToBGRARow_AVX2<C>(y + x, uv + x, dst + x * 4, width - x);
+    }
+
+    template <class C, bool UYVY>
+    VCAM_TARGET_AVX512 void PackedToBGRARow_AVX512(const uint8_t* src, uint8_t* dst, uint32_t width)
+    {
+        const __m512i split = _mm512_broadcast_i32x4(PackedSplitMask_SSE41(UYVY));
+        const __m512i order = _mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
+        uint32_t x = 0;
+        for (; x + 32 <= width; x += 32)
+        {
+            const __m512i s = _mm512_shuffle_epi8(_mm512_loadu_si512(src + x * 2), split);
+            const __m512i t = _mm512_permutexvar_epi64(order, s);                              // Y0..31 | UV0..15
+            YuvToBGRA32_AVX512<C>(_mm512_castsi512_si256(t), _mm512_extracti64x4_epi64(t, 1), dst + x * 4);
+        }
+        if (x < width)
+            PackedToBGRARow_AVX2<C, UYVY>(src + x * 2, dst + x * 4, width - x);
+    }
+#endif
+
+    // -----------------------------------------------------------------------
+    // Dispatch: one kernel per (matrix, range, SIMD level), chosen per frame
+    // -----------------------------------------------------------------------
+
+    struct NV12UnpackKernels
+    {
+        using Fn = NV12UnpackRowFn;
+
+        template <class C>
+        static Fn Select(SimdLevel level)
+        {
+#if VCAM_SIMD_X86
+            switch (ClampSimdLevel(level))
+            {
+            case SimdLevel::AVX512: return NV12ToBGRARow_AVX512<C>;
+            case SimdLevel::AVX2:   return NV12ToBGRARow_AVX2<C>;
+            case SimdLevel::SSE41:  return NV12ToBGRARow_SSE41<C>;
+            default:                break;
+            }
+#endif
+            return NV12ToBGRARow_Scalar<C>;
+        }
+    };
+
+    template <bool UYVY>
+    struct PackedUnpackKernels
+    {
+        using Fn = PackedUnpackRowFn;
+
+        template <class C>
+        static Fn Select(SimdLevel level)
+        {
+#if VCAM_SIMD_X86
+            switch (ClampSimdLevel(level))
+            {
+            case SimdLevel::AVX512: return PackedToBGRARow_AVX512<C, UYVY>;
+            case SimdLevel::AVX2:   return PackedToBGRARow_AVX2<C, UYVY>;
+            case SimdLevel::SSE41:  return PackedToBGRARow_SSE41<C, UYVY>;
+            default:                break;
+            }
+#endif
+            return PackedToBGRARow_Scalar<C, UYVY>;
+        }
+    };
+
+    template <class K>
+    typename K::Fn SelectKernel(YuvColorimetry colorimetry, SimdLevel level)
+    {
+        using M = YuvMatrix;
+        using R = YuvRange;
+        using SelectFn = typename K::Fn (*)(SimdLevel);
+        static constexpr SelectFn table[3][2] = {
+            { K::template Select<RgbCoefficients<M::BT601,  R::Limited>>, K::template Select<RgbCoefficients<M::BT601,  R::Full>> },
+            { K::template Select<RgbCoefficients<M::BT709,  R::Limited>>, K::template Select<RgbCoefficients<M::BT709,  R::Full>> },
+            { K::template Select<RgbCoefficients<M::BT2020, R::Limited>>, K::template Select<RgbCoefficients<M::BT2020, R::Full>> },
+        };
+        const unsigned m = std::min((unsigned)colorimetry.matrix, 2u);
+        const unsigned r = std::min((unsigned)colorimetry.range, 1u);
+        return table[m][r](level);
+    }
+
+    void ConvertPacked(PackedUnpackRowFn convertRow, const uint8_t* src, ptrdiff_t srcStride,
+                       uint32_t width, uint32_t height, uint8_t* dst, ptrdiff_t dstStride)
+    {
+        for (uint32_t y = 0; y < height; ++y)
+            convertRow(src + (ptrdiff_t)y * srcStride, dst + (ptrdiff_t)y * dstStride, width);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public entry points
+// ---------------------------------------------------------------------------
+
+void ConvertNV12ToBGRA(const uint8_t* srcY, ptrdiff_t srcYStride,
+                       const uint8_t* srcUV, ptrdiff_t srcUVStride,
+                       uint32_t width, uint32_t height,
+                       uint8_t* dst, ptrdiff_t dstStride,
+                       YuvColorimetry colorimetry, SimdLevel level)
+{
+    if (!srcY || !srcUV || !dst || !width || !height)
+        return;
+
+    const NV12UnpackRowFn convertRow = SelectKernel<NV12UnpackKernels>(colorimetry, level);
+    for (uint32_t y = 0; y < height; ++y)
+        convertRow(srcY + (ptrdiff_t)y * srcYStride, srcUV + (ptrdiff_t)(y / 2) * srcUVStride, dst + (ptrdiff_t)y * dstStride, width);
+}
+
+void ConvertNV12ToBGRAParallel(const uint8_t* srcY, ptrdiff_t srcYStride,
+                               const uint8_t* srcUV, ptrdiff_t srcUVStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dst, ptrdiff_t dstStride,
+                               YuvColorimetry colorimetry, WorkerPool& pool, SimdLevel level)
+{
+    if (!srcY || !srcUV || !dst || !width || !height)
+        return;
+
+    pool.ParallelBands(height, 2, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd)
+    {
+        ConvertNV12ToBGRA(srcY + (ptrdiff_t)rowBegin * srcYStride, srcYStride,
+                          srcUV + (ptrdiff_t)(rowBegin / 2) * srcUVStride, srcUVStride,
+                          width, rowEnd - rowBegin,
+                          dst + (ptrdiff_t)rowBegin * dstStride, dstStride,
+                          colorimetry, level);
+    });
+}
+
+void ConvertNV12ToBGRAParallel(const uint8_t* srcY, ptrdiff_t srcYStride,
+                               const uint8_t* srcUV, ptrdiff_t srcUVStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dst, ptrdiff_t dstStride,
+                               YuvColorimetry colorimetry, Orientation orientation,
+                               WorkerPool& pool, SimdLevel level)
+{
+    if (!srcY || !srcUV || !dst || !width || !height)
+        return;
+
+    // Chunks start on multiples of kOrientChunkRows, i.e. on a chroma row.
+    ProduceOriented(width, height, [&](uint32_t rowBegin, uint32_t rowEnd, uint8_t* rows, ptrdiff_t stride) {
+        ConvertNV12ToBGRA(srcY + (ptrdiff_t)rowBegin * srcYStride, srcYStride,
+                          srcUV + (ptrdiff_t)(rowBegin / 2) * srcUVStride, srcUVStride,
+                          width, rowEnd - rowBegin, rows, stride, colorimetry, level);
+    }, dst, dstStride, orientation, pool, level);
+}
+
+void ConvertYUY2ToBGRA(const uint8_t* src, ptrdiff_t srcStride,
+                       uint32_t width, uint32_t height,
+                       uint8_t* dst, ptrdiff_t dstStride,
+                       YuvColorimetry colorimetry, SimdLevel level)
+{
+    if (!src || !dst || !width || !height)
+        return;
+    ConvertPacked(SelectKernel<PackedUnpackKernels<false>>(colorimetry, level), src, srcStride, width, height, dst, dstStride);
+}
+
+void ConvertYUY2ToBGRAParallel(const uint8_t* src, ptrdiff_t srcStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dst, ptrdiff_t dstStride,
+                               YuvColorimetry colorimetry, WorkerPool& pool, SimdLevel level)
+{
+    if (!src || !dst || !width || !height)
+        return;
+
+    const PackedUnpackRowFn convertRow = SelectKernel<PackedUnpackKernels<false>>(colorimetry, level);
+    pool.ParallelBands(height, 1, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd)
+    {
+        ConvertPacked(convertRow, src + (ptrdiff_t)rowBegin * srcStride, srcStride,
+                      width, rowEnd - rowBegin, dst + (ptrdiff_t)rowBegin * dstStride, dstStride);
+    });
+}
+
+void ConvertYUY2ToBGRAParallel(const uint8_t* src, ptrdiff_t srcStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dst, ptrdiff_t dstStride,
+                               YuvColorimetry colorimetry, Orientation orientation,
+                               WorkerPool& pool, SimdLevel level)
+{
+    if (!src || !dst || !width || !height)
+        return;
+
+    const PackedUnpackRowFn convertRow = SelectKernel<PackedUnpackKernels<false>>(colorimetry, level);
+    ProduceOriented(width, height, [&](uint32_t rowBegin, uint32_t rowEnd, uint8_t* rows, ptrdiff_t stride) {
+        ConvertPacked(convertRow, src + (ptrdiff_t)rowBegin * srcStride, srcStride, width, rowEnd - rowBegin, rows, stride);
+    }, dst, dstStride, orientation, pool, level);
+}
+
+void ConvertUYVYToBGRA(const uint8_t* src, ptrdiff_t srcStride,
+                       uint32_t width, uint32_t height,
+                       uint8_t* dst, ptrdiff_t dstStride,
+                       YuvColorimetry colorimetry, SimdLevel level)
+{
+    if (!src || !dst || !width || !height)
+        return;
+    ConvertPacked(SelectKernel<PackedUnpackKernels<true>>(colorimetry, level), src, srcStride, width, height, dst, dstStride);
+}
+
+void ConvertUYVYToBGRAParallel(const uint8_t* src, ptrdiff_t srcStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dst, ptrdiff_t dstStride,
+                               YuvColorimetry colorimetry, WorkerPool& pool, SimdLevel level)
+{
+    if (!src || !dst || !width || !height)
+        return;
+
+    const PackedUnpackRowFn convertRow = SelectKernel<PackedUnpackKernels<true>>(colorimetry, level);
+    pool.ParallelBands(height, 1, WorkerPool::kMinBandRows, [&](uint32_t rowBegin, uint32_t rowEnd)
+    {
+        ConvertPacked(convertRow, src + (ptrdiff_t)rowBegin * srcStride, srcStride,
+                      width, rowEnd - rowBegin, dst + (ptrdiff_t)rowBegin * dstStride, dstStride);
+    });
+}
+
+void ConvertUYVYToBGRAParallel(const uint8_t* src, ptrdiff_t srcStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dst, ptrdiff_t dstStride,
+                               YuvColorimetry colorimetry, Orientation orientation,
+                               WorkerPool& pool, SimdLevel level)
+{
+    if (!src || !dst || !width || !height)
+        return;
+
+    const PackedUnpackRowFn convertRow = SelectKernel<PackedUnpackKernels<true>>(colorimetry, level);
+    ProduceOriented(width, height, [&](uint32_t rowBegin, uint32_t rowEnd, uint8_t* rows, ptrdiff_t stride) {
+        ConvertPacked(convertRow, src + (ptrdiff_t)rowBegin * srcStride, srcStride, width, rowEnd - rowBegin, rows, stride);
+    }, dst, dstStride, orientation, pool, level);
+}
+
+}
@@ -0,0 +1,99 @@
+// =============================================================================
+// YuvUnpack.h  --  CPU YUV -> BGRA conversion kernels
+// =============================================================================
+// The inverse of ColorConvert.h: turns the YUV frames that webcams deliver
+// natively (NV12, YUY2, UYVY) into BGRA for the shared producer texture, so the
+// camera producer never needs Media Foundation's software video processor.
+//
+// Every kernel is templated on RgbCoefficients<> (Colorimetry.h) and has a
+// scalar reference plus SSE4.1 / AVX2 / AVX-512 variants selected through
+// Simd.h; all variants produce bit-identical output.  Alpha is always 255.
+//
+// Strides are in bytes and may exceed the row width.  Chroma for pixel x is
+// taken from pair x/2 (and NV12 row y/2), i.e. nearest-neighbour upsampling.
+//
+// The Orientation overloads fuse a mirror / rotation into the conversion:
+// rows are converted a chunk at a time into cache-resident scratch and stored
+// oriented from there (Orientation.h); 'dst' has the oriented size.
+//
+// This header (and YuvUnpack.cpp) deliberately has no Windows dependency.
+// =============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Simd.h"
+#include "Colorimetry.h"
+#include "Orientation.h"
+#include "WorkerPool.h"
+
+namespace VirtuaCam {
+
+// NV12 (Y plane + interleaved Cb/Cr plane at half resolution) -> BGRA.
+void ConvertNV12ToBGRA(const uint8_t* srcY, ptrdiff_t srcYStride,
+                       const uint8_t* srcUV, ptrdiff_t srcUVStride,
+                       uint32_t width, uint32_t height,
+                       uint8_t* dst, ptrdiff_t dstStride,
+                       YuvColorimetry colorimetry = {},
+                       SimdLevel level = GetSimdLevel());
+
+void ConvertNV12ToBGRAParallel(const uint8_t* srcY, ptrdiff_t srcYStride,
+                               const uint8_t* srcUV, ptrdiff_t srcUVStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dst, ptrdiff_t dstStride,
+                               YuvColorimetry colorimetry = {},
+                               WorkerPool& pool = WorkerPool::Shared(),
+                               SimdLevel level = GetSimdLevel());
+
+void ConvertNV12ToBGRAParallel(const uint8_t* srcY, ptrdiff_t srcYStride,
+                               const uint8_t* srcUV, ptrdiff_t srcUVStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dst, ptrdiff_t dstStride,
+                               YuvColorimetry colorimetry, Orientation orientation,
+                               WorkerPool& pool = WorkerPool::Shared(),
+                               SimdLevel level = GetSimdLevel());
+
+// YUY2 (Y0 Cb Y1 Cr) -> BGRA.
+void ConvertYUY2ToBGRA(const uint8_t* src, ptrdiff_t srcStride,
+                       uint32_t width, uint32_t height,
+                       uint8_t* dst, ptrdiff_t dstStride,
+                       YuvColorimetry colorimetry = {},
+                       SimdLevel level = GetSimdLevel());
+
+void ConvertYUY2ToBGRAParallel(const uint8_t* src, ptrdiff_t srcStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dst, ptrdiff_t dstStride,
+                               YuvColorimetry colorimetry = {},
+                               WorkerPool& pool = WorkerPool::Shared(),
+                               SimdLevel level = GetSimdLevel());
+
+void ConvertYUY2ToBGRAParallel(const uint8_t* src, ptrdiff_t srcStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dst, ptrdiff_t dstStride,
+                               YuvColorimetry colorimetry, Orientation orientation,
+                               WorkerPool& pool = WorkerPool::Shared(),
+                               SimdLevel level = GetSimdLevel());
+
+// UYVY (Cb Y0 Cr Y1) -> BGRA.
+void ConvertUYVYToBGRA(const uint8_t* src, ptrdiff_t srcStride,
+                       uint32_t width, uint32_t height,
+                       uint8_t* dst, ptrdiff_t dstStride,
+                       YuvColorimetry colorimetry = {},
+                       SimdLevel level = GetSimdLevel());
+
+void ConvertUYVYToBGRAParallel(const uint8_t* src, ptrdiff_t srcStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dst, ptrdiff_t dstStride,
+                               YuvColorimetry colorimetry = {},
+                               WorkerPool& pool = WorkerPool::Shared(),
+                               SimdLevel level = GetSimdLevel());
+
+void ConvertUYVYToBGRAParallel(const uint8_t* src, ptrdiff_t srcStride,
+                               uint32_t width, uint32_t height,
+                               uint8_t* dst, ptrdiff_t dstStride,
+                               YuvColorimetry colorimetry, Orientation orientation,
+                               WorkerPool& pool = WorkerPool::Shared(),
+                               SimdLevel level = GetSimdLevel());
+
+}
@@ -0,0 +1,38 @@
+// =============================================================================
+// Bench.h  --  Timing helpers for the benchmarks
+// =============================================================================
+// Benchmarks are plain executables that print one line per measurement.  With
+// --quick (how ctest runs them) they use a couple of iterations so the suite
+// stays fast and only checks that every path runs; by hand they run long
+// enough for stable numbers.
+// =============================================================================
+
+#pragma once
+
+#include <chrono>
+#include <cstring>
+
+namespace VirtuaCam::Test {
+
+inline bool QuickMode(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i)
+        if (!std::strcmp(argv[i], "--quick"))
+            return true;
+    return false;
+}
+
+// Milliseconds per call of 'fn', averaged over 'iterations' after one
+// warm-up call.
+template <typename Fn>
+double TimeMs(int iterations, Fn&& fn)
+{
+    fn();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        fn();
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (iterations > 0 ? iterations : 1);
+}
+
+}
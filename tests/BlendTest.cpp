@@ -0,0 +1,138 @@
+// =============================================================================
+// BlendTest.cpp  --  Fill / copy / premultiplied blend / mask blend
+// =============================================================================
+// Random rectangles, partly or wholly off the surface, are drawn with every
+// SIMD tier and compared with a per-pixel reference written from the formulas
+// in Blend.h (rounded division by 255, clipping, untouched pixels outside
+// the rectangle).
+// =============================================================================
+
+#include "Check.h"
+#include "Blend.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    const SimdLevel kLevels[] = { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512 };
+
+    uint32_t Div255(uint32_t v) { return (v + 127) / 255; }
+
+    struct Rect {
+        uint32_t surfaceW, surfaceH;
+        int32_t x, y;
+        uint32_t w, h;
+
+        // Calls fn(dstX, dstY, srcX, srcY) for every covered surface pixel.
+        template <typename Fn>
+        void ForEach(Fn&& fn) const
+        {
+            for (uint32_t j = 0; j < h; ++j)
+            {
+                for (uint32_t i = 0; i < w; ++i)
+                {
+                    const int64_t dx = (int64_t)x + i, dy = (int64_t)y + j;
+                    if (dx >= 0 && dy >= 0 && dx < surfaceW && dy < surfaceH)
+                        fn((uint32_t)dx, (uint32_t)dy, i, j);
+                }
+            }
+        }
+    };
+
+    void ReferenceFill(std::vector<uint8_t>& surface, const Rect& r, uint32_t color)
+    {
+        r.ForEach([&](uint32_t dx, uint32_t dy, uint32_t, uint32_t) {
+            std::memcpy(&surface[(dy * r.surfaceW + dx) * 4], &color, 4);
+        });
+    }
+
+    void ReferenceOver(std::vector<uint8_t>& surface, const Rect& r, const std::vector<uint8_t>& src, uint8_t opacity)
+    {
+        r.ForEach([&](uint32_t dx, uint32_t dy, uint32_t sx, uint32_t sy) {
+            const uint8_t* s = &src[(sy * r.w + sx) * 4];
+            uint8_t* d = &surface[(dy * r.surfaceW + dx) * 4];
+            uint32_t scaled[4];
+            for (int c = 0; c < 4; ++c)
+                scaled[c] = Div255(s[c] * opacity);
+            for (int c = 0; c < 4; ++c)
+                d[c] = (uint8_t)std::min<uint32_t>(255, scaled[c] + Div255(d[c] * (255 - scaled[3])));
+        });
+    }
+
+    void ReferenceMask(std::vector<uint8_t>& surface, const Rect& r, const std::vector<uint8_t>& mask, uint32_t color)
+    {
+        uint8_t col[4];
+        std::memcpy(col, &color, 4);
+        r.ForEach([&](uint32_t dx, uint32_t dy, uint32_t sx, uint32_t sy) {
+            const uint32_t m = mask[sy * r.w + sx];
+            uint8_t* d = &surface[(dy * r.surfaceW + dx) * 4];
+            for (int c = 0; c < 4; ++c)
+                d[c] = (uint8_t)Div255(col[c] * m + d[c] * (255 - m));
+        });
+    }
+
+    void ReferenceCopy(std::vector<uint8_t>& surface, const Rect& r, const std::vector<uint8_t>& src)
+    {
+        r.ForEach([&](uint32_t dx, uint32_t dy, uint32_t sx, uint32_t sy) {
+            std::memcpy(&surface[(dy * r.surfaceW + dx) * 4], &src[(sy * r.w + sx) * 4], 4);
+        });
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(1);
+    for (int iteration = 0; iteration < 2000; ++iteration)
+    {
+        Rect r;
+        r.surfaceW = 1 + rng() % 70;
+        r.surfaceH = 1 + rng() % 20;
+        r.w = 1 + rng() % 80;
+        r.h = 1 + rng() % 25;
+        r.x = (int32_t)(rng() % (r.surfaceW + 20)) - 10;
+        r.y = (int32_t)(rng() % (r.surfaceH + 20)) - 10;
+        if (iteration % 50 == 0)
+            r.x = -(int32_t)r.w - 1;                    // wholly off the surface
+
+        std::vector<uint8_t> base(r.surfaceW * r.surfaceH * 4), src(r.w * r.h * 4), mask(r.w * r.h);
+        for (auto& v : base)
+            v = (uint8_t)rng();
+        for (auto& v : mask)
+            v = (uint8_t)rng();
+        for (uint32_t i = 0; i < r.w * r.h; ++i)
+        {
+            const uint8_t a = (uint8_t)rng();
+            src[i * 4 + 3] = a;
+            for (int c = 0; c < 3; ++c)
+                src[i * 4 + c] = (uint8_t)(rng() % (a + 1u));      // premultiplied
+        }
+        const uint8_t opacity = iteration % 3 == 0 ? 255 : (uint8_t)rng();
+        const uint32_t color = rng();
+
+        std::vector<uint8_t> fill = base, over = base, masked = base, copy = base;
+        ReferenceFill(fill, r, color);
+        ReferenceOver(over, r, src, opacity);
+        ReferenceMask(masked, r, mask, color);
+        ReferenceCopy(copy, r, src);
+
+        for (SimdLevel level : kLevels)
+        {
+            std::vector<uint8_t> a = base, b = base, c = base;
+            const ptrdiff_t stride = r.surfaceW * 4;
+            FillRect({ a.data(), stride, r.surfaceW, r.surfaceH }, r.x, r.y, r.w, r.h, color, level);
+            BlendOver({ b.data(), stride, r.surfaceW, r.surfaceH }, r.x, r.y, src.data(), r.w * 4, r.w, r.h, opacity, level);
+            BlendMask({ c.data(), stride, r.surfaceW, r.surfaceH }, r.x, r.y, mask.data(), r.w, r.w, r.h, color, level);
+            CHECK_MSG(a == fill, "fill %ux%u at %d,%d on %ux%u %s", r.w, r.h, r.x, r.y, r.surfaceW, r.surfaceH, SimdLevelName(level));
+            CHECK_MSG(b == over, "over %ux%u at %d,%d opacity %u %s", r.w, r.h, r.x, r.y, opacity, SimdLevelName(level));
+            CHECK_MSG(c == masked, "mask %ux%u at %d,%d %s", r.w, r.h, r.x, r.y, SimdLevelName(level));
+        }
+        std::vector<uint8_t> d = base;
+        CopyRect({ d.data(), (ptrdiff_t)r.surfaceW * 4, r.surfaceW, r.surfaceH }, r.x, r.y, src.data(), r.w * 4, r.w, r.h);
+        CHECK_MSG(d == copy, "copy %ux%u at %d,%d", r.w, r.h, r.x, r.y);
+    }
+    return Test::CheckResult();
+}
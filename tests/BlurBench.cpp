@@ -0,0 +1,52 @@
+// =============================================================================
+// BlurBench.cpp  --  Blur cost against radius
+// =============================================================================
+// 1080p BGRA, box radii 4 to 64: a single box pass and the 3-pass Gaussian
+// of the same sigma per SIMD tier at full resolution (the cost should stay
+// flat as the radius grows), then the Gaussian at 1/2 and 1/4 resolution.
+// =============================================================================
+
+#include "Bench.h"
+#include "Blur.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+int main(int argc, char** argv)
+{
+    const int iterations = Test::QuickMode(argc, argv) ? 1 : 10;
+    const uint32_t w = 1920, h = 1080;
+    std::mt19937 rng(3);
+    std::vector<uint8_t> src((size_t)w * h * 4), dst(src.size());
+    for (auto& v : src)
+        v = (uint8_t)rng();
+
+    for (uint32_t radius : { 4u, 8u, 16u, 32u, 64u })
+    {
+        // The sigma of a single box of this radius.
+        const float sigma = (float)std::sqrt(((2.0 * radius + 1) * (2.0 * radius + 1) - 1) / 12.0);
+        for (uint32_t passes : { 1u, 3u })
+            for (int l = 0; l <= (int)GetSimdLevel(); ++l)
+            {
+                Blur blur;
+                blur.Configure(w, h, sigma, passes, 1);
+                const double ms = Test::TimeMs(iterations, [&] {
+                    blur.Apply(src.data(), w * 4, dst.data(), w * 4, WorkerPool::Shared(), (SimdLevel)l);
+                });
+                std::printf("radius %2u  %u pass%s  box radii %3u %3u %3u  %-10s %8.3f ms\n", radius, passes,
+                            passes > 1 ? "es" : "  ", blur.BoxRadius(0), blur.BoxRadius(1), blur.BoxRadius(2),
+                            SimdLevelName((SimdLevel)l), ms);
+            }
+        for (uint32_t downscale : { 2u, 4u })
+        {
+            Blur blur;
+            blur.Configure(w, h, sigma, 3, downscale);
+            const double ms = Test::TimeMs(iterations, [&] { blur.Apply(src.data(), w * 4, dst.data(), w * 4); });
+            std::printf("radius %2u  3 passes  at 1/%u size                %8.3f ms\n", radius, blur.Downscale(), ms);
+        }
+    }
+    return 0;
+}
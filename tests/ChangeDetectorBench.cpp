@@ -0,0 +1,45 @@
+// =============================================================================
+// ChangeDetectorBench.cpp  --  Tile-hash cost per frame
+// =============================================================================
+// 1080p and 4K BGRA frames, per SIMD tier and band-parallel, against a plain
+// frame copy (what publishing an unchanged frame costs at the least).
+// =============================================================================
+
+#include "Bench.h"
+#include "ChangeDetector.h"
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+int main(int argc, char** argv)
+{
+    const int iterations = Test::QuickMode(argc, argv) ? 2 : 50;
+    struct Size { const char* name; uint32_t width, height; };
+    const Size sizes[] = { { "1080p", 1920, 1080 }, { "4K", 3840, 2160 } };
+    std::mt19937 rng(3);
+
+    for (const Size& size : sizes)
+    {
+        const uint32_t w = size.width, h = size.height;
+        std::vector<uint8_t> frame((size_t)w * h * 4), copy(frame.size());
+        for (auto& v : frame)
+            v = (uint8_t)rng();
+
+        std::printf("%-6s memcpy          %8.3f ms/frame\n", size.name,
+                    Test::TimeMs(iterations, [&] { std::memcpy(copy.data(), frame.data(), frame.size()); }));
+        for (int l = 0; l <= (int)GetSimdLevel(); ++l)
+        {
+            ChangeDetector detector(w, h);
+            const double ms = Test::TimeMs(iterations, [&] { detector.Update(frame.data(), w * 4, (SimdLevel)l); });
+            std::printf("%-6s hash %-10s %8.3f ms/frame\n", size.name, SimdLevelName((SimdLevel)l), ms);
+        }
+        ChangeDetector detector(w, h);
+        const double ms = Test::TimeMs(iterations, [&] { detector.UpdateParallel(frame.data(), w * 4); });
+        std::printf("%-6s hash parallel   %8.3f ms/frame (%u threads)\n", size.name, ms,
+                    WorkerPool::Shared().GetThreadCount());
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+// =============================================================================
+// ChangeDetectorTest.cpp  --  Tile hashing and dirty-tile reporting
+// =============================================================================
+// For random frame and tile sizes, on every SIMD tier and the parallel path:
+// the first Update() marks everything dirty, an identical frame marks
+// nothing, a one-byte change marks exactly its tile (and the bounds cover
+// it), stride padding is ignored, and Invalidate() / Configure() reset.
+// =============================================================================
+
+#include "Check.h"
+#include "ChangeDetector.h"
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    const SimdLevel kLevels[] = { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512 };
+
+    bool Update(ChangeDetector& detector, const std::vector<uint8_t>& frame, ptrdiff_t stride, int path, WorkerPool& pool)
+    {
+        return path < 4 ? detector.Update(frame.data(), stride, kLevels[path])
+                        : detector.UpdateParallel(frame.data(), stride, pool);
+    }
+
+    void RandomFrames()
+    {
+        std::mt19937 rng(3);
+        WorkerPool pool(4);
+        for (int iteration = 0; iteration < 200; ++iteration)
+        {
+            const uint32_t w = 1 + rng() % 300, h = 1 + rng() % 200, tile = 1 + rng() % 80;
+            const ptrdiff_t stride = w * 4 + (rng() % 3) * 4;
+            std::vector<uint8_t> frame(stride * h);
+            for (auto& v : frame)
+                v = (uint8_t)rng();
+            const uint32_t x = rng() % w, y = rng() % h;
+            const size_t changed = y * stride + x * 4 + rng() % 4;
+            const uint8_t flip = (uint8_t)(1 + rng() % 255);
+
+            for (int path = 0; path < 5; ++path)
+            {
+                std::vector<uint8_t> f = frame;
+                ChangeDetector detector(w, h, tile);
+                const uint32_t tiles = detector.TilesX() * detector.TilesY();
+                CHECK(detector.TilesX() == (w + tile - 1) / tile && detector.TilesY() == (h + tile - 1) / tile);
+                CHECK_MSG(Update(detector, f, stride, path, pool) && detector.DirtyCount() == tiles, "first, path %d", path);
+                CHECK_MSG(!Update(detector, f, stride, path, pool) && detector.DirtyCount() == 0, "same, path %d", path);
+                const ChangeDetector::Rect none = detector.DirtyBounds();
+                CHECK(none.width == 0 || none.height == 0);
+
+                f[changed] ^= flip;
+                const bool dirty = Update(detector, f, stride, path, pool);
+                CHECK_MSG(dirty && detector.DirtyCount() == 1 && detector.IsDirty(x / tile, y / tile),
+                          "%ux%u tile %u byte %u,%u path %d: %u dirty", w, h, tile, x, y, path, detector.DirtyCount());
+                const ChangeDetector::Rect r = detector.DirtyBounds();
+                CHECK(x >= r.x && x < r.x + r.width && y >= r.y && y < r.y + r.height);
+                CHECK(r.x + r.width <= w && r.y + r.height <= h);
+
+                if (stride > (ptrdiff_t)w * 4)
+                {
+                    f[stride - 1] ^= 0xFF;
+                    CHECK_MSG(!Update(detector, f, stride, path, pool), "padding, path %d", path);
+                }
+
+                detector.Invalidate();
+                CHECK(Update(detector, f, stride, path, pool) && detector.DirtyCount() == tiles);
+                detector.Configure(w, h, tile);                  // unchanged: keeps the previous frame
+                CHECK(!Update(detector, f, stride, path, pool));
+            }
+        }
+    }
+
+    // Every tier computes the same hashes, so detectors on different tiers
+    // agree tile for tile on a multi-tile change.
+    void TiersAgree()
+    {
+        std::mt19937 rng(4);
+        const uint32_t w = 640, h = 360;
+        std::vector<uint8_t> a(w * h * 4), b;
+        for (auto& v : a)
+            v = (uint8_t)rng();
+        b = a;
+        for (int i = 0; i < 40; ++i)
+            b[rng() % b.size()] ^= 0x10;
+
+        std::vector<uint8_t> reference;
+        for (SimdLevel level : kLevels)
+        {
+            ChangeDetector detector(w, h);
+            detector.Update(a.data(), w * 4, level);
+            detector.Update(b.data(), w * 4, level);
+            if (reference.empty())
+                reference = detector.DirtyTiles();
+            CHECK_MSG(detector.DirtyTiles() == reference, "%s", SimdLevelName(level));
+        }
+    }
+}
+
+int main()
+{
+    RandomFrames();
+    TiersAgree();
+    return Test::CheckResult();
+}
@@ -0,0 +1,59 @@
+// =============================================================================
+// Check.h  --  Minimal assertion helpers for the unit tests
+// =============================================================================
+// Each test is a plain executable.  CHECK() records a failure (expression,
+// file, line) and carries on, so one run reports every broken case; main()
+// ends with 'return CheckResult();', which ctest reads as pass / fail.
+// CHECK_MSG() adds printf-style context (sizes, SIMD tier, ...).
+//
+// No framework dependency: the tests build wherever the portable modules do.
+// =============================================================================
+
+#pragma once
+
+#include <cstdarg>
+#include <cstdio>
+
+namespace VirtuaCam::Test {
+
+// Failures after this many are counted but not printed.
+constexpr int kMaxPrintedFailures = 20;
+
+inline int& FailureCount()
+{
+    static int count = 0;
+    return count;
+}
+
+inline bool Check(bool ok, const char* expression, const char* file, int line, const char* format = nullptr, ...)
+{
+    if (ok)
+        return true;
+    if (++FailureCount() <= kMaxPrintedFailures)
+    {
+        std::fprintf(stderr, "%s:%d: CHECK(%s) failed", file, line, expression);
+        if (format)
+        {
+            std::fputs(": ", stderr);
+            va_list args;
+            va_start(args, format);
+            std::vfprintf(stderr, format, args);
+            va_end(args);
+        }
+        std::fputc('\n', stderr);
+    }
+    return false;
+}
+
+// Exit code for main(): 0 if every check passed.
+inline int CheckResult()
+{
+    if (FailureCount())
+        std::fprintf(stderr, "%d check(s) failed\n", FailureCount());
+    return FailureCount() ? 1 : 0;
+}
+
+}
+
+#define CHECK(expression) ::VirtuaCam::Test::Check(!!(expression), #expression, __FILE__, __LINE__)
+#define CHECK_MSG(expression, ...) ::VirtuaCam::Test::Check(!!(expression), #expression, __FILE__, __LINE__, __VA_ARGS__)
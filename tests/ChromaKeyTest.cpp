@@ -0,0 +1,252 @@
+// =============================================================================
+// ChromaKeyTest.cpp  --  Chroma-key matte and spill suppression
+// =============================================================================
+// Golden images: a synthetic green-screen shot (unevenly lit screen, a
+// skin-toned subject with a soft, green-tinged edge) and a sweep over the
+// whole Cb / Cr plane are keyed and compared with a double-precision
+// rendering of the formulas in ChromaKey.h (exact chroma, square root,
+// smoothstep and unit key direction).  Every SIMD tier and the parallel /
+// in-place paths must equal scalar for random keys and frames, and the
+// screen must come out fully transparent and the subject fully opaque.
+// =============================================================================
+
+#include "Check.h"
+#include "ChromaKey.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    const SimdLevel kLevels[] = { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512 };
+
+    double Cb(double r, double g, double b) { return -0.168736 * r - 0.331264 * g + 0.5 * b; }
+    double Cr(double r, double g, double b) { return 0.5 * r - 0.418688 * g - 0.081312 * b; }
+
+    // The documented formulas in doubles.  The kernels truncate chroma to
+    // integers and read the matte per squared-distance bucket, which moves
+    // the distance by up to kDistanceSlack: the alpha must lie between the
+    // doubles' alpha at d - slack and d + slack, and each colour channel must
+    // match the spill-corrected colour times the alpha actually produced.
+    constexpr double kDistanceSlack = 4.0;
+    constexpr int kColourSlack = 5;
+
+    struct Golden
+    {
+        double minAlpha, maxAlpha;
+        double b, g, r;
+    };
+
+    std::vector<Golden> Reference(const std::vector<uint8_t>& src, const ChromaKeyParams& p)
+    {
+        const double keyCb = Cb(p.keyR, p.keyG, p.keyB), keyCr = Cr(p.keyR, p.keyG, p.keyB);
+        const double length = std::hypot(keyCb, keyCr);
+        const double dirCb = length > 0 ? keyCb / length : 0, dirCr = length > 0 ? keyCr / length : 0;
+        const double tolerance = p.tolerance * 255.0, softness = p.softness * 255.0;
+        auto matte = [&](double d)
+        {
+            double t = softness > 0 ? std::clamp((d - tolerance) / softness, 0.0, 1.0) : (d > tolerance ? 1.0 : 0.0);
+            return t * t * (3.0 - 2.0 * t);
+        };
+
+        std::vector<Golden> out(src.size() / 4);
+        for (size_t i = 0; i < out.size(); ++i)
+        {
+            const uint8_t* px = &src[i * 4];
+            const double b = px[0], g = px[1], r = px[2];
+            const double cb = Cb(r, g, b), cr = Cr(r, g, b);
+            const double d = std::hypot(cb - keyCb, cr - keyCr);
+
+            const double s = std::max(cb * dirCb + cr * dirCr, 0.0) * p.spill;
+            const double sCb = -s * dirCb, sCr = -s * dirCr;
+            out[i].r = std::clamp(r + 1.402 * sCr, 0.0, 255.0);
+            out[i].g = std::clamp(g - 0.344136 * sCb - 0.714136 * sCr, 0.0, 255.0);
+            out[i].b = std::clamp(b + 1.772 * sCb, 0.0, 255.0);
+            out[i].minAlpha = matte(d - kDistanceSlack) * px[3];
+            out[i].maxAlpha = matte(d + kDistanceSlack) * px[3];
+        }
+        return out;
+    }
+
+    std::vector<uint8_t> Key(const ChromaKey& key, const std::vector<uint8_t>& src, uint32_t w, uint32_t h,
+                             SimdLevel level = GetSimdLevel())
+    {
+        std::vector<uint8_t> out(src.size());
+        key.Apply(src.data(), w * 4, out.data(), w * 4, w, h, level);
+        return out;
+    }
+
+    void Put(std::vector<uint8_t>& image, size_t i, double r, double g, double b, uint8_t a = 255)
+    {
+        image[i * 4] = (uint8_t)std::clamp(std::lround(b), 0l, 255l);
+        image[i * 4 + 1] = (uint8_t)std::clamp(std::lround(g), 0l, 255l);
+        image[i * 4 + 2] = (uint8_t)std::clamp(std::lround(r), 0l, 255l);
+        image[i * 4 + 3] = a;
+    }
+
+    // 320 x 240: the default key green lit from 85 % to 115 % across the
+    // frame, a skin-toned disc in the middle whose outer 12 pixels blend
+    // into the screen, and a semi-transparent strip across the middle.
+    std::vector<uint8_t> GreenScreen(uint32_t w, uint32_t h)
+    {
+        std::vector<uint8_t> image((size_t)w * h * 4);
+        for (uint32_t y = 0; y < h; ++y)
+            for (uint32_t x = 0; x < w; ++x)
+            {
+                const double light = 0.85 + 0.3 * x / (w - 1);
+                const double d = std::hypot(x - w / 2.0, y - h / 2.0);
+                const double subject = std::clamp((80.0 - d) / 12.0, 0.0, 1.0);
+                const double r = subject * 224;
+                const double g = (1 - subject) * 177 * light + subject * 172;
+                const double b = (1 - subject) * 64 * light + subject * 150;
+                Put(image, (size_t)y * w + x, r, g, b, y >= h / 2 + 20 && y < h / 2 + 28 ? 128 : 255);
+            }
+        return image;
+    }
+
+    // Every (Cb, Cr) at three luma levels, inside the RGB cube.
+    std::vector<uint8_t> ChromaSweep(uint32_t& w, uint32_t& h)
+    {
+        w = 64;
+        h = 64 * 3;
+        std::vector<uint8_t> image((size_t)w * h * 4);
+        for (uint32_t level = 0; level < 3; ++level)
+            for (uint32_t j = 0; j < 64; ++j)
+                for (uint32_t i = 0; i < 64; ++i)
+                {
+                    const double y = 70.0 + 55.0 * level, cb = (i - 31.5) * 3.0, cr = (j - 31.5) * 3.0;
+                    Put(image, (size_t)(level * 64 + j) * w + i, y + 1.402 * cr, y - 0.344136 * cb - 0.714136 * cr,
+                        y + 1.772 * cb);
+                }
+        return image;
+    }
+
+    void CompareGolden(const char* name, const std::vector<uint8_t>& src, uint32_t w, uint32_t h,
+                       const ChromaKeyParams& params)
+    {
+        ChromaKey key;
+        key.Configure(params);
+        const std::vector<uint8_t> out = Key(key, src, w, h);
+        const std::vector<Golden> ref = Reference(src, params);
+        int failures = 0;
+        for (size_t i = 0; i < ref.size() && failures < 4; ++i)
+        {
+            const uint8_t* px = &out[i * 4];
+            const double a = px[3];
+            const bool alphaOk = a >= std::floor(ref[i].minAlpha) - 1 && a <= std::ceil(ref[i].maxAlpha) + 1;
+            const bool colourOk = std::abs(px[0] - ref[i].b * a / 255) <= kColourSlack &&
+                                  std::abs(px[1] - ref[i].g * a / 255) <= kColourSlack &&
+                                  std::abs(px[2] - ref[i].r * a / 255) <= kColourSlack;
+            failures += !CHECK_MSG(alphaOk && colourOk,
+                                   "%s: pixel (%zu, %zu) = %d %d %d %d, expected alpha %.1f .. %.1f, colour %.1f %.1f %.1f",
+                                   name, i % w, i / w, px[0], px[1], px[2], px[3], ref[i].minAlpha, ref[i].maxAlpha,
+                                   ref[i].b, ref[i].g, ref[i].r);
+        }
+    }
+
+    void Golden()
+    {
+        const uint32_t w = 320, h = 240;
+        const std::vector<uint8_t> screen = GreenScreen(w, h);
+        ChromaKeyParams params;
+        CompareGolden("green screen", screen, w, h, params);
+
+        ChromaKey key;
+        key.Configure(params);
+        const std::vector<uint8_t> out = Key(key, screen, w, h);
+        auto alpha = [&](uint32_t x, uint32_t y) { return out[((size_t)y * w + x) * 4 + 3]; };
+        CHECK(alpha(5, 5) == 0 && alpha(w - 5, 5) == 0 && alpha(5, h / 2) == 0);    // whole screen, dim and bright
+        CHECK(alpha(w / 2, h / 2) == 255 && alpha(w / 2, h / 2 + 24) == 128);            // subject; source alpha kept
+        // Spill: the green-tinged edge loses green relative to red.
+        const size_t edge = ((size_t)(h / 2) * w + w / 2 + 74) * 4;
+        CHECK_MSG(alpha(w / 2 + 74, h / 2) > 0 && out[edge + 1] * screen[edge + 2] < screen[edge + 1] * out[edge + 2],
+                  "edge %d %d %d -> %d %d %d", screen[edge + 2], screen[edge + 1], screen[edge], out[edge + 2],
+                  out[edge + 1], out[edge]);
+
+        uint32_t sw, sh;
+        const std::vector<uint8_t> sweep = ChromaSweep(sw, sh);
+        CompareGolden("chroma sweep", sweep, sw, sh, params);
+        ChromaKeyParams blue;
+        blue.keyR = 30;
+        blue.keyG = 60;
+        blue.keyB = 200;
+        blue.tolerance = 0.2f;
+        blue.softness = 0.15f;
+        blue.spill = 1.0f;
+        CompareGolden("chroma sweep, blue key", sweep, sw, sh, blue);
+        blue.softness = 0.0f;
+        blue.spill = 0.0f;
+        CompareGolden("chroma sweep, hard blue key", sweep, sw, sh, blue);
+    }
+
+    void TiersAgree()
+    {
+        std::mt19937 rng(7);
+        WorkerPool pool(4);
+        for (int trial = 0; trial < 60; ++trial)
+        {
+            ChromaKeyParams params;
+            params.keyR = (uint8_t)rng();
+            params.keyG = (uint8_t)rng();
+            params.keyB = (uint8_t)rng();
+            params.tolerance = (rng() % 40) / 100.0f;
+            params.softness = (rng() % 30) / 100.0f;
+            params.spill = (rng() % 101) / 100.0f;
+            ChromaKey key;
+            key.Configure(params);
+
+            const uint32_t w = 1 + rng() % 97, h = 1 + rng() % 9;
+            std::vector<uint8_t> src((size_t)w * h * 4);
+            for (auto& v : src)
+                v = (uint8_t)rng();
+            const std::vector<uint8_t> ref = Key(key, src, w, h, SimdLevel::Scalar);
+            for (SimdLevel level : kLevels)
+                CHECK_MSG(Key(key, src, w, h, level) == ref, "%ux%u %s", w, h, SimdLevelName(level));
+            std::vector<uint8_t> inPlace = src;
+            key.ApplyParallel(inPlace.data(), w * 4, inPlace.data(), w * 4, w, h, pool);
+            CHECK_MSG(inPlace == ref, "%ux%u parallel, in place", w, h);
+        }
+    }
+
+    void Parameters()
+    {
+        ChromaKey key;
+        CHECK(!key.IsConfigured());
+        ChromaKeyParams params;
+        key.Configure(params);
+        CHECK(key.IsConfigured() && key.Params() == params);
+
+        // Far from the key with no spill: opaque and untouched.
+        params.spill = 0.0f;
+        key.Configure(params);
+        const std::vector<uint8_t> far = { 50, 100, 200, 255 };
+        CHECK(Key(key, far, 1, 1) == far);
+
+        const ChromaKeyShaderConstants c = key.ShaderConstants();
+        CHECK(std::fabs(c.keyCb - Cb(0, 177, 64) / 255.0) < 0.01 && std::fabs(c.keyCr - Cr(0, 177, 64) / 255.0) < 0.01);
+        CHECK(std::fabs(std::hypot(c.directionCb, c.directionCr) - 1.0) < 0.01);
+        CHECK(c.tolerance == params.tolerance && c.softness == params.softness && c.spill == 0.0f);
+
+        // A grey key has no direction: spill does nothing.
+        ChromaKeyParams grey;
+        grey.keyR = grey.keyG = grey.keyB = 128;
+        grey.spill = 1.0f;
+        grey.tolerance = 0.0f;
+        grey.softness = 0.0f;
+        key.Configure(grey);
+        const std::vector<uint8_t> green = { 40, 220, 40, 255 };
+        CHECK(Key(key, green, 1, 1) == green);
+    }
+}
+
+int main()
+{
+    Golden();
+    TiersAgree();
+    Parameters();
+    return Test::CheckResult();
+}
@@ -0,0 +1,42 @@
+// =============================================================================
+// ColorConvertBench.cpp  --  BGRA -> NV12 throughput per SIMD tier
+// =============================================================================
+// Single-threaded, so the numbers compare kernels rather than core counts
+// (WorkerPoolBench covers the parallel variants).
+// =============================================================================
+
+#include "Bench.h"
+#include "ColorConvert.h"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+int main(int argc, char** argv)
+{
+    const bool quick = Test::QuickMode(argc, argv);
+    const int iterations = quick ? 2 : 100;
+    struct Size { const char* name; uint32_t width, height; };
+    const Size sizes[] = { { "720p", 1280, 720 }, { "1080p", 1920, 1080 }, { "4K", 3840, 2160 } };
+
+    std::printf("detected %s\n", SimdLevelName(GetSimdLevel()));
+    std::mt19937 rng(1);
+    for (const Size& size : sizes)
+    {
+        const uint32_t w = size.width, h = size.height;
+        std::vector<uint8_t> in((size_t)w * h * 4), out((size_t)w * h * 3 / 2);
+        for (auto& b : in)
+            b = (uint8_t)rng();
+        for (int l = 0; l <= (int)GetSimdLevel(); ++l)
+        {
+            const SimdLevel level = (SimdLevel)l;
+            const double ms = Test::TimeMs(iterations, [&] {
+                ConvertBGRAToNV12(in.data(), w * 4, w, h, out.data(), w, out.data() + (size_t)w * h, w, {}, level);
+            });
+            std::printf("%-6s %-7s %8.3f ms/frame %8.1f Mpixel/s\n", size.name, SimdLevelName(level), ms,
+                        w * h / ms / 1000.0);
+        }
+    }
+    return 0;
+}
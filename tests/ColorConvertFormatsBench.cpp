@@ -0,0 +1,39 @@
+// =============================================================================
+// ColorConvertFormatsBench.cpp  --  BGRA -> NV12 / YUY2 / I420 / P010 per tier
+// =============================================================================
+
+#include "Bench.h"
+#include "ColorConvert.h"
+#include <cstdio>
+#include <vector>
+
+using namespace VirtuaCam;
+
+int main(int argc, char** argv)
+{
+    const int iterations = Test::QuickMode(argc, argv) ? 2 : 50;
+    const uint32_t w = 1920, h = 1080;
+    std::vector<uint8_t> src((size_t)w * h * 4, 99), dst((size_t)w * h * 4);
+    uint8_t* d = dst.data();
+    uint16_t* d16 = reinterpret_cast<uint16_t*>(d);
+
+    std::printf("1080p, ms/frame  NV12     YUY2     I420     P010\n");
+    for (int l = 0; l <= (int)GetSimdLevel(); ++l)
+    {
+        const SimdLevel level = (SimdLevel)l;
+        const double nv12 = Test::TimeMs(iterations, [&] {
+            ConvertBGRAToNV12(src.data(), w * 4, w, h, d, w, d + w * h, w, {}, level);
+        });
+        const double yuy2 = Test::TimeMs(iterations, [&] {
+            ConvertBGRAToYUY2(src.data(), w * 4, w, h, d, w * 2, {}, level);
+        });
+        const double i420 = Test::TimeMs(iterations, [&] {
+            ConvertBGRAToI420(src.data(), w * 4, w, h, d, w, d + w * h, w / 2, d + w * h * 5 / 4, w / 2, {}, level);
+        });
+        const double p010 = Test::TimeMs(iterations, [&] {
+            ConvertBGRAToP010(src.data(), w * 4, w, h, d16, w * 2, d16 + w * h, w * 2, {}, level);
+        });
+        std::printf("%-16s %8.3f %8.3f %8.3f %8.3f\n", SimdLevelName(level), nv12, yuy2, i420, p010);
+    }
+    return 0;
+}
@@ -0,0 +1,185 @@
+// =============================================================================
+// ColorConvertFormatsTest.cpp  --  BGRA -> YUY2 / I420 / P010
+// =============================================================================
+// Per format and colorimetry: every SIMD tier and the *Parallel variant match
+// the scalar kernel, and the samples agree with the NV12 kernel they are
+// siblings of (same luma; I420 holds NV12's chroma de-interleaved; YUY2's
+// chroma on odd rows is NV12's, which is taken from the bottom row of each
+// pair).  P010 luma is within 1 of the 10-bit floating-point definition and
+// the low 6 bits of every sample are zero.
+// =============================================================================
+
+#include "Check.h"
+#include "ColorConvert.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    const SimdLevel kLevels[] = { SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512 };
+
+    struct Image {
+        uint32_t w, h;
+        ptrdiff_t stride;
+        std::vector<uint8_t> bgra;
+    };
+
+    // NV12 reference with tight strides: 'pairs' chroma pairs per row.
+    struct Nv12 {
+        uint32_t pairs, chromaRows;
+        std::vector<uint8_t> y, uv;
+    };
+
+    Nv12 ToNv12(const Image& image, YuvColorimetry c)
+    {
+        Nv12 nv12 = { (image.w + 1) / 2, (image.h + 1) / 2, {}, {} };
+        const ptrdiff_t stride = nv12.pairs * 2;
+        nv12.y.resize(stride * image.h);
+        nv12.uv.resize(stride * nv12.chromaRows);
+        ConvertBGRAToNV12(image.bgra.data(), image.stride, image.w, image.h, nv12.y.data(), stride, nv12.uv.data(), stride,
+                          c, SimdLevel::Scalar);
+        return nv12;
+    }
+
+    void Yuy2(const Image& image, const Nv12& nv12, YuvColorimetry c, WorkerPool& pool)
+    {
+        const ptrdiff_t stride = nv12.pairs * 4, nvStride = nv12.pairs * 2;
+        std::vector<uint8_t> reference(stride * image.h);
+        ConvertBGRAToYUY2(image.bgra.data(), image.stride, image.w, image.h, reference.data(), stride, c, SimdLevel::Scalar);
+        for (SimdLevel level : kLevels)
+        {
+            std::vector<uint8_t> out(reference.size());
+            ConvertBGRAToYUY2(image.bgra.data(), image.stride, image.w, image.h, out.data(), stride, c, level);
+            CHECK_MSG(out == reference, "YUY2 %ux%u %s", image.w, image.h, SimdLevelName(level));
+        }
+        std::vector<uint8_t> parallel(reference.size());
+        ConvertBGRAToYUY2Parallel(image.bgra.data(), image.stride, image.w, image.h, parallel.data(), stride, c, pool);
+        CHECK_MSG(parallel == reference, "YUY2 parallel %ux%u", image.w, image.h);
+
+        bool lumaMatches = true, chromaMatches = true;
+        for (uint32_t y = 0; y < image.h; ++y)
+            for (uint32_t x = 0; x < image.w; ++x)
+                lumaMatches &= reference[y * stride + x * 2] == nv12.y[y * nvStride + x];
+        for (uint32_t y = 1; y < image.h; y += 2)
+            for (uint32_t p = 0; p < nv12.pairs; ++p)
+                chromaMatches &= reference[y * stride + p * 4 + 1] == nv12.uv[(y / 2) * nvStride + p * 2] &&
+                                 reference[y * stride + p * 4 + 3] == nv12.uv[(y / 2) * nvStride + p * 2 + 1];
+        CHECK_MSG(lumaMatches && chromaMatches, "YUY2 vs NV12 %ux%u", image.w, image.h);
+    }
+
+    void I420(const Image& image, const Nv12& nv12, YuvColorimetry c, WorkerPool& pool)
+    {
+        const ptrdiff_t yStride = image.w + 3, cStride = nv12.pairs + 1, nvStride = nv12.pairs * 2;
+        auto convert = [&](SimdLevel level, bool parallel, std::vector<uint8_t>& y, std::vector<uint8_t>& u,
+                           std::vector<uint8_t>& v) {
+            y.assign(yStride * image.h, 0);
+            u.assign(cStride * nv12.chromaRows, 0);
+            v.assign(cStride * nv12.chromaRows, 0);
+            if (parallel)
+                ConvertBGRAToI420Parallel(image.bgra.data(), image.stride, image.w, image.h, y.data(), yStride, u.data(),
+                                          cStride, v.data(), cStride, c, pool);
+            else
+                ConvertBGRAToI420(image.bgra.data(), image.stride, image.w, image.h, y.data(), yStride, u.data(), cStride,
+                                  v.data(), cStride, c, level);
+        };
+
+        std::vector<uint8_t> refY, refU, refV;
+        convert(SimdLevel::Scalar, false, refY, refU, refV);
+        bool matches = true;
+        for (uint32_t y = 0; y < image.h; ++y)
+            for (uint32_t x = 0; x < image.w; ++x)
+                matches &= refY[y * yStride + x] == nv12.y[y * nvStride + x];
+        for (uint32_t y = 0; y < nv12.chromaRows; ++y)
+            for (uint32_t p = 0; p < nv12.pairs; ++p)
+                matches &= refU[y * cStride + p] == nv12.uv[y * nvStride + p * 2] &&
+                           refV[y * cStride + p] == nv12.uv[y * nvStride + p * 2 + 1];
+        CHECK_MSG(matches, "I420 vs NV12 %ux%u", image.w, image.h);
+
+        for (SimdLevel level : kLevels)
+        {
+            std::vector<uint8_t> y, u, v;
+            convert(level, false, y, u, v);
+            CHECK_MSG(y == refY && u == refU && v == refV, "I420 %ux%u %s", image.w, image.h, SimdLevelName(level));
+        }
+        std::vector<uint8_t> y, u, v;
+        convert(SimdLevel::Scalar, true, y, u, v);
+        CHECK_MSG(y == refY && u == refU && v == refV, "I420 parallel %ux%u", image.w, image.h);
+    }
+
+    void P010(const Image& image, const Nv12& nv12, YuvColorimetry c, WorkerPool& pool)
+    {
+        const ptrdiff_t stride = nv12.pairs * 4, samples = stride / 2;
+        std::vector<uint16_t> reference(samples * (image.h + nv12.chromaRows));
+        uint16_t* refUV = reference.data() + samples * image.h;
+        ConvertBGRAToP010(image.bgra.data(), image.stride, image.w, image.h, reference.data(), stride, refUV, stride, c,
+                          SimdLevel::Scalar);
+        for (SimdLevel level : kLevels)
+        {
+            std::vector<uint16_t> out(reference.size());
+            ConvertBGRAToP010(image.bgra.data(), image.stride, image.w, image.h, out.data(), stride,
+                              out.data() + samples * image.h, stride, c, level);
+            CHECK_MSG(out == reference, "P010 %ux%u %s", image.w, image.h, SimdLevelName(level));
+        }
+        std::vector<uint16_t> parallel(reference.size());
+        ConvertBGRAToP010Parallel(image.bgra.data(), image.stride, image.w, image.h, parallel.data(), stride,
+                                  parallel.data() + samples * image.h, stride, c, pool);
+        CHECK_MSG(parallel == reference, "P010 parallel %ux%u", image.w, image.h);
+
+        const double kr[] = { 0.299, 0.2126, 0.2627 }, kb[] = { 0.114, 0.0722, 0.0593 };
+        const double k0 = kr[(int)c.matrix], k2 = kb[(int)c.matrix];
+        const bool limited = c.range == YuvRange::Limited;
+        int worst = 0;
+        bool lowBitsClear = true;
+        for (uint32_t y = 0; y < image.h; ++y)
+        {
+            for (uint32_t x = 0; x < image.w; ++x)
+            {
+                const uint8_t* p = &image.bgra[y * image.stride + x * 4];
+                const double expected = (limited ? 64 : 0) + (limited ? 876.0 : 1023.0) / 255.0 *
+                                        (k0 * p[2] + (1 - k0 - k2) * p[1] + k2 * p[0]);
+                const uint16_t v = reference[y * samples + x];
+                lowBitsClear &= (v & 63) == 0;
+                worst = std::max(worst, (int)std::abs(std::lround(expected) - (v >> 6)));
+            }
+        }
+        for (size_t i = 0; i < (size_t)samples * nv12.chromaRows; ++i)
+            lowBitsClear &= (refUV[i] & 63) == 0;
+        CHECK_MSG(worst <= 1 && lowBitsClear, "P010 %ux%u luma off by %d", image.w, image.h, worst);
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(5);
+    WorkerPool pool(4);
+    for (int m = 0; m < 3; ++m)
+    {
+        for (int r = 0; r < 2; ++r)
+        {
+            const YuvColorimetry c = { (YuvMatrix)m, (YuvRange)r };
+            for (int iteration = 0; iteration < 30; ++iteration)
+            {
+                Image image;
+                image.w = 1 + rng() % 300;
+                image.h = 1 + rng() % 90;
+                image.stride = image.w * 4 + (rng() % 2) * 8;
+                image.bgra.resize(image.stride * image.h);
+                for (auto& b : image.bgra)
+                    b = (uint8_t)rng();
+                if (iteration == 0)
+                    std::fill(image.bgra.begin(), image.bgra.end(), 255);
+
+                const Nv12 nv12 = ToNv12(image, c);
+                Yuy2(image, nv12, c, pool);
+                I420(image, nv12, c, pool);
+                P010(image, nv12, c, pool);
+            }
+        }
+    }
+    return Test::CheckResult();
+}
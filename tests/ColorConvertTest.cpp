@@ -0,0 +1,135 @@
+// =============================================================================
+// ColorConvertTest.cpp  --  BGRA -> NV12 against the legacy scalar converter
+// =============================================================================
+// LegacyRGB32ToNV12 is the converter Tools.cpp shipped before the SIMD
+// kernels (BT.601 limited range, even sizes only).  Every SIMD tier must
+// match it bit for bit on even sizes, and match the scalar kernel on any size,
+// stride (padded, unaligned, negative) and plane placement.
+// =============================================================================
+
+#include "Check.h"
+#include "ColorConvert.h"
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    const SimdLevel kLevels[] = { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512 };
+
+    void LegacyRGB24ToYUV(int r, int g, int b, uint8_t* y, uint8_t* u, uint8_t* v)
+    {
+        *y = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        *u = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        *v = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+
+    void LegacyRGB24ToY(int r, int g, int b, uint8_t* y)
+    {
+        *y = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+    }
+
+    // Y plane of 'height' rows followed by the UV plane, one stride for both.
+    void LegacyRGB32ToNV12(const uint8_t* input, ptrdiff_t inputStride, uint32_t width, uint32_t height,
+                           uint8_t* output, ptrdiff_t outputStride)
+    {
+        for (uint32_t h = 0; h < height - 1; h += 2)
+        {
+            const uint8_t* rgb1 = input + h * inputStride;
+            const uint8_t* rgb2 = input + (h + 1) * inputStride;
+            uint8_t* y1 = output + h * outputStride;
+            uint8_t* y2 = output + (h + 1) * outputStride;
+            uint8_t* uv = output + (h / 2 + height) * outputStride;
+            for (uint32_t w = 0; w < width; w += 2)
+            {
+                LegacyRGB24ToYUV(rgb1[2], rgb1[1], rgb1[0], y1, uv, uv + 1);
+                LegacyRGB24ToY(rgb1[6], rgb1[5], rgb1[4], y1 + 1);
+                LegacyRGB24ToYUV(rgb2[2], rgb2[1], rgb2[0], y2, uv, uv + 1);
+                LegacyRGB24ToY(rgb2[6], rgb2[5], rgb2[4], y2 + 1);
+                rgb1 += 8; rgb2 += 8; y1 += 2; y2 += 2; uv += 2;
+            }
+        }
+    }
+
+    void RandomSizes()
+    {
+        std::mt19937 rng(1);
+        for (int iteration = 0; iteration < 400; ++iteration)
+        {
+            uint32_t width = 1 + rng() % 300, height = 1 + rng() % 40;
+            const bool even = iteration % 2 == 0;
+            if (even)
+            {
+                width = (width + 1) & ~1u;
+                height = (height + 1) & ~1u;
+            }
+            const ptrdiff_t inStride = width * 4 + (rng() % 3) * 4 + (rng() % 2 ? 0 : 3);
+            const ptrdiff_t outStride = ((width + 1) & ~1u) + rng() % 17;
+            std::vector<uint8_t> in(inStride * height + 64);
+            for (auto& b : in)
+                b = (uint8_t)rng();
+
+            const size_t outSize = outStride * (height + (height + 1) / 2) + 64;
+            std::vector<uint8_t> reference(outSize, 0xCD);
+            if (even)
+                LegacyRGB32ToNV12(in.data(), inStride, width, height, reference.data(), outStride);
+            else
+                ConvertBGRAToNV12(in.data(), inStride, width, height, reference.data(), outStride,
+                                  reference.data() + height * outStride, outStride, {}, SimdLevel::Scalar);
+
+            for (SimdLevel level : kLevels)
+            {
+                std::vector<uint8_t> out(outSize, 0xCD);
+                ConvertBGRAToNV12(in.data(), inStride, width, height, out.data(), outStride,
+                                  out.data() + height * outStride, outStride, {}, level);
+                CHECK_MSG(out == reference, "%ux%u strides %td/%td %s", width, height, inStride, outStride,
+                          SimdLevelName(level));
+            }
+        }
+    }
+
+    // Bottom-up source and separate, differently strided Y and UV planes.
+    void NegativeStride()
+    {
+        std::mt19937 rng(2);
+        const uint32_t width = 101, height = 7;
+        const ptrdiff_t inStride = width * 4;
+        std::vector<uint8_t> in(inStride * height);
+        for (auto& b : in)
+            b = (uint8_t)rng();
+        const uint8_t* bottomUp = in.data() + inStride * (height - 1);
+
+        std::vector<uint8_t> refY(110 * height), refUV(120 * 4);
+        ConvertBGRAToNV12(bottomUp, -inStride, width, height, refY.data(), 110, refUV.data(), 120, {}, SimdLevel::Scalar);
+        for (SimdLevel level : kLevels)
+        {
+            std::vector<uint8_t> y(110 * height), uv(120 * 4);
+            ConvertBGRAToNV12(bottomUp, -inStride, width, height, y.data(), 110, uv.data(), 120, {}, level);
+            CHECK_MSG(y == refY && uv == refUV, "%s", SimdLevelName(level));
+        }
+    }
+
+    // Odd sizes take the last column / row into the final chroma sample.
+    void OddEdges()
+    {
+        const uint32_t width = 3, height = 3;
+        std::vector<uint8_t> in(width * height * 4, 0);
+        for (uint32_t y = 0; y < height; ++y)
+            for (uint32_t x = 0; x < width; ++x)
+                in[(y * width + x) * 4 + 2] = (x == 2 || y == 2) ? 255 : 0;     // red right column / bottom row
+        std::vector<uint8_t> y(4 * height), uv(4 * 2);
+        ConvertBGRAToNV12(in.data(), width * 4, width, height, y.data(), 4, uv.data(), 4);
+        CHECK(y[0] == 16 && y[2] == 82 && y[2 * 4] == 82);
+        CHECK(uv[0] == 128 && uv[1] == 128);                    // top-left block: black
+        CHECK(uv[2] != 128 && uv[4 + 3] > 128);                 // edge blocks: red
+    }
+}
+
+int main()
+{
+    RandomSizes();
+    NegativeStride();
+    OddEdges();
+    return Test::CheckResult();
+}
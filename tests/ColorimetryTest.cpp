@@ -0,0 +1,140 @@
+// =============================================================================
+// ColorimetryTest.cpp  --  BT.601 / 709 / 2020, limited and full range
+// =============================================================================
+// For every (matrix, range): the SIMD tiers match the scalar kernel, luma and
+// chroma are within 1 of the floating-point definition in Colorimetry.h, and
+// greys have exactly neutral chroma.
+// =============================================================================
+
+#include "Check.h"
+#include "ColorConvert.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    const SimdLevel kLevels[] = { SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512 };
+    const double kKr[] = { 0.299, 0.2126, 0.2627 };
+    const double kKb[] = { 0.114, 0.0722, 0.0593 };
+
+    struct Yuv { double y, cb, cr; };
+
+    Yuv Reference(YuvColorimetry c, int r, int g, int b)
+    {
+        const double kr = kKr[(int)c.matrix], kb = kKb[(int)c.matrix];
+        const bool limited = c.range == YuvRange::Limited;
+        const double luma = kr * r + (1 - kr - kb) * g + kb * b;
+        const double lumaScale = (limited ? 219.0 : 255.0) / 255.0, chromaScale = (limited ? 224.0 : 255.0) / 255.0;
+        return { (limited ? 16 : 0) + lumaScale * luma,
+                 128 + chromaScale * (b - luma) / (2 * (1 - kb)),
+                 128 + chromaScale * (r - luma) / (2 * (1 - kr)) };
+    }
+
+    bool Near(double expected, int actual)
+    {
+        return std::abs((long)std::lround(std::fmin(std::fmax(expected, 0.0), 255.0)) - actual) <= 1;
+    }
+
+    void RandomImages(YuvColorimetry c, std::mt19937& rng)
+    {
+        for (int iteration = 0; iteration < 40; ++iteration)
+        {
+            const uint32_t w = 1 + rng() % 300, h = 1 + rng() % 60;
+            const ptrdiff_t srcStride = w * 4, dstStride = w + (w & 1);
+            std::vector<uint8_t> src(srcStride * h);
+            for (auto& b : src)
+                b = (uint8_t)rng();
+            const size_t chromaRows = (h + 1) / 2;
+            std::vector<uint8_t> reference(dstStride * (h + chromaRows));
+            ConvertBGRAToNV12(src.data(), srcStride, w, h, reference.data(), dstStride, reference.data() + dstStride * h,
+                              dstStride, c, SimdLevel::Scalar);
+            for (SimdLevel level : kLevels)
+            {
+                std::vector<uint8_t> out(reference.size());
+                ConvertBGRAToNV12(src.data(), srcStride, w, h, out.data(), dstStride, out.data() + dstStride * h,
+                                  dstStride, c, level);
+                CHECK_MSG(out == reference, "matrix %d range %d %ux%u %s", (int)c.matrix, (int)c.range, w, h,
+                          SimdLevelName(level));
+            }
+
+            int worst = 0;
+            for (uint32_t y = 0; y < h; ++y)
+            {
+                for (uint32_t x = 0; x < w; ++x)
+                {
+                    const uint8_t* p = &src[y * srcStride + x * 4];
+                    const double expected = Reference(c, p[2], p[1], p[0]).y;
+                    worst = std::max(worst, (int)std::abs(std::lround(expected) - reference[y * dstStride + x]));
+                }
+            }
+            CHECK_MSG(worst <= 1, "matrix %d range %d: luma off by %d", (int)c.matrix, (int)c.range, worst);
+        }
+    }
+
+    // Solid colours, so chroma siting does not matter.
+    void SolidColours(YuvColorimetry c)
+    {
+        const int colours[][3] = { { 0, 0, 0 }, { 255, 255, 255 }, { 128, 128, 128 }, { 255, 0, 0 }, { 0, 255, 0 },
+                                   { 0, 0, 255 }, { 255, 255, 0 }, { 0, 255, 255 }, { 200, 30, 120 } };
+        const uint32_t w = 4, h = 2;
+        for (const auto& rgb : colours)
+        {
+            std::vector<uint8_t> src(w * h * 4);
+            for (size_t i = 0; i < src.size(); i += 4)
+            {
+                src[i] = (uint8_t)rgb[2];
+                src[i + 1] = (uint8_t)rgb[1];
+                src[i + 2] = (uint8_t)rgb[0];
+                src[i + 3] = 255;
+            }
+            uint8_t y[w * h], uv[w];
+            ConvertBGRAToNV12(src.data(), w * 4, w, h, y, w, uv, w, c);
+            const Yuv expected = Reference(c, rgb[0], rgb[1], rgb[2]);
+            CHECK_MSG(Near(expected.y, y[0]) && Near(expected.cb, uv[0]) && Near(expected.cr, uv[1]),
+                      "matrix %d range %d rgb %d,%d,%d -> %d %d %d", (int)c.matrix, (int)c.range, rgb[0], rgb[1],
+                      rgb[2], y[0], uv[0], uv[1]);
+        }
+    }
+
+    void NeutralGreys(YuvColorimetry c)
+    {
+        bool neutral = true;
+        for (int v = 0; v < 256; ++v)
+        {
+            uint8_t src[16], y[4], uv[2];
+            for (int i = 0; i < 16; i += 4)
+            {
+                src[i] = src[i + 1] = src[i + 2] = (uint8_t)v;
+                src[i + 3] = 255;
+            }
+            ConvertBGRAToNV12(src, 8, 2, 2, y, 2, uv, 2, c);
+            neutral &= uv[0] == 128 && uv[1] == 128;
+        }
+        CHECK_MSG(neutral, "matrix %d range %d", (int)c.matrix, (int)c.range);
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(3);
+    for (int m = 0; m < 3; ++m)
+    {
+        for (int r = 0; r < 2; ++r)
+        {
+            const YuvColorimetry c = { (YuvMatrix)m, (YuvRange)r };
+            RandomImages(c, rng);
+            SolidColours(c);
+            NeutralGreys(c);
+        }
+    }
+
+    CHECK(DefaultColorimetry(640, 480).matrix == YuvMatrix::BT601);
+    CHECK(DefaultColorimetry(1280, 720).matrix == YuvMatrix::BT709);
+    CHECK(DefaultColorimetry(3840, 2160).range == YuvRange::Limited);
+    return Test::CheckResult();
+}
@@ -0,0 +1,201 @@
+// =============================================================================
+// DenoiseTest.cpp  --  Motion-adaptive temporal denoise
+// =============================================================================
+// A per-pixel model of the recursive filter in Denoise.h, fed the same frame
+// sequence, must match every kernel bit for bit; the SIMD tiers, the
+// parallel path and in-place operation must equal scalar over several frames
+// with padded strides.  Behaviour: the first frame and the one after Reset()
+// pass through, a change beyond the threshold passes straight through (no
+// smear), and static noise is averaged away.
+// =============================================================================
+
+#include "Check.h"
+#include "Denoise.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    const SimdLevel kLevels[] = { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512 };
+
+    // The filter as documented, one pixel at a time.
+    struct Model
+    {
+        Model(uint32_t pixels, float strength)
+            : history(pixels * 4), maxWeight((int)std::lround(224.0f * strength)),
+              threshold((int)std::lround(8.0f + 24.0f * strength)),
+              slope((maxWeight * 16 + threshold / 2) / threshold)
+        {
+        }
+
+        void Apply(const std::vector<uint8_t>& src, std::vector<uint8_t>& dst)
+        {
+            dst.resize(src.size());
+            for (size_t i = 0; i < src.size(); i += 4)
+            {
+                const uint8_t* c = &src[i];
+                uint8_t* h = &history[i];
+                if (!primed)
+                {
+                    std::memcpy(h, c, 4);
+                }
+                else
+                {
+                    const int diff = (std::abs(c[0] - h[0]) + 2 * std::abs(c[1] - h[1]) + std::abs(c[2] - h[2])) / 4;
+                    const int k = std::max(maxWeight - ((std::min(diff, threshold) * slope + 8) >> 4), 0);
+                    for (int ch = 0; ch < 4; ++ch)
+                        h[ch] = (uint8_t)((c[ch] * (256 - k) + h[ch] * k + 128) >> 8);
+                }
+                std::memcpy(&dst[i], h, 4);
+            }
+            primed = true;
+        }
+
+        std::vector<uint8_t> history;
+        int maxWeight, threshold, slope;
+        bool primed = false;
+    };
+
+    std::vector<uint8_t> Noisy(std::mt19937& rng, size_t bytes, int base, int spread)
+    {
+        std::vector<uint8_t> frame(bytes);
+        for (auto& v : frame)
+            v = (uint8_t)(base + rng() % spread);
+        return frame;
+    }
+
+    void Parameters()
+    {
+        TemporalDenoise denoise;
+        denoise.Configure(64, 8, 1.0f);
+        CHECK(denoise.IsConfigured() && denoise.MaxWeight() == 224 && denoise.Threshold() == 32);
+        denoise.Configure(64, 8, 0.5f);
+        CHECK(denoise.MaxWeight() == 112 && denoise.Threshold() == 20);
+        denoise.Configure(64, 8, 3.0f);
+        CHECK(denoise.MaxWeight() == 224);
+        denoise.Configure(64, 8, 0.0f);
+        CHECK(!denoise.IsConfigured());
+        denoise.Configure(0, 8, 1.0f);
+        CHECK(!denoise.IsConfigured());
+
+        // Unconfigured: Apply does nothing.
+        std::vector<uint8_t> frame(16, 7), out(16, 9);
+        denoise.Apply(frame.data(), 16, out.data(), 16);
+        CHECK(out == std::vector<uint8_t>(16, 9));
+    }
+
+    void MatchesModel()
+    {
+        std::mt19937 rng(20);
+        for (int trial = 0; trial < 30; ++trial)
+        {
+            const uint32_t w = 1 + rng() % 77, h = 1 + rng() % 7;
+            const float strength = (1 + rng() % 100) / 100.0f;
+            const ptrdiff_t srcStride = w * 4 + 8, dstStride = w * 4 + 4;
+
+            Model model((size_t)w * h, strength);
+            TemporalDenoise tiers[4], parallel, inPlace;
+            for (auto& d : tiers)
+                d.Configure(w, h, strength);
+            parallel.Configure(w, h, strength);
+            inPlace.Configure(w, h, strength);
+            WorkerPool pool(3);
+
+            for (int frame = 0; frame < 6; ++frame)
+            {
+                // Mostly noise around a level, with a jump halfway through.
+                const std::vector<uint8_t> pixels = Noisy(rng, (size_t)w * h * 4, frame < 3 ? 100 : 150, 40);
+                std::vector<uint8_t> expected;
+                model.Apply(pixels, expected);
+
+                std::vector<uint8_t> src(srcStride * h);
+                for (uint32_t y = 0; y < h; ++y)
+                    std::memcpy(&src[y * srcStride], &pixels[y * w * 4], w * 4);
+                auto check = [&](const std::vector<uint8_t>& out, ptrdiff_t stride, const char* what) {
+                    bool same = true;
+                    for (uint32_t y = 0; y < h; ++y)
+                        same &= !std::memcmp(&out[y * stride], &expected[y * w * 4], w * 4);
+                    CHECK_MSG(same, "%ux%u strength %.2f frame %d: %s", w, h, strength, frame, what);
+                };
+
+                for (int l = 0; l < 4; ++l)
+                {
+                    std::vector<uint8_t> out(dstStride * h);
+                    tiers[l].Apply(src.data(), srcStride, out.data(), dstStride, kLevels[l]);
+                    check(out, dstStride, SimdLevelName(kLevels[l]));
+                }
+                std::vector<uint8_t> out(dstStride * h);
+                parallel.ApplyParallel(src.data(), srcStride, out.data(), dstStride, pool);
+                check(out, dstStride, "parallel");
+                std::vector<uint8_t> buffer = src;
+                inPlace.Apply(buffer.data(), srcStride, buffer.data(), srcStride);
+                check(buffer, srcStride, "in place");
+            }
+        }
+    }
+
+    void Behaviour()
+    {
+        const uint32_t w = 64, h = 16;
+        const size_t bytes = (size_t)w * h * 4;
+        TemporalDenoise denoise;
+        denoise.Configure(w, h, 1.0f);
+        std::vector<uint8_t> out(bytes);
+
+        // The first frame passes through, and so does the next one after Reset().
+        std::vector<uint8_t> grey(bytes, 100), bright(bytes, 200), dim(bytes, 104);
+        denoise.Apply(grey.data(), w * 4, out.data(), w * 4);
+        CHECK(out == grey);
+
+        // Motion: a change far beyond the threshold is not blended at all.
+        denoise.Apply(bright.data(), w * 4, out.data(), w * 4);
+        CHECK(out == bright);
+
+        denoise.Apply(dim.data(), w * 4, out.data(), w * 4);
+        CHECK(out == dim);
+
+        // A small change is pulled towards the history.
+        denoise.Apply(grey.data(), w * 4, out.data(), w * 4);
+        CHECK_MSG(out[0] > 100 && out[0] < 104, "blended %d", out[0]);
+
+        denoise.Reset();
+        denoise.Apply(bright.data(), w * 4, out.data(), w * 4);
+        CHECK(out == bright);
+
+        // Static noise: after a few frames the output is much closer to the
+        // clean level than the input.
+        std::mt19937 rng(4);
+        std::normal_distribution<double> noise(0.0, 6.0);
+        denoise.Reset();
+        double inError = 0, outError = 0;
+        for (int frame = 0; frame < 30; ++frame)
+        {
+            std::vector<uint8_t> noisy(bytes);
+            for (auto& v : noisy)
+                v = (uint8_t)std::clamp(std::lround(128 + noise(rng)), 0l, 255l);
+            denoise.Apply(noisy.data(), w * 4, out.data(), w * 4);
+            if (frame < 15)
+                continue;
+            for (size_t i = 0; i < bytes; ++i)
+            {
+                inError += (noisy[i] - 128.0) * (noisy[i] - 128.0);
+                outError += (out[i] - 128.0) * (out[i] - 128.0);
+            }
+        }
+        const double gain = 10 * std::log10(inError / std::max(outError, 1.0));
+        CHECK_MSG(gain >= 6.0, "noise reduced by %.1f dB", gain);
+    }
+}
+
+int main()
+{
+    Parameters();
+    MatchesModel();
+    Behaviour();
+    return Test::CheckResult();
+}
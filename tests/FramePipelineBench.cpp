@@ -0,0 +1,142 @@
+// =============================================================================
+// FramePipelineBench.cpp  --  Fused pipeline against chained full-frame passes
+// =============================================================================
+// Typical producer paths: a 4K NV12 camera cropped and scaled to 1080p YUY2,
+// the same bound for BGRA, 1080p YUY2 scaled to 720p NV12, and 1080p BGRA
+// converted to I420.  Each runs as one FramePipeline and as the stand-alone
+// parallel kernels with full intermediate frames between them.
+// =============================================================================
+
+#include "Bench.h"
+#include "ColorConvert.h"
+#include "FramePipeline.h"
+#include "YuvUnpack.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    struct Buffers {
+        std::vector<uint8_t> src, dst, unpacked, scaled;
+    };
+
+    void RunChained(const PipelineDesc& d, Buffers& b)
+    {
+        const uint32_t sw = d.srcWidth, sh = d.srcHeight, w = d.dstWidth, h = d.dstHeight;
+        const uint8_t* bgra = b.src.data();
+        ptrdiff_t bgraStride = (ptrdiff_t)sw * 4;
+        if (d.srcFormat == PixelFormat::NV12)
+            ConvertNV12ToBGRAParallel(b.src.data(), sw, b.src.data() + (size_t)sw * sh, sw, sw, sh, b.unpacked.data(), sw * 4);
+        else if (d.srcFormat == PixelFormat::YUY2)
+            ConvertYUY2ToBGRAParallel(b.src.data(), sw * 2, sw, sh, b.unpacked.data(), sw * 4);
+        if (d.srcFormat != PixelFormat::BGRA)
+            bgra = b.unpacked.data();
+
+        const uint8_t* crop = bgra + (ptrdiff_t)d.cropY * bgraStride + d.cropX * 4;
+        const uint32_t cw = d.cropWidth ? d.cropWidth : sw, ch = d.cropHeight ? d.cropHeight : sh;
+        if (cw != w || ch != h)
+        {
+            Scaler(cw, ch, w, h, d.filter).ScaleParallel(crop, bgraStride, b.scaled.data(), w * 4, 4);
+            crop = b.scaled.data();
+            bgraStride = (ptrdiff_t)w * 4;
+        }
+
+        uint8_t* o = b.dst.data();
+        switch (d.dstFormat)
+        {
+        case PixelFormat::BGRA:
+            if (crop != o)
+                for (uint32_t y = 0; y < h; ++y)
+                    std::copy_n(crop + y * bgraStride, w * 4, o + (size_t)y * w * 4);
+            break;
+        case PixelFormat::NV12: ConvertBGRAToNV12Parallel(crop, bgraStride, w, h, o, w, o + (size_t)w * h, w); break;
+        case PixelFormat::YUY2: ConvertBGRAToYUY2Parallel(crop, bgraStride, w, h, o, w * 2); break;
+        default:
+            ConvertBGRAToI420Parallel(crop, bgraStride, w, h, o, w, o + (size_t)w * h, w / 2, o + (size_t)w * h * 5 / 4, w / 2);
+            break;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int iterations = Test::QuickMode(argc, argv) ? 1 : 30;
+    std::mt19937 rng(12);
+
+    struct Case { const char* name; PipelineDesc desc; };
+    Case cases[4];
+    {
+        PipelineDesc& d = cases[0].desc;
+        cases[0].name = "NV12 4K crop -> 1080p YUY2";
+        d.srcFormat = PixelFormat::NV12;
+        d.srcWidth = 3840; d.srcHeight = 2160;
+        d.cropX = 480; d.cropY = 270; d.cropWidth = 2880; d.cropHeight = 1620;
+        d.dstFormat = PixelFormat::YUY2;
+        d.dstWidth = 1920; d.dstHeight = 1080;
+        cases[1] = cases[0];
+        cases[1].name = "NV12 4K crop -> 1080p BGRA";
+        cases[1].desc.dstFormat = PixelFormat::BGRA;
+    }
+    {
+        PipelineDesc& d = cases[2].desc;
+        cases[2].name = "YUY2 1080p -> 720p NV12";
+        d.srcFormat = PixelFormat::YUY2;
+        d.srcWidth = 1920; d.srcHeight = 1080;
+        d.dstFormat = PixelFormat::NV12;
+        d.dstWidth = 1280; d.dstHeight = 720;
+    }
+    {
+        PipelineDesc& d = cases[3].desc;
+        cases[3].name = "BGRA 1080p -> I420";
+        d.srcFormat = PixelFormat::BGRA;
+        d.srcWidth = 1920; d.srcHeight = 1080;
+        d.dstFormat = PixelFormat::I420;
+        d.dstWidth = 1920; d.dstHeight = 1080;
+    }
+
+    for (const Case& c : cases)
+    {
+        const PipelineDesc& d = c.desc;
+        FramePipeline pipeline;
+        pipeline.Configure(d);
+        const uint32_t sw = d.srcWidth, sh = d.srcHeight, w = d.dstWidth, h = d.dstHeight;
+        Buffers b;
+        b.src.resize((size_t)sw * sh * 4);
+        for (auto& v : b.src)
+            v = (uint8_t)rng();
+        b.dst.resize((size_t)w * h * 4);
+        b.unpacked.resize((size_t)sw * sh * 4);
+        b.scaled.resize((size_t)w * h * 4);
+
+        ImagePlanes src, dst;
+        src.plane[0] = b.src.data();
+        switch (d.srcFormat)
+        {
+        case PixelFormat::NV12: src.stride[0] = src.stride[1] = sw; src.plane[1] = b.src.data() + (size_t)sw * sh; break;
+        case PixelFormat::YUY2: src.stride[0] = (ptrdiff_t)sw * 2; break;
+        default:                src.stride[0] = (ptrdiff_t)sw * 4; break;
+        }
+        dst.plane[0] = b.dst.data();
+        switch (d.dstFormat)
+        {
+        case PixelFormat::NV12: dst.stride[0] = dst.stride[1] = w; dst.plane[1] = b.dst.data() + (size_t)w * h; break;
+        case PixelFormat::YUY2: dst.stride[0] = (ptrdiff_t)w * 2; break;
+        case PixelFormat::I420:
+            dst.stride[0] = w;
+            dst.stride[1] = dst.stride[2] = w / 2;
+            dst.plane[1] = b.dst.data() + (size_t)w * h;
+            dst.plane[2] = b.dst.data() + (size_t)w * h * 5 / 4;
+            break;
+        default:                dst.stride[0] = (ptrdiff_t)w * 4; break;
+        }
+
+        const double fused = Test::TimeMs(iterations, [&] { pipeline.Run(src, dst); });
+        const double chained = Test::TimeMs(iterations, [&] { RunChained(d, b); });
+        std::printf("%-28s fused %8.3f ms  chained %8.3f ms  (%.2fx)\n", c.name, fused, chained, chained / fused);
+    }
+    return 0;
+}
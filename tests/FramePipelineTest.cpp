@@ -0,0 +1,239 @@
+// =============================================================================
+// FramePipelineTest.cpp  --  Fused crop / scale / convert against chained passes
+// =============================================================================
+// For random source / destination formats, sizes, crops, filters and
+// orientations on a random SIMD tier, FramePipeline::Run() must produce the
+// same bytes as running the stand-alone kernels one full frame at a time:
+// unpack -> crop -> scale -> orient / convert.  NV12 sources follow the
+// pipeline's YUV route (NV12Scaler before the unpack when downscaled, never
+// leaving YUV for NV12 -> NV12).  Unsupported descriptions must be refused.
+// =============================================================================
+
+#include "Check.h"
+#include "ColorConvert.h"
+#include "FramePipeline.h"
+#include "YuvUnpack.h"
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    const SimdLevel kLevels[] = { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512 };
+    const PixelFormat kSources[] = { PixelFormat::BGRA, PixelFormat::NV12, PixelFormat::YUY2, PixelFormat::UYVY };
+    const PixelFormat kDestinations[] = { PixelFormat::BGRA, PixelFormat::NV12, PixelFormat::YUY2,
+                                          PixelFormat::I420, PixelFormat::P010 };
+
+    // Planes with padded strides; filled with noise, or zeroed for outputs so
+    // untouched padding compares equal.
+    struct Image {
+        std::vector<uint8_t> bytes[3];
+        ImagePlanes planes;
+
+        Image(PixelFormat format, uint32_t w, uint32_t h, std::mt19937* rng)
+        {
+            const uint32_t cw = (w + 1) / 2, ch = (h + 1) / 2;
+            switch (format)
+            {
+            case PixelFormat::BGRA: Plane(0, w * 4 + 8, h, rng); break;
+            case PixelFormat::NV12: Plane(0, w + 3, h, rng); Plane(1, cw * 2 + 2, ch, rng); break;
+            case PixelFormat::YUY2:
+            case PixelFormat::UYVY: Plane(0, cw * 4 + 4, h, rng); break;
+            case PixelFormat::I420: Plane(0, w, h, rng); Plane(1, cw, ch, rng); Plane(2, cw, ch, rng); break;
+            case PixelFormat::P010: Plane(0, w * 2, h, rng); Plane(1, cw * 4, ch, rng); break;
+            }
+        }
+
+        void Plane(int i, size_t stride, size_t rows, std::mt19937* rng)
+        {
+            bytes[i].resize(stride * rows);
+            if (rng)
+                for (auto& v : bytes[i])
+                    v = (uint8_t)(*rng)();
+            planes.plane[i] = bytes[i].data();
+            planes.stride[i] = (ptrdiff_t)stride;
+        }
+    };
+
+    // The chained passes, on the description as Configure() normalised it.
+    void Chain(const FramePipeline& pipeline, const ImagePlanes& src, const ImagePlanes& dst, SimdLevel level)
+    {
+        const PipelineDesc& d = pipeline.Desc();
+        const bool scaled = d.dstWidth != d.cropWidth || d.dstHeight != d.cropHeight;
+        const bool yuvOnly = d.srcFormat == PixelFormat::NV12 && d.dstFormat == PixelFormat::NV12 &&
+                             d.srcColorimetry.matrix == d.dstColorimetry.matrix &&
+                             d.srcColorimetry.range == d.dstColorimetry.range;
+        const uint8_t* srcY = src.plane[0] + d.cropY * src.stride[0] + d.cropX;
+        const uint8_t* srcUV = src.plane[1] + (d.cropY / 2) * src.stride[1] + d.cropX;
+        const ptrdiff_t outStride = (ptrdiff_t)d.dstWidth * 4;
+        std::vector<uint8_t> out((size_t)outStride * d.dstHeight);
+
+        if (yuvOnly && !scaled)
+        {
+            for (uint32_t row = 0; row < d.dstHeight; ++row)
+                std::memcpy(dst.plane[0] + row * dst.stride[0], srcY + row * src.stride[0], d.dstWidth);
+            for (uint32_t row = 0; row < (d.dstHeight + 1) / 2; ++row)
+                std::memcpy(dst.plane[1] + row * dst.stride[1], srcUV + row * src.stride[1], (d.dstWidth + 1) / 2 * 2);
+            return;
+        }
+        if (d.srcFormat == PixelFormat::NV12 && pipeline.GetNV12Scaler().IsConfigured())
+        {
+            const ptrdiff_t uvStride = (ptrdiff_t)((d.dstWidth + 1) / 2) * 2;
+            std::vector<uint8_t> y((size_t)d.dstWidth * d.dstHeight), uv((size_t)uvStride * ((d.dstHeight + 1) / 2));
+            pipeline.GetNV12Scaler().ScaleParallel(srcY, src.stride[0], srcUV, src.stride[1], y.data(), d.dstWidth,
+                                                   uv.data(), uvStride, WorkerPool::Shared(), level);
+            if (yuvOnly)
+            {
+                for (uint32_t row = 0; row < d.dstHeight; ++row)
+                    std::memcpy(dst.plane[0] + row * dst.stride[0], y.data() + row * d.dstWidth, d.dstWidth);
+                for (uint32_t row = 0; row < (d.dstHeight + 1) / 2; ++row)
+                    std::memcpy(dst.plane[1] + row * dst.stride[1], uv.data() + row * uvStride, uvStride);
+                return;
+            }
+            ConvertNV12ToBGRA(y.data(), d.dstWidth, uv.data(), uvStride, d.dstWidth, d.dstHeight, out.data(), outStride,
+                              d.srcColorimetry, level);
+        }
+        else
+        {
+            const ptrdiff_t fullStride = (ptrdiff_t)d.srcWidth * 4;
+            std::vector<uint8_t> full((size_t)fullStride * d.srcHeight);
+            switch (d.srcFormat)
+            {
+            case PixelFormat::BGRA:
+                for (uint32_t row = 0; row < d.srcHeight; ++row)
+                    std::memcpy(full.data() + row * fullStride, src.plane[0] + row * src.stride[0], fullStride);
+                break;
+            case PixelFormat::NV12:
+                ConvertNV12ToBGRA(src.plane[0], src.stride[0], src.plane[1], src.stride[1], d.srcWidth, d.srcHeight,
+                                  full.data(), fullStride, d.srcColorimetry, level);
+                break;
+            case PixelFormat::YUY2:
+                ConvertYUY2ToBGRA(src.plane[0], src.stride[0], d.srcWidth, d.srcHeight, full.data(), fullStride,
+                                  d.srcColorimetry, level);
+                break;
+            default:
+                ConvertUYVYToBGRA(src.plane[0], src.stride[0], d.srcWidth, d.srcHeight, full.data(), fullStride,
+                                  d.srcColorimetry, level);
+                break;
+            }
+            const uint8_t* crop = full.data() + d.cropY * fullStride + d.cropX * 4;
+            if (scaled)
+                Scaler(d.cropWidth, d.cropHeight, d.dstWidth, d.dstHeight, d.filter)
+                    .Scale(crop, fullStride, out.data(), outStride, 4, level);
+            else
+                for (uint32_t row = 0; row < d.dstHeight; ++row)
+                    std::memcpy(out.data() + row * outStride, crop + row * fullStride, outStride);
+        }
+
+        const uint8_t* o = out.data();
+        const uint32_t w = d.dstWidth, h = d.dstHeight;
+        switch (d.dstFormat)
+        {
+        case PixelFormat::BGRA:
+            OrientBGRA(o, outStride, w, h, dst.plane[0], dst.stride[0], d.orientation, level);
+            break;
+        case PixelFormat::NV12:
+            ConvertBGRAToNV12(o, outStride, w, h, dst.plane[0], dst.stride[0], dst.plane[1], dst.stride[1],
+                              d.dstColorimetry, level);
+            break;
+        case PixelFormat::YUY2:
+            ConvertBGRAToYUY2(o, outStride, w, h, dst.plane[0], dst.stride[0], d.dstColorimetry, level);
+            break;
+        case PixelFormat::I420:
+            ConvertBGRAToI420(o, outStride, w, h, dst.plane[0], dst.stride[0], dst.plane[1], dst.stride[1],
+                              dst.plane[2], dst.stride[2], d.dstColorimetry, level);
+            break;
+        default:
+            ConvertBGRAToP010(o, outStride, w, h, (uint16_t*)dst.plane[0], dst.stride[0], (uint16_t*)dst.plane[1],
+                              dst.stride[1], d.dstColorimetry, level);
+            break;
+        }
+    }
+
+    void FusedEqualsChained()
+    {
+        std::mt19937 rng(12);
+        WorkerPool pool(4);
+        for (int iteration = 0; iteration < 600; ++iteration)
+        {
+            PipelineDesc d;
+            d.srcFormat = kSources[rng() % 4];
+            d.dstFormat = kDestinations[rng() % 5];
+            d.srcWidth = 2 + 2 * (rng() % 60);
+            d.srcHeight = 2 + 2 * (rng() % 60);
+            if (rng() % 3)
+            {
+                d.cropX = rng() % (d.srcWidth / 2);
+                d.cropY = rng() % (d.srcHeight / 2);
+                d.cropWidth = 1 + rng() % (d.srcWidth - d.cropX - 1);
+                d.cropHeight = 1 + rng() % (d.srcHeight - d.cropY - 1);
+            }
+            if (rng() % 3)
+            {
+                d.dstWidth = 2 + 2 * (rng() % 50);
+                d.dstHeight = 2 + 2 * (rng() % 50);
+            }
+            d.filter = (ScaleFilter)(rng() % 3);
+            if (rng() % 4 == 0)
+                d.dstColorimetry = { YuvMatrix::BT709, YuvRange::Full };
+            if (d.dstFormat == PixelFormat::BGRA)
+            {
+                d.orientation.mirror = rng() & 1;
+                d.orientation.rotation = (Rotation)(90 * (rng() % 4));
+            }
+
+            FramePipeline pipeline;
+            if (!CHECK_MSG(pipeline.Configure(d), "source %d destination %d", (int)d.srcFormat, (int)d.dstFormat))
+                continue;
+            const PipelineDesc& n = pipeline.Desc();
+            const SimdLevel level = kLevels[rng() % 4];
+            Image src(n.srcFormat, n.srcWidth, n.srcHeight, &rng);
+            Image fused(n.dstFormat, pipeline.OutputWidth(), pipeline.OutputHeight(), nullptr);
+            Image chained(n.dstFormat, pipeline.OutputWidth(), pipeline.OutputHeight(), nullptr);
+            pipeline.Run(src.planes, fused.planes, pool, level);
+            Chain(pipeline, src.planes, chained.planes, level);
+            for (int i = 0; i < 3; ++i)
+                CHECK_MSG(fused.bytes[i] == chained.bytes[i],
+                          "source %d %ux%u crop %u,%u %ux%u -> %d %ux%u filter %d %s plane %d", (int)n.srcFormat,
+                          n.srcWidth, n.srcHeight, n.cropX, n.cropY, n.cropWidth, n.cropHeight, (int)n.dstFormat,
+                          n.dstWidth, n.dstHeight, (int)n.filter, SimdLevelName(level), i);
+        }
+    }
+
+    void Configure()
+    {
+        FramePipeline pipeline;
+        PipelineDesc d;
+        d.srcWidth = 64;
+        d.srcHeight = 48;
+        CHECK(pipeline.Configure(d) && pipeline.OutputWidth() == 64 && pipeline.OutputHeight() == 48);
+
+        d.orientation = { false, Rotation::Cw90 };
+        CHECK(pipeline.Configure(d) && pipeline.OutputWidth() == 48 && pipeline.OutputHeight() == 64);
+        d.dstFormat = PixelFormat::NV12;
+        CHECK(!pipeline.Configure(d) && !pipeline.IsConfigured());      // orientation needs BGRA
+        d.orientation = {};
+
+        d.srcFormat = PixelFormat::I420;                                // not a source format
+        CHECK(!pipeline.Configure(d));
+        d.srcFormat = PixelFormat::NV12;
+        d.cropX = 33;
+        d.cropY = 17;
+        d.cropWidth = 20;
+        d.cropHeight = 20;
+        CHECK(pipeline.Configure(d));
+        CHECK(pipeline.Desc().cropX == 32 && pipeline.Desc().cropWidth == 21);
+        CHECK(pipeline.Desc().cropY == 16 && pipeline.Desc().cropHeight == 21);
+        d.cropWidth = 40;                                               // past the right edge
+        CHECK(!pipeline.Configure(d));
+    }
+}
+
+int main()
+{
+    FusedEqualsChained();
+    Configure();
+    return Test::CheckResult();
+}
@@ -0,0 +1,60 @@
+// =============================================================================
+// FrameStatsBench.cpp  --  Cost of frame statistics, fused vs separate
+// =============================================================================
+// A separate statistics pass over a 1080p BGRA frame per SIMD tier, then a
+// 1080p YUY2 -> BGRA pipeline plain, with statistics gathered in flight, and
+// followed by a separate ComputeFrameStatsParallel() pass.
+// =============================================================================
+
+#include "Bench.h"
+#include "FramePipeline.h"
+#include "FrameStats.h"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+int main(int argc, char** argv)
+{
+    const int iterations = Test::QuickMode(argc, argv) ? 1 : 30;
+    const uint32_t w = 1920, h = 1080;
+    std::mt19937 rng(16);
+    std::vector<uint8_t> yuy2((size_t)w * h * 2), bgra((size_t)w * h * 4);
+    for (auto& v : yuy2)
+        v = (uint8_t)rng();
+    for (auto& v : bgra)
+        v = (uint8_t)rng();
+
+    for (int l = 0; l <= (int)GetSimdLevel(); ++l)
+    {
+        const double ms = Test::TimeMs(iterations, [&] {
+            FrameStats stats;
+            AccumulateFrameStats(bgra.data(), w * 4, w, h, stats, (SimdLevel)l);
+        });
+        std::printf("1080p stats pass  %-10s 1 thread   %8.3f ms\n", SimdLevelName((SimdLevel)l), ms);
+    }
+
+    PipelineDesc d;
+    d.srcFormat = PixelFormat::YUY2;
+    d.srcWidth = w;
+    d.srcHeight = h;
+    FramePipeline pipeline;
+    pipeline.Configure(d);
+    ImagePlanes src, dst;
+    src.plane[0] = yuy2.data();
+    src.stride[0] = (ptrdiff_t)w * 2;
+    dst.plane[0] = bgra.data();
+    dst.stride[0] = (ptrdiff_t)w * 4;
+
+    FrameStats stats;
+    const double plain = Test::TimeMs(iterations, [&] { pipeline.Run(src, dst); });
+    const double fused = Test::TimeMs(iterations, [&] { pipeline.Run(src, dst, stats); });
+    const double separate = Test::TimeMs(iterations, [&] {
+        pipeline.Run(src, dst);
+        stats = ComputeFrameStatsParallel(bgra.data(), w * 4, w, h);
+    });
+    std::printf("1080p YUY2 -> BGRA  plain %8.3f ms  stats in flight %8.3f ms  + separate pass %8.3f ms\n",
+                plain, fused, separate);
+    return 0;
+}
@@ -0,0 +1,247 @@
+// =============================================================================
+// FrameStatsTest.cpp  --  Frame statistics against a separate reference pass
+// =============================================================================
+// The statistics are exact integer counts, so every way of gathering them
+// must equal a naive single-threaded pass over the BGRA frame bit for bit:
+// AccumulateFrameStats() on every SIMD tier, ComputeFrameStatsParallel(),
+// merged partial passes, and FramePipeline::Run() accumulating its chunks in
+// flight for every source / destination format.  Also covers the derived
+// values (min / max / percentiles / means) and the manifest summary.
+// =============================================================================
+
+#include "Check.h"
+#include "FramePipeline.h"
+#include "FrameStats.h"
+#include "Manifest.h"
+#include "YuvUnpack.h"
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    const SimdLevel kLevels[] = { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512 };
+
+    FrameStats Reference(const uint8_t* bgra, ptrdiff_t stride, uint32_t w, uint32_t h)
+    {
+        FrameStats s;
+        for (uint32_t y = 0; y < h; ++y)
+            for (uint32_t x = 0; x < w; ++x)
+            {
+                const uint8_t* p = bgra + y * stride + x * 4;
+                const uint32_t luma = (19u * p[0] + 183u * p[1] + 54u * p[2] + 128u) >> 8;
+                ++s.lumaHistogram[luma];
+                s.lumaSum += luma;
+                ++s.pixelCount;
+                for (int c = 0; c < 3; ++c)
+                    s.channelSum[c] += p[c];
+                s.clippedLow += p[0] == 0 || p[1] == 0 || p[2] == 0;
+                s.clippedHigh += p[0] == 255 || p[1] == 255 || p[2] == 255;
+            }
+        return s;
+    }
+
+    bool Equal(const FrameStats& a, const FrameStats& b)
+    {
+        return std::memcmp(&a, &b, sizeof(FrameStats)) == 0;
+    }
+
+    // Noise, hard clips, and mostly-dark frames with a few whites.
+    void Fill(std::vector<uint8_t>& image, std::mt19937& rng)
+    {
+        const int mode = rng() % 3;
+        for (auto& v : image)
+            v = (uint8_t)(mode == 0 ? rng() : mode == 1 ? (rng() % 2 ? 0 : 255) : (rng() % 4 == 0 ? 255 : rng() % 8));
+    }
+
+    void SeparatePass()
+    {
+        std::mt19937 rng(5);
+        WorkerPool pool(4);
+        for (int iteration = 0; iteration < 300; ++iteration)
+        {
+            const uint32_t w = 1 + rng() % 300, h = 1 + rng() % 200;
+            const ptrdiff_t stride = (ptrdiff_t)w * 4 + (rng() % 3) * 4;
+            std::vector<uint8_t> image((size_t)stride * h);
+            Fill(image, rng);
+            const FrameStats ref = Reference(image.data(), stride, w, h);
+            for (SimdLevel level : kLevels)
+            {
+                FrameStats direct;
+                AccumulateFrameStats(image.data(), stride, w, h, direct, level);
+                CHECK_MSG(Equal(direct, ref), "%ux%u %s", w, h, SimdLevelName(level));
+                CHECK_MSG(Equal(ComputeFrameStatsParallel(image.data(), stride, w, h, pool, level), ref),
+                          "%ux%u %s parallel", w, h, SimdLevelName(level));
+            }
+
+            // Two partial passes, merged; accumulating adds to what is there.
+            const uint32_t split = rng() % (h + 1);
+            FrameStats top, bottom;
+            AccumulateFrameStats(image.data(), stride, w, split, top);
+            AccumulateFrameStats(image.data() + split * stride, stride, w, h - split, bottom);
+            top.Merge(bottom);
+            CHECK_MSG(Equal(top, ref), "%ux%u split at %u", w, h, split);
+        }
+    }
+
+    struct Image {
+        std::vector<uint8_t> bytes;
+        ImagePlanes planes;
+
+        // Planes back to back in one buffer.
+        Image(PixelFormat format, uint32_t w, uint32_t h, std::mt19937* rng)
+        {
+            const uint32_t cw = (w + 1) / 2, ch = (h + 1) / 2;
+            ptrdiff_t strides[3] = {};
+            uint32_t rows[3] = { h, 0, 0 };
+            switch (format)
+            {
+            case PixelFormat::BGRA: strides[0] = w * 4; break;
+            case PixelFormat::YUY2:
+            case PixelFormat::UYVY: strides[0] = cw * 4; break;
+            case PixelFormat::NV12: strides[0] = w; strides[1] = cw * 2; rows[1] = ch; break;
+            case PixelFormat::P010: strides[0] = w * 2; strides[1] = cw * 4; rows[1] = ch; break;
+            case PixelFormat::I420: strides[0] = w; strides[1] = strides[2] = cw; rows[1] = rows[2] = ch; break;
+            }
+            bytes.resize(strides[0] * rows[0] + strides[1] * rows[1] + strides[2] * rows[2]);
+            if (rng)
+                for (auto& v : bytes)
+                    v = (uint8_t)(*rng)();
+            uint8_t* p = bytes.data();
+            for (int i = 0; i < 3 && strides[i]; ++i)
+            {
+                planes.plane[i] = p;
+                planes.stride[i] = strides[i];
+                p += strides[i] * rows[i];
+            }
+        }
+    };
+
+    // The pipeline gathers the statistics of its BGRA rows before they are
+    // packed: compare with a reference pass over the same pipeline's output
+    // with a BGRA destination (or, for NV12 -> NV12, the output unpacked).
+    void Pipeline()
+    {
+        const PixelFormat sources[] = { PixelFormat::BGRA, PixelFormat::NV12, PixelFormat::YUY2, PixelFormat::UYVY };
+        const PixelFormat destinations[] = { PixelFormat::BGRA, PixelFormat::NV12, PixelFormat::YUY2,
+                                             PixelFormat::I420, PixelFormat::P010 };
+        std::mt19937 rng(16);
+        WorkerPool pool(4);
+        for (int iteration = 0; iteration < 200; ++iteration)
+        {
+            PipelineDesc d;
+            d.srcFormat = sources[rng() % 4];
+            d.dstFormat = destinations[rng() % 5];
+            d.srcWidth = 2 + 2 * (rng() % 200);
+            d.srcHeight = 2 + 2 * (rng() % 150);
+            if (rng() % 2)
+            {
+                d.dstWidth = 1 + rng() % 300;
+                d.dstHeight = 2 + 2 * (rng() % 100);
+            }
+            if (rng() % 3 == 0)
+            {
+                d.cropX = rng() % (d.srcWidth / 2);
+                d.cropY = rng() % (d.srcHeight / 2);
+                d.cropWidth = d.srcWidth / 2;
+                d.cropHeight = d.srcHeight / 2;
+            }
+            if (d.dstFormat == PixelFormat::BGRA && rng() % 2)
+                d.orientation = { true, Rotation::Cw90 };
+            FramePipeline pipeline;
+            if (!CHECK(pipeline.Configure(d)))
+                continue;
+            const uint32_t w = pipeline.Desc().dstWidth, h = pipeline.Desc().dstHeight;
+            Image src(d.srcFormat, d.srcWidth, d.srcHeight, &rng);
+            Image dst(d.dstFormat, pipeline.OutputWidth(), pipeline.OutputHeight(), nullptr);
+
+            FrameStats ref;
+            std::vector<uint8_t> bgra((size_t)w * h * 4);
+            if (d.srcFormat == PixelFormat::NV12 && d.dstFormat == PixelFormat::NV12)
+            {
+                pipeline.Run(src.planes, dst.planes);
+                ConvertNV12ToBGRA(dst.planes.plane[0], dst.planes.stride[0], dst.planes.plane[1], dst.planes.stride[1],
+                                  w, h, bgra.data(), w * 4, d.dstColorimetry);
+            }
+            else
+            {
+                PipelineDesc unpacked = d;
+                unpacked.dstFormat = PixelFormat::BGRA;
+                unpacked.orientation = {};
+                FramePipeline reference;
+                reference.Configure(unpacked);
+                ImagePlanes out;
+                out.plane[0] = bgra.data();
+                out.stride[0] = (ptrdiff_t)w * 4;
+                reference.Run(src.planes, out);
+            }
+            ref = Reference(bgra.data(), w * 4, w, h);
+
+            for (SimdLevel level : kLevels)
+            {
+                FrameStats stats;
+                stats.pixelCount = 12345;                           // replaced, not added to
+                pipeline.Run(src.planes, dst.planes, stats, pool, level);
+                CHECK_MSG(Equal(stats, ref), "source %d -> destination %d %ux%u %s", (int)d.srcFormat,
+                          (int)d.dstFormat, w, h, SimdLevelName(level));
+            }
+        }
+    }
+
+    void Derived()
+    {
+        FrameStats empty;
+        CHECK(empty.LumaMin() == 0 && empty.LumaMax() == 0 && empty.MeanLuma() == 0.0);
+
+        // 100 pixels: luma 10 x 1, 50 x 98, 200 x 1.
+        std::vector<uint8_t> image(100 * 4);
+        for (int i = 0; i < 100; ++i)
+        {
+            const uint8_t v = i == 0 ? 10 : i == 99 ? 200 : 50;
+            image[i * 4] = image[i * 4 + 1] = image[i * 4 + 2] = v;
+        }
+        FrameStats s;
+        AccumulateFrameStats(image.data(), 400, 100, 1, s);
+        CHECK(StatsLuma(10, 10, 10) == 10 && StatsLuma(255, 255, 255) == 255);
+        CHECK(s.LumaMin() == 10 && s.LumaMax() == 200);
+        CHECK(s.LumaPercentile(0.01) == 10 && s.LumaPercentile(0.02) == 50);
+        CHECK(s.LumaPercentile(0.99) == 50 && s.LumaPercentile(1.0) == 200);
+        CHECK(s.MeanLuma() == (10 + 50 * 98 + 200) / 100.0);
+        CHECK(s.MeanRed() == s.MeanLuma() && s.clippedLow == 0 && s.clippedHigh == 0);
+
+        const ManifestFrameStats summary = SummarizeFrameStats(s, 42);
+        CHECK(summary.frameValue == 42 && summary.lumaMin == 10 && summary.lumaMax == 200);
+        CHECK(summary.lumaLow == 10 && summary.lumaHigh == 50);
+        CHECK(summary.meanLuma == (uint16_t)(51.1 * 256 + 0.5) && summary.meanRed == summary.meanLuma);
+    }
+
+    void ManifestRecord()
+    {
+        auto manifest = std::make_unique<BroadcastManifestV2>();
+        std::memset((void*)manifest.get(), 0, sizeof(BroadcastManifestV2));
+        InitializeManifest(*manifest, 1920, 1080, 87, {}, 10000000, u"texture", u"fence");
+
+        ManifestFrameStats read;
+        CHECK(!ReadFrameStats(*manifest, read));                    // nothing published yet
+
+        FrameStats stats;
+        std::vector<uint8_t> image(64 * 4, 255);
+        AccumulateFrameStats(image.data(), 256, 64, 1, stats);
+        const ManifestFrameStats summary = SummarizeFrameStats(stats, 7);
+        CHECK(summary.clippedHigh == 65535 && summary.clippedLow == 0);
+        PublishFrameStats(*manifest, summary);
+        CHECK(ReadFrameStats(*manifest, read) && std::memcmp(&read, &summary, sizeof(read)) == 0);
+    }
+}
+
+int main()
+{
+    SeparatePass();
+    Pipeline();
+    Derived();
+    ManifestRecord();
+    return Test::CheckResult();
+}
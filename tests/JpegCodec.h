@@ -0,0 +1,94 @@
+// =============================================================================
+// JpegCodec.h  --  libjpeg-turbo encode / decode for the MJPEG tests
+// =============================================================================
+// Stands in for the WIC decoder the camera producer plugs into MjpegPipeline.
+// Only built when CMake finds libjpeg (VCAM_HAVE_LIBJPEG); the BGRA output
+// colour space is a libjpeg-turbo extension.
+// =============================================================================
+
+#pragma once
+
+#include <csetjmp>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <jpeglib.h>
+
+namespace VirtuaCam::Test {
+
+// Baseline JPEG of a deterministic pattern ('seed' varies it).
+inline std::vector<uint8_t> EncodeTestJpeg(uint32_t width, uint32_t height, int seed, int quality = 85)
+{
+    jpeg_compress_struct c;
+    jpeg_error_mgr error;
+    c.err = jpeg_std_error(&error);
+    jpeg_create_compress(&c);
+    unsigned char* buffer = nullptr;
+    unsigned long size = 0;
+    jpeg_mem_dest(&c, &buffer, &size);
+    c.image_width = width;
+    c.image_height = height;
+    c.input_components = 3;
+    c.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&c);
+    jpeg_set_quality(&c, quality, TRUE);
+    jpeg_start_compress(&c, TRUE);
+    std::vector<uint8_t> row(width * 3);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            row[x * 3] = (uint8_t)(x * 7 + seed * 13);
+            row[x * 3 + 1] = (uint8_t)(y * 5 + x);
+            row[x * 3 + 2] = (uint8_t)((x ^ y) + seed);
+        }
+        JSAMPROW rows = row.data();
+        jpeg_write_scanlines(&c, &rows, 1);
+    }
+    jpeg_finish_compress(&c);
+    jpeg_destroy_compress(&c);
+    std::vector<uint8_t> jpeg(buffer, buffer + size);
+    std::free(buffer);
+    return jpeg;
+}
+
+// MjpegPipeline::DecodeFn.  Corrupt data fails instead of exiting; libjpeg
+// error handlers must not return, so errors longjmp back here (nothing with
+// a destructor is live in this frame).
+inline bool DecodeTestJpeg(const uint8_t* jpeg, size_t size, uint8_t* bgra, ptrdiff_t stride,
+                           uint32_t width, uint32_t height)
+{
+    struct Error : jpeg_error_mgr {
+        std::jmp_buf exit;
+    } error;
+    jpeg_decompress_struct d;
+    d.err = jpeg_std_error(&error);
+    error.error_exit = [](j_common_ptr info) { std::longjmp(static_cast<Error*>(info->err)->exit, 1); };
+    error.emit_message = [](j_common_ptr, int) {};
+    jpeg_create_decompress(&d);
+    if (setjmp(error.exit))
+    {
+        jpeg_destroy_decompress(&d);
+        return false;
+    }
+    jpeg_mem_src(&d, jpeg, (unsigned long)size);
+    if (jpeg_read_header(&d, TRUE) != JPEG_HEADER_OK || d.image_width != width || d.image_height != height)
+    {
+        jpeg_destroy_decompress(&d);
+        return false;
+    }
+    d.out_color_space = JCS_EXT_BGRA;
+    jpeg_start_decompress(&d);
+    while (d.output_scanline < d.output_height)
+    {
+        JSAMPROW row = bgra + stride * d.output_scanline;
+        jpeg_read_scanlines(&d, &row, 1);
+    }
+    jpeg_finish_decompress(&d);
+    jpeg_destroy_decompress(&d);
+    return true;
+}
+
+}
@@ -0,0 +1,178 @@
+// =============================================================================
+// LetterboxTest.cpp  --  Aspect-fit layout math and the CPU bar fill
+// =============================================================================
+// Layout: FitRect / HasBars / CoverUv for portrait, 4:3, ultrawide and
+// matching sources; PlanLetterboxFill sizes and mip level; normalised
+// Gaussian weights.  LetterboxFill: every SIMD tier gives the same frame,
+// flat sources give a flat fill, only the cover region of the source shows,
+// its left-to-right structure survives, and fine noise is blurred away.
+// =============================================================================
+
+#include "Check.h"
+#include "Letterbox.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    const SimdLevel kLevels[] = { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512 };
+
+    bool Near(float a, float b)
+    {
+        return std::fabs(a - b) <= 1e-3f;
+    }
+
+    void Layout()
+    {
+        const LayoutRect dst{ 0, 0, 1920, 1080 };
+
+        LayoutRect fit = FitRect(dst, 1080, 1920);                  // portrait phone
+        CHECK(Near(fit.width, 607.5f) && Near(fit.height, 1080) && Near(fit.x, 656.25f) && Near(fit.y, 0));
+        CHECK(HasBars(dst, fit));
+
+        fit = FitRect(dst, 640, 480);                               // 4:3
+        CHECK(Near(fit.width, 1440) && Near(fit.x, 240) && HasBars(dst, fit));
+
+        fit = FitRect(dst, 2560, 1080);                             // ultrawide: bars top and bottom
+        CHECK(Near(fit.width, 1920) && Near(fit.height, 810) && Near(fit.y, 135) && HasBars(dst, fit));
+
+        fit = FitRect(dst, 1280, 720);                              // same aspect
+        CHECK(Near(fit.width, 1920) && Near(fit.height, 1080) && !HasBars(dst, fit));
+
+        const LayoutRect offset{ 100, 50, 400, 400 };
+        fit = FitRect(offset, 200, 100);
+        CHECK(Near(fit.x, 100) && Near(fit.y, 150) && Near(fit.width, 400) && Near(fit.height, 200));
+
+        fit = FitRect(dst, 0, 0);                                   // unknown size
+        CHECK(fit.width == dst.width && fit.height == dst.height);
+        CHECK(!HasBars(dst, LayoutRect{ 0.4f, 0, 1919.5f, 1080 }));  // sub-pixel slack is no bar
+    }
+
+    void Cover()
+    {
+        UvRect c = CoverUv(1920, 1080, 1080, 1920);                 // taller: crop top and bottom
+        CHECK(Near(c.width, 1) && Near(c.u, 0));
+        CHECK(Near(c.height, (1080.0f / 1920) / (1920.0f / 1080)) && Near(c.v, (1 - c.height) / 2));
+
+        c = CoverUv(1920, 1080, 2560, 1080);                        // wider: crop the sides
+        CHECK(Near(c.height, 1) && Near(c.width, (1920.0f / 1080) / (2560.0f / 1080)) && Near(c.u, (1 - c.width) / 2));
+
+        c = CoverUv(1280, 720, 1920, 1080);
+        CHECK(Near(c.u, 0) && Near(c.v, 0) && Near(c.width, 1) && Near(c.height, 1));
+
+        c = CoverUv(1920, 1080, 0, 0);
+        CHECK(Near(c.width, 1) && Near(c.height, 1));
+    }
+
+    void Plan()
+    {
+        LetterboxFillPlan p = PlanLetterboxFill(1920, 1080, 1080, 1920);
+        CHECK(p.width == 120 && p.height == 68);
+        // 1080 source columns over 120 reduced pixels: 9 texels per pixel.
+        CHECK_MSG(Near(p.lod, std::log2(9.0f)), "lod %.3f", p.lod);
+
+        p = PlanLetterboxFill(1920, 1080, 64, 64);                  // small source: no mip
+        CHECK(p.lod == 0.0f);
+        p = PlanLetterboxFill(10, 10, 640, 480, 0);                 // reduction clamped to 1
+        CHECK(p.width == 10 && p.height == 10);
+        p = PlanLetterboxFill(5, 3, 640, 480, 16);
+        CHECK(p.width == 1 && p.height == 1);
+
+        float weights[8];
+        GaussianWeights(2.0f, 7, weights);
+        double sum = weights[0];
+        for (int i = 1; i < 8; ++i)
+        {
+            sum += 2.0 * weights[i];
+            CHECK(weights[i] < weights[i - 1]);
+        }
+        CHECK(std::fabs(sum - 1.0) < 1e-5);
+        CHECK(Near(weights[1] / weights[0], std::exp(-1.0f / 8.0f)));
+    }
+
+    std::vector<uint8_t> Fill(LetterboxFill& fill, const std::vector<uint8_t>& src, uint32_t sw, uint32_t dw, uint32_t dh,
+                              SimdLevel level = GetSimdLevel())
+    {
+        std::vector<uint8_t> dst((size_t)dw * dh * 4);
+        fill.Apply(src.data(), sw * 4, dst.data(), dw * 4, WorkerPool::Shared(), level);
+        return dst;
+    }
+
+    void CpuFill()
+    {
+        const uint32_t sw = 540, sh = 960, dw = 640, dh = 360;
+        LetterboxFill fill;
+        fill.Configure(sw, sh, dw, dh);
+        CHECK(fill.IsConfigured() && fill.Plan().width == 40 && fill.Plan().height == 23);
+
+        // Flat in, flat out.
+        std::vector<uint8_t> src((size_t)sw * sh * 4);
+        for (size_t i = 0; i < src.size(); i += 4)
+        {
+            src[i] = 30;
+            src[i + 1] = 140;
+            src[i + 2] = 220;
+            src[i + 3] = 255;
+        }
+        std::vector<uint8_t> dst = Fill(fill, src, sw, dw, dh);
+        bool flat = true;
+        for (size_t i = 0; i < dst.size(); i += 4)
+            flat &= dst[i] == 30 && dst[i + 1] == 140 && dst[i + 2] == 220 && dst[i + 3] == 255;
+        CHECK(flat);
+
+        // Portrait source: the cover region is a centred band of rows (whole
+        // rows, as Configure() rounds it).  Rows outside it are pure red and
+        // must not show; inside, blue ramps up from left to right.
+        const UvRect cover = fill.Plan().cover;
+        const uint32_t bandTop = (uint32_t)(cover.v * sh);
+        const uint32_t bandBottom = bandTop + (uint32_t)std::lround(cover.height * sh);
+        CHECK(bandTop > 0 && bandBottom < sh);
+        std::mt19937 rng(17);
+        for (uint32_t y = 0; y < sh; ++y)
+            for (uint32_t x = 0; x < sw; ++x)
+            {
+                uint8_t* p = &src[((size_t)y * sw + x) * 4];
+                const bool inside = y >= bandTop && y < bandBottom;
+                p[0] = inside ? (uint8_t)(x * 255 / (sw - 1)) : 0;
+                p[1] = inside ? (uint8_t)(96 + rng() % 64) : 0;     // noise around 127.5
+                p[2] = inside ? 0 : 255;
+                p[3] = 255;
+            }
+        const std::vector<uint8_t> ref = Fill(fill, src, sw, dw, dh, SimdLevel::Scalar);
+        for (SimdLevel level : kLevels)
+            CHECK_MSG(Fill(fill, src, sw, dw, dh, level) == ref, "%s", SimdLevelName(level));
+
+        int maxRed = 0, maxNoise = 0;
+        bool monotonic = true;
+        for (uint32_t y = 0; y < dh; ++y)
+            for (uint32_t x = 0; x < dw; ++x)
+            {
+                const uint8_t* p = &ref[((size_t)y * dw + x) * 4];
+                maxRed = std::max(maxRed, (int)p[2]);
+                maxNoise = std::max(maxNoise, std::abs(2 * p[1] - 255));
+                if (x)
+                    monotonic &= p[0] + 1 >= p[-4];
+            }
+        CHECK_MSG(maxRed <= 2, "red from outside the cover region: %d", maxRed);
+        CHECK_MSG(maxNoise <= 2 * 12, "noise left: +-%d / 2", maxNoise);
+        CHECK(monotonic);
+        CHECK(ref[0] < 40 && ref[(dw - 1) * 4] > 215);              // dark left, bright right
+
+        LetterboxFill none;
+        none.Configure(0, 0, dw, dh);
+        CHECK(!none.IsConfigured());
+    }
+}
+
+int main()
+{
+    Layout();
+    Cover();
+    Plan();
+    CpuFill();
+    return Test::CheckResult();
+}
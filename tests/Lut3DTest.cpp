@@ -0,0 +1,208 @@
+// =============================================================================
+// Lut3DTest.cpp  --  .cube parsing and tetrahedral LUT application
+// =============================================================================
+// Generated 2 / 17 / 33 / 65-point .cube files of a non-trivial grade: every
+// SIMD tier and the parallel (in-place) path produce the scalar result, which
+// stays within 1 of a double-precision tetrahedral interpolation of the same
+// lattice; alpha passes through; an identity LUT is exact.  Malformed files
+// are rejected with a message, DOMAIN_MIN / DOMAIN_MAX are honoured, and
+// LoadCubeFile() reads the same file from disk.
+// =============================================================================
+
+#include "Check.h"
+#include "Lut3D.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    const SimdLevel kLevels[] = { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512 };
+
+    void Grade(double r, double g, double b, double& outR, double& outG, double& outB)
+    {
+        outR = std::fmin(1.0, std::pow(r, 0.8) * 0.9 + 0.05 * g);
+        outG = 0.1 + 0.8 * g * g + 0.1 * b;
+        outB = std::sqrt(b) * 0.95;
+    }
+
+    // The .cube text and the lattice values as written (6 decimals).
+    std::string MakeCube(int n, std::vector<double>& lattice)
+    {
+        std::string text = "# generated\nTITLE \"Warm look\"\nLUT_3D_SIZE " + std::to_string(n) + "\n\n";
+        lattice.assign((size_t)n * n * n * 3, 0.0);
+        char line[96];
+        for (int b = 0; b < n; ++b)
+            for (int g = 0; g < n; ++g)
+                for (int r = 0; r < n; ++r)
+                {
+                    double rgb[3];
+                    Grade(r / (n - 1.0), g / (n - 1.0), b / (n - 1.0), rgb[0], rgb[1], rgb[2]);
+                    std::snprintf(line, sizeof(line), "%.6f %.6f %.6f\n", rgb[0], rgb[1], rgb[2]);
+                    text += line;
+                    for (int c = 0; c < 3; ++c)
+                        lattice[(((size_t)b * n + g) * n + r) * 3 + c] = std::round(rgb[c] * 1e6) / 1e6;
+                }
+        return text;
+    }
+
+    // Tetrahedral interpolation of channel 'c' (0 R, 1 G, 2 B), in doubles.
+    double Reference(const std::vector<double>& lattice, int n, double r, double g, double b, int c)
+    {
+        const double pr = r * (n - 1), pg = g * (n - 1), pb = b * (n - 1);
+        const int ir = std::min((int)pr, n - 2), ig = std::min((int)pg, n - 2), ib = std::min((int)pb, n - 2);
+        const double fr = pr - ir, fg = pg - ig, fb = pb - ib;
+        auto at = [&](int dr, int dg, int db) {
+            return lattice[((((size_t)ib + db) * n + (ig + dg)) * n + (ir + dr)) * 3 + c];
+        };
+        const double c000 = at(0, 0, 0), c111 = at(1, 1, 1);
+        if (fr >= fg && fg >= fb) return (1 - fr) * c000 + (fr - fg) * at(1, 0, 0) + (fg - fb) * at(1, 1, 0) + fb * c111;
+        if (fr >= fb && fb >= fg) return (1 - fr) * c000 + (fr - fb) * at(1, 0, 0) + (fb - fg) * at(1, 0, 1) + fg * c111;
+        if (fb >= fr && fr >= fg) return (1 - fb) * c000 + (fb - fr) * at(0, 0, 1) + (fr - fg) * at(1, 0, 1) + fg * c111;
+        if (fg >= fr && fr >= fb) return (1 - fg) * c000 + (fg - fr) * at(0, 1, 0) + (fr - fb) * at(1, 1, 0) + fb * c111;
+        if (fg >= fb && fb >= fr) return (1 - fg) * c000 + (fg - fb) * at(0, 1, 0) + (fb - fr) * at(0, 1, 1) + fr * c111;
+        return (1 - fb) * c000 + (fb - fg) * at(0, 0, 1) + (fg - fr) * at(0, 1, 1) + fr * c111;
+    }
+
+    void GeneratedCubes()
+    {
+        std::mt19937 rng(14);
+        WorkerPool pool(4);
+        for (int n : { 2, 17, 33, 65 })
+        {
+            std::vector<double> lattice;
+            Lut3D lut;
+            std::string error;
+            if (!CHECK_MSG(lut.ParseCube(MakeCube(n, lattice), &error), "%d points: %s", n, error.c_str()))
+                continue;
+            CHECK(lut.IsLoaded() && lut.Size() == (uint32_t)n && lut.Title() == "Warm look");
+
+            // Odd width for the SIMD tails; the whole grey axis up front.
+            const uint32_t w = 517, h = 37;
+            std::vector<uint32_t> src((size_t)w * h);
+            for (auto& v : src)
+                v = rng();
+            for (uint32_t i = 0; i < 256; ++i)
+                src[i] = 0xFF000000u | i * 0x010101u;
+
+            std::vector<uint32_t> ref(src.size());
+            lut.Apply((const uint8_t*)src.data(), w * 4, (uint8_t*)ref.data(), w * 4, w, h, SimdLevel::Scalar);
+            for (SimdLevel level : kLevels)
+            {
+                std::vector<uint32_t> out(src.size());
+                lut.Apply((const uint8_t*)src.data(), w * 4, (uint8_t*)out.data(), w * 4, w, h, level);
+                CHECK_MSG(out == ref, "%d points %s", n, SimdLevelName(level));
+            }
+            std::vector<uint32_t> inPlace = src;
+            lut.ApplyParallel((uint8_t*)inPlace.data(), w * 4, (uint8_t*)inPlace.data(), w * 4, w, h, pool);
+            CHECK_MSG(inPlace == ref, "%d points in place, parallel", n);
+
+            int maxError = 0;
+            for (size_t i = 0; i < src.size(); ++i)
+            {
+                const uint32_t p = src[i];
+                const double r = ((p >> 16) & 255) / 255.0, g = ((p >> 8) & 255) / 255.0, b = (p & 255) / 255.0;
+                for (int c = 0; c < 3; ++c)
+                {
+                    const double v = std::clamp(Reference(lattice, n, r, g, b, c), 0.0, 1.0);
+                    const int expected = (int)std::lround(v * 255), got = (ref[i] >> (16 - 8 * c)) & 255;
+                    maxError = std::max(maxError, std::abs(expected - got));
+                }
+                CHECK((ref[i] >> 24) == (p >> 24));
+            }
+            CHECK_MSG(maxError <= 1, "%d points: max error %d against the double reference", n, maxError);
+        }
+    }
+
+    void Identity()
+    {
+        Lut3D lut;
+        lut.SetIdentity(33);
+        const uint32_t w = 4096, h = 16;
+        std::vector<uint32_t> src((size_t)w * h), out(src.size());
+        for (size_t i = 0; i < src.size(); ++i)
+            src[i] = (uint32_t)(i * 2654435761u);
+        for (SimdLevel level : kLevels)
+        {
+            lut.Apply((const uint8_t*)src.data(), w * 4, (uint8_t*)out.data(), w * 4, w, h, level);
+            CHECK_MSG(out == src, "%s", SimdLevelName(level));
+        }
+        lut.Reset();
+        CHECK(!lut.IsLoaded());
+    }
+
+    void ParseErrors()
+    {
+        const char* invalid[] = {
+            "LUT_3D_SIZE 2\n0 0 0\n",          // too few entries
+            "LUT_1D_SIZE 4\n",                  // 1D LUT
+            "0 0 0\n",                          // no size
+            "LUT_3D_SIZE 2\n0 0\n",             // short line
+            "LUT_3D_SIZE 300\n",                // too large
+        };
+        for (const char* text : invalid)
+        {
+            Lut3D lut;
+            lut.SetIdentity(2);
+            std::string error;
+            CHECK_MSG(!lut.ParseCube(text, &error) && !error.empty(), "accepted: %s", text);
+            CHECK(lut.Size() == 2);             // unchanged on failure
+        }
+    }
+
+    // DOMAIN 0..2: input white sits half-way up the lattice.  CRLF line
+    // endings, a '+' sign and a trailing comment are accepted.
+    void Domain()
+    {
+        Lut3D lut;
+        std::string error;
+        CHECK_MSG(lut.ParseCube("DOMAIN_MIN 0 0 0\r\nDOMAIN_MAX 2 2 2\r\nLUT_3D_SIZE 2\r\n"
+                                "0 0 0\r\n1 0 0\r\n0 1 0\r\n1 1 0\r\n0 0 1\r\n1 0 1\r\n0 1 1\r\n+1 1 1 # white\r\n",
+                                &error),
+                  "%s", error.c_str());
+        const uint32_t white = 0xFFFFFFFF;
+        uint32_t out = 0;
+        lut.Apply((const uint8_t*)&white, 4, (uint8_t*)&out, 4, 1, 1);
+        CHECK_MSG(out == 0xFF808080u, "%08x", out);
+    }
+
+    void LoadFile()
+    {
+        std::vector<double> lattice;
+        const std::string text = MakeCube(17, lattice);
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "vcam_lut3d_test.cube";
+        std::ofstream(path, std::ios::binary) << text;
+
+        Lut3D fromFile, fromText;
+        std::string error;
+        CHECK_MSG(fromFile.LoadCubeFile(path, &error), "%s", error.c_str());
+        fromText.ParseCube(text);
+        std::vector<uint32_t> src(1024), a(src.size()), b(src.size());
+        for (size_t i = 0; i < src.size(); ++i)
+            src[i] = (uint32_t)(i * 2246822519u);
+        fromFile.Apply((const uint8_t*)src.data(), 1024 * 4, (uint8_t*)a.data(), 1024 * 4, 1024, 1);
+        fromText.Apply((const uint8_t*)src.data(), 1024 * 4, (uint8_t*)b.data(), 1024 * 4, 1024, 1);
+        CHECK(a == b);
+        std::filesystem::remove(path);
+
+        Lut3D missing;
+        CHECK(!missing.LoadCubeFile(path, &error) && !error.empty());
+    }
+}
+
+int main()
+{
+    GeneratedCubes();
+    Identity();
+    ParseErrors();
+    Domain();
+    LoadFile();
+    return Test::CheckResult();
+}
@@ -0,0 +1,245 @@
+// =============================================================================
+// ManifestTest.cpp  --  Manifest layouts, version detection and the seqlock
+// =============================================================================
+// Layout: v1 is bit-for-bit the original, v2 keeps the hot counter and the
+// seqlocked record on cache lines of their own.  ManifestVersion() tells
+// v1, v2 and garbage apart from the bytes alone.  Stress: a writer publishes
+// frames whose every field derives from the frame number while readers (3
+// threads, then a forked process through POSIX shm) check that no snapshot
+// is torn, none goes backwards, and none is older than the frame counter
+// read before it; the statistics record gets the same treatment (torn reads
+// need the threads on separate cores to show up).  A writer that dies
+// mid-update makes readers give up instead of spinning.
+// =============================================================================
+
+#include "Check.h"
+#include "Manifest.h"
+#include "SharedMemory.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace VirtuaCam;
+
+namespace
+{
+    constexpr uint64_t kFrames = 1000000;
+
+    ManifestFrameInfo MakeInfo(uint64_t frame)
+    {
+        ManifestFrameInfo info;
+        info.frameValue = frame;
+        info.captureTime = (int64_t)frame * 1000;
+        info.duration = 333333;
+        info.width = (uint32_t)(frame * 7);
+        info.height = (uint32_t)(frame * 13);
+        info.format = 87;
+        info.dirtyRegions = (uint32_t)frame;
+        info.dirtyLeft = (int32_t)frame;
+        info.dirtyTop = -(int32_t)frame;
+        info.dirtyRight = (int32_t)frame + 1;
+        info.dirtyBottom = (int32_t)(frame ^ 5);
+        return info;
+    }
+
+    ManifestFrameStats MakeStats(uint64_t frame)
+    {
+        ManifestFrameStats stats;
+        stats.frameValue = frame;
+        stats.meanLuma = (uint16_t)frame;
+        stats.meanBlue = (uint16_t)(frame * 3);
+        stats.meanGreen = (uint16_t)(frame * 5);
+        stats.meanRed = (uint16_t)(frame * 7);
+        stats.lumaMin = (uint8_t)frame;
+        stats.lumaMax = (uint8_t)(frame + 1);
+        stats.lumaLow = (uint8_t)(frame + 2);
+        stats.lumaHigh = (uint8_t)(frame + 3);
+        stats.clippedLow = (uint16_t)(frame >> 3);
+        stats.clippedHigh = (uint16_t)(frame >> 5);
+        return stats;
+    }
+
+    // A snapshot is consistent if it is exactly what one PublishFrame wrote.
+    bool Consistent(const ManifestFrameInfo& info)
+    {
+        const ManifestFrameInfo expected = info.frameValue ? MakeInfo(info.frameValue) : ManifestFrameInfo();
+        return !std::memcmp(&expected, &info, sizeof(info));
+    }
+
+    bool Consistent(const ManifestFrameStats& stats)
+    {
+        const ManifestFrameStats expected = MakeStats(stats.frameValue);
+        return !std::memcmp(&expected, &stats, sizeof(stats));
+    }
+
+    std::unique_ptr<BroadcastManifestV2> ZeroedManifest()
+    {
+        auto manifest = std::make_unique<BroadcastManifestV2>();
+        std::memset((void*)manifest.get(), 0, sizeof(BroadcastManifestV2));
+        return manifest;
+    }
+
+    void Layout()
+    {
+        CHECK(sizeof(BroadcastManifestV1) == 1056);
+        CHECK(offsetof(BroadcastManifestV1, textureName) == 28 && offsetof(BroadcastManifestV1, command) == 1056 - 4);
+        CHECK(offsetof(BroadcastManifestV2, frameValue) == 64);
+        CHECK(offsetof(BroadcastManifestV2, sequence) == 128);
+        CHECK(offsetof(BroadcastManifestV2, textureName) >= 192);
+        CHECK(offsetof(BroadcastManifestV2, statsSequence) % 64 == 0);
+        CHECK(kManifestV2MinSize < kManifestV2RingSize && kManifestV2RingSize < kManifestV2LivenessSize &&
+              kManifestV2LivenessSize < sizeof(BroadcastManifestV2));
+    }
+
+    void Versions()
+    {
+        auto manifest = ZeroedManifest();
+        const size_t bytes = sizeof(BroadcastManifestV2);
+        CHECK(ManifestVersion(nullptr, bytes) == 0);
+        CHECK(ManifestVersion(manifest.get(), sizeof(BroadcastManifestV1) - 1) == 0);
+        // Not stamped yet: reads as a v1 producer that has no frame yet.
+        CHECK(ManifestVersion(manifest.get(), bytes) == 1);
+
+        InitializeManifest(*manifest, 1920, 1080, 87, { 5, -1 }, 10000000, u"Local\\Texture", u"Local\\Fence");
+        CHECK(ManifestVersion(manifest.get(), bytes) == 2);
+        CHECK(ManifestVersion(manifest.get(), sizeof(BroadcastManifestV1)) == 1);     // mapping shorter than 'size'
+        CHECK(manifest->width == 1920 && manifest->height == 1080 && manifest->format == 87);
+        CHECK(manifest->adapterLuid.lowPart == 5 && manifest->adapterLuid.highPart == -1);
+        CHECK(std::u16string(manifest->textureName) == u"Local\\Texture" && std::u16string(manifest->fenceName) == u"Local\\Fence");
+        CHECK(!ManifestRing(*manifest));
+
+        ManifestFrameInfo info;
+        CHECK(ReadFrameInfo(*manifest, info) && info.frameValue == 0);
+        ManifestFrameStats stats;
+        CHECK(!ReadFrameStats(*manifest, stats));
+
+        // Long names are truncated and terminated.
+        std::u16string longName(kManifestNameChars + 10, u'x');
+        InitializeManifest(*manifest, 1, 1, 87, {}, 1, longName.c_str(), u"f");
+        CHECK(std::u16string(manifest->textureName).size() == kManifestNameChars - 1);
+
+        // Any other version or a size beyond the mapping is not v2.
+        manifest->version = 3;
+        CHECK(ManifestVersion(manifest.get(), bytes) == 1);
+        manifest->version = kManifestVersion;
+        manifest->size = (uint32_t)bytes + 64;
+        CHECK(ManifestVersion(manifest.get(), bytes) == 1);
+
+        // A v1 producer's counter never reaches the magic.
+        std::vector<uint8_t> v1(sizeof(BroadcastManifestV1));
+        const uint64_t frame = 123456789;
+        std::memcpy(v1.data(), &frame, sizeof(frame));
+        CHECK(ManifestVersion(v1.data(), v1.size()) == 1);
+    }
+
+    void ThreadStress()
+    {
+        auto manifest = ZeroedManifest();
+        InitializeManifest(*manifest, 1920, 1080, 87, {}, 10000000, u"t", u"f");
+
+        std::atomic<bool> done = false;
+        std::atomic<long> reads = 0, torn = 0, backwards = 0, stale = 0, statsTorn = 0;
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 3; ++t)
+            readers.emplace_back([&] {
+                uint64_t last = 0;
+                while (!done.load(std::memory_order_relaxed))
+                {
+                    const uint64_t counter = manifest->frameValue.load(std::memory_order_acquire);
+                    ManifestFrameInfo info;
+                    if (ReadFrameInfo(*manifest, info))
+                    {
+                        ++reads;
+                        torn += !Consistent(info);
+                        backwards += info.frameValue < last;
+                        stale += info.frameValue < counter;
+                        last = info.frameValue;
+                    }
+                    ManifestFrameStats stats;
+                    if (ReadFrameStats(*manifest, stats))
+                        statsTorn += !Consistent(stats);
+                }
+            });
+        for (uint64_t frame = 1; frame <= kFrames; ++frame)
+        {
+            PublishFrameStats(*manifest, MakeStats(frame));
+            PublishFrame(*manifest, MakeInfo(frame));
+        }
+        done = true;
+        for (auto& reader : readers)
+            reader.join();
+
+        CHECK(reads > 0);
+        CHECK_MSG(!torn && !backwards && !stale && !statsTorn, "%ld reads: %ld torn, %ld backwards, %ld older than the counter, %ld torn stats",
+                  reads.load(), torn.load(), backwards.load(), stale.load(), statsTorn.load());
+        ManifestFrameInfo info;
+        CHECK(ReadFrameInfo(*manifest, info) && info.frameValue == kFrames && Consistent(info));
+    }
+
+    void ProcessStress()
+    {
+#if defined(__unix__)
+        const std::string name = "vcam_test_manifest_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+        SharedMemoryRegion::Remove(name);
+        SharedMemoryRegion region;
+        if (!CHECK(region.Open(name, sizeof(BroadcastManifestV2))))
+            return;
+        auto* manifest = static_cast<BroadcastManifestV2*>(region.Data());
+        InitializeManifest(*manifest, 1, 1, 87, {}, 1, u"t", u"f");
+
+        const pid_t child = fork();
+        if (child == 0)
+        {
+            SharedMemoryRegion writer;
+            if (!writer.Open(name, sizeof(BroadcastManifestV2)))
+                _exit(1);
+            auto* m = static_cast<BroadcastManifestV2*>(writer.Data());
+            for (uint64_t frame = 1; frame <= kFrames; ++frame)
+                PublishFrame(*m, MakeInfo(frame));
+            _exit(0);
+        }
+
+        long reads = 0, torn = 0, backwards = 0;
+        uint64_t last = 0;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+        while (last != kFrames && std::chrono::steady_clock::now() < deadline)
+        {
+            ManifestFrameInfo info;
+            if (!ReadFrameInfo(*manifest, info))
+                continue;
+            ++reads;
+            torn += !Consistent(info);
+            backwards += info.frameValue < last;
+            last = info.frameValue;
+        }
+        int status = 0;
+        CHECK(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        CHECK_MSG(last == kFrames && !torn && !backwards, "%ld reads up to frame %llu: %ld torn, %ld backwards", reads,
+                  (unsigned long long)last, torn, backwards);
+
+        // A writer that died mid-update leaves the sequence odd: readers give up.
+        manifest->sequence.fetch_add(1);
+        ManifestFrameInfo info;
+        CHECK(!ReadFrameInfo(*manifest, info));
+        SharedMemoryRegion::Remove(name);
+#endif
+    }
+}
+
+int main()
+{
+    Layout();
+    Versions();
+    ThreadStress();
+    ProcessStress();
+    return Test::CheckResult();
+}
@@ -0,0 +1,142 @@
+// =============================================================================
+// ManifestViewBench.cpp  --  Per-frame manifest polling: reopen vs held view
+// =============================================================================
+// Readers (the multiplexer, the consumer) poll every connected producer's
+// frame counter once per frame.  They used to open the manifest mapping, map
+// it, read the counter, unmap and close it every time; now they keep the
+// view mapped for the life of the connection and the poll is one atomic
+// load.  This measures both for 1 / 4 / 16 producers on the POSIX backend
+// (SharedMemoryRegion: shm_open, fstat, mmap, close, munmap per reopen;
+// Windows makes four calls), with the OS calls counted by wrapping them at
+// link time (-Wl,--wrap; see CMakeLists.txt) where the toolchain allows.
+// =============================================================================
+
+#include "Bench.h"
+#include "Manifest.h"
+#include "SharedMemory.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if VCAM_COUNT_SYSCALLS
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace
+{
+    std::atomic<long> g_osCalls = 0;
+}
+
+extern "C"
+{
+    int __real_shm_open(const char* name, int flags, mode_t mode);
+    int __real_fstat(int fd, struct stat* st);
+    int __real_ftruncate(int fd, off_t length);
+    void* __real_mmap(void* address, size_t length, int protection, int flags, int fd, off_t offset);
+    int __real_munmap(void* address, size_t length);
+    int __real_close(int fd);
+
+    int __wrap_shm_open(const char* name, int flags, mode_t mode) { ++g_osCalls; return __real_shm_open(name, flags, mode); }
+    int __wrap_fstat(int fd, struct stat* st) { ++g_osCalls; return __real_fstat(fd, st); }
+    int __wrap_ftruncate(int fd, off_t length) { ++g_osCalls; return __real_ftruncate(fd, length); }
+    void* __wrap_mmap(void* address, size_t length, int protection, int flags, int fd, off_t offset)
+    {
+        ++g_osCalls;
+        return __real_mmap(address, length, protection, flags, fd, offset);
+    }
+    int __wrap_munmap(void* address, size_t length) { ++g_osCalls; return __real_munmap(address, length); }
+    int __wrap_close(int fd) { ++g_osCalls; return __real_close(fd); }
+}
+
+static long OsCalls() { return g_osCalls.load(); }
+#else
+static long OsCalls() { return -1; }
+#endif
+
+using namespace VirtuaCam;
+
+int main(int argc, char** argv)
+{
+    const int frames = Test::QuickMode(argc, argv) ? 100 : 20000;
+    const std::string base = "vcam_bench_manifest_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+
+    for (uint32_t producers : { 1u, 4u, 16u })
+    {
+        // The producers' side: one manifest each, publishing frames.
+        std::vector<std::string> names;
+        std::vector<std::unique_ptr<SharedMemoryRegion>> published;
+        for (uint32_t i = 0; i < producers; ++i)
+        {
+            names.push_back(base + "_" + std::to_string(i));
+            SharedMemoryRegion::Remove(names.back());
+            published.push_back(std::make_unique<SharedMemoryRegion>());
+            published.back()->Open(names.back(), sizeof(BroadcastManifestV2));
+            auto* manifest = static_cast<BroadcastManifestV2*>(published.back()->Data());
+            InitializeManifest(*manifest, 1920, 1080, 87, {}, 10000000, u"texture", u"fence", 0, 1000 + i);
+        }
+        auto publish = [&](int frame) {
+            for (auto& region : published)
+            {
+                ManifestFrameInfo info;
+                info.frameValue = (uint64_t)frame + 1;
+                PublishFrame(*static_cast<BroadcastManifestV2*>(region->Data()), info);
+            }
+        };
+
+        uint64_t seen = 0;
+        long calls = OsCalls();
+        const double reopen = Test::TimeMs(1, [&] {
+            for (int frame = 0; frame < frames; ++frame)
+            {
+                publish(frame);
+                for (const std::string& name : names)
+                {
+                    SharedMemoryRegion view;
+                    if (view.Open(name, sizeof(BroadcastManifestV2)))
+                        seen += static_cast<BroadcastManifestV2*>(view.Data())->frameValue.load(std::memory_order_acquire);
+                }
+            }
+        });
+        const long reopenCalls = OsCalls() - calls;
+
+        std::vector<std::unique_ptr<SharedMemoryRegion>> views;
+        for (const std::string& name : names)
+        {
+            views.push_back(std::make_unique<SharedMemoryRegion>());
+            views.back()->Open(name, sizeof(BroadcastManifestV2));
+        }
+        calls = OsCalls();
+        const double held = Test::TimeMs(1, [&] {
+            for (int frame = 0; frame < frames; ++frame)
+            {
+                publish(frame);
+                for (const auto& view : views)
+                    seen += static_cast<BroadcastManifestV2*>(view->Data())->frameValue.load(std::memory_order_acquire);
+            }
+        });
+        const long heldCalls = OsCalls() - calls;
+
+        // TimeMs runs each loop twice (warm-up + timed).
+        const double perFrame = 2.0 * frames;
+        if (reopenCalls >= 0)
+            std::printf("%2u producer%s  reopen per frame %9.3f us  %5.1f OS calls    held view %7.3f us  %4.1f OS calls\n",
+                        producers, producers > 1 ? "s" : " ", reopen * 1000.0 / frames, reopenCalls / perFrame, held * 1000.0 / frames,
+                        heldCalls / perFrame);
+        else
+            std::printf("%2u producer%s  reopen per frame %9.3f us    held view %7.3f us  (OS calls not counted)\n",
+                        producers, producers > 1 ? "s" : " ", reopen * 1000.0 / frames, held * 1000.0 / frames);
+        if (!seen)
+            std::printf("no frames seen\n");
+
+        views.clear();
+        published.clear();
+        for (const std::string& name : names)
+            SharedMemoryRegion::Remove(name);
+    }
+    return 0;
+}
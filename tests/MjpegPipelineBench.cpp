@@ -0,0 +1,165 @@
+// =============================================================================
+// MjpegPipelineBench.cpp  --  Pipelined MJPEG decode throughput
+// =============================================================================
+// Usage: MjpegPipelineBench [--quick] [directory]
+//
+// Decodes a directory of sample frames (*.jpg / *.jpeg, all the same size,
+// e.g. dumped from a camera) with libjpeg-turbo, first one frame at a time
+// and then through MjpegPipeline at 1, 2, 4, ... pool threads.  Without a
+// directory it encodes 1080p and 4K test frames itself.
+// =============================================================================
+
+#include "Bench.h"
+#include "JpegCodec.h"
+#include "MjpegPipeline.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    struct Clip {
+        std::string name;
+        uint32_t width = 0, height = 0;
+        std::vector<std::vector<uint8_t>> frames;
+    };
+
+    bool ReadSize(const std::vector<uint8_t>& jpeg, uint32_t& width, uint32_t& height)
+    {
+        for (size_t pos = 2; pos + 9 < jpeg.size();)
+        {
+            if (jpeg[pos] != 0xFF)
+                return false;
+            const uint8_t marker = jpeg[pos + 1];
+            if (marker >= 0xC0 && marker <= 0xC3)
+            {
+                height = (uint32_t)jpeg[pos + 5] << 8 | jpeg[pos + 6];
+                width = (uint32_t)jpeg[pos + 7] << 8 | jpeg[pos + 8];
+                return true;
+            }
+            pos += 2 + ((size_t)jpeg[pos + 2] << 8 | jpeg[pos + 3]);
+        }
+        return false;
+    }
+
+    bool LoadDirectory(const std::string& directory, Clip& clip)
+    {
+        std::vector<std::filesystem::path> paths;
+        for (const auto& entry : std::filesystem::directory_iterator(directory))
+        {
+            std::string extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+            if (extension == ".jpg" || extension == ".jpeg")
+                paths.push_back(entry.path());
+        }
+        std::sort(paths.begin(), paths.end());
+        clip.name = directory;
+        for (const auto& path : paths)
+        {
+            std::ifstream file(path, std::ios::binary);
+            std::vector<uint8_t> jpeg((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            uint32_t w = 0, h = 0;
+            if (!ReadSize(jpeg, w, h) || (!clip.frames.empty() && (w != clip.width || h != clip.height)))
+            {
+                std::fprintf(stderr, "skipping %s\n", path.string().c_str());
+                continue;
+            }
+            clip.width = w;
+            clip.height = h;
+            clip.frames.push_back(std::move(jpeg));
+        }
+        return !clip.frames.empty();
+    }
+
+    Clip Synthesize(const char* name, uint32_t width, uint32_t height, int count)
+    {
+        Clip clip = { name, width, height, {} };
+        for (int i = 0; i < count; ++i)
+            clip.frames.push_back(Test::EncodeTestJpeg(width, height, i));
+        return clip;
+    }
+
+    void Run(const Clip& clip, int passes)
+    {
+        const uint32_t w = clip.width, h = clip.height;
+        auto decode = [w, h](const uint8_t* jpeg, size_t size, uint8_t* bgra, ptrdiff_t stride) {
+            return Test::DecodeTestJpeg(jpeg, size, bgra, stride, w, h);
+        };
+        const double frames = (double)clip.frames.size() * passes;
+
+        std::vector<uint8_t> bgra((size_t)w * h * 4), copy;
+        const double serial = Test::TimeMs(1, [&] {
+            for (int pass = 0; pass < passes; ++pass)
+            {
+                for (const auto& jpeg : clip.frames)
+                {
+                    AppendMjpegFrame(jpeg.data(), jpeg.size(), copy);
+                    decode(copy.data(), copy.size(), bgra.data(), w * 4);
+                }
+            }
+        });
+        std::printf("%s %ux%u, %zu frames: serial %7.1f fps\n", clip.name.c_str(), w, h, clip.frames.size(),
+                    frames * 1000.0 / serial);
+
+        const unsigned maxThreads = std::max(2u, std::thread::hardware_concurrency());
+        for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads))
+        {
+            WorkerPool pool(threads);
+            MjpegPipeline pipeline(w, h, decode, 0, pool);
+            size_t delivered = 0;
+            auto consume = [&](const uint8_t*, ptrdiff_t, int64_t, int64_t) { ++delivered; };
+            const double ms = Test::TimeMs(1, [&] {
+                for (int pass = 0; pass < passes; ++pass)
+                {
+                    for (size_t i = 0; i < clip.frames.size(); ++i)
+                    {
+                        const auto& jpeg = clip.frames[i];
+                        while (!pipeline.Submit(jpeg.data(), jpeg.size(), (int64_t)i, 0))
+                            pipeline.Pop(consume);
+                        while (pipeline.TryPop(consume))
+                        {
+                        }
+                    }
+                }
+                while (pipeline.Pop(consume))
+                {
+                }
+            });
+            std::printf("%s %ux%u  pipeline %2u threads (depth %u) %7.1f fps\n", clip.name.c_str(), w, h, threads,
+                        pipeline.Depth(), frames * 1000.0 / ms);
+            if (threads == maxThreads)
+                break;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const bool quick = Test::QuickMode(argc, argv);
+    std::string directory;
+    for (int i = 1; i < argc; ++i)
+        if (std::string(argv[i]) != "--quick")
+            directory = argv[i];
+
+    if (!directory.empty())
+    {
+        Clip clip;
+        if (!LoadDirectory(directory, clip))
+        {
+            std::fprintf(stderr, "no usable JPEG frames in %s\n", directory.c_str());
+            return 1;
+        }
+        Run(clip, quick ? 1 : 3);
+        return 0;
+    }
+    Run(Synthesize("1080p", 1920, 1080, quick ? 4 : 30), quick ? 1 : 2);
+    Run(Synthesize("4K", 3840, 2160, quick ? 2 : 15), quick ? 1 : 2);
+    return 0;
+}
@@ -0,0 +1,178 @@
+// =============================================================================
+// MjpegPipelineTest.cpp  --  In-order delivery and Huffman table insertion
+// =============================================================================
+// The pipeline runs with a stand-in decoder whose frames carry their index
+// and whose decode time varies, so decodes finish out of order: frames must
+// still come out in submission order with their own timestamp and duration,
+// corrupt ones dropped.  AppendMjpegFrame() is checked structurally and, with
+// libjpeg available, by decoding a UVC-style frame with its tables stripped.
+// =============================================================================
+
+#include "Check.h"
+#include "MjpegPipeline.h"
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+#if VCAM_HAVE_LIBJPEG
+#include "JpegCodec.h"
+#endif
+
+using namespace VirtuaCam;
+
+namespace
+{
+    constexpr uint32_t kWidth = 64, kHeight = 16;
+
+    // Stand-in frame: SOI, then the index.  Index 0xFF marks a corrupt frame.
+    std::vector<uint8_t> FakeFrame(uint8_t index) { return { 0xFF, 0xD8, index }; }
+
+    bool FakeDecode(const uint8_t* data, size_t size, uint8_t* bgra, ptrdiff_t stride)
+    {
+        if (size != 3 || data[2] == 0xFF)
+            return false;
+        std::this_thread::sleep_for(std::chrono::microseconds((data[2] * 7919) % 1500));
+        for (uint32_t y = 0; y < kHeight; ++y)
+            std::memset(bgra + y * stride, data[2], kWidth * 4);
+        return true;
+    }
+
+    void InOrderDelivery()
+    {
+        WorkerPool pool(4);
+        MjpegPipeline pipeline(kWidth, kHeight, FakeDecode, 0, pool);
+        CHECK(pipeline.Depth() == 4);
+
+        int next = 0;
+        auto consume = [&](const uint8_t* bgra, ptrdiff_t stride, int64_t timestamp, int64_t duration) {
+            if (next == 7 || next == 20)
+                ++next;                                 // the corrupt ones
+            bool same = true;
+            for (uint32_t y = 0; y < kHeight; ++y)
+                for (uint32_t x = 0; x < kWidth * 4; ++x)
+                    same &= bgra[y * stride + x] == (uint8_t)next;
+            CHECK_MSG(timestamp == next * 1000 && duration == 333 + next && same, "expected frame %d, got %lld", next,
+                      (long long)timestamp);
+            ++next;
+        };
+
+        for (int i = 0; i < 60; ++i)
+        {
+            const std::vector<uint8_t> frame = FakeFrame(i == 7 || i == 20 ? 0xFF : (uint8_t)i);
+            if (!pipeline.Submit(frame.data(), frame.size(), i * 1000, 333 + i))
+            {
+                CHECK(pipeline.InFlight() == pipeline.Depth());
+                pipeline.Pop(consume);
+                CHECK(pipeline.Submit(frame.data(), frame.size(), i * 1000, 333 + i));
+            }
+            while (pipeline.TryPop(consume))
+            {
+            }
+        }
+        while (pipeline.Pop(consume))
+        {
+        }
+        CHECK(next == 60);
+        CHECK(pipeline.InFlight() == 0);
+        CHECK(!pipeline.TryPop(consume) && !pipeline.Pop(consume));
+    }
+
+    // Destroying the pipeline with decodes in flight waits for them.
+    void DestroyInFlight()
+    {
+        WorkerPool pool(3);
+        for (int round = 0; round < 20; ++round)
+        {
+            MjpegPipeline pipeline(kWidth, kHeight, FakeDecode, 3, pool);
+            for (uint8_t i = 0; i < 3; ++i)
+            {
+                const std::vector<uint8_t> frame = FakeFrame(i);
+                pipeline.Submit(frame.data(), frame.size(), i, 0);
+            }
+        }
+    }
+
+    // SOI, DQT, SOF0 and SOS with no DHT, then some entropy-coded bytes.
+    std::vector<uint8_t> HeaderWithoutDht()
+    {
+        std::vector<uint8_t> jpeg = { 0xFF, 0xD8, 0xFF, 0xDB, 0x00, 0x43, 0x00 };
+        jpeg.insert(jpeg.end(), 64, 1);
+        const uint8_t sof[] = { 0xFF, 0xC0, 0x00, 0x11, 0x08, 0x00, 0x10, 0x00, 0x10, 0x03,
+                                0x01, 0x22, 0x00, 0x02, 0x11, 0x00, 0x03, 0x11, 0x00 };
+        jpeg.insert(jpeg.end(), sof, sof + sizeof(sof));
+        const uint8_t sos[] = { 0xFF, 0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3F, 0x00,
+                                0x12, 0x34, 0x56, 0xFF, 0xD9 };
+        jpeg.insert(jpeg.end(), sos, sos + sizeof(sos));
+        return jpeg;
+    }
+
+    void HuffmanTables()
+    {
+        const std::vector<uint8_t> in = HeaderWithoutDht();
+        const size_t sosOffset = in.size() - 19;
+        std::vector<uint8_t> out;
+        AppendMjpegFrame(in.data(), in.size(), out);
+        // One DHT segment with the four Annex K.3 tables: 2 + 4 * 17 + 12 + 12 + 162 + 162 bytes.
+        const size_t dhtSize = 2 + 2 + 4 * 17 + 12 + 12 + 162 + 162;
+        CHECK(out.size() == in.size() + dhtSize);
+        CHECK(std::memcmp(out.data(), in.data(), sosOffset) == 0);
+        CHECK(out[sosOffset] == 0xFF && out[sosOffset + 1] == 0xC4);
+        CHECK((out[sosOffset + 2] << 8 | out[sosOffset + 3]) == (int)dhtSize - 2);
+        CHECK(std::memcmp(out.data() + sosOffset + dhtSize, in.data() + sosOffset, in.size() - sosOffset) == 0);
+
+        // With tables already present, or not a JPEG at all: a plain copy.
+        std::vector<uint8_t> again;
+        AppendMjpegFrame(out.data(), out.size(), again);
+        CHECK(again == out);
+        const uint8_t junk[] = { 1, 2, 3, 4, 5 };
+        AppendMjpegFrame(junk, sizeof(junk), again);
+        CHECK(again.size() == sizeof(junk) && std::memcmp(again.data(), junk, sizeof(junk)) == 0);
+    }
+
+#if VCAM_HAVE_LIBJPEG
+    // Strips every DHT segment, as UVC cameras do.
+    std::vector<uint8_t> StripDht(const std::vector<uint8_t>& in)
+    {
+        std::vector<uint8_t> out(in.begin(), in.begin() + 2);
+        size_t pos = 2;
+        for (;;)
+        {
+            const uint8_t marker = in[pos + 1];
+            const size_t length = (size_t)in[pos + 2] << 8 | in[pos + 3];
+            if (marker == 0xDA)
+            {
+                out.insert(out.end(), in.begin() + pos, in.end());
+                return out;
+            }
+            if (marker != 0xC4)
+                out.insert(out.end(), in.begin() + pos, in.begin() + pos + 2 + length);
+            pos += 2 + length;
+        }
+    }
+
+    void DecodeStrippedFrame()
+    {
+        const uint32_t w = 160, h = 96;
+        const std::vector<uint8_t> jpeg = Test::EncodeTestJpeg(w, h, 1);
+        const std::vector<uint8_t> stripped = StripDht(jpeg);
+        CHECK(stripped.size() < jpeg.size());
+
+        std::vector<uint8_t> fixed, expected(w * h * 4), actual(w * h * 4);
+        AppendMjpegFrame(stripped.data(), stripped.size(), fixed);
+        CHECK(Test::DecodeTestJpeg(jpeg.data(), jpeg.size(), expected.data(), w * 4, w, h));
+        CHECK(Test::DecodeTestJpeg(fixed.data(), fixed.size(), actual.data(), w * 4, w, h));
+        CHECK(actual == expected);
+    }
+#endif
+}
+
+int main()
+{
+    InOrderDelivery();
+    DestroyInFlight();
+    HuffmanTables();
+#if VCAM_HAVE_LIBJPEG
+    DecodeStrippedFrame();
+#endif
+    return Test::CheckResult();
+}
@@ -0,0 +1,38 @@
+// =============================================================================
+// NoSignalBench.cpp  --  Placeholder generation time
+// =============================================================================
+// RenderNoSignalFrame() at 720p / 1080p / 4K per SIMD tier on one thread, and
+// band-parallel on the shared pool: what a cache miss in
+// CreateNoSignalTexture() costs.
+// =============================================================================
+
+#include "Bench.h"
+#include "NoSignal.h"
+#include <cstdio>
+#include <vector>
+
+using namespace VirtuaCam;
+
+int main(int argc, char** argv)
+{
+    const int iterations = Test::QuickMode(argc, argv) ? 1 : 20;
+    struct Size { const char* name; uint32_t width, height; };
+    const Size sizes[] = { { "720p", 1280, 720 }, { "1080p", 1920, 1080 }, { "4K", 3840, 2160 } };
+    WorkerPool serial(1);
+
+    for (const Size& size : sizes)
+    {
+        std::vector<uint32_t> frame((size_t)size.width * size.height);
+        for (int l = 0; l <= (int)GetSimdLevel(); ++l)
+        {
+            const double ms = Test::TimeMs(iterations, [&] {
+                RenderNoSignalFrame(frame.data(), size.width, size.height, serial, (SimdLevel)l);
+            });
+            std::printf("%-6s %-10s 1 thread  %8.3f ms\n", size.name, SimdLevelName((SimdLevel)l), ms);
+        }
+        const double ms = Test::TimeMs(iterations, [&] { RenderNoSignalFrame(frame.data(), size.width, size.height); });
+        std::printf("%-6s %-10s %u threads %8.3f ms\n", size.name, SimdLevelName(GetSimdLevel()),
+                    WorkerPool::Shared().GetThreadCount(), ms);
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+// =============================================================================
+// NoSignalTest.cpp  --  "No Signal" placeholder rasteriser
+// =============================================================================
+// Every SIMD tier and the serial / parallel paths draw the same frame; away
+// from the wordmark each pixel is the radial gradient evaluated with the
+// formula from NoSignal.cpp; the wordmark lands centred, opaque and visible.
+// =============================================================================
+
+#include "Check.h"
+#include "NoSignal.h"
+#include "NoSignalMask.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    const SimdLevel kLevels[] = { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512 };
+
+    struct Size { uint32_t width, height; };
+    const Size kSizes[] = { { 1, 1 }, { 7, 3 }, { 33, 1000 }, { 640, 480 }, { 1281, 721 }, { 1920, 1080 } };
+
+    uint32_t GradientPixel(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+    {
+        const float cx = width * 0.5f, cy = height * 0.5f;
+        const float inv = 1.0f / std::sqrt(cx * cx + cy * cy);
+        const float dx = (float)x - cx, dy = (float)y - cy;
+        float t = std::sqrt(dx * dx + dy * dy) * inv;
+        t = t * t * (3.0f - 2.0f * t);
+        const uint32_t r = (uint32_t)(24.0f + (7.0f - 24.0f) * t);
+        const uint32_t g = (uint32_t)(26.0f + (8.0f - 26.0f) * t);
+        const uint32_t b = (uint32_t)(30.0f + (10.0f - 30.0f) * t);
+        return 0xFF000000u | (r << 16) | (g << 8) | b;
+    }
+
+    void TiersAgree()
+    {
+        WorkerPool serial(1), pool(4);
+        for (const Size& s : kSizes)
+        {
+            std::vector<uint32_t> ref((size_t)s.width * s.height);
+            RenderNoSignalFrame(ref.data(), s.width, s.height, serial, SimdLevel::Scalar);
+            for (SimdLevel level : kLevels)
+            {
+                std::vector<uint32_t> out(ref.size());
+                RenderNoSignalFrame(out.data(), s.width, s.height, pool, level);
+                CHECK_MSG(out == ref, "%ux%u %s", s.width, s.height, SimdLevelName(level));
+            }
+        }
+    }
+
+    // The wordmark box as RenderNoSignalFrame() sizes it, padded by a pixel
+    // for the bilinear footprint.
+    void Background()
+    {
+        for (const Size& s : kSizes)
+        {
+            const uint32_t w = s.width, h = s.height;
+            std::vector<uint32_t> frame((size_t)w * h);
+            RenderNoSignalFrame(frame.data(), w, h);
+
+            float scale = (h / 12.0f) / kNoSignalMaskHeight;
+            if (kNoSignalMaskWidth * scale > w * 0.5f)
+                scale = (w * 0.5f) / kNoSignalMaskWidth;
+            const int32_t outW = std::max(1, (int32_t)(kNoSignalMaskWidth * scale));
+            const int32_t outH = std::max(1, (int32_t)(kNoSignalMaskHeight * scale));
+            const int32_t x0 = ((int32_t)w - outW) / 2 - 1, y0 = ((int32_t)h - outH) / 2 - 1;
+            const int32_t x1 = x0 + outW + 2, y1 = y0 + outH + 2;
+
+            int mismatches = 0, inside = 0, text = 0;
+            for (uint32_t y = 0; y < h; ++y)
+                for (uint32_t x = 0; x < w; ++x)
+                {
+                    const uint32_t px = frame[(size_t)y * w + x];
+                    CHECK((px >> 24) == 0xFF);
+                    if ((int32_t)x >= x0 && (int32_t)x < x1 && (int32_t)y >= y0 && (int32_t)y < y1)
+                    {
+                        ++inside;
+                        text += px != GradientPixel(x, y, w, h);
+                    }
+                    else
+                        mismatches += px != GradientPixel(x, y, w, h);
+                }
+            CHECK_MSG(mismatches == 0, "%ux%u: %d background pixels off the gradient", w, h, mismatches);
+            if (w >= 640)
+                CHECK_MSG(text > inside / 20, "%ux%u: wordmark covers %d of %d pixels", w, h, text, inside);
+        }
+    }
+
+    // Brightest in the centre, darkest in the corners.
+    void Falloff()
+    {
+        const uint32_t w = 640, h = 480;
+        std::vector<uint32_t> frame((size_t)w * h);
+        RenderNoSignalFrame(frame.data(), w, h);
+        CHECK(frame[0] == GradientPixel(0, 0, w, h));
+        CHECK(((frame[0] >> 16) & 0xFF) <= 8 && (frame[0] & 0xFF) <= 11);
+        const uint32_t top = frame[w / 2];
+        CHECK(((top >> 16) & 0xFF) > ((frame[0] >> 16) & 0xFF));
+    }
+}
+
+int main()
+{
+    TiersAgree();
+    Background();
+    Falloff();
+
+    std::vector<uint32_t> untouched(4, 0x12345678);
+    RenderNoSignalFrame(untouched.data(), 0, 2);
+    RenderNoSignalFrame(nullptr, 2, 2);
+    CHECK(untouched[0] == 0x12345678);
+    return Test::CheckResult();
+}
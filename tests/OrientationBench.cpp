@@ -0,0 +1,77 @@
+// =============================================================================
+// OrientationBench.cpp  --  Fused vs separate mirror / rotation passes
+// =============================================================================
+// 1080p NV12 -> BGRA and 4K -> 1080p BGRA scaling with each orientation:
+// convert (or scale) then OrientBGRAParallel() as a second full-frame pass,
+// against the fused call that writes the oriented frame directly.  The
+// stand-alone OrientBGRA() pass is timed per SIMD tier as well.
+// =============================================================================
+
+#include "Bench.h"
+#include "Orientation.h"
+#include "Scaler.h"
+#include "YuvUnpack.h"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+int main(int argc, char** argv)
+{
+    const int iterations = Test::QuickMode(argc, argv) ? 1 : 30;
+    const Orientation orientations[] = { { true, Rotation::None }, { false, Rotation::Cw90 },
+                                         { false, Rotation::Cw180 }, { true, Rotation::Cw270 } };
+    std::mt19937 rng(5);
+
+    const uint32_t w = 1920, h = 1080;
+    std::vector<uint8_t> Y((size_t)w * h), UV((size_t)w * h / 2);
+    for (auto& v : Y)
+        v = (uint8_t)rng();
+    for (auto& v : UV)
+        v = (uint8_t)rng();
+    std::vector<uint32_t> temp((size_t)w * h), out((size_t)w * h);
+
+    const uint32_t sw = 3840, sh = 2160;
+    std::vector<uint32_t> big((size_t)sw * sh);
+    for (auto& v : big)
+        v = rng();
+    const Scaler scaler(sw, sh, w, h, ScaleFilter::Bilinear);
+
+    for (const Orientation& o : orientations)
+    {
+        uint32_t ow, oh;
+        OrientedSize(w, h, o, ow, oh);
+        const char* mirror = o.mirror ? "mirror" : "";
+        const unsigned degrees = (unsigned)o.rotation;
+
+        for (int l = 0; l <= (int)GetSimdLevel(); ++l)
+        {
+            const double ms = Test::TimeMs(iterations, [&] {
+                OrientBGRA((uint8_t*)temp.data(), w * 4, w, h, (uint8_t*)out.data(), ow * 4, o, (SimdLevel)l);
+            });
+            std::printf("1080p orient only  %-6s %3u %-10s %8.3f ms\n", mirror, degrees, SimdLevelName((SimdLevel)l), ms);
+        }
+
+        const double convertSeparate = Test::TimeMs(iterations, [&] {
+            ConvertNV12ToBGRAParallel(Y.data(), w, UV.data(), w, w, h, (uint8_t*)temp.data(), w * 4);
+            OrientBGRAParallel((uint8_t*)temp.data(), w * 4, w, h, (uint8_t*)out.data(), ow * 4, o);
+        });
+        const double convertFused = Test::TimeMs(iterations, [&] {
+            ConvertNV12ToBGRAParallel(Y.data(), w, UV.data(), w, w, h, (uint8_t*)out.data(), ow * 4, YuvColorimetry{}, o);
+        });
+        std::printf("1080p NV12->BGRA   %-6s %3u separate %8.3f ms  fused %8.3f ms\n", mirror, degrees,
+                    convertSeparate, convertFused);
+
+        const double scaleSeparate = Test::TimeMs(iterations, [&] {
+            scaler.ScaleParallel((uint8_t*)big.data(), sw * 4, (uint8_t*)temp.data(), w * 4, 4);
+            OrientBGRAParallel((uint8_t*)temp.data(), w * 4, w, h, (uint8_t*)out.data(), ow * 4, o);
+        });
+        const double scaleFused = Test::TimeMs(iterations, [&] {
+            scaler.ScaleParallel((uint8_t*)big.data(), sw * 4, (uint8_t*)out.data(), ow * 4, o);
+        });
+        std::printf("4K->1080p scale    %-6s %3u separate %8.3f ms  fused %8.3f ms\n", mirror, degrees,
+                    scaleSeparate, scaleFused);
+    }
+    return 0;
+}
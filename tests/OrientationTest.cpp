@@ -0,0 +1,168 @@
+// =============================================================================
+// OrientationTest.cpp  --  Mirror / rotate transforms and their fused users
+// =============================================================================
+// For random frame sizes and every mirror x rotation: OrientBGRA() on every
+// SIMD tier and in parallel matches a per-pixel index-mapping reference, and
+// the fused NV12 / YUY2 / UYVY conversions and the fused BGRA scaler equal
+// the plain pass followed by a separate OrientBGRA().
+// =============================================================================
+
+#include "Check.h"
+#include "Orientation.h"
+#include "Scaler.h"
+#include "YuvUnpack.h"
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    const SimdLevel kLevels[] = { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512 };
+    const Rotation kRotations[] = { Rotation::None, Rotation::Cw90, Rotation::Cw180, Rotation::Cw270 };
+
+    // Mirror first, then rotate clockwise (Orientation.h).
+    std::vector<uint32_t> Reference(const std::vector<uint32_t>& src, uint32_t w, uint32_t h, Orientation o)
+    {
+        uint32_t ow, oh;
+        OrientedSize(w, h, o, ow, oh);
+        std::vector<uint32_t> out((size_t)ow * oh);
+        for (uint32_t y = 0; y < h; ++y)
+            for (uint32_t x = 0; x < w; ++x)
+            {
+                const uint32_t xm = o.mirror ? w - 1 - x : x;
+                uint32_t dx, dy;
+                switch (o.rotation)
+                {
+                case Rotation::None:  dx = xm;         dy = y;          break;
+                case Rotation::Cw90:  dx = h - 1 - y;  dy = xm;         break;
+                case Rotation::Cw180: dx = w - 1 - xm; dy = h - 1 - y;  break;
+                default:              dx = y;          dy = w - 1 - xm; break;
+                }
+                out[(size_t)dy * ow + dx] = src[(size_t)y * w + x];
+            }
+        return out;
+    }
+
+    void Sizes()
+    {
+        uint32_t w, h;
+        OrientedSize(640, 480, { true, Rotation::Cw90 }, w, h);
+        CHECK(w == 480 && h == 640);
+        OrientedSize(640, 480, { false, Rotation::Cw180 }, w, h);
+        CHECK(w == 640 && h == 480);
+
+        Rotation r;
+        CHECK(RotationFromDegrees(90, r) && r == Rotation::Cw90);
+        CHECK(RotationFromDegrees(-90, r) && r == Rotation::Cw270);
+        CHECK(RotationFromDegrees(540, r) && r == Rotation::Cw180);
+        CHECK(RotationFromDegrees(0, r) && r == Rotation::None);
+        CHECK(!RotationFromDegrees(45, r));
+        CHECK(Orientation{}.IsIdentity() && !Orientation{ true }.IsIdentity());
+    }
+
+    void OrientAgainstReference()
+    {
+        std::mt19937 rng(5);
+        WorkerPool pool(4);
+        for (int iteration = 0; iteration < 150; ++iteration)
+        {
+            const uint32_t w = 1 + rng() % 70, h = 1 + rng() % 70;
+            const uint32_t pad = rng() % 3;
+            std::vector<uint32_t> src((size_t)(w + pad) * h);
+            for (auto& v : src)
+                v = rng();
+            std::vector<uint32_t> packed((size_t)w * h);
+            for (uint32_t y = 0; y < h; ++y)
+                for (uint32_t x = 0; x < w; ++x)
+                    packed[(size_t)y * w + x] = src[(size_t)y * (w + pad) + x];
+
+            for (int mirror = 0; mirror < 2; ++mirror)
+                for (Rotation rotation : kRotations)
+                {
+                    const Orientation o{ mirror == 1, rotation };
+                    const std::vector<uint32_t> ref = Reference(packed, w, h, o);
+                    uint32_t ow, oh;
+                    OrientedSize(w, h, o, ow, oh);
+                    for (int path = 0; path < 5; ++path)
+                    {
+                        std::vector<uint32_t> out(ref.size());
+                        const uint8_t* s = (const uint8_t*)src.data();
+                        if (path < 4)
+                            OrientBGRA(s, (w + pad) * 4, w, h, (uint8_t*)out.data(), ow * 4, o, kLevels[path]);
+                        else
+                            OrientBGRAParallel(s, (w + pad) * 4, w, h, (uint8_t*)out.data(), ow * 4, o, pool);
+                        CHECK_MSG(out == ref, "%ux%u mirror %d rotate %u path %d", w, h, mirror, (unsigned)rotation, path);
+                    }
+                }
+        }
+    }
+
+    void FusedEqualsSeparate()
+    {
+        std::mt19937 rng(6);
+        WorkerPool pool(4);
+        for (int iteration = 0; iteration < 60; ++iteration)
+        {
+            // Even sizes for the 4:2:x sources.
+            const uint32_t w = 2 + 2 * (rng() % 60), h = 2 + 2 * (rng() % 60);
+            std::vector<uint8_t> Y((size_t)w * h), UV((size_t)w * h / 2), packed((size_t)w * h * 2);
+            std::vector<uint32_t> bgra((size_t)w * h);
+            for (auto& v : Y)
+                v = (uint8_t)rng();
+            for (auto& v : UV)
+                v = (uint8_t)rng();
+            for (auto& v : packed)
+                v = (uint8_t)rng();
+            for (auto& v : bgra)
+                v = rng();
+            const uint32_t dw = 1 + rng() % 90, dh = 1 + rng() % 90;
+            Scaler scaler(w, h, dw, dh, ScaleFilter::Bilinear);
+
+            for (int mirror = 0; mirror < 2; ++mirror)
+                for (Rotation rotation : kRotations)
+                {
+                    const Orientation o{ mirror == 1, rotation };
+                    uint32_t ow, oh;
+                    OrientedSize(w, h, o, ow, oh);
+                    std::vector<uint32_t> plain((size_t)w * h), separate((size_t)ow * oh), fused(separate.size());
+
+                    ConvertNV12ToBGRA(Y.data(), w, UV.data(), w, w, h, (uint8_t*)plain.data(), w * 4);
+                    OrientBGRA((uint8_t*)plain.data(), w * 4, w, h, (uint8_t*)separate.data(), ow * 4, o);
+                    ConvertNV12ToBGRAParallel(Y.data(), w, UV.data(), w, w, h, (uint8_t*)fused.data(), ow * 4,
+                                              YuvColorimetry{}, o, pool);
+                    CHECK_MSG(fused == separate, "NV12 %ux%u mirror %d rotate %u", w, h, mirror, (unsigned)rotation);
+
+                    ConvertYUY2ToBGRA(packed.data(), w * 2, w, h, (uint8_t*)plain.data(), w * 4);
+                    OrientBGRA((uint8_t*)plain.data(), w * 4, w, h, (uint8_t*)separate.data(), ow * 4, o);
+                    ConvertYUY2ToBGRAParallel(packed.data(), w * 2, w, h, (uint8_t*)fused.data(), ow * 4,
+                                              YuvColorimetry{}, o, pool);
+                    CHECK_MSG(fused == separate, "YUY2 %ux%u mirror %d rotate %u", w, h, mirror, (unsigned)rotation);
+
+                    ConvertUYVYToBGRA(packed.data(), w * 2, w, h, (uint8_t*)plain.data(), w * 4);
+                    OrientBGRA((uint8_t*)plain.data(), w * 4, w, h, (uint8_t*)separate.data(), ow * 4, o);
+                    ConvertUYVYToBGRAParallel(packed.data(), w * 2, w, h, (uint8_t*)fused.data(), ow * 4,
+                                              YuvColorimetry{}, o, pool);
+                    CHECK_MSG(fused == separate, "UYVY %ux%u mirror %d rotate %u", w, h, mirror, (unsigned)rotation);
+
+                    uint32_t sw, sh;
+                    OrientedSize(dw, dh, o, sw, sh);
+                    std::vector<uint32_t> scaled((size_t)dw * dh), scaledSeparate((size_t)sw * sh),
+                        scaledFused(scaledSeparate.size());
+                    scaler.Scale((uint8_t*)bgra.data(), w * 4, (uint8_t*)scaled.data(), dw * 4, 4);
+                    OrientBGRA((uint8_t*)scaled.data(), dw * 4, dw, dh, (uint8_t*)scaledSeparate.data(), sw * 4, o);
+                    scaler.ScaleParallel((uint8_t*)bgra.data(), w * 4, (uint8_t*)scaledFused.data(), sw * 4, o, pool);
+                    CHECK_MSG(scaledFused == scaledSeparate, "scale %ux%u -> %ux%u mirror %d rotate %u",
+                              w, h, dw, dh, mirror, (unsigned)rotation);
+                }
+        }
+    }
+}
+
+int main()
+{
+    Sizes();
+    OrientAgainstReference();
+    FusedEqualsSeparate();
+    return Test::CheckResult();
+}
@@ -0,0 +1,114 @@
+// =============================================================================
+// ProducerDirectoryBench.cpp  --  Directory contention and discovery cost
+// =============================================================================
+// Register + deregister throughput with 1 .. 8 threads hammering one table
+// while a reader snapshots it continuously, then the cost of one discovery
+// pass: a directory snapshot holding 0 / 8 / 64 producers against the scan
+// it replaces, one named-mapping probe per process on the machine (on UNIX,
+// shm_open of a manifest name, almost always failing like OpenFileMappingW
+// on a PID without a producer).
+// =============================================================================
+
+#include "Bench.h"
+#include "ProducerDirectory.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace VirtuaCam;
+
+int main(int argc, char** argv)
+{
+    const bool quick = Test::QuickMode(argc, argv);
+    const std::string name = "vcam_bench_dir_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    SharedMemoryRegion::Remove(name);
+
+    const int operations = quick ? 2000 : 200000;
+    for (int threads : { 1, 2, 4, 8 })
+    {
+        std::atomic<bool> done = false;
+        std::atomic<long> snapshots = 0;
+        std::thread reader([&] {
+            ProducerDirectory directory;
+            directory.Open(name);
+            std::vector<ProducerDirectory::Entry> entries;
+            while (!done.load(std::memory_order_relaxed))
+            {
+                directory.Snapshot(entries);
+                snapshots.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        const double ms = Test::TimeMs(1, [&] {
+            std::vector<std::thread> writers;
+            for (int t = 0; t < threads; ++t)
+                writers.emplace_back([&, t] {
+                    ProducerDirectory directory;
+                    directory.Open(name);
+                    for (int i = 0; i < operations / threads; ++i)
+                    {
+                        ProducerDirectory::Entry entry;
+                        if (directory.Register(100 + t, entry))
+                            directory.Deregister(entry);
+                    }
+                });
+            for (auto& writer : writers)
+                writer.join();
+        });
+        done = true;
+        reader.join();
+        std::printf("%d writer thread%s + 1 reader  %8.0f ns per register + deregister  (%ld snapshots)\n", threads,
+                    threads > 1 ? "s" : " ", ms * 1e6 / operations, snapshots.load());
+    }
+
+    const int passes = quick ? 100 : 100000;
+    ProducerDirectory directory;
+    directory.Open(name);
+    std::vector<ProducerDirectory::Entry> registered, entries;
+    for (uint32_t producers : { 0u, 8u, 64u })
+    {
+        while (registered.size() < producers)
+        {
+            ProducerDirectory::Entry entry;
+            directory.Register(1000 + (uint32_t)registered.size(), entry);
+            registered.push_back(entry);
+        }
+        const double ms = Test::TimeMs(1, [&] {
+            for (int i = 0; i < passes; ++i)
+                directory.Snapshot(entries);
+        });
+        std::printf("directory snapshot, %2u producers  %10.0f ns per discovery pass\n", producers, ms * 1e6 / passes);
+    }
+    for (const auto& entry : registered)
+        directory.Deregister(entry);
+
+#if defined(__unix__)
+    const int scans = quick ? 2 : 200;
+    for (int processes : { 100, 400 })
+    {
+        const double ms = Test::TimeMs(1, [&] {
+            for (int i = 0; i < scans; ++i)
+                for (int pid = 1; pid <= processes; ++pid)
+                {
+                    const std::string probe = "/DirectPort_Producer_Manifest_" + std::to_string(1000000 + pid);
+                    const int fd = shm_open(probe.c_str(), O_RDONLY, 0);
+                    if (fd >= 0)
+                        close(fd);
+                }
+        });
+        std::printf("per-process probe, %3d processes %10.0f ns per discovery pass\n", processes, ms * 1e6 / scans);
+    }
+#endif
+
+    directory.Close();
+    SharedMemoryRegion::Remove(name);
+    return 0;
+}
@@ -0,0 +1,187 @@
+// =============================================================================
+// ProducerDirectoryTest.cpp  --  Shared-memory producer directory
+// =============================================================================
+// Runs on the POSIX shm backend: two instances on one region see each
+// other's registrations; a stale entry (the same PID registered again, or a
+// slot deregistered meanwhile) can neither be deregistered nor reclaimed; a
+// full table refuses; a region with a foreign header is refused.  Threads
+// registering and deregistering while another snapshots must never show a
+// PID twice or leave anything behind, and on UNIX a forked child that exits
+// without deregistering leaves an entry the parent can reclaim.
+// =============================================================================
+
+#include "Check.h"
+#include "ProducerDirectory.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace VirtuaCam;
+
+namespace
+{
+    using Entry = ProducerDirectory::Entry;
+
+    std::string UniqueName(const char* base)
+    {
+        return std::string(base) + "_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    }
+
+    void RegisterAndSnapshot(const std::string& name)
+    {
+        ProducerDirectory a, b;
+        CHECK(a.Open(name) && b.Open(name));
+        CHECK(a.ChangeCount() == 0);
+
+        Entry e1, e2;
+        CHECK(a.Register(100, e1) && b.Register(200, e2));
+        CHECK(e1.slot != e2.slot && e1.processId == 100 && e2.processId == 200);
+        std::vector<Entry> entries;
+        b.Snapshot(entries);
+        CHECK(entries.size() == 2);
+        CHECK(a.ChangeCount() == 2 && b.ChangeCount() == 2);
+
+        // PID 100 registers again (a restarted process with a recycled PID):
+        // it takes over its old slot with a new generation, so the old entry
+        // is stale and reclaiming it must fail.
+        Entry again;
+        CHECK(a.Register(100, again));
+        CHECK(again.slot == e1.slot && again.generation == e1.generation + 1);
+        CHECK(!b.Reclaim(e1));
+        CHECK(a.Deregister(again));
+        CHECK(!a.Deregister(again));
+        b.Snapshot(entries);
+        CHECK(entries.size() == 1 && entries[0].processId == 200 && entries[0].word == e2.word);
+        CHECK(b.Deregister(e2));
+
+        // PID 0 is refused; a closed directory refuses everything.
+        Entry e;
+        CHECK(!a.Register(0, e));
+        ProducerDirectory closed;
+        CHECK(!closed.Register(1, e) && closed.ChangeCount() == 0);
+
+        // Full table.
+        for (uint32_t i = 1; i <= ProducerDirectory::kMaxProducers; ++i)
+            CHECK(a.Register(1000 + i, e));
+        CHECK(!a.Register(5000, e));
+        a.Snapshot(entries);
+        CHECK(entries.size() == ProducerDirectory::kMaxProducers);
+        for (const Entry& entry : entries)
+            CHECK(a.Deregister(entry));
+        b.Snapshot(entries);
+        CHECK(entries.empty());
+    }
+
+    void ForeignHeader()
+    {
+        const std::string name = UniqueName("vcam_test_dir_foreign");
+        SharedMemoryRegion::Remove(name);
+        {
+            SharedMemoryRegion region;
+            CHECK(region.Open(name, ProducerDirectory::kRegionBytes));
+            const uint64_t other = 0x0000000144504356ull;     // right magic, version 1
+            std::memcpy(region.Data(), &other, sizeof(other));
+            ProducerDirectory directory;
+            CHECK(!directory.Open(name) && !directory.IsOpen());
+        }
+        SharedMemoryRegion::Remove(name);
+    }
+
+    void Contention(const std::string& name)
+    {
+        const int threads = 8, iterations = 20000;
+        std::atomic<bool> done = false;
+        std::atomic<int> failures = 0, duplicates = 0;
+        std::vector<std::thread> writers;
+        for (int t = 0; t < threads; ++t)
+            writers.emplace_back([&, t] {
+                ProducerDirectory directory;
+                if (!directory.Open(name))
+                {
+                    ++failures;
+                    return;
+                }
+                for (int i = 0; i < iterations; ++i)
+                {
+                    Entry entry;
+                    if (!directory.Register(10 + t, entry) || !directory.Deregister(entry))
+                        ++failures;
+                }
+            });
+        std::thread reader([&] {
+            ProducerDirectory directory;
+            directory.Open(name);
+            std::vector<Entry> entries;
+            while (!done.load())
+            {
+                directory.Snapshot(entries);
+                std::set<uint32_t> seen;
+                for (const Entry& entry : entries)
+                    duplicates += !seen.insert(entry.processId).second;
+            }
+        });
+        for (auto& writer : writers)
+            writer.join();
+        done = true;
+        reader.join();
+        CHECK_MSG(failures == 0 && duplicates == 0, "%d failed operations, %d duplicate PIDs", failures.load(),
+                  duplicates.load());
+
+        ProducerDirectory directory;
+        directory.Open(name);
+        std::vector<Entry> entries;
+        directory.Snapshot(entries);
+        CHECK(entries.empty());
+    }
+
+    void CrossProcess(const std::string& name)
+    {
+#if defined(__unix__)
+        // The child registers and exits without deregistering, like a crash.
+        const pid_t child = fork();
+        if (child == 0)
+        {
+            ProducerDirectory directory;
+            Entry entry;
+            const bool ok = directory.Open(name) && directory.Register((uint32_t)getpid(), entry);
+            _exit(ok ? 0 : 1);
+        }
+        int status = 0;
+        CHECK(child > 0 && waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+        ProducerDirectory directory;
+        CHECK(directory.Open(name));
+        std::vector<Entry> entries;
+        directory.Snapshot(entries);
+        if (CHECK(entries.size() == 1 && entries[0].processId == (uint32_t)child))
+        {
+            CHECK(directory.Reclaim(entries[0]));
+            directory.Snapshot(entries);
+            CHECK(entries.empty());
+        }
+#else
+        (void)name;
+#endif
+    }
+}
+
+int main()
+{
+    const std::string name = UniqueName("vcam_test_dir");
+    SharedMemoryRegion::Remove(name);
+    RegisterAndSnapshot(name);
+    ForeignHeader();
+    Contention(name);
+    CrossProcess(name);
+    SharedMemoryRegion::Remove(name);
+    return Test::CheckResult();
+}
@@ -0,0 +1,318 @@
+// =============================================================================
+// ProducerNotifyTest.cpp  --  Producer arrival / departure notifications
+// =============================================================================
+// The POSIX stand-in for the Windows events: NamedEvent on named semaphores
+// and the directory's change sequence with per-subscriber wake events.  A
+// subscriber blocked in WaitForChange() must wake promptly when another
+// process registers, deregisters or has its slot reclaimed after being
+// killed, must time out when nothing changes, and must return on Wake().
+// Subscriber slots are bounded and reusable, and a notifier that cannot
+// open a live subscriber's event (here: out of file descriptors) skips it
+// instead of reclaiming its slot.  Readers that open the
+// directory without creating it (discovery read-write, the Frame Server
+// read-only) fail while it is missing, leave nothing behind, and then follow
+// the change count; read-only ones cannot write.  The manifest's liveness
+// fields (processId, stopped) are only trusted within the manifest's size.
+// =============================================================================
+
+#include "Check.h"
+#include "Manifest.h"
+#include "NamedEvent.h"
+#include "ProducerDirectory.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__)
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace VirtuaCam;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::string UniqueName(const char* base)
+    {
+        return std::string(base) + "_" + std::to_string(Clock::now().time_since_epoch().count());
+    }
+
+    double MsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Waits for the count to move from 'seen', tolerating the stale wake-ups
+    // the semaphore backend allows.
+    bool WaitMoved(ProducerDirectory& directory, uint64_t seen, uint32_t timeoutMs)
+    {
+        const auto start = Clock::now();
+        while (MsSince(start) < timeoutMs)
+            if (directory.WaitForChange(seen, timeoutMs))
+                return true;
+        return false;
+    }
+
+    void Events()
+    {
+        const std::string name = UniqueName("vcam_test_event");
+        NamedEvent waiter, signaller;
+        CHECK(!signaller.Open(name));
+        CHECK(waiter.Create(name) && signaller.Open(name));
+        CHECK(!waiter.Wait(10));
+
+        // A signal with nobody waiting is kept for the next Wait().
+        signaller.Signal();
+        CHECK(waiter.Wait(0));
+        CHECK(!waiter.Wait(0));
+
+        std::thread later([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            signaller.Signal();
+        });
+        const auto start = Clock::now();
+        CHECK(waiter.Wait(5000));
+        CHECK_MSG(MsSince(start) < 1000, "woke after %.1f ms", MsSince(start));
+        later.join();
+
+        // The creator's Close() removes the name.
+        waiter.Close();
+        signaller.Close();
+        CHECK(!signaller.Open(name));
+    }
+
+    void Subscriptions(const std::string& name)
+    {
+        ProducerDirectory subscriber;
+        CHECK(subscriber.Open(name) && subscriber.Subscribe() && subscriber.IsSubscribed());
+        uint64_t seen = subscriber.ChangeCount();
+        CHECK(!subscriber.WaitForChange(seen, 20));
+
+        // Another instance's registration wakes the subscriber.
+        ProducerDirectory producer;
+        producer.Open(name);
+        std::thread arrive([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            ProducerDirectory::Entry entry;
+            producer.Register(4242, entry);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            producer.Deregister(entry);
+        });
+        CHECK(WaitMoved(subscriber, seen, 5000));
+        seen = subscriber.ChangeCount();
+        std::vector<ProducerDirectory::Entry> entries;
+        subscriber.Snapshot(entries);
+        CHECK(entries.size() == 1 || subscriber.ChangeCount() != seen);     // unless already gone again
+        CHECK(WaitMoved(subscriber, seen, 5000));
+        arrive.join();
+        seen = subscriber.ChangeCount();
+        subscriber.Snapshot(entries);
+        CHECK(entries.empty());
+
+        // Wake() cancels a blocked wait without a change.  First drain the
+        // wake-ups the changes above left (semaphores count them).
+        for (int i = 0; i < 4; ++i)
+            subscriber.WaitForChange(seen, 0);
+        bool changed = true;
+        const auto start = Clock::now();
+        std::thread waiter([&] { changed = subscriber.WaitForChange(seen); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        subscriber.Wake();
+        waiter.join();
+        CHECK_MSG(!changed && MsSince(start) >= 15, "returned %d after %.1f ms", changed, MsSince(start));
+
+        // Subscriber slots are bounded and come back when released.
+        std::vector<std::unique_ptr<ProducerDirectory>> others;
+        uint32_t subscribed = 0;
+        for (uint32_t i = 0; i < ProducerDirectory::kMaxSubscribers + 4; ++i)
+        {
+            others.push_back(std::make_unique<ProducerDirectory>());
+            others.back()->Open(name);
+            subscribed += others.back()->Subscribe();
+        }
+        CHECK_MSG(subscribed == ProducerDirectory::kMaxSubscribers - 1, "%u extra subscribers", subscribed);
+        others.clear();
+        ProducerDirectory again;
+        again.Open(name);
+        CHECK(again.Subscribe());
+    }
+
+    void OtherProcesses(const std::string& name)
+    {
+#if defined(__unix__)
+        ProducerDirectory subscriber;
+        subscriber.Open(name);
+        subscriber.Subscribe();
+        uint64_t seen = subscriber.ChangeCount();
+
+        // A child process registers after a moment and then hangs, like a
+        // producer that is killed later.
+        const pid_t child = fork();
+        if (child == 0)
+        {
+            ProducerDirectory directory;
+            ProducerDirectory::Entry entry;
+            usleep(20000);
+            if (!directory.Open(name) || !directory.Register((uint32_t)getpid(), entry))
+                _exit(1);
+            for (;;)
+                pause();
+        }
+        const auto start = Clock::now();
+        CHECK(WaitMoved(subscriber, seen, 5000));
+        CHECK_MSG(MsSince(start) < 2000, "arrival seen after %.1f ms", MsSince(start));
+        seen = subscriber.ChangeCount();
+        std::vector<ProducerDirectory::Entry> entries;
+        subscriber.Snapshot(entries);
+        CHECK(entries.size() == 1 && entries[0].processId == (uint32_t)child);
+
+        // The watcher sees the process die (the Windows build waits on its
+        // handle) and reclaims the slot, which notifies every subscriber.
+        kill(child, SIGKILL);
+        waitpid(child, nullptr, 0);
+        ProducerDirectory watcher;
+        watcher.Open(name);
+        if (CHECK(entries.size() == 1))
+            CHECK(watcher.Reclaim(entries[0]));
+        CHECK(WaitMoved(subscriber, seen, 5000));
+        subscriber.Snapshot(entries);
+        CHECK(entries.empty());
+#else
+        (void)name;
+#endif
+    }
+
+    void NotifierOutOfHandles(const std::string& name)
+    {
+#if defined(__unix__)
+        ProducerDirectory subscriber;
+        CHECK(subscriber.Open(name) && subscriber.Subscribe());
+        const uint64_t before = subscriber.ChangeCount();
+
+        // The child uses up its descriptors, so sem_open() fails with EMFILE
+        // for every subscriber's event while it notifies.
+        const pid_t child = fork();
+        if (child == 0)
+        {
+            ProducerDirectory notifier;
+            if (!notifier.Open(name))
+                _exit(1);
+            rlimit limit = {};
+            getrlimit(RLIMIT_NOFILE, &limit);
+            limit.rlim_cur = std::min<rlim_t>(limit.rlim_cur, 256);
+            setrlimit(RLIMIT_NOFILE, &limit);
+            while (open("/dev/null", O_RDONLY) >= 0)
+            {
+            }
+            if (errno != EMFILE)
+                _exit(2);
+            notifier.Notify();
+            _exit(0);
+        }
+        int status = 0;
+        CHECK(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        CHECK(subscriber.ChangeCount() != before);
+
+        // Still subscribed: the next notification wakes it at once rather
+        // than after the timeout.
+        uint64_t seen = subscriber.ChangeCount();
+        for (int i = 0; i < 4; ++i)
+            subscriber.WaitForChange(seen, 0);
+        ProducerDirectory notifier;
+        notifier.Open(name);
+        std::thread later([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            notifier.Notify();
+        });
+        const auto start = Clock::now();
+        CHECK(subscriber.WaitForChange(seen, 5000));
+        CHECK_MSG(MsSince(start) < 1000, "woke after %.1f ms", MsSince(start));
+        later.join();
+#else
+        (void)name;
+#endif
+    }
+
+    void Readers(const std::string& name)
+    {
+        using Access = ProducerDirectory::Access;
+        SharedMemoryRegion::Remove(name);
+        ProducerDirectory reader, watcher;
+        CHECK(!reader.Open(name, Access::ReadOnly) && !watcher.Open(name, Access::OpenExisting));
+#if defined(__unix__)
+        const int fd = shm_open(("/" + name).c_str(), O_RDONLY, 0);        // the failed opens created nothing
+        CHECK(fd < 0);
+        if (fd >= 0)
+            close(fd);
+#endif
+
+        // Too short to be the directory: not opened, and not grown either.
+        SharedMemoryRegion shorter;
+        CHECK(shorter.Open(name, 64));
+        CHECK(!watcher.Open(name, Access::OpenExisting));
+        shorter.Close();
+        SharedMemoryRegion::Remove(name);
+
+        ProducerDirectory producer;
+        ProducerDirectory::Entry entry;
+        CHECK(producer.Open(name));
+        CHECK(reader.Open(name, Access::ReadOnly) && reader.IsReadOnly());
+        CHECK(watcher.Open(name, Access::OpenExisting) && !watcher.IsReadOnly());
+        const uint64_t seen = reader.ChangeCount();
+        CHECK(producer.Register(4242, entry) && reader.ChangeCount() != seen);
+        std::vector<ProducerDirectory::Entry> entries;
+        reader.Snapshot(entries);
+        CHECK(entries.size() == 1 && entries[0].processId == 4242);
+
+        // Read-only: every write is refused.
+        ProducerDirectory::Entry other;
+        const uint64_t count = reader.ChangeCount();
+        reader.Notify();
+        CHECK(!reader.Register(4343, other) && !reader.Reclaim(entry) && !reader.Subscribe());
+        CHECK(reader.ChangeCount() == count);
+
+        // Discovery's mode reclaims and subscribes.
+        CHECK(watcher.Subscribe() && watcher.Reclaim(entry));
+        watcher.Snapshot(entries);
+        CHECK(entries.empty() && reader.ChangeCount() != count);
+    }
+
+    void Liveness()
+    {
+        auto manifest = std::make_unique<BroadcastManifestV2>();
+        std::memset((void*)manifest.get(), 0, sizeof(*manifest));
+        InitializeManifest(*manifest, 1280, 720, 87, {}, 10000000, u"texture", u"fence", 3, 1234);
+        CHECK(ManifestProcessId(*manifest) == 1234 && !ManifestStopped(*manifest));
+        MarkManifestStopped(*manifest);
+        CHECK(ManifestStopped(*manifest));
+
+        // A v2 producer from before the liveness fields: size stops short of them.
+        manifest->size = (uint32_t)kManifestV2RingSize;
+        CHECK(ManifestProcessId(*manifest) == 0 && !ManifestStopped(*manifest));
+    }
+}
+
+int main()
+{
+    const std::string name = UniqueName("vcam_test_notify");
+    SharedMemoryRegion::Remove(name);
+    Events();
+    Subscriptions(name);
+    OtherProcesses(name);
+    NotifierOutOfHandles(name);
+    Readers(name);
+    Liveness();
+    SharedMemoryRegion::Remove(name);
+    return Test::CheckResult();
+}
@@ -0,0 +1,54 @@
+// =============================================================================
+// ScalerBench.cpp  --  Resampling throughput per filter, plane type and tier
+// =============================================================================
+// 1080p -> 720p for each filter on BGRA, UV (2-channel) and grey planes, plus
+// the 2:1 box fast path, single-threaded.
+// =============================================================================
+
+#include "Bench.h"
+#include "Scaler.h"
+#include <cstdio>
+#include <vector>
+
+using namespace VirtuaCam;
+
+int main(int argc, char** argv)
+{
+    const int iterations = Test::QuickMode(argc, argv) ? 1 : 20;
+    const char* const filters[] = { "box", "bilinear", "lanczos3" };
+    struct Plane { const char* name; uint32_t channels, divisor; };
+    const Plane planes[] = { { "BGRA", 4, 1 }, { "UV", 2, 2 }, { "grey", 1, 1 } };
+
+    std::printf("ms/frame                      ");
+    for (int l = 0; l <= (int)GetSimdLevel(); ++l)
+        std::printf("%9s", SimdLevelName((SimdLevel)l));
+    std::printf("\n");
+
+    auto run = [&](const char* label, uint32_t sw, uint32_t sh, uint32_t dw, uint32_t dh, ScaleFilter filter,
+                   uint32_t channels) {
+        const Scaler scaler(sw, sh, dw, dh, filter);
+        std::vector<uint8_t> src((size_t)sw * sh * channels, 3), dst((size_t)dw * dh * channels);
+        std::printf("%-30s", label);
+        for (int l = 0; l <= (int)GetSimdLevel(); ++l)
+        {
+            const double ms = Test::TimeMs(iterations, [&] {
+                scaler.Scale(src.data(), sw * channels, dst.data(), dw * channels, channels, (SimdLevel)l);
+            });
+            std::printf("%9.3f", ms);
+        }
+        std::printf("\n");
+    };
+
+    for (const Plane& plane : planes)
+    {
+        for (int f = 0; f < 3; ++f)
+        {
+            char label[64];
+            std::snprintf(label, sizeof(label), "1080p->720p %-8s %s", filters[f], plane.name);
+            const uint32_t d = plane.divisor;
+            run(label, 1920 / d, 1080 / d, 1280 / d, 720 / d, (ScaleFilter)f, plane.channels);
+        }
+    }
+    run("1080p->540p 2:1 box BGRA", 1920, 1080, 960, 540, ScaleFilter::Box, 4);
+    return 0;
+}
@@ -0,0 +1,245 @@
+// =============================================================================
+// ScalerTest.cpp  --  Box / bilinear / Lanczos-3 resampling
+// =============================================================================
+// Golden images come from a double-precision resampler with the filter
+// definitions of Scaler.cpp (centre-aligned mapping, kernel widened by the
+// shrink factor, weights normalised per output sample); the fixed-point
+// kernels must be within 1 of it.  On top of that: hand-computed outputs,
+// SIMD tiers and ScaleParallel() bit-identical to the scalar kernel, exact
+// identity scaling, flat images staying flat and the 2:1 box fast path.
+// =============================================================================
+
+#include "Check.h"
+#include "Scaler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    const SimdLevel kLevels[] = { SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512 };
+    const char* const kFilterNames[] = { "box", "bilinear", "lanczos3" };
+
+    double Weight(ScaleFilter filter, double x)
+    {
+        switch (filter)
+        {
+        case ScaleFilter::Box:
+            return x > -0.5 && x <= 0.5 ? 1.0 : 0.0;
+        case ScaleFilter::Lanczos3:
+        {
+            if (x <= -3.0 || x >= 3.0)
+                return 0.0;
+            if (x == 0.0)
+                return 1.0;
+            const double pi = 3.14159265358979323846;
+            return std::sin(pi * x) / (pi * x) * std::sin(pi * x / 3) / (pi * x / 3);
+        }
+        default:
+            return std::max(0.0, 1.0 - std::fabs(x));
+        }
+    }
+
+    // Normalised weights of every output sample along one axis.
+    struct Taps {
+        std::vector<int> first;
+        std::vector<std::vector<double>> weights;
+    };
+
+    Taps ReferenceTaps(uint32_t src, uint32_t dst, ScaleFilter filter)
+    {
+        const double scale = double(src) / dst, filterScale = std::max(scale, 1.0);
+        const double support = (filter == ScaleFilter::Box ? 0.5 : filter == ScaleFilter::Lanczos3 ? 3.0 : 1.0) * filterScale;
+        Taps taps;
+        for (uint32_t i = 0; i < dst; ++i)
+        {
+            const double center = (i + 0.5) * scale;
+            const int lo = std::max(0, (int)std::floor(center - support + 0.5));
+            const int hi = std::min((int)src, (int)std::floor(center + support + 0.5));
+            std::vector<double> w;
+            double sum = 0;
+            for (int k = lo; k < hi; ++k)
+            {
+                w.push_back(Weight(filter, (k + 0.5 - center) / filterScale));
+                sum += w.back();
+            }
+            for (double& v : w)
+                v /= sum;
+            taps.first.push_back(lo);
+            taps.weights.push_back(w);
+        }
+        return taps;
+    }
+
+    std::vector<uint8_t> ReferenceScale(const std::vector<uint8_t>& src, uint32_t sw, uint32_t sh, uint32_t dw, uint32_t dh,
+                                        uint32_t channels, ScaleFilter filter)
+    {
+        const Taps horizontal = ReferenceTaps(sw, dw, filter), vertical = ReferenceTaps(sh, dh, filter);
+        std::vector<double> mid((size_t)dh * sw * channels, 0.0);
+        for (uint32_t y = 0; y < dh; ++y)
+            for (size_t k = 0; k < vertical.weights[y].size(); ++k)
+                for (uint32_t x = 0; x < sw * channels; ++x)
+                    mid[(size_t)y * sw * channels + x] += vertical.weights[y][k] * src[(size_t)(vertical.first[y] + k) * sw * channels + x];
+        std::vector<uint8_t> out((size_t)dw * dh * channels);
+        for (uint32_t y = 0; y < dh; ++y)
+        {
+            for (uint32_t x = 0; x < dw; ++x)
+            {
+                for (uint32_t c = 0; c < channels; ++c)
+                {
+                    double v = 0;
+                    for (size_t k = 0; k < horizontal.weights[x].size(); ++k)
+                        v += horizontal.weights[x][k] * mid[((size_t)y * sw + horizontal.first[x] + k) * channels + c];
+                    out[((size_t)y * dw + x) * channels + c] = (uint8_t)std::lround(std::clamp(v, 0.0, 255.0));
+                }
+            }
+        }
+        return out;
+    }
+
+    // Smooth content with some detail, so Lanczos stays within 8-bit range.
+    std::vector<uint8_t> TestImage(uint32_t w, uint32_t h, uint32_t channels)
+    {
+        std::vector<uint8_t> image((size_t)w * h * channels);
+        for (uint32_t y = 0; y < h; ++y)
+            for (uint32_t x = 0; x < w; ++x)
+                for (uint32_t c = 0; c < channels; ++c)
+                    image[((size_t)y * w + x) * channels + c] =
+                        (uint8_t)(128 + 90 * std::sin(x * 0.21 + c) * std::cos(y * 0.13 - c));
+        return image;
+    }
+
+    void GoldenImages()
+    {
+        struct Case { uint32_t sw, sh, dw, dh; };
+        const Case cases[] = { { 64, 48, 32, 24 }, { 100, 60, 37, 91 }, { 33, 17, 66, 34 }, { 240, 135, 160, 90 },
+                               { 5, 3, 40, 30 }, { 130, 66, 65, 33 } };
+        for (const Case& c : cases)
+        {
+            for (int f = 0; f < 3; ++f)
+            {
+                for (uint32_t channels : { 1u, 2u, 4u })
+                {
+                    const std::vector<uint8_t> src = TestImage(c.sw, c.sh, channels);
+                    const std::vector<uint8_t> golden = ReferenceScale(src, c.sw, c.sh, c.dw, c.dh, channels, (ScaleFilter)f);
+                    std::vector<uint8_t> out(golden.size());
+                    Scaler scaler(c.sw, c.sh, c.dw, c.dh, (ScaleFilter)f);
+                    scaler.Scale(src.data(), c.sw * channels, out.data(), c.dw * channels, channels);
+                    int worst = 0;
+                    for (size_t i = 0; i < out.size(); ++i)
+                        worst = std::max(worst, std::abs(out[i] - golden[i]));
+                    CHECK_MSG(worst <= 1, "%ux%u -> %ux%u %s %u channels: off by %d", c.sw, c.sh, c.dw, c.dh,
+                              kFilterNames[f], channels, worst);
+                }
+            }
+        }
+    }
+
+    void HandComputed()
+    {
+        const uint8_t ramp[4] = { 0, 64, 128, 192 };
+        uint8_t half[2];
+        Scaler(4, 1, 2, 1, ScaleFilter::Box).Scale(ramp, 4, half, 2, 1);
+        CHECK(half[0] == 32 && half[1] == 160);
+
+        // Bilinear 2 -> 4: samples at 0.25, 0.75, 1.25, 1.75 of [0, 255].
+        const uint8_t edge[2] = { 0, 255 };
+        uint8_t wide[4];
+        Scaler(2, 1, 4, 1, ScaleFilter::Bilinear).Scale(edge, 2, wide, 4, 1);
+        CHECK(wide[0] == 0 && wide[1] == 64 && wide[2] == 191 && wide[3] == 255);
+
+        // Box enlarging is nearest neighbour.
+        Scaler(2, 1, 4, 1, ScaleFilter::Box).Scale(edge, 2, wide, 4, 1);
+        CHECK(wide[0] == 0 && wide[1] == 0 && wide[2] == 255 && wide[3] == 255);
+    }
+
+    void SimdAndParallel()
+    {
+        std::mt19937 rng(5);
+        struct Case { uint32_t sw, sh, dw, dh; };
+        const Case cases[] = { { 1, 1, 1, 1 }, { 2, 2, 1, 1 }, { 7, 5, 3, 9 }, { 64, 48, 32, 24 }, { 100, 60, 37, 91 },
+                               { 33, 17, 66, 34 }, { 240, 135, 160, 90 }, { 5, 3, 40, 30 }, { 200, 10, 3, 2 },
+                               { 16, 16, 16, 16 }, { 130, 66, 65, 33 } };
+        WorkerPool pool(4);
+        for (const Case& c : cases)
+        {
+            for (int f = 0; f < 3; ++f)
+            {
+                for (uint32_t channels : { 1u, 2u, 4u })
+                {
+                    const Scaler scaler(c.sw, c.sh, c.dw, c.dh, (ScaleFilter)f);
+                    const ptrdiff_t srcStride = c.sw * channels + 5, dstStride = c.dw * channels + 3;
+                    std::vector<uint8_t> src(srcStride * c.sh);
+                    for (auto& b : src)
+                        b = (uint8_t)rng();
+                    std::vector<uint8_t> reference(dstStride * c.dh, 0xCD), out;
+                    scaler.Scale(src.data(), srcStride, reference.data(), dstStride, channels, SimdLevel::Scalar);
+                    for (SimdLevel level : kLevels)
+                    {
+                        out.assign(reference.size(), 0xCD);
+                        scaler.Scale(src.data(), srcStride, out.data(), dstStride, channels, level);
+                        CHECK_MSG(out == reference, "%ux%u -> %ux%u %s %u channels %s", c.sw, c.sh, c.dw, c.dh,
+                                  kFilterNames[f], channels, SimdLevelName(level));
+                    }
+                    out.assign(reference.size(), 0xCD);
+                    scaler.ScaleParallel(src.data(), srcStride, out.data(), dstStride, channels, pool);
+                    CHECK_MSG(out == reference, "%ux%u -> %ux%u %s parallel", c.sw, c.sh, c.dw, c.dh, kFilterNames[f]);
+
+                    if (c.sw == c.dw && c.sh == c.dh)
+                    {
+                        bool identical = true;
+                        for (uint32_t y = 0; y < c.dh; ++y)
+                            identical &= std::equal(src.begin() + y * srcStride, src.begin() + y * srcStride + c.dw * channels,
+                                                    reference.begin() + y * dstStride);
+                        CHECK_MSG(identical, "identity %s %u channels", kFilterNames[f], channels);
+                    }
+                }
+            }
+        }
+    }
+
+    void FlatStaysFlat()
+    {
+        for (int f = 0; f < 3; ++f)
+        {
+            const Scaler scaler(97, 55, 41, 130, (ScaleFilter)f);
+            std::vector<uint8_t> src(97 * 4 * 55, 77), out(41 * 4 * 130);
+            scaler.Scale(src.data(), 97 * 4, out.data(), 41 * 4, 4);
+            CHECK_MSG(std::all_of(out.begin(), out.end(), [](uint8_t v) { return v == 77; }), "%s", kFilterNames[f]);
+        }
+    }
+
+    void Halving()
+    {
+        std::mt19937 rng(9);
+        const uint32_t w = 130, h = 66;
+        std::vector<uint8_t> src(w * 4 * h), out(w / 2 * 4 * h / 2);
+        for (auto& b : src)
+            b = (uint8_t)rng();
+        Scaler(w, h, w / 2, h / 2, ScaleFilter::Box).Scale(src.data(), w * 4, out.data(), w * 2, 4);
+        bool exact = true;
+        for (uint32_t y = 0; y < h / 2; ++y)
+        {
+            for (uint32_t x = 0; x < w / 2 * 4; ++x)
+            {
+                const uint8_t* p = &src[(2 * y) * w * 4 + (x / 4) * 8 + x % 4];
+                exact &= out[y * w * 2 + x] == (p[0] + p[4] + p[w * 4] + p[w * 4 + 4] + 2) / 4;
+            }
+        }
+        CHECK(exact);
+    }
+}
+
+int main()
+{
+    GoldenImages();
+    HandComputed();
+    SimdAndParallel();
+    FlatStaysFlat();
+    Halving();
+    return Test::CheckResult();
+}
@@ -0,0 +1,329 @@
+// =============================================================================
+// TextureRingTest.cpp  --  Shared texture ring slot accounting
+// =============================================================================
+// Protocol: slot counts are clamped, an empty ring refuses both sides, the
+// writer never claims the latest slot or a pinned one, AbortWrite() leaves no
+// frame behind, a moved reader keeps its pins.  A pin the next Acquire()
+// retires keeps the writer off its slot until ReleaseRetired() (the reader's
+// GPU copy is done), and a reader with every retired slot in use stops
+// acquiring until then.  A reader that dies holding a pin stalls the writer
+// for exactly kStallLimit frames, and its late Release() does not touch the
+// rewritten slot.
+//
+// Stress: "textures" are arrays of words in the shared state, written word
+// by word (with yields) between BeginWrite() and EndWrite().  Readers copy
+// the slot they pinned twice and check every word still holds their frame
+// (the writer never touched it), release retired pins only after that, and
+// check that frames never go backwards and that no pins are left at the end;
+// for 2, 3 and 4 slots with 3 reader threads, and with the writer in a
+// forked process through POSIX shm.
+// =============================================================================
+
+#include "Check.h"
+#include "SharedMemory.h"
+#include "TextureRing.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace VirtuaCam;
+
+namespace
+{
+    constexpr int kWords = 64;
+    constexpr uint64_t kFrames = 100000;
+
+    struct Shared
+    {
+        TextureRingState ring;
+        std::atomic<uint64_t> texture[kMaxRingSlots][kWords];
+        std::atomic<int> stop;
+    };
+
+    uint32_t Pins(const TextureRingState& ring, uint32_t slot) { return (uint32_t)((ring.slots[slot].load() >> 48) & 0x7FFF); }
+
+    uint64_t Writer(Shared& shared, uint64_t frames)
+    {
+        TextureRingWriter writer;
+        writer.Attach(&shared.ring);
+        uint64_t published = 0;
+        for (uint64_t frame = 1; frame <= frames; ++frame)
+        {
+            const int slot = writer.BeginWrite();
+            if (slot < 0)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            for (int i = 0; i < kWords; ++i)
+            {
+                shared.texture[slot][i].store(frame, std::memory_order_relaxed);
+                if ((i & 15) == 15)
+                    std::this_thread::yield();
+            }
+            writer.EndWrite(frame);
+            ++published;
+        }
+        return published;
+    }
+
+    struct ReaderResult
+    {
+        uint64_t acquires = 0, torn = 0, backwards = 0;
+    };
+
+    ReaderResult Reader(Shared& shared, unsigned seed)
+    {
+        TextureRingReader reader;
+        reader.Attach(&shared.ring);
+        std::mt19937 rng(seed);
+        ReaderResult result;
+        uint64_t last = 0;
+        while (!shared.stop.load())
+        {
+            uint32_t slot;
+            uint64_t frame;
+            if (!reader.Acquire(slot, frame))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            ++result.acquires;
+            result.backwards += frame < last;
+            last = frame;
+            // "Copy" the slot twice with a gap: it must hold the frame throughout.
+            for (int pass = 0; pass < 2; ++pass)
+            {
+                for (int i = 0; i < kWords; ++i)
+                    if (shared.texture[slot][i].load(std::memory_order_relaxed) != frame)
+                    {
+                        ++result.torn;
+                        break;
+                    }
+                if (rng() & 1)
+                    std::this_thread::yield();
+            }
+            // The copies out of the slots retired so far have completed.
+            reader.ReleaseRetired();
+        }
+        return result;
+    }
+
+    void Protocol()
+    {
+        auto shared = std::make_unique<Shared>();
+        TextureRingState& ring = shared->ring;
+        InitializeRing(ring, 1);
+        CHECK(RingSlotCount(ring) == kMinRingSlots);
+        InitializeRing(ring, 9);
+        CHECK(RingSlotCount(ring) == kMaxRingSlots);
+        ring.slotCount.store(0);
+        CHECK(RingSlotCount(ring) == 0);
+
+        TextureRingWriter writer;
+        TextureRingReader reader;
+        uint32_t slot;
+        uint64_t frame;
+        writer.Attach(&ring);
+        reader.Attach(&ring);
+        CHECK(writer.BeginWrite() < 0 && !reader.Acquire(slot, frame));     // no ring
+
+        InitializeRing(ring, 3);
+        CHECK(!reader.Acquire(slot, frame));                                // nothing published
+        // The writer skips the latest slot (0 after initialisation) and goes round robin.
+        const int first = writer.BeginWrite();
+        CHECK(first == 1 && writer.BeginWrite() < 0);                       // one claim at a time
+        writer.EndWrite(1);
+        CHECK(reader.Acquire(slot, frame) && slot == 1 && frame == 1 && Pins(ring, 1) == 1);
+
+        const int second = writer.BeginWrite();
+        CHECK(second == 2);
+        writer.AbortWrite();
+        CHECK(ring.slots[2].load() == 0 && ring.latestSlot.load() == 1);
+        CHECK(writer.BeginWrite() == 0);                                    // skips 1: latest and pinned
+        writer.EndWrite(2);
+        CHECK(writer.BeginWrite() == 2);                                    // skips 1: pinned
+        writer.EndWrite(3);
+
+        // A moved reader keeps the pin.  Re-acquiring pins the latest frame
+        // and retires the old pin, which keeps its slot until released.
+        TextureRingReader moved = std::move(reader);
+        CHECK(Pins(ring, 1) == 1);
+        CHECK(moved.Acquire(slot, frame) && slot == 2 && frame == 3 && Pins(ring, 1) == 1 && Pins(ring, 2) == 1);
+        CHECK(moved.RetiredCount() == 1);
+        CHECK(writer.BeginWrite() == 0);                                    // 1 retired, 2 latest and pinned
+        writer.EndWrite(4);
+        CHECK(writer.BeginWrite() < 0);                                     // 0 latest, 1 and 2 pinned
+        moved.ReleaseRetired();
+        CHECK(Pins(ring, 1) == 0 && Pins(ring, 2) == 1 && moved.RetiredCount() == 0);
+        CHECK(writer.BeginWrite() == 1);
+        writer.EndWrite(5);
+
+        // Retired pins moved with the reader are still released.
+        CHECK(moved.Acquire(slot, frame) && slot == 1 && frame == 5);
+        TextureRingReader last = std::move(moved);
+        CHECK(last.RetiredCount() == 1 && moved.RetiredCount() == 0);
+        last.Release();
+        CHECK(Pins(ring, 0) == 0 && Pins(ring, 1) == 0 && Pins(ring, 2) == 0);
+    }
+
+    void RetiredLimit()
+    {
+        auto shared = std::make_unique<Shared>();
+        InitializeRing(shared->ring, kMaxRingSlots);
+        TextureRingWriter writer;
+        TextureRingReader reader;
+        writer.Attach(&shared->ring);
+        reader.Attach(&shared->ring);
+
+        // A reader whose copies never complete: one pin plus kMaxRingSlots
+        // retired, then Acquire() refuses and the writer stalls on it (the
+        // stall limit takes slots back from a reader that really is stuck).
+        uint32_t slot;
+        uint64_t frame = 0, published = 0;
+        bool acquired = true;
+        for (int i = 0; i < 3 * (int)kMaxRingSlots && acquired; ++i)
+        {
+            if (writer.BeginWrite() >= 0)
+                writer.EndWrite(++published);
+            acquired = reader.Acquire(slot, frame);
+        }
+        CHECK(!acquired && reader.RetiredCount() == kMaxRingSlots);
+        uint32_t pins = 0;
+        for (uint32_t i = 0; i < kMaxRingSlots; ++i)
+            pins += Pins(shared->ring, i);
+        CHECK_MSG(pins == kMaxRingSlots + 1, "%u pins", pins);
+
+        reader.ReleaseRetired();
+        CHECK(reader.RetiredCount() == 0 && Pins(shared->ring, slot) == 1);
+        if (writer.BeginWrite() >= 0)
+            writer.EndWrite(++published);
+        CHECK(reader.Acquire(slot, frame) && frame == published);
+    }
+
+    void DeadReader()
+    {
+        auto shared = std::make_unique<Shared>();
+        InitializeRing(shared->ring, 2);
+        TextureRingWriter writer;
+        writer.Attach(&shared->ring);
+        writer.BeginWrite();
+        writer.EndWrite(1);
+
+        // Pins frame 1 and never releases it (until much later).
+        auto dead = std::make_unique<TextureRingReader>();
+        dead->Attach(&shared->ring);
+        uint32_t slot;
+        uint64_t frame;
+        CHECK(dead->Acquire(slot, frame) && frame == 1);
+        CHECK(writer.BeginWrite() >= 0);
+        writer.EndWrite(2);
+
+        // Only the pinned slot is left besides the latest: frames are dropped
+        // until the writer takes it back.
+        uint32_t drops = 0;
+        while (writer.BeginWrite() < 0 && drops < 1000)
+            ++drops;
+        CHECK_MSG(drops == TextureRingWriter::kStallLimit - 1, "writer resumed after %u dropped frames", drops);
+        writer.EndWrite(3);
+
+        dead->Release();
+        CHECK(Pins(shared->ring, 0) == 0 && Pins(shared->ring, 1) == 0);
+        CHECK((shared->ring.slots[slot].load() & 0xFFFFFFFFFFFFull) == 3);  // the rewritten slot is untouched
+    }
+
+    void ThreadStress()
+    {
+        for (uint32_t slots : { 2u, 3u, 4u })
+        {
+            auto shared = std::make_unique<Shared>();
+            InitializeRing(shared->ring, slots);
+            std::vector<ReaderResult> results(3);
+            std::vector<std::thread> readers;
+            for (int i = 0; i < 3; ++i)
+                readers.emplace_back([&, i] { results[i] = Reader(*shared, 100 + i); });
+            const uint64_t published = Writer(*shared, kFrames);
+            shared->stop = 1;
+            for (auto& reader : readers)
+                reader.join();
+
+            ReaderResult total;
+            for (const auto& r : results)
+            {
+                total.acquires += r.acquires;
+                total.torn += r.torn;
+                total.backwards += r.backwards;
+            }
+            uint32_t pins = 0;
+            for (uint32_t i = 0; i < slots; ++i)
+                pins += Pins(shared->ring, i);
+            CHECK(published > 0 && total.acquires > 0);
+            CHECK_MSG(!total.torn && !total.backwards && !pins,
+                      "%u slots: %llu acquires, %llu torn, %llu backwards, %u pins left", slots,
+                      (unsigned long long)total.acquires, (unsigned long long)total.torn,
+                      (unsigned long long)total.backwards, pins);
+        }
+    }
+
+    void ProcessStress()
+    {
+#if defined(__unix__)
+        const std::string name = "vcam_test_ring_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+        SharedMemoryRegion::Remove(name);
+        SharedMemoryRegion region;
+        if (!CHECK(region.Open(name, sizeof(Shared))))
+            return;
+        auto* shared = static_cast<Shared*>(region.Data());
+        InitializeRing(shared->ring, 3);
+
+        const pid_t child = fork();
+        if (child == 0)
+        {
+            SharedMemoryRegion mapping;
+            if (!mapping.Open(name, sizeof(Shared)))
+                _exit(1);
+            auto* s = static_cast<Shared*>(mapping.Data());
+            Writer(*s, kFrames);
+            s->stop = 1;
+            _exit(0);
+        }
+        std::vector<ReaderResult> results(2);
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 2; ++i)
+            readers.emplace_back([&, i] { results[i] = Reader(*shared, 7 + i); });
+        for (auto& reader : readers)
+            reader.join();
+        int status = 0;
+        CHECK(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+        uint64_t torn = 0, backwards = 0;
+        for (const auto& r : results)
+        {
+            torn += r.torn;
+            backwards += r.backwards;
+        }
+        CHECK_MSG(!torn && !backwards, "%llu torn, %llu backwards", (unsigned long long)torn, (unsigned long long)backwards);
+        region.Close();
+        SharedMemoryRegion::Remove(name);
+#endif
+    }
+}
+
+int main()
+{
+    Protocol();
+    RetiredLimit();
+    DeadReader();
+    ThreadStress();
+    ProcessStress();
+    return Test::CheckResult();
+}
@@ -0,0 +1,65 @@
+// =============================================================================
+// WarpBench.cpp  --  Warp table build time and per-frame apply time
+// =============================================================================
+// At 720p, 1080p and 4K: building the remap table for keystone only and
+// keystone + lens + zoom (serial and band-parallel), its size against a pair
+// of float maps, and applying it to a BGRA frame per SIMD tier and in
+// parallel.
+// =============================================================================
+
+#include "Bench.h"
+#include "Warp.h"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+int main(int argc, char** argv)
+{
+    const int iterations = Test::QuickMode(argc, argv) ? 1 : 20;
+    const struct { uint32_t w, h; const char* name; } sizes[] = {
+        { 1280, 720, "720p" }, { 1920, 1080, "1080p" }, { 3840, 2160, "4K" },
+    };
+    std::mt19937 rng(3);
+    WorkerPool serial(1);
+
+    for (const auto& size : sizes)
+    {
+        WarpDesc keystone;
+        keystone.srcWidth = size.w;
+        keystone.srcHeight = size.h;
+        keystone.corners[0] = keystone.corners[6] = 0.08f;
+        WarpDesc full = keystone;
+        full.k1 = -0.15f;
+        full.k2 = 0.02f;
+        full.zoom = 1.1f;
+
+        Warp warp;
+        for (const WarpDesc* desc : { &keystone, &full })
+        {
+            const char* name = desc == &keystone ? "keystone" : "keystone + lens";
+            const double one = Test::TimeMs(iterations, [&] { warp.Configure(*desc, serial); });
+            const double parallel = Test::TimeMs(iterations, [&] { warp.Configure(*desc); });
+            std::printf("%-5s build %-16s %8.2f ms  parallel %8.2f ms\n", size.name, name, one, parallel);
+        }
+        std::printf("%-5s table %.1f MB (float maps %.1f MB)\n", size.name, warp.TableBytes() / 1048576.0,
+                    (double)size.w * size.h * 8 / 1048576.0);
+
+        std::vector<uint8_t> src((size_t)size.w * size.h * 4), dst(src.size());
+        for (auto& v : src)
+            v = (uint8_t)rng();
+        for (int l = 0; l <= (int)GetSimdLevel(); ++l)
+        {
+            const double ms = Test::TimeMs(iterations, [&] {
+                warp.Apply(src.data(), size.w * 4, dst.data(), size.w * 4, (SimdLevel)l);
+            });
+            std::printf("%-5s apply %-10s %8.3f ms\n", size.name, SimdLevelName((SimdLevel)l), ms);
+        }
+        const double ms = Test::TimeMs(iterations, [&] {
+            warp.ApplyParallel(src.data(), size.w * 4, dst.data(), size.w * 4);
+        });
+        std::printf("%-5s apply parallel   %8.3f ms\n", size.name, ms);
+    }
+    return 0;
+}
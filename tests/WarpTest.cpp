@@ -0,0 +1,293 @@
+// =============================================================================
+// WarpTest.cpp  --  Remap-table geometric correction
+// =============================================================================
+// The table is checked against the mapping in Warp.h evaluated from scratch
+// in doubles (zoom, a homography solved as an 8 x 8 linear system from the
+// four corners, the radial lens model) and a double bilinear sample of a
+// smooth source; pixels within a hair of the source border are skipped, as
+// rounding decides them.  Every SIMD tier and the parallel path must equal
+// scalar for random keystone / lens / zoom settings and padded strides, the
+// identity must be exact, and the table must hold 6 bytes per output pixel.
+// =============================================================================
+
+#include "Check.h"
+#include "Warp.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    const SimdLevel kLevels[] = { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512 };
+
+    // Homography taking the unit square's corners (0,0) (1,0) (1,1) (0,1) to
+    // 'corners', by Gaussian elimination: x = (a u + b v + c) / (g u + h v + 1).
+    void SolveHomography(const float* corners, double* m)
+    {
+        const double us[4] = { 0, 1, 1, 0 }, vs[4] = { 0, 0, 1, 1 };
+        double a[8][9] = {};
+        for (int i = 0; i < 4; ++i)
+        {
+            const double u = us[i], v = vs[i], x = corners[i * 2], y = corners[i * 2 + 1];
+            const double rowX[9] = { u, v, 1, 0, 0, 0, -u * x, -v * x, x };
+            const double rowY[9] = { 0, 0, 0, u, v, 1, -u * y, -v * y, y };
+            std::copy(rowX, rowX + 9, a[i * 2]);
+            std::copy(rowY, rowY + 9, a[i * 2 + 1]);
+        }
+        for (int c = 0; c < 8; ++c)
+        {
+            int pivot = c;
+            for (int r = c + 1; r < 8; ++r)
+                if (std::fabs(a[r][c]) > std::fabs(a[pivot][c]))
+                    pivot = r;
+            std::swap(a[c], a[pivot]);
+            for (int r = 0; r < 8; ++r)
+                if (r != c)
+                {
+                    const double f = a[r][c] / a[c][c];
+                    for (int k = c; k < 9; ++k)
+                        a[r][k] -= f * a[c][k];
+                }
+        }
+        for (int i = 0; i < 8; ++i)
+            m[i] = a[i][8] / a[i][i];
+    }
+
+    struct Reference
+    {
+        explicit Reference(const WarpDesc& desc) : d(desc)
+        {
+            if (!d.dstWidth)  d.dstWidth = d.srcWidth;
+            if (!d.dstHeight) d.dstHeight = d.srcHeight;
+            SolveHomography(d.corners, m);
+        }
+
+        // Source position of output pixel (x, y), pixel centres at integers.
+        void Map(uint32_t x, uint32_t y, double& sx, double& sy) const
+        {
+            const double u = 0.5 + ((x + 0.5) / d.dstWidth - 0.5) / d.zoom;
+            const double v = 0.5 + ((y + 0.5) / d.dstHeight - 0.5) / d.zoom;
+            const double w = m[6] * u + m[7] * v + 1.0;
+            const double px = ((m[0] * u + m[1] * v + m[2]) / w - 0.5) * d.srcWidth;
+            const double py = ((m[3] * u + m[4] * v + m[5]) / w - 0.5) * d.srcHeight;
+            const double halfDiagonal2 = (d.srcWidth * (double)d.srcWidth + d.srcHeight * (double)d.srcHeight) / 4.0;
+            const double r2 = (px * px + py * py) / halfDiagonal2;
+            const double scale = 1.0 + d.k1 * r2 + d.k2 * r2 * r2;
+            sx = px * scale + (d.srcWidth - 1) / 2.0;
+            sy = py * scale + (d.srcHeight - 1) / 2.0;
+        }
+
+        WarpDesc d;
+        double m[8];
+    };
+
+    // A smooth source, so the table's 1/64-pixel fractions cost well under a
+    // level: channels are slow sinusoids of x and y, alpha a ramp.
+    std::vector<uint8_t> SmoothSource(uint32_t w, uint32_t h, ptrdiff_t stride)
+    {
+        std::vector<uint8_t> src((size_t)stride * h);
+        for (uint32_t y = 0; y < h; ++y)
+            for (uint32_t x = 0; x < w; ++x)
+            {
+                uint8_t* p = &src[y * stride + x * 4];
+                p[0] = (uint8_t)std::lround(127.5 + 100 * std::sin(x * 0.05));
+                p[1] = (uint8_t)std::lround(127.5 + 100 * std::cos(y * 0.07));
+                p[2] = (uint8_t)std::lround(127.5 + 100 * std::sin((x + y) * 0.03));
+                p[3] = (uint8_t)(64 + (x + y) * 128 / (w + h));
+            }
+        return src;
+    }
+
+    void MatchesMapping()
+    {
+        std::mt19937 rng(19);
+        for (int trial = 0; trial < 30; ++trial)
+        {
+            WarpDesc desc;
+            desc.srcWidth = 64 + rng() % 400;
+            desc.srcHeight = 48 + rng() % 300;
+            desc.dstWidth = trial % 3 ? 32 + rng() % 300 : 0;
+            desc.dstHeight = trial % 3 ? 24 + rng() % 200 : 0;
+            for (float& c : desc.corners)
+                c += ((int)(rng() % 31) - 15) / 100.0f;
+            desc.k1 = ((int)(rng() % 41) - 20) / 100.0f;
+            desc.k2 = ((int)(rng() % 11) - 5) / 100.0f;
+            desc.zoom = 0.8f + (rng() % 50) / 100.0f;
+
+            Warp warp;
+            if (!CHECK(warp.Configure(desc)))
+                continue;
+            const Reference ref(desc);
+            const uint32_t sw = desc.srcWidth, sh = desc.srcHeight, dw = warp.DstWidth(), dh = warp.DstHeight();
+            CHECK(dw == ref.d.dstWidth && dh == ref.d.dstHeight);
+            CHECK(warp.TableBytes() == (size_t)dw * dh * 6);
+
+            const std::vector<uint8_t> src = SmoothSource(sw, sh, sw * 4);
+            std::vector<uint8_t> dst((size_t)dw * dh * 4);
+            warp.Apply(src.data(), sw * 4, dst.data(), dw * 4);
+
+            int failures = 0;
+            for (uint32_t y = 0; y < dh && failures < 3; ++y)
+                for (uint32_t x = 0; x < dw && failures < 3; ++x)
+                {
+                    double sx, sy;
+                    ref.Map(x, y, sx, sy);
+                    const double margin = std::min({ sx + 0.5, sw - 0.5 - sx, sy + 0.5, sh - 0.5 - sy });
+                    if (std::fabs(margin) < 1e-6)
+                        continue;
+                    const uint8_t* out = &dst[((size_t)y * dw + x) * 4];
+                    if (margin < 0)
+                    {
+                        failures += !CHECK_MSG(!out[0] && !out[1] && !out[2] && !out[3],
+                                               "trial %d (%u, %u) maps outside to (%.2f, %.2f)", trial, x, y, sx, sy);
+                        continue;
+                    }
+                    sx = std::clamp(sx, 0.0, sw - 1.0);
+                    sy = std::clamp(sy, 0.0, sh - 1.0);
+                    const uint32_t x0 = std::min((uint32_t)sx, sw - 2), y0 = std::min((uint32_t)sy, sh - 2);
+                    const double fx = sx - x0, fy = sy - y0;
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        auto at = [&](uint32_t px, uint32_t py) { return (double)src[((size_t)py * sw + px) * 4 + c]; };
+                        const double top = at(x0, y0) * (1 - fx) + at(x0 + 1, y0) * fx;
+                        const double bottom = at(x0, y0 + 1) * (1 - fx) + at(x0 + 1, y0 + 1) * fx;
+                        const int e = std::abs(out[c] - (int)std::lround(top * (1 - fy) + bottom * fy));
+                        failures += !CHECK_MSG(e <= 2, "trial %d (%u, %u) channel %d off by %d at (%.2f, %.2f)",
+                                               trial, x, y, c, e, sx, sy);
+                    }
+                }
+        }
+    }
+
+    void TiersAgree()
+    {
+        std::mt19937 rng(3);
+        WorkerPool pool(4);
+        for (int trial = 0; trial < 40; ++trial)
+        {
+            WarpDesc desc;
+            desc.srcWidth = 2 + rng() % 150;
+            desc.srcHeight = 2 + rng() % 90;
+            desc.dstWidth = 1 + rng() % 170;
+            desc.dstHeight = 1 + rng() % 70;
+            for (float& c : desc.corners)
+                c += ((int)(rng() % 41) - 20) / 100.0f;
+            desc.k1 = ((int)(rng() % 61) - 30) / 100.0f;
+            desc.k2 = ((int)(rng() % 21) - 10) / 100.0f;
+            desc.zoom = 0.8f + (rng() % 50) / 100.0f;
+            Warp warp;
+            if (!CHECK(warp.Configure(desc)))
+                continue;
+
+            const ptrdiff_t srcStride = desc.srcWidth * 4 + 12, dstStride = desc.dstWidth * 4 + 20;
+            std::vector<uint8_t> src(srcStride * desc.srcHeight);
+            for (auto& v : src)
+                v = (uint8_t)rng();
+            std::vector<uint8_t> ref(dstStride * desc.dstHeight, 0xCD), out(ref.size());
+            warp.Apply(src.data(), srcStride, ref.data(), dstStride, SimdLevel::Scalar);
+            for (uint32_t y = 0; y < desc.dstHeight; ++y)
+                CHECK_MSG(std::all_of(&ref[y * dstStride + desc.dstWidth * 4], &ref[(y + 1) * dstStride],
+                                      [](uint8_t v) { return v == 0xCD; }),
+                          "trial %d row %u: stride padding written", trial, y);
+            for (SimdLevel level : kLevels)
+            {
+                std::fill(out.begin(), out.end(), 0xCD);
+                warp.Apply(src.data(), srcStride, out.data(), dstStride, level);
+                CHECK_MSG(out == ref, "trial %d %s", trial, SimdLevelName(level));
+            }
+            std::fill(out.begin(), out.end(), 0xCD);
+            warp.ApplyParallel(src.data(), srcStride, out.data(), dstStride, pool);
+            CHECK_MSG(out == ref, "trial %d parallel", trial);
+        }
+    }
+
+    void Identity()
+    {
+        std::mt19937 rng(5);
+        WarpDesc desc;
+        desc.srcWidth = 333;
+        desc.srcHeight = 77;
+        CHECK(desc.IsIdentity());
+        Warp warp;
+        CHECK(warp.Configure(desc));
+        std::vector<uint8_t> src(333 * 77 * 4), out(src.size());
+        for (auto& v : src)
+            v = (uint8_t)rng();
+        for (SimdLevel level : kLevels)
+        {
+            warp.Apply(src.data(), 333 * 4, out.data(), 333 * 4, level);
+            CHECK_MSG(out == src, "identity %s", SimdLevelName(level));
+        }
+
+        WarpDesc zoomed = desc;
+        zoomed.zoom = 1.5f;
+        CHECK(!zoomed.IsIdentity());
+        WarpDesc lens = desc;
+        lens.k1 = -0.1f;
+        CHECK(!lens.IsIdentity());
+        WarpDesc sized = desc;
+        sized.dstWidth = 100;
+        CHECK(!sized.IsIdentity());
+    }
+
+    void Geometry()
+    {
+        // Keystone: the top edge spans the middle half of the source.
+        WarpDesc desc;
+        desc.srcWidth = desc.srcHeight = 256;
+        const float corners[8] = { 0.25f, 0.0f, 0.75f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f };
+        std::copy(corners, corners + 8, desc.corners);
+        Warp warp;
+        warp.Configure(desc);
+        std::vector<uint8_t> src(256 * 256 * 4), out(src.size());
+        for (uint32_t y = 0; y < 256; ++y)
+            for (uint32_t x = 0; x < 256; ++x)
+            {
+                uint8_t* p = &src[(y * 256 + x) * 4];
+                p[0] = (uint8_t)x;
+                p[1] = (uint8_t)y;
+                p[2] = 0;
+                p[3] = 255;
+            }
+        warp.Apply(src.data(), 1024, out.data(), 1024);
+        CHECK_MSG(std::abs(out[0] - 64) <= 1 && std::abs(out[255 * 4] - 191) <= 1, "top row %d .. %d", out[0],
+                  out[255 * 4]);
+        CHECK_MSG(out[255 * 1024] <= 1 && out[255 * 1024 + 255 * 4] >= 254, "bottom row %d .. %d", out[255 * 1024],
+                  out[255 * 1024 + 255 * 4]);
+
+        // Barrel correction (k1 < 0) pulls the corners in, so they sample
+        // inside the source; pincushion (k1 > 0) pushes them out.
+        WarpDesc lens;
+        lens.srcWidth = lens.srcHeight = 256;
+        lens.k1 = -0.2f;
+        warp.Configure(lens);
+        warp.Apply(src.data(), 1024, out.data(), 1024);
+        CHECK(out[3] == 255 && out[0] > 0 && out[1] > 0);
+        lens.k1 = 0.2f;
+        warp.Configure(lens);
+        warp.Apply(src.data(), 1024, out.data(), 1024);
+        CHECK(out[3] == 0 && out[128 * 1024 + 128 * 4 + 3] == 255);
+
+        // Rejected sizes leave the warp unconfigured.
+        WarpDesc tiny;
+        tiny.srcWidth = 1;
+        tiny.srcHeight = 10;
+        CHECK(!warp.Configure(tiny) && !warp.IsConfigured());
+        WarpDesc huge;
+        huge.srcWidth = 70000;
+        huge.srcHeight = 2;
+        CHECK(!warp.Configure(huge) && !warp.IsConfigured());
+    }
+}
+
+int main()
+{
+    MatchesMapping();
+    TiersAgree();
+    Identity();
+    Geometry();
+    return Test::CheckResult();
+}
@@ -0,0 +1,49 @@
+// =============================================================================
+// WorkerPoolBench.cpp  --  Band-parallel BGRA -> NV12 scaling over thread count
+// =============================================================================
+// 720p / 1080p / 4K at 1, 2, 4, ... threads up to the machine's logical
+// processor count (and at least 2, so --quick exercises the workers even on
+// a single-core runner).
+// =============================================================================
+
+#include "Bench.h"
+#include "ColorConvert.h"
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace VirtuaCam;
+
+int main(int argc, char** argv)
+{
+    const bool quick = Test::QuickMode(argc, argv);
+    const int iterations = quick ? 2 : 50;
+    const unsigned maxThreads = std::max(2u, std::thread::hardware_concurrency());
+    struct Size { const char* name; uint32_t width, height; };
+    const Size sizes[] = { { "720p", 1280, 720 }, { "1080p", 1920, 1080 }, { "4K", 3840, 2160 } };
+
+    std::vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    WorkerPool pool;
+    for (const Size& size : sizes)
+    {
+        const uint32_t w = size.width, h = size.height;
+        std::vector<uint8_t> src((size_t)w * h * 4, 77), dst((size_t)w * h * 3 / 2);
+        double single = 0;
+        for (unsigned threads : threadCounts)
+        {
+            pool.SetThreadCount(threads);
+            const double ms = Test::TimeMs(iterations, [&] {
+                ConvertBGRAToNV12Parallel(src.data(), w * 4, w, h, dst.data(), w, dst.data() + (size_t)w * h, w, {}, pool);
+            });
+            if (threads == 1)
+                single = ms;
+            std::printf("%-6s %2u threads %8.3f ms/frame  x%.2f\n", size.name, threads, ms, single / ms);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+// =============================================================================
+// WorkerPoolTest.cpp  --  Band splitting, fork/join, Submit and Shutdown
+// =============================================================================
+
+#include "Check.h"
+#include "ColorConvert.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    // Every row is covered exactly once, bands respect alignment / minRows
+    // and there are never more bands than threads.
+    void BandSplitting()
+    {
+        WorkerPool pool(4);
+        for (uint32_t rows : { 1u, 7u, 64u, 100u, 1081u, 2160u })
+        {
+            for (uint32_t alignment : { 1u, 2u, 16u })
+            {
+                for (uint32_t minRows : { 1u, 10u, WorkerPool::kMinBandRows })
+                {
+                    std::mutex lock;
+                    std::vector<std::pair<uint32_t, uint32_t>> bands;
+                    pool.ParallelBands(rows, alignment, minRows, [&](uint32_t begin, uint32_t end) {
+                        std::lock_guard<std::mutex> guard(lock);
+                        bands.emplace_back(begin, end);
+                    });
+                    std::sort(bands.begin(), bands.end());
+                    bool ok = !bands.empty() && bands.size() <= pool.GetThreadCount() && bands.front().first == 0 &&
+                              bands.back().second == rows;
+                    for (size_t i = 0; i < bands.size(); ++i)
+                    {
+                        ok &= bands[i].first < bands[i].second;
+                        if (i + 1 < bands.size())
+                            ok &= bands[i].second == bands[i + 1].first && bands[i].second % alignment == 0 &&
+                                  bands[i].second - bands[i].first >= minRows;
+                    }
+                    CHECK_MSG(ok, "rows %u alignment %u minRows %u: %zu bands", rows, alignment, minRows, bands.size());
+                }
+            }
+        }
+    }
+
+    // ParallelBands from inside a band runs (with less help) instead of
+    // deadlocking.
+    void Nested()
+    {
+        WorkerPool pool(3);
+        std::atomic<uint32_t> total{ 0 };
+        pool.ParallelBands(300, 1, 1, [&](uint32_t begin, uint32_t end) {
+            pool.ParallelBands(end - begin, 1, 1, [&](uint32_t b, uint32_t e) { total += e - b; });
+        });
+        CHECK(total == 300);
+    }
+
+    void ThreadCount()
+    {
+        WorkerPool pool(1);
+        CHECK(pool.GetThreadCount() == 1);
+        const std::thread::id caller = std::this_thread::get_id();
+        bool inline_ = true;
+        pool.ParallelBands(1000, 1, 1, [&](uint32_t, uint32_t) { inline_ &= std::this_thread::get_id() == caller; });
+        CHECK(inline_);
+
+        pool.SetThreadCount(5);
+        CHECK(pool.GetThreadCount() == 5);
+        pool.SetThreadCount(0);
+        CHECK(pool.GetThreadCount() == std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    // Submit() runs every task; after Shutdown() the next call restarts the
+    // workers, and Shutdown() of an idle pool is harmless.
+    void SubmitAndShutdown()
+    {
+        WorkerPool pool(4);
+        for (int round = 0; round < 50; ++round)
+        {
+            std::atomic<int> done{ 0 };
+            for (int i = 0; i < 8; ++i)
+                pool.Submit([&] { ++done; });
+            while (done < 8)
+                std::this_thread::yield();
+
+            std::atomic<uint32_t> rows{ 0 };
+            pool.ParallelBands(1000, 2, 10, [&](uint32_t begin, uint32_t end) { rows += end - begin; });
+            CHECK(rows == 1000);
+            if (round % 3 == 0)
+                pool.Shutdown();
+        }
+        pool.Shutdown();
+        pool.Shutdown();
+        CHECK(pool.GetThreadCount() == 4);
+
+        std::atomic<bool> ran{ false };
+        pool.Submit([&] { ran = true; });
+        while (!ran)
+            std::this_thread::yield();
+    }
+
+    // The band-parallel converter matches the single-threaded one for any
+    // size and thread count.
+    void ParallelConversion()
+    {
+        std::mt19937 rng(7);
+        WorkerPool pool(8);
+        for (int iteration = 0; iteration < 150; ++iteration)
+        {
+            const uint32_t w = 1 + rng() % 700, h = 1 + rng() % 700;
+            const ptrdiff_t srcStride = w * 4 + (rng() % 3) * 4, dstStride = w + (w & 1) + rng() % 5;
+            std::vector<uint8_t> src(srcStride * h);
+            for (auto& b : src)
+                b = (uint8_t)rng();
+            const size_t chromaRows = (h + 1) / 2;
+            std::vector<uint8_t> a(dstStride * (h + chromaRows), 0xCD), b(a.size(), 0xCD);
+            ConvertBGRAToNV12(src.data(), srcStride, w, h, a.data(), dstStride, a.data() + dstStride * h, dstStride);
+            pool.SetThreadCount(1 + rng() % 8);
+            ConvertBGRAToNV12Parallel(src.data(), srcStride, w, h, b.data(), dstStride, b.data() + dstStride * h,
+                                      dstStride, {}, pool);
+            CHECK_MSG(a == b, "%ux%u threads %u", w, h, pool.GetThreadCount());
+        }
+    }
+}
+
+int main()
+{
+    BandSplitting();
+    Nested();
+    ThreadCount();
+    SubmitAndShutdown();
+    ParallelConversion();
+    return Test::CheckResult();
+}
@@ -0,0 +1,181 @@
+// =============================================================================
+// YuvUnpackTest.cpp  --  NV12 / YUY2 / UYVY -> BGRA
+// =============================================================================
+// Against a floating-point reference image (the inverse matrices of
+// Colorimetry.h with nearest-neighbour chroma), for every colorimetry and a
+// range of odd and even sizes: the scalar kernel is within 1 of it, every
+// SIMD tier and the *Parallel variants match the scalar kernel exactly, and a
+// BGRA -> NV12 -> BGRA round trip of a chroma-flat image stays close.
+// =============================================================================
+
+#include "Check.h"
+#include "ColorConvert.h"
+#include "YuvUnpack.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace VirtuaCam;
+
+namespace
+{
+    const SimdLevel kLevels[] = { SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512 };
+
+    enum class Format { NV12, YUY2, UYVY };
+
+    // One BGRA pixel from Y / Cb / Cr.
+    void ReferencePixel(YuvColorimetry c, int y, int cb, int cr, uint8_t* bgra)
+    {
+        const double kr[] = { 0.299, 0.2126, 0.2627 }, kb[] = { 0.114, 0.0722, 0.0593 };
+        const double r0 = kr[(int)c.matrix], b0 = kb[(int)c.matrix], g0 = 1 - r0 - b0;
+        const bool limited = c.range == YuvRange::Limited;
+        const double luma = (y - (limited ? 16 : 0)) * (limited ? 255.0 / 219.0 : 1.0);
+        const double u = (cb - 128) * (limited ? 255.0 / 224.0 : 1.0), v = (cr - 128) * (limited ? 255.0 / 224.0 : 1.0);
+        const double rgb[3] = { luma + 2 * (1 - r0) * v,
+                                luma - 2 * (1 - b0) * b0 / g0 * u - 2 * (1 - r0) * r0 / g0 * v,
+                                luma + 2 * (1 - b0) * u };
+        for (int i = 0; i < 3; ++i)
+            bgra[2 - i] = (uint8_t)std::lround(std::clamp(rgb[i], 0.0, 255.0));
+        bgra[3] = 255;
+    }
+
+    struct Source {
+        uint32_t w, h, pairs;
+        std::vector<uint8_t> y, uv, packed;     // NV12 planes; YUY2 / UYVY
+    };
+
+    std::vector<uint8_t> Reference(const Source& s, Format format, YuvColorimetry c)
+    {
+        std::vector<uint8_t> out(s.w * s.h * 4);
+        for (uint32_t y = 0; y < s.h; ++y)
+        {
+            for (uint32_t x = 0; x < s.w; ++x)
+            {
+                int luma, cb, cr;
+                if (format == Format::NV12)
+                {
+                    luma = s.y[y * s.w + x];
+                    cb = s.uv[(y / 2) * s.pairs * 2 + (x / 2) * 2];
+                    cr = s.uv[(y / 2) * s.pairs * 2 + (x / 2) * 2 + 1];
+                }
+                else
+                {
+                    const uint8_t* pair = &s.packed[y * s.pairs * 4 + (x / 2) * 4];
+                    const bool yuy2 = format == Format::YUY2;
+                    luma = yuy2 ? pair[(x & 1) * 2] : pair[(x & 1) * 2 + 1];
+                    cb = yuy2 ? pair[1] : pair[0];
+                    cr = yuy2 ? pair[3] : pair[2];
+                }
+                ReferencePixel(c, luma, cb, cr, &out[(y * s.w + x) * 4]);
+            }
+        }
+        return out;
+    }
+
+    void Convert(const Source& s, Format format, YuvColorimetry c, SimdLevel level, bool parallel, WorkerPool& pool,
+                 std::vector<uint8_t>& out)
+    {
+        out.assign(s.w * s.h * 4, 0);
+        const ptrdiff_t nvStride = s.pairs * 2, packedStride = s.pairs * 4, dstStride = s.w * 4;
+        switch (format)
+        {
+        case Format::NV12:
+            if (parallel)
+                ConvertNV12ToBGRAParallel(s.y.data(), s.w, s.uv.data(), nvStride, s.w, s.h, out.data(), dstStride, c, pool);
+            else
+                ConvertNV12ToBGRA(s.y.data(), s.w, s.uv.data(), nvStride, s.w, s.h, out.data(), dstStride, c, level);
+            break;
+        case Format::YUY2:
+            if (parallel)
+                ConvertYUY2ToBGRAParallel(s.packed.data(), packedStride, s.w, s.h, out.data(), dstStride, c, pool);
+            else
+                ConvertYUY2ToBGRA(s.packed.data(), packedStride, s.w, s.h, out.data(), dstStride, c, level);
+            break;
+        case Format::UYVY:
+            if (parallel)
+                ConvertUYVYToBGRAParallel(s.packed.data(), packedStride, s.w, s.h, out.data(), dstStride, c, pool);
+            else
+                ConvertUYVYToBGRA(s.packed.data(), packedStride, s.w, s.h, out.data(), dstStride, c, level);
+            break;
+        }
+    }
+
+    int MaxDifference(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+    {
+        int worst = 0;
+        for (size_t i = 0; i < a.size(); ++i)
+            worst = std::max(worst, std::abs(a[i] - b[i]));
+        return worst;
+    }
+
+    void RoundTrip(YuvColorimetry c)
+    {
+        // Constant colour per 2x2 block, so 4:2:0 subsampling loses nothing.
+        const uint32_t w = 64, h = 64;
+        std::vector<uint8_t> src(w * h * 4), y(w * h), uv(w * h / 2), back;
+        for (uint32_t j = 0; j < h; ++j)
+        {
+            for (uint32_t i = 0; i < w; ++i)
+            {
+                uint8_t* p = &src[(j * w + i) * 4];
+                p[0] = (uint8_t)((i & ~1u) * 3 + 20);
+                p[1] = (uint8_t)((j & ~1u) * 3 + 10);
+                p[2] = (uint8_t)(200 - ((i & ~1u) + (j & ~1u)));
+                p[3] = 255;
+            }
+        }
+        ConvertBGRAToNV12(src.data(), w * 4, w, h, y.data(), w, uv.data(), w, c);
+        back.resize(src.size());
+        ConvertNV12ToBGRA(y.data(), w, uv.data(), w, w, h, back.data(), w * 4, c);
+        const int worst = MaxDifference(src, back);
+        CHECK_MSG(worst <= (c.range == YuvRange::Limited ? 3 : 2), "matrix %d range %d round trip off by %d",
+                  (int)c.matrix, (int)c.range, worst);
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(1);
+    WorkerPool pool(4);
+    for (int m = 0; m < 3; ++m)
+    {
+        for (int r = 0; r < 2; ++r)
+        {
+            const YuvColorimetry c = { (YuvMatrix)m, (YuvRange)r };
+            for (uint32_t w : { 1u, 2u, 7u, 8u, 15u, 16u, 31u, 33u, 64u, 100u, 130u })
+            {
+                for (uint32_t h : { 1u, 2u, 3u, 130u })
+                {
+                    Source s = { w, h, (w + 1) / 2, {}, {}, {} };
+                    s.y.resize(w * h);
+                    s.uv.resize(s.pairs * 2 * ((h + 1) / 2));
+                    s.packed.resize(s.pairs * 4 * h);
+                    for (auto* plane : { &s.y, &s.uv, &s.packed })
+                        for (auto& b : *plane)
+                            b = (uint8_t)rng();
+
+                    for (Format format : { Format::NV12, Format::YUY2, Format::UYVY })
+                    {
+                        std::vector<uint8_t> scalar, out;
+                        Convert(s, format, c, SimdLevel::Scalar, false, pool, scalar);
+                        const int worst = MaxDifference(scalar, Reference(s, format, c));
+                        CHECK_MSG(worst <= 1, "format %d matrix %d range %d %ux%u off by %d", (int)format, m, r, w, h,
+                                  worst);
+                        for (SimdLevel level : kLevels)
+                        {
+                            Convert(s, format, c, level, false, pool, out);
+                            CHECK_MSG(out == scalar, "format %d %ux%u %s", (int)format, w, h, SimdLevelName(level));
+                        }
+                        Convert(s, format, c, SimdLevel::Scalar, true, pool, out);
+                        CHECK_MSG(out == scalar, "format %d %ux%u parallel", (int)format, w, h);
+                    }
+                }
+            }
+            RoundTrip(c);
+        }
+    }
+    return Test::CheckResult();
+}